@@ -53,7 +53,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
  /****************************************************************************
   *
-  *                   Function eval_COOP
+  *                   Function COOP_at_k
   *
   * Arguments:   COOP: pointer to COOP_type
   *            details: pointer to detail_type
@@ -63,20 +63,21 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
   *        R_overlaps: pointer to hermetian_matrix_type
   *  orbital_ordering: pointer to K_orb_ptr_type
   * orbital_lookup_table: pointer to int
+  *     MO_ptr,MO_ptrI: pointers to real
+  *              kloc: pointer to point_type
   *
   *
   * Returns: real
   *
-  * Action:   This evaluates and returns the actual COOP.
+  * Action:   This evaluates and returns the COOP for the crystal orbital
+  *   with coefficients 'MO_ptr + i 'MO_ptrI at the k point 'kloc.
   *
   ****************************************************************************/
- real eval_COOP(COOP_type *COOP,detail_type *details,cell_type *cell,int num_orbs,avg_prop_info_type *prop_info,hermetian_matrix_type R_overlaps,
-                K_orb_ptr_type *orbital_ordering,
-                int *orbital_lookup_table)
+ static real COOP_at_k(COOP_type *COOP,detail_type *details,cell_type *cell,int num_orbs,avg_prop_info_type *prop_info,hermetian_matrix_type R_overlaps,
+                       K_orb_ptr_type *orbital_ordering,
+                       int *orbital_lookup_table,real *MO_ptr,real *MO_ptrI,
+                       point_type *kloc)
  {
-   static point_type *cell_dim=0;
-   static real *overlap_store=0;
-   static int last_overlap=-1;
    int i,ii,j,itab,jtab;
    real accum,accumI,temp,temp2;
    real answer, answer_contrib,Hii_1, Hii_2;
@@ -87,43 +88,20 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
    int which_overlap;
    hermetian_matrix_type overlap;
    real phaseR,phaseI;
-   float *MO_ptr,*MO_ptrI,*FMO_ptr,*FMO_ptrI;
+   float *FMO_ptr,*FMO_ptrI;
    real *FMO_AOptr1,*FMO_AOptr2;
    real ao_term;
    point_type k,R;
    real kdotR;
    char doing_unit_cell;
+   arena_mark_type mark;
 
    overlap.dim = num_orbs;
-
-   /* check to see if we need to fill in the dimensions of the unit cell */
-   if( !cell_dim ){
-     cell_dim = (point_type *)calloc(3,sizeof(point_type));
-     if( !cell_dim ) fatal("Can't get space for cell_dim in eval_COOP.");
-
-     /* fill in the dimensions */
-     for(i=0;i<3;i++){
-       itab = cell->tvects[i].begin;
-       jtab = cell->tvects[i].end;
-       cell_dim[i].x = cell->atoms[jtab].loc.x-cell->atoms[itab].loc.x;
-       cell_dim[i].y = cell->atoms[jtab].loc.y-cell->atoms[itab].loc.y;
-       cell_dim[i].z = cell->atoms[jtab].loc.z-cell->atoms[itab].loc.z;
-     }
-   }
-
-   /* check to see if we need space to store overlap matrices */
-   if( !overlap_store ){
-     overlap_store = (real *)calloc(num_orbs*num_orbs,sizeof(real));
-     if( !overlap_store ) fatal("Can't get space for overlap_store.");
-   }
-
-   /* get pointers to the orbital information */
-   MO_ptr = &(prop_info->orbs[orbital_ordering->MO*num_orbs]);
-   MO_ptrI = &(prop_info->orbsI[orbital_ordering->MO*num_orbs]);
+   overlap.packed = 0;
 
    /* figure out which overlap matrix and phase factor we should be using */
    which_overlap = overlap_tab_from_vect(&(COOP->cell),cell);
-   overlap.mat = &(R_overlaps.mat[which_overlap*num_orbs*num_orbs]);
+   overlap.mat = R_overlap_block(R_overlaps,which_overlap,num_orbs);
 
    /* check to see if we are doing a COOP w/in the unit cell */
    if( COOP->cell.x == 0.0 && COOP->cell.y == 0.0 && COOP->cell.z == 0.0 ){
@@ -132,9 +110,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
      doing_unit_cell = 0;
    }
 
-   k.x = details->K_POINTS[orbital_ordering->Kpoint].loc.x;
-   k.y = details->K_POINTS[orbital_ordering->Kpoint].loc.y;
-   k.z = details->K_POINTS[orbital_ordering->Kpoint].loc.z;
+   k.x = kloc->x;
+   k.y = kloc->y;
+   k.z = kloc->z;
    R.x = COOP->cell.x;
    R.y = COOP->cell.y;
    R.z = COOP->cell.z;
@@ -451,7 +429,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
      FMO_AOptr2 = details->FMO_frags[frag_2].eigenset.vectR;
 
      /* build FMO to AO map for fragments */
-     FMO_map1 = calloc(details->FMO_frags[frag_1].num_orbs,sizeof(int));
+     mark = arena_mark(&kpoint_arena);
+     FMO_map1 = (int *)arena_calloc(&kpoint_arena,
+                                    details->FMO_frags[frag_1].num_orbs,sizeof(int));
 
      /* loop over atoms in fragment */
      increment=0;
@@ -475,7 +455,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
        FMO_map2 = FMO_map1;
      }else{
        /* set up FMO to AO map for frag2 */
-       FMO_map2 = calloc(details->FMO_frags[frag_2].num_orbs,sizeof(int));
+       FMO_map2 = (int *)arena_calloc(&kpoint_arena,
+                                      details->FMO_frags[frag_2].num_orbs,sizeof(int));
        increment=0;
 
        /* loop over atoms in fragment 2 */
@@ -628,15 +609,67 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
          }
        }
      }
-     /* free FMO_map memory blocks */
-     free(FMO_map1);
-     if(FMO_map2 != FMO_map1) free(FMO_map2);
+     /* give back the FMO_map memory blocks */
+     arena_release(&kpoint_arena,mark);
    }
    /* we're done, return the answer that we have calculated */
    return(answer);
  }
 
 
+ /****************************************************************************
+  *
+  *                   Function eval_COOP
+  *
+  * Arguments:   COOP: pointer to COOP_type
+  *            details: pointer to detail_type
+  *              cell: pointer to cell_type
+  *          num_orbs: int
+  *         prop_info: pointer to avg_prop_info_type
+  *        R_overlaps: pointer to hermetian_matrix_type
+  *  orbital_ordering: pointer to K_orb_ptr_type
+  * orbital_lookup_table: pointer to int
+  *
+  *
+  * Returns: real
+  *
+  * Action:   This evaluates and returns the actual COOP.
+  *
+  *  If the k point of the orbital stands for a star of symmetry related
+  *   points, the orbital is unfolded into the star and the COOP is
+  *   averaged over the members.
+  *
+  ****************************************************************************/
+ real eval_COOP(COOP_type *COOP,detail_type *details,cell_type *cell,int num_orbs,avg_prop_info_type *prop_info,hermetian_matrix_type R_overlaps,
+                K_orb_ptr_type *orbital_ordering,
+                int *orbital_lookup_table)
+ {
+   k_point_type *kpoint;
+   real *vectR,*vectI;
+   real answer;
+   int m,num_members;
+
+   kpoint = &(details->K_POINTS[orbital_ordering->Kpoint]);
+   num_members = avg_prop_orbital(details,cell,num_orbs,prop_info,
+                                  orbital_ordering->Kpoint,orbital_ordering->MO,
+                                  &vectR,&vectI);
+   if( num_members == 1 ){
+     return(COOP_at_k(COOP,details,cell,num_orbs,prop_info,R_overlaps,
+                      orbital_ordering,orbital_lookup_table,vectR,vectI,
+                      &(kpoint->loc)));
+   }
+
+   answer = 0.0;
+   for(m=0;m<num_members;m++){
+     answer += COOP_at_k(COOP,details,cell,num_orbs,prop_info,R_overlaps,
+                         orbital_ordering,orbital_lookup_table,
+                         &(vectR[m*num_orbs]),&(vectI[m*num_orbs]),
+                         &(kpoint->star[m].loc));
+   }
+   return(answer / (real)num_members);
+ }
+
+
  /****************************************************************************
   *
   *                   Procedure gen_COOP
@@ -675,8 +708,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
    int num_to_avg;
    real COOP_accum,temp;
    real this_E,diff;
-   real tot_num_K;
-   real num_occup_bands;
+   real tot_K_weight;
    COOP_type *COOP_ptr1,*COOP_ptr2;
 
    tot_num_orbs = num_orbs * details->num_KPOINTS;
@@ -699,11 +731,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
    *******/
 
    /* the total k weighting that is used */
-   tot_num_K = 0.0;
-   num_occup_bands = 0.0;
+   tot_K_weight = 0.0;
    for( i=0; i<details->num_KPOINTS; i++){
-     tot_num_K += details->K_POINTS[i].weight*details->K_POINTS[i].num_filled_bands;
-     num_occup_bands += details->K_POINTS[i].num_filled_bands;
+     tot_K_weight += details->K_POINTS[i].weight;
    }
 
    /******
@@ -741,6 +771,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
      }
 
      fprintf(output_file,"#BEGIN CURVE\n");
+     results_begin_table("COOP",COOP_ptr1->which,2);
 
      /* check for inversion of intercell vector */
      intercell_COOP_check(COOP_ptr1);
@@ -799,16 +830,18 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
        }
        i = j;
        /* write out the result */
-       fprintf(output_file,"%lg %lg\n",COOP_accum*num_occup_bands /
-               (num_to_avg*details->num_KPOINTS*tot_num_K),
+       fprintf(output_file,"%lg %lg\n",COOP_accum/(num_to_avg*tot_K_weight),
                this_E);
+       results_table_value(COOP_accum/(num_to_avg*tot_K_weight));
+       results_table_value(this_E);
      }
 
      /* now correct the accumulated value to make it the AVERAGE value */
-     COOP_ptr1->avg_value = COOP_ptr1->avg_value * num_occup_bands /
-       (num_to_avg * details->num_KPOINTS * tot_num_K);
+     COOP_ptr1->avg_value = COOP_ptr1->avg_value /
+       (num_to_avg * tot_K_weight);
 
      fprintf(output_file,"#END CURVE\n");
+     results_end_table();
      COOP_ptr1 = COOP_ptr1->next_type;
    }
  }
@@ -844,8 +877,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
    int num_to_avg;
    real COOP_accum,temp;
    real this_E,diff;
-   real tot_num_K;
-   real num_occup_bands;
+   real tot_K_weight;
    COOP_type *COOP_ptr1,*COOP_ptr2;
 
    tot_num_orbs = num_orbs * details->num_KPOINTS;
@@ -857,11 +889,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
    *******/
 
    /* the total k weighting that is used */
-   tot_num_K = 0.0;
-   num_occup_bands = 0.0;
+   tot_K_weight = 0.0;
    for( i=0; i<details->num_KPOINTS; i++){
-     tot_num_K += details->K_POINTS[i].weight*details->K_POINTS[i].num_filled_bands;
-     num_occup_bands += details->K_POINTS[i].num_filled_bands;
+     tot_K_weight += details->K_POINTS[i].weight;
    }
 
    /******
@@ -942,8 +972,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
      }
 
      /* now correct the accumulated value to make it the AVERAGE value */
-     COOP_ptr1->avg_value = COOP_ptr1->avg_value * num_occup_bands /
-       (num_to_avg * details->num_KPOINTS * tot_num_K);
+     COOP_ptr1->avg_value = COOP_ptr1->avg_value /
+       (num_to_avg * tot_K_weight);
      COOP_ptr1 = COOP_ptr1->next_type;
    }
  }
@@ -118,6 +118,7 @@ void gen_total_DOS(detail_type *details,cell_type *cell,int num_orbs,avg_prop_in
   fprintf(output_file,"\n### TOTAL DENSITY OF STATES \n");
   fprintf(output_file,"%d states are present.\n",num_orbs*2);
   fprintf(output_file,"#BEGIN CURVE\n");
+  results_begin_table("total_DOS",-1,2);
   while(i<tot_num_orbs){
     num_at_this_E = details->K_POINTS[orbital_ordering[i].Kpoint].weight;
     this_E = (real)*(orbital_ordering[i].energy);
@@ -148,6 +149,8 @@ void gen_total_DOS(detail_type *details,cell_type *cell,int num_orbs,avg_prop_in
     fprintf(output_file,"%lf %lf\n",(real)num_at_this_E/tot_K_weight,
             this_E);
 #endif
+    results_table_value((real)num_at_this_E/tot_K_weight);
+    results_table_value(this_E);
     if( weights && energies ){
       weights[num_entries] = num_at_this_E/tot_K_weight;
       energies[num_entries] = this_E;
@@ -156,6 +159,7 @@ void gen_total_DOS(detail_type *details,cell_type *cell,int num_orbs,avg_prop_in
     }
   }
   fprintf(output_file,"#END CURVE\n");
+  results_end_table();
 
   /****
 
@@ -373,6 +377,7 @@ void gen_projected_DOS(detail_type *details,cell_type *cell,int num_orbs,avg_pro
     fprintf(output_file,"\n");
 
     fprintf(output_file,"#BEGIN CURVE\n");
+    results_begin_table("projected_DOS",k,2);
     while(i<tot_num_orbs){
 
       /* now figure out the contribution of whatever is being projected out */
@@ -454,11 +459,11 @@ void gen_projected_DOS(detail_type *details,cell_type *cell,int num_orbs,avg_pro
               FATAL_BUG("Invalid projection type in gen_proj_DOS.");
             }
           }
+          accum *= (real)details->K_POINTS[orbital_ordering[j].Kpoint].weight;
           j++;
 
           if( j < tot_num_orbs ){
             diff = (real)*(orbital_ordering[i].energy) - (real)*(orbital_ordering[j].energy);
-            accum *= (real)details->K_POINTS[orbital_ordering[j].Kpoint].weight;
           }
 
           num_at_this_E += accum;
@@ -467,8 +472,11 @@ void gen_projected_DOS(detail_type *details,cell_type *cell,int num_orbs,avg_pro
       i = j;
       /* write out the result */
       fprintf(output_file,"%lf %lf\n",num_at_this_E/tot_K_weight,this_E);
+      results_table_value(num_at_this_E/tot_K_weight);
+      results_table_value(this_E);
     }
     fprintf(output_file,"#END CURVE\n");
+    results_end_table();
     fprintf(output_file," \n");
   }
 }
@@ -73,6 +73,39 @@ void init_FMO_file(detail_type *details,int num_orbs,real num_electrons)
   }
 }
 
+/****************************************************************************
+*
+*                   Procedure copy_FMO_block
+*
+* Arguments:    FMO_frag: pointer to FMO_frag_type
+*               num_orbs: int
+*                    mat: pointer to real
+*                FMO_mat: pointer to real
+*
+* Returns: none
+*
+* Action: Copies the elements of the 'num_orbs x 'num_orbs matrix 'mat
+*    between the orbitals of 'FMO_frag into 'FMO_mat, using the fragment's
+*    orbital map (see allocate_matrices).
+*
+****************************************************************************/
+static void copy_FMO_block(FMO_frag_type *FMO_frag,int num_orbs,real *mat,
+                           real *FMO_mat)
+{
+  int i,j;
+  int itab,FMO_itab;
+  int *orb_map;
+
+  orb_map = FMO_frag->orb_map;
+  for( i=0; i<FMO_frag->num_orbs; i++){
+    itab = orb_map[i]*num_orbs;
+    FMO_itab = i*FMO_frag->num_orbs;
+    for( j=0; j<FMO_frag->num_orbs; j++){
+      FMO_mat[FMO_itab+j] = mat[itab+orb_map[j]];
+    }
+  }
+}
+
 /****************************************************************************
 *
 *                   Procedure build_FMO_overlap
@@ -92,12 +125,7 @@ void init_FMO_file(detail_type *details,int num_orbs,real num_electrons)
 ****************************************************************************/
 void build_FMO_overlap(detail_type *details,int num_orbs,int num_atoms,hermetian_matrix_type overlap,int *orbital_lookup_table)
 {
-  FMO_frag_type *FMO_frag;
-  int i,j;
-  int itab,jtab,FMO_itab,FMO_jtab;
-  int begin1,end1,begin2,end2;
-  int FMO_begin1,FMO_end1,FMO_begin2,FMO_end2;
-  int frag,atom1,atom2;
+  int frag;
   int num_frags;
 
   if( !details->num_FMO_frags ) num_frags = details->num_FCO_frags;
@@ -109,47 +137,8 @@ void build_FMO_overlap(detail_type *details,int num_orbs,int num_atoms,hermetian
 
   /* loop over fragments */
   for(frag=0;frag<num_frags;frag++){
-    FMO_frag = &(details->FMO_frags[frag]);
-
-    /* loop over the atoms which contribute to this fragment */
-    for( atom1=0;atom1<FMO_frag->num_atoms;atom1++){
-      /******
-
-        the location of the orbitals belonging to this atom must be found
-        in BOTH the main overlap matrix and the FMO overlap matrix.
-
-      *******/
-      find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom1],
-                      orbital_lookup_table,&begin1,&end1);
-      find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom1,
-                      FMO_frag->orbital_lookup_table,&FMO_begin1,&FMO_end1);
-      /* ignore dummy atoms */
-      if( begin1 >= 0 && FMO_begin1 >= 0){
-
-        for( atom2=0;atom2<FMO_frag->num_atoms;atom2++){
-          /* find the orbitals of the other atom */
-          find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom2],
-                          orbital_lookup_table,&begin2,&end2);
-          find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom2,
-                          FMO_frag->orbital_lookup_table,&FMO_begin2,&FMO_end2);
-
-          if( begin2 >= 0 && FMO_begin2 >= 0){
-            /* now loop over and copy the orbitals */
-            for( i=0; i<(end1-begin1); i++){
-              itab = (i+begin1)*num_orbs;
-              FMO_itab = (i+FMO_begin1)*FMO_frag->num_orbs;
-              for( j=0; j<(end2-begin2); j++){
-                jtab = j+begin2;
-                FMO_jtab = j+FMO_begin2;
-
-                FMO_frag->overlap_K.mat[FMO_itab+FMO_jtab] =
-                  overlap.mat[itab+jtab];
-              }
-            }
-          }
-        }
-      }
-    }
+    copy_FMO_block(&(details->FMO_frags[frag]),num_orbs,overlap.mat,
+                   details->FMO_frags[frag].overlap_K.mat);
   }
 }
 
@@ -173,12 +162,7 @@ void build_FMO_overlap(detail_type *details,int num_orbs,int num_atoms,hermetian
 ****************************************************************************/
 void build_FMO_hamil(detail_type *details,int num_orbs,int num_atoms,hermetian_matrix_type hamil,int *orbital_lookup_table)
 {
-  FMO_frag_type *FMO_frag;
-  int i,j;
-  int itab,jtab,FMO_itab,FMO_jtab;
-  int begin1,end1,begin2,end2;
-  int FMO_begin1,FMO_end1,FMO_begin2,FMO_end2;
-  int frag,atom1,atom2;
+  int frag;
   int num_frags;
 
   if( !details->num_FMO_frags ) num_frags = details->num_FCO_frags;
@@ -189,56 +173,118 @@ void build_FMO_hamil(detail_type *details,int num_orbs,int num_atoms,hermetian_m
     FATAL_BUG("Bad FMO_frag_type array passed to build_FMO_hamil.");
   }
 
+  /* loop over fragments */
+  for(frag=0;frag<num_frags;frag++){
+    copy_FMO_block(&(details->FMO_frags[frag]),num_orbs,hamil.mat,
+                   details->FMO_frags[frag].hamil_K.mat);
+  }
+}
 
-  /******
 
-    this is the basically the same code used to build the overlap
-    matrices
+/****************************************************************************
+*
+*                   Procedure solve_FMO_frag
+*
+* Arguments:    details: pointer to detail type
+*              FMO_frag: pointer to FMO_frag_type
+*           factor_slot: int
+*     work1,work2,work3: pointers to reals
+* cmplx_hamil,cmplx_overlap,cmplx_work: pointers to complex
+*            diag_error: pointer to int
+*
+* Returns: none
+*
+* Action: Solves the eigenvalue problem for a single fragment, leaving
+*    the results in FMO_frag->eigenset.  The fragment's hamiltonian and
+*    overlap matrices are not changed.
+*
+*   The work arrays only need to be big enough for the fragment:
+*      work1,work2: FMO_frag->num_orbs
+*            work3: FMO_frag->num_orbs^2
+*   and the same goes for the complex arrays.
+*
+*   This doesn't write anything, so different fragments can be done at
+*    the same time as long as they're given their own work arrays.
+*
+****************************************************************************/
+static void solve_FMO_frag(detail_type *details,FMO_frag_type *FMO_frag,
+                           int factor_slot,real *work1,real *work2,real *work3,
+                           complex *cmplx_hamil,complex *cmplx_overlap,
+                           complex *cmplx_work,int *diag_error)
+{
+  int num_orbs;
+#ifdef USE_LAPACK
+  int j,k,jtab,ktab;
+  char jobz;
+  int num_orbs2;
+#endif
+
+  num_orbs = FMO_frag->num_orbs;
 
+#ifndef USE_LAPACK
+  /******
+    The matrix diagonalization routine destroys both matrices, so we
+    work on copies of them: the hamiltonian is copied into
+    eigenset.vectR (where the real part of the eigenvectors ends up)
+    and the overlap matrix into work3.
   *******/
+  bcopy((char *)FMO_frag->overlap_K.mat,(char *)work3,num_orbs*num_orbs*sizeof(real));
+  bcopy((char *)FMO_frag->hamil_K.mat,(char *)FMO_frag->eigenset.vectR,
+        num_orbs*num_orbs*sizeof(real));
 
-  /* loop over fragments */
-  for(frag=0;frag<num_frags;frag++){
-    FMO_frag = &(details->FMO_frags[frag]);
+  /*******
 
-    /* loop over the atoms which contribute to this fragment */
-    for( atom1=0;atom1<FMO_frag->num_atoms;atom1++){
-      /******
-
-        the location of the orbitals belonging to this atom must be found
-        in BOTH the main hamiltonian matrix and the FMO hamiltonian.
-
-      *******/
-      find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom1],
-                      orbital_lookup_table,&begin1,&end1);
-      find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom1,
-                      FMO_frag->orbital_lookup_table,&FMO_begin1,&FMO_end1);
-      /* ignore dummy atoms */
-      if( begin1 >= 0 && FMO_begin1 >= 0){
-
-        for( atom2=0;atom2<FMO_frag->num_atoms;atom2++){
-          find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom2],
-                          orbital_lookup_table,&begin2,&end2);
-          find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom2,
-                          FMO_frag->orbital_lookup_table,&FMO_begin2,&FMO_end2);
-
-          if( begin2 >= 0 && FMO_begin2 >= 0){
-            for( i=0; i<(end1-begin1); i++){
-              itab = (i+begin1)*num_orbs;
-              FMO_itab = (i+FMO_begin1)*FMO_frag->num_orbs;
-              for( j=0; j<(end2-begin2); j++){
-                jtab = j+begin2;
-                FMO_jtab = j+FMO_begin2;
-
-                FMO_frag->hamil_K.mat[FMO_itab+FMO_jtab] =
-                  hamil.mat[itab+jtab];
-              }
-            }
-          }
-        }
+    now diagonalize that beast by calling the FORTRAN subroutine used
+     to diagonalize stuff in new3 and CACAO.
+
+  ********/
+  cached_cboris(factor_slot,&(num_orbs),FMO_frag->eigenset.vectR,
+                work3,FMO_frag->eigenset.vectI,FMO_frag->eigenset.val,work1,
+                work2,diag_error);
+#else
+  /**********
+
+    we're using LAPACK to diagonalize and we need to copy the matrices into those
+    used by the LAPACK diagonalizer
+
+    **********/
+  for(j=0;j<num_orbs;j++){
+    jtab = j*num_orbs;
+    for(k=j+1;k<num_orbs;k++){
+      ktab = k*num_orbs;
+      cmplx_hamil[jtab+k].r = FMO_frag->hamil_K.mat[jtab+k];
+      cmplx_hamil[jtab+k].i = FMO_frag->hamil_K.mat[ktab+j];
+      cmplx_overlap[jtab+k].r = FMO_frag->overlap_K.mat[jtab+k];
+      cmplx_overlap[jtab+k].i = FMO_frag->overlap_K.mat[ktab+j];
+      cmplx_hamil[ktab+j].r = 0.0;
+      cmplx_hamil[ktab+j].i = 0.0;
+      cmplx_overlap[ktab+j].r = 0.0;
+      cmplx_overlap[ktab+j].i = 0.0;
+    }
+    cmplx_hamil[jtab+j].r = FMO_frag->hamil_K.mat[jtab+j];
+    cmplx_hamil[jtab+j].i = 0.0;
+    cmplx_overlap[jtab+j].r = FMO_frag->overlap_K.mat[jtab+j];
+    cmplx_overlap[jtab+j].i = 0.0;
+  }
+
+  if( details->just_avgE ) jobz = 'N';
+  else jobz = 'V';
+  num_orbs2 = num_orbs*num_orbs;
+  cached_zhegv(factor_slot,&jobz,&num_orbs,cmplx_hamil,cmplx_overlap,
+               FMO_frag->eigenset.val,cmplx_work,&num_orbs2,work3,
+               diag_error);
+
+  /* now copy stuff back out of the results */
+  if( !details->just_avgE ){
+    for(j=0;j<num_orbs;j++){
+      jtab = j*num_orbs;
+      for(k=0;k<num_orbs;k++){
+        FMO_frag->eigenset.vectR[jtab+k] = cmplx_hamil[jtab+k].r;
+        FMO_frag->eigenset.vectI[jtab+k] = cmplx_hamil[jtab+k].i;
       }
     }
   }
+#endif
 }
 
 
@@ -247,15 +293,15 @@ void build_FMO_hamil(detail_type *details,int num_orbs,int num_atoms,hermetian_m
 *                   Procedure diagonalize_FMO
 *
 * Arguments:    details: pointer to detail type
+*               which_k: int
 *     work1,work2,work3: pointers to reals
-*
+* cmplx_hamil,cmplx_overlap,cmplx_work: pointers to complex
 *
 *
 * Returns: none
 *
-* Action: Copies the relevant pieces of the hamiltonian matrix passed in
-*    to the correct portions of the FMO structures contained within
-*    'details.
+* Action: Solves the eigenvalue problems for each of the fragments and
+*    writes out the results.
 *
 *   The work arrays are used as temporary memory in the various functions called
 *    by this one.  The dimensions should be:
@@ -268,19 +314,28 @@ void build_FMO_hamil(detail_type *details,int num_orbs,int num_atoms,hermetian_m
 *   they will continue to hold useful information after this function
 *   returns (they will not).
 *
+*  When the fragments have no more orbitals between them than the whole
+*   system (the usual case) the work arrays are split up between the
+*   fragments and the fragments are diagonalized at the same time (if
+*   the program was built with OpenMP).  The results are written out
+*   afterwards in the usual order.
+*
+*  'which_k is the index of the current k point (0 for molecules); it's
+*   used to find the cached overlap factors for the fragments.
+*
 ****************************************************************************/
-void diagonalize_FMO(detail_type *details,real *work1,real *work2,real *work3,complex *cmplx_hamil,complex *cmplx_overlap,complex *cmplx_work)
+void diagonalize_FMO(detail_type *details,int which_k,real *work1,real *work2,real *work3,complex *cmplx_hamil,complex *cmplx_overlap,complex *cmplx_work)
 {
   FMO_frag_type *FMO_frag;
-  int i,j,k,itab,jtab,ktab;
-  int num_orbs,diag_error;
+  int i,j;
+  int frag_orbs,diag_error;
   real *occupations;
   int num_frags;
-#ifdef USE_LAPACK
-  char jobz, uplo;
-  int info, itype;
-  int num_orbs2;
-#endif
+  int num_k;
+  long *vect_offset,*mat_offset;
+  int *diag_errors;
+  char split_work;
+  arena_mark_type mark;
 
   if( !details->num_FMO_frags ) num_frags = details->num_FCO_frags;
   else num_frags = details->num_FMO_frags;
@@ -289,14 +344,54 @@ void diagonalize_FMO(detail_type *details,real *work1,real *work2,real *work3,co
     FATAL_BUG("Bad FMO_frag_type array passed to diagonalize_FMO.");
   }
 
+  /* the fragment factors go in the cache after the ones for the full system */
+  num_k = details->num_KPOINTS ? details->num_KPOINTS : 1;
+
+  /******
+
+    figure out where each fragment's piece of the work arrays starts.
+
+  *******/
+  mark = arena_mark(&kpoint_arena);
+  vect_offset = (long *)arena_calloc(&kpoint_arena,num_frags,sizeof(long));
+  mat_offset = (long *)arena_calloc(&kpoint_arena,num_frags,sizeof(long));
+  diag_errors = (int *)arena_calloc(&kpoint_arena,num_frags,sizeof(int));
+  vect_offset[0] = mat_offset[0] = 0;
+  for( i=1; i<num_frags; i++){
+    frag_orbs = details->FMO_frags[i-1].num_orbs;
+    vect_offset[i] = vect_offset[i-1] + frag_orbs;
+    mat_offset[i] = mat_offset[i-1] + (long)frag_orbs*frag_orbs;
+  }
+  frag_orbs = details->FMO_frags[num_frags-1].num_orbs;
+  split_work = vect_offset[num_frags-1] + frag_orbs <= num_orbs;
+
+  if( split_work ){
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) if(num_frags > 1)
+#endif
+    for( i=0; i<num_frags; i++){
+      solve_FMO_frag(details,&(details->FMO_frags[i]),(i+1)*num_k + which_k,
+                     &(work1[vect_offset[i]]),&(work2[vect_offset[i]]),
+                     &(work3[mat_offset[i]]),&(cmplx_hamil[mat_offset[i]]),
+                     &(cmplx_overlap[mat_offset[i]]),&(cmplx_work[mat_offset[i]]),
+                     &(diag_errors[i]));
+    }
+  } else{
+    for( i=0; i<num_frags; i++){
+      solve_FMO_frag(details,&(details->FMO_frags[i]),(i+1)*num_k + which_k,
+                     work1,work2,work3,cmplx_hamil,cmplx_overlap,cmplx_work,
+                     &(diag_errors[i]));
+    }
+  }
+
   fprintf(output_file,";------------------ FMO Analysis --------------\n");
   fprintf(output_file,"#NUM_FRAGMENTS: %d\n",num_frags);
 
-  /* loop over each fragment and do it's orbitals individually */
+  /* now write out the results for each fragment */
   for( i=0; i<num_frags; i++){
     FMO_frag = &(details->FMO_frags[i]);
-    num_orbs = FMO_frag->num_orbs;
-
+    frag_orbs = FMO_frag->num_orbs;
+    diag_error = diag_errors[i];
 
     fprintf(output_file,"\n#Fragment %d <*><*><*><*><*><*><*><*><*><*><*><*>\n",i+1);
 
@@ -309,7 +404,7 @@ void diagonalize_FMO(detail_type *details,real *work1,real *work2,real *work3,co
       else{
         fprintf(output_file,"S(K) ---\n");
       }
-      printmat(FMO_frag->overlap_K.mat,num_orbs,num_orbs,output_file,1e-4,
+      printmat(FMO_frag->overlap_K.mat,frag_orbs,frag_orbs,output_file,1e-4,
                details->overlap_mat_PRT & PRT_TRANSPOSE_FLAG,details->line_width);
     }
 
@@ -323,103 +418,23 @@ void diagonalize_FMO(detail_type *details,real *work1,real *work2,real *work3,co
       else{
         fprintf(output_file,"H(K) ---\n");
       }
-      printmat(FMO_frag->hamil_K.mat,num_orbs,num_orbs,output_file,1e-4,
+      printmat(FMO_frag->hamil_K.mat,frag_orbs,frag_orbs,output_file,1e-4,
                details->hamil_PRT & PRT_TRANSPOSE_FLAG,details->line_width);
     }
 
     fprintf(stdout,"]");
-
 #ifndef USE_LAPACK
-    /******
-      The matrix diagonalization routine destroys the overlap matrix, so we
-      make a copy of it in work3.
-    *******/
-    bcopy((char *)FMO_frag->overlap_K.mat,(char *)work3,num_orbs*num_orbs*sizeof(real));
-
-    /*******
-
-      now diagonalize that beast by calling the FORTRAN subroutine used
-       to diagonalize stuff in new3 and CACAO.
-
-    ********/
-    cboris(&(num_orbs),&(num_orbs),FMO_frag->hamil_K.mat,
-           work3,FMO_frag->eigenset.vectI,FMO_frag->eigenset.val,work1,
-           work2,&diag_error);
+    timer_add_flops(eigensolver_flops(frag_orbs,1));
     fprintf(status_file,"Error value from FMO diagonalization (fragment %d): %d\n",
             i,diag_error);
     fflush(status_file);
     if( diag_error != 0 ){
       error("Problems in the FMO diagonalization, try more overlaps.");
     }
-
-    /*********
-
-      at this point, hamilK.mat contains the real part of the eigenvectors,
-      eigenset.vectI contains the imaginary part, and
-      eigenset.val has the energies.
-
-      copy the information from hamilK.mat into eigenset.vectR
-
-    **********/
-    bcopy((char *)FMO_frag->hamil_K.mat,FMO_frag->eigenset.vectR,
-          num_orbs*num_orbs*sizeof(real));
 #else
-      /**********
-
-        we're using LAPACK to diagonalize and we need to copy the matrices into those
-        used by the LAPACK diagonalizer
-
-        **********/
-      for(j=0;j<num_orbs;j++){
-        jtab = j*num_orbs;
-        for(k=j+1;k<num_orbs;k++){
-          ktab = k*num_orbs;
-          cmplx_hamil[jtab+k].r = FMO_frag->hamil_K.mat[jtab+k];
-          cmplx_hamil[jtab+k].i = FMO_frag->hamil_K.mat[ktab+j];
-          cmplx_overlap[jtab+k].r = FMO_frag->overlap_K.mat[jtab+k];
-          cmplx_overlap[jtab+k].i = FMO_frag->overlap_K.mat[ktab+j];
-          cmplx_hamil[ktab+j].r = 0.0;
-          cmplx_hamil[ktab+j].i = 0.0;
-          cmplx_overlap[ktab+j].r = 0.0;
-          cmplx_overlap[ktab+j].i = 0.0;
-        }
-        cmplx_hamil[jtab+j].r = FMO_frag->hamil_K.mat[jtab+j];
-        cmplx_hamil[jtab+j].i = 0.0;
-        cmplx_overlap[jtab+j].r = FMO_frag->overlap_K.mat[jtab+j];
-        cmplx_overlap[jtab+j].i = 0.0;
-
-      }
-
-
-      itype = 1;
-      if( details->just_avgE ){
-        jobz = 'N';
-        if( print_progress )
-          fprintf(stdout,".");
-      } else{
-        jobz = 'V';
-      }
-      uplo = 'L';
-      num_orbs2 = num_orbs*num_orbs;
-      fprintf(stdout,"{");
-      zhegv((long *)&(itype),&jobz,&uplo,(long *)&num_orbs,cmplx_hamil,
-                              (long *)&num_orbs,cmplx_overlap,
-                                           (long *)&num_orbs,FMO_frag->eigenset.val,cmplx_work,
-                                           (long *)&num_orbs2,work3,(long *)&diag_error);
-      fprintf(stdout,"}");
-
-      /* now copy stuff back out of the results */
-      if( !details->just_avgE ){
-        for(j=0;j<num_orbs;j++){
-          jtab = j*num_orbs;
-          for(k=0;k<num_orbs;k++){
-            ktab = k*num_orbs;
-            FMO_frag->eigenset.vectR[jtab+k] = cmplx_hamil[jtab+k].r;
-            FMO_frag->eigenset.vectI[jtab+k] = cmplx_hamil[jtab+k].i;
-          }
-        }
-      }
-
+    if( details->just_avgE && print_progress ) fprintf(stdout,".");
+    timer_add_flops(eigensolver_flops(frag_orbs,!details->just_avgE));
+    fprintf(stdout,"{}");
 #endif
 
     fprintf(stdout,"[ ");
@@ -435,7 +450,7 @@ INCREASE down)\n");
 INCREASE to the right)\n");
       }
       fprintf(output_file,";\t***> REAL:\n");
-      printmat(FMO_frag->eigenset.vectR,num_orbs,num_orbs,output_file,1e-4,
+      printmat(FMO_frag->eigenset.vectR,frag_orbs,frag_orbs,output_file,1e-4,
                details->wave_fn_PRT & PRT_TRANSPOSE_FLAG,details->line_width);
       /********
 
@@ -445,7 +460,7 @@ INCREASE to the right)\n");
       ********/
       if( details->Execution_Mode != MOLECULAR ){
         fprintf(output_file,";\t***> IMAGINARY:\n");
-        printmat(FMO_frag->eigenset.vectI,num_orbs,num_orbs,output_file,1e-4,
+        printmat(FMO_frag->eigenset.vectI,frag_orbs,frag_orbs,output_file,1e-4,
                  details->wave_fn_PRT & PRT_TRANSPOSE_FLAG,details->line_width);
       }
     }
@@ -463,12 +478,12 @@ INCREASE to the right)\n");
     occupations = work2;
 
     /* zero out the occupations array */
-    bzero((char *)occupations,num_orbs*sizeof(real));
+    bzero((char *)occupations,frag_orbs*sizeof(real));
 
-    calc_occupations(0,FMO_frag->num_electrons,num_orbs,occupations,FMO_frag->eigenset);
+    calc_occupations(0,FMO_frag->num_electrons,frag_orbs,occupations,FMO_frag->eigenset);
 
     fprintf(output_file,"\n#\t****Fragment Energies (in eV) and Occupation Numbers ****\n");
-    for(j=0;j<num_orbs;j++){
+    for(j=0;j<frag_orbs;j++){
       fprintf(output_file,"%d:--->  %8.6lg  [%4.3lf Electrons]\n",j+1,
               EIGENVAL(FMO_frag->eigenset,j), occupations[j]);
       total_energy += occupations[j]*EIGENVAL(FMO_frag->eigenset,j);
@@ -484,11 +499,12 @@ INCREASE to the right)\n");
     /* write the relevant information into the FMO results file */
     if( details->num_FMO_frags ){
       fprintf(FMO_file,"; Fragment %d orbital energies\n",i+1);
-      for(j=0;j<num_orbs;j++){
+      for(j=0;j<frag_orbs;j++){
         fprintf(FMO_file,"%lg\n",EIGENVAL(FMO_frag->eigenset,j));
       }
     }
   }
+  arena_release(&kpoint_arena,mark);
   fprintf(stdout,"\n");
   fprintf(output_file,";-o-o-o-o-o-o-o-o- END FMO -o-o-o-o-o-o-\n\n");
 }
@@ -623,16 +639,24 @@ void tform_wavefuncs_to_FMO_basis(detail_type *details,int num_orbs,int num_atom
 {
   FMO_frag_type *FMO_frag;
 
-  int num_orbs_this_frag;
-  int frag,atom1,atom2,i,j,k;
-  int itab,FMO_itab;
-  int jtab,FMO_jtab;
-  int ktab,FMO_ktab;
-  int begin1,end1,FMO_begin1,FMO_end1;
+  int frag_orbs,num_frags;
+  int frag,i,j,k;
+  int itab,FMO_jtab,FMO_ktab;
+  int *orb_map;
   real *results_matR,*results_matI;
   real *T_matR,*T_matI;
+#ifndef USE_LAPACK
   real accumR, accumI;
+#else
+  complex *T_cmplx,*C_cmplx;
+  complex one,zero;
+  char trans='N';
+  long m,n,ldc;
+  arena_mark_type mark;
+#endif
 
+  if( !details->num_FMO_frags ) num_frags = details->num_FCO_frags;
+  else num_frags = details->num_FMO_frags;
 
   /* start by getting pointers to and zeroing out the results matrices */
   results_matR = details->FMO_props->eigenset.vectR;
@@ -640,77 +664,88 @@ void tform_wavefuncs_to_FMO_basis(detail_type *details,int num_orbs,int num_atom
   bzero(results_matR,num_orbs*num_orbs*sizeof(real));
   bzero(results_matI,num_orbs*num_orbs*sizeof(real));
 
+  /*******
 
+    The transformation matrix is block diagonal, so each fragment's
+    columns of the results only need the coefficients of that
+    fragment's AOs (which are found using the fragment's orb_map) and
+    its own block of the transformation matrix.
 
-  for(i=0;i<num_orbs;i++){
-    /* check to see if we need to move onto the next fragment */
-
-    itab = i*num_orbs;
-
-    /* now loop over columns (FMO's) */
-    num_orbs_this_frag = 0;
-    frag = 0;
+  ********/
+  for(frag=0;frag<num_frags;frag++){
     FMO_frag = &(details->FMO_frags[frag]);
+    frag_orbs = FMO_frag->num_orbs;
+    if( !frag_orbs ) continue;
+    orb_map = FMO_frag->orb_map;
     T_matR = FMO_frag->tform_matrix.matR;
     T_matI = FMO_frag->tform_matrix.matI;
 
-
-    /* first loop over rows (MO's) in the new matrix */
-
-    for(j=0;j<num_orbs;j++){
-      jtab = j*num_orbs;
-
-      if( num_orbs_this_frag == FMO_frag->num_orbs ){
-        frag++;
-        FMO_frag = &(details->FMO_frags[frag]);
-        T_matR = FMO_frag->tform_matrix.matR;
-        T_matI = FMO_frag->tform_matrix.matI;
-        num_orbs_this_frag = 0;
+#ifndef USE_LAPACK
+    /* loop over rows (MO's) in the new matrix */
+    for(i=0;i<num_orbs;i++){
+      itab = i*num_orbs;
+      /* now loop over this fragment's columns (FMO's) */
+      for(j=0;j<frag_orbs;j++){
+        FMO_jtab = j;
+        accumR = 0.0;
+        accumI = 0.0;
+        for(k=0;k<frag_orbs;k++){
+          FMO_ktab = k*frag_orbs;
+          accumR += eigenset.vectR[itab+orb_map[k]]*T_matR[FMO_jtab + FMO_ktab];
+          accumR -= eigenset.vectI[itab+orb_map[k]]*T_matI[FMO_jtab + FMO_ktab];
+          accumI += eigenset.vectI[itab+orb_map[k]]*T_matR[FMO_jtab + FMO_ktab];
+          accumI += eigenset.vectR[itab+orb_map[k]]*T_matI[FMO_jtab + FMO_ktab];
+        }
+        /* set the matrix element */
+        results_matR[itab+FMO_frag->orb_offset+j] = accumR;
+        results_matI[itab+FMO_frag->orb_offset+j] = accumI;
       }
+    }
+#else
+    /*******
 
-      FMO_jtab = num_orbs_this_frag;
-      /***********
-
-        to do the multiplication, loop over the atoms in the fragment and do the
-        orbitals of each atom.
-
-      ************/
-      accumR = 0.0;
-      accumI = 0.0;
-      for(atom1=0; atom1<FMO_frag->num_atoms; atom1++){
-        /******
-
-          the location of the orbitals belonging to this atom must be found
-          in BOTH the main and FMO coefficient matrices.
-
-        *******/
-        find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom1],
-                        orbital_lookup_table,&begin1,&end1);
-        find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom1,
-                        FMO_frag->orbital_lookup_table,&FMO_begin1,&FMO_end1);
-
-        if( begin1 >= 0 && FMO_begin1 >= 0 ){
-
-          /* loop over the atom's orbitals */
-          for(k=0;k<(end1-begin1);k++){
-            ktab = k+begin1;
-            FMO_ktab = (k+FMO_begin1)*FMO_frag->num_orbs;
-
-            accumR += eigenset.vectR[ktab+itab]*T_matR[FMO_jtab + FMO_ktab];
-            accumR -= eigenset.vectI[ktab+itab]*T_matI[FMO_jtab + FMO_ktab];
-            accumI += eigenset.vectI[ktab+itab]*T_matR[FMO_jtab + FMO_ktab];
-            accumI += eigenset.vectR[ktab+itab]*T_matI[FMO_jtab + FMO_ktab];
-          }
-        }
+      gather the fragment's coefficients and transform matrix into
+      complex arrays and let ZGEMM do the multiply.  ZGEMM works
+      with column major matrices, so what it sees are the transposes:
+        (C T)^T = T^T C^T
+      and the result block is written straight into the complex scratch
+      array with a leading dimension of frag_orbs.
 
+    ********/
+    mark = arena_mark(&kpoint_arena);
+    T_cmplx = (complex *)arena_calloc(&kpoint_arena,(long)frag_orbs*frag_orbs,
+                                      sizeof(complex));
+    C_cmplx = (complex *)arena_calloc(&kpoint_arena,2*(long)num_orbs*frag_orbs,
+                                      sizeof(complex));
+    for(k=0;k<frag_orbs*frag_orbs;k++){
+      T_cmplx[k].r = T_matR[k];
+      T_cmplx[k].i = T_matI[k];
+    }
+    for(i=0;i<num_orbs;i++){
+      itab = i*num_orbs;
+      for(k=0;k<frag_orbs;k++){
+        C_cmplx[i*frag_orbs+k].r = eigenset.vectR[itab+orb_map[k]];
+        C_cmplx[i*frag_orbs+k].i = eigenset.vectI[itab+orb_map[k]];
       }
-
-      /* set the matrix element */
-      results_matR[itab+j] = accumR;
-      results_matI[itab+j] = accumI;
-      num_orbs_this_frag++;
     }
-
+    one.r = 1.0;
+    one.i = 0.0;
+    zero.r = zero.i = 0.0;
+    m = frag_orbs;
+    n = num_orbs;
+    ldc = frag_orbs;
+    zgemm(&trans,&trans,&m,&n,&m,&one,T_cmplx,&m,C_cmplx,&m,&zero,
+          &(C_cmplx[(long)num_orbs*frag_orbs]),&ldc);
+    for(i=0;i<num_orbs;i++){
+      itab = i*num_orbs;
+      FMO_jtab = num_orbs*frag_orbs + i*frag_orbs;
+      for(j=0;j<frag_orbs;j++){
+        results_matR[itab+FMO_frag->orb_offset+j] = C_cmplx[FMO_jtab+j].r;
+        results_matI[itab+FMO_frag->orb_offset+j] = C_cmplx[FMO_jtab+j].i;
+      }
+    }
+    arena_release(&kpoint_arena,mark);
+#endif
   }
 #ifdef DEBUG
 fprintf(output_file,"\n\n\n\t FMO matrix \n");
@@ -721,6 +756,33 @@ fprintf(output_file,"\n\n\n");
 }
 
 
+/****************************************************************************
+*
+*                   Function max_FMO_frag_orbs
+*
+* Arguments:    details: pointer to detail type
+*             num_frags: int
+*
+* Returns: int
+*
+* Action: returns the number of orbitals in the biggest fragment.  This
+*   sets the size of the temporary blocks used in the transformations
+*   below.
+*
+****************************************************************************/
+static int max_FMO_frag_orbs(detail_type *details,int num_frags)
+{
+  int frag,max_orbs;
+
+  max_orbs = 0;
+  for(frag=0;frag<num_frags;frag++){
+    if( details->FMO_frags[frag].num_orbs > max_orbs )
+      max_orbs = details->FMO_frags[frag].num_orbs;
+  }
+  return max_orbs;
+}
+
+
 /****************************************************************************
 *
 *                   Procedure tform_matrix_to_FMO_basis
@@ -728,7 +790,6 @@ fprintf(output_file,"\n\n\n");
 * Arguments:    details: pointer to detail type
 *    num_orbs,num_atoms: integer
 *       AO_matR,AO_matI: pointers to reals
-*   temp_matR,temp_matI: pointers to reals
 *             cmplx_mat: complex_matrix_type
 *  orbital_lookup_table: pointer to int
 *
@@ -745,26 +806,32 @@ fprintf(output_file,"\n\n\n");
 *    be set to zero.
 *
 *   'AO_matR and 'AO_matI are assumed to be 'num_orbs x 'num_orbs.
-*   'temp_matR and 'temp_matI, which are used to store intermediate results,
-*    should also be at least 'num_orbs x 'num_orbs.
+*
+*   The transformation matrix is block diagonal, so this is done one
+*    pair of fragments at a time: the block of the results between
+*    fragments a and b only needs the AO block between the orbitals of
+*    a and b and the coefficients of the two fragments.  The intermediate
+*    results are kept in a block the size of the largest fragment.
 *
 *    The results are placed in 'cmplx_mat.
 *
 ****************************************************************************/
 void tform_matrix_to_FMO_basis(detail_type *details,int num_orbs,int num_atoms,real *AO_matR,real *AO_matI,
-                               real *temp_matR,real *temp_matI,complex_matrix_type cmplx_mat,int *orbital_lookup_table)
+                               complex_matrix_type cmplx_mat,int *orbital_lookup_table)
 {
-  FMO_frag_type *FMO_frag;
-
-  int num_orbs_this_frag;
-  int frag,atom1,atom2,i,j,k;
-  int itab,FMO_itab;
-  int jtab,FMO_jtab;
-  int ktab,FMO_ktab;
-  int begin1,end1,FMO_begin1,FMO_end1;
+  FMO_frag_type *FMO_frag1,*FMO_frag2;
+  int frag1,frag2,num_frags;
+  int num_orbs1,num_orbs2,max_orbs;
+  int i,j,k;
+  int itab,FMO_itab,FMO_jtab;
   real *results_matR,*results_matI;
-  real *T_matR,*T_matI;
-  real accumR, accumI;
+  real *T_matR1,*T_matR2;
+  real *temp_matR;
+  real accumR;
+  arena_mark_type mark;
+
+  if( !details->num_FMO_frags ) num_frags = details->num_FCO_frags;
+  else num_frags = details->num_FMO_frags;
 
   /* start by getting pointers to and zeroing out the results matrix */
   results_matR = cmplx_mat.matR;
@@ -772,138 +839,55 @@ void tform_matrix_to_FMO_basis(detail_type *details,int num_orbs,int num_atoms,r
   bzero(results_matR,num_orbs*num_orbs*sizeof(real));
   bzero(results_matI,num_orbs*num_orbs*sizeof(real));
 
-  /********
-
-    Do the first matrix multiply and fill the temporary matrix
-
-  *********/
-
-  /* first loop over rows in the temporary matrix */
-  for(i=0;i<num_orbs;i++){
-
-    itab = i*num_orbs;
-
-    frag = 0;
-    FMO_frag = &(details->FMO_frags[frag]);
-    T_matR = FMO_frag->eigenset.vectR;
-    T_matI = FMO_frag->eigenset.vectI;
-    num_orbs_this_frag = 0;
-
-    /* now loop over columns */
-    for(j=0;j<num_orbs;j++){
-
-      /* check to see if we need to move onto the next fragment */
-      if( num_orbs_this_frag == FMO_frag->num_orbs ){
-        frag++;
-        FMO_frag = &(details->FMO_frags[frag]);
-        T_matR = FMO_frag->eigenset.vectR;
-        T_matI = FMO_frag->eigenset.vectI;
-        num_orbs_this_frag = 0;
-      }
-
-      jtab = j*num_orbs;
-      FMO_jtab = num_orbs_this_frag*FMO_frag->num_orbs;
-
-      /***********
+  max_orbs = max_FMO_frag_orbs(details,num_frags);
+  mark = arena_mark(&kpoint_arena);
+  temp_matR = (real *)arena_calloc(&kpoint_arena,(long)max_orbs*max_orbs,
+                                   sizeof(real));
 
-        to do the multiplication, loop over the atoms in the fragment and do the
-        orbitals of each atom.
+  for(frag1=0;frag1<num_frags;frag1++){
+    FMO_frag1 = &(details->FMO_frags[frag1]);
+    num_orbs1 = FMO_frag1->num_orbs;
+    T_matR1 = FMO_frag1->eigenset.vectR;
 
-      ************/
-      accumR = 0.0;
-      for(atom1=0; atom1<FMO_frag->num_atoms; atom1++){
-        /******
+    for(frag2=0;frag2<num_frags;frag2++){
+      FMO_frag2 = &(details->FMO_frags[frag2]);
+      num_orbs2 = FMO_frag2->num_orbs;
+      T_matR2 = FMO_frag2->eigenset.vectR;
 
-          the location of the orbitals belonging to this atom must be found
-          in BOTH the main and FMO coefficient matrices.
+      /********
 
-        *******/
-        find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom1],
-                        orbital_lookup_table,&begin1,&end1);
-        find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom1,
-                        FMO_frag->orbital_lookup_table,&FMO_begin1,&FMO_end1);
-
-        if( begin1 >= 0 && FMO_begin1 >= 0 ){
-          /* loop over the atom's orbitals */
-          for(k=0;k<(end1-begin1);k++){
-            FMO_ktab = k+FMO_begin1;
-            ktab = (k+begin1);
-
-            accumR += AO_matR[itab + ktab]*T_matR[FMO_ktab+FMO_jtab];
+        the first multiply: the AO rows of fragment 1 times the
+        coefficients of fragment 2
+
+      *********/
+      for(i=0;i<num_orbs1;i++){
+        itab = FMO_frag1->orb_map[i]*num_orbs;
+        for(j=0;j<num_orbs2;j++){
+          FMO_jtab = j*num_orbs2;
+          accumR = 0.0;
+          for(k=0;k<num_orbs2;k++){
+            accumR += AO_matR[itab + FMO_frag2->orb_map[k]]*T_matR2[k+FMO_jtab];
           }
+          temp_matR[i*num_orbs2+j] = accumR;
         }
       }
 
-      num_orbs_this_frag++;
-      /* set the matrix element */
-      temp_matR[itab+j] = accumR;
-    }
-  }
-
-  /***********
-
-    okay, now the temporary matrix is built, do the second matrix multiplication
-
-  ************/
-  frag = 0;
-  FMO_frag = &(details->FMO_frags[frag]);
-  T_matR = FMO_frag->eigenset.vectR;
-  T_matI = FMO_frag->eigenset.vectR;
-  num_orbs_this_frag = 0;
-
-  /* first loop over rows (MO's) in the new matrix */
-  for(i=0;i<num_orbs;i++){
-    /* check to see if we need to move onto the next fragment */
-    if( num_orbs_this_frag == FMO_frag->num_orbs ){
-      frag++;
-      FMO_frag = &(details->FMO_frags[frag]);
-      T_matR = FMO_frag->tform_matrix.matR;
-      T_matI = FMO_frag->tform_matrix.matI;
-      num_orbs_this_frag = 0;
-    }
-
-    itab = i*num_orbs;
-
-    FMO_itab = num_orbs_this_frag*FMO_frag->num_orbs;
-
-    /* now loop over columns (FMO's) */
-    for(j=0;j<num_orbs;j++){
-      jtab = j;
-      /***********
-
-        to do the multiplication, loop over the atoms in the fragment and do the
-        orbitals of each atom.
-
-      ************/
-      accumR = 0.0;
-      for(atom1=0; atom1<FMO_frag->num_atoms; atom1++){
-        /******
-
-          the location of the orbitals belonging to this atom must be found
-          in BOTH the main and FMO coefficient matrices.
-
-        *******/
-        find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom1],
-                        orbital_lookup_table,&begin1,&end1);
-        find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom1,
-                        FMO_frag->orbital_lookup_table,&FMO_begin1,&FMO_end1);
-
-        if( begin1 >= 0 && FMO_begin1 >= 0 ){
-          /* loop over the atom's orbitals */
-          for(k=0;k<(end1-begin1);k++){
-            FMO_ktab = k+FMO_begin1;
-
-            ktab = (k+begin1)*num_orbs;
-            accumR += T_matR[FMO_itab + FMO_ktab]*temp_matR[ktab+jtab];
+      /* and the second */
+      for(i=0;i<num_orbs1;i++){
+        FMO_itab = i*num_orbs1;
+        itab = (FMO_frag1->orb_offset+i)*num_orbs + FMO_frag2->orb_offset;
+        for(j=0;j<num_orbs2;j++){
+          accumR = 0.0;
+          for(k=0;k<num_orbs1;k++){
+            accumR += T_matR1[FMO_itab + k]*temp_matR[k*num_orbs2+j];
           }
+          /* set the matrix element */
+          results_matR[itab+j] = accumR;
         }
       }
-
-      /* set the matrix element */
-      results_matR[itab+j] = accumR;
     }
-    num_orbs_this_frag++;
   }
+  arena_release(&kpoint_arena,mark);
 
 #ifdef DEBUG
 fprintf(output_file,"\n\n\n\t FMO matrix \n");
@@ -920,7 +904,6 @@ fprintf(output_file,"\n\n\n");
 * Arguments:    details: pointer to detail type
 *    num_orbs,num_atoms: integer
 *              herm_mat: hermetian_matrix_type
-*   temp_matR,temp_matI: pointers to reals
 *               results: hermetian_matrix_type
 *  orbital_lookup_table: pointer to int
 *
@@ -933,196 +916,117 @@ fprintf(output_file,"\n\n\n");
 *    matrix ('herm_mat), using the FMO coefficient matrices as
 *    the transformation matrix.
 *
-*   'AO_matR and 'AO_matI are assumed to be 'num_orbs x 'num_orbs.
-*   'temp_matR and 'temp_matI, which are used to store intermediate results,
-*    should also be at least 'num_orbs x 'num_orbs.
+*   As in tform_matrix_to_FMO_basis, this is done one pair of fragments
+*    at a time.  Since the results are hermetian, only the blocks on
+*    and above the diagonal need to be done.
 *
 *   The results of the multiplication are put into the matrix 'results
 *
 ****************************************************************************/
 void tform_hermetian_matrix_to_FMO_basis(detail_type *details,int num_orbs,int num_atoms,hermetian_matrix_type herm_mat,
-                               real *temp_matR,real *temp_matI,hermetian_matrix_type results,int *orbital_lookup_table)
+                                         hermetian_matrix_type results,int *orbital_lookup_table)
 {
-  FMO_frag_type *FMO_frag;
-
-  int num_orbs_this_frag;
-  int frag,atom1,atom2,i,j,k;
-  int itab,FMO_itab;
-  int jtab,FMO_jtab;
-  int ktab,FMO_ktab;
-  int begin1,end1,FMO_begin1,FMO_end1;
-  real *results_mat;
-  real *T_matR,*T_matI;
+  FMO_frag_type *FMO_frag1,*FMO_frag2;
+  int frag1,frag2,num_frags;
+  int num_orbs1,num_orbs2,max_orbs;
+  int i,j,k;
+  int itab,jtab,ktab,FMO_itab,FMO_jtab;
+  real *T_matR1,*T_matI1;
+  real *T_matR2,*T_matI2;
+  real *temp_matR,*temp_matI;
   real accumR, accumI;
+  arena_mark_type mark;
 
+  if( !details->num_FMO_frags ) num_frags = details->num_FCO_frags;
+  else num_frags = details->num_FMO_frags;
 
   /* start by zeroing out the results matrix */
   bzero(results.mat,num_orbs*num_orbs*sizeof(real));
 
+  max_orbs = max_FMO_frag_orbs(details,num_frags);
+  mark = arena_mark(&kpoint_arena);
+  temp_matR = (real *)arena_calloc(&kpoint_arena,(long)max_orbs*max_orbs,
+                                   sizeof(real));
+  temp_matI = (real *)arena_calloc(&kpoint_arena,(long)max_orbs*max_orbs,
+                                   sizeof(real));
+
+  for(frag1=0;frag1<num_frags;frag1++){
+    FMO_frag1 = &(details->FMO_frags[frag1]);
+    num_orbs1 = FMO_frag1->num_orbs;
+    T_matR1 = FMO_frag1->eigenset.vectR;
+    T_matI1 = FMO_frag1->eigenset.vectI;
+
+    for(frag2=frag1;frag2<num_frags;frag2++){
+      FMO_frag2 = &(details->FMO_frags[frag2]);
+      num_orbs2 = FMO_frag2->num_orbs;
+      T_matR2 = FMO_frag2->eigenset.vectR;
+      T_matI2 = FMO_frag2->eigenset.vectI;
 
-  /********
-
-    Do the first matrix multiply and fill the temporary matrix
-
-  *********/
-
-  /* first loop over rows in the temporary matrix */
-  for(i=0;i<num_orbs;i++){
-
-    itab = i*num_orbs;
-
-    frag = 0;
-    FMO_frag = &(details->FMO_frags[frag]);
-    T_matR = FMO_frag->eigenset.vectR;
-    T_matI = FMO_frag->eigenset.vectI;
-    num_orbs_this_frag = 0;
-
-    /* now loop over columns */
-    for(j=0;j<num_orbs;j++){
-
-      /* check to see if we need to move onto the next fragment */
-      if( num_orbs_this_frag == FMO_frag->num_orbs ){
-        frag++;
-        FMO_frag = &(details->FMO_frags[frag]);
-        T_matR = FMO_frag->eigenset.vectR;
-        T_matI = FMO_frag->eigenset.vectI;
-        num_orbs_this_frag = 0;
-      }
-
-      jtab = j*num_orbs;
-      FMO_jtab = num_orbs_this_frag*FMO_frag->num_orbs;
-
-      /***********
-
-        to do the multiplication, loop over the atoms in the fragment and do the
-        orbitals of each atom.
-
-      ************/
-      accumR = 0.0;
-      accumI = 0.0;
-      for(atom1=0; atom1<FMO_frag->num_atoms; atom1++){
-        /******
-
-          the location of the orbitals belonging to this atom must be found
-          in BOTH the main and FMO coefficient matrices.
+      /********
 
-        *******/
-        find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom1],
-                        orbital_lookup_table,&begin1,&end1);
-        find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom1,
-                        FMO_frag->orbital_lookup_table,&FMO_begin1,&FMO_end1);
-
-        if( begin1 >= 0 && FMO_begin1 >= 0 ){
-
-          /* loop over the atom's orbitals */
-          for(k=0;k<(end1-begin1);k++){
-            FMO_ktab = k+FMO_begin1;
-            ktab = (k+begin1);
-
-            accumR += S_ELEMENT_R(herm_mat.mat,num_orbs,i,ktab)*
-              T_matR[FMO_ktab+FMO_jtab];
-            accumR += S_ELEMENT_I(herm_mat.mat,num_orbs,i,ktab)*
-              T_matI[FMO_ktab+FMO_jtab];
-            accumI += S_ELEMENT_I(herm_mat.mat,num_orbs,i,ktab)*
-              T_matR[FMO_ktab+FMO_jtab];
-            accumI -= S_ELEMENT_R(herm_mat.mat,num_orbs,i,ktab)*
-              T_matI[FMO_ktab+FMO_jtab];
+        Do the first matrix multiply and fill the temporary block:
+        the AO rows of fragment 1 times the coefficients of fragment 2
+
+      *********/
+      for(i=0;i<num_orbs1;i++){
+        itab = FMO_frag1->orb_map[i];
+        for(j=0;j<num_orbs2;j++){
+          FMO_jtab = j*num_orbs2;
+          accumR = 0.0;
+          accumI = 0.0;
+          for(k=0;k<num_orbs2;k++){
+            ktab = FMO_frag2->orb_map[k];
+            accumR += S_ELEMENT_R(herm_mat.mat,num_orbs,itab,ktab)*
+              T_matR2[k+FMO_jtab];
+            accumR += S_ELEMENT_I(herm_mat.mat,num_orbs,itab,ktab)*
+              T_matI2[k+FMO_jtab];
+            accumI += S_ELEMENT_I(herm_mat.mat,num_orbs,itab,ktab)*
+              T_matR2[k+FMO_jtab];
+            accumI -= S_ELEMENT_R(herm_mat.mat,num_orbs,itab,ktab)*
+              T_matI2[k+FMO_jtab];
           }
+          temp_matR[i*num_orbs2+j] = accumR;
+          temp_matI[i*num_orbs2+j] = accumI;
         }
       }
 
-      num_orbs_this_frag++;
-      /* set the matrix element */
-      temp_matR[itab+j] = accumR;
-      temp_matI[itab+j] = accumI;
-    }
-  }
-
-#ifdef DEBUG
-fprintf(output_file,"\n\n\n\t FMO temporary matrix REAL part\n");
-printmat(temp_matR,num_orbs,num_orbs,output_file,1e-5,0,details->line_width);
-printmat(temp_matI,num_orbs,num_orbs,output_file,1e-5,0,details->line_width);
-fprintf(output_file,"\n\n\n");
-#endif
-
-  /***********
-
-    okay, now the temporary matrix is built, do the second matrix multiplication
-
-  ************/
-  frag = 0;
-  FMO_frag = &(details->FMO_frags[frag]);
-  T_matR = FMO_frag->eigenset.vectR;
-  T_matI = FMO_frag->eigenset.vectI;
-  num_orbs_this_frag = 0;
-
-  /* first loop over rows (MO's) in the new matrix */
-  for(i=0;i<num_orbs;i++){
-    /* check to see if we need to move onto the next fragment */
-    if( num_orbs_this_frag == FMO_frag->num_orbs ){
-      frag++;
-      FMO_frag = &(details->FMO_frags[frag]);
-      T_matR = FMO_frag->eigenset.vectR;
-      T_matI = FMO_frag->eigenset.vectI;
-      num_orbs_this_frag = 0;
-    }
-
-    itab = i*num_orbs;
-
-    FMO_itab = num_orbs_this_frag*FMO_frag->num_orbs;
-
-    /* now loop over columns (FMO's) */
-    for(j=i;j<num_orbs;j++){
-      jtab = j;
       /***********
 
-        to do the multiplication, loop over the atoms in the fragment and do the
-        orbitals of each atom.
+        okay, now the temporary block is built, do the second matrix
+        multiplication
 
       ************/
-      accumR = 0.0;
-      accumI = 0.0;
-      for(atom1=0; atom1<FMO_frag->num_atoms; atom1++){
-        /******
-
-          the location of the orbitals belonging to this atom must be found
-          in BOTH the main and FMO coefficient matrices.
+      for(i=0;i<num_orbs1;i++){
+        FMO_itab = i*num_orbs1;
+        itab = FMO_frag1->orb_offset+i;
+
+        /* on the diagonal blocks we only need the upper triangle */
+        for(j=(frag1 == frag2 ? i : 0);j<num_orbs2;j++){
+          jtab = FMO_frag2->orb_offset+j;
+          accumR = 0.0;
+          accumI = 0.0;
+          for(k=0;k<num_orbs1;k++){
+            ktab = k*num_orbs2;
+            accumR += T_matR1[FMO_itab + k]*temp_matR[ktab+j];
+            accumR -= T_matI1[FMO_itab + k]*temp_matI[ktab+j];
+            accumI += T_matR1[FMO_itab + k]*temp_matI[ktab+j];
+            accumI += T_matI1[FMO_itab + k]*temp_matR[ktab+j];
+          }
 
-        *******/
-        find_atoms_orbs(num_orbs,num_atoms,FMO_frag->atoms_in_frag[atom1],
-                        orbital_lookup_table,&begin1,&end1);
-        find_atoms_orbs(FMO_frag->num_orbs,FMO_frag->num_atoms,atom1,
-                        FMO_frag->orbital_lookup_table,&FMO_begin1,&FMO_end1);
-
-        if( begin1 >= 0 && FMO_begin1 >= 0 ){
-
-          /* loop over the atom's orbitals */
-          for(k=0;k<(end1-begin1);k++){
-            FMO_ktab = k+FMO_begin1;
-            ktab = (k+begin1)*num_orbs;
-            accumR += T_matR[FMO_itab + FMO_ktab]*temp_matR[ktab+jtab];
-            accumR -= T_matI[FMO_itab + FMO_ktab]*temp_matI[ktab+jtab];
-            accumI += T_matR[FMO_itab + FMO_ktab]*temp_matI[ktab+jtab];
-            accumI += T_matI[FMO_itab + FMO_ktab]*temp_matR[ktab+jtab];
+          /* set the matrix element */
+          results.mat[itab*num_orbs+jtab] = accumR;
+          if( jtab != itab ){
+            results.mat[jtab*num_orbs+itab] = accumI;
           }
         }
       }
-
-      /* set the matrix element */
-      results.mat[itab+j] = accumR;
-      if( j != i ){
-        results.mat[j*num_orbs+i] = accumI;
-      }
     }
-    num_orbs_this_frag++;
   }
+  arena_release(&kpoint_arena,mark);
+
 #ifdef DEBUG
 fprintf(output_file,"\n\n\n\t FMO overlap matrix \n");
 printmat(results.mat,num_orbs,num_orbs,output_file,1e-5,details->line_width);
 fprintf(output_file,"\n\n\n");
 #endif
 }
-
-
-
-
@@ -63,7 +63,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 * Returns: none
 *
 * Action: This just performs the weighted sum of the R-overlaps for the given
-*   k-point.
+*   k-point.  The sum is done in double precision even if the R-overlaps
+*   are kept in single precision.
 *
 ****************************************************************************/
 void build_k_overlap_FAT(cell_type *cell,k_point_type *kpoint,hermetian_matrix_type overlapR,hermetian_matrix_type overlapK,int num_orbs)
@@ -77,6 +78,7 @@ void build_k_overlap_FAT(cell_type *cell,k_point_type *kpoint,hermetian_matrix_t
   real kdotR,temp;
   real cos_term,sin_term;
   real *which_overlap;
+  int overlap_num;
 
 
   kpointloc.x = TWOPI*kpoint->loc.x;
@@ -85,10 +87,10 @@ void build_k_overlap_FAT(cell_type *cell,k_point_type *kpoint,hermetian_matrix_t
 
 
   /*****
-    we'll use which_overlap to keep track of our location within the
-    R space overlap matrix.
+    we'll use overlap_num to keep track of our location within the
+    R space overlap matrix, which_overlap points to the current S(R).
   ******/
-  which_overlap = overlapR.mat;
+  overlap_num = 0;
 
   /* copy the unit cell overlap values into the k space matrix */
   for(l=0;l<num_orbs;l++){
@@ -102,7 +104,7 @@ void build_k_overlap_FAT(cell_type *cell,k_point_type *kpoint,hermetian_matrix_t
 
   /* sum up the individual overlaps, just like when overlapR was built */
   for(i=1;i<=cell->overlaps[0];i++){
-    which_overlap += num_orbs*num_orbs;
+    which_overlap = R_overlap_block(overlapR,++overlap_num,num_orbs);
 
     kdotR = kpointloc.x*(real)i;
     cos_term = cos(kdotR);
@@ -132,7 +134,7 @@ void build_k_overlap_FAT(cell_type *cell,k_point_type *kpoint,hermetian_matrix_t
     for(i=0;i<=2*cell->overlaps[0];i++){
       itab = cell->overlaps[0]-i;
       for(j=1;j<=cell->overlaps[1];j++){
-        which_overlap += num_orbs*num_orbs;
+        which_overlap = R_overlap_block(overlapR,++overlap_num,num_orbs);
         kdotR = kpointloc.x*(real)itab+kpointloc.y*(real)j;
         cos_term = cos(kdotR);
         sin_term = sin(kdotR);
@@ -157,7 +159,7 @@ void build_k_overlap_FAT(cell_type *cell,k_point_type *kpoint,hermetian_matrix_t
         jtab = cell->overlaps[0] - j;
         for(k=0;k<=2*cell->overlaps[1];k++){
           ktab = cell->overlaps[1] - k;
-          which_overlap += num_orbs*num_orbs;
+          which_overlap = R_overlap_block(overlapR,++overlap_num,num_orbs);
           kdotR = kpointloc.x*(real)jtab+kpointloc.y*(real)ktab+
             kpointloc.z*(real)i;
           cos_term = cos(kdotR);
@@ -124,21 +124,12 @@ void full_R_space_Hamiltonian(cell_type *cell,detail_type *details,
   int orb_tab1,orb_tab2;
   atom_type *atom_ptr1,*atom_ptr2;
   real temp,temp2;
-  static real *diagonal_elements=0;
-  static int diagonal_elements_size=0;
-#if 0
-real *rham;
-
-rham = (real *)calloc(num_orbs*num_orbs,sizeof(real));
-#endif
-
-  /* get space for the diagonal elements if it hasn't been done already */
-  if( !diagonal_elements || diagonal_elements_size != num_orbs){
-    if(diagonal_elements) free(diagonal_elements);
-    diagonal_elements = (real *)calloc(num_orbs,sizeof(real));
-    if( !diagonal_elements )fatal("Can't get memory to build hamiltonian.");
-    diagonal_elements_size = num_orbs;
-  }
+  real *diagonal_elements;
+  arena_mark_type mark;
+
+  /* get space for the diagonal elements */
+  mark = arena_mark(&cycle_arena);
+  diagonal_elements = (real *)arena_calloc(&cycle_arena,num_orbs,sizeof(real));
 
   /******
     put in the diagonal elements. These are just the coulomb
@@ -207,13 +198,7 @@ rham = (real *)calloc(num_orbs*num_orbs,sizeof(real));
     }
   }
 
-#if 0
-  fprintf(output_file,"\n\n----------------------------- OVERLAP:\n");
-printmat(overlap.mat,num_orbs,num_orbs,output_file,1e-6,details->line_width);
-
-  fprintf(output_file,"\n\n----------------------------------Hamiltonian:\n");
-printmat(rham,num_orbs,num_orbs,output_file,1e-6,details->line_width);
-#endif
+  arena_release(&cycle_arena,mark);
 }
 
 
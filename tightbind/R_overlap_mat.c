@@ -123,6 +123,645 @@ void zero_overlaps(real *overlap,detail_type *details,int num_orbs,int num_atoms
 
 
 
+/****************************************************************************
+*
+*                   Procedure R_overlap_pair
+*
+* Arguments: block: pointer to type real
+*               ld: int
+*             cell: pointer to cell type
+*              i,j: int
+*        dist_vect: point_type
+*       derivative: char
+*
+* Returns: none
+*
+* Action: evaluates the overlaps between the orbitals of atoms 'i and 'j,
+*   where 'dist_vect is the vector from atom j to atom i (so it includes
+*   any lattice translation).  The element for orbital a of atom i and
+*   orbital b of atom j goes in block[a*ld+b].
+*
+*   Mov evaluates the overlap matrix elements between those atoms in
+*     a basis of sigma, pi, and delta (with phi if those icky f orbitals
+*     are being used).  The ugly transformation matrix crap that is at
+*     the top constructs the matrix to transform from this simple
+*     (spherical polar) basis back into the cartesian (sensible, but hard
+*     to do the math) basis.
+*
+*   If 'derivative is set, mov_derivative is used instead of mov, so
+*     'block is filled with the derivatives of the overlaps with respect
+*     to the distance between the atoms (in bohr) at fixed orientation.
+*
+*   The atoms should be between 1e-6 and rho apart, calc_R_overlap checks
+*     this before calling here.
+*
+****************************************************************************/
+void R_overlap_pair(real *block,int ld,cell_type *cell,int i,int j,
+                    point_type dist_vect,char derivative)
+{
+  void (*radial_fn) PROTO((real *,real *,real *,real *,int,int,real,int,int,
+                           int,int,atom_type *));
+  real tot_dist,xy_dist,cosA,sinA,cosB,sinB;
+  real s2B,c2B,c2A,sA3,c3B,s3B;
+  real p_trans_mat[P_SIZE],d_trans_mat[D_SIZE],f_trans_mat[F_SIZE];
+  real sigma,pi,delta,phi;
+  real temp;
+  int i_orb,j_orb;
+  int la,lb;
+  int q_num1,q_num2;
+
+  if( derivative ) radial_fn = mov_derivative;
+  else radial_fn = mov;
+
+  /* zero out the transformation matrices just to make sure */
+  bzero(p_trans_mat,(P_SIZE)*sizeof(real));
+  bzero(d_trans_mat,(D_SIZE)*sizeof(real));
+  bzero(f_trans_mat,(F_SIZE)*sizeof(real));
+
+  temp = dist_vect.x*dist_vect.x + dist_vect.y*dist_vect.y;
+
+  /* distance in the xy plane */
+  xy_dist = sqrt(temp);
+  /* total distance */
+  tot_dist = sqrt(temp + dist_vect.z*dist_vect.z);
+
+  /********
+
+    set up the cosines and sines of the angles A & B
+
+    A is the angle between the distance vector and the z axis
+    B is the angle between the xy projection of the distance
+    vector and the x axis
+
+    *********/
+  if( xy_dist < 1e-5 ){
+    cosB = 1.0;
+    sinB = 0.0;
+    sinA = 0.0;
+  }
+  else{
+    cosB = dist_vect.x/xy_dist;
+    sinB = dist_vect.y/xy_dist;
+    sinA = xy_dist/tot_dist;
+  }
+  cosA = dist_vect.z/tot_dist;
+
+  /*******
+    build the p projection matrix
+    (order:  x,y,z)
+    *******/
+  p_trans_mat[0+BEGIN_P] = sinA*cosB;
+  p_trans_mat[1+BEGIN_P] =sinA*sinB;
+  p_trans_mat[2+BEGIN_P] =cosA;
+  p_trans_mat[3+BEGIN_P] =cosA*cosB;
+  p_trans_mat[4+BEGIN_P] =cosA*sinB;
+  p_trans_mat[5+BEGIN_P] =-sinA;
+  p_trans_mat[6+BEGIN_P] =-sinB;
+  p_trans_mat[7+BEGIN_P] =cosB;
+  p_trans_mat[8+BEGIN_P] =0.0;
+
+  /*******
+    build the d projection matrix
+    (order:  x2-y2,z2,xy,xz,yz)
+    *******/
+  if( cell->atoms[i].nd || cell->atoms[j].nd ){
+
+    /* some useful definitions */
+    c2A = (cosA*cosA)-(sinA*sinA);
+    c2B = (cosB*cosB)-(sinB*sinB);
+    s2B = 2*sinB*cosB;
+
+
+    d_trans_mat[0+BEGIN_D] =SQRT3*.5*sinA*sinA*c2B;
+    d_trans_mat[1+BEGIN_D] =1.0-1.5*sinA*sinA;
+    d_trans_mat[2+BEGIN_D] =SQRT3*cosB*sinB*sinA*sinA;
+    d_trans_mat[3+BEGIN_D] =SQRT3*cosA*sinA*cosB;
+    d_trans_mat[4+BEGIN_D] =SQRT3*cosA*sinA*sinB;
+    d_trans_mat[5+BEGIN_D] =cosA*sinA*c2B;
+    d_trans_mat[6+BEGIN_D] =-SQRT3*cosA*sinA;
+    d_trans_mat[7+BEGIN_D] =cosA*sinA*s2B;
+    d_trans_mat[8+BEGIN_D] =cosB*c2A;
+    d_trans_mat[9+BEGIN_D] =sinB*c2A;
+    d_trans_mat[10+BEGIN_D] =-sinA*s2B;
+    d_trans_mat[11+BEGIN_D] =0.0;
+    d_trans_mat[12+BEGIN_D] =sinA*c2B;
+    d_trans_mat[13+BEGIN_D] =-p_trans_mat[4+BEGIN_P];
+    d_trans_mat[14+BEGIN_D] =p_trans_mat[3+BEGIN_P];
+ }
+
+  /* only do these if both atoms have d or f orbitals */
+
+  if((cell->atoms[i].nd || cell->atoms[i].nf) && (cell->atoms[j].nd || cell->atoms[j].nf)){
+    d_trans_mat[15+BEGIN_D] =.50*(1.0+cosA*cosA)*c2B;
+    d_trans_mat[16+BEGIN_D] =.50*SQRT3*sinA*sinA;
+    d_trans_mat[17+BEGIN_D] =cosB*sinB*(1.0+cosA*cosA);
+    d_trans_mat[18+BEGIN_D] =-cosA*sinA*cosB;
+    d_trans_mat[19+BEGIN_D] =-cosA*sinA*sinB;
+    d_trans_mat[20+BEGIN_D] =-cosA*s2B;
+    d_trans_mat[21+BEGIN_D] =0.0;
+    d_trans_mat[22+BEGIN_D] =cosA*c2B;
+    d_trans_mat[23+BEGIN_D] =p_trans_mat[1+BEGIN_P];
+    d_trans_mat[24+BEGIN_D] =-p_trans_mat[0+BEGIN_P];
+  }
+  /*******
+    build the f projection matrix
+    *******/
+
+  if( cell->atoms[i].nf || cell->atoms[j].nf ){
+
+    /* some useful definitions */
+    sA3 = sinA*sinA*sinA;
+    c3B = (c2B*cosB)-(s2B*sinB);
+    s3B = (c2B*sinB)+(s2B*cosB);
+
+    f_trans_mat[0+BEGIN_F] =0.5*cosA*(5*cosA*cosA-3);
+    f_trans_mat[1+BEGIN_F] =SQRT6*0.25*cosB*sinA*(5*cosA*cosA-1);
+    f_trans_mat[2+BEGIN_F] =SQRT6*0.25*sinB*sinA*(5*cosA*cosA-1);
+    f_trans_mat[3+BEGIN_F] =SQRT15*sinB*cosB*cosA*sinA*sinA;
+    f_trans_mat[4+BEGIN_F] =SQRT15*0.5*c2B*cosA*sinA*sinA;
+    f_trans_mat[5+BEGIN_F] =SQRT10*0.25*c3B*sA3;
+    f_trans_mat[6+BEGIN_F] =SQRT10*0.25*s3B*sA3;
+    f_trans_mat[7+BEGIN_F] =(-SQRT6)*0.25*sinA*(5*cosA*cosA-1);
+    f_trans_mat[8+BEGIN_F] =0.25*cosB*cosA*(15*cosA*cosA-11);
+    f_trans_mat[9+BEGIN_F] =0.25*sinB*cosA*(15*cosA*cosA-11);
+    f_trans_mat[10+BEGIN_F] =SQRT10*0.25*s2B*sinA*(3*cosA*cosA-1);
+    f_trans_mat[11+BEGIN_F] =SQRT10*0.25*c2B*sinA*(3*cosA*cosA-1);
+    f_trans_mat[12+BEGIN_F] =SQRT15*0.25*c3B*cosA*sinA*sinA;
+    f_trans_mat[13+BEGIN_F] =SQRT15*0.25*s3B*cosA*sinA*sinA;
+    f_trans_mat[14+BEGIN_F] =0.0;
+    f_trans_mat[15+BEGIN_F] =(-0.25)*sinB*(5*cosA*cosA-1);
+    f_trans_mat[16+BEGIN_F] =0.25*cosB*(5*cosA*cosA-1);
+    f_trans_mat[17+BEGIN_F] =SQRT10*0.5*c2B*sinA*cosA;
+    f_trans_mat[18+BEGIN_F] =(-SQRT10)*sinA*cosA*sinB*cosB;
+    f_trans_mat[19+BEGIN_F] =(-SQRT15)*0.25*s3B*sinA*sinA;
+    f_trans_mat[20+BEGIN_F] =SQRT15*0.25*sinA*sinA*cosB*(4*cosB*cosB-3);
+  }
+
+  /*   only do these if both atoms have d or f orbitals */
+
+  if( (cell->atoms[i].nd || cell->atoms[i].nf) && (cell->atoms[j].nd || cell->atoms[j].nf)){
+    f_trans_mat[21+BEGIN_F] =0.0;
+    f_trans_mat[22+BEGIN_F] =SQRT10*0.5*sinB*cosA*sinA;
+    f_trans_mat[23+BEGIN_F] =(-SQRT10)*0.5*cosB*cosA*sinA;
+    f_trans_mat[24+BEGIN_F] =c2B*(cosA*cosA-sinA*sinA);
+    f_trans_mat[25+BEGIN_F] =(-s2B)*(cosA*cosA-sinA*sinA);
+    f_trans_mat[26+BEGIN_F] =(-SQRT6)*0.5*s3B*sinA*cosA;
+    f_trans_mat[27+BEGIN_F] =SQRT6*0.5*cosA*sinA*cosB*(4*cosB*cosB-3);
+    f_trans_mat[28+BEGIN_F] =SQRT15*0.5*cosA*sinA*sinA;
+    f_trans_mat[29+BEGIN_F] =SQRT10*0.25*cosB*sinA*(1-3*cosA*cosA);
+    f_trans_mat[30+BEGIN_F] =SQRT10*0.25*sinA*sinB*(1-3*cosA*cosA);
+    f_trans_mat[31+BEGIN_F] =sinB*cosB*cosA*(3*cosA*cosA-1);
+    f_trans_mat[32+BEGIN_F] =0.5*c2B*cosA*(3*cosA*cosA-1);
+    f_trans_mat[33+BEGIN_F] =SQRT6*0.25*c3B*sinA*(1+cosA*cosA);
+    f_trans_mat[34+BEGIN_F] =SQRT6*0.25*s3B*sinA*(1+cosA*cosA);
+  }
+
+  /*   only do these if both atoms have f orbitals */
+
+  if( cell->atoms[i].nf && cell->atoms[j].nf){
+    f_trans_mat[35+BEGIN_F] =SQRT10*0.25*sinA*(cosA*cosA-1);
+    f_trans_mat[36+BEGIN_F] =SQRT15*0.25*cosB*cosA*sinA*sinA;
+    f_trans_mat[37+BEGIN_F] =SQRT15*0.25*sinB*cosA*sinA*sinA;
+    f_trans_mat[38+BEGIN_F] =(-SQRT6)*0.5*sinB*cosB*sinA*(1+cosA*cosA);
+    f_trans_mat[39+BEGIN_F] =(-SQRT6)*0.25*c2B*sinA*(1+cosA*cosA);
+    f_trans_mat[40+BEGIN_F] =0.25*c3B*cosA*(3+cosA*cosA);
+    f_trans_mat[41+BEGIN_F] =0.25*s3B*cosA*(3+cosA*cosA);
+    f_trans_mat[42+BEGIN_F] =0.0;
+    f_trans_mat[43+BEGIN_F] =(-SQRT15)*0.25*sinB*sinA*sinA;
+    f_trans_mat[44+BEGIN_F] =SQRT15*0.25*cosB*sinA*sinA;
+    f_trans_mat[45+BEGIN_F] =(-SQRT6)*0.5*c2B*sinA*cosA;
+    f_trans_mat[46+BEGIN_F] =SQRT6*sinB*cosB*sinA*cosA;
+    f_trans_mat[47+BEGIN_F] =(-0.25)*s3B*(1+3*cosA*cosA);
+    f_trans_mat[48+BEGIN_F] =0.25*c3B*(1+3*cosA*cosA);
+  }
+  /* AUI is 1/BOHR where BOHR is the Bohr radius */
+  tot_dist *= AUI;
+
+  /*************
+
+    Now actually evaluate the overlaps
+
+    **************/
+
+  /*-----------
+    < S(i) | S(j) >
+    -------------*/
+  q_num1 = cell->atoms[i].ns;
+  q_num2 = cell->atoms[j].ns;
+  if( q_num1 && q_num2 ){
+    la = 0;
+    lb = 0;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    /* fprintf(stderr,"S-S: (sigma) %.12f\n",sigma);  */
+
+    block[0] = sigma;
+  }
+
+  /*-----------
+    < P(i) | S(j) >
+    -------------*/
+  q_num1 = cell->atoms[i].np;
+  if( q_num1 && q_num2 ){
+    la = 1;
+    lb = 0;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    sigma *= -1;
+
+    /* fprintf(stderr,"P-S: (sigma) %.12f\n",sigma);  */
+
+    for(j_orb=BEGIN_P;j_orb<=END_P;j_orb++){
+      block[j_orb*ld] = p_trans_mat[j_orb]*sigma;
+    }
+  }
+
+  /*-----------
+    < P(i) | P(j) >
+    -------------*/
+  q_num2 = cell->atoms[j].np;
+  if( q_num1 && q_num2 ){
+    la = 1;
+    lb = 1;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    sigma *= -1;
+
+    /* fprintf(stderr,"P-P: (sigma,pi) %.12f %.12f\n",sigma,pi);  */
+
+    for(j_orb=BEGIN_P;j_orb<=END_P;j_orb++){
+      for(i_orb=j_orb;i_orb<=END_P;i_orb++){
+        block[i_orb*ld+j_orb] =
+          p_trans_mat[j_orb]*p_trans_mat[i_orb]*sigma +
+            (p_trans_mat[i_orb+3]*p_trans_mat[j_orb+3] +
+             p_trans_mat[i_orb+6]*p_trans_mat[j_orb+6]) * pi;
+        block[j_orb*ld+i_orb] =
+          block[i_orb*ld+j_orb];
+
+/*                  fprintf(stderr,"P-P: orbital %d and %d\t%f \n",j_orb+1,i_orb+1,block[j_orb*ld+i_orb]);     */
+      }
+    }
+  }
+
+  /*-----------
+    < S(i) | P(j) >
+    -------------*/
+  q_num1 = cell->atoms[i].ns;
+  if( q_num1 && q_num2 ){
+    la = 0;
+    lb = 1;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    /* fprintf(stderr,"S-P: (sigma) %.12f\n",sigma);  */
+
+    for(j_orb=BEGIN_P;j_orb<=END_P;j_orb++){
+      block[j_orb] = p_trans_mat[j_orb]*sigma;
+    }
+  }
+
+  /*-----------
+    < S(i) | D(j) >
+    -------------*/
+  q_num2 = cell->atoms[j].nd;
+  if( q_num1 && q_num2 ){
+    la = 0;
+    lb = 2;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    /* fprintf(stderr,"S-D: (sigma) %.12f\n",sigma);   */
+
+    for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
+      block[j_orb] = d_trans_mat[j_orb]*sigma;
+    }
+  }
+
+  /*-----------
+    < P(i) | D(j) >
+    -------------*/
+  q_num1 = cell->atoms[i].np;
+  if( q_num1 && q_num2 ){
+    la = 1;
+    lb = 2;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    sigma *= -1;
+
+    /* fprintf(stderr,"P-D: (sigma,pi) %.12f %.12f\n",sigma,pi);   */
+
+    for(i_orb=BEGIN_P;i_orb<=END_P;i_orb++){
+      for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
+        block[i_orb*ld+j_orb] =
+          p_trans_mat[i_orb]*d_trans_mat[j_orb]*sigma +
+            (d_trans_mat[j_orb+5]*p_trans_mat[i_orb+3] +
+             d_trans_mat[j_orb+10]*p_trans_mat[i_orb+6]) * pi;
+      }
+    }
+  }
+
+  /*-----------
+    < D(i) | S(j) >
+    -------------*/
+  q_num1 = cell->atoms[i].nd;
+  q_num2 = cell->atoms[j].ns;
+  if( q_num1 && q_num2 ){
+    la = 2;
+    lb = 0;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    /* fprintf(stderr,"D-S: (sigma) %.12f\n",sigma);   */
+
+    for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
+      block[j_orb*ld] = d_trans_mat[j_orb]*sigma;
+    }
+  }
+
+  /*-----------
+    < D(i) | P(j) >
+    -------------*/
+  q_num2 = cell->atoms[j].np;
+  if( q_num1 && q_num2 ){
+    la = 2;
+    lb = 1;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    pi *= -1;
+
+    /* fprintf(stderr,"D-P: (sigma,pi) %.12f %.12f\n",sigma,pi);   */
+
+    for(i_orb=BEGIN_P;i_orb<=END_P;i_orb++){
+      for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
+        block[j_orb*ld+i_orb] =
+          p_trans_mat[i_orb]*d_trans_mat[j_orb]*sigma +
+            (p_trans_mat[i_orb+3]*d_trans_mat[j_orb+5] +
+             d_trans_mat[j_orb+10]*p_trans_mat[i_orb+6]) * pi;
+      }
+    }
+  }
+
+  /*-----------
+    < D(i) | D(j) >
+    -------------*/
+  q_num2 = cell->atoms[j].nd;
+  if( q_num1 && q_num2 ){
+    la = 2;
+    lb = 2;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
+        la,lb,cell->atoms);
+
+    pi *= -1;
+
+    /* fprintf(stderr,"D-D: (sigma,pi,delta) %.12f %.12f %.12f\n",
+            sigma,pi,delta);  */
+
+    for(i_orb=BEGIN_D;i_orb<=END_D;i_orb++){
+      for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
+        block[j_orb*ld+i_orb] =
+          d_trans_mat[i_orb]*d_trans_mat[j_orb]*sigma +
+            (d_trans_mat[i_orb+5]*d_trans_mat[j_orb+5] +
+             d_trans_mat[j_orb+10]*d_trans_mat[i_orb+10])*pi+
+               (d_trans_mat[i_orb+15]*d_trans_mat[j_orb+15] +
+                d_trans_mat[i_orb+20]*d_trans_mat[j_orb+20])*delta;
+
+        /*
+          fprintf(stderr,"D-D element(%d,%d)= %f\n",
+          i_orb,j_orb,block[j_orb*ld+i_orb]);
+          */
+
+        block[i_orb*ld+j_orb] =
+          block[j_orb*ld+i_orb];
+      }
+    }
+  }
+
+  /*------------
+    < S(i) | F(j) >
+    -------------*/
+  q_num1 = cell->atoms[i].ns;
+  q_num2 = cell->atoms[j].nf;
+  if(q_num1 && q_num2){
+    la = 0;
+    lb = 3;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,
+        q_num1,q_num2,la,lb,cell->atoms);
+
+    /* fprintf(stderr, "S-F:  (sigma) %f \n",sigma);  */
+
+    for(j_orb=BEGIN_F;j_orb<=END_F;j_orb++){
+      block[j_orb]=
+        f_trans_mat[j_orb]*sigma;
+
+      /*
+        fprintf(stderr,"S-F element(%d)= %f\n",
+        j_orb,block[j_orb]);
+        */
+
+    }
+  }
+
+  /*------------
+    < P(i) | F(j) >
+    -------------*/
+  q_num1 = cell->atoms[i].np;
+  q_num2 = cell->atoms[j].nf;
+  if(q_num1 && q_num2){
+    la = 1;
+    lb = 3;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,
+        q_num1,q_num2,la,lb,cell->atoms);
+
+    sigma *= -1;
+
+    /* fprintf(stderr, "P-F:  (sigma,pi) %f %f \n",
+            sigma, pi);  */
+
+    for(i_orb=BEGIN_P; i_orb<=END_P; i_orb++){
+      for(j_orb=BEGIN_F; j_orb<=END_F; j_orb++){
+        block[i_orb*ld+j_orb]=
+          p_trans_mat[i_orb]*f_trans_mat[j_orb]*sigma +
+            (p_trans_mat[i_orb+3]*f_trans_mat[j_orb+7] +
+             p_trans_mat[i_orb+6]*f_trans_mat[j_orb+14])*pi;
+
+        /*
+          fprintf(stderr,"P-F element(%d,%d)= %f\n",
+          i_orb,j_orb,block[i_orb*ld+j_orb]);
+          */
+
+      }
+    }
+  }
+
+  /*------------
+    < D(i) | F(j) >
+    ------------*/
+  q_num1 = cell->atoms[i].nd;
+  q_num2 = cell->atoms[j].nf;
+  if(q_num1 && q_num2){
+    la = 2;
+    lb = 3;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,
+        q_num1,q_num2,la,lb,cell->atoms);
+
+    pi *= -1;
+
+    /* fprintf(stderr, "D-F:  (sigma,pi,delta) %f %f %f \n",
+            sigma,pi,delta);   */
+
+    for(i_orb=BEGIN_D;i_orb<=END_D;i_orb++){
+      for(j_orb=BEGIN_F;j_orb<=END_F;j_orb++){
+        block[i_orb*ld+j_orb]=
+          d_trans_mat[i_orb]*f_trans_mat[j_orb]*sigma +
+            (d_trans_mat[i_orb+5]*f_trans_mat[j_orb+7] +
+             d_trans_mat[i_orb+10]*f_trans_mat[j_orb+14])*pi +
+               (d_trans_mat[i_orb+15]*f_trans_mat[j_orb+28] +
+                d_trans_mat[i_orb+20]*f_trans_mat[j_orb+21])*delta;
+
+        /*
+          fprintf(stderr,"D-F element(%d,%d)= %f\n",
+          i_orb,j_orb,block[i_orb*ld+j_orb]);
+          */
+
+      }
+    }
+  }
+
+  /*------------
+    < F(i) | F(j) >
+    ------------*/
+  q_num1 = cell->atoms[i].nf;
+  q_num2 = cell->atoms[j].nf;
+  if(q_num1 && q_num2){
+    la = 3;
+    lb = 3;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,
+        q_num1,q_num2,la,lb,cell->atoms);
+
+    sigma *= -1;
+
+    /* fprintf(stderr, "F-F:  (sigma,pi,delta,phi) %f %f %f %f \n",
+            sigma,pi,delta,phi);   */
+
+    for(i_orb=BEGIN_F;i_orb<=END_F; i_orb++){
+      for(j_orb=BEGIN_F;j_orb<=END_F; j_orb++){
+        block[j_orb*ld+i_orb]=
+          f_trans_mat[i_orb]*f_trans_mat[j_orb]*sigma +
+            (f_trans_mat[i_orb+7]*f_trans_mat[j_orb+7] +
+             f_trans_mat[i_orb+14]*f_trans_mat[j_orb+14])*pi +
+               (f_trans_mat[i_orb+21]*f_trans_mat[j_orb+21] +
+                f_trans_mat[i_orb+28]*f_trans_mat[j_orb+28])*delta +
+                  (f_trans_mat[i_orb+35]*f_trans_mat[j_orb+35]+
+                   f_trans_mat[i_orb+42]*f_trans_mat[j_orb+42])*phi;
+
+        /*
+          fprintf(stderr,"F-F element(%d,%d)= %f\n",
+          i_orb,j_orb,overlap[(i_tab+j_orb)*num_orbs
+          +j_tab+i_orb]);
+          */
+        block[i_orb*ld+j_orb]=
+          block[j_orb*ld+i_orb];
+      }
+    }
+  }
+
+  /*------------
+    < F(i) | S(j) >
+    -----------*/
+  q_num1 = cell->atoms[i].nf;
+  q_num2 = cell->atoms[j].ns;
+  if(q_num1 && q_num2){
+    la = 3;
+    lb = 0;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,
+        q_num1,q_num2,la,lb,cell->atoms);
+
+    sigma *= -1;
+
+    /* fprintf(stderr, "F-S: (sigma) %f \n",sigma);  */
+
+    for(i_orb=BEGIN_F;i_orb<=END_F;i_orb++){
+      block[i_orb*ld]=
+        f_trans_mat[i_orb]*sigma;
+    }
+  }
+
+  /*------------
+    < F(i) | P(j) >
+    ------------*/
+  q_num1 = cell->atoms[i].nf;
+  q_num2 = cell->atoms[j].np;
+  if(q_num1 && q_num2){
+    la = 3;
+    lb = 1;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,
+        q_num1,q_num2,la,lb,cell->atoms);
+
+    sigma *= -1;
+
+    /* fprintf(stderr,"F-P: (sigma,pi) %f %f \n",sigma,pi);  */
+
+    for(i_orb=BEGIN_F;i_orb<=END_F;i_orb++){
+      for(j_orb=BEGIN_P;j_orb<=END_P;j_orb++){
+        block[i_orb*ld+j_orb]=
+          f_trans_mat[i_orb]*p_trans_mat[j_orb]*sigma +
+            (f_trans_mat[i_orb+7]*p_trans_mat[j_orb+3] +
+             f_trans_mat[i_orb+14]*p_trans_mat[j_orb+6])*pi;
+      }
+    }
+  }
+
+  /*-------------
+    < F(i) | D(j) >
+    ------------*/
+  q_num1 = cell->atoms[i].nf;
+  q_num2 = cell->atoms[j].nd;
+  if(q_num1 && q_num2){
+    la = 3;
+    lb = 2;
+
+    (*radial_fn)(&sigma,&pi,&delta,&phi,i,j,tot_dist,
+        q_num1,q_num2,la,lb,cell->atoms);
+
+    sigma *= -1; delta *= -1;
+
+    /* fprintf(stderr, "F-D: (sigma,pi,delta) %f %f %f \n",sigma,pi,delta); */
+
+    for(i_orb=BEGIN_F;i_orb<=END_F;i_orb++){
+      for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
+        block[i_orb*ld+j_orb]=
+          f_trans_mat[i_orb]*d_trans_mat[j_orb]*sigma +
+            (f_trans_mat[i_orb+7]*d_trans_mat[j_orb+5] +
+             f_trans_mat[i_orb+14]*d_trans_mat[j_orb+10])*pi +
+               (f_trans_mat[i_orb+21]*d_trans_mat[j_orb+20] +
+                f_trans_mat[i_orb+28]*d_trans_mat[j_orb+15])*delta;
+      }
+    }
+  }
+  /* END OF MATRIX ELEMENTS */
+}
+
+
 /****************************************************************************
 *
 *                   Procedure calc_R_overlap
@@ -148,15 +787,12 @@ void zero_overlaps(real *overlap,detail_type *details,int num_orbs,int num_atoms
 *  Hugh and I figured out some of what happens here. (but we didn't make the
 *    code any more palatable).
 *
-*   Between each pair of atoms mov is called.  Mov evaluates
-*     the overlap matrix elements between those atoms in a basis
-*     of sigma, pi, and delta (with phi if those icky f orbitals
-*     are being used).  The ugly transformation matrix crap that
-*     is at the top of the double loop over all atoms constructs
-*     the matrix to transform from this simple (spherical polar)
-*     basis back into the cartesian (sensible, but hard to do the
-*     math) basis.  I still have no idea how mov works and God
-*     forbid that I should *ever* have to look at lovlap.
+*   Between each pair of atoms R_overlap_pair is called, which
+*     calls mov to evaluate the overlap matrix elements between those
+*     atoms in a basis of sigma, pi, and delta (with phi if those
+*     icky f orbitals are being used) and then transforms them back
+*     into the cartesian basis.  I still have no idea how mov works
+*     and God forbid that I should *ever* have to look at lovlap.
 *
 ****************************************************************************/
 void calc_R_overlap(real *overlap,cell_type *cell,detail_type *details,
@@ -164,28 +800,32 @@ void calc_R_overlap(real *overlap,cell_type *cell,detail_type *details,
                     int *orbital_lookup_table)
 {
   point_type dist_vect;
-  real tot_dist,xy_dist,cosA,sinA,cosB,sinB;
-  real s2B,c2B,c2A,sA3,c3B,s3B;
-  real p_trans_mat[P_SIZE],d_trans_mat[D_SIZE],f_trans_mat[F_SIZE];
-  real sigma,pi,delta,phi;
+  real tot_dist;
   real temp;
 
-  int i,j,k,j_end;
+  int i,j,j_end;
   int i_tab,j_tab;
-  int i_orb,j_orb;
-  int la,lb;
-  int q_num1,q_num2;
+  neighbor_list_type *neighbors;
+  int image,pair,pair_end;
 
-  /* zero out the transformation matrices just to make sure */
-  bzero(p_trans_mat,(P_SIZE)*sizeof(real));
-  bzero(d_trans_mat,(D_SIZE)*sizeof(real));
-  bzero(f_trans_mat,(F_SIZE)*sizeof(real));
   bzero(overlap,num_orbs*num_orbs*sizeof(real));
 
   /*
     printf("add: %6.4lf %6.4lf %6.4lf\n",distances.x,distances.y,distances.z);
     printf("MOVLAP\n");
     */
+  /********
+    only atoms within rho of each other can overlap, so the neighbor
+    list is used to skip the others.  The atoms in the cell shifted by
+    'distances are those in the neighbor list's cell at -'distances.
+    If that cell isn't in the list, every pair gets checked.
+  ********/
+  neighbors = get_neighbor_list(cell,details->rho);
+  dist_vect.x = -distances.x;
+  dist_vect.y = -distances.y;
+  dist_vect.z = -distances.z;
+  image = find_neighbor_image(neighbors,dist_vect);
+
   j_end = cell->num_atoms;
   for(i=0;i<cell->num_atoms;i++){
 
@@ -206,7 +846,17 @@ void calc_R_overlap(real *overlap,cell_type *cell,detail_type *details,
 
     /* trap dummy atoms */
     if(i_tab >= 0 ){
-      for(j=0;j<j_end;j++){
+      if( image >= 0 ){
+        pair = neighbors->first[i*neighbors->num_images+image];
+        pair_end = neighbors->first[i*neighbors->num_images+image+1];
+      } else{
+        pair = 0;
+        pair_end = j_end;
+      }
+      for(;pair<pair_end;pair++){
+        j = image >= 0 ? neighbors->partner[pair] : pair;
+        /* the partners are sorted, so we can stop here */
+        if( j >= j_end ) break;
         j_tab = orbital_lookup_table[j];
         if(j_tab >= 0){
           /* this is the distance vector between the two atoms */
@@ -218,8 +868,6 @@ void calc_R_overlap(real *overlap,cell_type *cell,detail_type *details,
             */
           temp = dist_vect.x*dist_vect.x + dist_vect.y*dist_vect.y;
 
-          /* distance in the xy plane */
-          xy_dist = sqrt(temp);
           /* total distance */
           tot_dist = sqrt(temp + dist_vect.z*dist_vect.z);
 
@@ -241,581 +889,8 @@ void calc_R_overlap(real *overlap,cell_type *cell,detail_type *details,
 
           *********/
           if( tot_dist >= 1e-6 && tot_dist <= details->rho ){
-
-            /********
-
-              set up the cosines and sines of the angles A & B
-
-              A is the angle between the distance vector and the z axis
-              B is the angle between the xy projection of the distance
-              vector and the x axis
-
-              *********/
-            if( xy_dist < 1e-5 ){
-              cosB = 1.0;
-              sinB = 0.0;
-              sinA = 0.0;
-            }
-            else{
-              cosB = dist_vect.x/xy_dist;
-              sinB = dist_vect.y/xy_dist;
-              sinA = xy_dist/tot_dist;
-            }
-            cosA = dist_vect.z/tot_dist;
-
-            /*******
-              build the p projection matrix
-              (order:  x,y,z)
-              *******/
-            p_trans_mat[0+BEGIN_P] = sinA*cosB;
-            p_trans_mat[1+BEGIN_P] =sinA*sinB;
-            p_trans_mat[2+BEGIN_P] =cosA;
-            p_trans_mat[3+BEGIN_P] =cosA*cosB;
-            p_trans_mat[4+BEGIN_P] =cosA*sinB;
-            p_trans_mat[5+BEGIN_P] =-sinA;
-            p_trans_mat[6+BEGIN_P] =-sinB;
-            p_trans_mat[7+BEGIN_P] =cosB;
-            p_trans_mat[8+BEGIN_P] =0.0;
-
-            /*******
-              build the d projection matrix
-              (order:  x2-y2,z2,xy,xz,yz)
-              *******/
-            if( cell->atoms[i].nd || cell->atoms[j].nd ){
-
-              /* some useful definitions */
-              c2A = (cosA*cosA)-(sinA*sinA);
-              c2B = (cosB*cosB)-(sinB*sinB);
-              s2B = 2*sinB*cosB;
-
-
-              d_trans_mat[0+BEGIN_D] =SQRT3*.5*sinA*sinA*c2B;
-              d_trans_mat[1+BEGIN_D] =1.0-1.5*sinA*sinA;
-              d_trans_mat[2+BEGIN_D] =SQRT3*cosB*sinB*sinA*sinA;
-              d_trans_mat[3+BEGIN_D] =SQRT3*cosA*sinA*cosB;
-              d_trans_mat[4+BEGIN_D] =SQRT3*cosA*sinA*sinB;
-              d_trans_mat[5+BEGIN_D] =cosA*sinA*c2B;
-              d_trans_mat[6+BEGIN_D] =-SQRT3*cosA*sinA;
-              d_trans_mat[7+BEGIN_D] =cosA*sinA*s2B;
-              d_trans_mat[8+BEGIN_D] =cosB*c2A;
-              d_trans_mat[9+BEGIN_D] =sinB*c2A;
-              d_trans_mat[10+BEGIN_D] =-sinA*s2B;
-              d_trans_mat[11+BEGIN_D] =0.0;
-              d_trans_mat[12+BEGIN_D] =sinA*c2B;
-              d_trans_mat[13+BEGIN_D] =-p_trans_mat[4+BEGIN_P];
-              d_trans_mat[14+BEGIN_D] =p_trans_mat[3+BEGIN_P];
-           }
-
-            /* only do these if both atoms have d or f orbitals */
-
-            if((cell->atoms[i].nd || cell->atoms[i].nf) && (cell->atoms[j].nd || cell->atoms[j].nf)){
-              d_trans_mat[15+BEGIN_D] =.50*(1.0+cosA*cosA)*c2B;
-              d_trans_mat[16+BEGIN_D] =.50*SQRT3*sinA*sinA;
-              d_trans_mat[17+BEGIN_D] =cosB*sinB*(1.0+cosA*cosA);
-              d_trans_mat[18+BEGIN_D] =-cosA*sinA*cosB;
-              d_trans_mat[19+BEGIN_D] =-cosA*sinA*sinB;
-              d_trans_mat[20+BEGIN_D] =-cosA*s2B;
-              d_trans_mat[21+BEGIN_D] =0.0;
-              d_trans_mat[22+BEGIN_D] =cosA*c2B;
-              d_trans_mat[23+BEGIN_D] =p_trans_mat[1+BEGIN_P];
-              d_trans_mat[24+BEGIN_D] =-p_trans_mat[0+BEGIN_P];
-            }
-            /*******
-              build the f projection matrix
-              *******/
-
-            if( cell->atoms[i].nf || cell->atoms[j].nf ){
-
-              /* some useful definitions */
-              sA3 = sinA*sinA*sinA;
-              c3B = (c2B*cosB)-(s2B*sinB);
-              s3B = (c2B*sinB)+(s2B*cosB);
-
-              f_trans_mat[0+BEGIN_F] =0.5*cosA*(5*cosA*cosA-3);
-              f_trans_mat[1+BEGIN_F] =SQRT6*0.25*cosB*sinA*(5*cosA*cosA-1);
-              f_trans_mat[2+BEGIN_F] =SQRT6*0.25*sinB*sinA*(5*cosA*cosA-1);
-              f_trans_mat[3+BEGIN_F] =SQRT15*sinB*cosB*cosA*sinA*sinA;
-              f_trans_mat[4+BEGIN_F] =SQRT15*0.5*c2B*cosA*sinA*sinA;
-              f_trans_mat[5+BEGIN_F] =SQRT10*0.25*c3B*sA3;
-              f_trans_mat[6+BEGIN_F] =SQRT10*0.25*s3B*sA3;
-              f_trans_mat[7+BEGIN_F] =(-SQRT6)*0.25*sinA*(5*cosA*cosA-1);
-              f_trans_mat[8+BEGIN_F] =0.25*cosB*cosA*(15*cosA*cosA-11);
-              f_trans_mat[9+BEGIN_F] =0.25*sinB*cosA*(15*cosA*cosA-11);
-              f_trans_mat[10+BEGIN_F] =SQRT10*0.25*s2B*sinA*(3*cosA*cosA-1);
-              f_trans_mat[11+BEGIN_F] =SQRT10*0.25*c2B*sinA*(3*cosA*cosA-1);
-              f_trans_mat[12+BEGIN_F] =SQRT15*0.25*c3B*cosA*sinA*sinA;
-              f_trans_mat[13+BEGIN_F] =SQRT15*0.25*s3B*cosA*sinA*sinA;
-              f_trans_mat[14+BEGIN_F] =0.0;
-              f_trans_mat[15+BEGIN_F] =(-0.25)*sinB*(5*cosA*cosA-1);
-              f_trans_mat[16+BEGIN_F] =0.25*cosB*(5*cosA*cosA-1);
-              f_trans_mat[17+BEGIN_F] =SQRT10*0.5*c2B*sinA*cosA;
-              f_trans_mat[18+BEGIN_F] =(-SQRT10)*sinA*cosA*sinB*cosB;
-              f_trans_mat[19+BEGIN_F] =(-SQRT15)*0.25*s3B*sinA*sinA;
-              f_trans_mat[20+BEGIN_F] =SQRT15*0.25*sinA*sinA*cosB*(4*cosB*cosB-3);
-            }
-
-            /*   only do these if both atoms have d or f orbitals */
-
-            if( (cell->atoms[i].nd || cell->atoms[i].nf) && (cell->atoms[j].nd || cell->atoms[j].nf)){
-              f_trans_mat[21+BEGIN_F] =0.0;
-              f_trans_mat[22+BEGIN_F] =SQRT10*0.5*sinB*cosA*sinA;
-              f_trans_mat[23+BEGIN_F] =(-SQRT10)*0.5*cosB*cosA*sinA;
-              f_trans_mat[24+BEGIN_F] =c2B*(cosA*cosA-sinA*sinA);
-              f_trans_mat[25+BEGIN_F] =(-s2B)*(cosA*cosA-sinA*sinA);
-              f_trans_mat[26+BEGIN_F] =(-SQRT6)*0.5*s3B*sinA*cosA;
-              f_trans_mat[27+BEGIN_F] =SQRT6*0.5*cosA*sinA*cosB*(4*cosB*cosB-3);
-              f_trans_mat[28+BEGIN_F] =SQRT15*0.5*cosA*sinA*sinA;
-              f_trans_mat[29+BEGIN_F] =SQRT10*0.25*cosB*sinA*(1-3*cosA*cosA);
-              f_trans_mat[30+BEGIN_F] =SQRT10*0.25*sinA*sinB*(1-3*cosA*cosA);
-              f_trans_mat[31+BEGIN_F] =sinB*cosB*cosA*(3*cosA*cosA-1);
-              f_trans_mat[32+BEGIN_F] =0.5*c2B*cosA*(3*cosA*cosA-1);
-              f_trans_mat[33+BEGIN_F] =SQRT6*0.25*c3B*sinA*(1+cosA*cosA);
-              f_trans_mat[34+BEGIN_F] =SQRT6*0.25*s3B*sinA*(1+cosA*cosA);
-            }
-
-            /*   only do these if both atoms have f orbitals */
-
-            if( cell->atoms[i].nf && cell->atoms[j].nf){
-              f_trans_mat[35+BEGIN_F] =SQRT10*0.25*sinA*(cosA*cosA-1);
-              f_trans_mat[36+BEGIN_F] =SQRT15*0.25*cosB*cosA*sinA*sinA;
-              f_trans_mat[37+BEGIN_F] =SQRT15*0.25*sinB*cosA*sinA*sinA;
-              f_trans_mat[38+BEGIN_F] =(-SQRT6)*0.5*sinB*cosB*sinA*(1+cosA*cosA);
-              f_trans_mat[39+BEGIN_F] =(-SQRT6)*0.25*c2B*sinA*(1+cosA*cosA);
-              f_trans_mat[40+BEGIN_F] =0.25*c3B*cosA*(3+cosA*cosA);
-              f_trans_mat[41+BEGIN_F] =0.25*s3B*cosA*(3+cosA*cosA);
-              f_trans_mat[42+BEGIN_F] =0.0;
-              f_trans_mat[43+BEGIN_F] =(-SQRT15)*0.25*sinB*sinA*sinA;
-              f_trans_mat[44+BEGIN_F] =SQRT15*0.25*cosB*sinA*sinA;
-              f_trans_mat[45+BEGIN_F] =(-SQRT6)*0.5*c2B*sinA*cosA;
-              f_trans_mat[46+BEGIN_F] =SQRT6*sinB*cosB*sinA*cosA;
-              f_trans_mat[47+BEGIN_F] =(-0.25)*s3B*(1+3*cosA*cosA);
-              f_trans_mat[48+BEGIN_F] =0.25*c3B*(1+3*cosA*cosA);
-            }
-            /* AUI is 1/BOHR where BOHR is the Bohr radius */
-            tot_dist *= AUI;
-
-            /*************
-
-              Now actually evaluate the overlaps
-
-              **************/
-
-            /*-----------
-              < S(i) | S(j) >
-              -------------*/
-            q_num1 = cell->atoms[i].ns;
-            q_num2 = cell->atoms[j].ns;
-            if( q_num1 && q_num2 ){
-              la = 0;
-              lb = 0;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              /* fprintf(stderr,"S-S: (sigma) %.12f\n",sigma);  */
-
-              overlap[i_tab*num_orbs+j_tab] = sigma;
-            }
-
-            /*-----------
-              < P(i) | S(j) >
-              -------------*/
-            q_num1 = cell->atoms[i].np;
-            if( q_num1 && q_num2 ){
-              la = 1;
-              lb = 0;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              sigma *= -1;
-
-              /* fprintf(stderr,"P-S: (sigma) %.12f\n",sigma);  */
-
-              for(j_orb=BEGIN_P;j_orb<=END_P;j_orb++){
-                overlap[(i_tab+j_orb)*num_orbs+j_tab] = p_trans_mat[j_orb]*sigma;
-              }
-            }
-
-            /*-----------
-              < P(i) | P(j) >
-              -------------*/
-            q_num2 = cell->atoms[j].np;
-            if( q_num1 && q_num2 ){
-              la = 1;
-              lb = 1;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              sigma *= -1;
-
-              /* fprintf(stderr,"P-P: (sigma,pi) %.12f %.12f\n",sigma,pi);  */
-
-              for(j_orb=BEGIN_P;j_orb<=END_P;j_orb++){
-                for(i_orb=j_orb;i_orb<=END_P;i_orb++){
-                  overlap[(i_tab+i_orb)*num_orbs+j_tab+j_orb] =
-                    p_trans_mat[j_orb]*p_trans_mat[i_orb]*sigma +
-                      (p_trans_mat[i_orb+3]*p_trans_mat[j_orb+3] +
-                       p_trans_mat[i_orb+6]*p_trans_mat[j_orb+6]) * pi;
-                  overlap[(i_tab+j_orb)*num_orbs+j_tab+i_orb] =
-                    overlap[(i_tab+i_orb)*num_orbs+j_tab+j_orb];
-
-/*                  fprintf(stderr,"P-P: orbital %d and %d\t%f \n",j_orb+1,i_orb+1,overlap[(i_tab+j_orb)*num_orbs + j_tab + i_orb]);     */
-                }
-              }
-            }
-
-            /*-----------
-              < S(i) | P(j) >
-              -------------*/
-            q_num1 = cell->atoms[i].ns;
-            if( q_num1 && q_num2 ){
-              la = 0;
-              lb = 1;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              /* fprintf(stderr,"S-P: (sigma) %.12f\n",sigma);  */
-
-              for(j_orb=BEGIN_P;j_orb<=END_P;j_orb++){
-                overlap[i_tab*num_orbs+j_tab+j_orb] = p_trans_mat[j_orb]*sigma;
-              }
-            }
-
-            /*-----------
-              < S(i) | D(j) >
-              -------------*/
-            q_num2 = cell->atoms[j].nd;
-            if( q_num1 && q_num2 ){
-              la = 0;
-              lb = 2;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              /* fprintf(stderr,"S-D: (sigma) %.12f\n",sigma);   */
-
-              for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
-                overlap[i_tab*num_orbs+j_tab+j_orb] = d_trans_mat[j_orb]*sigma;
-              }
-            }
-
-            /*-----------
-              < P(i) | D(j) >
-              -------------*/
-            q_num1 = cell->atoms[i].np;
-            if( q_num1 && q_num2 ){
-              la = 1;
-              lb = 2;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              sigma *= -1;
-
-              /* fprintf(stderr,"P-D: (sigma,pi) %.12f %.12f\n",sigma,pi);   */
-
-              for(i_orb=BEGIN_P;i_orb<=END_P;i_orb++){
-                for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
-                  overlap[(i_tab+i_orb)*num_orbs+j_tab+j_orb] =
-                    p_trans_mat[i_orb]*d_trans_mat[j_orb]*sigma +
-                      (d_trans_mat[j_orb+5]*p_trans_mat[i_orb+3] +
-                       d_trans_mat[j_orb+10]*p_trans_mat[i_orb+6]) * pi;
-                }
-              }
-            }
-
-            /*-----------
-              < D(i) | S(j) >
-              -------------*/
-            q_num1 = cell->atoms[i].nd;
-            q_num2 = cell->atoms[j].ns;
-            if( q_num1 && q_num2 ){
-              la = 2;
-              lb = 0;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              /* fprintf(stderr,"D-S: (sigma) %.12f\n",sigma);   */
-
-              for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
-                overlap[(i_tab+j_orb)*num_orbs+j_tab] = d_trans_mat[j_orb]*sigma;
-              }
-            }
-
-            /*-----------
-              < D(i) | P(j) >
-              -------------*/
-            q_num2 = cell->atoms[j].np;
-            if( q_num1 && q_num2 ){
-              la = 2;
-              lb = 1;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              pi *= -1;
-
-              /* fprintf(stderr,"D-P: (sigma,pi) %.12f %.12f\n",sigma,pi);   */
-
-              for(i_orb=BEGIN_P;i_orb<=END_P;i_orb++){
-                for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
-                  overlap[(i_tab+j_orb)*num_orbs+j_tab+i_orb] =
-                    p_trans_mat[i_orb]*d_trans_mat[j_orb]*sigma +
-                      (p_trans_mat[i_orb+3]*d_trans_mat[j_orb+5] +
-                       d_trans_mat[j_orb+10]*p_trans_mat[i_orb+6]) * pi;
-                }
-              }
-            }
-
-            /*-----------
-              < D(i) | D(j) >
-              -------------*/
-            q_num2 = cell->atoms[j].nd;
-            if( q_num1 && q_num2 ){
-              la = 2;
-              lb = 2;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,q_num1,q_num2,
-                  la,lb,cell->atoms);
-
-              pi *= -1;
-
-              /* fprintf(stderr,"D-D: (sigma,pi,delta) %.12f %.12f %.12f\n",
-                      sigma,pi,delta);  */
-
-              for(i_orb=BEGIN_D;i_orb<=END_D;i_orb++){
-                for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
-                  overlap[(i_tab+j_orb)*num_orbs+(j_tab+i_orb)] =
-                    d_trans_mat[i_orb]*d_trans_mat[j_orb]*sigma +
-                      (d_trans_mat[i_orb+5]*d_trans_mat[j_orb+5] +
-                       d_trans_mat[j_orb+10]*d_trans_mat[i_orb+10])*pi+
-                         (d_trans_mat[i_orb+15]*d_trans_mat[j_orb+15] +
-                          d_trans_mat[i_orb+20]*d_trans_mat[j_orb+20])*delta;
-
-                  /*
-                    fprintf(stderr,"D-D element(%d,%d)= %f\n",
-                    i_orb,j_orb,overlap[(i_tab+j_orb)*num_orbs+j_tab+i_orb]);
-                    */
-
-                  overlap[(i_tab+i_orb)*num_orbs+j_tab+j_orb] =
-                    overlap[(i_tab+j_orb)*num_orbs+j_tab+i_orb];
-                }
-              }
-            }
-
-            /*------------
-              < S(i) | F(j) >
-              -------------*/
-            q_num1 = cell->atoms[i].ns;
-            q_num2 = cell->atoms[j].nf;
-            if(q_num1 && q_num2){
-              la = 0;
-              lb = 3;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,
-                  q_num1,q_num2,la,lb,cell->atoms);
-
-              /* fprintf(stderr, "S-F:  (sigma) %f \n",sigma);  */
-
-              for(j_orb=BEGIN_F;j_orb<=END_F;j_orb++){
-                overlap[(i_tab*num_orbs)+j_tab+j_orb]=
-                  f_trans_mat[j_orb]*sigma;
-
-                /*
-                  fprintf(stderr,"S-F element(%d)= %f\n",
-                  j_orb,overlap[(i_tab*num_orbs)+j_tab+j_orb]);
-                  */
-
-              }
-            }
-
-            /*------------
-              < P(i) | F(j) >
-              -------------*/
-            q_num1 = cell->atoms[i].np;
-            q_num2 = cell->atoms[j].nf;
-            if(q_num1 && q_num2){
-              la = 1;
-              lb = 3;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,
-                  q_num1,q_num2,la,lb,cell->atoms);
-
-              sigma *= -1;
-
-              /* fprintf(stderr, "P-F:  (sigma,pi) %f %f \n",
-                      sigma, pi);  */
-
-              for(i_orb=BEGIN_P; i_orb<=END_P; i_orb++){
-                for(j_orb=BEGIN_F; j_orb<=END_F; j_orb++){
-                  overlap[(i_tab+i_orb)*num_orbs + j_tab + j_orb]=
-                    p_trans_mat[i_orb]*f_trans_mat[j_orb]*sigma +
-                      (p_trans_mat[i_orb+3]*f_trans_mat[j_orb+7] +
-                       p_trans_mat[i_orb+6]*f_trans_mat[j_orb+14])*pi;
-
-                  /*
-                    fprintf(stderr,"P-F element(%d,%d)= %f\n",
-                    i_orb,j_orb,overlap[(i_tab+i_orb)*num_orbs+j_tab+j_orb]);
-                    */
-
-                }
-              }
-            }
-
-            /*------------
-              < D(i) | F(j) >
-              ------------*/
-            q_num1 = cell->atoms[i].nd;
-            q_num2 = cell->atoms[j].nf;
-            if(q_num1 && q_num2){
-              la = 2;
-              lb = 3;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,
-                  q_num1,q_num2,la,lb,cell->atoms);
-
-              pi *= -1;
-
-              /* fprintf(stderr, "D-F:  (sigma,pi,delta) %f %f %f \n",
-                      sigma,pi,delta);   */
-
-              for(i_orb=BEGIN_D;i_orb<=END_D;i_orb++){
-                for(j_orb=BEGIN_F;j_orb<=END_F;j_orb++){
-                  overlap[(i_tab+i_orb)*num_orbs + j_tab + j_orb]=
-                    d_trans_mat[i_orb]*f_trans_mat[j_orb]*sigma +
-                      (d_trans_mat[i_orb+5]*f_trans_mat[j_orb+7] +
-                       d_trans_mat[i_orb+10]*f_trans_mat[j_orb+14])*pi +
-                         (d_trans_mat[i_orb+15]*f_trans_mat[j_orb+28] +
-                          d_trans_mat[i_orb+20]*f_trans_mat[j_orb+21])*delta;
-
-                  /*
-                    fprintf(stderr,"D-F element(%d,%d)= %f\n",
-                    i_orb,j_orb,overlap[(i_tab+i_orb)*num_orbs+j_tab+j_orb]);
-                    */
-
-                }
-              }
-            }
-
-            /*------------
-              < F(i) | F(j) >
-              ------------*/
-            q_num1 = cell->atoms[i].nf;
-            q_num2 = cell->atoms[j].nf;
-            if(q_num1 && q_num2){
-              la = 3;
-              lb = 3;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,
-                  q_num1,q_num2,la,lb,cell->atoms);
-
-              sigma *= -1;
-
-              /* fprintf(stderr, "F-F:  (sigma,pi,delta,phi) %f %f %f %f \n",
-                      sigma,pi,delta,phi);   */
-
-              for(i_orb=BEGIN_F;i_orb<=END_F; i_orb++){
-                for(j_orb=BEGIN_F;j_orb<=END_F; j_orb++){
-                  overlap[(i_tab+j_orb)*num_orbs + j_tab + i_orb]=
-                    f_trans_mat[i_orb]*f_trans_mat[j_orb]*sigma +
-                      (f_trans_mat[i_orb+7]*f_trans_mat[j_orb+7] +
-                       f_trans_mat[i_orb+14]*f_trans_mat[j_orb+14])*pi +
-                         (f_trans_mat[i_orb+21]*f_trans_mat[j_orb+21] +
-                          f_trans_mat[i_orb+28]*f_trans_mat[j_orb+28])*delta +
-                            (f_trans_mat[i_orb+35]*f_trans_mat[j_orb+35]+
-                             f_trans_mat[i_orb+42]*f_trans_mat[j_orb+42])*phi;
-
-                  /*
-                    fprintf(stderr,"F-F element(%d,%d)= %f\n",
-                    i_orb,j_orb,overlap[(i_tab+j_orb)*num_orbs
-                    +j_tab+i_orb]);
-                    */
-                  overlap[(i_tab+i_orb)*num_orbs + j_tab + j_orb]=
-                    overlap[(i_tab+j_orb)*num_orbs + j_tab + i_orb];
-                }
-              }
-            }
-
-            /*------------
-              < F(i) | S(j) >
-              -----------*/
-            q_num1 = cell->atoms[i].nf;
-            q_num2 = cell->atoms[j].ns;
-            if(q_num1 && q_num2){
-              la = 3;
-              lb = 0;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,
-                  q_num1,q_num2,la,lb,cell->atoms);
-
-              sigma *= -1;
-
-              /* fprintf(stderr, "F-S: (sigma) %f \n",sigma);  */
-
-              for(i_orb=BEGIN_F;i_orb<=END_F;i_orb++){
-                overlap[(i_tab+i_orb)*num_orbs + j_tab]=
-                  f_trans_mat[i_orb]*sigma;
-              }
-            }
-
-            /*------------
-              < F(i) | P(j) >
-              ------------*/
-            q_num1 = cell->atoms[i].nf;
-            q_num2 = cell->atoms[j].np;
-            if(q_num1 && q_num2){
-              la = 3;
-              lb = 1;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,
-                  q_num1,q_num2,la,lb,cell->atoms);
-
-              sigma *= -1;
-
-              /* fprintf(stderr,"F-P: (sigma,pi) %f %f \n",sigma,pi);  */
-
-              for(i_orb=BEGIN_F;i_orb<=END_F;i_orb++){
-                for(j_orb=BEGIN_P;j_orb<=END_P;j_orb++){
-                  overlap[(i_tab+i_orb)*num_orbs + j_tab + j_orb]=
-                    f_trans_mat[i_orb]*p_trans_mat[j_orb]*sigma +
-                      (f_trans_mat[i_orb+7]*p_trans_mat[j_orb+3] +
-                       f_trans_mat[i_orb+14]*p_trans_mat[j_orb+6])*pi;
-                }
-              }
-            }
-
-            /*-------------
-              < F(i) | D(j) >
-              ------------*/
-            q_num1 = cell->atoms[i].nf;
-            q_num2 = cell->atoms[j].nd;
-            if(q_num1 && q_num2){
-              la = 3;
-              lb = 2;
-
-              mov(&sigma,&pi,&delta,&phi,i,j,tot_dist,
-                  q_num1,q_num2,la,lb,cell->atoms);
-
-              sigma *= -1; delta *= -1;
-
-              /* fprintf(stderr, "F-D: (sigma,pi,delta) %f %f %f \n",sigma,pi,delta); */
-
-              for(i_orb=BEGIN_F;i_orb<=END_F;i_orb++){
-                for(j_orb=BEGIN_D;j_orb<=END_D;j_orb++){
-                  overlap[(i_tab+i_orb)*num_orbs + j_tab + j_orb]=
-                    f_trans_mat[i_orb]*d_trans_mat[j_orb]*sigma +
-                      (f_trans_mat[i_orb+7]*d_trans_mat[j_orb+5] +
-                       f_trans_mat[i_orb+14]*d_trans_mat[j_orb+10])*pi +
-                         (f_trans_mat[i_orb+21]*d_trans_mat[j_orb+20] +
-                          f_trans_mat[i_orb+28]*d_trans_mat[j_orb+15])*delta;
-                }
-              }
-            }
-            /* END OF MATRIX ELEMENTS */
+            R_overlap_pair(overlap+i_tab*num_orbs+j_tab,num_orbs,cell,i,j,
+                           dist_vect,0);
           }
         }
       }
@@ -861,6 +936,131 @@ printmat(overlap,num_orbs,num_orbs,status_file,1e-6,0,details->line_width);
 }
 
 
+/******
+  scratch space for a single S(R) when the translated cells are kept
+  in single precision.
+******/
+static real *R_overlap_scratch_mat=0;
+static long R_overlap_scratch_size=0;
+
+/****************************************************************************
+ *
+ *                   Function R_overlap_scratch
+ *
+ * Arguments: num_sq: long
+ *
+ * Returns: pointer to real
+ *
+ * Action: returns the scratch matrix, making sure it holds 'num_sq elements
+ *
+ *****************************************************************************/
+static real *R_overlap_scratch(long num_sq)
+{
+  int old_tag;
+
+  if( num_sq > R_overlap_scratch_size ){
+    if( R_overlap_scratch_mat ) my_free(R_overlap_scratch_mat);
+    old_tag = set_mem_tag(MEM_R_MATS);
+    R_overlap_scratch_mat = (real *)my_malloc(num_sq*sizeof(real));
+    set_mem_tag(old_tag);
+    if( !R_overlap_scratch_mat ) fatal("Can't allocate S(R) scratch space.");
+    R_overlap_scratch_size = num_sq;
+  }
+  return R_overlap_scratch_mat;
+}
+
+/****************************************************************************
+ *
+ *                   Procedure free_R_overlap_block
+ *
+ * Arguments: none
+ *
+ * Returns: none
+ *
+ * Action: frees the scratch matrix used by R_overlap_block
+ *
+ *****************************************************************************/
+void free_R_overlap_block()
+{
+  if( R_overlap_scratch_mat ) my_free(R_overlap_scratch_mat);
+  R_overlap_scratch_mat = 0;
+  R_overlap_scratch_size = 0;
+}
+
+/****************************************************************************
+ *
+ *                   Function R_overlap_block
+ *
+ * Arguments:  overlap: hermetian_matrix_type
+ *               which: int
+ *            num_orbs: int
+ *
+ * Returns: pointer to real
+ *
+ * Action: returns (in double precision) S(R) number 'which of the stored
+ *   overlap matrices, unit cell first.
+ *
+ *   If it's one of the packed ones it is unpacked into a scratch matrix,
+ *   which is overwritten by the next call.
+ *
+ *****************************************************************************/
+real *R_overlap_block(hermetian_matrix_type overlap,int which,int num_orbs)
+{
+  real *block;
+  long num_sq;
+
+  num_sq = (long)num_orbs*num_orbs;
+  if( !overlap.packed || which == 0 ) return &(overlap.mat[which*num_sq]);
+
+  block = R_overlap_scratch(num_sq);
+  unpack_matrix(block,&(overlap.packed[(which-1)*num_sq]),num_sq);
+  return block;
+}
+
+
+/****************************************************************************
+ *
+ *                   Procedure calc_translated_R_overlap
+ *
+ * Arguments:  overlap: hermetian_matrix_type
+ *         overlap_tab: int
+ *                cell: pointer to cell type
+ *             details: pointer to detail type
+ *            num_orbs: int
+ *           distances: point_type
+ * orbital_lookup_table: pointer to int.
+ *
+ * Returns: none
+ *
+ * Action: evaluates the overlap matrix of the cell displaced by 'distances
+ *   and stores it at position 'overlap_tab of 'overlap.  If the translated
+ *   cells are being kept in single precision it is evaluated in a
+ *   scratch matrix and then packed.
+ *
+ *****************************************************************************/
+static void calc_translated_R_overlap(hermetian_matrix_type overlap,
+                                      int overlap_tab,cell_type *cell,
+                                      detail_type *details,int num_orbs,
+                                      point_type distances,
+                                      int *orbital_lookup_table)
+{
+  real *block;
+  long num_sq;
+
+  if( !overlap.packed || overlap_tab == 0 ){
+    calc_R_overlap(&(overlap.mat[overlap_tab]),cell,details,
+                   num_orbs,distances,FALSE,orbital_lookup_table);
+    return;
+  }
+  num_sq = (long)num_orbs*num_orbs;
+  block = R_overlap_scratch(num_sq);
+  bzero((char *)block,num_sq*sizeof(real));
+  calc_R_overlap(block,cell,details,num_orbs,distances,FALSE,
+                 orbital_lookup_table);
+  pack_matrix(&(overlap.packed[overlap_tab-num_sq]),block,num_sq);
+}
+
+
 /****************************************************************************
  *
  *                   Procedure R_space_overlap_matrix
@@ -937,9 +1137,14 @@ void R_space_overlap_matrix(cell_type *cell,detail_type *details,hermetian_matri
   if( fabs(details->rho) <= 1e-3 )
     details->rho = 10.0;
 
-  /* initialize the overlap matrix to zeroes (just in case) */
+  /******
+    initialize the overlap matrix to zeroes (just in case)
+    the packed matrices are completely overwritten, so only the unit
+    cell needs to be done if there are any.
+  ******/
   if( details->store_R_overlaps ){
-    for(i=0;i<tot_overlaps;i++){
+    if( overlap.packed ) begin_packed_set();
+    for(i=0;i<(overlap.packed ? 1 : tot_overlaps);i++){
       itab = i*num_orbs*num_orbs;
       for(j=0;j<num_orbs;j++){
         jtab = j*num_orbs;
@@ -987,8 +1192,8 @@ void R_space_overlap_matrix(cell_type *cell,detail_type *details,hermetian_matri
         distances.x = i*cell_dim[0].x;
         distances.y = i*cell_dim[0].y;
         distances.z = i*cell_dim[0].z;
-        calc_R_overlap(&(overlap.mat[overlap_tab]),cell,details,
-                       num_orbs,distances,FALSE,orbital_lookup_table);
+        calc_translated_R_overlap(overlap,overlap_tab,cell,details,
+                                  num_orbs,distances,orbital_lookup_table);
         found = 1;
       }
       overlaps_so_far++;
@@ -1008,8 +1213,8 @@ void R_space_overlap_matrix(cell_type *cell,detail_type *details,hermetian_matri
           distances.y = itab*cell_dim[0].y + j*cell_dim[1].y;
           distances.z = itab*cell_dim[0].z + j*cell_dim[1].z;
 
-          calc_R_overlap(&(overlap.mat[overlap_tab]),cell,details,
-                         num_orbs,distances,FALSE,orbital_lookup_table);
+          calc_translated_R_overlap(overlap,overlap_tab,cell,details,
+                                    num_orbs,distances,orbital_lookup_table);
           found = 1;
         }
         overlaps_so_far++;
@@ -1033,8 +1238,8 @@ void R_space_overlap_matrix(cell_type *cell,detail_type *details,hermetian_matri
             distances.z = itab*cell_dim[2].z + jtab*cell_dim[0].z +
               ktab*cell_dim[1].z;
 
-            calc_R_overlap(&(overlap.mat[overlap_tab]),cell,details,
-                           num_orbs,distances,FALSE,orbital_lookup_table);
+            calc_translated_R_overlap(overlap,overlap_tab,cell,details,
+                                      num_orbs,distances,orbital_lookup_table);
             found = 1;
           }
           overlaps_so_far++;
@@ -1066,3 +1271,114 @@ not match calculated number: %d.  This is a bug.\n",overlaps_so_far,tot_overlaps
 
 
 
+
+
+/******
+  this is the basis that the currently stored overlap matrices were
+  built for.  It's used to avoid rebuilding S(R) (or S(k)) on every
+  cycle of a charge iteration when nothing that goes into the
+  overlaps has changed.
+******/
+static atom_type *overlap_basis_atoms=0;
+static int overlap_basis_num_atoms=0;
+static real overlap_basis_rho=0.0;
+static real *overlap_basis_mat=0;
+
+/****************************************************************************
+ *
+ *                   Procedure invalidate_overlap_cache
+ *
+ * Arguments: none
+ *
+ * Returns: none
+ *
+ * Action: forgets about the basis the stored overlaps were built for,
+ *   so that the next call to overlaps_are_current returns 0.
+ *   This needs to be called whenever the overlap storage is reallocated.
+ *
+ *****************************************************************************/
+void invalidate_overlap_cache()
+{
+  if( overlap_basis_atoms ) free(overlap_basis_atoms);
+  overlap_basis_atoms = 0;
+  overlap_basis_num_atoms = 0;
+  overlap_basis_rho = 0.0;
+  overlap_basis_mat = 0;
+}
+
+/****************************************************************************
+ *
+ *                   Procedure overlaps_are_current
+ *
+ * Arguments:  cell: pointer to cell type
+ *          details: pointer to detail type
+ *      overlap_mat: pointer to real
+ *
+ * Returns: char
+ *
+ * Action: checks to see if the overlap matrices stored in 'overlap_mat
+ *   were built for the current basis.  The overlaps only depend on the
+ *   atomic positions, the quantum numbers and the exponents (and
+ *   coefficients) of the orbitals, so charge iteration (which only
+ *   changes the Hii's) leaves them alone.  Zeta variation, Muller
+ *   iteration and Walsh steps all cause a rebuild.
+ *
+ *  returns 1 if the overlaps can be reused, 0 otherwise.
+ *
+ *****************************************************************************/
+char overlaps_are_current(cell_type *cell,detail_type *details,real *overlap_mat)
+{
+  atom_type *atom,*old_atom;
+  int i;
+
+  if( !overlap_basis_atoms || overlap_mat != overlap_basis_mat ||
+      cell->num_atoms != overlap_basis_num_atoms ||
+      details->rho != overlap_basis_rho ){
+    return 0;
+  }
+
+  for(i=0;i<cell->num_atoms;i++){
+    atom = &(cell->atoms[i]);
+    old_atom = &(overlap_basis_atoms[i]);
+    if( atom->loc.x != old_atom->loc.x || atom->loc.y != old_atom->loc.y ||
+        atom->loc.z != old_atom->loc.z ) return 0;
+    if( atom->ns != old_atom->ns || atom->np != old_atom->np ||
+        atom->nd != old_atom->nd || atom->nf != old_atom->nf ) return 0;
+    if( atom->exp_s != old_atom->exp_s || atom->exp_p != old_atom->exp_p ||
+        atom->exp_d != old_atom->exp_d || atom->exp_d2 != old_atom->exp_d2 ||
+        atom->exp_f != old_atom->exp_f || atom->exp_f2 != old_atom->exp_f2 )
+      return 0;
+    if( atom->coeff_d1 != old_atom->coeff_d1 ||
+        atom->coeff_d2 != old_atom->coeff_d2 ||
+        atom->coeff_f1 != old_atom->coeff_f1 ||
+        atom->coeff_f2 != old_atom->coeff_f2 ) return 0;
+  }
+  return 1;
+}
+
+/****************************************************************************
+ *
+ *                   Procedure mark_overlaps_current
+ *
+ * Arguments:  cell: pointer to cell type
+ *          details: pointer to detail type
+ *      overlap_mat: pointer to real
+ *
+ * Returns: none
+ *
+ * Action: records the basis that the overlap matrices in 'overlap_mat
+ *   have just been built for.
+ *
+ *****************************************************************************/
+void mark_overlaps_current(cell_type *cell,detail_type *details,real *overlap_mat)
+{
+  if( !overlap_basis_atoms || overlap_basis_num_atoms != cell->num_atoms ){
+    if( overlap_basis_atoms ) free(overlap_basis_atoms);
+    overlap_basis_atoms = (atom_type *)calloc(cell->num_atoms,sizeof(atom_type));
+    if( !overlap_basis_atoms ) fatal("Can't allocate overlap_basis_atoms.");
+  }
+  bcopy(cell->atoms,overlap_basis_atoms,cell->num_atoms*sizeof(atom_type));
+  overlap_basis_num_atoms = cell->num_atoms;
+  overlap_basis_rho = details->rho;
+  overlap_basis_mat = overlap_mat;
+}
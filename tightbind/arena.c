@@ -0,0 +1,208 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+
+/****************************************************************************
+*
+*     this file contains the arenas used for scratch memory in the
+*      inner loops.
+*
+*   Memory is handed out from an arena by bumping a pointer, and all of
+*    it is given back at once by resetting the arena (or back to a mark
+*    taken earlier with arena_release).  Chunks are only allocated when
+*    the arena runs out of room; they're kept across resets, so once the
+*    arena has grown to the size needed by one pass through a loop no
+*    more heap calls are made.
+*
+*   There are two global arenas (see globals.c): kpoint_arena is reset
+*    at the start of each k point and cycle_arena at the start of each
+*    SCF cycle.  Anything that needs to outlive those shouldn't be put
+*    in them.  Since each arena is just a structure, a thread can be
+*    given one of its own.
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+/* everything handed out is a multiple of this many bytes long */
+#define ARENA_ALIGN 16
+
+/* the smallest chunk that will be allocated */
+#define ARENA_MIN_CHUNK (4*1024)
+
+
+/****************************************************************************
+*
+*                   Function arena_calloc
+*
+* Arguments: arena: pointer to arena_type
+*              num: long
+*             size: long
+*
+* Returns: pointer to void
+*
+* Action: returns zeroed space for 'num elements of 'size bytes from
+*   'arena, getting a new chunk if there isn't room in the current one.
+*
+*****************************************************************************/
+void *arena_calloc(arena_type *arena,long num,long size)
+{
+  arena_chunk_type *chunk,*next;
+  long bytes,chunk_size;
+  char *ptr;
+  int old_tag;
+
+  bytes = num*size;
+  bytes = (bytes + ARENA_ALIGN - 1) & ~(long)(ARENA_ALIGN - 1);
+  if( !bytes ) bytes = ARENA_ALIGN;
+
+  chunk = arena->current;
+  if( !chunk || chunk->used + bytes > chunk->size ){
+    /* use the following chunk if it's big enough */
+    next = chunk ? chunk->next : arena->first;
+    if( next && next->size >= bytes ){
+      chunk = next;
+      chunk->used = 0;
+    } else{
+      chunk_size = chunk ? 2*chunk->size : ARENA_MIN_CHUNK;
+      if( chunk_size < bytes ) chunk_size = bytes;
+      /* the chunk header and its memory come from the same block */
+      old_tag = set_mem_tag(MEM_SCRATCH);
+      next = (arena_chunk_type *)my_malloc(sizeof(arena_chunk_type) + chunk_size);
+      set_mem_tag(old_tag);
+      if( !next ) fatal("Can't get a new chunk for an arena.");
+      next->mem = (char *)(next+1);
+      next->size = chunk_size;
+      next->used = 0;
+
+      /* splice it in after the current chunk */
+      if( chunk ){
+        next->next = chunk->next;
+        chunk->next = next;
+      } else{
+        next->next = arena->first;
+        arena->first = next;
+      }
+      chunk = next;
+    }
+    arena->current = chunk;
+  }
+
+  ptr = chunk->mem + chunk->used;
+  chunk->used += bytes;
+  bzero(ptr,bytes);
+  return (void *)ptr;
+}
+
+/****************************************************************************
+*
+*                   Procedure arena_reset
+*
+* Arguments: arena: pointer to arena_type
+*
+* Returns: none
+*
+* Action: gives back everything allocated from 'arena.  The chunks are
+*   kept for next time.
+*
+*****************************************************************************/
+void arena_reset(arena_type *arena)
+{
+  arena->current = arena->first;
+  if( arena->current ) arena->current->used = 0;
+}
+
+/****************************************************************************
+*
+*                   Function arena_mark
+*
+* Arguments: arena: pointer to arena_type
+*
+* Returns: arena_mark_type
+*
+* Action: returns the current position in 'arena, for use with
+*   arena_release.
+*
+*****************************************************************************/
+arena_mark_type arena_mark(arena_type *arena)
+{
+  arena_mark_type mark;
+
+  mark.chunk = arena->current;
+  mark.used = arena->current ? arena->current->used : 0;
+  return mark;
+}
+
+/****************************************************************************
+*
+*                   Procedure arena_release
+*
+* Arguments: arena: pointer to arena_type
+*             mark: arena_mark_type
+*
+* Returns: none
+*
+* Action: gives back everything allocated from 'arena since 'mark was
+*   taken.
+*
+*****************************************************************************/
+void arena_release(arena_type *arena,arena_mark_type mark)
+{
+  if( !mark.chunk ){
+    arena_reset(arena);
+  } else{
+    arena->current = mark.chunk;
+    arena->current->used = mark.used;
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure arena_free
+*
+* Arguments: arena: pointer to arena_type
+*
+* Returns: none
+*
+* Action: frees all of the chunks in 'arena.
+*
+*****************************************************************************/
+void arena_free(arena_type *arena)
+{
+  arena_chunk_type *chunk,*next;
+
+  for(chunk=arena->first;chunk;chunk=next){
+    next = chunk->next;
+    my_free(chunk);
+  }
+  arena->first = arena->current = 0;
+}
@@ -134,12 +134,12 @@ void calc_avg_occups(detail_type *details,cell_type *cell,int num_orbs,K_orb_ptr
 
 
   /******
-    okay, now divide all the AO_occups by the total number of k points to get
+    okay, now divide all the AO_occups by the total k point weight to get
     the average value.
   ******/
   if( !details->just_avgE ){
     for(i=0;i<num_orbs;i++){
-      AO_occups[i] = AO_occups[i]*num_occup_bands/(tot_num_K*details->num_KPOINTS);
+      AO_occups[i] = AO_occups[i]/tot_K_weight;
     }
   }
 #ifdef DEBUG
@@ -148,7 +148,7 @@ void calc_avg_occups(detail_type *details,cell_type *cell,int num_orbs,K_orb_ptr
   fprintf(output_file,"tot_num_K: %lf tot_K_weight: %lf\n",
           tot_num_K,tot_K_weight);
 #endif
-  accum = accum*num_occup_bands/(tot_num_K*details->num_KPOINTS);
+  accum = accum/tot_K_weight;
 
 #ifdef DEBUG
   fprintf(output_file,"num_filled: ");
@@ -202,6 +202,7 @@ void print_avg_occups(detail_type *details,cell_type *cell,int num_orbs,K_orb_pt
   total_electrons = 0.0;
 
   fprintf(output_file,"#Average Energy:  %lf eV\n\n",properties.total_E);
+  results_write_mat("average_energy",1,1,&properties.total_E);
   if( !details->just_avgE ){
     fprintf(output_file,"# Atomic Orbital Occupations\n");
     fprintf(output_file,";        s      px      py      pz    dx2-y2    dz2     dxy     dxz     dyz\n");
@@ -305,6 +306,8 @@ void print_avg_occups(detail_type *details,cell_type *cell,int num_orbs,K_orb_pt
     }
 
     fprintf(output_file,"There are a total of %lf electrons.\n",total_electrons);
+    results_write_mat("AO_occupations",1,num_orbs,AO_occups);
+    results_write_mat("avg_net_charges",1,cell->num_atoms,properties.net_chgs);
   }
 }
 
@@ -391,13 +394,13 @@ void calc_avg_FMO_occups(detail_type *details,int num_orbs,K_orb_ptr_type *orbit
 
 
   /******
-    okay, now divide all the FMO_occups by the total number of k points to get
+    okay, now divide all the FMO_occups by the total k point weight to get
     the average value.
   ******/
   for(i=0;i<num_orbs;i++){
-    FMO_occups[i] = FMO_occups[i]*num_occup_bands/(tot_num_K*details->num_KPOINTS);
+    FMO_occups[i] = FMO_occups[i]/tot_K_weight;
   }
-  accum = accum*num_occup_bands/(tot_num_K*details->num_KPOINTS);
+  accum = accum/tot_K_weight;
 
   fprintf(output_file,"# Fragment MO Occupations\n");
 
@@ -450,9 +453,11 @@ void calc_avg_FMO_occups(detail_type *details,int num_orbs,K_orb_ptr_type *orbit
 void calc_avg_OP(detail_type *details,cell_type *cell,int num_orbs,K_orb_ptr_type *orbital_ordering,avg_prop_info_type *avg_prop_info,
                      hermetian_matrix_type overlapR,prop_type properties)
 {
-  int i,j,k,l;
-  real tot_num_K=0.0;
-  float *MO_ptr,*MO_ptrI,*chg_mat_ptr;
+  int i,j,k,l,m;
+  real tot_K_weight;
+  real *MO_ptr,*MO_ptrI,*vectR,*vectI;
+  real weight;
+  int num_members;
   hermetian_matrix_type overlap;
   real accum,accumI;
   int kpoint,MO;
@@ -461,11 +466,9 @@ void calc_avg_OP(detail_type *details,cell_type *cell,int num_orbs,K_orb_ptr_typ
   real contrib,total_electrons;
   int begin1,begin2,end1,end2;
   real num_electrons;
-  int num_elements,num_occup_bands,num_occup_orbs;
+  int num_elements,num_occup_orbs;
   COOP_type *COOP_ptr;
 
-  tot_num_K = 0.0;
-
   overlap.dim = num_orbs;
 
   /*******
@@ -476,61 +479,69 @@ void calc_avg_OP(detail_type *details,cell_type *cell,int num_orbs,K_orb_ptr_typ
 
   /* zero them both out first */
   bzero(properties.OP_mat,num_orbs*num_orbs*sizeof(real));
-  bzero(properties.ROP_mat,num_orbs*num_orbs*sizeof(real));
+  bzero(properties.ROP_mat,cell->num_atoms*cell->num_atoms*sizeof(real));
 
   overlap.mat = overlapR.mat;
+  overlap.packed = 0;
   i = 0;
   while( orbital_ordering[i].occup > .0001 ){
     /* some pointers to make things a little more efficient */
     kpoint = orbital_ordering[i].Kpoint;
     MO = orbital_ordering[i].MO;
 
-    /* get pointers to the orbital information */
-    MO_ptr = &(avg_prop_info[kpoint].orbs[MO*num_orbs]);
-    MO_ptrI = &(avg_prop_info[kpoint].orbsI[MO*num_orbs]);
+    /******
+      get the orbital information, unfolded into the star of the
+      k point if need be.  Each member of the star gets an equal share
+      of the k point weight.
+    ******/
+    num_members = avg_prop_orbital(details,cell,num_orbs,&(avg_prop_info[kpoint]),
+                                   kpoint,MO,&vectR,&vectI);
+    weight = details->K_POINTS[kpoint].weight / (real)num_members;
 
-    for(j=0;j<num_orbs;j++){
-      for( k=j;k<num_orbs;k++){
-        /*****
-          within the unit cell there's no need to accumulate an imaginary
-          contribution to the overlap population,
-          *****/
-        accum = ((real)MO_ptr[j] * MO_ptr[k] +
-                 (real)MO_ptrI[j] * MO_ptrI[k]) /
-                   ((real)MULTIPLIER*(real)MULTIPLIER);
-        if(j != k){
-          properties.OP_mat[j*num_orbs+k] +=
-            (2.0*orbital_ordering[i].occup*details->K_POINTS[kpoint].weight*
-              accum*HERMETIAN_R(overlap,j,k));
+    for(m=0;m<num_members;m++){
+      MO_ptr = &(vectR[m*num_orbs]);
+      MO_ptrI = &(vectI[m*num_orbs]);
 
-        }
-        else{
-          properties.OP_mat[j*num_orbs+k] +=
-            (orbital_ordering[i].occup*details->K_POINTS[kpoint].weight*
-              accum*HERMETIAN_R(overlap,j,k));
+      for(j=0;j<num_orbs;j++){
+        for( k=j;k<num_orbs;k++){
+          /*****
+            within the unit cell there's no need to accumulate an imaginary
+            contribution to the overlap population,
+            *****/
+          accum = (MO_ptr[j] * MO_ptr[k] + MO_ptrI[j] * MO_ptrI[k]) /
+            ((real)MULTIPLIER*(real)MULTIPLIER);
+          if(j != k){
+            properties.OP_mat[j*num_orbs+k] +=
+              (2.0*orbital_ordering[i].occup*weight*
+               accum*HERMETIAN_R(overlap,j,k));
+
+          }
+          else{
+            properties.OP_mat[j*num_orbs+k] +=
+              (orbital_ordering[i].occup*weight*
+               accum*HERMETIAN_R(overlap,j,k));
+          }
         }
       }
     }
     i++;
   }
 
-  num_occup_bands = i;
-
-  tot_num_K = 0.0;
+  tot_K_weight = 0.0;
   for( i=0; i<details->num_KPOINTS; i++){
-    tot_num_K += details->K_POINTS[i].weight*details->K_POINTS[i].num_filled_bands;
+    tot_K_weight += details->K_POINTS[i].weight;
   }
 
   /******
     okay, now divide all the elements of the
-    overlap population matrix by the total number of k points to get
+    overlap population matrix by the total k point weight to get
     the average value, and copy the elements across the diagonal.
   ******/
   num_electrons = 0.0;
   for(i=0;i<num_orbs;i++){
     for(j=i;j<num_orbs;j++){
-      properties.OP_mat[i*num_orbs+j] = properties.OP_mat[i*num_orbs+j] *
-        num_occup_bands / (tot_num_K*details->num_KPOINTS);
+      properties.OP_mat[i*num_orbs+j] = properties.OP_mat[i*num_orbs+j] /
+        tot_K_weight;
       properties.OP_mat[j*num_orbs+i] = properties.OP_mat[i*num_orbs+j];
       num_electrons += properties.OP_mat[i*num_orbs+j];
     }
@@ -579,6 +590,7 @@ void calc_avg_OP(detail_type *details,cell_type *cell,int num_orbs,K_orb_ptr_typ
     fprintf(output_file,
             "\n; Average Mulliken Overlap Population Matrix W/in the Unit Cell.\n");
     printmat(properties.OP_mat,num_orbs,num_orbs,output_file,1e-05,0,details->line_width);
+    results_write_mat("avg_OP_matrix",num_orbs,num_orbs,properties.OP_mat);
   }
 
   if( details->avg_ROP_mat_PRT ){
@@ -586,6 +598,7 @@ void calc_avg_OP(detail_type *details,cell_type *cell,int num_orbs,K_orb_ptr_typ
           "\n; Average Reduced Mulliken Overlap Population Matrix W/in the Unit Cell.\n");
   print_sym_mat(properties.ROP_mat,cell->num_atoms,cell->num_atoms,output_file,
                 (char *)0,(char *)0,details->line_width);
+  results_write_sym_mat("avg_ROP_matrix",cell->num_atoms,properties.ROP_mat);
   }
   fprintf(output_file,"\n");
 
@@ -606,7 +619,11 @@ void calc_avg_OP(detail_type *details,cell_type *cell,int num_orbs,K_orb_ptr_typ
  * Returns: none
  *
  * Action: this loops through the 'orbital_ordering array and populates
- *   the first 'electrons_per_cell * 'details->num_KPOINTS / 2.0 orbitals.
+ *   the lowest orbitals until 'electrons_per_cell electrons per unit of
+ *   k point weight have been placed.
+ *
+ *  A crystal orbital at a k point with weight w holds 2w electrons, so
+ *   that k sets reduced by symmetry fill the same way as the full set.
  *
  *  The Fermi Energy is stored in the the variable 'Fermi_E.
  *
@@ -621,11 +638,14 @@ void find_crystal_occupations(detail_type *details,real electrons_per_cell,int n
 
   real electrons_left;
   real num_here;
-  real accum;
+  real accum,degen_weight;
   k_point_type *temp_kpoint;
 
   tot_orbs = num_orbs * details->num_KPOINTS;
-  electrons_left = electrons_per_cell * (real)details->num_KPOINTS;
+  electrons_left = 0.0;
+  for(i=0;i<details->num_KPOINTS;i++){
+    electrons_left += electrons_per_cell * details->K_POINTS[i].weight;
+  }
 
   /* zero out the orbital ordering array */
   for(i=0;i<tot_orbs;i++){
@@ -638,18 +658,18 @@ void find_crystal_occupations(detail_type *details,real electrons_per_cell,int n
   for(i=0;i<tot_orbs && electrons_left > 0.0; i++){
     temp_kpoint = &(details->K_POINTS[orbital_ordering[i].Kpoint]);
 
-    if( electrons_left >= 2.0 ){
+    if( electrons_left >= 2.0*temp_kpoint->weight ){
       num_here = 2.0;
 
       orbital_ordering[i].occup = num_here;
-      accum += num_here;
+      accum += num_here*temp_kpoint->weight;
 
-      electrons_left -= 2.0;
+      electrons_left -= 2.0*temp_kpoint->weight;
     }else if(electrons_left > 0.0 ){
-      num_here = electrons_left;
+      num_here = electrons_left / temp_kpoint->weight;
       orbital_ordering[i].occup = num_here;
       electrons_left = 0.0;
-      accum += num_here;
+      accum += num_here*temp_kpoint->weight;
     }
   }
 
@@ -688,11 +708,13 @@ void find_crystal_occupations(detail_type *details,real electrons_per_cell,int n
         then distributing them equally amongst those levels.
     ******/
     num_degen_electrons = 0;
+    degen_weight = 0;
     for(i=begin_degen;i<end_degen;i++){
       temp_kpoint = &(details->K_POINTS[orbital_ordering[i].Kpoint]);
-      num_degen_electrons += orbital_ordering[i].occup;
+      num_degen_electrons += orbital_ordering[i].occup*temp_kpoint->weight;
+      degen_weight += temp_kpoint->weight;
     }
-    electrons_per_level = num_degen_electrons / (real)num_degen_levels;
+    electrons_per_level = num_degen_electrons / degen_weight;
     for(i=begin_degen;i<end_degen;i++){
       temp_kpoint = &(details->K_POINTS[orbital_ordering[i].Kpoint]);
       orbital_ordering[i].occup = electrons_per_level;
@@ -722,11 +744,164 @@ void find_crystal_occupations(detail_type *details,real electrons_per_cell,int n
 
 
 
+/****************************************************************************
+ *
+ *                   Procedure unfold_chg_mat
+ *
+ * Arguments:     cell: pointer to cell_type
+ *              kpoint: pointer to k_point_type
+ *            eigenset: eigenset_type
+ *             overlap: hermetian_matrix_type
+ *            num_orbs: int
+ *             chg_mat: pointer to float
+ *
+ * Returns: none
+ *
+ * Action: fills 'chg_mat with the charge matrix averaged over the
+ *   star of 'kpoint.
+ *
+ *   The charge matrix element for AO j in an MO is Re(c_j* (S c)_j).
+ *   Under a symmetry operation S c transforms just like c does, so
+ *   both vectors are unfolded into the star and the elements are
+ *   evaluated for each member.
+ *
+ ****************************************************************************/
+static void unfold_chg_mat(cell_type *cell,k_point_type *kpoint,eigenset_type eigenset,
+                           hermetian_matrix_type overlap,int num_orbs,float *chg_mat)
+{
+  int i,j,k,m;
+  int itab,jtab,ktab;
+  int num_in_star;
+  real *cR,*cI,*sR,*sI;
+  real *star_cR,*star_cI,*star_sR,*star_sI;
+  real Sjk_R,Sjk_I,accum;
+  arena_mark_type mark;
+
+  num_in_star = kpoint->num_in_star;
+  mark = arena_mark(&kpoint_arena);
+  cR = (real *)arena_calloc(&kpoint_arena,4*num_orbs,sizeof(real));
+  star_cR = (real *)arena_calloc(&kpoint_arena,4*num_in_star*num_orbs,sizeof(real));
+  cI = cR + num_orbs;
+  sR = cI + num_orbs;
+  sI = sR + num_orbs;
+  star_cI = star_cR + num_in_star*num_orbs;
+  star_sR = star_cI + num_in_star*num_orbs;
+  star_sI = star_sR + num_in_star*num_orbs;
+
+  for(i=0;i<num_orbs;i++){
+    itab = i*num_orbs;
+
+    /* S c, using the same conventions as eval_charge_matrix */
+    for(j=0;j<num_orbs;j++){
+      jtab = j*num_orbs;
+      cR[j] = EIGENVECT_R(eigenset,i,j);
+      cI[j] = EIGENVECT_I(eigenset,i,j);
+      sR[j] = HERMETIAN_R(overlap,j,j) * EIGENVECT_R(eigenset,i,j);
+      sI[j] = HERMETIAN_I(overlap,j,j) * EIGENVECT_I(eigenset,i,j);
+      for(k=j+1;k<num_orbs;k++){
+        ktab = k*num_orbs;
+        Sjk_R = overlap.mat[jtab+k];
+        Sjk_I = overlap.mat[ktab+j];
+        sR[j] += Sjk_R * eigenset.vectR[itab+k] + Sjk_I * eigenset.vectI[itab+k];
+        sI[j] += Sjk_R * eigenset.vectI[itab+k] - Sjk_I * eigenset.vectR[itab+k];
+      }
+      for(k=0;k<j;k++){
+        ktab = k*num_orbs;
+        Sjk_R = overlap.mat[ktab+j];
+        Sjk_I = overlap.mat[jtab+k];
+        sR[j] += Sjk_R * eigenset.vectR[itab+k] - Sjk_I * eigenset.vectI[itab+k];
+        sI[j] += Sjk_R * eigenset.vectI[itab+k] + Sjk_I * eigenset.vectR[itab+k];
+      }
+    }
+
+    unfold_star_orbital(cell,num_orbs,kpoint,cR,cI,star_cR,star_cI,0);
+    unfold_star_orbital(cell,num_orbs,kpoint,sR,sI,star_sR,star_sI,0);
+
+    for(j=0;j<num_orbs;j++){
+      accum = 0.0;
+      for(m=0;m<num_in_star;m++){
+        accum += star_cR[m*num_orbs+j]*star_sR[m*num_orbs+j] +
+          star_cI[m*num_orbs+j]*star_sI[m*num_orbs+j];
+      }
+      chg_mat[itab+j] = (float)(accum / (real)num_in_star);
+    }
+  }
+
+  arena_release(&kpoint_arena,mark);
+}
+
+/****************************************************************************
+ *
+ *                   Function avg_prop_orbital
+ *
+ * Arguments:  details: pointer to detail_type
+ *                cell: pointer to cell_type
+ *            num_orbs: int
+ *           prop_info: pointer to avg_prop_info_type
+ *              kpoint: int
+ *                  MO: int
+ *        vectR, vectI: pointers to pointers to real
+ *
+ * Returns: int
+ *
+ * Action: returns the coefficients of crystal orbital 'MO at 'kpoint
+ *   (stored in 'prop_info) in 'vectR and 'vectI.
+ *
+ *   If the k point stands for a star of points related by symmetry,
+ *   the orbital is unfolded into the whole star and the return value is
+ *   the number of members, the coefficients of member m begin at
+ *   m*num_orbs.  Otherwise the return value is 1.
+ *
+ *   The arrays are static, so they are overwritten by the next call.
+ *
+ ****************************************************************************/
+int avg_prop_orbital(detail_type *details,cell_type *cell,int num_orbs,
+                     avg_prop_info_type *prop_info,int kpoint,int MO,
+                     real **vectR,real **vectI)
+{
+  static real *buffer=0;
+  static int buffer_size=0;
+  k_point_type *kpt;
+  int j,num_members;
+  float *MO_ptr,*MO_ptrI;
+
+  kpt = &(details->K_POINTS[kpoint]);
+  if( star_needs_unfolding(kpt) ) num_members = kpt->num_in_star;
+  else num_members = 1;
+
+  /* the buffer holds the orbital followed by the star */
+  if( buffer_size < 2*(num_members+1)*num_orbs ){
+    buffer_size = 2*(num_members+1)*num_orbs;
+    buffer = (real *)my_realloc((int *)buffer,buffer_size*sizeof(real));
+    if( !buffer ) fatal("Can't allocate memory in avg_prop_orbital.");
+    retag_memory(buffer,MEM_PERSISTENT);
+  }
+
+  MO_ptr = &(prop_info->orbs[MO*num_orbs]);
+  MO_ptrI = &(prop_info->orbsI[MO*num_orbs]);
+  for(j=0;j<num_orbs;j++){
+    buffer[j] = (real)MO_ptr[j];
+    buffer[num_orbs+j] = (real)MO_ptrI[j];
+  }
+
+  if( num_members == 1 ){
+    *vectR = buffer;
+    *vectI = buffer+num_orbs;
+  } else{
+    *vectR = buffer+2*num_orbs;
+    *vectI = *vectR + num_members*num_orbs;
+    unfold_star_orbital(cell,num_orbs,kpt,buffer,buffer+num_orbs,
+                        *vectR,*vectI,1);
+  }
+  return(num_members);
+}
+
 /****************************************************************************
  *
  *                   Procedure store_avg_prop_info
  *
  * Arguments:  details: pointer to detail_type
+ *             cell: pointer to cell_type
  *          which_k: int
  *         eigenset: eigenset_type
  *          overlap: hermetian_matrix_type
@@ -741,8 +916,13 @@ void find_crystal_occupations(detail_type *details,real electrons_per_cell,int n
  *    and stores them either in the avg_prop_info element passed in or
  *    in the file indicated by the element (depending on execution mode)
  *
+ *  If the k point is the representative of a star of symmetry related
+ *    points, the charge matrix which is stored is the average over the
+ *    star, so the AO occupations and projected DOS come out the same
+ *    as they would for the full set of points.
+ *
  ****************************************************************************/
-void store_avg_prop_info(detail_type *details,int which_k,eigenset_type eigenset,hermetian_matrix_type overlap,int num_orbs,
+void store_avg_prop_info(detail_type *details,cell_type *cell,int which_k,eigenset_type eigenset,hermetian_matrix_type overlap,int num_orbs,
                          real *chg_mat,avg_prop_info_type *avg_prop_info)
 {
   int i,j;
@@ -775,8 +955,10 @@ void store_avg_prop_info(detail_type *details,int which_k,eigenset_type eigenset
 
           /* do the FMO stuff if we need to */
           if( details->num_FMO_frags ){
-            temp_ptr->FMO_orbs[itab+j] = (float)EIGENVECT_R(details->FMO_props->eigenset,i,j);
-            temp_ptr->FMO_orbsI[itab+j] = (float)EIGENVECT_I(details->FMO_props->eigenset,i,j);
+            if( temp_ptr->FMO_orbs ){
+              temp_ptr->FMO_orbs[itab+j] = (float)EIGENVECT_R(details->FMO_props->eigenset,i,j);
+              temp_ptr->FMO_orbsI[itab+j] = (float)EIGENVECT_I(details->FMO_props->eigenset,i,j);
+            }
             temp_ptr->FMO_chg_mat[itab+j] = (float)details->FMO_props->chg_mat[itab+j];
           }
         }
@@ -787,6 +969,14 @@ void store_avg_prop_info(detail_type *details,int which_k,eigenset_type eigenset
     }
     temp_ptr->energies[i] = (float)EIGENVAL(eigenset,i);
   }
+
+  if( !details->just_avgE &&
+     (details->num_proj_DOS || details->the_COOPS ||
+      !details->no_total_DOS_PRT || details->num_FMO_frags) &&
+     star_needs_unfolding(&(details->K_POINTS[which_k])) ){
+    unfold_chg_mat(cell,&(details->K_POINTS[which_k]),eigenset,overlap,
+                   num_orbs,temp_ptr->chg_mat);
+  }
 }
 
 
@@ -215,6 +215,9 @@ void construct_band_structure(cell_type *cell,detail_type *details,
 
   fprintf(band_file,"; Begin band data.\n");
 
+  /* each row of the table is: the k point, followed by the energies */
+  results_begin_table("band_structure",-1,3+num_orbs);
+
   /********
 
     here's the loop over the k point set.
@@ -270,6 +273,7 @@ if( print_progress )
     cboris(&(num_orbs),&(num_orbs),hamilK.mat,overlapK.mat,eigenset.vectI,
            eigenset.val,work1,
            work2,&diag_error);
+    timer_add_flops(eigensolver_flops(num_orbs,1));
 
 #else
     for(j=0;j<num_orbs;j++){
@@ -309,6 +313,7 @@ if( print_progress )
       zheev(&jobz,&uplo,(long *)&num_orbs,cmplx_hamil,(long *)&num_orbs,
                                     eigenset.val,cmplx_work,(long *)&num_orbs2,work3,(long *)&diag_error);
     }
+    timer_add_flops(eigensolver_flops(num_orbs,0));
 
     if( print_progress )
       fprintf(stderr,"}");
@@ -328,6 +333,12 @@ if( print_progress )
     for(j=0;j<num_orbs;j++){
       fprintf(band_file,"%10.8lg\n",EIGENVAL(eigenset,j));
     }
+    results_table_value(kpoint->loc.x);
+    results_table_value(kpoint->loc.y);
+    results_table_value(kpoint->loc.z);
+    for(j=0;j<num_orbs;j++){
+      results_table_value(EIGENVAL(eigenset,j));
+    }
 
   } /* end of k point loop */
   if( details->Execution_Mode == FAT && !details->store_R_overlaps ){
@@ -336,6 +347,7 @@ if( print_progress )
 
   // Indicate that we have finished the band data
   fprintf(band_file, "#END_BAND_DATA\n");
+  results_end_table();
 }
 
 
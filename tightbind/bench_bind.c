@@ -0,0 +1,903 @@
+/*******************************************************
+
+Copyright (C) 2026 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*  Benchmark and regression driver for bind
+*
+*   usage: bench_bind -b <bind> [-g <grow_xtal>] [-e <examples dir>]
+*                     [-w <work dir>] [-o <json file>] [-n repeats]
+*                     [-s scale] [-a abs_tol] [-r rel_tol] [case ...]
+*
+*  runs bind on a set of cases: the sample inputs in the examples
+*   directory (molecules and crystals) and synthetic 1D, 2D and 3D
+*   supercells which are grown with grow_xtal.  For each case the
+*   wall time, user and system time and peak resident set size of the
+*   bind process are measured, the per-stage timings are read from the
+*   #TIMERS block of the .status file, and, where the examples
+*   directory has compressed reference results (.out.Z and .band.Z),
+*   the energies in them are compared to those from the run.  A value
+*   passes if |run - reference| <= abs_tol + rel_tol*|reference|; the
+*   defaults are 1e-3 and 1e-5, about what the output files can resolve.
+*
+*  The results are written as JSON.  The exit status is nonzero if a
+*   run failed or any comparison was out of tolerance.
+*
+*  If cases are named on the command line only those are run, the
+*   default is to run all of them.  -s multiplies the number of cells
+*   along each direction of the synthetic supercells.
+*
+*  This is POSIX only (it uses fork/exec and wait4).
+*
+*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define MAX_PATH_LEN 1024
+#define MAX_REFS 4
+#define MAX_STAGES 128
+#define MAX_COMPARES 16
+
+/******
+  grow_xtal inputs for the synthetic supercells.  The lattice is
+  defined by the last 'dim atoms and the coordinates are cartesian.
+******/
+static char chain_template[]=
+"; trans-polyacetylene\n"
+"1\n3 0 0\n10\n5\n"
+"1 C 0.000 0.000 0.000\n"
+"2 C 1.230 0.700 0.000\n"
+"3 H 0.000 -1.090 0.000\n"
+"4 H 1.230 1.790 0.000\n"
+"5 C 2.460 0.000 0.000\n"
+"Geometry\n"
+"average properties\n"
+"k points\n2\n0 0 0 1\n0.25 0 0 1\n";
+
+static char sheet_template[]=
+"; graphene\n"
+"2\n3 3 0\n8\n4\n"
+"1 C 0.000 0.000 0.000\n"
+"2 C 1.230 0.710141 0.000\n"
+"3 C 2.460 0.000 0.000\n"
+"4 C 1.230 2.130422 0.000\n"
+"Geometry\n"
+"average properties\n"
+"k points\n1\n0 0 0 1\n";
+
+static char diamond_template[]=
+"; diamond\n"
+"3\n2 2 2\n8\n5\n"
+"1 C 0.0000 0.0000 0.0000\n"
+"2 C 0.8925 0.8925 0.8925\n"
+"3 C 1.7850 1.7850 0.0000\n"
+"4 C 0.0000 1.7850 1.7850\n"
+"5 C 1.7850 0.0000 1.7850\n"
+"Geometry\n"
+"average properties\n"
+"k points\n1\n0 0 0 1\n";
+
+typedef struct {
+  char *name;
+  char *kind;
+  /* either an input in the examples directory... */
+  char *example;
+  char *refs[MAX_REFS];
+  /* ...or a grow_xtal template and the number of cells */
+  char *grow_template;
+  int cells[3];
+} bench_case_type;
+
+static bench_case_type bench_cases[]={
+  {"XeF4","molecule","XeF4",{"XeF4.out"},0,{0,0,0}},
+  {"Cp2Zr","molecule","Cp2Zr",{"Cp2Zr.out"},0,{0,0,0}},
+  {"FeCO4Eth","molecule","FeCO4Eth",{"FeCO4Eth.out"},0,{0,0,0}},
+  {"ethane.b","molecule","ethane.b",{0},0,{0,0,0}},
+  {"diamond","3D","diamond",{"diamond.out","diamond.band"},0,{0,0,0}},
+  {"diamond.3s","3D","diamond.3s",{"diamond.3s.out","diamond.3s.band"},0,{0,0,0}},
+  {"Te2Br","3D","Te2Br",{"Te2Br.out","Te2Br.band"},0,{0,0,0}},
+  {"CoNb4Si","3D","CoNb4Si",{"CoNb4Si.band"},0,{0,0,0}},
+  {"kmesh","3D","kmesh",{"kmesh.out"},0,{0,0,0}},
+  {"chain","1D",0,{0},chain_template,{16,1,1}},
+  {"sheet","2D",0,{0},sheet_template,{6,6,1}},
+  {"supercell","3D",0,{0},diamond_template,{3,3,3}},
+};
+#define NUM_BENCH_CASES (int)(sizeof(bench_cases)/sizeof(bench_case_type))
+
+/* the quantities compared between runs and references */
+typedef struct {
+  char *name;
+  char *key;    /* text preceding the value, 0 for lines holding only a number */
+  char after;   /* if nonzero, what has to follow the value */
+  char *suffix; /* which files to look in */
+} quantity_type;
+
+static quantity_type quantities[]={
+  {"total_energy","Total_Energy:",0,".out"},
+  {"fermi_energy","#Fermi_Energy:",0,".out"},
+  {"average_energy","#Average Energy:",0,".out"},
+  {"MO_energies","--->",'[',".out"},
+  {"band_energies",0,'\n',".band"},
+};
+#define NUM_QUANTITIES (int)(sizeof(quantities)/sizeof(quantity_type))
+
+typedef struct {
+  char path[120];
+  long calls;
+  double wall,cpu,bytes,mflops;
+} stage_type;
+
+typedef struct {
+  char file[80];
+  char *quantity;
+  int num_ref,num_run,num_bad;
+  double max_diff;
+} compare_type;
+
+typedef struct {
+  int exit_status;
+  double wall,user,sys;
+  long peak_rss_kb;
+  int num_stages;
+  stage_type stages[MAX_STAGES];
+} run_type;
+
+static char *bind_exe=0,*grow_exe=0,*examples_dir=0;
+static char work_dir[MAX_PATH_LEN]="bench";
+static double abs_tol=1e-3,rel_tol=1e-5;
+
+
+/****************************************************************************
+*
+*                   Function make_path
+*
+* Arguments: path: pointer to char
+*             dir: pointer to char
+*            name: pointer to char
+*          suffix: pointer to char
+*
+* Returns: int
+*
+* Action: puts "dir/namesuffix" in 'path, which holds MAX_PATH_LEN chars.
+*   returns nonzero (after complaining) if the result doesn't fit.
+*
+*****************************************************************************/
+static int make_path(char *path,char *dir,char *name,char *suffix)
+{
+  if( snprintf(path,MAX_PATH_LEN,"%s/%s%s",dir,name,suffix) >= MAX_PATH_LEN ){
+    fprintf(stderr,"bench_bind: the path to %s%s in %s is too long\n",name,suffix,dir);
+    return 1;
+  }
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function read_file
+*
+* Arguments: name: pointer to char
+*            size: pointer to long
+*
+* Returns: pointer to char
+*
+* Action: reads the whole of file 'name into a NUL terminated buffer.
+*   returns 0 if it can't be read.
+*
+*****************************************************************************/
+static char *read_file(char *name,long *size)
+{
+  FILE *infile;
+  char *buff;
+  long len,num_read;
+
+  infile = fopen(name,"rb");
+  if( !infile ) return 0;
+  fseek(infile,0,SEEK_END);
+  len = ftell(infile);
+  fseek(infile,0,SEEK_SET);
+  buff = (char *)malloc(len+1);
+  if( !buff ){
+    fclose(infile);
+    return 0;
+  }
+  num_read = fread(buff,1,len,infile);
+  fclose(infile);
+  buff[num_read] = 0;
+  if( size ) *size = num_read;
+  return buff;
+}
+
+
+/****************************************************************************
+*
+*                   Function uncompress_Z
+*
+* Arguments: in: pointer to unsigned char
+*        in_len: long
+*
+* Returns: pointer to char
+*
+* Action: expands data written by compress(1) (LZW, the .Z format) and
+*   returns it in a NUL terminated buffer.  Decoding stops at the first
+*   bad code, so a damaged file gives as much as could be recovered.
+*   returns 0 if this isn't .Z data.
+*
+*   As in compress, every change of code width (and every clear code)
+*   skips ahead to the end of the current group of 8 codes.
+*
+*****************************************************************************/
+static char *uncompress_Z(unsigned char *in,long in_len)
+{
+  static unsigned short prefix[1<<16];
+  static unsigned char suffix[1<<16],stack[1<<16];
+  unsigned char *out,*new_out;
+  long out_len,out_max;
+  long bit_pos,tot_bits,group_start,group_bits;
+  int max_bits,block_mode,n_bits;
+  long max_code,max_max_code,free_ent;
+  long code,old_code,in_code;
+  int fin_char,sp;
+  int i;
+
+  if( in_len < 3 || in[0] != 0x1f || in[1] != 0x9d ) return 0;
+  max_bits = in[2] & 0x1f;
+  block_mode = in[2] & 0x80;
+  if( max_bits < 9 || max_bits > 16 ) return 0;
+  max_max_code = 1L << max_bits;
+
+  out_max = 4*in_len + 1024;
+  out = (unsigned char *)malloc(out_max);
+  if( !out ) return 0;
+  out_len = 0;
+
+  for(i=0;i<256;i++){
+    prefix[i] = 0;
+    suffix[i] = (unsigned char)i;
+  }
+  n_bits = 9;
+  max_code = (1L << n_bits) - 1;
+  free_ent = block_mode ? 257 : 256;
+  old_code = -1;
+  fin_char = 0;
+  bit_pos = 3*8;
+  group_start = bit_pos;
+  tot_bits = in_len*8;
+
+  while(1){
+    if( free_ent > max_code ){
+      group_bits = n_bits*8;
+      bit_pos = group_start +
+        ((bit_pos - group_start + group_bits - 1)/group_bits)*group_bits;
+      group_start = bit_pos;
+      n_bits++;
+      max_code = n_bits == max_bits ? max_max_code : (1L << n_bits) - 1;
+    }
+    if( bit_pos + n_bits > tot_bits ) break;
+
+    /* codes are stored low bit first */
+    code = 0;
+    for(i=0;i<n_bits;i++){
+      if( in[(bit_pos+i) >> 3] & (1 << ((bit_pos+i) & 7)) ) code |= 1L << i;
+    }
+    bit_pos += n_bits;
+
+    if( old_code == -1 ){
+      if( code >= 256 ) break;
+      old_code = code;
+      fin_char = (int)code;
+      out[out_len++] = (unsigned char)code;
+      continue;
+    }
+    if( code == 256 && block_mode ){
+      for(i=0;i<256;i++) prefix[i] = 0;
+      free_ent = 256;
+      group_bits = n_bits*8;
+      bit_pos = group_start +
+        ((bit_pos - group_start + group_bits - 1)/group_bits)*group_bits;
+      group_start = bit_pos;
+      n_bits = 9;
+      max_code = (1L << n_bits) - 1;
+      continue;
+    }
+
+    in_code = code;
+    sp = 0;
+    if( code >= free_ent ){
+      /* the KwKwK case */
+      if( code > free_ent ) break;
+      stack[sp++] = (unsigned char)fin_char;
+      code = old_code;
+    }
+    while( code >= 256 ){
+      stack[sp++] = suffix[code];
+      code = prefix[code];
+    }
+    fin_char = suffix[code];
+    stack[sp++] = (unsigned char)fin_char;
+
+    if( out_len + sp + 1 > out_max ){
+      out_max = 2*out_max + sp;
+      new_out = (unsigned char *)realloc(out,out_max);
+      if( !new_out ){
+        free(out);
+        return 0;
+      }
+      out = new_out;
+    }
+    while( sp > 0 ) out[out_len++] = stack[--sp];
+
+    if( free_ent < max_max_code ){
+      prefix[free_ent] = (unsigned short)old_code;
+      suffix[free_ent] = (unsigned char)fin_char;
+      free_ent++;
+    }
+    old_code = in_code;
+  }
+  out[out_len] = 0;
+  return (char *)out;
+}
+
+
+/****************************************************************************
+*
+*                   Function extract_values
+*
+* Arguments: text: pointer to char
+*        quantity: pointer to quantity_type
+*            vals: pointer to pointer to double
+*
+* Returns: int
+*
+* Action: pulls the values of 'quantity out of 'text, in the order they
+*   appear, into a newly allocated array and returns how many there were.
+*   For quantities without a key, the values are the lines which contain
+*   nothing but a number.  If the quantity has an 'after character, only
+*   values followed by it (and maybe some white space) are used.
+*
+*****************************************************************************/
+static int extract_values(char *text,quantity_type *quantity,double **vals)
+{
+  char *line,*next,*start,*end;
+  int num,max_num;
+  double val;
+
+  num = 0;
+  max_num = 256;
+  *vals = (double *)malloc(max_num*sizeof(double));
+  if( !*vals ) return 0;
+
+  for(line=text;line && *line;line=next){
+    next = strchr(line,'\n');
+    if( next ) next++;
+
+    if( quantity->key ){
+      start = strstr(line,quantity->key);
+      if( !start || (next && start >= next) ) continue;
+      start += strlen(quantity->key);
+    } else{
+      start = line;
+    }
+    val = strtod(start,&end);
+    if( end == start ) continue;
+    if( quantity->after ){
+      while( *end == ' ' || *end == '\t' || *end == '\r' ) end++;
+      if( *end != quantity->after && (quantity->after != '\n' || *end != 0) ) continue;
+    }
+    if( num == max_num ){
+      max_num *= 2;
+      *vals = (double *)realloc(*vals,max_num*sizeof(double));
+      if( !*vals ) return 0;
+    }
+    (*vals)[num++] = val;
+  }
+  return num;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure compare_results
+*
+* Arguments: case_dir: pointer to char
+*          the_case: pointer to bench_case_type
+*          compares: array of compare_type
+*      num_compares: pointer to int
+*
+* Returns: none
+*
+* Action: compares the quantities in the reference files for 'the_case with
+*   those in the files produced by the run.  The references come from
+*   older versions of the program and don't always cover all of a run, so
+*   only the values present in both are compared.
+*
+*****************************************************************************/
+static void compare_results(char *case_dir,bench_case_type *the_case,
+                            compare_type *compares,int *num_compares)
+{
+  char file_name[MAX_PATH_LEN];
+  char *raw,*ref_text,*run_text;
+  double *ref_vals,*run_vals;
+  long raw_len;
+  compare_type *compare;
+  int i,j,k,num;
+  double diff;
+
+  *num_compares = 0;
+  for(i=0;i<MAX_REFS && the_case->refs[i];i++){
+    if( make_path(file_name,examples_dir,the_case->refs[i],".Z") ) continue;
+    raw = read_file(file_name,&raw_len);
+    if( !raw ){
+      fprintf(stderr,"bench_bind: can't read reference file %s\n",file_name);
+      continue;
+    }
+    ref_text = uncompress_Z((unsigned char *)raw,raw_len);
+    free(raw);
+    if( !ref_text ){
+      fprintf(stderr,"bench_bind: %s isn't a compressed file\n",file_name);
+      continue;
+    }
+    if( make_path(file_name,case_dir,the_case->refs[i],"") ){
+      free(ref_text);
+      continue;
+    }
+    run_text = read_file(file_name,0);
+    if( !run_text ) run_text = strdup("");
+
+    for(j=0;j<NUM_QUANTITIES;j++){
+      if( !strstr(the_case->refs[i],quantities[j].suffix) ) continue;
+      if( *num_compares == MAX_COMPARES ) break;
+      compare = &(compares[*num_compares]);
+      compare->num_ref = extract_values(ref_text,&(quantities[j]),&ref_vals);
+      compare->num_run = extract_values(run_text,&(quantities[j]),&run_vals);
+      if( compare->num_ref ){
+        strncpy(compare->file,the_case->refs[i],sizeof(compare->file)-1);
+        compare->file[sizeof(compare->file)-1] = 0;
+        compare->quantity = quantities[j].name;
+        compare->num_bad = 0;
+        compare->max_diff = 0.0;
+        num = compare->num_ref < compare->num_run ? compare->num_ref : compare->num_run;
+        for(k=0;k<num;k++){
+          diff = fabs(ref_vals[k]-run_vals[k]);
+          if( diff > compare->max_diff ) compare->max_diff = diff;
+          if( diff > abs_tol + rel_tol*fabs(ref_vals[k]) ) compare->num_bad++;
+        }
+        /* a run which lost a quantity entirely is a failure */
+        if( !compare->num_run ) compare->num_bad = compare->num_ref;
+        (*num_compares)++;
+      }
+      free(ref_vals);
+      free(run_vals);
+    }
+    free(ref_text);
+    free(run_text);
+  }
+}
+
+
+/****************************************************************************
+*
+*                   Procedure read_stages
+*
+* Arguments: status_name: pointer to char
+*                    run: pointer to run_type
+*
+* Returns: none
+*
+* Action: reads the #TIMERS block out of the status file.
+*
+*****************************************************************************/
+static void read_stages(char *status_name,run_type *run)
+{
+  FILE *infile;
+  char instring[400];
+  char in_block;
+  stage_type *stage;
+
+  run->num_stages = 0;
+  infile = fopen(status_name,"r");
+  if( !infile ) return;
+  in_block = 0;
+  while( fgets(instring,sizeof(instring),infile) ){
+    if( !strncmp(instring,"#TIMERS",7) ) in_block = 1;
+    else if( !strncmp(instring,"#END_TIMERS",11) ) in_block = 0;
+    else if( in_block && instring[0] != ';' && run->num_stages < MAX_STAGES ){
+      stage = &(run->stages[run->num_stages]);
+      if( sscanf(instring,"%119s %ld %lf %lf %lf %lf",stage->path,&stage->calls,
+                 &stage->wall,&stage->cpu,&stage->bytes,&stage->mflops) == 6 ){
+        run->num_stages++;
+      }
+    }
+  }
+  fclose(infile);
+}
+
+
+/****************************************************************************
+*
+*                   Function run_program
+*
+* Arguments: dir: pointer to char
+*           argv: pointer to pointer to char
+*            run: pointer to run_type (can be 0)
+*
+* Returns: int
+*
+* Action: runs the program argv[0] in directory 'dir, with its standard
+*   output and error going to files there, and waits for it to finish.
+*   The timings and peak memory use are put into 'run.
+*   returns nonzero if the program couldn't be run or failed.
+*
+*****************************************************************************/
+static int run_program(char *dir,char **argv,run_type *run)
+{
+  struct timeval start,finish;
+  struct rusage usage;
+  char file_name[MAX_PATH_LEN];
+  pid_t pid;
+  int status,fd;
+
+  gettimeofday(&start,0);
+  pid = fork();
+  if( pid < 0 ){
+    perror("bench_bind: fork");
+    return 1;
+  }
+  if( !pid ){
+    if( chdir(dir) ) _exit(127);
+    snprintf(file_name,MAX_PATH_LEN,"%s.stdout",strrchr(argv[0],'/') ? strrchr(argv[0],'/')+1 : argv[0]);
+    fd = open(file_name,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if( fd >= 0 ){
+      dup2(fd,1);
+      close(fd);
+    }
+    snprintf(file_name,MAX_PATH_LEN,"%s.stderr",strrchr(argv[0],'/') ? strrchr(argv[0],'/')+1 : argv[0]);
+    fd = open(file_name,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if( fd >= 0 ){
+      dup2(fd,2);
+      close(fd);
+    }
+    fd = open("/dev/null",O_RDONLY);
+    if( fd >= 0 ){
+      dup2(fd,0);
+      close(fd);
+    }
+    execv(argv[0],argv);
+    _exit(127);
+  }
+  if( wait4(pid,&status,0,&usage) < 0 ){
+    perror("bench_bind: wait4");
+    return 1;
+  }
+  gettimeofday(&finish,0);
+
+  if( run ){
+    run->exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128+WTERMSIG(status);
+    run->wall = (finish.tv_sec - start.tv_sec) + 1e-6*(finish.tv_usec - start.tv_usec);
+    run->user = usage.ru_utime.tv_sec + 1e-6*usage.ru_utime.tv_usec;
+    run->sys = usage.ru_stime.tv_sec + 1e-6*usage.ru_stime.tv_usec;
+#ifdef __APPLE__
+    run->peak_rss_kb = usage.ru_maxrss/1024;
+#else
+    run->peak_rss_kb = usage.ru_maxrss;
+#endif
+  }
+  return !WIFEXITED(status) || WEXITSTATUS(status);
+}
+
+
+/****************************************************************************
+*
+*                   Function setup_case
+*
+* Arguments: the_case: pointer to bench_case_type
+*          case_dir: pointer to char
+*             scale: int
+*
+* Returns: int
+*
+* Action: puts the input file for 'the_case into 'case_dir, either by
+*   copying it from the examples directory or by running grow_xtal.
+*   returns nonzero on failure.
+*
+*****************************************************************************/
+static int setup_case(bench_case_type *the_case,char *case_dir,int scale)
+{
+  char file_name[MAX_PATH_LEN],cells[3][20];
+  char *argv[7];
+  char *text;
+  long len;
+  FILE *outfile;
+  int i;
+
+  mkdir(work_dir,0755);
+  if( mkdir(case_dir,0755) && errno != EEXIST ){
+    fprintf(stderr,"bench_bind: can't make directory %s\n",case_dir);
+    return 1;
+  }
+
+  if( the_case->example ){
+    if( make_path(file_name,examples_dir,the_case->example,"") ) return 1;
+    text = read_file(file_name,&len);
+    if( !text ){
+      fprintf(stderr,"bench_bind: can't read %s\n",file_name);
+      return 1;
+    }
+  } else{
+    if( !grow_exe ){
+      fprintf(stderr,"bench_bind: no grow_xtal given for case %s\n",the_case->name);
+      return 1;
+    }
+    text = the_case->grow_template;
+    len = strlen(text);
+  }
+
+  if( make_path(file_name,case_dir,the_case->name,the_case->example ? "" : ".grow") ){
+    if( the_case->example ) free(text);
+    return 1;
+  }
+  outfile = fopen(file_name,"w");
+  if( !outfile || fwrite(text,1,len,outfile) != (size_t)len ){
+    fprintf(stderr,"bench_bind: can't write %s\n",file_name);
+    if( outfile ) fclose(outfile);
+    return 1;
+  }
+  fclose(outfile);
+  if( the_case->example ){
+    free(text);
+    return 0;
+  }
+
+  snprintf(file_name,MAX_PATH_LEN,"%s.grow",the_case->name);
+  argv[0] = grow_exe;
+  argv[1] = file_name;
+  argv[2] = the_case->name;
+  for(i=0;i<3;i++){
+    sprintf(cells[i],"%d",the_case->cells[i]*scale);
+    argv[3+i] = cells[i];
+  }
+  argv[6] = 0;
+  if( run_program(case_dir,argv,0) ){
+    fprintf(stderr,"bench_bind: grow_xtal failed for case %s\n",the_case->name);
+    return 1;
+  }
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure write_json_string
+*
+* Arguments: outfile: pointer to FILE
+*               str: pointer to char
+*
+* Returns: none
+*
+* Action: writes 'str as a JSON string.
+*
+*****************************************************************************/
+static void write_json_string(FILE *outfile,char *str)
+{
+  fputc('"',outfile);
+  for(;*str;str++){
+    if( *str == '"' || *str == '\\' ) fprintf(outfile,"\\%c",*str);
+    else if( (unsigned char)*str < 0x20 ) fprintf(outfile,"\\u%04x",*str);
+    else fputc(*str,outfile);
+  }
+  fputc('"',outfile);
+}
+
+
+static void usage()
+{
+  int i;
+
+  fprintf(stderr,"usage: bench_bind -b <bind> [-g <grow_xtal>] [-e <examples dir>]\n");
+  fprintf(stderr,"                  [-w <work dir>] [-o <json file>] [-n repeats]\n");
+  fprintf(stderr,"                  [-s scale] [-a abs_tol] [-r rel_tol] [case ...]\n");
+  fprintf(stderr,"cases:");
+  for(i=0;i<NUM_BENCH_CASES;i++) fprintf(stderr," %s",bench_cases[i].name);
+  fprintf(stderr,"\n");
+  exit(2);
+}
+
+
+int main(int argc,char **argv)
+{
+  char case_dir[MAX_PATH_LEN],file_name[MAX_PATH_LEN];
+  char bind_path[PATH_MAX],grow_path[PATH_MAX];
+  char *json_name=0;
+  char *bind_argv[3];
+  FILE *outfile;
+  bench_case_type *the_case;
+  run_type run,best;
+  compare_type compares[MAX_COMPARES];
+  int num_compares;
+  int repeats=1,scale=1;
+  int first_case,num_run,num_failed;
+  char selected,case_ok,failed;
+  int i,j,k,opt;
+
+  while( (opt = getopt(argc,argv,"b:g:e:w:o:n:s:a:r:h")) != -1 ){
+    switch(opt){
+    case 'b': bind_exe = optarg; break;
+    case 'g': grow_exe = optarg; break;
+    case 'e': examples_dir = optarg; break;
+    case 'w':
+      strncpy(work_dir,optarg,MAX_PATH_LEN-1);
+      break;
+    case 'o': json_name = optarg; break;
+    case 'n': repeats = atoi(optarg); break;
+    case 's': scale = atoi(optarg); break;
+    case 'a': abs_tol = atof(optarg); break;
+    case 'r': rel_tol = atof(optarg); break;
+    default: usage();
+    }
+  }
+  if( !bind_exe || repeats < 1 || scale < 1 ) usage();
+  if( !examples_dir ) examples_dir = "../examples";
+
+  /* the programs are run from inside the work directory */
+  if( !realpath(bind_exe,bind_path) ){
+    fprintf(stderr,"bench_bind: can't find %s\n",bind_exe);
+    exit(2);
+  }
+  bind_exe = bind_path;
+  if( grow_exe ){
+    if( !realpath(grow_exe,grow_path) ){
+      fprintf(stderr,"bench_bind: can't find %s\n",grow_exe);
+      exit(2);
+    }
+    grow_exe = grow_path;
+  }
+
+  /* make sure any case named on the command line exists */
+  for(k=optind;k<argc;k++){
+    for(i=0;i<NUM_BENCH_CASES;i++) if( !strcmp(argv[k],bench_cases[i].name) ) break;
+    if( i == NUM_BENCH_CASES ){
+      fprintf(stderr,"bench_bind: unknown case %s\n",argv[k]);
+      usage();
+    }
+  }
+
+  if( json_name ){
+    outfile = fopen(json_name,"w");
+    if( !outfile ){
+      fprintf(stderr,"bench_bind: can't open %s\n",json_name);
+      exit(2);
+    }
+  } else{
+    outfile = stdout;
+  }
+
+  fprintf(outfile,"{\n  \"bind\": ");
+  write_json_string(outfile,bind_exe);
+  fprintf(outfile,",\n  \"repeats\": %d,\n  \"scale\": %d,\n",repeats,scale);
+  fprintf(outfile,"  \"abs_tol\": %g,\n  \"rel_tol\": %g,\n  \"cases\": [",abs_tol,rel_tol);
+
+  first_case = 1;
+  num_run = 0;
+  num_failed = 0;
+  for(i=0;i<NUM_BENCH_CASES;i++){
+    the_case = &(bench_cases[i]);
+    selected = optind == argc;
+    for(k=optind;k<argc;k++) if( !strcmp(argv[k],the_case->name) ) selected = 1;
+    if( !selected ) continue;
+
+    fprintf(stderr,"%-12s ",the_case->name);
+    fflush(stderr);
+    failed = make_path(case_dir,work_dir,the_case->name,"");
+    if( !failed ) failed = setup_case(the_case,case_dir,scale);
+
+    /* keep the fastest of the repeats */
+    memset((char *)&best,0,sizeof(run_type));
+    best.exit_status = -1;
+    bind_argv[0] = bind_exe;
+    bind_argv[1] = the_case->name;
+    bind_argv[2] = 0;
+    for(j=0;j<repeats && !failed;j++){
+      failed = run_program(case_dir,bind_argv,&run);
+      if( !j || run.wall < best.wall ){
+        if( !make_path(file_name,case_dir,the_case->name,".status") ){
+          read_stages(file_name,&run);
+        } else{
+          run.num_stages = 0;
+        }
+        best = run;
+      }
+    }
+
+    num_compares = 0;
+    if( !failed ) compare_results(case_dir,the_case,compares,&num_compares);
+    case_ok = !failed;
+    for(k=0;k<num_compares;k++) if( compares[k].num_bad ) case_ok = 0;
+    num_run++;
+    if( !case_ok ) num_failed++;
+
+    fprintf(stderr,"%s %9.3f s %8ld KB\n",case_ok ? "ok    " : "FAILED",best.wall,
+            best.peak_rss_kb);
+
+    fprintf(outfile,"%s\n    {\n      \"name\": ",first_case ? "" : ",");
+    first_case = 0;
+    write_json_string(outfile,the_case->name);
+    fprintf(outfile,",\n      \"kind\": ");
+    write_json_string(outfile,the_case->kind);
+    if( !the_case->example ){
+      fprintf(outfile,",\n      \"cells\": [%d, %d, %d]",the_case->cells[0]*scale,
+              the_case->cells[1]*scale,the_case->cells[2]*scale);
+    }
+    fprintf(outfile,",\n      \"exit_status\": %d,\n",best.exit_status);
+    fprintf(outfile,"      \"wall_seconds\": %.6f,\n      \"user_seconds\": %.6f,\n",
+            best.wall,best.user);
+    fprintf(outfile,"      \"system_seconds\": %.6f,\n      \"peak_rss_kb\": %ld,\n",
+            best.sys,best.peak_rss_kb);
+    fprintf(outfile,"      \"stages\": [");
+    for(k=0;k<best.num_stages;k++){
+      fprintf(outfile,"%s\n        {\"name\": ",k ? "," : "");
+      write_json_string(outfile,best.stages[k].path);
+      fprintf(outfile,", \"calls\": %ld, \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, ",
+              best.stages[k].calls,best.stages[k].wall,best.stages[k].cpu);
+      fprintf(outfile,"\"bytes\": %.0f, \"mflops\": %.3f}",best.stages[k].bytes,
+              best.stages[k].mflops);
+    }
+    fprintf(outfile,"%s],\n      \"comparisons\": [",best.num_stages ? "\n      " : "");
+    for(k=0;k<num_compares;k++){
+      fprintf(outfile,"%s\n        {\"file\": ",k ? "," : "");
+      write_json_string(outfile,compares[k].file);
+      fprintf(outfile,", \"quantity\": ");
+      write_json_string(outfile,compares[k].quantity);
+      fprintf(outfile,", \"num_reference\": %d, \"num_run\": %d, ",
+              compares[k].num_ref,compares[k].num_run);
+      fprintf(outfile,"\"num_out_of_tolerance\": %d, \"max_abs_diff\": %g}",
+              compares[k].num_bad,compares[k].max_diff);
+    }
+    fprintf(outfile,"%s],\n      \"pass\": %s\n    }",num_compares ? "\n      " : "",
+            case_ok ? "true" : "false");
+  }
+  fprintf(outfile,"\n  ],\n  \"num_cases\": %d,\n  \"num_failed\": %d\n}\n",
+          num_run,num_failed);
+  if( outfile != stdout ) fclose(outfile);
+
+  return num_failed ? 1 : 0;
+}
@@ -0,0 +1,296 @@
+/*******************************************************
+
+Copyright (C) 2026 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*  Micro-benchmark for the text matrix printers in genutil.c
+*
+*   usage: bench_print [num_orbs] [repeats]
+*
+*  checks sprint_fixed against sprintf, then times printmat and
+*   print_labelled_mat against straightforward fprintf versions of the
+*   same loops (which is how they used to be written) and checks that
+*   the two produce the same bytes.
+*
+*****************************************************************************/
+#include "bind.h"
+
+#include <time.h>
+
+/* same layout as printmat, one fprintf per element */
+static void reference_printmat(real *mat,int num_row,int num_col,FILE *outfile,
+                               real tol,int width)
+{
+  int i,j;
+  int beg_col,end_col;
+  int which_part,num_parts;
+  int cols_per_line;
+  real val;
+
+  cols_per_line = (int)floor((real)width/10) - 1;
+  beg_col = 0;
+  if( num_col < cols_per_line ){
+    end_col = num_col;
+    num_parts = 1;
+  }
+  else{
+    end_col = cols_per_line;
+    num_parts = ceil((real)num_col/(real)cols_per_line);
+  }
+  for(which_part=0;which_part<num_parts;which_part++){
+    for( i=-1; i<num_row; i++ ){
+      if( i >= 0 ) fprintf(outfile,"%4d",i+1);
+      else fprintf(outfile,"    ");
+      for( j=beg_col; j<end_col && j< num_col; j++ ){
+        if( i == -1) fprintf(outfile,"  %-7d",j+1);
+        else{
+          val = mat[i*num_col+j];
+          if( fabs(val) <= tol ) val = 0.0;
+          fprintf(outfile,"  %-6.4lf",val);
+        }
+      }
+      fprintf(outfile,"\n");
+    }
+    beg_col=end_col;
+    end_col+=cols_per_line;
+  }
+  fprintf(outfile,"\n");
+  fprintf(outfile,"\n");
+}
+
+/* same layout as print_labelled_mat with LABEL_BOTH */
+static void reference_labelled_mat(real *mat,int num_row,int num_col,FILE *outfile,
+                                   real tol,atom_type *atoms,int num_atoms,
+                                   int *orbital_lookup_table,int num_orbs,int width)
+{
+  char name_string[80],just_string[80];
+  int i,j;
+  int beg_col,end_col;
+  int which_part,num_parts;
+  int cols_per_line;
+  real val;
+
+  cols_per_line = (int)floor((real)width/18) - 1;
+  beg_col = 0;
+  if( num_col < cols_per_line ){
+    end_col = num_col;
+    num_parts = 1;
+  }
+  else{
+    end_col = cols_per_line;
+    num_parts = ceil((real)num_col/(real)cols_per_line);
+  }
+  for(which_part=0;which_part<num_parts;which_part++){
+    for( i=-1; i<num_row; i++ ){
+      if( i >= 0 ){
+        map_orb_num_to_name(name_string,i,orbital_lookup_table,
+                            num_orbs,atoms,num_atoms);
+        left_just_text_string(name_string,just_string,18);
+        fprintf(outfile,"%s",just_string);
+      }
+      else fprintf(outfile,"               ");
+      for( j=beg_col; j<end_col && j< num_col; j++ ){
+        if( i == -1){
+          map_orb_num_to_name(name_string,j,orbital_lookup_table,
+                              num_orbs,atoms,num_atoms);
+          center_text_string(name_string,just_string,18);
+          fprintf(outfile,"%s",just_string);
+        }
+        else{
+          val = mat[i*num_col+j];
+          if( fabs(val) <= tol ) val = 0.0;
+          fprintf(outfile," %-18.4lf",val);
+        }
+      }
+      fprintf(outfile,"\n");
+    }
+    beg_col=end_col;
+    end_col+=cols_per_line;
+  }
+  fprintf(outfile,"\n");
+  fprintf(outfile,"\n");
+}
+
+/* compares the contents of two files, returns nonzero if they differ */
+static int files_differ(FILE *file1,FILE *file2)
+{
+  int c1,c2;
+
+  rewind(file1);
+  rewind(file2);
+  do{
+    c1 = getc(file1);
+    c2 = getc(file2);
+    if( c1 != c2 ) return 1;
+  }while(c1 != EOF);
+  return 0;
+}
+
+/* checks sprint_fixed against sprintf, returns the number of mismatches */
+static int check_formatter(int num_vals)
+{
+  char fast[80],slow[80];
+  double val;
+  int i,k,num_bad;
+  static int widths[] = {6,10,18};
+
+  num_bad = 0;
+  for(i=0;i<num_vals;i++){
+    switch(i%4){
+    case 0:
+      /* values of all sizes */
+      val = (2.0*rand()/(double)RAND_MAX - 1.0)*pow(10.0,rand()%12-4);
+      break;
+    case 1:
+      /* values right at (or next to) a rounding boundary */
+      val = ((rand()%200001) - 100000 + 0.5)/10000.0;
+      if( i%8 == 1 ) val = nextafter(val,0.0);
+      break;
+    case 2:
+      /* tiny values, some of which round to -0.0000 */
+      val = (2.0*rand()/(double)RAND_MAX - 1.0)*1e-4;
+      break;
+    default:
+      /* multiples of 1/32 include exact ties (e.g. 0.03125) */
+      val = (double)(rand()%1000 - 500) + (rand()%32)/32.0;
+      break;
+    }
+    if( i == 0 ) val = -0.0;
+    for(k=0;k<3;k++){
+      sprint_fixed(fast,val,4,widths[k],1);
+      sprintf(slow,"%-*.4f",widths[k],val);
+      if( strcmp(fast,slow) ){
+        if( num_bad < 10 ) printf("  mismatch: [%s] [%s]\n",fast,slow);
+        num_bad++;
+      }
+      sprint_fixed(fast,val,4,widths[k],0);
+      sprintf(slow,"%*.4f",widths[k],val);
+      if( strcmp(fast,slow) ){
+        if( num_bad < 10 ) printf("  mismatch: [%s] [%s]\n",fast,slow);
+        num_bad++;
+      }
+    }
+  }
+  return num_bad;
+}
+
+int main(int argc, char **argv){
+  int num_orbs,num_atoms,repeats;
+  int i,j;
+  real *mat;
+  atom_type *atoms;
+  int *orbital_lookup_table;
+  FILE *fast_file,*slow_file;
+  clock_t start;
+  double fast_time,slow_time;
+  int num_bad;
+
+  num_orbs = 360;
+  repeats = 5;
+  if( argc > 1 ) num_orbs = atoi(argv[1]);
+  if( argc > 2 ) repeats = atoi(argv[2]);
+  if( num_orbs < 9 ) num_orbs = 9;
+  if( repeats < 1 ) repeats = 1;
+
+  status_file = stderr;
+  output_file = stdout;
+
+  /* a bunch of carbon-like atoms with s, p and d orbitals */
+  num_atoms = num_orbs / 9;
+  num_orbs = num_atoms*9;
+  atoms = (atom_type *)calloc(num_atoms,sizeof(atom_type));
+  orbital_lookup_table = (int *)calloc(num_atoms,sizeof(int));
+  mat = (real *)calloc(num_orbs*num_orbs,sizeof(real));
+  if( !atoms || !orbital_lookup_table || !mat ) fatal("Can't allocate memory.");
+  for(i=0;i<num_atoms;i++){
+    strcpy(atoms[i].symb,"C");
+    atoms[i].which_atom = i;
+    atoms[i].ns = 2;
+    atoms[i].np = 2;
+    atoms[i].nd = 3;
+    orbital_lookup_table[i] = i*9;
+  }
+  srand(23);
+  for(i=0;i<num_orbs*num_orbs;i++){
+    mat[i] = 2.0*rand()/(real)RAND_MAX - 1.0;
+  }
+
+  num_bad = check_formatter(200000);
+  printf("sprint_fixed vs sprintf: %d mismatches\n",num_bad);
+
+  fast_file = tmpfile();
+  slow_file = tmpfile();
+  if( !fast_file || !slow_file ) fatal("Can't open temporary files.");
+
+  /* printmat */
+  start = clock();
+  for(j=0;j<repeats;j++) reference_printmat(mat,num_orbs,num_orbs,slow_file,1e-4,80);
+  slow_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+  start = clock();
+  for(j=0;j<repeats;j++) printmat(mat,num_orbs,num_orbs,fast_file,1e-4,0,80);
+  fast_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+  printf("printmat (%d x %d, %d times): fprintf: %.3f s  buffered: %.3f s  %s\n",
+         num_orbs,num_orbs,repeats,slow_time,fast_time,
+         files_differ(fast_file,slow_file) ? "OUTPUT DIFFERS" : "identical");
+  if( files_differ(fast_file,slow_file) ) num_bad++;
+
+  fclose(fast_file);
+  fclose(slow_file);
+  fast_file = tmpfile();
+  slow_file = tmpfile();
+  if( !fast_file || !slow_file ) fatal("Can't open temporary files.");
+
+  /* print_labelled_mat */
+  start = clock();
+  for(j=0;j<repeats;j++){
+    reference_labelled_mat(mat,num_orbs,num_orbs,slow_file,1e-4,atoms,num_atoms,
+                           orbital_lookup_table,num_orbs,80);
+  }
+  slow_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+  start = clock();
+  for(j=0;j<repeats;j++){
+    print_labelled_mat(mat,num_orbs,num_orbs,fast_file,1e-4,atoms,num_atoms,
+                       orbital_lookup_table,num_orbs,0,LABEL_BOTH,80);
+  }
+  fast_time = (double)(clock()-start)/CLOCKS_PER_SEC;
+  printf("print_labelled_mat (%d x %d, %d times): fprintf: %.3f s  buffered: %.3f s  %s\n",
+         num_orbs,num_orbs,repeats,slow_time,fast_time,
+         files_differ(fast_file,slow_file) ? "OUTPUT DIFFERS" : "identical");
+  if( files_differ(fast_file,slow_file) ) num_bad++;
+
+  fclose(fast_file);
+  fclose(slow_file);
+  free(mat);
+  free(atoms);
+  free(orbital_lookup_table);
+  return num_bad ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+/*******************************************************
+
+Copyright (C) 2026 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*  Micro-benchmark for the radial overlap kernel in sto_overlap.c
+*
+*   usage: bench_sto [num_inputs] [repeats]
+*
+*  for a range of (n,l) combinations, evaluates the radial overlaps (and
+*   their distance derivatives) for 'num_inputs random distances and
+*   exponent pairs three ways: with the old abfns/lovlap routines (the
+*   way mov used to call them), with sto_radial_overlaps one input at a
+*   time (the way mov calls it for single zeta functions), and with
+*   sto_radial_overlaps on all the inputs at once.  Reports the times
+*   and the largest difference from the old routines.
+*
+*****************************************************************************/
+#include "bind.h"
+
+#include <time.h>
+
+/* the (n,l) shells which are tried, against each other */
+static int shells[][2] = {
+  {1,0},{2,0},{2,1},{3,0},{3,1},{3,2},{4,0},{4,1},{4,2},{4,3},
+  {5,0},{5,1},{5,2},{5,3},{6,0},{6,1},{6,2},{7,0},{7,1}
+};
+#define NUM_SHELLS (sizeof(shells)/sizeof(shells[0]))
+
+/* mov's old add_zeta_overlap, without the coefficient */
+static void reference_overlap(real *components,real sk1,real sk2,real dist,
+                              int q_num1,int q_num2,int l1,int l2,
+                              char derivative)
+{
+  real A_fn_values[40], B_fn_values[40];
+  real A_term,B_term;
+  int i,max,max_AB,nn,m=0;
+
+  max = q_num1 + q_num2;
+  if( l1 > l2 ) nn = l2;
+  else nn = l1;
+  components[0]=components[1]=components[2]=components[3]=0.0;
+  if( derivative ) max_AB = max+1;
+  else max_AB = max;
+  abfns(A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max_AB);
+  for(i=0;i<=nn;i++){
+    m=i;
+    lovlap(&(components[i]),A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
+    if( derivative ){
+      lovlap(&A_term,A_fn_values+1,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
+      lovlap(&B_term,A_fn_values,B_fn_values+1,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
+      components[i] = (real)(max+1)*components[i]/dist -
+        0.5*(sk1+sk2)*A_term - 0.5*(sk1-sk2)*B_term;
+    }
+  }
+}
+
+int main(int argc, char **argv){
+  int num_inputs,repeats;
+  int i,j,k,m,s1,s2,rep;
+  real *dist,*sk1,*sk2,*ref,*single,*fast;
+  real diff,max_diff,scale;
+  clock_t start;
+  double ref_time,single_time,fast_time;
+  char derivative;
+  int num_bad;
+
+  num_inputs = 256;
+  repeats = 5;
+  if( argc > 1 ) num_inputs = atoi(argv[1]);
+  if( argc > 2 ) repeats = atoi(argv[2]);
+  if( num_inputs < 1 ) num_inputs = 1;
+  if( repeats < 1 ) repeats = 1;
+
+  status_file = stderr;
+  output_file = stdout;
+
+  dist = (real *)calloc(num_inputs,sizeof(real));
+  sk1 = (real *)calloc(num_inputs,sizeof(real));
+  sk2 = (real *)calloc(num_inputs,sizeof(real));
+  ref = (real *)calloc(4*num_inputs,sizeof(real));
+  single = (real *)calloc(4*num_inputs,sizeof(real));
+  fast = (real *)calloc(4*num_inputs,sizeof(real));
+  if( !dist || !sk1 || !sk2 || !ref || !single || !fast ){
+    fatal("Can't allocate memory.");
+  }
+
+  /*
+    distances between 0.5 and 15 bohr with exponents between 0.8 and 4.
+    Every fourth pair has equal exponents and every fourth one exponents
+    which are very close, to exercise the special cases for B.
+  */
+  srand(23);
+  for(i=0;i<num_inputs;i++){
+    dist[i] = 0.5 + 14.5*rand()/(real)RAND_MAX;
+    sk1[i] = 0.8 + 3.2*rand()/(real)RAND_MAX;
+    switch(i%4){
+    case 0:
+      sk2[i] = sk1[i];
+      break;
+    case 1:
+      sk2[i] = sk1[i] + 1e-3*rand()/(real)RAND_MAX;
+      break;
+    default:
+      sk2[i] = 0.8 + 3.2*rand()/(real)RAND_MAX;
+      break;
+    }
+  }
+
+  num_bad = 0;
+  for(derivative=0;derivative<=1;derivative++){
+    ref_time = single_time = fast_time = 0.0;
+    max_diff = 0.0;
+    for(s1=0;s1<NUM_SHELLS;s1++){
+      for(s2=0;s2<NUM_SHELLS;s2++){
+        start = clock();
+        for(rep=0;rep<repeats;rep++){
+          for(i=0;i<num_inputs;i++){
+            real components[4];
+            reference_overlap(components,sk1[i],sk2[i],dist[i],
+                              shells[s1][0],shells[s2][0],shells[s1][1],
+                              shells[s2][1],derivative);
+            for(m=0;m<4;m++) ref[m*num_inputs+i] = components[m];
+          }
+        }
+        ref_time += (double)(clock()-start)/CLOCKS_PER_SEC;
+
+        start = clock();
+        for(rep=0;rep<repeats;rep++){
+          for(i=0;i<num_inputs;i++){
+            real components[4];
+            sto_radial_overlaps(components,1,dist+i,sk1+i,sk2+i,shells[s1][0],
+                                shells[s2][0],shells[s1][1],shells[s2][1],
+                                derivative);
+            for(m=0;m<4;m++) single[m*num_inputs+i] = components[m];
+          }
+        }
+        single_time += (double)(clock()-start)/CLOCKS_PER_SEC;
+
+        start = clock();
+        for(rep=0;rep<repeats;rep++){
+          sto_radial_overlaps(fast,num_inputs,dist,sk1,sk2,shells[s1][0],
+                              shells[s2][0],shells[s1][1],shells[s2][1],
+                              derivative);
+        }
+        fast_time += (double)(clock()-start)/CLOCKS_PER_SEC;
+
+        /* differences are relative to the size of the overlap (or 1) */
+        for(k=0;k<4*num_inputs;k++){
+          scale = fabs(ref[k]);
+          if( scale < 1.0 ) scale = 1.0;
+          diff = fabs(fast[k]-ref[k])/scale;
+          if( fabs(single[k]-ref[k])/scale > diff ){
+            diff = fabs(single[k]-ref[k])/scale;
+          }
+          if( diff > max_diff ) max_diff = diff;
+          if( diff > 1e-10 ){
+            if( num_bad < 10 ){
+              j = k%num_inputs;
+              printf("  mismatch: n1=%d l1=%d n2=%d l2=%d m=%d r=%g sk1=%g sk2=%g: %.12g %.12g\n",
+                     shells[s1][0],shells[s1][1],shells[s2][0],shells[s2][1],
+                     k/num_inputs,dist[j],sk1[j],sk2[j],ref[k],fast[k]);
+            }
+            num_bad++;
+          }
+        }
+      }
+    }
+    printf("%s (%d shell pairs, %d inputs, %d times): abfns/lovlap: %.3f s  one at a time: %.3f s  batched: %.3f s  max diff: %.2g\n",
+           derivative ? "derivatives" : "overlaps",(int)(NUM_SHELLS*NUM_SHELLS),
+           num_inputs,repeats,ref_time,single_time,fast_time,max_diff);
+  }
+  if( num_bad ) printf("%d values differ by more than 1e-10\n",num_bad);
+
+  free(dist);
+  free(sk1);
+  free(sk2);
+  free(ref);
+  free(single);
+  free(fast);
+  return num_bad ? 1 : 0;
+}
@@ -69,6 +69,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /******  includes for everyone ******/
 #include <fcntl.h>
 #include <math.h>
+#include <setjmp.h>
 #include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -171,6 +172,33 @@ the
 #define THIN 1
 #define MOLECULAR 27
 
+/******
+  what memory from my_malloc and friends is being used for (see memory.c).
+   SCRATCH is the chunks of the arenas (see arena.c).  PERSISTENT
+   blocks are scratch space which is held on purpose for the life of
+   the program and isn't reported as a leak.
+******/
+#define MEM_MISC 0
+#define MEM_R_MATS 1
+#define MEM_K_MATS 2
+#define MEM_AVG_PROPS 3
+#define MEM_FMO 4
+#define MEM_DIAG_WORK 5
+#define MEM_SCRATCH 6
+#define MEM_PERSISTENT 7
+#define NUM_MEM_TAGS 8
+
+/* the kinds of checkpoint (see checkpoint.c) */
+#define CHK_WALSH_STEP 0
+#define CHK_CYCLE 1
+
+/* the output streams which are tracked by checkpoints */
+#define CHK_OUT 0
+#define CHK_WALSH 1
+#define CHK_BAND 2
+#define CHK_FMO 3
+#define NUM_CHK_STREAMS 4
+
 /* used as generic indicators */
 #define NORMAL 0
 #define RESET 44
@@ -260,6 +288,10 @@ the
 #ifdef UNDERSCORE_FORTRAN
 #define zhegv zhegv_
 #define zheev zheev_
+#define zpotrf zpotrf_
+#define zhegst zhegst_
+#define ztrsm ztrsm_
+#define zgemm zgemm_
 #endif
 
 #define ABS(a) ((a) > 0 ? (a) : -(a))
@@ -278,6 +310,24 @@ the
 #define MULLER_E_TOL_DEF 0.01
 #define MULLER_Z_TOL_DEF 0.001
 
+/* geometry optimization methods and their default settings */
+#define OPT_BFGS 0
+#define OPT_FIRE 1
+#define OPT_MAX_STEPS_DEF 100
+#define OPT_FORCE_TOL_DEF 0.01
+#define OPT_ENERGY_TOL_DEF 1e-6
+#define OPT_MAX_DISP_DEF 0.2
+#define OPT_ARMIJO_DEF 1e-4
+#define OPT_BACKTRACK_DEF 0.5
+#define OPT_MAX_LINE_DEF 10
+#define OPT_TIME_STEP_DEF 0.1
+#define OPT_MAX_TIME_STEP_DEF 1.0
+
+/* the batched radial overlap kernel (sto_overlap.c) works on this many
+   inputs at a time, and keeps this many A and B functions for each */
+#define STO_BATCH_SIZE 8
+#define STO_MAX_AB 20
+
 /****************************  type definitions *******************/
 
 typedef char BOOLEAN;
@@ -347,6 +397,27 @@ typedef struct {
 
 } atom_type;
 
+/* the orbitals which were found for an entry in a parameter table */
+#define PARM_S 1
+#define PARM_P 2
+#define PARM_D 4
+#define PARM_D2 8
+#define PARM_F 16
+#define PARM_F2 32
+
+/* the parameters for one atom in a parameter table */
+typedef struct {
+  char symb[3];      /* only the first two characters of the symbol count */
+  char orbs_found;
+  atom_type parms;
+} parm_entry_type;
+
+/* a hash table of atomic parameters, empty slots have no symbol */
+typedef struct {
+  int num_entries, table_size;
+  parm_entry_type *entries;
+} parm_table_type;
+
 /* used to allow geometrical fragments */
 typedef struct geom_frag_def {
   int which;
@@ -379,6 +450,60 @@ struct equiv_atom_def {
   equiv_atom_type *next;
 };
 
+/**********
+
+  the atoms close to each atom of the unit cell (see neighbors.c)
+
+************/
+/******
+  a translation of the unit cell: n[0]*a + n[1]*b + n[2]*c
+*******/
+typedef struct {
+  int n[3];
+  point_type vect;
+} neighbor_image_type;
+
+/******
+  atom j translated by images[t].vect is within 'cutoff of atom i
+  if j is one of partner[first[i*num_images+t]] through
+  partner[first[i*num_images+t+1]-1].  These are sorted, and atom i
+  is never its own partner in the untranslated cell.
+*******/
+typedef struct {
+  real cutoff;
+  int num_atoms;
+  int max_image[3];
+  int num_images;
+  neighbor_image_type *images;
+  int *first;
+  int *partner;
+  int num_pairs;
+
+  /* the positions the list was built for */
+  point_type *locs;
+} neighbor_list_type;
+
+/******
+  scratch memory which is handed out by bumping a pointer (see arena.c).
+  The chunks are kept when the arena is reset, so once it has grown
+  big enough nothing more has to be allocated.
+*******/
+typedef struct arena_chunk_type_def{
+  struct arena_chunk_type_def *next;
+  long size,used;
+  char *mem;
+} arena_chunk_type;
+
+typedef struct {
+  arena_chunk_type *first,*current;
+} arena_type;
+
+/* a position in an arena to go back to with arena_release */
+typedef struct {
+  arena_chunk_type *chunk;
+  long used;
+} arena_mark_type;
+
 /**********
 
   a unit cell
@@ -396,9 +521,13 @@ typedef struct {
   /******
     the distance matrix for the unit cell is stored as a symmetric matrix
       (see notes.outl for the format)
+    this is only built if it's going to be printed.
   *******/
   real *distance_mat;
 
+  /* the atoms near each atom, built as needed */
+  neighbor_list_type *neighbors;
+
   real num_electrons;
   real charge;
 
@@ -427,10 +556,25 @@ typedef struct {
   k points
 
 ************/
+/******
+  one member of the star of a k point generated by automagic_k_points.
+  member 0 is the k point itself, every other member was generated
+  from member 'from by applying 'op (or by time reversal, k -> -k,
+  if 'op is null).
+*******/
+typedef struct {
+  point_type loc;
+  int from;
+  struct sym_op_type_def *op;
+} k_star_type;
+
 typedef struct {
   point_type loc;
   real weight;
   real num_filled_bands; /* this needs to be a real to deal with degeneracies */
+  /* the star (only filled in for automatically generated k points) */
+  int num_in_star;
+  k_star_type *star;
 } k_point_type;
 
 /**********
@@ -656,6 +800,8 @@ typedef struct {
 typedef struct {
   int dim;
   real *mat;
+  /* the S(R)'s beyond the unit cell when they're kept in single precision */
+  float *packed;
 } hermetian_matrix_type;
 
 #define HERMETIAN_R(matrix, i, j)                                              \
@@ -695,6 +841,11 @@ typedef struct {
   avg_prop_info_type *avg_prop_info;
   prop_type *properties;
   int *orbital_lookup_table;
+  /* orb_map[i] is the orbital of the full system which is orbital i of
+     the fragment, orb_offset is where the fragment's orbitals start
+     in the FMO basis */
+  int *orb_map;
+  int orb_offset;
 } FMO_frag_type;
 
 /******
@@ -726,6 +877,26 @@ typedef struct {
   real tolerance;
 } chg_it_parm_type;
 
+/*********
+
+  geometry optimization parameters
+
+**********/
+typedef struct {
+  int method;     /* OPT_BFGS or OPT_FIRE */
+  char cartesian; /* optimize the cartesians even with a Z matrix */
+  int max_steps;
+  real force_tol, energy_tol;
+  real max_disp; /* the longest step any one coordinate may take */
+
+  /* the backtracking line search (BFGS) */
+  real armijo, backtrack;
+  int max_line_steps;
+
+  /* the time steps (FIRE) */
+  real time_step, max_time_step;
+} geom_opt_parm_type;
+
 /********
 
   used to specify orbital occupations
@@ -755,6 +926,7 @@ typedef struct {
 
   /* for dumping binary files containing the matrices */
   BOOLEAN dump_overlap, dump_hamil;
+  BOOLEAN dump_float, dump_compressed;
 
   /* for dumping sparse matrix files */
   BOOLEAN dump_sparse_mats;
@@ -762,6 +934,9 @@ typedef struct {
   /* for dumping the distance matrix (for find_coops) */
   BOOLEAN dump_dist_mat;
 
+  /* for writing the binary results (.bres) file */
+  BOOLEAN binary_results;
+
   /*******
     printing options
   ********/
@@ -802,6 +977,10 @@ typedef struct {
   char do_chg_it;
   chg_it_parm_type chg_it_parms;
 
+  /* geometry optimization */
+  char do_geom_opt;
+  geom_opt_parm_type geom_opt_parms;
+
   /* this is the cutoff for printing of close nearest neighbor contacts */
   real close_nn_contact;
 
@@ -862,6 +1041,18 @@ typedef struct {
 
   real sparsify_value;
 
+  /* the most memory (in Mbytes) the run may use, 0 for no limit */
+  real memory_budget;
+
+  /* keep the S(R)'s of the translated cells in single precision */
+  BOOLEAN mixed_precision;
+
+  /* minutes between checkpoints in the k point loop, 0 for no checkpoints */
+  real checkpoint_interval;
+
+  /* where k point results are cached (see result_cache.c), empty for none */
+  char cache_dir[240];
+
   /*******
     the tolerance for atoms being considered equivalent in the
     symmetry analysis
@@ -929,9 +1120,21 @@ extern int num_unique_atoms;
 extern prop_type properties;
 extern avg_prop_info_type *avg_prop_info;
 extern K_orb_ptr_type *orbital_ordering;
+extern arena_type kpoint_arena, cycle_arena;
 
 extern real electrostatic_term, eHMO_term, total_energy;
 
 extern bool print_progress; // Shall we print progress during calculations?
+extern bool print_text_mats; // Shall matrices be printed into the output file?
+extern bool restart_run; // Shall the run be picked up from its checkpoint?
+extern bool force_binary_results; // Write the binary results whatever the input says?
+extern jmp_buf *fatal_trap; // Where fatal errors go instead of exiting (see eht_run)
+extern char fatal_message[MAX_STR_LEN]; // What the trapped fatal error was
+
+#include "results.h"
+#include "matrix_dump.h"
+
+/* an open .OV or .HAM file, see matrix_dump.c */
+typedef struct matrix_dump_def matrix_dump_type;
 
 #include "prototypes.h"
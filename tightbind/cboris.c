@@ -9,10 +9,9 @@ void cboris(int *n,int *nd,double *a,double *b,double *c,double *d,double *e,
 
 
 extern void cchol(int *n,int *nd,double *a,int *fail);
-extern void ctred2(int *n,int *nd,double *a,double *b,double *d,double *e,double *f);
-extern void ctql2(int *n,int *nd,double *d,double *e,double *f,double *a,double *b,
-    int *fail);
-static int lf,i,ia,j,k,ja,ii;
+extern void cboris_factored(int *n,int *nd,double *a,double *b,double *c,double *d,
+    double *e,double *f,int *fail);
+int lf;
 /*
 
   for YAeHMOP this common block is not needed
@@ -84,7 +83,30 @@ static int lf,i,ia,j,k,ja,ii;
 */
     *fail = 1;
     cchol(n,nd,b,&lf);
-    if(lf != 0) goto S999;
+    if(lf != 0) return;
+    cboris_factored(n,nd,a,b,c,d,e,f,fail);
+}
+
+/*
+
+  for YAeHMOP:  CBORIS_FACTORED IS CBORIS WITHOUT THE CHOLESKI
+  DECOMPOSITION.  ON ENTRY B MUST ALREADY HOLD THE LOWER
+  TRIANGLE OF L (AS LEFT BEHIND BY CCHOL OR A PREVIOUS CALL
+  TO CBORIS), SO THAT THE FACTORIZATION OF AN OVERLAP MATRIX
+  WHICH HAS NOT CHANGED CAN BE REUSED.  THE OTHER ARGUMENTS
+  ARE AS IN CBORIS.
+              gL
+
+*/
+void cboris_factored(int *n,int *nd,double *a,double *b,double *c,double *d,
+    double *e,double *f,int *fail)
+{
+extern void ctred2(int *n,int *nd,double *a,double *b,double *d,double *e,double *f);
+extern void ctql2(int *n,int *nd,double *d,double *e,double *f,double *a,double *b,
+    int *fail);
+int lf,i,ia,j,k,ja,ii;
+
+    *fail = 1;
 /*
  MOVE MATRIX A
 
@@ -0,0 +1,151 @@
+/*******************************************************
+
+Copyright (C) 2026 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*  Finite difference check of the forces from the Gradients keyword
+*
+*   usage: check_forces
+*
+*  for a few small molecules (with and without the electrostatic term,
+*   and with and without d orbitals), compares the analytic forces with
+*   central differences of the total energy.  Everything goes through
+*   the library interface (eht_api.h), so the energies aren't limited
+*   to the precision of the output file.  Exits with a nonzero status if
+*   any force is off.
+*
+*****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "eht_api.h"
+
+#define MAX_CHECK_ATOMS 4
+
+/* the displacement used for the differences (in Angstroms) */
+#define FD_STEP 1e-4
+
+/* how far apart the forces can be (in eV/Angstrom) */
+#define ABS_TOL 1e-4
+#define REL_TOL 1e-5
+
+typedef struct {
+  char *name;
+  int num_atoms;
+  const char *symbols[MAX_CHECK_ATOMS];
+  double coords[3*MAX_CHECK_ATOMS];
+  int electrostatics;
+} check_case_type;
+
+static check_case_type check_cases[]={
+  {"H2O",3,{"O","H","H"},{0.0,0.0,0.0, 0.95,0.1,0.0, -0.3,0.9,0.05},0},
+  {"H2O electrostatics",3,{"O","H","H"},{0.0,0.0,0.0, 0.95,0.1,0.0, -0.3,0.9,0.05},1},
+  {"ZrCO",3,{"Zr","C","O"},{0.0,0.0,0.0, 2.2,0.3,0.1, 3.35,0.45,-0.1},0},
+  {"ZrCO electrostatics",3,{"Zr","C","O"},{0.0,0.0,0.0, 2.2,0.3,0.1, 3.35,0.45,-0.1},1},
+  {"HCNZr electrostatics",4,{"H","C","N","Zr"},
+   {0.0,0.0,0.0, 0.05,0.1,1.08, 0.0,-0.1,2.25, 0.2,0.1,4.4},1},
+};
+#define NUM_CHECK_CASES (int)(sizeof(check_cases)/sizeof(check_case_type))
+
+
+/****************************************************************************
+*
+*                   Function run_case
+*
+* Arguments: the_case: pointer to check_case_type
+*            coords: pointer to double
+*            energy: pointer to double
+*            forces: pointer to double (can be NULL)
+*
+* Returns: int
+*
+* Action: runs 'the_case at 'coords and fetches its total energy (and
+*   the forces if 'forces isn't NULL).  Returns nonzero on failure.
+*
+*****************************************************************************/
+static int run_case(check_case_type *the_case,double *coords,double *energy,
+                    double *forces)
+{
+  eht_system *sys;
+  int failed;
+
+  sys = eht_create(the_case->num_atoms,the_case->symbols,coords,0,NULL);
+  if( !sys ) return 1;
+  eht_set_charge(sys,0.0);
+  failed = eht_set_electrostatics(sys,the_case->electrostatics) ||
+    eht_request(sys,forces ? EHT_FORCES : 0) ||
+    eht_run(sys) ||
+    eht_get_total_energy(sys,energy) ||
+    (forces && eht_get_forces(sys,forces) < 0);
+  if( failed ) fprintf(stderr,"check_forces: %s failed: %s\n",the_case->name,
+                       eht_last_error(sys));
+  eht_destroy(sys);
+  return failed;
+}
+
+
+int main(int argc,char **argv)
+{
+  check_case_type *the_case;
+  double coords[3*MAX_CHECK_ATOMS],forces[3*MAX_CHECK_ATOMS];
+  double energy,e_plus,e_minus,fd_force,diff,max_diff;
+  int i,j,num_bad,tot_bad;
+
+  tot_bad = 0;
+  for(i=0;i<NUM_CHECK_CASES;i++){
+    the_case = &(check_cases[i]);
+    if( run_case(the_case,the_case->coords,&energy,forces) ) exit(2);
+
+    num_bad = 0;
+    max_diff = 0.0;
+    for(j=0;j<3*the_case->num_atoms;j++){
+      memcpy(coords,the_case->coords,sizeof(coords));
+      coords[j] += FD_STEP;
+      if( run_case(the_case,coords,&e_plus,0) ) exit(2);
+      coords[j] -= 2*FD_STEP;
+      if( run_case(the_case,coords,&e_minus,0) ) exit(2);
+      fd_force = -(e_plus-e_minus)/(2*FD_STEP);
+      diff = fabs(fd_force-forces[j]);
+      if( diff > max_diff ) max_diff = diff;
+      if( diff > ABS_TOL + REL_TOL*fabs(fd_force) ){
+        printf("  %s atom %d %c: analytic %.6f finite difference %.6f\n",
+               the_case->name,j/3+1,"xyz"[j%3],forces[j],fd_force);
+        num_bad++;
+      }
+    }
+    printf("%-22s E = %12.6f eV  largest difference %.2e eV/A  %s\n",
+           the_case->name,energy,max_diff,num_bad ? "FAILED" : "ok");
+    tot_bad += num_bad;
+  }
+  exit(tot_bad ? 1 : 0);
+}
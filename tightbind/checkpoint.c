@@ -0,0 +1,740 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the stuff for checkpointing long runs.
+*
+*   When a checkpoint interval is given in the input file, the state of
+*    the run is written to <input>.chk:
+*      - after each cycle of a charge iteration or zeta optimization (the
+*        atomic parameters and the state of the iteration),
+*      - after each step of a Walsh diagram,
+*      - during the loop over k points, when more than the interval has
+*        gone by since the last checkpoint (the eigenvalues and vectors
+*        stored for the average properties at the k points done so far).
+*    The file is written to <input>.chk.tmp and then renamed, so a run
+*    which is killed while checkpointing leaves the old checkpoint intact.
+*
+*   Running bind with --restart picks the run up from the checkpoint,
+*    provided it was written by this version of the program for the
+*    same input file (the file is stamped with a hash of the input deck).
+*
+*   On a restart the finished Walsh steps and k points are skipped, but
+*    the setup (and the part of the current step before the checkpoint)
+*    is done again.  Its output has already been written, so until the
+*    restart point is reached the output streams are pointed at scratch
+*    files, then the real output files are truncated to the sizes they
+*    had when the checkpoint was written and output continues from there.
+*    The results are the same as those of a run which was never
+*    interrupted, though the things which are cached for the whole run
+*    (overlap matrices, symmetry blocking) are worked out again after a
+*    restart and may add a few comment lines to the output.
+*
+*   The checkpoint file is removed once the run finishes.
+*
+*****************************************************************************/
+
+#include "bind.h"
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define ftruncate _chsize
+#else
+#include <unistd.h>
+#endif
+
+#define CHK_MAGIC "YAeHMOP chk"
+#define CHK_VERSION 1
+
+/* the output streams which are tracked across a restart */
+static FILE **the_streams[NUM_CHK_STREAMS]={&output_file,&walsh_file,
+                                             &band_file,&FMO_file};
+static char stream_names[NUM_CHK_STREAMS][MAX_STR_LEN];
+static FILE *sinks[NUM_CHK_STREAMS];
+
+/* where checkpoints go and what they were made from */
+static char chk_name[MAX_STR_LEN];
+static char chk_enabled=0;
+static unsigned long deck_hash;
+static long deck_len;
+static real chk_interval;
+static time_t last_write;
+static int current_step;
+
+/* the state picked up from the checkpoint on a restart */
+static FILE *restore_file=0;
+static char restoring=0;
+static int restore_phase,restore_step,restore_k_done;
+static int restore_num_atoms;
+static atom_type *restore_atoms=0;
+static int restore_chg_calls,restore_AO_size;
+static real *restore_AO=0;
+static int restore_zeta_calls;
+static real *restore_zeta_chgs=0;
+static long restore_offsets[NUM_CHK_STREAMS];
+static char restore_names[NUM_CHK_STREAMS][MAX_STR_LEN];
+
+
+/****************************************************************************
+*
+*                   Procedure hash_input_deck
+*
+* Arguments: file_name: pointer to char
+*               length: pointer to long
+*
+* Returns: unsigned long
+*
+* Action: returns the (32 bit FNV-1a) hash of the contents of the file
+*    'file_name and puts its length in 'length.
+*
+*****************************************************************************/
+static unsigned long hash_input_deck(char *file_name,long *length)
+{
+  FILE *infile;
+  unsigned long hash;
+  int c;
+
+  hash = 2166136261UL;
+  *length = 0;
+  infile = fopen(file_name,"rb");
+  if( !infile ) return hash;
+  while( (c=getc(infile)) != EOF ){
+    hash = ((hash ^ (unsigned long)c) * 16777619UL) & 0xffffffffUL;
+    (*length)++;
+  }
+  fclose(infile);
+  return hash;
+}
+
+/****************************************************************************
+*
+*                   Procedure chk_read
+*
+* Arguments: ptr: pointer to void
+*           size: long
+*          count: long
+*
+* Returns: none
+*
+* Action: reads 'count items from the checkpoint, a short read is fatal.
+*
+*****************************************************************************/
+static void chk_read(void *ptr,long size,long count)
+{
+  if( count && fread(ptr,size,count,restore_file) != (size_t)count ){
+    fatal("The checkpoint file is truncated.");
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure chk_write
+*
+* Arguments: ptr: pointer to void
+*           size: long
+*          count: long
+*        outfile: pointer to FILE
+*
+* Returns: none
+*
+* Action: writes 'count items to the checkpoint.
+*
+*****************************************************************************/
+static void chk_write(void *ptr,long size,long count,FILE *outfile)
+{
+  if( count && fwrite(ptr,size,count,outfile) != (size_t)count ){
+    error("Can't write the checkpoint file.");
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure close_restore_file
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: forgets about the checkpoint being restored.
+*
+*****************************************************************************/
+static void close_restore_file()
+{
+  if( restore_file ) fclose(restore_file);
+  restore_file = 0;
+  restoring = 0;
+  if( restore_atoms ) free(restore_atoms);
+  if( restore_AO ) free(restore_AO);
+  if( restore_zeta_chgs ) free(restore_zeta_chgs);
+  restore_atoms = 0;
+  restore_AO = 0;
+  restore_zeta_chgs = 0;
+}
+
+/****************************************************************************
+*
+*                   Procedure resume_streams
+*
+* Arguments: keep_sinks: char
+*
+* Returns: none
+*
+* Action: points the output streams which have been going to scratch files
+*    back at their real files.
+*
+*   If 'keep_sinks is nonzero the restart is being abandoned, so the
+*    real files are started over with what went into the scratch files.
+*   Otherwise the real files are truncated to the sizes they had when
+*    the checkpoint was written.
+*
+*****************************************************************************/
+static void resume_streams(char keep_sinks)
+{
+  FILE *real_file;
+  long offset;
+  int i,c;
+
+  for(i=0;i<NUM_CHK_STREAMS;i++){
+    if( !sinks[i] ) continue;
+    if( *the_streams[i] != sinks[i] ){
+      /* the stream has been closed or reopened since */
+      fclose(sinks[i]);
+      sinks[i] = 0;
+      continue;
+    }
+    offset = 0;
+    if( !keep_sinks && !strcmp(stream_names[i],restore_names[i]) ){
+      offset = restore_offsets[i];
+    }
+    if( keep_sinks || !offset ){
+      real_file = fopen(stream_names[i],"w+");
+    } else{
+      real_file = fopen(stream_names[i],"r+");
+      if( real_file ){
+        fseek(real_file,0L,SEEK_END);
+        if( ftell(real_file) < offset ) fatal("An output file is shorter than its checkpoint.");
+        fflush(real_file);
+        if( ftruncate(fileno(real_file),offset) ) fatal("Can't truncate an output file.");
+        fseek(real_file,0L,SEEK_END);
+      }
+    }
+    if( !real_file ) fatal("Can't reopen an output file to restart.");
+    if( keep_sinks ){
+      rewind(sinks[i]);
+      while( (c=getc(sinks[i])) != EOF ) putc(c,real_file);
+    }
+    fclose(sinks[i]);
+    sinks[i] = 0;
+    *the_streams[i] = real_file;
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure restore_cycle_state
+*
+* Arguments: cell: pointer to cell_type
+*
+* Returns: none
+*
+* Action: puts the atomic parameters and the state of the charge iteration
+*    and zeta optimization back the way they were at the checkpoint.
+*
+*****************************************************************************/
+static void restore_cycle_state(cell_type *cell)
+{
+  bcopy((char *)restore_atoms,(char *)cell->atoms,
+        restore_num_atoms*sizeof(atom_type));
+  set_chg_it_state(restore_chg_calls,restore_AO,restore_AO_size);
+  if( restore_zeta_chgs ){
+    set_zeta_state(restore_zeta_calls,restore_zeta_chgs,restore_num_atoms);
+  }
+}
+
+/****************************************************************************
+*
+*                   Function checkpoint_init
+*
+* Arguments: file_name: pointer to char
+*
+* Returns: char
+*
+* Action: sets up the checkpointing for the input file 'file_name.
+*   This needs to be called before any of the output files are opened.
+*
+*   If a restart was asked for and there is a checkpoint from the same
+*    input file, it is opened and 1 is returned.
+*
+*****************************************************************************/
+char checkpoint_init(char *file_name)
+{
+  char magic[sizeof(CHK_MAGIC)];
+  int version;
+  unsigned long hash;
+  long length;
+
+  sprintf(chk_name,"%s.chk",file_name);
+  deck_hash = hash_input_deck(file_name,&deck_len);
+
+  if( !restart_run ) return 0;
+
+  restore_file = fopen(chk_name,"rb");
+  if( !restore_file ){
+    fprintf(stderr,"There's no checkpoint file %s, starting from the beginning.\n",
+            chk_name);
+    return 0;
+  }
+  if( fread(magic,sizeof(magic),1,restore_file) != 1 ||
+      strncmp(magic,CHK_MAGIC,sizeof(magic)) ||
+      fread(&version,sizeof(int),1,restore_file) != 1 ||
+      version != CHK_VERSION ){
+    fprintf(stderr,"%s isn't a checkpoint from this version of the program, ignoring it.\n",
+            chk_name);
+    close_restore_file();
+    return 0;
+  }
+  if( fread(&hash,sizeof(hash),1,restore_file) != 1 ||
+      fread(&length,sizeof(length),1,restore_file) != 1 ||
+      hash != deck_hash || length != deck_len ){
+    fprintf(stderr,"%s was written for a different input file, ignoring it.\n",
+            chk_name);
+    close_restore_file();
+    return 0;
+  }
+  restoring = 1;
+  return 1;
+}
+
+/****************************************************************************
+*
+*                   Function checkpoint_fopen
+*
+* Arguments: name: pointer to char
+*           which: int
+*
+* Returns: pointer to FILE
+*
+* Action: opens the output file 'name, which will be used for the output
+*   stream 'which (one of the CHK_ streams), for writing.
+*
+*   Until the restart point is reached during a restart, what's written
+*   to the stream is thrown away, so a scratch file is returned instead.
+*
+*****************************************************************************/
+FILE *checkpoint_fopen(char *name,int which)
+{
+  strcpy(stream_names[which],name);
+  if( restoring ){
+    if( sinks[which] && *the_streams[which] != sinks[which] ){
+      fclose(sinks[which]);
+    }
+    sinks[which] = tmpfile();
+    return sinks[which];
+  }
+  return fopen(name,"w+");
+}
+
+/****************************************************************************
+*
+*                   Procedure checkpoint_setup
+*
+* Arguments: details: pointer to detail_type
+*               cell: pointer to cell_type
+*           num_orbs: int
+*
+* Returns: none
+*
+* Action: turns on checkpointing if the input file asks for it and,
+*   on a restart, reads the state of the run from the checkpoint.
+*   This is called once the input has been read.
+*
+*****************************************************************************/
+void checkpoint_setup(detail_type *details,cell_type *cell,int num_orbs)
+{
+  int dims[4];
+  int i,len;
+  char ok;
+
+  chk_interval = details->checkpoint_interval;
+  chk_enabled = chk_name[0] && chk_interval > 0.0;
+  if( chk_enabled && details->binary_results ){
+    error("Checkpoints can't be used along with binary results, turning them off.");
+    chk_enabled = 0;
+  }
+  last_write = time(0);
+  current_step = 0;
+
+  if( !restoring ) return;
+
+  ok = !details->binary_results;
+  if( ok ){
+    chk_read(dims,sizeof(int),4);
+    ok = dims[0] == cell->num_atoms && dims[1] == num_orbs &&
+      dims[2] == details->num_KPOINTS &&
+      dims[3] == details->walsh_details.num_steps;
+  }
+  if( !ok ){
+    fprintf(status_file,"The checkpoint doesn't fit this run, starting from the beginning.\n");
+    resume_streams(1);
+    close_restore_file();
+    return;
+  }
+
+  chk_read(&restore_phase,sizeof(int),1);
+  chk_read(&restore_step,sizeof(int),1);
+  chk_read(&restore_k_done,sizeof(int),1);
+
+  restore_num_atoms = cell->num_atoms;
+  restore_atoms = (atom_type *)calloc(restore_num_atoms,sizeof(atom_type));
+  if( !restore_atoms ) fatal("Can't get memory to restore the atoms.");
+  chk_read(restore_atoms,sizeof(atom_type),restore_num_atoms);
+
+  chk_read(&restore_chg_calls,sizeof(int),1);
+  chk_read(&restore_AO_size,sizeof(int),1);
+  if( restore_AO_size ){
+    restore_AO = (real *)calloc(restore_AO_size,sizeof(real));
+    if( !restore_AO ) fatal("Can't get memory to restore the charge iteration.");
+    chk_read(restore_AO,sizeof(real),restore_AO_size);
+  }
+  chk_read(&restore_zeta_calls,sizeof(int),1);
+  chk_read(&len,sizeof(int),1);
+  if( len ){
+    restore_zeta_chgs = (real *)calloc(restore_num_atoms,sizeof(real));
+    if( !restore_zeta_chgs ) fatal("Can't get memory to restore the zetas.");
+    chk_read(restore_zeta_chgs,sizeof(real),restore_num_atoms);
+  }
+
+  for(i=0;i<NUM_CHK_STREAMS;i++){
+    chk_read(&len,sizeof(int),1);
+    if( len >= MAX_STR_LEN ) fatal("Bad file name in the checkpoint.");
+    chk_read(restore_names[i],sizeof(char),len);
+    restore_names[i][len] = 0;
+    chk_read(&restore_offsets[i],sizeof(long),1);
+  }
+
+  fprintf(status_file,"Restarting from the checkpoint in %s (Walsh step %d, %d k points).\n",
+          chk_name,restore_step+1,restore_k_done);
+}
+
+/****************************************************************************
+*
+*                   Function checkpoint_skip_walsh_step
+*
+* Arguments: cell: pointer to cell_type
+*      walsh_step: int
+*
+* Returns: char
+*
+* Action: this is called at the top of each step of the Walsh loop.
+*   It returns 1 if the step was finished before the checkpoint being
+*   restarted from.
+*
+*****************************************************************************/
+char checkpoint_skip_walsh_step(cell_type *cell,int walsh_step)
+{
+  current_step = walsh_step;
+  if( !restoring ) return 0;
+  if( walsh_step < restore_step ) return 1;
+  if( restore_phase == CHK_WALSH_STEP ){
+    restore_cycle_state(cell);
+    resume_streams(0);
+    close_restore_file();
+  }
+  return 0;
+}
+
+/****************************************************************************
+*
+*                   Procedure checkpoint_restore_cycle
+*
+* Arguments: cell: pointer to cell_type
+*
+* Returns: none
+*
+* Action: this is called before the convergence loop is entered.  If the
+*   checkpoint was written during the loop, the atomic parameters and
+*   iteration state are restored.
+*
+*****************************************************************************/
+void checkpoint_restore_cycle(cell_type *cell)
+{
+  if( !restoring || restore_phase != CHK_CYCLE ) return;
+  restore_cycle_state(cell);
+  if( !restore_k_done ){
+    resume_streams(0);
+    close_restore_file();
+  }
+}
+
+/****************************************************************************
+*
+*                   Function checkpoint_restore_kpoint
+*
+* Arguments: details: pointer to detail_type
+*            which_k: int
+*           num_orbs: int
+*      avg_prop_info: pointer to avg_prop_info_type
+*
+* Returns: char
+*
+* Action: this is called at the top of the loop over k points.  If k point
+*   'which_k was done before the checkpoint, the information needed for
+*   the average properties is read back into 'avg_prop_info and 1 is
+*   returned (the k point can be skipped).
+*
+*****************************************************************************/
+char checkpoint_restore_kpoint(detail_type *details,int which_k,int num_orbs,
+                               avg_prop_info_type *avg_prop_info)
+{
+  avg_prop_info_type *info;
+  float *arrays[7];
+  int i,present;
+
+  if( !restoring || restore_phase != CHK_CYCLE ) return 0;
+  if( which_k >= restore_k_done ){
+    resume_streams(0);
+    close_restore_file();
+    return 0;
+  }
+
+  info = &(avg_prop_info[which_k]);
+  chk_read(info->energies,sizeof(float),num_orbs);
+  arrays[0] = info->orbs;
+  arrays[1] = info->orbsI;
+  arrays[2] = info->S;
+  arrays[3] = info->chg_mat;
+  arrays[4] = info->FMO_orbs;
+  arrays[5] = info->FMO_orbsI;
+  arrays[6] = info->FMO_chg_mat;
+  for(i=0;i<7;i++){
+    chk_read(&present,sizeof(int),1);
+    if( present != (arrays[i] != 0) ) fatal("The checkpoint doesn't fit this run.");
+    if( present ) chk_read(arrays[i],sizeof(float),num_orbs*num_orbs);
+  }
+
+  if( which_k == 0 ){
+    fprintf(status_file,"Restoring %d k points from the checkpoint.\n",
+            restore_k_done);
+  }
+  return 1;
+}
+
+/****************************************************************************
+*
+*                   Function checkpoint_pending
+*
+* Arguments: none
+*
+* Returns: char
+*
+* Action: returns 1 if a run is being picked up from a checkpoint and
+*   the restart point hasn't been reached yet.
+*
+*****************************************************************************/
+char checkpoint_pending()
+{
+  return restoring;
+}
+
+/****************************************************************************
+*
+*                   Procedure checkpoint_write
+*
+* Arguments: details: pointer to detail_type
+*               cell: pointer to cell_type
+*           num_orbs: int
+*              phase: int
+*             k_done: int
+*      avg_prop_info: pointer to avg_prop_info_type
+*
+* Returns: none
+*
+* Action: writes a checkpoint.
+*
+*   'phase is CHK_WALSH_STEP if the current step of the Walsh diagram has
+*    just been finished and CHK_CYCLE for a checkpoint from within the
+*    convergence loop, in which case the first 'k_done k points are
+*    finished and their data is stored in 'avg_prop_info.
+*
+*****************************************************************************/
+void checkpoint_write(detail_type *details,cell_type *cell,int num_orbs,
+                      int phase,int k_done,avg_prop_info_type *avg_prop_info)
+{
+  char tmp_name[MAX_STR_LEN+10];
+  FILE *outfile;
+  avg_prop_info_type *info;
+  float *arrays[7];
+  int dims[4];
+  int i,j,len,step,present;
+  int chg_calls,AO_size,zeta_calls;
+  real *AO_store,*zeta_chgs;
+  long offset;
+
+  if( !chk_enabled ) return;
+
+  sprintf(tmp_name,"%s.tmp",chk_name);
+  outfile = fopen(tmp_name,"wb");
+  if( !outfile ){
+    error("Can't open the checkpoint file.");
+    return;
+  }
+
+  step = current_step;
+  if( phase == CHK_WALSH_STEP ) step++;
+
+  chk_write(CHK_MAGIC,sizeof(CHK_MAGIC),1,outfile);
+  i = CHK_VERSION;
+  chk_write(&i,sizeof(int),1,outfile);
+  chk_write(&deck_hash,sizeof(deck_hash),1,outfile);
+  chk_write(&deck_len,sizeof(deck_len),1,outfile);
+
+  dims[0] = cell->num_atoms;
+  dims[1] = num_orbs;
+  dims[2] = details->num_KPOINTS;
+  dims[3] = details->walsh_details.num_steps;
+  chk_write(dims,sizeof(int),4,outfile);
+  chk_write(&phase,sizeof(int),1,outfile);
+  chk_write(&step,sizeof(int),1,outfile);
+  chk_write(&k_done,sizeof(int),1,outfile);
+
+  chk_write(cell->atoms,sizeof(atom_type),cell->num_atoms,outfile);
+  get_chg_it_state(&chg_calls,&AO_store,&AO_size);
+  chk_write(&chg_calls,sizeof(int),1,outfile);
+  chk_write(&AO_size,sizeof(int),1,outfile);
+  chk_write(AO_store,sizeof(real),AO_size,outfile);
+  get_zeta_state(&zeta_calls,&zeta_chgs);
+  chk_write(&zeta_calls,sizeof(int),1,outfile);
+  len = zeta_chgs ? cell->num_atoms : 0;
+  chk_write(&len,sizeof(int),1,outfile);
+  chk_write(zeta_chgs,sizeof(real),len,outfile);
+
+  for(i=0;i<NUM_CHK_STREAMS;i++){
+    offset = 0;
+    len = 0;
+    if( *the_streams[i] && stream_names[i][0] ){
+      fflush(*the_streams[i]);
+      offset = ftell(*the_streams[i]);
+      len = strlen(stream_names[i]);
+    }
+    chk_write(&len,sizeof(int),1,outfile);
+    chk_write(stream_names[i],sizeof(char),len,outfile);
+    chk_write(&offset,sizeof(long),1,outfile);
+  }
+
+  for(j=0;j<k_done;j++){
+    info = &(avg_prop_info[j]);
+    chk_write(info->energies,sizeof(float),num_orbs,outfile);
+    arrays[0] = info->orbs;
+    arrays[1] = info->orbsI;
+    arrays[2] = info->S;
+    arrays[3] = info->chg_mat;
+    arrays[4] = info->FMO_orbs;
+    arrays[5] = info->FMO_orbsI;
+    arrays[6] = info->FMO_chg_mat;
+    for(i=0;i<7;i++){
+      present = arrays[i] != 0;
+      chk_write(&present,sizeof(int),1,outfile);
+      if( present ) chk_write(arrays[i],sizeof(float),num_orbs*num_orbs,outfile);
+    }
+  }
+
+  if( fclose(outfile) ){
+    error("Can't write the checkpoint file.");
+    return;
+  }
+#ifdef _WIN32
+  remove(chk_name);
+#endif
+  if( rename(tmp_name,chk_name) ){
+    error("Can't rename the checkpoint file.");
+    return;
+  }
+  fprintf(status_file,"Checkpoint written (Walsh step %d, %d k points).\n",
+          step+1,k_done);
+  last_write = time(0);
+}
+
+/****************************************************************************
+*
+*                   Procedure checkpoint_kpoint_done
+*
+* Arguments: details: pointer to detail_type
+*               cell: pointer to cell_type
+*            which_k: int
+*           num_orbs: int
+*      avg_prop_info: pointer to avg_prop_info_type
+*
+* Returns: none
+*
+* Action: called once the data for k point 'which_k has been stored,
+*   this writes a checkpoint if the checkpoint interval has passed.
+*
+*   The k points can only be picked up from a checkpoint when all they
+*    leave behind is in 'avg_prop_info.
+*
+*****************************************************************************/
+void checkpoint_kpoint_done(detail_type *details,cell_type *cell,int which_k,
+                            int num_orbs,avg_prop_info_type *avg_prop_info)
+{
+  if( !chk_enabled || which_k >= details->num_KPOINTS-1 ) return;
+  if( difftime(time(0),last_write) < 60.0*chk_interval ) return;
+  if( details->Execution_Mode == MOLECULAR || !details->avg_props ||
+      details->num_FCO_frags || details->dump_hamil || details->dump_overlap ||
+      details->dump_sparse_mats ) return;
+
+  checkpoint_write(details,cell,num_orbs,CHK_CYCLE,which_k+1,avg_prop_info);
+}
+
+/****************************************************************************
+*
+*                   Procedure checkpoint_finish
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: the run is done, so the checkpoint isn't needed anymore.
+*
+*****************************************************************************/
+void checkpoint_finish()
+{
+  if( restoring ){
+    /* the restart point was never reached */
+    resume_streams(1);
+  }
+  close_restore_file();
+  if( chk_enabled ) remove(chk_name);
+  chk_enabled = 0;
+  chk_name[0] = 0;
+}
@@ -39,7 +39,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 #include "bind.h"
 
-
+/******
+  the occupations from the last call and the number of calls so far.
+  These live out here so that they can be saved in checkpoints.
+******/
+static real *AO_store=0;
+static int AO_store_size=0;
+static int num_calls=0;
 
 
 /****************************************************************************
@@ -63,8 +69,6 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 void update_chg_it_parms(detail_type *details,cell_type *cell,real *AO_occups,int *converged,int num_orbs,
                          int *orbital_lookup_table)
 {
-  static real *AO_store=0;
-  static int num_calls=0;
   atom_type *atom;
   chg_it_parm_type *parms;
   int i,j,num_atoms;
@@ -78,10 +82,17 @@ void update_chg_it_parms(detail_type *details,cell_type *cell,real *AO_occups,in
   int orb_tab;
   int begin_atom,end_atom;
 
-  /* get storage space if this is the first call */
-  if( !AO_store ){
-    AO_store = (real *)calloc(num_orbs,sizeof(real));
+  /******
+    get storage space if this is the first call (or the number of
+    orbitals has changed).  This holds the occupations from the last
+    call, so it can't live in one of the arenas.
+  ******/
+  if( AO_store_size != num_orbs ){
+    if( AO_store ) my_free(AO_store);
+    AO_store = (real *)my_calloc(num_orbs,sizeof(real));
     if( !AO_store ) fatal("Can't get AO_store memory.");
+    retag_memory(AO_store,MEM_PERSISTENT);
+    AO_store_size = num_orbs;
   }
   parms = &(details->chg_it_parms);
 
@@ -227,3 +238,56 @@ fprintf(stderr,"It: %d, denom: %lf tol: %lf\n",num_calls,denom,parms->tolerance)
                            num_calls,parms->max_it);
 
 }
+
+
+/****************************************************************************
+ *
+ *                   Procedure get_chg_it_state
+ *
+ * Arguments:     calls: pointer to int
+ *                store: pointer to pointer to real
+ *           store_size: pointer to int
+ *
+ * Returns: none
+ *
+ * Action:  Returns the number of charge iteration cycles done so far and
+ *   the AO occupations from the last of them (store_size is zero if
+ *   there haven't been any).
+ *
+ ****************************************************************************/
+void get_chg_it_state(int *calls,real **store,int *store_size)
+{
+  *calls = num_calls;
+  *store = AO_store;
+  *store_size = AO_store_size;
+}
+
+/****************************************************************************
+ *
+ *                   Procedure set_chg_it_state
+ *
+ * Arguments:     calls: int
+ *                store: pointer to real
+ *           store_size: int
+ *
+ * Returns: none
+ *
+ * Action:  The inverse of get_chg_it_state, this is used to pick up
+ *   a charge iteration from a checkpoint.
+ *
+ ****************************************************************************/
+void set_chg_it_state(int calls,real *store,int store_size)
+{
+  if( AO_store_size != store_size ){
+    if( AO_store ) my_free(AO_store);
+    AO_store = 0;
+    if( store_size ){
+      AO_store = (real *)my_calloc(store_size,sizeof(real));
+      if( !AO_store ) fatal("Can't get AO_store memory.");
+      retag_memory(AO_store,MEM_PERSISTENT);
+    }
+    AO_store_size = store_size;
+  }
+  if( store_size ) bcopy((char *)store,(char *)AO_store,store_size*sizeof(real));
+  num_calls = calls;
+}
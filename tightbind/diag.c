@@ -5,7 +5,7 @@ Produced by gmFortran V30.59(10/26/17) on 9/18/18 at 9:02:32
 #include "fortran.h"
 void cchol(int *n,int *nd,double *a,int *fail)
 {
-static int i,ia,j,k,ka;
+int i,ia,j,k,ka;
 /*
 
  SUBROUTINE CCHOL COMPUTES CHOLESKI
@@ -92,12 +92,12 @@ S13:;
 }
 void ctred2(int *n,int *nd,double *a,double *b,double *d,double *e,double *f)
 {
-static double chep;
-static int k,l;
-static double all;
-static int i;
-static double c,s,r,alr,ali,sm,g,t;
-static int ia,j,kk;
+double chep;
+int k,l;
+double all;
+int i;
+double c,s,r,alr,ali,sm,g,t;
+int ia,j,kk;
 /*
 
      SUBROUTINE CTRED2 REDUCES GIVEN COMPLEX
@@ -301,17 +301,17 @@ S36:
 void ctql2(int *n,int *nd,double *d,double *e,double *f,double *a,double *b,
     int *fail)
 {
-static double chep;
-static int k;
-static double r,c,s;
-static int i;
-static double p;
-static int l;
-static double bb,ff;
-static int j;
-static double h;
-static int m,ma,ia,i1;
-static double g,hr,hi;
+double chep;
+int k;
+double r,c,s;
+int i;
+double p;
+int l;
+double bb,ff;
+int j;
+double h;
+int m,ma,ia,i1;
+double g,hr,hi;
 /*
 
      SUBROUTINE CTQL2 COMPUTES THE EIGENVALUES AND
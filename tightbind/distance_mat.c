@@ -45,37 +45,94 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /* distances less than this trigger warnings */
 #define TOO_SHORT 1.0
 
+/******
+  the neighboring cells checked for close contacts, in the order they're
+  reported.  Only the first 1, 4 or 13 of these are used for 1, 2 or 3
+  dimensional systems.
+*******/
+static int nn_cells[13][3]={{1,0,0},
+                            {1,1,0},{0,1,0},{-1,1,0},
+                            {0,0,1},{1,1,1},{0,1,1},{-1,1,1},{1,0,1},
+                            {-1,0,1},{1,-1,1},{0,-1,1},{-1,-1,1}};
+static char *nn_cell_names[13]={"(1 0 0)",
+                                "(1 1 0)","(0 1 0)","(-1 1 0)",
+                                "(0 0 1)","(1 1 1)","(0 1 1)","(-1 1 1)",
+                                "(1 0 1)","(-1 0 1)","(1 -1 1)","(0 -1 1)",
+                                "(-1 -1 1)"};
+
+/****************************************************************************
+*
+*                   Function atom_distance
+*
+* Arguments:  cell: pointer to cell_type
+*           atom1, atom2: ints
+*
+* Returns: real
+*
+* Action: returns the distance between 'atom1 and 'atom2 in the unit cell.
+*
+*****************************************************************************/
+real atom_distance(cell_type *cell,int atom1,int atom2)
+{
+  point_type temp;
+
+  temp.x = cell->atoms[atom1].loc.x - cell->atoms[atom2].loc.x;
+  temp.y = cell->atoms[atom1].loc.y - cell->atoms[atom2].loc.y;
+  temp.z = cell->atoms[atom1].loc.z - cell->atoms[atom2].loc.z;
+
+  return sqrt(temp.x*temp.x + temp.y*temp.y + temp.z*temp.z);
+}
+
 /****************************************************************************
 *
 *                   Procedure check_a_cell
 *
-* Arguments:  atoms: pointer to atom_type
-*              vect: point_type
-*         num_atoms: int
+* Arguments:  cell: pointer to cell_type
+*        neighbors: pointer to neighbor_list_type
+*             vect: point_type
 * closest_nn_contact: real
 *        descriptor: pointer to char
 *
 * Returns: none
 *
 * Action:
-*        Goes through 'atoms and checks the distances between
+*        Goes through the atoms of 'cell and checks the distances between
 *   the unmoved atoms and the atoms in the cell translated by
 *   'vect.  any distances less than 'closest_nn_contact are printed
 *   out in the output file.
 *
+*   Only the pairs in 'neighbors are checked, so it needs to have been
+*    built with a cut off at least as big as 'closest_nn_contact and
+*    TOO_SHORT.
+*
 *****************************************************************************/
-void check_a_cell(atom_type *atoms,point_type vect,int num_atoms,real closest_nn_contact,char *descriptor)
+void check_a_cell(cell_type *cell,neighbor_list_type *neighbors,point_type vect,
+                  real closest_nn_contact,char *descriptor)
 {
+  atom_type *atoms;
   int i,j;
+  int image,pair,pair_end;
   real min_squared;
   real dist,temp;
 
+  atoms = cell->atoms;
+
   /* use the squared distance to avoid sqrts */
   min_squared = closest_nn_contact * closest_nn_contact;
 
+  image = find_neighbor_image(neighbors,vect);
+
   /* loop over all the atoms */
-  for(i=0;i<num_atoms;i++){
-    for(j=0;j<num_atoms;j++){
+  for(i=0;i<cell->num_atoms;i++){
+    if( image >= 0 ){
+      pair = neighbors->first[i*neighbors->num_images+image];
+      pair_end = neighbors->first[i*neighbors->num_images+image+1];
+    } else{
+      pair = 0;
+      pair_end = cell->num_atoms;
+    }
+    for(;pair<pair_end;pair++){
+      j = image >= 0 ? neighbors->partner[pair] : pair;
       temp = atoms[i].loc.x - (atoms[j].loc.x + vect.x);
       dist = temp*temp;
       temp = atoms[i].loc.y - (atoms[j].loc.y + vect.y);
@@ -115,15 +172,11 @@ void check_a_cell(atom_type *atoms,point_type vect,int num_atoms,real closest_nn
 *****************************************************************************/
 void check_nn_contacts(cell_type *cell,detail_type *details)
 {
-  int num_atoms;
-  int i,j;
+  neighbor_list_type *neighbors;
+  int i,which,num_cells;
   int itab,jtab;
   point_type vect,cell_dim[3];
-  char *symbols;
-  int num_so_far;
-  real dist,max_dist=-1;
-
-  num_atoms = cell->num_atoms;
+  real cutoff;
 
   /* primitive error checking */
   if( cell->dim <= 0 ){
@@ -138,91 +191,29 @@ void check_nn_contacts(cell_type *cell,detail_type *details)
     cell_dim[i].y = cell->atoms[jtab].loc.y-cell->atoms[itab].loc.y;
     cell_dim[i].z = cell->atoms[jtab].loc.z-cell->atoms[itab].loc.z;
   }
+  for(;i<3;i++) cell_dim[i].x = cell_dim[i].y = cell_dim[i].z = 0.0;
+
+  cutoff = details->close_nn_contact > TOO_SHORT ? details->close_nn_contact : TOO_SHORT;
+  neighbors = get_neighbor_list(cell,cutoff);
 
   /*******
 
     now do the nearest neighbor cells
 
   *******/
-
-  /* 1 0 0 */
-  vect.x = cell_dim[0].x; vect.y = cell_dim[0].y; vect.z = cell_dim[0].z;
-  check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(1 0 0)");
-
-  if( cell->dim != 1 ){
-    /* 1 1 0 */
-    vect.x = cell_dim[0].x + cell_dim[1].x;
-    vect.y = cell_dim[0].y + cell_dim[1].y;
-    vect.z = cell_dim[0].z + cell_dim[1].z;
-    check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(1 1 0)");
-
-    /* 0 1 0 */
-    vect.x = cell_dim[1].x;
-    vect.y = cell_dim[1].y;
-    vect.z = cell_dim[1].z;
-    check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(0 1 0)");
-
-    /* -1 1 0 */
-    vect.x = -cell_dim[0].x + cell_dim[1].x;
-    vect.y = -cell_dim[0].y + cell_dim[1].y;
-    vect.z = -cell_dim[0].z + cell_dim[1].z;
-    check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(-1 1 0)");
-
-    if( cell->dim != 2 ){
-      /* 0 0 1 */
-      vect.x = cell_dim[2].x;
-      vect.y = cell_dim[2].y;
-      vect.z = cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(0 0 1)");
-
-      /* 1 1 1 */
-      vect.x = cell_dim[0].x + cell_dim[1].x + cell_dim[2].x;
-      vect.y = cell_dim[0].y + cell_dim[1].y + cell_dim[2].y;
-      vect.z = cell_dim[0].z + cell_dim[1].z + cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(1 1 1)");
-
-      /* 0 1 1 */
-      vect.x = cell_dim[1].x + cell_dim[2].x;
-      vect.y = cell_dim[1].y + cell_dim[2].y;
-      vect.z = cell_dim[1].z + cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(0 1 1)");
-
-      /* -1 1 1 */
-      vect.x = -cell_dim[0].x + cell_dim[1].x + cell_dim[2].x;
-      vect.y = -cell_dim[0].y + cell_dim[1].y + cell_dim[2].y;
-      vect.z = -cell_dim[0].z + cell_dim[1].z + cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(-1 1 1)");
-
-      /* 1 0 1 */
-      vect.x = cell_dim[0].x + cell_dim[2].x;
-      vect.y = cell_dim[0].y + cell_dim[2].y;
-      vect.z = cell_dim[0].z + cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(1 0 1)");
-
-      /* -1 0 1 */
-      vect.x = -cell_dim[0].x + cell_dim[2].x;
-      vect.y = -cell_dim[0].y + cell_dim[2].y;
-      vect.z = -cell_dim[0].z + cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(-1 0 1)");
-
-      /* 1 -1 1 */
-      vect.x = cell_dim[0].x - cell_dim[1].x + cell_dim[2].x;
-      vect.y = cell_dim[0].y - cell_dim[1].y + cell_dim[2].y;
-      vect.z = cell_dim[0].z - cell_dim[1].z + cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(1 -1 1)");
-
-      /* 0 -1 1 */
-      vect.x = -cell_dim[1].x + cell_dim[2].x;
-      vect.y = -cell_dim[1].y + cell_dim[2].y;
-      vect.z = -cell_dim[1].z + cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(0 -1 1)");
-
-      /* -1 -1 1 */
-      vect.x = -cell_dim[0].x - cell_dim[1].x + cell_dim[2].x;
-      vect.y = -cell_dim[0].y - cell_dim[1].y + cell_dim[2].y;
-      vect.z = -cell_dim[0].z - cell_dim[1].z + cell_dim[2].z;
-      check_a_cell(cell->atoms,vect,num_atoms,details->close_nn_contact,"(-1 -1 1)");
-    }
+  switch(cell->dim){
+  case 1: num_cells = 1; break;
+  case 2: num_cells = 4; break;
+  default: num_cells = 13; break;
+  }
+  for(which=0;which<num_cells;which++){
+    vect.x = nn_cells[which][0]*cell_dim[0].x + nn_cells[which][1]*cell_dim[1].x +
+      nn_cells[which][2]*cell_dim[2].x;
+    vect.y = nn_cells[which][0]*cell_dim[0].y + nn_cells[which][1]*cell_dim[1].y +
+      nn_cells[which][2]*cell_dim[2].y;
+    vect.z = nn_cells[which][0]*cell_dim[0].z + nn_cells[which][1]*cell_dim[1].z +
+      nn_cells[which][2]*cell_dim[2].z;
+    check_a_cell(cell,neighbors,vect,details->close_nn_contact,nn_cell_names[which]);
   }
 }
 
@@ -238,68 +229,88 @@ void check_nn_contacts(cell_type *cell,detail_type *details)
 * Returns: none
 *
 * Action:
-*     generates the distance matrix for the unit cell.
+*     checks the distances between the atoms in the unit cell and, if
+*     it's going to be printed, generates the distance matrix.
 *
 *  see the file notes.outl for the representation of symmetric matrices.
 *
+*  Only the neighbor list is needed to find short distances, so the
+*   full matrix (which is N^2/2 long) is only built for printing.
+*
 *****************************************************************************/
 void build_distance_matrix(cell_type *cell,detail_type *details)
 {
+  neighbor_list_type *neighbors;
   int num_atoms;
   int i,j;
+  int pair,pair_end,image;
   point_type temp;
   char *symbols;
   int num_so_far;
-  real dist,max_dist=-1;
+  real dist,cutoff;
 
   num_atoms = cell->num_atoms;
 
-  /* space for the list of symbols */
-  symbols = (char *)calloc(num_atoms*4,sizeof(char));
-  if(!symbols) fatal("Can't get space for symbols");
-
   /********
-    get space for the distance matrix
-      (we only need half of the matrix, since it's symmetrical)
+    look for distances which are too short.  The neighbor list will
+    be used for the overlaps too, so build it big enough for them.
   ********/
-  if( !cell->distance_mat ){
-    cell->distance_mat = (real *)calloc((num_atoms*num_atoms)/2+num_atoms,
-                                         sizeof(real));
-    if(!cell->distance_mat) fatal("Can't allocate distance matrix.");
+  cutoff = details->rho > TOO_SHORT ? details->rho : TOO_SHORT;
+  if( cell->dim > 0 && details->distance_mat_PRT &&
+      details->close_nn_contact > cutoff ){
+    cutoff = details->close_nn_contact;
   }
-
-  num_so_far = 0;
+  neighbors = get_neighbor_list(cell,cutoff);
+  temp.x = temp.y = temp.z = 0.0;
+  image = find_neighbor_image(neighbors,temp);
   for(i=0;i<num_atoms;i++){
-    for(j=0;j<i;j++){
-      temp.x = cell->atoms[i].loc.x - cell->atoms[j].loc.x;
-      temp.y = cell->atoms[i].loc.y - cell->atoms[j].loc.y;
-      temp.z = cell->atoms[i].loc.z - cell->atoms[j].loc.z;
-
-      dist = sqrt(temp.x*temp.x + temp.y*temp.y + temp.z*temp.z);
-
-      cell->distance_mat[num_so_far++] = dist;
+    pair = neighbors->first[i*neighbors->num_images+image];
+    pair_end = neighbors->first[i*neighbors->num_images+image+1];
+    for(;pair<pair_end && neighbors->partner[pair] < i;pair++){
+      j = neighbors->partner[pair];
+      dist = atom_distance(cell,i,j);
 
       /* check to see if the distance is too short */
       if( dist < TOO_SHORT && cell->atoms[i].at_number > 0 && cell->atoms[j].at_number > 0){
         fprintf(stderr,"!!! Warning !!! Distance between atoms %d and %d (%f A) \
 is suspicious.\n",i+1,j+1,dist);
       }
-      if( dist > max_dist ) max_dist = dist;
+    }
+  }
+
+  if( details->distance_mat_PRT ){
+    /* space for the list of symbols */
+    symbols = (char *)calloc(num_atoms*4,sizeof(char));
+    if(!symbols) fatal("Can't get space for symbols");
 
+    /********
+      get space for the distance matrix
+      (we only need half of the matrix, since it's symmetrical)
+    ********/
+    if( !cell->distance_mat ){
+      cell->distance_mat = (real *)calloc((num_atoms*num_atoms)/2+num_atoms,
+                                           sizeof(real));
+      if(!cell->distance_mat) fatal("Can't allocate distance matrix.");
     }
 
-    /* put in the diagonal element */
-    cell->distance_mat[num_so_far++] = 0.0;
+    num_so_far = 0;
+    for(i=0;i<num_atoms;i++){
+      for(j=0;j<i;j++){
+        cell->distance_mat[num_so_far++] = atom_distance(cell,i,j);
+      }
 
-    /* copy the symbol into the list of symbols */
-    symbols[i*4] = cell->atoms[i].symb[0];
-    symbols[i*4+1] = cell->atoms[i].symb[1];
-    symbols[i*4+2] = 0;
-  }
+      /* put in the diagonal element */
+      cell->distance_mat[num_so_far++] = 0.0;
+
+      /* copy the symbol into the list of symbols */
+      symbols[i*4] = cell->atoms[i].symb[0];
+      symbols[i*4+1] = cell->atoms[i].symb[1];
+      symbols[i*4+2] = 0;
+    }
 
-  if( details->distance_mat_PRT ){
     print_sym_mat(cell->distance_mat,num_atoms,num_atoms,output_file,
                   "\n\n;****** DISTANCE MATRIX *********",symbols,details->line_width);
+    free(symbols);
 
     /* check close contacts to nearest neighbors */
     if( cell->dim > 0 ){
@@ -309,7 +320,6 @@ is suspicious.\n",i+1,j+1,dist);
 
     }
   }
-  free(symbols);
 
   if(details->dump_dist_mat) dump_distance_mats(cell,details);
 
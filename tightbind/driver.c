@@ -47,7 +47,11 @@ void set_details_defaults(detail_type *details)
   details->just_geom = 0;
   details->dump_overlap = 0;
   details->dump_hamil = 0;
+  details->dump_float = 0;
+  details->dump_compressed = 0;
   details->sparsify_value = 0.0;
+  details->memory_budget = 0.0;
+  details->mixed_precision = 0;
   details->Execution_Mode = FAT;
   details->the_const = THE_CONST;
   details->weighted_Hij = 1;
@@ -76,6 +80,9 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
   int zeta_converged,Hii_converged;
   real new_num_electrons;
   COOP_type *COOP_ptr;
+  char cache_hit;
+  point_type *gradients;
+  arena_mark_type grad_mark;
   int i;
 
   /********
@@ -83,12 +90,14 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
     allocate space for the various arrays that are going to be needed
 
   *********/
+  timer_start("allocate");
   allocate_matrices(unit_cell,details,&Hamil_R,&Overlap_R,
                     &Hamil_K,&Overlap_K,&cmplx_hamil,&cmplx_overlap,
                     &eigenset,&work1,&work2,
                     &work3,&cmplx_work,
                     &properties,&avg_prop_info,num_orbs,
                     &tot_overlaps,orbital_lookup_table,&orbital_ordering);
+  timer_stop("allocate");
 
   /******
 
@@ -107,6 +116,20 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
       fprintf(output_file,"%d \t %s\n",i+1,test_string);
     }
   }
+  /******
+
+    relax the geometry first, the rest of the calculation is then
+    done at the optimized geometry.
+
+  ******/
+  if( details->do_geom_opt ){
+    timer_start("geom_opt");
+    optimize_geometry(unit_cell,details,Overlap_R,Hamil_R,cmplx_hamil,cmplx_overlap,
+                      eigenset,work1,work2,work3,cmplx_work,&properties,
+                      num_orbs,tot_overlaps,orbital_lookup_table);
+    timer_stop("geom_opt");
+  }
+
   /**********
 
     now do the calculation (loop over walsh diagram points)
@@ -117,6 +140,9 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
   ***********/
   for( walsh_step=0; walsh_step<details->walsh_details.num_steps; walsh_step++){
 
+    /* steps finished before a restart are skipped */
+    if( checkpoint_skip_walsh_step(unit_cell,walsh_step) ) continue;
+
     /* open the file that will be used for band output (if we need one) */
     if(details->band_info){
       if( details->walsh_details.num_steps > 1 )
@@ -131,7 +157,7 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
       }
       else {
         if( band_file ) fclose(band_file);
-        band_file = fopen(temp_file_name,"w+");
+        band_file = checkpoint_fopen(temp_file_name,CHK_BAND);
       }
       if(!band_file)fatal("Can't open band results file!");
     }
@@ -151,7 +177,7 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
       }
       else {
         if(FMO_file) fclose(FMO_file);
-        FMO_file = fopen(temp_file_name,"w+");
+        FMO_file = checkpoint_fopen(temp_file_name,CHK_FMO);
       }
       if(!FMO_file)fatal("Can't open FMO results file!");
       /******
@@ -176,6 +202,8 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
                   &zeta_converged,RESET);
     }
 
+    results_begin_step(unit_cell,walsh_step);
+
     if( details->Execution_Mode != MOLECULAR ){
       display_lattice_parms(unit_cell);
     }
@@ -185,7 +213,9 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
       generate the distance_matrix
 
       ***********/
+    timer_start("distance_matrix");
     build_distance_matrix(unit_cell,details);
+    timer_stop("distance_matrix");
 
 
     /* check to see if any calculations are necessary */
@@ -200,17 +230,43 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
         ***********/
       zeta_converged = 0;
       Hii_converged = 0;
+      checkpoint_restore_cycle(unit_cell);
       while( !zeta_converged || !Hii_converged ){
+        /* the scratch space from the last cycle can be reused */
+        arena_reset(&cycle_arena);
+
+        /* maybe this cycle has been done before (see result_cache.c) */
+        cache_hit = result_cache_fetch(unit_cell,details,num_orbs,tot_overlaps,
+                                       Overlap_R,Hamil_R,Overlap_K,avg_prop_info);
+
         /*************
 
           if we evaluate all of the overlaps once, then do it now...
 
           **************/
-        if( (details->Execution_Mode == FAT && details->store_R_overlaps ) ||
+        if( cache_hit ){
+          /* the matrices came out of the cache along with the k point results */
+          mark_overlaps_current(unit_cell,details,details->store_R_overlaps ?
+                                Overlap_R.mat : Overlap_K.mat);
+          reset_overlap_factors(details);
+        }
+        else if( (details->Execution_Mode == FAT && details->store_R_overlaps ) ||
           details->Execution_Mode == MOLECULAR ){
-          /* build the R space overlap matrix */
-          R_space_overlap_matrix(unit_cell,details,Overlap_R,num_orbs,
-                                tot_overlaps,orbital_lookup_table,0);
+          /******
+            build the R space overlap matrix, unless the basis hasn't
+            changed since the last cycle (i.e. we're doing charge
+            iteration and only the Hii's are different).
+          ******/
+          if( overlaps_are_current(unit_cell,details,Overlap_R.mat) ){
+            fprintf(status_file,"Basis is unchanged, reusing the overlap matrices.\n");
+          } else{
+            timer_start("overlap");
+            R_space_overlap_matrix(unit_cell,details,Overlap_R,num_orbs,
+                                  tot_overlaps,orbital_lookup_table,0);
+            timer_stop("overlap");
+            mark_overlaps_current(unit_cell,details,Overlap_R.mat);
+            reset_overlap_factors(details);
+          }
 
           /***********
 
@@ -229,6 +285,7 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
               it's built differently here when we are doing an extended system.
 
               *******/
+            timer_start("FMO");
             full_R_space_Hamiltonian(unit_cell,details,Overlap_R,Hamil_R,num_orbs,
                                     orbital_lookup_table,1);
 
@@ -239,36 +296,57 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
                             orbital_lookup_table);
 
             /* now diagonalize them */
-            diagonalize_FMO(details,work1,work2,work3,cmplx_hamil,cmplx_overlap,cmplx_work);
+            diagonalize_FMO(details,0,work1,work2,work3,cmplx_hamil,cmplx_overlap,
+                            cmplx_work);
 
             /* generate the transform matrices */
             gen_FMO_tform_matrices(details);
+            timer_stop("FMO");
           }
           /* build the real hamiltonian */
+          timer_start("hamiltonian");
           full_R_space_Hamiltonian(unit_cell,details,Overlap_R,Hamil_R,
                                   num_orbs,orbital_lookup_table,0);
+          timer_stop("hamiltonian");
 
 
         }
         else if( details->Execution_Mode == FAT &&
                 !details->store_R_overlaps ){
-          fprintf(stderr,"Storing S(k) instead of S(R)\n");
-          fprintf(status_file,
-                  "Storing the %d S(k)'s instead of the %d S(R)'s to save memory.\n",
-                  details->num_KPOINTS,tot_overlaps);
-
-          build_all_K_overlaps(unit_cell,details,Overlap_R,Overlap_K,
-                              num_orbs,tot_overlaps,orbital_lookup_table);
+          if( overlaps_are_current(unit_cell,details,Overlap_K.mat) ){
+            fprintf(status_file,"Basis is unchanged, reusing the stored S(k)'s.\n");
+          } else{
+            fprintf(stderr,"Storing S(k) instead of S(R)\n");
+            fprintf(status_file,
+                    "Storing the %d S(k)'s instead of the %d S(R)'s to save memory.\n",
+                    details->num_KPOINTS,tot_overlaps);
+
+            timer_start("overlap");
+            build_all_K_overlaps(unit_cell,details,Overlap_R,Overlap_K,
+                                num_orbs,tot_overlaps,orbital_lookup_table);
+            timer_stop("overlap");
+            mark_overlaps_current(unit_cell,details,Overlap_K.mat);
+            reset_overlap_factors(details);
+          }
 
           /* build the real hamiltonian */
+          timer_start("hamiltonian");
           full_R_space_Hamiltonian(unit_cell,details,Overlap_R,Hamil_R,
                                   num_orbs,orbital_lookup_table,0);
+          timer_stop("hamiltonian");
 
         }
         else if( details->Execution_Mode == THIN ){
+          /* the S(k)'s are rebuilt at each k point, but their factors can be kept */
+          if( !overlaps_are_current(unit_cell,details,Overlap_R.mat) ){
+            mark_overlaps_current(unit_cell,details,Overlap_R.mat);
+            reset_overlap_factors(details);
+          }
           /* just find the diagonal elements now... */
+          timer_start("hamiltonian");
           R_space_Hamiltonian(unit_cell,details,Overlap_R,Hamil_R,num_orbs,
                               orbital_lookup_table);
+          timer_stop("hamiltonian");
         }
 
         /***********
@@ -281,11 +359,17 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
           work3 has the reduced overlap matrix.
 
           ************/
-        loop_over_k_points(unit_cell,details,Overlap_R,Hamil_R,Overlap_K,
-                          Hamil_K,cmplx_hamil,cmplx_overlap,
-                          eigenset,work1,work2,work3,cmplx_work,
-                          &properties,
-                          avg_prop_info,num_orbs,orbital_lookup_table);
+        if( !cache_hit ){
+          timer_start("k_points");
+          loop_over_k_points(unit_cell,details,Overlap_R,Hamil_R,Overlap_K,
+                            Hamil_K,cmplx_hamil,cmplx_overlap,
+                            eigenset,work1,work2,work3,cmplx_work,
+                            &properties,
+                            avg_prop_info,num_orbs,orbital_lookup_table);
+          timer_stop("k_points");
+          result_cache_store(unit_cell,details,num_orbs,tot_overlaps,
+                             Overlap_R,Hamil_R,Overlap_K,avg_prop_info);
+        }
 
 
         if( !details->just_matrices ){
@@ -298,6 +382,7 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
           function) with the orbital occupation numbers.
           *******/
           if( details->Execution_Mode == MOLECULAR && details->eval_electrostat ){
+            timer_start("electrostatics");
             eval_electrostatics(unit_cell,num_orbs,eigenset,work2,
                                 properties.OP_mat,
                                 orbital_lookup_table,&electrostatic_term,
@@ -312,15 +397,36 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
                     electrostatic_term);
             fprintf(output_file,"\t                   Total Energy: %lg eV\n",
                     total_energy);
+            /* this replaces the one-electron total energy for readers */
+            results_set_kpoint(0);
+            results_write_mat("total_energy",1,1,&total_energy);
+            results_set_kpoint(-1);
 
-            fprintf(stderr,"%lg %lg %lg %lg\n", unit_cell->distance_mat[1],
+            fprintf(stderr,"%lg %lg %lg %lg\n", atom_distance(unit_cell,1,0),
                     eHMO_term,electrostatic_term,total_energy);
+            timer_stop("electrostatics");
+          }
+
+          /*********
+          the forces on the atoms (work2 still has the occupations)
+          *********/
+          if( details->Execution_Mode == MOLECULAR && details->gradients ){
+            timer_start("gradients");
+            grad_mark = arena_mark(&cycle_arena);
+            gradients = (point_type *)arena_calloc(&cycle_arena,unit_cell->num_atoms,
+                                                   sizeof(point_type));
+            eval_gradients(unit_cell,details,num_orbs,eigenset,work2,
+                           orbital_lookup_table,gradients);
+            report_forces(unit_cell,gradients);
+            arena_release(&cycle_arena,grad_mark);
+            timer_stop("gradients");
           }
 
           /*********
           do the average properties calculations
           *********/
           if( details->avg_props ){
+            timer_start("avg_props");
             sort_avg_prop_info(details,num_orbs,avg_prop_info,orbital_ordering);
 
             find_crystal_occupations(details,unit_cell->num_electrons,num_orbs,
@@ -400,6 +506,7 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
   #endif
               /* Density of States */
               if( !details->no_total_DOS_PRT || !details->just_avgE ){
+                timer_start("DOS");
                 gen_total_DOS(details,unit_cell,num_orbs,avg_prop_info,orbital_ordering);
 
                 /* Projected Density of States */
@@ -408,11 +515,14 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
                                     orbital_ordering,orbital_lookup_table);
                 }
                 fprintf(output_file,"# END OF DOS\n\n");
+                timer_stop("DOS");
               }
               /* check to see if we need to do a COOP */
               if( details->the_COOPS ){
+                timer_start("COOP");
                 gen_COOP(details,unit_cell,num_orbs,avg_prop_info,Overlap_R,
                         orbital_ordering,orbital_lookup_table);
+                timer_stop("COOP");
               }
 
               /*************
@@ -429,6 +539,7 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
               fprintf(output_file,";      in the unit cell (%lf electrons total)\n",
                       unit_cell->num_electrons*(real)details->num_KPOINTS);
               fprintf(output_file,"#Fermi_Energy:  %lf\n",properties.Fermi_E);
+              results_write_mat("Fermi_energy",1,1,&properties.Fermi_E);
 
               /* print the moments if we generated them */
               if( details->do_moments && details->moments ){
@@ -569,6 +680,7 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
                 }
               } /* end of if(!details->just_avgE) */
             } /* end of if(Hii_converged && zeta_converged) */
+            timer_stop("avg_props");
           } /* end of if(details->avg_props) */
           else{
             /* we need to set convergence stuff here */
@@ -580,6 +692,11 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
           Hii_converged = 1;
           zeta_converged = 1;
         }
+
+        /* a restart can pick up from the next cycle */
+        if( !zeta_converged || !Hii_converged ){
+          checkpoint_write(details,unit_cell,num_orbs,CHK_CYCLE,0,avg_prop_info);
+        }
       }/* end of convergence loop */
 
       /*********
@@ -587,11 +704,13 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
         if so deal with it.
         **********/
       if( details->band_info ){
+        timer_start("band_structure");
         construct_band_structure(unit_cell,details,Overlap_R,
                                 Hamil_R,Overlap_K,
                                 Hamil_K,cmplx_hamil,cmplx_overlap,
                                 eigenset,work1,work2,work3,cmplx_work,
                                 num_orbs,orbital_lookup_table);
+        timer_stop("band_structure");
 
       }
     }
@@ -608,6 +727,11 @@ void inner_wrapper(char *file_name, bool use_stdin_stdout){
                     properties,orbital_lookup_table,walsh_step);
       }
     }
+
+    /* a restart can pick up from the next step */
+    if( walsh_step < details->walsh_details.num_steps-1 ){
+      checkpoint_write(details,unit_cell,num_orbs,CHK_WALSH_STEP,0,avg_prop_info);
+    }
   }
 }
 
@@ -621,6 +745,7 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
   real new_num_electrons;
   COOP_type *COOP_ptr;
   int i;
+  char restarting=0;
 
   /************
 
@@ -632,6 +757,10 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
   details = (detail_type *)calloc(1,sizeof(detail_type));
   if(!unit_cell || !details) fatal("Can't allocate initial memory.");
 
+  /* start timing (this can be turned off in the input file) */
+  reset_timers();
+  timer_start("total");
+
   if (!use_stdin_stdout) {
     /* check to see if we can open the input file */
     temp_file = fopen(file_name,"r");
@@ -640,6 +769,9 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
       fatal(err_string);
     }
     fclose(temp_file);
+
+    /* this has to happen before any of the output files are opened */
+    restarting = checkpoint_init(file_name);
   }
 
   // If we are using stdin and stdout, then write all status to stdout
@@ -650,7 +782,8 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
     /* open the file that will be used to dump progress reports */
     strcpy(temp_file_name,file_name);
     strcat(temp_file_name,".status");
-    status_file = fopen(temp_file_name,"w+");
+    /* a restarted run adds to the status file it had */
+    status_file = fopen(temp_file_name,restarting ? "a+" : "w+");
   }
   if(!status_file)fatal("Can't open status file!");
 
@@ -662,7 +795,7 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
     /* open the file that will be used for results */
     strcpy(temp_file_name,file_name);
     strcat(temp_file_name,".out");
-    output_file = fopen(temp_file_name,"w+");
+    output_file = checkpoint_fopen(temp_file_name,CHK_OUT);
   }
 
   if(!output_file)fatal("Can't open results file!");
@@ -681,7 +814,12 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
     read in the data
 
   *********/
+  timer_start("parse");
   read_inputfile(unit_cell,details,file_name,&num_orbs,&orbital_lookup_table,the_file,parm_file_name);
+  timer_stop("parse");
+
+  /* worker jobs always hand back the binary results */
+  if( force_binary_results ) details->binary_results = 1;
 
   /* copy the file name into the details structure */
   strcpy(details->filename,file_name);
@@ -697,7 +835,7 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
       /* open the file that will be used for results */
       strcpy(temp_file_name,file_name);
       strcat(temp_file_name,".walsh");
-      walsh_file = fopen(temp_file_name,"w+");
+      walsh_file = checkpoint_fopen(temp_file_name,CHK_WALSH);
     }
     if(!walsh_file)fatal("Can't open Walsh results file!");
   }
@@ -709,6 +847,7 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
       are present throughout the distortion.
 
   **********/
+  timer_start("symmetry");
   if(details->walsh_details.num_vars != 0){
     walsh_update(unit_cell,details,0,0);
     find_walsh_sym_ops(unit_cell,details);
@@ -721,6 +860,7 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
 
     if(details->use_symmetry) find_sym_ops(details,unit_cell);
   }
+  timer_stop("symmetry");
 
   /*****
     if we are using automagic k-points, at this point
@@ -732,7 +872,9 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
   if(details->use_automatic_kpoints){
     if(details->walsh_details.num_vars != 0 ) walsh_update(unit_cell,details,0,0);
 
+    timer_start("k_point_setup");
     automagic_k_points(details,unit_cell);
+    timer_stop("k_point_setup");
   }
 
   /*********
@@ -743,9 +885,29 @@ void run_bind(char *file_name, bool use_stdin_stdout, char *parm_file_name ){
   *********/
   check_for_errors(unit_cell,details,num_orbs);
 
+  /* open the binary results file (if we need one) */
+  if( details->binary_results ){
+    if( use_stdin_stdout ){
+      error("Binary results can't be written when using stdin and stdout.");
+    } else{
+      results_open_file(details,unit_cell,num_orbs,file_name);
+    }
+  }
+
+  /* turn on checkpointing and pick up the state of a restarted run */
+  checkpoint_setup(details,unit_cell,num_orbs);
+
   inner_wrapper(file_name,use_stdin_stdout);
+  checkpoint_finish();
+  results_close_file();
+  report_memory_usage(status_file);
+  report_result_cache(status_file);
+  report_precision_errors(status_file);
   cleanup_memory();
 
+  timer_stop("total");
+  report_timers(status_file);
+
   fprintf(status_file,"Done!\n");
   fprintf(stdout,"Done!\n");
 
@@ -773,6 +935,9 @@ void run_eht(FILE *outstream ){
   status_file = outstream;
   output_file = outstream;
 
+  /* the timing block would end up mixed in with the results */
+  timers_off();
+
   fprintf(output_file,"#BIND_OUTPUT version: %s\n\n",VERSION_STRING);
 	fprintf(output_file,"#Author: Greg Landrum\n");
 	fprintf(output_file,"#Extensions made by Wingfield Glassey.\n");
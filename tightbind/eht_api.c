@@ -0,0 +1,1165 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the library interface described in eht_api.h.
+*
+*   An eht_system just holds copies of what the caller gave it.  When
+*    it's run the global unit_cell and details structures are built
+*    from those (the way read_inputfile would build them), run_eht does
+*    the calculation with the output going nowhere, and the chunks that
+*    would have gone into the binary results file (see results.c) are
+*    collected in memory.  The globals are then freed and the results
+*    are read back out of those chunks when the caller asks for them.
+*
+*   Matrices (like the ROP's) aren't printed into the (discarded) output
+*    during the run, so there's no formatting cost for them.
+*
+*****************************************************************************/
+
+#include "bind.h"
+#include "eht_api.h"
+
+#ifdef _WIN32
+#define NULL_DEVICE "NUL"
+#else
+#define NULL_DEVICE "/dev/null"
+#endif
+
+typedef struct eht_COOP_def eht_COOP;
+
+struct eht_COOP_def {
+  int which;
+  int atom1, atom2;
+  int cell[3];
+  eht_COOP *next;
+};
+
+struct eht_system_def {
+  int num_atoms;
+  char (*symbols)[ATOM_SYMB_LEN];
+  double *coords;
+
+  int dim;
+  double lattice[9];
+  int overlaps[3];
+
+  char charge_given;
+  double charge, electrons;
+
+  int num_kpoints;
+  double *kpoints;
+  int points_per_axis[3];
+
+  char use_symmetry;
+  char use_electrostatics;
+  char parm_file[MAX_STR_LEN];
+  int requested;
+  eht_COOP *COOPs;
+
+  /* what came out of the last run */
+  char have_results;
+  int num_orbs;
+  int num_kpoints_used;
+  double *kpoints_used;
+  results_list_type *results;
+
+  char error[MAX_STR_LEN];
+};
+
+
+/****************************************************************************
+*
+*                   Function api_error
+*
+* Arguments: sys: pointer to eht_system
+*            msg: pointer to char
+*
+* Returns: int
+*
+* Action: remembers 'msg as the last error for 'sys and returns -1.
+*
+*****************************************************************************/
+static int api_error(eht_system *sys,char *msg)
+{
+  if( sys ){
+    strncpy(sys->error,msg,MAX_STR_LEN-1);
+    sys->error[MAX_STR_LEN-1] = 0;
+  }
+  return -1;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure forget_results
+*
+* Arguments: sys: pointer to eht_system
+*
+* Returns: none
+*
+* Action: frees the results of the last run of 'sys (if there are any).
+*   This is done whenever the system is changed.
+*
+*****************************************************************************/
+static void forget_results(eht_system *sys)
+{
+  results_free_list(sys->results);
+  sys->results = 0;
+  if( sys->kpoints_used ) free(sys->kpoints_used);
+  sys->kpoints_used = 0;
+  sys->num_kpoints_used = 0;
+  sys->num_orbs = 0;
+  sys->have_results = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function eht_create
+*
+* Arguments: num_atoms: int
+*              symbols: pointer to pointers to char
+*               coords: pointer to double
+*                  dim: int
+*              lattice: pointer to double
+*
+* Returns: pointer to eht_system
+*
+* Action: makes a new system with 'num_atoms atoms.  'symbols has the
+*   atomic symbols, 'coords the Cartesian coordinates (3 per atom).
+*   For an extended system 'dim is the number of lattice vectors and
+*   'lattice holds them (3 numbers each); use 0 and NULL for a
+*   molecule.
+*
+*   The system starts out neutral, without symmetry, with 2 overlaps
+*    along each lattice direction and just the Gamma point.
+*
+*   Returns NULL if the arguments don't make sense or there's no memory.
+*
+*****************************************************************************/
+eht_system *eht_create(int num_atoms,const char *const *symbols,
+                       const double *coords,int dim,const double *lattice)
+{
+  eht_system *sys;
+  int i;
+
+  if( num_atoms <= 0 || !symbols || !coords ) return 0;
+  if( dim < 0 || dim > 3 || (dim && !lattice) ) return 0;
+
+  sys = (eht_system *)calloc(1,sizeof(eht_system));
+  if( !sys ) return 0;
+  sys->symbols = (char (*)[ATOM_SYMB_LEN])calloc(num_atoms,ATOM_SYMB_LEN);
+  sys->coords = (double *)malloc(3*num_atoms*sizeof(double));
+  if( !sys->symbols || !sys->coords ){
+    eht_destroy(sys);
+    return 0;
+  }
+
+  sys->num_atoms = num_atoms;
+  for(i=0;i<num_atoms;i++){
+    if( !symbols[i] ){
+      eht_destroy(sys);
+      return 0;
+    }
+    strncpy(sys->symbols[i],symbols[i],ATOM_SYMB_LEN-1);
+  }
+  memcpy(sys->coords,coords,3*num_atoms*sizeof(double));
+
+  sys->dim = dim;
+  if( dim ) memcpy(sys->lattice,lattice,3*dim*sizeof(double));
+  for(i=0;i<dim;i++) sys->overlaps[i] = 2;
+
+  sys->charge_given = 1;
+  sys->charge = 0.0;
+  return sys;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure eht_destroy
+*
+* Arguments: sys: pointer to eht_system
+*
+* Returns: none
+*
+* Action: frees 'sys and everything that goes with it.
+*
+*****************************************************************************/
+void eht_destroy(eht_system *sys)
+{
+  eht_COOP *COOP,*next;
+
+  if( !sys ) return;
+  forget_results(sys);
+  for(COOP=sys->COOPs;COOP;COOP=next){
+    next = COOP->next;
+    free(COOP);
+  }
+  if( sys->symbols ) free(sys->symbols);
+  if( sys->coords ) free(sys->coords);
+  if( sys->kpoints ) free(sys->kpoints);
+  free(sys);
+}
+
+
+/****************************************************************************
+*
+*                   Functions eht_set_charge, eht_set_electrons
+*
+* Arguments: sys: pointer to eht_system
+*   charge/electrons: double
+*
+* Returns: int
+*
+* Action: sets either the charge on the molecule (unit cell) or the
+*   number of valence electrons in it.  Whichever was set last is used.
+*
+*****************************************************************************/
+int eht_set_charge(eht_system *sys,double charge)
+{
+  if( !sys ) return -1;
+  forget_results(sys);
+  sys->charge_given = 1;
+  sys->charge = charge;
+  return 0;
+}
+
+int eht_set_electrons(eht_system *sys,double electrons)
+{
+  if( !sys ) return -1;
+  if( electrons < 0.0 ) return api_error(sys,"Negative number of electrons.");
+  forget_results(sys);
+  sys->charge_given = 0;
+  sys->electrons = electrons;
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function eht_set_overlaps
+*
+* Arguments: sys: pointer to eht_system
+*       overlaps: pointer to int
+*
+* Returns: int
+*
+* Action: sets the number of overlaps along each lattice direction
+*   ('overlaps has one entry for each).
+*
+*****************************************************************************/
+int eht_set_overlaps(eht_system *sys,const int *overlaps)
+{
+  int i;
+
+  if( !sys || !overlaps ) return -1;
+  if( !sys->dim ) return api_error(sys,"A molecule has no overlaps to set.");
+  for(i=0;i<sys->dim;i++){
+    if( overlaps[i] < 0 ) return api_error(sys,"Negative number of overlaps.");
+  }
+  forget_results(sys);
+  for(i=0;i<sys->dim;i++) sys->overlaps[i] = overlaps[i];
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Functions eht_set_kpoints, eht_set_kpoint_mesh
+*
+* Arguments: sys: pointer to eht_system
+*    num_kpoints: int
+*        kpoints: pointer to double
+*  points_per_axis: pointer to int
+*
+* Returns: int
+*
+* Action: sets the k points for an extended system.  Either 'num_kpoints
+*   points are given explicitly (4 numbers each: the position in
+*   fractions of the reciprocal lattice vectors and the weight), or
+*   an automatic mesh is generated with 'points_per_axis points along
+*   each reciprocal lattice vector (see the K Points Automatic keyword).
+*
+*****************************************************************************/
+int eht_set_kpoints(eht_system *sys,int num_kpoints,const double *kpoints)
+{
+  double *copy;
+
+  if( !sys ) return -1;
+  if( !sys->dim ) return api_error(sys,"A molecule has no k points to set.");
+  if( num_kpoints <= 0 || !kpoints ) return api_error(sys,"No k points given.");
+  copy = (double *)malloc(4*num_kpoints*sizeof(double));
+  if( !copy ) return api_error(sys,"Can't allocate memory for the k points.");
+  memcpy(copy,kpoints,4*num_kpoints*sizeof(double));
+
+  forget_results(sys);
+  if( sys->kpoints ) free(sys->kpoints);
+  sys->kpoints = copy;
+  sys->num_kpoints = num_kpoints;
+  bzero((char *)sys->points_per_axis,3*sizeof(int));
+  return 0;
+}
+
+int eht_set_kpoint_mesh(eht_system *sys,const int *points_per_axis)
+{
+  int i,num_points=0;
+
+  if( !sys || !points_per_axis ) return -1;
+  if( !sys->dim ) return api_error(sys,"A molecule has no k points to set.");
+  for(i=0;i<sys->dim;i++){
+    if( points_per_axis[i] < 0 ) return api_error(sys,"Bad k point mesh.");
+    num_points += points_per_axis[i];
+  }
+  if( !num_points ) return api_error(sys,"Bad k point mesh.");
+
+  forget_results(sys);
+  if( sys->kpoints ) free(sys->kpoints);
+  sys->kpoints = 0;
+  sys->num_kpoints = 0;
+  bzero((char *)sys->points_per_axis,3*sizeof(int));
+  for(i=0;i<sys->dim;i++) sys->points_per_axis[i] = points_per_axis[i];
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Functions eht_set_symmetry, eht_set_electrostatics,
+*                             eht_set_parameter_file
+*
+* Arguments: sys: pointer to eht_system
+*   use_symmetry: int
+* use_electrostatics: int
+*      file_name: pointer to char
+*
+* Returns: int
+*
+* Action: turn the use of symmetry on or off, turn the electrostatic
+*   term (the Electrostatics keyword, only for molecules) on or off,
+*   and set the atomic parameter file (NULL goes back to the default one).
+*
+*****************************************************************************/
+int eht_set_symmetry(eht_system *sys,int use_symmetry)
+{
+  if( !sys ) return -1;
+  forget_results(sys);
+  sys->use_symmetry = use_symmetry ? 1 : 0;
+  return 0;
+}
+
+int eht_set_electrostatics(eht_system *sys,int use_electrostatics)
+{
+  if( !sys ) return -1;
+  if( use_electrostatics && sys->dim )
+    return api_error(sys,"The electrostatic term is only available for molecules.");
+  forget_results(sys);
+  sys->use_electrostatics = use_electrostatics ? 1 : 0;
+  return 0;
+}
+
+int eht_set_parameter_file(eht_system *sys,const char *file_name)
+{
+  if( !sys ) return -1;
+  if( file_name && strlen(file_name) >= MAX_STR_LEN )
+    return api_error(sys,"Parameter file name is too long.");
+  forget_results(sys);
+  if( file_name ) strcpy(sys->parm_file,file_name);
+  else sys->parm_file[0] = 0;
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function eht_request
+*
+* Arguments: sys: pointer to eht_system
+*           what: int
+*
+* Returns: int
+*
+* Action: asks for the results which aren't evaluated by default
+*   (EHT_EIGENVECTORS, EHT_ROP and EHT_FORCES, or'ed together) to be
+*   made by the next run.  This replaces whatever was asked for before.
+*
+*   Forces are only available for molecules.
+*
+*****************************************************************************/
+int eht_request(eht_system *sys,int what)
+{
+  if( !sys ) return -1;
+  if( what & ~(EHT_EIGENVECTORS|EHT_ROP|EHT_FORCES) )
+    return api_error(sys,"Unknown result requested.");
+  if( (what & EHT_FORCES) && sys->dim )
+    return api_error(sys,"Forces are only available for molecules.");
+  forget_results(sys);
+  sys->requested = what;
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function eht_add_COOP
+*
+* Arguments: sys: pointer to eht_system
+*          which: int
+*    atom1,atom2: ints
+*           cell: pointer to int
+*
+* Returns: int
+*
+* Action: adds a COOP curve between 'atom1 (in the unit cell) and
+*   'atom2 (in the cell given by 'cell, NULL for the unit cell itself;
+*   only the first 'dim entries can be nonzero).
+*   COOP's added with the same 'which are averaged into one curve,
+*   which is fetched with eht_get_COOP.  Only for extended systems.
+*
+*****************************************************************************/
+int eht_add_COOP(eht_system *sys,int which,int atom1,int atom2,const int *cell)
+{
+  eht_COOP *COOP,*last;
+  int i;
+
+  if( !sys ) return -1;
+  if( !sys->dim ) return api_error(sys,"COOP's are only done for extended systems.");
+  if( atom1 < 0 || atom1 >= sys->num_atoms || atom2 < 0 || atom2 >= sys->num_atoms )
+    return api_error(sys,"Bad atom number in a COOP.");
+
+  for(i=sys->dim;i<3 && cell;i++){
+    if( cell[i] ) return api_error(sys,"COOP cell is outside the lattice.");
+  }
+
+  COOP = (eht_COOP *)calloc(1,sizeof(eht_COOP));
+  if( !COOP ) return api_error(sys,"Can't allocate memory for a COOP.");
+  COOP->which = which;
+  COOP->atom1 = atom1;
+  COOP->atom2 = atom2;
+  for(i=0;i<3 && cell;i++) COOP->cell[i] = cell[i];
+
+  forget_results(sys);
+  if( !sys->COOPs ) sys->COOPs = COOP;
+  else{
+    for(last=sys->COOPs;last->next;last=last->next);
+    last->next = COOP;
+  }
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure build_COOP_list
+*
+* Arguments: sys: pointer to eht_system
+*
+* Returns: none
+*
+* Action: puts the COOP's of 'sys into details->the_COOPS, organized
+*   the way the COOP keyword in the input file does it.
+*
+*****************************************************************************/
+static void build_COOP_list(eht_system *sys)
+{
+  eht_COOP *api_COOP;
+  COOP_type *new_COOP,*COOP_ptr;
+
+  for(api_COOP=sys->COOPs;api_COOP;api_COOP=api_COOP->next){
+    new_COOP = (COOP_type *)calloc(1,sizeof(COOP_type));
+    if( !new_COOP ) fatal("Can't get space for a COOP.");
+    new_COOP->type = P_DOS_ATOM;
+    new_COOP->energy_weight = FALSE;
+    new_COOP->which = api_COOP->which;
+    new_COOP->contrib1 = api_COOP->atom1;
+    new_COOP->contrib2 = api_COOP->atom2;
+    new_COOP->cell.x = api_COOP->cell[0];
+    new_COOP->cell.y = api_COOP->cell[1];
+    new_COOP->cell.z = api_COOP->cell[2];
+
+    for(COOP_ptr=details->the_COOPS;COOP_ptr;COOP_ptr=COOP_ptr->next_type){
+      if( COOP_ptr->which == new_COOP->which ){
+        new_COOP->next_to_avg = COOP_ptr->next_to_avg;
+        COOP_ptr->next_to_avg = new_COOP;
+        break;
+      }
+    }
+    if( !COOP_ptr ){
+      if( !details->the_COOPS ) details->the_COOPS = new_COOP;
+      else{
+        for(COOP_ptr=details->the_COOPS;COOP_ptr->next_type;
+            COOP_ptr=COOP_ptr->next_type);
+        COOP_ptr->next_type = new_COOP;
+      }
+    }
+  }
+}
+
+
+/****************************************************************************
+*
+*                   Procedure free_COOP_list
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: frees the COOP's made by build_COOP_list.
+*
+*****************************************************************************/
+static void free_COOP_list()
+{
+  COOP_type *type_ptr,*next_type,*avg_ptr,*next_avg;
+
+  for(type_ptr=details->the_COOPS;type_ptr;type_ptr=next_type){
+    next_type = type_ptr->next_type;
+    for(avg_ptr=type_ptr;avg_ptr;avg_ptr=next_avg){
+      next_avg = avg_ptr->next_to_avg;
+      free(avg_ptr);
+    }
+  }
+  details->the_COOPS = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function check_symbols
+*
+* Arguments: sys: pointer to eht_system
+*
+* Returns: int
+*
+* Action: makes sure there are parameters for all the atoms in 'sys
+*   (fill_atomic_parms would stop the program if there weren't).
+*
+*****************************************************************************/
+static int check_symbols(eht_system *sys)
+{
+  parm_table_type *parm_table;
+  char symb[ATOM_SYMB_LEN];
+  char err_string[MAX_STR_LEN];
+  int i;
+
+  parm_table = shared_parm_table(sys->parm_file[0] ? sys->parm_file : 0);
+  for(i=0;i<sys->num_atoms;i++){
+    safe_strcpy(symb,sys->symbols[i]);
+    if( symb[0] == '&' ) continue;
+    upcase(symb);
+    if( symb[0] == '*' || !find_parm_entry(parm_table,symb) ){
+      sprintf(err_string,"No parameters for atom %d (%s).",i,sys->symbols[i]);
+      return api_error(sys,err_string);
+    }
+  }
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure setup_globals
+*
+* Arguments: sys: pointer to eht_system
+*
+* Returns: none
+*
+* Action: builds unit_cell, details, num_orbs and the
+*   orbital_lookup_table from 'sys.
+*
+*****************************************************************************/
+static void setup_globals(eht_system *sys)
+{
+  atom_type *atom;
+  int i;
+
+  unit_cell = (cell_type *)calloc(1,sizeof(cell_type));
+  details = (detail_type *)calloc(1,sizeof(detail_type));
+  if(!unit_cell || !details) fatal("Can't allocate initial memory.");
+  set_details_defaults(details);
+  set_cell_defaults(unit_cell);
+  safe_strcpy(details->title,"eht_api");
+  details->use_symmetry = sys->use_symmetry;
+  details->eval_electrostat = sys->use_electrostatics;
+
+  /* the atoms, followed by the ends of the lattice vectors */
+  unit_cell->atoms = (atom_type *)calloc(sys->num_atoms+sys->dim,sizeof(atom_type));
+  if( !unit_cell->atoms ) fatal("Can't allocate memory for the atoms.");
+  for(i=0;i<sys->num_atoms;i++){
+    atom = &(unit_cell->atoms[i]);
+    safe_strcpy(atom->symb,sys->symbols[i]);
+    atom->symb[2] = 0;
+    atom->loc.x = sys->coords[3*i];
+    atom->loc.y = sys->coords[3*i+1];
+    atom->loc.z = sys->coords[3*i+2];
+    atom->which_atom = i;
+  }
+  for(i=0;i<sys->dim;i++){
+    atom = &(unit_cell->atoms[sys->num_atoms+i]);
+    safe_strcpy(atom->symb,"&");
+    atom->loc.x = sys->coords[0]+sys->lattice[3*i];
+    atom->loc.y = sys->coords[1]+sys->lattice[3*i+1];
+    atom->loc.z = sys->coords[2]+sys->lattice[3*i+2];
+    atom->which_atom = sys->num_atoms+i;
+    unit_cell->tvects[i].begin = 0;
+    unit_cell->tvects[i].end = sys->num_atoms+i;
+    unit_cell->overlaps[i] = sys->overlaps[i];
+  }
+  unit_cell->num_atoms = sys->num_atoms;
+  unit_cell->num_raw_atoms = sys->num_atoms;
+  unit_cell->dim = sys->dim;
+
+  if( !sys->dim ){
+    details->Execution_Mode = MOLECULAR;
+    details->num_KPOINTS = 1;
+    details->K_POINTS = (k_point_type *)calloc(1,sizeof(k_point_type));
+    if( !details->K_POINTS ) fatal("Can't allocate the single k point.");
+    details->K_POINTS[0].weight = 1.0;
+    details->net_chg_PRT = 1;
+    if( sys->requested & EHT_ROP ) details->ROP_mat_PRT = 1;
+    if( sys->requested & EHT_FORCES ) details->gradients = 1;
+  } else{
+    details->Execution_Mode = FAT;
+    details->avg_props = 1;
+    if( sys->requested & EHT_ROP ) details->avg_ROP_mat_PRT = 1;
+    if( sys->points_per_axis[0] || sys->points_per_axis[1] ||
+        sys->points_per_axis[2] ){
+      details->use_automatic_kpoints = 1;
+      for(i=0;i<3;i++) details->points_per_axis[i] = sys->points_per_axis[i];
+    } else{
+      details->num_KPOINTS = sys->kpoints ? sys->num_kpoints : 1;
+      details->K_POINTS = (k_point_type *)calloc(details->num_KPOINTS,
+                                                sizeof(k_point_type));
+      if( !details->K_POINTS ) fatal("Can't allocate memory for k point set.");
+      if( sys->kpoints ){
+        for(i=0;i<details->num_KPOINTS;i++){
+          details->K_POINTS[i].loc.x = sys->kpoints[4*i];
+          details->K_POINTS[i].loc.y = sys->kpoints[4*i+1];
+          details->K_POINTS[i].loc.z = sys->kpoints[4*i+2];
+          details->K_POINTS[i].weight = sys->kpoints[4*i+3];
+        }
+      } else{
+        details->K_POINTS[0].weight = 1.0;
+      }
+    }
+    build_COOP_list(sys);
+  }
+  if( sys->requested & EHT_EIGENVECTORS ) details->wave_fn_PRT = 1;
+
+  fill_atomic_parms(unit_cell->atoms,unit_cell->num_atoms,0,
+                    sys->parm_file[0] ? sys->parm_file : 0);
+  if( sys->charge_given ){
+    unit_cell->charge = sys->charge;
+    charge_to_num_electrons(unit_cell);
+  } else{
+    unit_cell->num_electrons = sys->electrons;
+  }
+
+  build_orbital_lookup_table(unit_cell,&num_orbs,&orbital_lookup_table);
+}
+
+
+/****************************************************************************
+*
+*                   Procedure finish_run
+*
+* Arguments: null_file: pointer to FILE
+*   old_print_text_mats: bool
+*
+* Returns: none
+*
+* Action: frees the globals set up for a run and puts back what
+*   eht_run changed.
+*
+*   This is also used to clean up after a run which was stopped by a
+*    fatal error, so the globals may only have been partly set up.
+*
+*****************************************************************************/
+static void finish_run(FILE *null_file,bool old_print_text_mats)
+{
+  if( unit_cell && details ){
+    free_COOP_list();
+    cleanup_memory();
+  } else{
+    if( unit_cell ) free(unit_cell);
+    if( details ) free(details);
+  }
+  unit_cell = 0;
+  details = 0;
+
+  print_text_mats = old_print_text_mats;
+  status_file = 0;
+  output_file = 0;
+  fclose(null_file);
+}
+
+
+/****************************************************************************
+*
+*                   Function eht_run
+*
+* Arguments: sys: pointer to eht_system
+*
+* Returns: int
+*
+* Action: does the calculation for 'sys.  Any results from an earlier
+*   run are thrown away first.
+*
+*   fatal errors during the run don't stop the program: they land back
+*    here, whatever the run left in the globals is freed, and -1 is
+*    returned with the message in the error for 'sys.
+*
+*****************************************************************************/
+int eht_run(eht_system *sys)
+{
+  FILE *null_file;
+  bool old_print_text_mats;
+  jmp_buf trap;
+  int i;
+
+  if( !sys ) return -1;
+  forget_results(sys);
+  sys->error[0] = 0;
+  if( check_symbols(sys) ) return -1;
+
+  null_file = fopen(NULL_DEVICE,"w");
+  if( !null_file ) null_file = tmpfile();
+  if( !null_file ) return api_error(sys,"Can't open the null device.");
+
+  old_print_text_mats = print_text_mats;
+  print_text_mats = false;
+  status_file = null_file;
+  output_file = null_file;
+
+  fatal_trap = &trap;
+  if( setjmp(trap) ){
+    fatal_trap = 0;
+    sys->results = results_end_capture();
+    forget_results(sys);
+    /* the run was abandoned part way through whatever it was doing */
+    set_mem_tag(MEM_MISC);
+    reset_timers();
+    finish_run(null_file,old_print_text_mats);
+    return api_error(sys,fatal_message);
+  }
+
+  setup_globals(sys);
+  results_start_capture();
+  run_eht(null_file);
+  sys->results = results_end_capture();
+
+  /* remember what's needed to make sense of the results */
+  sys->num_orbs = num_orbs;
+  sys->num_kpoints_used = details->num_KPOINTS;
+  sys->kpoints_used = (double *)malloc(4*details->num_KPOINTS*sizeof(double));
+  if( !sys->kpoints_used ) fatal("Can't allocate memory for the k points.");
+  for(i=0;i<details->num_KPOINTS;i++){
+    sys->kpoints_used[4*i] = details->K_POINTS[i].loc.x;
+    sys->kpoints_used[4*i+1] = details->K_POINTS[i].loc.y;
+    sys->kpoints_used[4*i+2] = details->K_POINTS[i].loc.z;
+    sys->kpoints_used[4*i+3] = details->K_POINTS[i].weight;
+  }
+  sys->have_results = 1;
+
+  fatal_trap = 0;
+  finish_run(null_file,old_print_text_mats);
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function eht_last_error
+*
+* Arguments: sys: pointer to eht_system
+*
+* Returns: pointer to char
+*
+* Action: returns a description of the last thing that went wrong
+*   with 'sys (an empty string if nothing has).
+*
+*****************************************************************************/
+const char *eht_last_error(eht_system *sys)
+{
+  if( !sys ) return "No system.";
+  return sys->error;
+}
+
+
+/****************************************************************************
+*
+*                   Function find_result
+*
+* Arguments: sys: pointer to eht_system
+*           name: pointer to char
+*   kpoint,index: ints
+*
+* Returns: pointer to results_list_type
+*
+* Action: finds a result of the last run of 'sys, setting the error
+*   if it's not there.
+*
+*****************************************************************************/
+static results_list_type *find_result(eht_system *sys,char *name,int kpoint,
+                                      int index)
+{
+  results_list_type *item;
+  char err_string[MAX_STR_LEN];
+
+  if( !sys->have_results ){
+    api_error(sys,"The system hasn't been run.");
+    return 0;
+  }
+  item = results_find(sys->results,name,kpoint,index);
+  if( !item ){
+    sprintf(err_string,"No %s results (were they requested?).",name);
+    api_error(sys,err_string);
+  }
+  return item;
+}
+
+
+/****************************************************************************
+*
+*                   Function copy_values
+*
+* Arguments: item: pointer to results_list_type
+*           first: int
+*          stride: int
+*             num: int
+*            dest: pointer to double
+*
+* Returns: none
+*
+* Action: copies 'num values, starting at 'first and 'stride apart, out
+*   of the chunk in 'item into 'dest.
+*
+*****************************************************************************/
+static void copy_values(results_list_type *item,int first,int stride,int num,
+                        double *dest)
+{
+  int i;
+
+  for(i=0;i<num;i++){
+    if( item->chunk.type == RESULTS_FLOAT )
+      dest[i] = ((float *)item->data)[first+i*stride];
+    else dest[i] = ((double *)item->data)[first+i*stride];
+  }
+}
+
+
+/****************************************************************************
+*
+*                   Functions eht_num_orbitals, eht_num_kpoints, eht_get_kpoints
+*
+* Arguments: sys: pointer to eht_system
+*        kpoints: pointer to double
+*
+* Returns: int
+*
+* Action: the number of orbitals and k points (1 for a molecule) in
+*   the last run, and the k points themselves (4 numbers each, as for
+*   eht_set_kpoints).
+*
+*****************************************************************************/
+int eht_num_orbitals(eht_system *sys)
+{
+  if( !sys ) return -1;
+  if( !sys->have_results ) return api_error(sys,"The system hasn't been run.");
+  return sys->num_orbs;
+}
+
+int eht_num_kpoints(eht_system *sys)
+{
+  if( !sys ) return -1;
+  if( !sys->have_results ) return api_error(sys,"The system hasn't been run.");
+  return sys->num_kpoints_used;
+}
+
+int eht_get_kpoints(eht_system *sys,double *kpoints)
+{
+  if( !sys || !kpoints ) return -1;
+  if( !sys->have_results ) return api_error(sys,"The system hasn't been run.");
+  memcpy(kpoints,sys->kpoints_used,4*sys->num_kpoints_used*sizeof(double));
+  return sys->num_kpoints_used;
+}
+
+
+/****************************************************************************
+*
+*                   Functions eht_get_energies, eht_get_occupations
+*
+* Arguments: sys: pointer to eht_system
+*         kpoint: int
+*   energies/occupations: pointer to double
+*
+* Returns: int
+*
+* Action: copies the orbital energies (eV, lowest first) at 'kpoint,
+*   or the occupations of the orbitals of a molecule, into the buffer,
+*   which needs room for eht_num_orbitals values.
+*
+*****************************************************************************/
+int eht_get_energies(eht_system *sys,int kpoint,double *energies)
+{
+  results_list_type *item;
+
+  if( !sys || !energies ) return -1;
+  item = find_result(sys,"energies",kpoint,-1);
+  if( !item ) return -1;
+  copy_values(item,0,1,item->chunk.num_elements,energies);
+  return item->chunk.num_elements;
+}
+
+int eht_get_occupations(eht_system *sys,int kpoint,double *occupations)
+{
+  results_list_type *item;
+
+  if( !sys || !occupations ) return -1;
+  if( sys->dim ) return api_error(sys,"Orbital occupations are only done for molecules.");
+  item = find_result(sys,"occupations",kpoint,-1);
+  if( !item ) return -1;
+  copy_values(item,0,1,item->chunk.num_elements,occupations);
+  return item->chunk.num_elements;
+}
+
+
+/****************************************************************************
+*
+*                   Function eht_get_eigenvectors
+*
+* Arguments: sys: pointer to eht_system
+*         kpoint: int
+*   real_part,imag_part: pointers to double
+*
+* Returns: int
+*
+* Action: copies the wavefunctions at 'kpoint into the buffers, each of
+*   which needs room for eht_num_orbitals squared values.  The
+*   coefficients of MO i are at i*num_orbs .. i*num_orbs+num_orbs-1.
+*   'imag_part can be NULL (it's all zeroes for a molecule).
+*
+*   This needs EHT_EIGENVECTORS to have been requested.
+*
+*****************************************************************************/
+int eht_get_eigenvectors(eht_system *sys,int kpoint,double *real_part,
+                         double *imag_part)
+{
+  results_list_type *item;
+  int num_elements;
+
+  if( !sys || !real_part ) return -1;
+  item = find_result(sys,"wavefunctions_real",kpoint,-1);
+  if( !item ) return -1;
+  num_elements = item->chunk.num_elements;
+  copy_values(item,0,1,num_elements,real_part);
+  if( imag_part ){
+    if( sys->dim ){
+      item = find_result(sys,"wavefunctions_imag",kpoint,-1);
+      if( !item ) return -1;
+      copy_values(item,0,1,num_elements,imag_part);
+    } else{
+      bzero((char *)imag_part,num_elements*sizeof(double));
+    }
+  }
+  return num_elements;
+}
+
+
+/****************************************************************************
+*
+*                   Functions eht_get_total_energy, eht_get_fermi_energy
+*
+* Arguments: sys: pointer to eht_system
+*         energy: pointer to double
+*
+* Returns: int
+*
+* Action: the total energy of a molecule (the average energy for an
+*   extended system) and the Fermi level of an extended system, in eV.
+*   The energy of a molecule includes the electrostatic term if that's
+*   turned on.
+*
+*****************************************************************************/
+int eht_get_total_energy(eht_system *sys,double *energy)
+{
+  results_list_type *item;
+
+  if( !sys || !energy ) return -1;
+  if( sys->dim ) item = find_result(sys,"average_energy",-1,-1);
+  else item = find_result(sys,"total_energy",0,-1);
+  if( !item ) return -1;
+  copy_values(item,0,1,1,energy);
+  return 0;
+}
+
+int eht_get_fermi_energy(eht_system *sys,double *energy)
+{
+  results_list_type *item;
+
+  if( !sys || !energy ) return -1;
+  if( !sys->dim ) return api_error(sys,"There is no Fermi level for a molecule.");
+  item = find_result(sys,"Fermi_energy",-1,-1);
+  if( !item ) return -1;
+  copy_values(item,0,1,1,energy);
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Functions eht_get_charges, eht_get_ROP
+*
+* Arguments: sys: pointer to eht_system
+*   charges/rop: pointer to double
+*
+* Returns: int
+*
+* Action: copies the net atomic charges (one per atom), or the reduced
+*   overlap populations (the full num_atoms x num_atoms symmetric
+*   matrix), into the buffer.  For extended systems these are averages
+*   over the k points.
+*
+*   The ROP's need EHT_ROP to have been requested.
+*
+*****************************************************************************/
+int eht_get_charges(eht_system *sys,double *charges)
+{
+  results_list_type *item;
+
+  if( !sys || !charges ) return -1;
+  if( sys->dim ) item = find_result(sys,"avg_net_charges",-1,-1);
+  else item = find_result(sys,"net_charges",0,-1);
+  if( !item ) return -1;
+  copy_values(item,0,1,item->chunk.num_elements,charges);
+  return item->chunk.num_elements;
+}
+
+int eht_get_ROP(eht_system *sys,double *rop)
+{
+  results_list_type *item;
+  int dim,i,j;
+
+  if( !sys || !rop ) return -1;
+  if( sys->dim ) item = find_result(sys,"avg_ROP_matrix",-1,-1);
+  else item = find_result(sys,"ROP_matrix",0,-1);
+  if( !item ) return -1;
+
+  /* the populations are stored as a lower triangle */
+  dim = item->chunk.rows;
+  for(i=0;i<dim;i++){
+    copy_values(item,i*(i+1)/2,1,i+1,&(rop[i*dim]));
+    for(j=0;j<i;j++) rop[j*dim+i] = rop[i*dim+j];
+  }
+  return dim*dim;
+}
+
+
+/****************************************************************************
+*
+*                   Function eht_get_forces
+*
+* Arguments: sys: pointer to eht_system
+*         forces: pointer to double
+*
+* Returns: int
+*
+* Action: copies the forces on the atoms (x, y and z for each atom, in
+*   eV/Angstrom) into 'forces and returns how many values there were.
+*   This needs EHT_FORCES to have been requested.
+*
+*****************************************************************************/
+int eht_get_forces(eht_system *sys,double *forces)
+{
+  results_list_type *item;
+
+  if( !sys || !forces ) return -1;
+  item = find_result(sys,"forces",-1,-1);
+  if( !item ) return -1;
+  copy_values(item,0,1,item->chunk.num_elements,forces);
+  return item->chunk.num_elements;
+}
+
+
+/****************************************************************************
+*
+*                   Functions eht_get_DOS, eht_get_COOP
+*
+* Arguments: sys: pointer to eht_system
+*          which: int
+*       energies: pointer to double
+*  weights/values: pointer to double
+*     max_points: int
+*
+* Returns: int
+*
+* Action: copies the points of the total DOS, or of the COOP curve
+*   added with 'which, into the buffers (at most 'max_points of them).
+*   These are the unbroadened curves bind writes into the output file:
+*   one point for each distinct energy level, with the DOS weighted by
+*   the k point weights.  Only for extended systems.
+*
+*   Returns the total number of points in the curve, so passing NULL
+*    buffers (or 0 for 'max_points) finds out how much room is needed.
+*
+*****************************************************************************/
+int eht_get_DOS(eht_system *sys,double *energies,double *weights,int max_points)
+{
+  results_list_type *item;
+  int num;
+
+  if( !sys ) return -1;
+  if( !sys->dim ) return api_error(sys,"The DOS is only done for extended systems.");
+  item = find_result(sys,"total_DOS",-1,-1);
+  if( !item ) return -1;
+  num = item->chunk.rows < max_points ? item->chunk.rows : max_points;
+  if( weights ) copy_values(item,0,2,num,weights);
+  if( energies ) copy_values(item,1,2,num,energies);
+  return item->chunk.rows;
+}
+
+int eht_get_COOP(eht_system *sys,int which,double *energies,double *values,
+                 int max_points)
+{
+  results_list_type *item;
+  int num;
+
+  if( !sys ) return -1;
+  if( !sys->dim ) return api_error(sys,"COOP's are only done for extended systems.");
+  item = find_result(sys,"COOP",-1,which);
+  if( !item ) return -1;
+  num = item->chunk.rows < max_points ? item->chunk.rows : max_points;
+  if( values ) copy_values(item,0,2,num,values);
+  if( energies ) copy_values(item,1,2,num,energies);
+  return item->chunk.rows;
+}
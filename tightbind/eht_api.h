@@ -0,0 +1,117 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the library interface to bind.
+*
+*   A calculation is set up in an eht_system (which the caller only
+*    sees through a pointer) from arrays of atomic symbols, Cartesian
+*    coordinates (in Angstroms) and, for extended systems, lattice
+*    vectors.  After it's run the results are copied into buffers the
+*    caller provides.  No input file is parsed and nothing is written
+*    to disk.
+*
+*   Atoms, orbitals and k points are numbered from 0.  The orbitals of
+*    each atom are in the order used in the output file (s, p, d, f).
+*
+*   Functions which return an int give a negative value if something
+*    was wrong with the arguments or the result isn't available
+*    (eht_last_error says why).  This includes failures inside the
+*    calculation itself, which would stop bind: eht_run cleans up after
+*    them and returns -1.
+*
+*   The library keeps its state in globals, so only one system can be
+*    run at a time (any number can exist, though).
+*
+*****************************************************************************/
+
+#ifndef EHT_API_DEFINED
+#define EHT_API_DEFINED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct eht_system_def eht_system;
+
+/* things which aren't evaluated unless they're asked for (eht_request) */
+#define EHT_EIGENVECTORS 1
+#define EHT_ROP 2
+#define EHT_FORCES 4
+
+/* setting up */
+extern eht_system *eht_create(int num_atoms, const char *const *symbols,
+                              const double *coords, int dim,
+                              const double *lattice);
+extern void eht_destroy(eht_system *sys);
+extern int eht_set_charge(eht_system *sys, double charge);
+extern int eht_set_electrons(eht_system *sys, double electrons);
+extern int eht_set_overlaps(eht_system *sys, const int *overlaps);
+extern int eht_set_kpoints(eht_system *sys, int num_kpoints,
+                           const double *kpoints);
+extern int eht_set_kpoint_mesh(eht_system *sys, const int *points_per_axis);
+extern int eht_set_symmetry(eht_system *sys, int use_symmetry);
+extern int eht_set_electrostatics(eht_system *sys, int use_electrostatics);
+extern int eht_set_parameter_file(eht_system *sys, const char *file_name);
+extern int eht_request(eht_system *sys, int what);
+extern int eht_add_COOP(eht_system *sys, int which, int atom1, int atom2,
+                        const int *cell);
+
+/* running */
+extern int eht_run(eht_system *sys);
+extern const char *eht_last_error(eht_system *sys);
+
+/* results */
+extern int eht_num_orbitals(eht_system *sys);
+extern int eht_num_kpoints(eht_system *sys);
+extern int eht_get_kpoints(eht_system *sys, double *kpoints);
+extern int eht_get_energies(eht_system *sys, int kpoint, double *energies);
+extern int eht_get_occupations(eht_system *sys, int kpoint,
+                               double *occupations);
+extern int eht_get_eigenvectors(eht_system *sys, int kpoint, double *real_part,
+                                double *imag_part);
+extern int eht_get_total_energy(eht_system *sys, double *energy);
+extern int eht_get_fermi_energy(eht_system *sys, double *energy);
+extern int eht_get_charges(eht_system *sys, double *charges);
+extern int eht_get_ROP(eht_system *sys, double *rop);
+extern int eht_get_forces(eht_system *sys, double *forces);
+extern int eht_get_DOS(eht_system *sys, double *energies, double *weights,
+                       int max_points);
+extern int eht_get_COOP(eht_system *sys, int which, double *energies,
+                        double *values, int max_points);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
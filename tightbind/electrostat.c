@@ -164,7 +164,6 @@ void free_atomic_energy(cell_type *cell,real *energy,real *work_array)
 void AO_occupations(cell_type *cell,int num_orbs,real *OP_mat,int *orbital_lookup_table,real *accum)
 {
   atom_type *atom;
-  static real *free_atom_occups=0;
   int orbs_so_far,orb_tab;
   real electrons_left;
   int i,j,k;
@@ -231,54 +230,40 @@ fprintf(stderr,"Atom %d p orbital occupation: %lg\n",i,accum[orbs_so_far]);
 #endif
 
   /********
-    figure out the free atom orbital occupations, we only have to do
-    this once.
-  ********/
-
-  /* get space to store the free occupations, if we need it */
-  if( !free_atom_occups ){
-    free_atom_occups = (real *)calloc(num_orbs,sizeof(real));
-    if( !free_atom_occups)
-      fatal("Can't allocate space for free atoms occupations in AO_occupations");
+    fill the accum array which was passed in with the free atom
+    orbital occupations.  These are cheap enough to find that it's
+    not worth keeping them around between calls (the atoms may have
+    changed anyway).
 
-    /******
-      fill the array of free atom occupations
+     this isn't set up for d electrons yet.
+  ********/
+  bzero((char *)accum,num_orbs*sizeof(real));
+  orbs_so_far = 0;
+  for( i=0;i<cell->num_atoms;i++){
+    atom = &(cell->atoms[i]);
+    electrons_left = atom->num_valence;
 
-       this isn't set up for d electrons yet.
-    *******/
-    orbs_so_far = 0;
-    for( i=0;i<cell->num_atoms;i++){
-      atom = &(cell->atoms[i]);
-      electrons_left = atom->num_valence;
-
-      if( atom->ns ){
-        if( electrons_left >= 2.0 ){
-          free_atom_occups[orbs_so_far++] = 2.0;
-          electrons_left -= 2.0;
-        }
-        else{
-          free_atom_occups[orbs_so_far++] = electrons_left;
-          electrons_left = 0.0;
-        }
+    if( atom->ns ){
+      if( electrons_left >= 2.0 ){
+        accum[orbs_so_far++] = 2.0;
+        electrons_left -= 2.0;
       }
-      if( atom->np ){
-        if( electrons_left >= 6.0 ){
-          free_atom_occups[orbs_so_far++] = 6.0;
-          electrons_left -= 6.0;
-        }
-        else{
-          free_atom_occups[orbs_so_far++] = electrons_left;
-          electrons_left = 0.0;
-        }
+      else{
+        accum[orbs_so_far++] = electrons_left;
+        electrons_left = 0.0;
+      }
+    }
+    if( atom->np ){
+      if( electrons_left >= 6.0 ){
+        accum[orbs_so_far++] = 6.0;
+        electrons_left -= 6.0;
+      }
+      else{
+        accum[orbs_so_far++] = electrons_left;
+        electrons_left = 0.0;
       }
     }
   }
-
-  /*****
-    copy the free atom_occupation numbers into the accum array
-    which was passed in
-  ******/
-  bcopy((char *)free_atom_occups,(char *)accum,num_orbs*sizeof(real));
 }
 
 /****************************************************************************
@@ -315,7 +300,8 @@ void eval_electrostatics(cell_type *cell,int num_orbs,eigenset_type eigenset,rea
                          real *OP_mat,int *orbital_lookup_table,
                          real *electrostat_term,real *eHMO_term,real *total_E,real *accum,real *net_chgs)
 {
-  static real *atomic_energy=0;
+  real *atomic_energy;
+  arena_mark_type mark;
   atom_type *atomA,*atomB;
   int i,orbs_so_far,orb_tab;
   int n,l,p;
@@ -332,11 +318,8 @@ void eval_electrostatics(cell_type *cell,int num_orbs,eigenset_type eigenset,rea
     make sure that we have memory to accumulate the "free" atomic energies
 
   ***************/
-  if( !atomic_energy ){
-    atomic_energy = (real *)calloc(cell->num_atoms,sizeof(real));
-    if( !atomic_energy )
-      fatal("Cannot allocate memory for atomic energy array in eval_electrostatics.");
-  }
+  mark = arena_mark(&cycle_arena);
+  atomic_energy = (real *)arena_calloc(&cycle_arena,cell->num_atoms,sizeof(real));
 
   /*******
     zero out the accumulator array
@@ -411,10 +394,9 @@ void eval_electrostatics(cell_type *cell,int num_orbs,eigenset_type eigenset,rea
 
 
       /*******
-        get the distance from the symmetric distance matrix and convert it to bohrs...
-        (this reference assumes that numA < numB)
+        get the distance and convert it to bohrs...
       ********/
-      R = cell->distance_mat[ numB*(numB+1)/2 + numA ]/BOHR;
+      R = atom_distance(cell,numB,numA)/BOHR;
 
       /******
 
@@ -573,5 +555,132 @@ void eval_electrostatics(cell_type *cell,int num_orbs,eigenset_type eigenset,rea
   *****/
   *total_E = *electrostat_term + *eHMO_term;
 
+  arena_release(&cycle_arena,mark);
   return;
 }
+
+
+/****************************************************************************
+ *
+ *                   Function shell_potential
+ *
+ * Arguments:  zeta: real
+ *                n: int
+ *                R: real
+ *            deriv: pointer to real
+ *
+ * Returns: real
+ *
+ * Action: evaluates the term (1/R - p_sum) used in eval_electrostatics
+ *   for one electron in a shell with exponent 'zeta and principal quantum
+ *   number 'n at distance 'R (in bohr).  Its derivative with respect to
+ *   R is returned in 'deriv.
+ *
+ ****************************************************************************/
+static real shell_potential(real zeta,int n,real R,real *deriv)
+{
+  real p_sum,dp_sum,prefactor;
+  int p;
+
+  p_sum = 0;
+  dp_sum = 0;
+  for(p=1; p <= 2*n; p++){
+    p_sum += pow((2.0*R*zeta),(2*n-p)) * (real)p / (real)factorial(2*n-p);
+    if( p < 2*n ){
+      dp_sum += 2.0*zeta*(real)(2*n-p)*pow((2.0*R*zeta),(2*n-p-1)) * (real)p /
+        (real)factorial(2*n-p);
+    }
+  }
+  prefactor = exp(-2.0*R*zeta)/(2.0*n*R);
+
+  *deriv = -1/(R*R) - (prefactor*dp_sum - prefactor*p_sum*(2.0*zeta + 1/R));
+  return 1/R - prefactor*p_sum;
+}
+
+
+/****************************************************************************
+ *
+ *                   Procedure electrostatic_gradients
+ *
+ * Arguments:  cell: pointer to cell type
+ *         num_orbs: int
+ *     orbital_lookup_table: int
+ *            accum: pointer to real
+ *        gradients: pointer to point_type
+ *
+ * Returns: none
+ *
+ * Action:   Adds the gradient of the electrostatic repulsion energy from
+ *    eval_electrostatics (in eV/Angstrom) to 'gradients.
+ *
+ *   'accum is used to build the orbital occupation array.  it should be at least
+ *     num_orbs long
+ *
+ ****************************************************************************/
+void electrostatic_gradients(cell_type *cell,int num_orbs,int *orbital_lookup_table,
+                             real *accum,point_type *gradients)
+{
+  atom_type *atomA,*atomB;
+  int numA,numB,orbs_so_far;
+  real R,deriv,drhoA,drhoB;
+  real ZA,ZB;
+  real dE_dR;
+  point_type dist_vect;
+
+  bzero((char *)accum,num_orbs*sizeof(real));
+  AO_occupations(cell,num_orbs,0,orbital_lookup_table,accum);
+
+  for(numA=0;numA<cell->num_atoms;numA++){
+    for(numB=numA+1; numB<cell->num_atoms; numB++){
+      atomA = &(cell->atoms[numA]);
+      atomB = &(cell->atoms[numB]);
+
+      R = atom_distance(cell,numB,numA)/BOHR;
+
+      /******
+        the derivatives of the terms due to centers A and B.  d shells
+        are left out, just as they are in eval_electrostatics (which
+        complains about them), so this stays the gradient of that energy.
+      *******/
+      drhoA = 0.0;
+      orbs_so_far = orbital_lookup_table[numA];
+      if( atomA->ns != 0){
+        shell_potential(atomA->exp_s,atomA->ns,R,&deriv);
+        drhoA += accum[orbs_so_far++] * deriv;
+      }
+      if( atomA->np != 0){
+        shell_potential(atomA->exp_p,atomA->np,R,&deriv);
+        drhoA += accum[orbs_so_far++] * deriv;
+      }
+      drhoB = 0.0;
+      orbs_so_far = orbital_lookup_table[numB];
+      if( atomB->ns != 0){
+        shell_potential(atomB->exp_s,atomB->ns,R,&deriv);
+        drhoB += accum[orbs_so_far++] * deriv;
+      }
+      if( atomB->np != 0){
+        shell_potential(atomB->exp_p,atomB->np,R,&deriv);
+        drhoB += accum[orbs_so_far++] * deriv;
+      }
+
+      ZA = atomA->num_valence;
+      ZB = atomB->num_valence;
+
+      /* this is per bohr, the 27.2 is the same as in eval_electrostatics */
+      dE_dR = -ZA*ZB/(R*R) - .5*(ZA*drhoB + ZB*drhoA);
+      dE_dR *= 27.2;
+
+      /* move it to per Angstrom along the A->B vector */
+      dist_vect.x = atomB->loc.x - atomA->loc.x;
+      dist_vect.y = atomB->loc.y - atomA->loc.y;
+      dist_vect.z = atomB->loc.z - atomA->loc.z;
+      dE_dR /= R*BOHR*BOHR;
+      gradients[numB].x += dE_dR*dist_vect.x;
+      gradients[numB].y += dE_dR*dist_vect.y;
+      gradients[numB].z += dE_dR*dist_vect.z;
+      gradients[numA].x -= dE_dR*dist_vect.x;
+      gradients[numA].y -= dE_dR*dist_vect.y;
+      gradients[numA].z -= dE_dR*dist_vect.z;
+    }
+  }
+}
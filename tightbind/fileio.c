@@ -66,17 +66,6 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "symmetry.h"
 #endif
 
-#ifndef EHT_PARM_FILE
-#define EHT_PARM_FILE "eht_parms.dat"
-#endif
-
-// Include the default data in case we need it
-#include "eht_parms.h"
-
-/* hopefully this will be way more than enough */
-#define MAX_CUSTOM_ATOMS 40
-atom_type custom_atoms[MAX_CUSTOM_ATOMS];
-
 
 
 /****************************************************************************
@@ -406,6 +395,40 @@ void fill_chg_it_parms(atom_type *atoms,int num_atoms,int num_lines,FILE *infile
   }
 }
 
+/****************************************************************************
+ *
+ *                   Procedure copy_custom_atom
+ *
+ * Arguments:  atom: pointer to atom_type
+ *           custom: pointer to atom_type
+ *
+ * Returns: none
+ *
+ * Action: copies everything about the special atom 'custom into 'atom
+ *   except for its position and which atom it is.
+ *
+ *****************************************************************************/
+static void copy_custom_atom(atom_type *atom,atom_type *custom)
+{
+  point_type saveloc;
+  Z_mat_type saveZloc;
+  int save_which;
+
+  /************
+
+    since I copy the whole block at once, I need to save the
+    atomic position and then re-insert it into the atom structure
+
+    **************/
+  bcopy((char *)&(atom->loc),(char *)&(saveloc),sizeof(point_type));
+  bcopy((char *)&(atom->Zmat_loc),(char *)&saveZloc,sizeof(Z_mat_type));
+  save_which = atom->which_atom;
+  bcopy((char *)custom,(char *)atom,sizeof(atom_type));
+  atom->which_atom = save_which;
+  bcopy((char *)&saveloc,(char *)&(atom->loc),sizeof(point_type));
+  bcopy((char *)&saveZloc,(char *)&(atom->Zmat_loc),sizeof(Z_mat_type));
+}
+
 /****************************************************************************
  *
  *                   Procedure fill_atomic_parms
@@ -420,79 +443,29 @@ void fill_chg_it_parms(atom_type *atoms,int num_atoms,int num_lines,FILE *infile
  *
  * Action:
  *   sets all the atoms up with extended hueckel parameters
- *   atomic wavefunction parameters not supplied by the input file are read
- *   out of a parameter file with the name indicated in the #define for
- *   EHT_PARM_FILE given above (or in the makefile)
+ *   atomic wavefunction parameters not supplied by the input file are
+ *   looked up in the table for the parameter file (see shared_parm_table
+ *   in parm_table.c), which is only read the first time it's needed.
  *
  *****************************************************************************/
 void fill_atomic_parms(atom_type *atoms,int num_atoms,FILE *infile,char *parm_file_name)
 {
-  char err_string[240],instring[240];
-  point_type saveloc;
-  Z_mat_type saveZloc;
-  FILE *parmfile;
-  int own_parm_file_name; 
-  int i,j;
+  char instring[MAX_STR_LEN];
+  parm_table_type *parm_table;
+  parm_table_type custom_table;
+  parm_entry_type *entry;
+  atom_type custom;
+  int i;
   int num_read;
-  int save_which;
-  char found;
   real temp;
 
-  int num_custom;
-
-  char ang[2],tstring[10];
-  int atnum,nzeta,nquant,nval;
-  real Hii,exp1,exp2,c1,c2;
 
-
-  own_parm_file_name = 0;
-  /* open the parameter file */
-  if (!parm_file_name)
-    parm_file_name = (char *)getenv("BIND_PARM_FILE");
-  if( !parm_file_name ){
-    parm_file_name = (char *)calloc(240,sizeof(char));
-    if(!parm_file_name)fatal("can't get memory for parm_file_name");
-    safe_strcpy(parm_file_name,EHT_PARM_FILE);
-    own_parm_file_name = 1;
-  }
-  parmfile = fopen(parm_file_name,"r");
-
-  bzero(custom_atoms,MAX_CUSTOM_ATOMS*sizeof(atom_type));
-
-  /* make sure that it opened, but don't exit if not... */
-  if(!parmfile){
-    safe_strcpy(err_string,"Can't open parameter file: ");
-    strcat(err_string,parm_file_name);
-    strcat(err_string," using default data in eht_parms.h...");
-    if(own_parm_file_name) free(parm_file_name);
-    error(err_string);
-  }
-  if(own_parm_file_name) free(parm_file_name);
+  parm_table = shared_parm_table(parm_file_name);
+  bzero((char *)&custom_table,sizeof(parm_table_type));
 
   /* loop over the atoms and get the parameters */
-  num_custom = 0;
   for(i=0;i<num_atoms;i++){
 
-#if 0
-    /******
-      if the first character in the symbol is a space, then move
-      the second character to the first position, this makes searching
-      for parameters much easier
-      ******/
-    if( atoms[i].symb[0] == ' ' || atoms[i].symb[0] == '\t'){
-      atoms[i].symb[0] = atoms[i].symb[1];
-      atoms[i].symb[1] = 0;
-    }
-    /* remove tab characters and spaces */
-    if(atoms[i].symb[1] == '\t' || atoms[i].symb[1] == ' '){
-      atoms[i].symb[1] = 0;
-    }
-    /* remove carriage returns */
-    if(atoms[i].symb[1] == '\n'){
-      atoms[i].symb[1] = 0;
-    }
-
-#endif
     /*******
       if it's a dummy atom, then we don't have to really do anything
       ********/
@@ -508,37 +481,27 @@ void fill_atomic_parms(atom_type *atoms,int num_atoms,FILE *infile,char *parm_fi
     else if(atoms[i].symb[0] == '*'){
       printf("Looking for parameters for special atom in the input file...\n");
       skipcomments(infile,instring,FATAL);
+      bzero((char *)&custom,sizeof(atom_type));
       num_read = sscanf(instring,"%s %d %d %d %lf %lf %d %lf %lf %d %lf %lf %lf %lf %lf %d %lf %lf %lf %lf %lf",
-                        custom_atoms[num_custom].symb,
-                        &(custom_atoms[num_custom].at_number),
-                        &(custom_atoms[num_custom].num_valence),
-                        &(custom_atoms[num_custom].ns),&(custom_atoms[num_custom].exp_s),
-                        &(custom_atoms[num_custom].coul_s),
-                        &(custom_atoms[num_custom].np),&(custom_atoms[num_custom].exp_p),
-                        &(custom_atoms[num_custom].coul_p),
-                        &(custom_atoms[num_custom].nd),&(custom_atoms[num_custom].exp_d),
-                        &(custom_atoms[num_custom].coul_d),
-                        &(custom_atoms[num_custom].coeff_d1),
-                        &(custom_atoms[num_custom].exp_d2),
-                        &(custom_atoms[num_custom].coeff_d2),
-                        &(custom_atoms[num_custom].nf),&(custom_atoms[num_custom].exp_f),
-                        &(custom_atoms[num_custom].coul_f),
-                        &(custom_atoms[num_custom].coeff_f1),
-                        &(custom_atoms[num_custom].exp_f2),
-                        &(custom_atoms[num_custom].coeff_f2));
-
-#if 0
-      /* patch up the custom name */
-      if(custom_atoms[num_custom].symb[0]==' '||custom_atoms[num_custom].symb[0] =='\t'){
-        custom_atoms[num_custom].symb[0] = custom_atoms[num_custom].symb[1];
-        custom_atoms[num_custom].symb[1] = 0;
-      }
-      if(custom_atoms[num_custom].symb[1] == '\t'){
-        custom_atoms[num_custom].symb[1] = 0;
-      }
-
-#endif
-      upcase(custom_atoms[num_custom].symb);
+                        custom.symb,
+                        &(custom.at_number),
+                        &(custom.num_valence),
+                        &(custom.ns),&(custom.exp_s),
+                        &(custom.coul_s),
+                        &(custom.np),&(custom.exp_p),
+                        &(custom.coul_p),
+                        &(custom.nd),&(custom.exp_d),
+                        &(custom.coul_d),
+                        &(custom.coeff_d1),
+                        &(custom.exp_d2),
+                        &(custom.coeff_d2),
+                        &(custom.nf),&(custom.exp_f),
+                        &(custom.coul_f),
+                        &(custom.coeff_f1),
+                        &(custom.exp_f2),
+                        &(custom.coeff_f2));
+
+      upcase(custom.symb);
       /***********
         we're not guaranteed to have gotten information on all the orbitals,
         (the user probably won't have anything for f orbitals when giving
@@ -548,235 +511,83 @@ void fill_atomic_parms(atom_type *atoms,int num_atoms,FILE *infile,char *parm_fi
         ***********/
       switch(num_read){
       case 6:
-        custom_atoms[num_custom].np=0;
-        custom_atoms[num_custom].nd=0;
-        custom_atoms[num_custom].nf=0;
+        custom.np=0;
+        custom.nd=0;
+        custom.nf=0;
         break;
       case 9:
-        custom_atoms[num_custom].nd=0;
-        custom_atoms[num_custom].nf=0;
+        custom.nd=0;
+        custom.nf=0;
         break;
       case 15:
-        custom_atoms[num_custom].nf=0;
+        custom.nf=0;
         break;
       }
 
       /*******
         Normalize the d-coefficients.
         ******/
-      if(custom_atoms[num_custom].coeff_d2 != 0){
-        temp = 4.0*(custom_atoms[num_custom].exp_d*custom_atoms[num_custom].exp_d2/
-                  pow(custom_atoms[num_custom].exp_d+custom_atoms[num_custom].exp_d2,2.0));
-        temp = pow(temp,((real)custom_atoms[num_custom].nd+.5));
-
-        temp = sqrt(custom_atoms[num_custom].coeff_d1*custom_atoms[num_custom].coeff_d1+
-                    custom_atoms[num_custom].coeff_d2*custom_atoms[num_custom].coeff_d2+
-                    2.0*temp*custom_atoms[num_custom].coeff_d1*
-                    custom_atoms[num_custom].coeff_d2);
+      if(custom.coeff_d2 != 0){
+        temp = 4.0*(custom.exp_d*custom.exp_d2/
+                  pow(custom.exp_d+custom.exp_d2,2.0));
+        temp = pow(temp,((real)custom.nd+.5));
+
+        temp = sqrt(custom.coeff_d1*custom.coeff_d1+
+                    custom.coeff_d2*custom.coeff_d2+
+                    2.0*temp*custom.coeff_d1*
+                    custom.coeff_d2);
         temp = 1.0/temp;
 
-        custom_atoms[num_custom].coeff_d1 *= temp;
-        custom_atoms[num_custom].coeff_d2 *= temp;
+        custom.coeff_d1 *= temp;
+        custom.coeff_d2 *= temp;
       }
 
       /*******
         Normalize the f-coefficients.
         ******/
-      if(custom_atoms[num_custom].coeff_f2 != 0){
-        temp = 4.0*(custom_atoms[num_custom].exp_f*custom_atoms[num_custom].exp_f2/
-                  pow(custom_atoms[num_custom].exp_f+custom_atoms[num_custom].exp_f2,2.0));
-        temp = pow(temp,((real)custom_atoms[num_custom].nf+.5));
-
-        temp = sqrt(custom_atoms[num_custom].coeff_f1*custom_atoms[num_custom].coeff_f1+
-                    custom_atoms[num_custom].coeff_f2*custom_atoms[num_custom].coeff_f2+
-                    2.0*temp*custom_atoms[num_custom].coeff_f1*
-                    custom_atoms[num_custom].coeff_f2);
+      if(custom.coeff_f2 != 0){
+        temp = 4.0*(custom.exp_f*custom.exp_f2/
+                  pow(custom.exp_f+custom.exp_f2,2.0));
+        temp = pow(temp,((real)custom.nf+.5));
+
+        temp = sqrt(custom.coeff_f1*custom.coeff_f1+
+                    custom.coeff_f2*custom.coeff_f2+
+                    2.0*temp*custom.coeff_f1*
+                    custom.coeff_f2);
         temp = 1.0/temp;
 
-        custom_atoms[num_custom].coeff_f1 *= temp;
-        custom_atoms[num_custom].coeff_f2 *= temp;
+        custom.coeff_f1 *= temp;
+        custom.coeff_f2 *= temp;
       }
 
+      /* later atoms with this symbol get the same parameters */
+      entry = add_parm_entry(&custom_table,custom.symb);
+      bcopy((char *)&custom,(char *)&(entry->parms),sizeof(atom_type));
 
-      /************
-
-        make sure that the atomic list has these parameters
-        since I copy the whole block at once, I need to save the
-        atomic position and then re-insert it into the atom structure
-
-        **************/
-      bcopy((char *)&(atoms[i].loc),(char *)&(saveloc),sizeof(point_type));
-      bcopy((char *)&(atoms[i].Zmat_loc),(char *)&saveZloc,sizeof(Z_mat_type));
-      save_which = atoms[i].which_atom;
-      bzero((char *)&(atoms[i]),sizeof(atom_type));
-      bcopy((char *)&(custom_atoms[num_custom]),(char *)&(atoms[i]),
-            sizeof(atom_type));
-
-      atoms[i].which_atom = save_which;
-      bcopy((char *)&saveloc,(char *)&(atoms[i].loc),sizeof(point_type));
-      bcopy((char *)&saveZloc,(char *)&(atoms[i].Zmat_loc),sizeof(Z_mat_type));
-
-      num_custom++;
+      /* make sure that the atomic list has these parameters */
+      copy_custom_atom(&(atoms[i]),&custom);
     }
     else{
-      found = 0;
+      upcase(atoms[i].symb);
 
       /*****
-        check to see if this is a custom atom that has already been hit
+        check to see if this is a custom atom that has already been hit,
+        otherwise use the parameter file
         ******/
-          upcase(atoms[i].symb);
-      for(j=0;j<num_custom;j++){
-
-                upcase(custom_atoms[j].symb);
-        if(!strncmp(atoms[i].symb,custom_atoms[j].symb,2)){
-          /* BINGO! copy the data and save the location. */
-          bcopy((char *)&(atoms[i].loc),(char *)&(saveloc),sizeof(point_type));
-          bcopy((char *)&(atoms[i].Zmat_loc),(char *)&saveZloc,sizeof(Z_mat_type));
-          save_which = atoms[i].which_atom;
-
-          bcopy((char *)&(custom_atoms[j]),(char *)&(atoms[i]),
-                sizeof(atom_type));
-          atoms[i].which_atom = save_which;
-          bcopy((char *)&saveloc,(char *)&(atoms[i].loc),sizeof(point_type));
-          bcopy((char *)&saveZloc,(char *)&(atoms[i].Zmat_loc),sizeof(Z_mat_type));
-
-          found = 1;
-        }
-      }
-
-      /******
-        look for the parameters in the param file if it exists
-        *******/
-      if (parmfile)
-        rewind(parmfile);
-
-      bool atEnd = false;
-      size_t defaultParmsInd = 0;
-      while(!found && !atEnd) {
-        // If the parm file exists, read from that
-        if (parmfile) {
-          if (skipcomments(parmfile,instring,IGNORE) == -1) {
-            atEnd = true;
-            break;
-          }
-        }
-        // Else, read from the default data
-        else {
-          strcpy(instring, defaultParms[defaultParmsInd]);
-          // If the string says "END", then we have reached the end!
-          if (strcmp(instring, "END") == 0) {
-            atEnd = true;
-            break;
-          }
-          ++defaultParmsInd;
-        }
-
-        /* compare two characters and see if this is the right atom */
-        sscanf(instring,"%s",tstring);
-        upcase(tstring);
-        while(!strncmp(atoms[i].symb,tstring,2)){
-          /* it is... read out the data */
-          sscanf(instring,"%s %d %d %d %d %s %lf %lf %lf %lf %lf",
-                 tstring,&atnum,&nval,&nzeta,&nquant,ang,&Hii,&exp1,&exp2,&c1,&c2);
-
-          atoms[i].at_number = atnum;
-          atoms[i].num_valence = nval;
-          /* figure out which type of orbital this is */
-          switch(ang[0]){
-          case 's':
-          case 'S':
-            if( Hii != 0.0 )
-              atoms[i].ns = nquant;
-            else atoms[i].ns = 0;
-
-            atoms[i].exp_s = exp1;
-            atoms[i].coul_s = Hii;
-            break;
-          case 'p':
-          case 'P':
-            if( Hii != 0.0 )
-              atoms[i].np = nquant;
-            else atoms[i].np = 0;
-            atoms[i].exp_p = exp1;
-            atoms[i].coul_p = Hii;
-            break;
-          case 'd':
-          case 'D':
-            if( Hii != 0.0 )
-              atoms[i].nd = nquant;
-            else atoms[i].nd = 0;
-            atoms[i].exp_d = exp1;
-            atoms[i].coul_d = Hii;
-            atoms[i].coeff_d1 = c1;
-            if( nzeta == 2 ){
-              atoms[i].exp_d2 = exp2;
-              atoms[i].coeff_d2 = c2;
-
-              /*******
-                this is some kind of wierd coefficient adjustment business that
-                they do in the original source... I'm not sure why...
-                ******/
-              temp = 4.0*(exp1*exp2/pow(exp1+exp2,2.0));
-              temp = pow(temp,(real)nquant+.5);
-
-              temp = sqrt(c1*c1+c2*c2+2*temp*c1*c2);
-              temp = 1.0/temp;
-
-              atoms[i].coeff_d1 *= temp;
-              atoms[i].coeff_d2 *= temp;
-            }
-            break;
-          case 'f':
-          case 'F':
-            if( Hii != 0.0 )
-              atoms[i].nf = nquant;
-            else atoms[i].nf = 0;
-            atoms[i].exp_f = exp1;
-            atoms[i].coul_f = Hii;
-            atoms[i].coeff_f1 = c1;
-            if( nzeta == 2 ){
-              atoms[i].exp_f2 = exp2;
-              atoms[i].coeff_f2 = c2;
-
-              /*******
-                this is some kind of wierd coefficient adjustment business that
-                they do in the original source... I'm not sure why...
-                ******/
-              temp = 4.0*(exp1*exp2/pow(exp1+exp2,2.0));
-              temp = pow(temp,(real)nquant+.5);
-
-              temp = sqrt(c1*c1+c2*c2+2*temp*c1*c2);
-              temp = 1.0/temp;
-
-              atoms[i].coeff_f1 *= temp;
-              atoms[i].coeff_f2 *= temp;
-            }
-            break;
-          }
-          /********
-            now read in the next line to make sure that we have all the oribtals
-            for this atom.
-            ********/
-          if (parmfile)
-            skipcomments(parmfile,instring,IGNORE);
-          else {
-            // Read next line from default data
-            strcpy(instring, defaultParms[defaultParmsInd]);
-            ++defaultParmsInd;
-          }
-
-          sscanf(instring,"%s",tstring);
-          found = 1;
+      entry = find_parm_entry(&custom_table,atoms[i].symb);
+      if( entry ){
+        copy_custom_atom(&(atoms[i]),&(entry->parms));
+      } else{
+        entry = find_parm_entry(parm_table,atoms[i].symb);
+        if( !entry ){
+          fprintf(stderr,"Can't find parameters for atom: %s\n",atoms[i].symb);
+          fatal("Parameter acquisition failure :-(");
         }
-      }
-
-      if(!found){
-        fprintf(stderr,"Can't find parameters for atom: %s\n",atoms[i].symb);
-        fatal("Parameter acquisition failure :-(");
+        apply_parm_entry(&(atoms[i]),entry);
       }
     }
   }
-  if( parmfile ) fclose(parmfile);
+  if( custom_table.entries ) my_free(custom_table.entries);
 }
 
 
@@ -1339,7 +1150,7 @@ void parse_charge_iteration(FILE *infile,detail_type *details,cell_type *cell)
   int i,j;
   int EOF_hit;
   int which;
-  int *numbers_read;
+  int *numbers_read=0;
   int num_read,num_to_vary;
   int num_parm_lines;
   chg_it_parm_type *parms;
@@ -1437,6 +1248,132 @@ void parse_charge_iteration(FILE *infile,detail_type *details,cell_type *cell)
 
 
 
+/****************************************************************************
+ *
+ *                   Procedure parse_geom_opt
+ *
+ * Arguments: infile: pointer to type FILE
+ *           details: pointer to detail_type
+ *
+ * Returns: none
+ *
+ * Action:  This parses the geometry optimization options and sets
+ *   defaults for the ones which aren't given.
+ *
+ *****************************************************************************/
+void parse_geom_opt(FILE *infile,detail_type *details)
+{
+  char instring[240];
+  char tempstring[240];
+  int EOF_hit;
+  geom_opt_parm_type *parms;
+
+  /*********
+
+      NOTE: before adding keywords to this, make sure to read the
+        warning in parse_printing_options.
+
+  ***********/
+
+  parms = &(details->geom_opt_parms);
+  parms->method = OPT_BFGS;
+  parms->cartesian = 0;
+  parms->max_steps = OPT_MAX_STEPS_DEF;
+  parms->force_tol = OPT_FORCE_TOL_DEF;
+  parms->energy_tol = OPT_ENERGY_TOL_DEF;
+  parms->max_disp = OPT_MAX_DISP_DEF;
+  parms->armijo = OPT_ARMIJO_DEF;
+  parms->backtrack = OPT_BACKTRACK_DEF;
+  parms->max_line_steps = OPT_MAX_LINE_DEF;
+  parms->time_step = OPT_TIME_STEP_DEF;
+  parms->max_time_step = OPT_MAX_TIME_STEP_DEF;
+
+  /* read until we hit either the EOF or the keyword END OPT */
+  EOF_hit = 0;
+  while( EOF_hit > -1 ){
+    EOF_hit = skipcomments(infile,instring,IGNORE);
+    upcase(instring);
+    if( EOF_hit > -1 ){
+      /*----------------------------------------------------------------------*/
+      if(strstr(instring,"END_OPT") || strstr(instring,"END OPT")){
+        EOF_hit = -1;
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "BFGS")){
+        parms->method = OPT_BFGS;
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "FIRE")){
+        parms->method = OPT_FIRE;
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "CARTESIAN")){
+        parms->cartesian = 1;
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "MAX STEPS")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%d",&parms->max_steps);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "FORCE TOL")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%lf",&parms->force_tol);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "ENERGY TOL")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%lf",&parms->energy_tol);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "MAX DISP")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%lf",&parms->max_disp);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "ARMIJO")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%lf",&parms->armijo);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "BACKTRACK")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%lf",&parms->backtrack);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "MAX LINE")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%d",&parms->max_line_steps);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "MAX TIME")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%lf",&parms->max_time_step);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring, "TIME STEP")){
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%lf",&parms->time_step);
+      }
+      else{
+        safe_strcpy(tempstring,"Bad geometry optimization section line: ");
+        strcat(tempstring,instring);
+        error(tempstring);
+      }
+    }
+  }
+
+  if( parms->max_steps < 1 || parms->max_disp <= 0.0 ||
+      parms->backtrack <= 0.0 || parms->backtrack >= 1.0 ||
+      parms->max_line_steps < 1 || parms->time_step <= 0.0 ){
+    fatal("Bad value in the geometry optimization section.");
+  }
+}
+
+
+
+
+
 /****************************************************************************
  *
  *                   Procedure read_inputfile
@@ -1604,6 +1541,29 @@ void read_inputfile(cell_type *cell,detail_type *details,char *name,int *num_orb
         details->do_netCDF = 1;
       }
 #endif
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring,"BINARY RESULTS")){
+        fprintf(status_file,"Results will also be written to a binary file.\n");
+        details->binary_results = 1;
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring,"RESULT CACHE")){
+        /* the directory is on the next line (its case matters) */
+        skipcomments(infile,instring,FATAL);
+        sscanf(instring,"%239s",details->cache_dir);
+        fprintf(status_file,"k point results will be cached in %s.\n",
+                details->cache_dir);
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring,"NO TEXT MAT")){
+        fprintf(status_file,"Matrices won't be printed in the output file.\n");
+        print_text_mats = false;
+      }
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring,"NO TIMING")){
+        fprintf(status_file,"Timing information won't be collected.\n");
+        timers_off();
+      }
       /*----------------------------------------------------------------------*/
       else if(strstr(instring,"ELECTROSTAT")){
         fprintf(status_file,"Electrostatic contributions to the energy will be\
@@ -1611,6 +1571,21 @@ void read_inputfile(cell_type *cell,detail_type *details,char *name,int *num_orb
         details->eval_electrostat = 1;
       }
 
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring,"GRADIENTS")){
+        fprintf(status_file,"The forces on the atoms will be evaluated.\n");
+        details->gradients = 1;
+      }
+
+      /*----------------------------------------------------------------------*/
+      else if(strstr(instring,"OPTIMIZE GEOM") || strstr(instring,"OPTIMISE GEOM")){
+        fprintf(status_file,"The geometry will be optimized.\n");
+        details->do_geom_opt = 1;
+        /* the forces at the final geometry are printed too */
+        details->gradients = 1;
+        parse_geom_opt(infile,details);
+      }
+
       /*----------------------------------------------------------------------*/
       else if(strstr(instring,"NONWEIGHTED")){
         fprintf(status_file,"The nonweighted Hij form will be used.\n");
@@ -2007,6 +1982,20 @@ done.\n");
         }
       } /* end of keyword LATTICE */
 
+      /*----------------------------------------------------------------------*/
+      /* this has to come before the K POINTS keywords (it contains KPOINT) */
+      else if( strstr(instring,"CHECKPOINT") ){
+        if( sscanf(instring,"%s %lf",string1,
+                   &(details->checkpoint_interval)) != 2 ){
+          skipcomments(infile,instring,FATAL);
+          sscanf(instring,"%lf",&details->checkpoint_interval);
+        }
+        if( details->checkpoint_interval <= 0.0 ){
+          error("The checkpoint interval must be positive, checkpoints are off.");
+          details->checkpoint_interval = 0.0;
+        }
+      }
+
       /*----------------------------------------------------------------------*/
       else if( strstr(instring,"K POINTS AUTO") ||
               strstr(instring,"K-POINTS AUTO") ||
@@ -2066,6 +2055,9 @@ calculation.\n");
           skipcomments(infile,instring,FATAL);
           sscanf(instring,"%lf",&(details->k_offset));
         }
+        fprintf(status_file,
+                "Warning: K Offset is no longer used, automatic k point meshes are \
+Monkhorst-Pack meshes.\n");
       }
       /*----------------------------------------------------------------------*/
       else if( strstr(instring,"ZERO OVER") ){
@@ -2398,6 +2390,12 @@ calculation.\n");
       else if( strstr(instring,"MOMENTS") ){
         details->do_moments=1;
       }
+      else if( strstr(instring,"DUMP FLOAT") ){
+        details->dump_float=1;
+      }
+      else if( strstr(instring,"DUMP COMPRESS") ){
+        details->dump_compressed=1;
+      }
       else if( strstr(instring,"DUMP HAM") ){
         details->dump_hamil=1;
       }
@@ -2576,6 +2574,28 @@ calculation.\n");
         }
       }
 
+      /*----------------------------------------------------------------------*/
+      else if( strstr(instring,"MEMORY BUDGET") ){
+        if( sscanf(instring,"%s %s %lf",string1,string2,
+                   &(details->memory_budget)) != 3 ){
+          skipcomments(infile,instring,FATAL);
+          sscanf(instring,"%lf",&details->memory_budget);
+        }
+        if( details->memory_budget < 0.0 ){
+          error("The memory budget can't be negative, ignoring it.");
+          details->memory_budget = 0.0;
+        }
+        if( details->memory_budget > 0.0 ){
+          fprintf(status_file,"The run will use at most %.2lf Meg.\n",
+                  details->memory_budget);
+        }
+      }
+
+      /*----------------------------------------------------------------------*/
+      else if( strstr(instring,"MIXED PREC") ){
+        details->mixed_precision = 1;
+      }
+
       /*----------------------------------------------------------------------*/
       else if( strstr(instring,"RHO") ){
         if( sscanf(instring,"%s %lf",string1,&(details->rho)) != 2 ){
@@ -75,9 +75,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  * prints an error message and terminates the program.
  *  this should be called when internal consistency error checking
  *   fails.
+ *
+ * fatal_trap is handled as it is in fatal.
  */
 void fatal_bug( char *errorstring, char *file, int line )
 {
+  if( fatal_trap ){
+    snprintf(fatal_message,MAX_STR_LEN,"%s (line %d of %s)",errorstring,line,file);
+    longjmp(*fatal_trap,1);
+  }
   fprintf( stderr, "FATAL ERROR: %s.\n",errorstring );
     fprintf( stderr, "The error occured at line: %d of file: %s\n",line,file );
   fprintf( stderr, "  This is a bug. Please report the error by e-mail to:\n");
@@ -117,9 +123,16 @@ void nonfatal_bug( char *errorstring, char *file, int line )
  * prints an error message and terminates the program
  *
  * in case the job was queued, the error message is echoed to the status file
+ *
+ * if fatal_trap is set the message is left in fatal_message and we
+ *  jump back there instead.
  */
 void fatal( char *errorstring )
 {
+  if( fatal_trap ){
+    snprintf(fatal_message,MAX_STR_LEN,"%s",errorstring);
+    longjmp(*fatal_trap,1);
+  }
   fprintf( stderr, "FATAL ERROR: %s.\nExecution Terminated.\n",
       errorstring );
   if( status_file ){
@@ -449,6 +462,245 @@ void debugmat( real *mat, int num_row, int num_col, real tol )
 }
 
 
+/****************************************************************************
+*
+*  The matrix printers below can produce a lot of output (every element
+*   of every wavefunction/overlap population matrix at every k point),
+*   so they don't go through fprintf for each element.  Text is built
+*   up in 'print_buffer and written out a block at a time.
+*
+*****************************************************************************/
+#define PRINT_BUFFER_SIZE 65536
+#define MAX_PRINT_FIELD 64
+
+static char print_buffer[PRINT_BUFFER_SIZE];
+static int print_buffer_len=0;
+
+/* powers of ten used by sprint_fixed */
+static double fixed_scales[] = {1.0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9};
+#define MAX_FIXED_PREC 9
+#define MAX_FIXED_VAL 1e9
+
+/****************************************************************************
+*
+*                   Procedure sprint_fixed
+*
+* Arguments:  dest: pointer to char
+*              val: double
+*             prec: int
+*            width: int
+*             left: char
+*
+* Returns: int
+*
+* Action: writes 'val into 'dest with 'prec digits after the decimal
+*   point in a field 'width characters wide (left justified if 'left
+*   is nonzero).  The result is the same as sprintf with "%*.*f" (or
+*   "%-*.*f"): the value is rounded exactly, with ties going to even.
+*   The decimal point is always a '.'.
+*
+*   The number of characters written is returned.
+*
+*****************************************************************************/
+int sprint_fixed(char *dest,double val,int prec,int width,char left)
+{
+  char digits[MAX_PRINT_FIELD];
+  double absval,scale,diff;
+  long long scaled,int_part,frac_part;
+  int num_digits,len,i;
+
+  absval = fabs(val);
+  if( prec < 0 || prec > MAX_FIXED_PREC || width >= MAX_PRINT_FIELD ||
+      !(absval < MAX_FIXED_VAL) ){
+    if( left ) return sprintf(dest,"%-*.*f",width,prec,val);
+    else return sprintf(dest,"%*.*f",width,prec,val);
+  }
+
+  /******
+    find the nearest integer to absval*scale.  The product itself
+    is rounded, so check the candidate against the exact value with
+    fma (which only rounds once).
+  ******/
+  scale = fixed_scales[prec];
+  scaled = (long long)floor(absval*scale+0.5);
+  diff = fma(absval,scale,-((double)scaled-0.5));
+  if( diff < 0.0 || (diff == 0.0 && scaled%2) ) scaled--;
+  else{
+    diff = fma(absval,scale,-((double)scaled+0.5));
+    if( diff > 0.0 || (diff == 0.0 && scaled%2) ) scaled++;
+  }
+
+  /* build the digits backwards */
+  num_digits = 0;
+  int_part = scaled / (long long)scale;
+  frac_part = scaled % (long long)scale;
+  for(i=0;i<prec;i++){
+    digits[num_digits++] = '0' + (char)(frac_part%10);
+    frac_part /= 10;
+  }
+  if( prec ) digits[num_digits++] = '.';
+  do{
+    digits[num_digits++] = '0' + (char)(int_part%10);
+    int_part /= 10;
+  }while(int_part);
+  if( signbit(val) ) digits[num_digits++] = '-';
+
+  len = 0;
+  if( !left ) for(;len<width-num_digits;len++) dest[len] = ' ';
+  for(i=num_digits-1;i>=0;i--) dest[len++] = digits[i];
+  if( left ) for(;len<width;len++) dest[len] = ' ';
+  dest[len] = 0;
+  return len;
+}
+
+/****************************************************************************
+*
+*                   Procedure flush_print_buffer
+*
+* Arguments: outfile: pointer to FILE
+*
+* Returns: none
+*
+* Action: writes whatever is in the print buffer to 'outfile
+*
+*****************************************************************************/
+static void flush_print_buffer(FILE *outfile)
+{
+  if( print_buffer_len ){
+    fwrite(print_buffer,sizeof(char),print_buffer_len,outfile);
+    print_buffer_len = 0;
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure buffer_string
+*
+* Arguments: outfile: pointer to FILE
+*              string: pointer to char
+*                 len: int
+*
+* Returns: none
+*
+* Action: adds the first 'len characters of 'string to the print buffer,
+*   flushing it to 'outfile first if there isn't room.
+*
+*****************************************************************************/
+static void buffer_string(FILE *outfile,char *string,int len)
+{
+  if( print_buffer_len + len > PRINT_BUFFER_SIZE ){
+    flush_print_buffer(outfile);
+    if( len > PRINT_BUFFER_SIZE ){
+      fwrite(string,sizeof(char),len,outfile);
+      return;
+    }
+  }
+  memcpy(&(print_buffer[print_buffer_len]),string,len);
+  print_buffer_len += len;
+}
+
+/****************************************************************************
+*
+*                   Procedure buffer_fixed
+*
+* Arguments: outfile: pointer to FILE
+*                val: real
+*               prec: int
+*              width: int
+*               left: char
+*
+* Returns: none
+*
+* Action: adds 'val, formatted by sprint_fixed, to the print buffer.
+*
+*****************************************************************************/
+static void buffer_fixed(FILE *outfile,real val,int prec,int width,char left)
+{
+  if( print_buffer_len + MAX_PRINT_FIELD > PRINT_BUFFER_SIZE ){
+    flush_print_buffer(outfile);
+  }
+  print_buffer_len += sprint_fixed(&(print_buffer[print_buffer_len]),
+                                   (double)val,prec,width,left);
+}
+
+/****************************************************************************
+*
+*                   Procedure buffer_int
+*
+* Arguments: outfile: pointer to FILE
+*                val: int
+*              width: int
+*               left: char
+*
+* Returns: none
+*
+* Action: adds 'val to the print buffer, like fprintf with "%*d"
+*   (or "%-*d").
+*
+*****************************************************************************/
+static void buffer_int(FILE *outfile,int val,int width,char left)
+{
+  if( print_buffer_len + MAX_PRINT_FIELD > PRINT_BUFFER_SIZE ){
+    flush_print_buffer(outfile);
+  }
+  print_buffer_len += sprint_fixed(&(print_buffer[print_buffer_len]),
+                                   (double)val,0,width,left);
+}
+
+/****************************************************************************
+*
+*                   Procedure orbital_labels
+*
+* Arguments:        num: int
+*                 atoms: pointer to atom_type
+*             num_atoms: int
+*  orbital_lookup_table: pointer to int
+*              num_orbs: int
+*          left_labels: pointer to pointer to char
+*        center_labels: pointer to pointer to char
+*
+* Returns: none
+*
+* Action: builds the names of the first 'num orbitals, left justified
+*   and centered in LABEL_WIDTH+1 character fields, so that
+*   print_labelled_mat doesn't have to look them up for every row.
+*
+*   The label for orbital i starts at 'left_labels[i*(LABEL_WIDTH+1)].
+*   the arrays are static and are reused by later calls.
+*
+*****************************************************************************/
+#define LABEL_WIDTH 18
+static void orbital_labels(int num,atom_type *atoms,int num_atoms,
+                           int *orbital_lookup_table,int num_orbs,
+                           char **left_labels,char **center_labels)
+{
+  static char *left_text=0,*center_text=0;
+  static int max_labels=0;
+  char name_string[80],just_string[80];
+  int i;
+
+  if( num > max_labels ){
+    left_text = (char *)my_realloc((int *)left_text,num*(LABEL_WIDTH+1)*sizeof(char));
+    center_text = (char *)my_realloc((int *)center_text,num*(LABEL_WIDTH+1)*sizeof(char));
+    if( !left_text || !center_text ) fatal("Can't allocate space for orbital labels.");
+    retag_memory(left_text,MEM_PERSISTENT);
+    retag_memory(center_text,MEM_PERSISTENT);
+    max_labels = num;
+  }
+
+  for(i=0;i<num;i++){
+    map_orb_num_to_name(name_string,i,orbital_lookup_table,
+                        num_orbs,atoms,num_atoms);
+    left_just_text_string(name_string,just_string,LABEL_WIDTH);
+    memcpy(&(left_text[i*(LABEL_WIDTH+1)]),just_string,LABEL_WIDTH+1);
+    center_text_string(name_string,just_string,LABEL_WIDTH);
+    memcpy(&(center_text[i*(LABEL_WIDTH+1)]),just_string,LABEL_WIDTH+1);
+  }
+  *left_labels = left_text;
+  *center_labels = center_text;
+}
+
+
 /****************************************************************************
 *
 *                   Procedure printmat
@@ -477,6 +729,12 @@ void printmat( real *mat, int num_row, int num_col, FILE *outfile, real tol,
   int cols_per_line;
   real val;
 
+  /* matrices can be left out of the output file entirely */
+  if( !print_text_mats && outfile == output_file ){
+    fprintf(outfile,";  (matrix not printed)\n");
+    return;
+  }
+
   /* figure out how many columns we get.... */
   cols_per_line = (int)floor((real)width/10);
 
@@ -501,23 +759,28 @@ void printmat( real *mat, int num_row, int num_col, FILE *outfile, real tol,
 
         /* start each row with a label */
         if( i >= 0 ){
-          fprintf(outfile,"%4d",i+1);
+          buffer_int(outfile,i+1,4,0);
         }
-        else fprintf(outfile,"    ");
+        else buffer_string(outfile,"    ",4);
 
         for( j=beg_col; j<end_col && j< num_col; j++ ){
 
           /* begin each column with a header */
-          if( i == -1) fprintf(outfile,"  %-7d",j+1);
+          if( i == -1){
+            buffer_string(outfile,"  ",2);
+            buffer_int(outfile,j+1,7,1);
+          }
           else{
             val = mat[i*num_col+j];
             /* check to see if the value is less than the tolerance */
             if( fabs(val) <= tol ) val = 0.0;
-            fprintf(outfile,"  %-6.4lf",val);
+            buffer_string(outfile,"  ",2);
+            buffer_fixed(outfile,val,4,6,1);
           }
         }
-        fprintf(outfile,"\n");
+        buffer_string(outfile,"\n",1);
       }
+      flush_print_buffer(outfile);
 
       beg_col=end_col;
       end_col+=cols_per_line;
@@ -536,23 +799,28 @@ void printmat( real *mat, int num_row, int num_col, FILE *outfile, real tol,
 
         /* start each row with a label */
         if( i >= 0 ){
-          fprintf(outfile,"%4d",i+1);
+          buffer_int(outfile,i+1,4,0);
         }
-        else fprintf(outfile,"    ");
+        else buffer_string(outfile,"    ",4);
 
         for( j=beg_row; j<end_row && j< num_row; j++ ){
 
           /* begin each column with a header */
-          if( i == -1) fprintf(outfile,"  %-7d",j+1);
+          if( i == -1){
+            buffer_string(outfile,"  ",2);
+            buffer_int(outfile,j+1,7,1);
+          }
           else{
             val = mat[j*num_col+i];
             /* check to see if the value is less than the tolerance */
             if( fabs(val) <= tol ) val = 0.0;
-            fprintf(outfile,"  %-6.4lf",val);
+            buffer_string(outfile,"  ",2);
+            buffer_fixed(outfile,val,4,6,1);
           }
         }
-        fprintf(outfile,"\n");
+        buffer_string(outfile,"\n",1);
       }
+      flush_print_buffer(outfile);
 
       beg_row=end_row;
       end_row+=cols_per_line;
@@ -591,19 +859,38 @@ void print_labelled_mat( real *mat, int num_row, int num_col, FILE *outfile, rea
                         int num_orbs,char transpose,char label_which,int width)
 {
   char name_string[80],just_string[80];
+  char *left_labels,*center_labels;
   int i,j;
   int beg_col,end_col;
   int beg_row,end_row;
   int which_part,num_parts;
   int cols_per_line;
+  int num_labels;
   real val;
 
+  /* matrices can be left out of the output file entirely */
+  if( !print_text_mats && outfile == output_file ){
+    fprintf(outfile,";  (matrix not printed)\n");
+    return;
+  }
+
   /* figure out how many columns we get.... */
   cols_per_line = (int)floor((real)width/18);
 
   /* we need to subtract one from this to leave room for the row labels */
   cols_per_line--;
 
+  /* look up the orbital names once, rather than once per row */
+  num_labels = 0;
+  if( label_which == LABEL_ROWS || label_which == LABEL_BOTH ){
+    num_labels = num_row;
+  }
+  if( (label_which == LABEL_COLS || label_which == LABEL_BOTH) &&
+      num_col > num_labels ){
+    num_labels = num_col;
+  }
+  orbital_labels(num_labels,atoms,num_atoms,orbital_lookup_table,num_orbs,
+                 &left_labels,&center_labels);
 
   beg_col = 0;
   beg_row = 0;
@@ -624,41 +911,37 @@ void print_labelled_mat( real *mat, int num_row, int num_col, FILE *outfile, rea
         /* start each row with a label */
         if( i >= 0 ){
           if( label_which == LABEL_ROWS || label_which == LABEL_BOTH ){
-            map_orb_num_to_name(name_string,i,orbital_lookup_table,
-                                num_orbs,atoms,num_atoms);
-            left_just_text_string(name_string,just_string,18);
-            fprintf(outfile,"%s",just_string);
+            buffer_string(outfile,&(left_labels[i*(LABEL_WIDTH+1)]),LABEL_WIDTH+1);
           }else{
-            fprintf(outfile,"%18d",i+1);
+            buffer_int(outfile,i+1,18,0);
           }
         }
-        else fprintf(outfile,"               ");
+        else buffer_string(outfile,"               ",15);
 
         for( j=beg_col; j<end_col && j< num_col; j++ ){
 
           /* begin each column with a header */
           if( i == -1){
             if( label_which == LABEL_COLS || label_which == LABEL_BOTH ){
-              map_orb_num_to_name(name_string,j,orbital_lookup_table,
-                                  num_orbs,atoms,num_atoms);
-              center_text_string(name_string,just_string,18);
-              fprintf(outfile,"%s",just_string);
+              buffer_string(outfile,&(center_labels[j*(LABEL_WIDTH+1)]),LABEL_WIDTH+1);
             }
             else{
               sprintf(name_string,"%d",j+1);
               center_text_string(name_string,just_string,18);
-              fprintf(outfile,"%s",just_string);
+              buffer_string(outfile,just_string,LABEL_WIDTH+1);
             }
           }
           else{
             val = mat[i*num_col+j];
             /* check to see if the value is less than the tolerance */
             if( fabs(val) <= tol ) val = 0.0;
-            fprintf(outfile," %-18.4lf",val);
+            buffer_string(outfile," ",1);
+            buffer_fixed(outfile,val,4,18,1);
           }
         }
-        fprintf(outfile,"\n");
+        buffer_string(outfile,"\n",1);
       }
+      flush_print_buffer(outfile);
 
       beg_col=end_col;
       end_col+=cols_per_line;
@@ -679,39 +962,35 @@ void print_labelled_mat( real *mat, int num_row, int num_col, FILE *outfile, rea
 
         if( i >= 0 ){
           if( label_which == LABEL_COLS || label_which == LABEL_BOTH ){
-            map_orb_num_to_name(name_string,i,orbital_lookup_table,
-                                num_orbs,atoms,num_atoms);
-            left_just_text_string(name_string,just_string,18);
-            fprintf(outfile,"%s",just_string);
+            buffer_string(outfile,&(left_labels[i*(LABEL_WIDTH+1)]),LABEL_WIDTH+1);
           }else{
-            fprintf(outfile,"%18d",i+1);
+            buffer_int(outfile,i+1,18,0);
           }
         }
-        else fprintf(outfile,"               ");
+        else buffer_string(outfile,"               ",15);
 
         for( j=beg_row; j<end_row && j< num_row; j++ ){
 
           /* begin each column with a header */
           if( i == -1){
             if( label_which == LABEL_ROWS || label_which == LABEL_BOTH ){
-              map_orb_num_to_name(name_string,j,orbital_lookup_table,
-                                  num_orbs,atoms,num_atoms);
-              center_text_string(name_string,just_string,18);
-              fprintf(outfile,"%s",just_string);
+              buffer_string(outfile,&(center_labels[j*(LABEL_WIDTH+1)]),LABEL_WIDTH+1);
             }else{
               sprintf(name_string,"%d",j+1);
               center_text_string(name_string,just_string,18);
-              fprintf(outfile,"%s",just_string);
+              buffer_string(outfile,just_string,LABEL_WIDTH+1);
             }
           }else{
             val = mat[j*num_col+i];
             /* check to see if the value is less than the tolerance */
             if( fabs(val) <= tol ) val = 0.0;
-            fprintf(outfile," %-18.4lf",val);
+            buffer_string(outfile," ",1);
+            buffer_fixed(outfile,val,4,18,1);
           }
         }
-        fprintf(outfile,"\n");
+        buffer_string(outfile,"\n",1);
       }
+      flush_print_buffer(outfile);
 
       beg_row=end_row;
       end_row+=cols_per_line;
@@ -757,6 +1036,12 @@ void print_sym_mat( real *mat, int num_row, int num_col, FILE *outfile, char *le
   int num_so_far;
   int cols_per_line;
 
+  /* matrices can be left out of the output file entirely */
+  if( !print_text_mats && outfile == output_file ){
+    fprintf(outfile,";  (matrix not printed)\n");
+    return;
+  }
+
   /* figure out how many columns we get.... */
   cols_per_line = (int)floor((real)width/10);
 
@@ -780,12 +1065,14 @@ void print_sym_mat( real *mat, int num_row, int num_col, FILE *outfile, char *le
 
   num_so_far = 0;
   for(which_part=0;which_part<num_parts;which_part++){
-    fprintf(outfile,"\n");
+    buffer_string(outfile,"\n",1);
     for( i=beg_col-1; i<num_row; i++ ){
 
       /* start each row with a label */
       if( i >= beg_col ){
         if( titles ){
+          /* the titles aren't necessarily terminated, so let fprintf do these */
+          flush_print_buffer(outfile);
           if( i<9 ){
             fprintf(outfile,"%4s(%4d)  ",&(titles[4*i]),i+1);
           } else if(i<99){
@@ -794,14 +1081,18 @@ void print_sym_mat( real *mat, int num_row, int num_col, FILE *outfile, char *le
             fprintf(outfile,"%4s(%4d) ",&(titles[4*i]),i+1);
           }
         }
-        else fprintf(outfile,"  %-7d",i+1);
+        else{
+          buffer_string(outfile,"  ",2);
+          buffer_int(outfile,i+1,7,1);
+        }
       }
-      else fprintf(outfile,"            ");
+      else buffer_string(outfile,"            ",12);
 
       /* begin each column with a header */
       if( i == beg_col-1){
         for(j=beg_col; j<end_col; j++ ){
           if( titles ){
+            flush_print_buffer(outfile);
             if( j<9 ){
               fprintf(outfile,"%4s(%4d)  ",&(titles[4*j]),j+1);
             } else if(j<99){
@@ -810,17 +1101,22 @@ void print_sym_mat( real *mat, int num_row, int num_col, FILE *outfile, char *le
               fprintf(outfile,"%4s(%4d)  ",&(titles[4*j]),j+1);
             }
           }
-          else fprintf(outfile,"  %-7d",j+1);
+          else{
+            buffer_string(outfile,"  ",2);
+            buffer_int(outfile,j+1,7,1);
+          }
         }
       }
       else{
         /* go ahead and print out the values for this row */
         for( j=beg_col; j<end_col && j<=i; j++ ){
-          fprintf(outfile,"  %-10.4f",mat[i*(i+1)/2 +j]);
+          buffer_string(outfile,"  ",2);
+          buffer_fixed(outfile,mat[i*(i+1)/2 +j],4,10,1);
         }
       }
-      fprintf(outfile,"\n");
+      buffer_string(outfile,"\n",1);
     }
+    flush_print_buffer(outfile);
 
 
     beg_col=end_col;
@@ -1131,6 +1427,20 @@ void check_for_errors(cell_type *cell,detail_type *details,int num_orbs)
     COOP_ptr = COOP_ptr->next_type;
   }
 
+  /* the geometry optimizer works with the molecular gradients */
+  if( details->do_geom_opt ){
+    if( details->Execution_Mode != MOLECULAR )
+      fatal("Geometry optimization can only be done for molecules.");
+    if( details->walsh_details.num_vars )
+      fatal("Geometry optimization can't be combined with a Walsh diagram.");
+    if( cell->geom_frags )
+      fatal("Geometry optimization can't be used with Geom Frags.");
+    if( details->do_chg_it || details->do_muller_it || details->vary_zeta )
+      fatal("Geometry optimization can't be combined with charge iteration.");
+    if( details->just_geom || details->just_matrices || details->just_avgE )
+      fatal("Geometry optimization needs the wavefunctions.");
+  }
+
   /* did they combine goofy stuff with the just_avgE option? */
   if( details->just_avgE ){
     if( details->num_FMO_frags )
@@ -1486,7 +1796,7 @@ void parse_integer_string(char *string,int **values,int *num_values)
   max_values = 10;
 
   /* if space in *values has already been allocated, blow it out now */
-  if( *values ) free(*values);
+  if( *values ) my_free(*values);
 
   /* get some initial memory */
   *values = (int *)calloc(max_values,sizeof(int));
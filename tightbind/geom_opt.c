@@ -0,0 +1,921 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file has the geometry optimizer for molecules.
+*
+*   Everything is done in-process: the matrices and work arrays which
+*    were allocated for the calculation are used for each energy
+*    evaluation, and the overlaps are only rebuilt when the atoms have
+*    moved (see overlaps_are_current).  The energy is the extended
+*    Hueckel energy, plus the electrostatic correction if that is being
+*    evaluated, and the gradients come from eval_gradients.
+*
+*   The optimization can be done in cartesian coordinates, in the Z
+*    matrix variables (bond lengths, and angles in radians) or in
+*    crystallographic coordinates, depending on how the geometry was
+*    given.  Gradients with respect to Z matrix variables are found
+*    from the cartesian ones using the derivatives of the atomic
+*    positions, which are done numerically (the Z matrix code is
+*    cheap compared to an energy evaluation).
+*
+*   Two methods are available: BFGS with a backtracking line search
+*    and FIRE (Bitzek et al. PRL _97_ 170201 (2006)).
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+/* the coordinates the optimization is done in */
+#define OPT_COORDS_CART 0
+#define OPT_COORDS_ZMAT 1
+#define OPT_COORDS_XTAL 2
+
+/* the types of Z matrix variables */
+#define ZMAT_BOND 0
+#define ZMAT_ANGLE 1
+#define ZMAT_DIHEDRAL 2
+
+/* step used for the derivatives of the positions with respect to Z matrix variables */
+#define ZMAT_DERIV_STEP 1e-5
+
+/* the initial guess at the Hessian (eV/Angstrom^2) used by BFGS */
+#define OPT_INIT_HESSIAN 70.0
+
+/* atoms further apart than this (in Angstrom) are taken to be in
+   different pieces of the molecule when looking for dissociation */
+#define OPT_DISSOC_DIST 10.0
+
+/* the FIRE constants that aren't in the input file */
+#define FIRE_ALPHA_START 0.1
+#define FIRE_F_ALPHA 0.99
+#define FIRE_F_INC 1.1
+#define FIRE_F_DEC 0.5
+#define FIRE_N_MIN 5
+
+/******
+  everything needed to evaluate the energy at a set of coordinates
+******/
+typedef struct {
+  cell_type *cell;
+  detail_type *details;
+  hermetian_matrix_type overlapR, hamilR;
+  complex *cmplx_hamil, *cmplx_overlap, *cmplx_work;
+  eigenset_type eigenset;
+  real *work1, *work2, *work3;
+  prop_type *properties;
+  int num_orbs, tot_overlaps;
+  int *orbital_lookup_table;
+
+  int coords;
+  int num_vars;
+  int *var_atom;  /* Z matrix: the atom each variable belongs to */
+  char *var_type; /* Z matrix: ZMAT_BOND, ZMAT_ANGLE or ZMAT_DIHEDRAL */
+  real tform[3][3];
+
+  point_type *cart_grads;
+  point_type *locs_plus, *locs_minus;
+
+  int *piece;      /* scratch space for count_pieces */
+  int num_pieces;  /* the number of pieces at the start */
+  char dissociated;
+
+  int num_evals;
+} opt_system_type;
+
+
+/****************************************************************************
+*
+*                   Procedure set_opt_coords
+*
+* Arguments: sys: pointer to opt_system_type
+*           vars: pointer to real
+*
+* Returns: none
+*
+* Action: puts the atoms where the optimization variables in 'vars say
+*   they should be.
+*
+*****************************************************************************/
+static void set_opt_coords(opt_system_type *sys,real *vars)
+{
+  cell_type *cell;
+  atom_type *atom;
+  int i;
+
+  cell = sys->cell;
+  switch(sys->coords){
+  case OPT_COORDS_ZMAT:
+    for(i=0;i<sys->num_vars;i++){
+      atom = &(cell->atoms[sys->var_atom[i]]);
+      switch(sys->var_type[i]){
+      case ZMAT_BOND: atom->Zmat_loc.bond_length = vars[i]; break;
+      case ZMAT_ANGLE: atom->Zmat_loc.alpha = vars[i]*180.0/PI; break;
+      default: atom->Zmat_loc.beta = vars[i]*180.0/PI; break;
+      }
+    }
+    eval_Zmat_locs(cell->atoms,cell->num_atoms,cell->dim,0);
+    break;
+  case OPT_COORDS_XTAL:
+    for(i=0;i<cell->num_atoms;i++){
+      atom = &(cell->atoms[i]);
+      atom->loc.x = sys->tform[0][0]*vars[3*i] + sys->tform[0][1]*vars[3*i+1] +
+        sys->tform[0][2]*vars[3*i+2];
+      atom->loc.y = sys->tform[1][0]*vars[3*i] + sys->tform[1][1]*vars[3*i+1] +
+        sys->tform[1][2]*vars[3*i+2];
+      atom->loc.z = sys->tform[2][0]*vars[3*i] + sys->tform[2][1]*vars[3*i+1] +
+        sys->tform[2][2]*vars[3*i+2];
+    }
+    break;
+  default:
+    for(i=0;i<cell->num_atoms;i++){
+      cell->atoms[i].loc.x = vars[3*i];
+      cell->atoms[i].loc.y = vars[3*i+1];
+      cell->atoms[i].loc.z = vars[3*i+2];
+    }
+    break;
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure get_opt_coords
+*
+* Arguments: sys: pointer to opt_system_type
+*           vars: pointer to real
+*
+* Returns: none
+*
+* Action: fills 'vars with the optimization variables for the current
+*   positions of the atoms.
+*
+*****************************************************************************/
+static void get_opt_coords(opt_system_type *sys,real *vars)
+{
+  cell_type *cell;
+  atom_type *atom;
+  int i;
+
+  cell = sys->cell;
+  switch(sys->coords){
+  case OPT_COORDS_ZMAT:
+    for(i=0;i<sys->num_vars;i++){
+      atom = &(cell->atoms[sys->var_atom[i]]);
+      switch(sys->var_type[i]){
+      case ZMAT_BOND: vars[i] = atom->Zmat_loc.bond_length; break;
+      case ZMAT_ANGLE: vars[i] = atom->Zmat_loc.alpha*PI/180.0; break;
+      default: vars[i] = atom->Zmat_loc.beta*PI/180.0; break;
+      }
+    }
+    break;
+  case OPT_COORDS_XTAL:
+    /* the transformation is upper triangular, so just back substitute */
+    for(i=0;i<cell->num_atoms;i++){
+      atom = &(cell->atoms[i]);
+      vars[3*i+2] = atom->loc.z/sys->tform[2][2];
+      vars[3*i+1] = (atom->loc.y - sys->tform[1][2]*vars[3*i+2])/sys->tform[1][1];
+      vars[3*i] = (atom->loc.x - sys->tform[0][1]*vars[3*i+1] -
+                   sys->tform[0][2]*vars[3*i+2])/sys->tform[0][0];
+    }
+    break;
+  default:
+    for(i=0;i<cell->num_atoms;i++){
+      vars[3*i] = cell->atoms[i].loc.x;
+      vars[3*i+1] = cell->atoms[i].loc.y;
+      vars[3*i+2] = cell->atoms[i].loc.z;
+    }
+    break;
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure opt_var_gradient
+*
+* Arguments: sys: pointer to opt_system_type
+*           vars: pointer to real
+*           grad: pointer to real
+*
+* Returns: none
+*
+* Action: converts the cartesian gradients in 'sys->cart_grads into the
+*   gradient with respect to the optimization variables.  The atoms
+*   are left where 'vars puts them.
+*
+*****************************************************************************/
+static void opt_var_gradient(opt_system_type *sys,real *vars,real *grad)
+{
+  cell_type *cell;
+  point_type *g;
+  real save;
+  int i,j;
+
+  cell = sys->cell;
+  g = sys->cart_grads;
+  switch(sys->coords){
+  case OPT_COORDS_ZMAT:
+    for(i=0;i<sys->num_vars;i++){
+      save = vars[i];
+      vars[i] = save + ZMAT_DERIV_STEP;
+      set_opt_coords(sys,vars);
+      for(j=0;j<cell->num_atoms;j++) sys->locs_plus[j] = cell->atoms[j].loc;
+      vars[i] = save - ZMAT_DERIV_STEP;
+      set_opt_coords(sys,vars);
+      for(j=0;j<cell->num_atoms;j++) sys->locs_minus[j] = cell->atoms[j].loc;
+      vars[i] = save;
+
+      grad[i] = 0.0;
+      for(j=0;j<cell->num_atoms;j++){
+        grad[i] += g[j].x*(sys->locs_plus[j].x - sys->locs_minus[j].x) +
+          g[j].y*(sys->locs_plus[j].y - sys->locs_minus[j].y) +
+          g[j].z*(sys->locs_plus[j].z - sys->locs_minus[j].z);
+      }
+      grad[i] /= 2.0*ZMAT_DERIV_STEP;
+    }
+    set_opt_coords(sys,vars);
+    break;
+  case OPT_COORDS_XTAL:
+    for(i=0;i<cell->num_atoms;i++){
+      grad[3*i] = sys->tform[0][0]*g[i].x + sys->tform[1][0]*g[i].y +
+        sys->tform[2][0]*g[i].z;
+      grad[3*i+1] = sys->tform[0][1]*g[i].x + sys->tform[1][1]*g[i].y +
+        sys->tform[2][1]*g[i].z;
+      grad[3*i+2] = sys->tform[0][2]*g[i].x + sys->tform[1][2]*g[i].y +
+        sys->tform[2][2]*g[i].z;
+    }
+    break;
+  default:
+    for(i=0;i<cell->num_atoms;i++){
+      grad[3*i] = g[i].x;
+      grad[3*i+1] = g[i].y;
+      grad[3*i+2] = g[i].z;
+    }
+    break;
+  }
+}
+
+/****************************************************************************
+*
+*                   Function opt_energy
+*
+* Arguments: sys: pointer to opt_system_type
+*           vars: pointer to real
+*           grad: pointer to real
+*
+* Returns: real
+*
+* Action: moves the atoms to 'vars, does the calculation and returns
+*   the energy (in eV).  The gradient with respect to the optimization
+*   variables is put in 'grad.
+*
+*****************************************************************************/
+static real opt_energy(opt_system_type *sys,real *vars,real *grad)
+{
+  cell_type *cell;
+  detail_type *details;
+  real energy,electrostat_term,eHMO_term;
+  int diag_error;
+  int i;
+
+  cell = sys->cell;
+  details = sys->details;
+  set_opt_coords(sys,vars);
+
+  if( !overlaps_are_current(cell,details,sys->overlapR.mat) ){
+    R_space_overlap_matrix(cell,details,sys->overlapR,sys->num_orbs,
+                           sys->tot_overlaps,sys->orbital_lookup_table,0);
+    mark_overlaps_current(cell,details,sys->overlapR.mat);
+    reset_overlap_factors(details);
+  }
+  full_R_space_Hamiltonian(cell,details,sys->overlapR,sys->hamilR,sys->num_orbs,
+                           sys->orbital_lookup_table,0);
+
+  /* the molecular diagonalization leaves the overlap matrix alone */
+  diagonalize_k_matrices(details,0,sys->num_orbs,sys->overlapR,sys->hamilR,
+                         sys->cmplx_hamil,sys->cmplx_overlap,sys->eigenset,
+                         sys->work1,sys->work2,sys->work3,sys->cmplx_work,
+                         &diag_error);
+  if( diag_error != 0 ){
+    error("Problems in the diagonalization during the geometry optimization.");
+  }
+
+  /* work2 holds the occupations from here on */
+  bzero((char *)sys->work2,sys->num_orbs*sizeof(real));
+  calc_occupations(details,cell->num_electrons,sys->num_orbs,sys->work2,
+                   sys->eigenset);
+
+  if( details->eval_electrostat ){
+    eval_electrostatics(cell,sys->num_orbs,sys->eigenset,sys->work2,
+                        sys->properties->OP_mat,sys->orbital_lookup_table,
+                        &electrostat_term,&eHMO_term,&energy,sys->work3,
+                        sys->properties->net_chgs);
+  } else{
+    energy = 0.0;
+    for(i=0;i<sys->num_orbs;i++){
+      energy += sys->work2[i]*EIGENVAL(sys->eigenset,i);
+    }
+  }
+
+  eval_gradients(cell,details,sys->num_orbs,sys->eigenset,sys->work2,
+                 sys->orbital_lookup_table,sys->cart_grads);
+  opt_var_gradient(sys,vars,grad);
+
+  sys->num_evals++;
+  return energy;
+}
+
+/****************************************************************************
+*
+*                   Function largest_force
+*
+* Arguments: sys: pointer to opt_system_type
+*
+* Returns: real
+*
+* Action: returns the length of the largest force on any atom for the
+*   last energy evaluation.
+*
+*****************************************************************************/
+static real largest_force(opt_system_type *sys)
+{
+  real max_force,temp;
+  point_type *g;
+  int i;
+
+  max_force = 0.0;
+  for(i=0;i<sys->cell->num_atoms;i++){
+    g = &(sys->cart_grads[i]);
+    temp = sqrt(g->x*g->x + g->y*g->y + g->z*g->z);
+    if( temp > max_force ) max_force = temp;
+  }
+  return max_force;
+}
+
+/****************************************************************************
+*
+*                   Function count_pieces
+*
+* Arguments: sys: pointer to opt_system_type
+*
+* Returns: int
+*
+* Action: returns the number of separate pieces the molecule is in.
+*   Atoms closer than OPT_DISSOC_DIST to each other are in the same piece.
+*
+*****************************************************************************/
+static int count_pieces(opt_system_type *sys)
+{
+  cell_type *cell;
+  int *piece;
+  int num_pieces;
+  int i,j,root_i,root_j;
+
+  cell = sys->cell;
+  piece = sys->piece;
+  for(i=0;i<cell->num_atoms;i++) piece[i] = i;
+
+  num_pieces = cell->num_atoms;
+  for(i=0;i<cell->num_atoms;i++){
+    for(j=0;j<i;j++){
+      if( atom_distance(cell,i,j) < OPT_DISSOC_DIST ){
+        for(root_i=i;piece[root_i]!=root_i;root_i=piece[root_i]);
+        for(root_j=j;piece[root_j]!=root_j;root_j=piece[root_j]);
+        if( root_i != root_j ){
+          piece[root_i] = root_j;
+          num_pieces--;
+        }
+      }
+    }
+  }
+  return num_pieces;
+}
+
+/****************************************************************************
+*
+*                   Function came_apart
+*
+* Arguments: sys: pointer to opt_system_type
+*
+* Returns: char
+*
+* Action: checks whether the molecule (as it is after the last energy
+*   evaluation) has come apart into more pieces than it started in.
+*   If it has, that is noted in sys->dissociated and 1 is returned.
+*
+*   Surfaces which go on down as the atoms fly apart can have forces
+*   small enough to pass the force test long before anything settles,
+*   so this keeps the optimizer from chasing them off to infinity.
+*
+*****************************************************************************/
+static char came_apart(opt_system_type *sys)
+{
+  if( count_pieces(sys) > sys->num_pieces ){
+    fprintf(status_file,
+            "Some atoms are more than %.1lf Angstrom from the rest of the molecule,\n"
+            "  stopping the optimization.\n",OPT_DISSOC_DIST);
+    sys->dissociated = 1;
+  }
+  return sys->dissociated;
+}
+
+/****************************************************************************
+*
+*                   Procedure limit_step
+*
+* Arguments: step: pointer to real
+*       num_vars: int
+*       max_disp: real
+*
+* Returns: none
+*
+* Action: scales 'step down (keeping its direction) so that no variable
+*   moves by more than 'max_disp.
+*
+*****************************************************************************/
+static void limit_step(real *step,int num_vars,real max_disp)
+{
+  real biggest;
+  int i;
+
+  biggest = 0.0;
+  for(i=0;i<num_vars;i++){
+    if( fabs(step[i]) > biggest ) biggest = fabs(step[i]);
+  }
+  if( biggest > max_disp ){
+    for(i=0;i<num_vars;i++) step[i] *= max_disp/biggest;
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure print_opt_step
+*
+* Arguments: step: int
+*         energy: real
+*      max_force: real
+*
+* Returns: none
+*
+*****************************************************************************/
+static void print_opt_step(int step,real energy,real max_force)
+{
+  fprintf(output_file,"#Opt_Step: %4d %16.8lf %12.6lf\n",step,energy,max_force);
+  fprintf(status_file,"Optimization step %d: E = %lf eV, largest force %lf eV/A\n",
+          step,energy,max_force);
+  fflush(status_file);
+}
+
+/****************************************************************************
+*
+*                   Function bfgs_minimize
+*
+* Arguments: sys: pointer to opt_system_type
+*           vars: pointer to real
+*          parms: pointer to geom_opt_parm_type
+*      num_steps: pointer to int
+*
+* Returns: int
+*
+* Action: minimizes the energy using BFGS updates of the inverse
+*   Hessian and a backtracking (Armijo) line search.  'vars has the
+*   starting point on entry and the best point found on exit.
+*
+*   returns 1 if the optimization converged, 0 otherwise.
+*
+*****************************************************************************/
+static int bfgs_minimize(opt_system_type *sys,real *vars,geom_opt_parm_type *parms,
+                         int *num_steps)
+{
+  real *grad,*new_vars,*new_grad,*dir,*s,*y,*Hy,*inv_hess;
+  real energy,new_energy,max_force;
+  real slope,alpha,sy,yHy,yy,temp;
+  arena_mark_type mark;
+  int num_vars;
+  int step,line_step,i,j;
+  char fresh_hessian,converged;
+
+  num_vars = sys->num_vars;
+  mark = arena_mark(&cycle_arena);
+  grad = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  new_vars = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  new_grad = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  dir = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  s = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  y = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  Hy = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  inv_hess = (real *)arena_calloc(&cycle_arena,num_vars*num_vars,sizeof(real));
+
+  for(i=0;i<num_vars;i++) inv_hess[i*num_vars+i] = 1.0/OPT_INIT_HESSIAN;
+  fresh_hessian = 1;
+
+  energy = opt_energy(sys,vars,grad);
+  max_force = largest_force(sys);
+  print_opt_step(0,energy,max_force);
+
+  converged = 0;
+  for(step=1;step<=parms->max_steps && !converged;step++){
+    /* the search direction */
+    slope = 0.0;
+    for(i=0;i<num_vars;i++){
+      dir[i] = 0.0;
+      for(j=0;j<num_vars;j++) dir[i] -= inv_hess[i*num_vars+j]*grad[j];
+    }
+    limit_step(dir,num_vars,parms->max_disp);
+    for(i=0;i<num_vars;i++) slope += dir[i]*grad[i];
+
+    /* if it's not downhill the Hessian has gone bad, start over */
+    if( slope >= 0.0 ){
+      bzero((char *)inv_hess,num_vars*num_vars*sizeof(real));
+      for(i=0;i<num_vars;i++) inv_hess[i*num_vars+i] = 1.0/OPT_INIT_HESSIAN;
+      fresh_hessian = 1;
+      slope = 0.0;
+      for(i=0;i<num_vars;i++) dir[i] = -grad[i]/OPT_INIT_HESSIAN;
+      limit_step(dir,num_vars,parms->max_disp);
+      for(i=0;i<num_vars;i++) slope += dir[i]*grad[i];
+    }
+
+    /* backtrack until the energy goes down enough */
+    alpha = 1.0;
+    new_energy = energy;
+    for(line_step=0;line_step<parms->max_line_steps;line_step++){
+      for(i=0;i<num_vars;i++) new_vars[i] = vars[i] + alpha*dir[i];
+      new_energy = opt_energy(sys,new_vars,new_grad);
+      if( new_energy <= energy + parms->armijo*alpha*slope ) break;
+      alpha *= parms->backtrack;
+    }
+    if( line_step == parms->max_line_steps ){
+      if( fresh_hessian ){
+        /* the energy can't be lowered any more, so small forces are good enough */
+        fprintf(status_file,"The line search failed, stopping the optimization.\n");
+        converged = max_force <= parms->force_tol;
+        break;
+      }
+      /* try again from the gradient direction */
+      fprintf(status_file,"The line search failed, resetting the Hessian.\n");
+      bzero((char *)inv_hess,num_vars*num_vars*sizeof(real));
+      for(i=0;i<num_vars;i++) inv_hess[i*num_vars+i] = 1.0/OPT_INIT_HESSIAN;
+      fresh_hessian = 1;
+      step--;
+      continue;
+    }
+
+    sy = yy = 0.0;
+    for(i=0;i<num_vars;i++){
+      s[i] = new_vars[i] - vars[i];
+      y[i] = new_grad[i] - grad[i];
+      sy += s[i]*y[i];
+      yy += y[i]*y[i];
+    }
+    temp = energy;
+    bcopy((char *)new_vars,(char *)vars,num_vars*sizeof(real));
+    bcopy((char *)new_grad,(char *)grad,num_vars*sizeof(real));
+    energy = new_energy;
+    max_force = largest_force(sys);
+    print_opt_step(step,energy,max_force);
+    *num_steps = step;
+
+    if( came_apart(sys) ) break;
+    if( max_force <= parms->force_tol && fabs(energy-temp) <= parms->energy_tol ){
+      converged = 1;
+      break;
+    }
+
+    /*******
+      update the inverse Hessian.  The first time through the
+      starting guess is rescaled to match the curvature that's been
+      seen.
+    *******/
+    if( sy > 1e-10 ){
+      if( fresh_hessian ){
+        bzero((char *)inv_hess,num_vars*num_vars*sizeof(real));
+        for(i=0;i<num_vars;i++) inv_hess[i*num_vars+i] = sy/yy;
+        fresh_hessian = 0;
+      }
+      yHy = 0.0;
+      for(i=0;i<num_vars;i++){
+        Hy[i] = 0.0;
+        for(j=0;j<num_vars;j++) Hy[i] += inv_hess[i*num_vars+j]*y[j];
+        yHy += y[i]*Hy[i];
+      }
+      for(i=0;i<num_vars;i++){
+        for(j=0;j<num_vars;j++){
+          inv_hess[i*num_vars+j] += (sy+yHy)*s[i]*s[j]/(sy*sy) -
+            (Hy[i]*s[j] + s[i]*Hy[j])/sy;
+        }
+      }
+    }
+  }
+
+  arena_release(&cycle_arena,mark);
+  return converged;
+}
+
+/****************************************************************************
+*
+*                   Function fire_minimize
+*
+* Arguments: sys: pointer to opt_system_type
+*           vars: pointer to real
+*          parms: pointer to geom_opt_parm_type
+*      num_steps: pointer to int
+*
+* Returns: int
+*
+* Action: minimizes the energy with the fast inertial relaxation engine.
+*   'vars has the starting point on entry and the last point on exit.
+*
+*   returns 1 if the optimization converged, 0 otherwise.
+*
+*****************************************************************************/
+static int fire_minimize(opt_system_type *sys,real *vars,geom_opt_parm_type *parms,
+                         int *num_steps)
+{
+  real *grad,*velocity,*disp;
+  real energy,old_energy,max_force;
+  real power,v_norm,f_norm;
+  real time_step,alpha;
+  arena_mark_type mark;
+  int num_vars;
+  int step,num_downhill,i;
+  char converged;
+
+  num_vars = sys->num_vars;
+  mark = arena_mark(&cycle_arena);
+  grad = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  velocity = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+  disp = (real *)arena_calloc(&cycle_arena,num_vars,sizeof(real));
+
+  time_step = parms->time_step;
+  alpha = FIRE_ALPHA_START;
+  num_downhill = 0;
+
+  energy = opt_energy(sys,vars,grad);
+  max_force = largest_force(sys);
+  print_opt_step(0,energy,max_force);
+
+  converged = 0;
+  for(step=1;step<=parms->max_steps;step++){
+    /* the force is minus the gradient */
+    power = v_norm = f_norm = 0.0;
+    for(i=0;i<num_vars;i++){
+      power -= grad[i]*velocity[i];
+      v_norm += velocity[i]*velocity[i];
+      f_norm += grad[i]*grad[i];
+    }
+    v_norm = sqrt(v_norm);
+    f_norm = sqrt(f_norm);
+
+    if( power > 0.0 ){
+      /* going downhill: turn the velocity towards the force and speed up */
+      for(i=0;i<num_vars;i++){
+        velocity[i] = (1.0-alpha)*velocity[i] - alpha*v_norm*grad[i]/f_norm;
+      }
+      num_downhill++;
+      if( num_downhill > FIRE_N_MIN ){
+        time_step *= FIRE_F_INC;
+        if( time_step > parms->max_time_step ) time_step = parms->max_time_step;
+        alpha *= FIRE_F_ALPHA;
+      }
+    } else{
+      /* uphill: stop and start again more carefully */
+      bzero((char *)velocity,num_vars*sizeof(real));
+      time_step *= FIRE_F_DEC;
+      alpha = FIRE_ALPHA_START;
+      num_downhill = 0;
+    }
+
+    for(i=0;i<num_vars;i++){
+      velocity[i] -= time_step*grad[i];
+      disp[i] = time_step*velocity[i];
+    }
+    limit_step(disp,num_vars,parms->max_disp);
+    for(i=0;i<num_vars;i++) vars[i] += disp[i];
+
+    old_energy = energy;
+    energy = opt_energy(sys,vars,grad);
+    max_force = largest_force(sys);
+    print_opt_step(step,energy,max_force);
+    *num_steps = step;
+
+    if( came_apart(sys) ) break;
+    if( max_force <= parms->force_tol && fabs(energy-old_energy) <= parms->energy_tol ){
+      converged = 1;
+      break;
+    }
+  }
+
+  arena_release(&cycle_arena,mark);
+  return converged;
+}
+
+/****************************************************************************
+*
+*                   Procedure optimize_geometry
+*
+* Arguments:  cell: pointer to cell type
+*          details: pointer to detail type
+*          overlapR: hermetian_matrix_type
+*            hamilR: hermetian_matrix_type
+*   cmplx_hamil, cmplx_overlap: pointers to complex
+*          eigenset: eigenset_type
+* work1,work2,work3: pointers to reals
+*        cmplx_work: pointer to complex
+*        properties: pointer to prop_type
+*          num_orbs: int
+*      tot_overlaps: int
+* orbital_lookup_table: pointer to int
+*
+* Returns: none
+*
+* Action: moves the atoms in 'cell to a minimum of the energy using the
+*   settings in 'details->geom_opt_parms.  The matrices and work arrays
+*   are the ones used for the rest of the calculation (see
+*   loop_over_k_points for their dimensions); what's left in them
+*   afterwards shouldn't be used.
+*
+*   The progress and the final geometry are written to the output file.
+*
+*****************************************************************************/
+void optimize_geometry(cell_type *cell,detail_type *details,
+                       hermetian_matrix_type overlapR,hermetian_matrix_type hamilR,
+                       complex *cmplx_hamil,complex *cmplx_overlap,
+                       eigenset_type eigenset,real *work1,real *work2,real *work3,
+                       complex *cmplx_work,prop_type *properties,
+                       int num_orbs,int tot_overlaps,int *orbital_lookup_table)
+{
+  opt_system_type sys;
+  geom_opt_parm_type *parms;
+  real *vars;
+  real cell_volume;
+  arena_mark_type mark;
+  atom_type *atom;
+  char *opt_label;
+  int num_steps,converged;
+  int i,which;
+
+  if( details->Execution_Mode != MOLECULAR )
+    FATAL_BUG("optimize_geometry called for an extended system.");
+
+  parms = &(details->geom_opt_parms);
+  bzero((char *)&sys,sizeof(opt_system_type));
+  sys.cell = cell;
+  sys.details = details;
+  sys.overlapR = overlapR;
+  sys.hamilR = hamilR;
+  sys.cmplx_hamil = cmplx_hamil;
+  sys.cmplx_overlap = cmplx_overlap;
+  sys.cmplx_work = cmplx_work;
+  sys.eigenset = eigenset;
+  sys.work1 = work1;
+  sys.work2 = work2;
+  sys.work3 = work3;
+  sys.properties = properties;
+  sys.num_orbs = num_orbs;
+  sys.tot_overlaps = tot_overlaps;
+  sys.orbital_lookup_table = orbital_lookup_table;
+
+  mark = arena_mark(&cycle_arena);
+  sys.cart_grads = (point_type *)arena_calloc(&cycle_arena,cell->num_atoms,
+                                              sizeof(point_type));
+  sys.piece = (int *)arena_calloc(&cycle_arena,cell->num_atoms,sizeof(int));
+  sys.num_pieces = count_pieces(&sys);
+
+  /* figure out what the variables are */
+  if( cell->using_Zmat && !parms->cartesian ){
+    sys.coords = OPT_COORDS_ZMAT;
+    sys.var_atom = (int *)arena_calloc(&cycle_arena,3*cell->num_atoms,sizeof(int));
+    sys.var_type = (char *)arena_calloc(&cycle_arena,3*cell->num_atoms,sizeof(char));
+    sys.locs_plus = (point_type *)arena_calloc(&cycle_arena,cell->num_atoms,
+                                               sizeof(point_type));
+    sys.locs_minus = (point_type *)arena_calloc(&cycle_arena,cell->num_atoms,
+                                                sizeof(point_type));
+    /* the first atom has no variables, the second a bond length, etc. */
+    for(i=1;i<cell->num_atoms;i++){
+      which = find_atom(cell->atoms,cell->num_atoms,i);
+      sys.var_atom[sys.num_vars] = which;
+      sys.var_type[sys.num_vars++] = ZMAT_BOND;
+      if( i > 1 ){
+        sys.var_atom[sys.num_vars] = which;
+        sys.var_type[sys.num_vars++] = ZMAT_ANGLE;
+      }
+      if( i > 2 ){
+        sys.var_atom[sys.num_vars] = which;
+        sys.var_type[sys.num_vars++] = ZMAT_DIHEDRAL;
+      }
+    }
+  } else if( cell->using_xtal_coords && !parms->cartesian ){
+    sys.coords = OPT_COORDS_XTAL;
+    sys.num_vars = 3*cell->num_atoms;
+    xtal_coord_tform(cell,sys.tform,&cell_volume);
+  } else{
+    sys.coords = OPT_COORDS_CART;
+    sys.num_vars = 3*cell->num_atoms;
+  }
+  if( !sys.num_vars ){
+    error("There's nothing to optimize.");
+    arena_release(&cycle_arena,mark);
+    return;
+  }
+  vars = (real *)arena_calloc(&cycle_arena,sys.num_vars,sizeof(real));
+  get_opt_coords(&sys,vars);
+
+  fprintf(output_file,"\n; Geometry Optimization (%s in ",
+          parms->method == OPT_FIRE ? "FIRE" : "BFGS");
+  switch(sys.coords){
+  case OPT_COORDS_ZMAT: fprintf(output_file,"Z matrix"); break;
+  case OPT_COORDS_XTAL: fprintf(output_file,"crystallographic"); break;
+  default: fprintf(output_file,"cartesian"); break;
+  }
+  fprintf(output_file," coordinates, %d variables)\n",sys.num_vars);
+  fprintf(output_file,";  Energies in eV, forces in eV/Angstrom\n");
+  fprintf(output_file,";  Step          Energy  Largest Force\n");
+
+  num_steps = 0;
+  if( parms->method == OPT_FIRE ){
+    converged = fire_minimize(&sys,vars,parms,&num_steps);
+  } else{
+    converged = bfgs_minimize(&sys,vars,parms,&num_steps);
+  }
+
+  /* the last energy evaluation may not have been at the final point */
+  set_opt_coords(&sys,vars);
+
+  if( converged ){
+    fprintf(output_file,"; The geometry optimization converged after %d steps",
+            num_steps);
+  } else if( sys.dissociated ){
+    fprintf(output_file,"; The geometry optimization was stopped after %d steps "
+            "because the molecule came apart",num_steps);
+    error("The molecule came apart during the geometry optimization.");
+  } else{
+    fprintf(output_file,"; The geometry optimization did NOT converge after %d steps",
+            num_steps);
+    error("The geometry optimization did not converge.");
+  }
+  fprintf(output_file," (%d energy evaluations).\n",sys.num_evals);
+  fprintf(status_file,"Geometry optimization finished after %d energy evaluations.\n",
+          sys.num_evals);
+
+  /* a geometry which has come apart isn't a minimum of anything */
+  opt_label = sys.dissociated ? "Last step" : "Optimized";
+
+  if( sys.coords == OPT_COORDS_ZMAT ){
+    fprintf(output_file,"# %s Z matrix\n",opt_label);
+    for(i=0;i<cell->num_atoms;i++){
+      atom = &(cell->atoms[i]);
+      fprintf(output_file,"%4d %4s",i+1,atom->symb);
+      if( atom->which_atom > 0 )
+        fprintf(output_file," %4d %8.4lf",atom->Zmat_loc.ref1+1,
+                atom->Zmat_loc.bond_length);
+      if( atom->which_atom > 1 )
+        fprintf(output_file," %4d %8.4lf",atom->Zmat_loc.ref2+1,atom->Zmat_loc.alpha);
+      if( atom->which_atom > 2 )
+        fprintf(output_file," %4d %8.4lf",atom->Zmat_loc.ref3+1,atom->Zmat_loc.beta);
+      fprintf(output_file,"\n");
+    }
+  } else if( sys.coords == OPT_COORDS_XTAL ){
+    fprintf(output_file,"# %s crystallographic coordinates\n",opt_label);
+    for(i=0;i<cell->num_atoms;i++){
+      fprintf(output_file,"%4d %4s %8.4lf %8.4lf %8.4lf\n",i+1,
+              cell->atoms[i].symb,vars[3*i],vars[3*i+1],vars[3*i+2]);
+    }
+  }
+  fprintf(output_file,"# %s positions of atoms\n",opt_label);
+  for(i=0;i<cell->num_atoms;i++){
+    fprintf(output_file,"%4d %4s %8.4lf %8.4lf %8.4lf\n",i+1,
+            cell->atoms[i].symb,cell->atoms[i].loc.x,
+            cell->atoms[i].loc.y,cell->atoms[i].loc.z);
+  }
+
+  arena_release(&cycle_arena,mark);
+}
@@ -74,4 +74,12 @@ prop_type properties;
 avg_prop_info_type *avg_prop_info;
 K_orb_ptr_type *orbital_ordering;
 
+/* scratch space for a single k point and for a single SCF cycle */
+arena_type kpoint_arena,cycle_arena;
+
 bool print_progress = false;
+bool print_text_mats = true;
+bool restart_run = false;
+bool force_binary_results = false;
+jmp_buf *fatal_trap = 0;
+char fatal_message[MAX_STR_LEN];
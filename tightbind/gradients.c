@@ -0,0 +1,453 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the analytic energy gradients for molecules.
+*
+*   The extended Hueckel energy is a sum of occupied eigenvalues, so
+*    (Hellmann-Feynman for H C = S C E) its derivative is
+*
+*       dE = sum_ij (P_ij dH_ij - W_ij dS_ij)
+*
+*    where P is the density matrix and W the energy weighted one.  Off
+*    diagonal H_ij are just h_ij * S_ij, with h_ij fixed by the Hii's,
+*    so everything comes down to the derivatives of the overlaps between
+*    pairs of atoms.
+*
+*   Those are done in two pieces: stretching the bond (the derivative
+*    of the radial integrals, see mov_derivative) and turning it.  An
+*    overlap doesn't change when both atoms' orbitals and the bond are
+*    rotated together, so turning the bond is the same as rotating the
+*    two sets of orbitals the other way.  That's what the generators
+*    below do: rotating about axis n by a small angle e takes the
+*    orbitals of a shell into (1 + e n.G) times themselves.
+*
+*   Gradients are in eV/Angstrom.  The Hii's are held fixed, so for
+*    charge iteration runs this is the gradient of the final Hamiltonian.
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+/* the most orbitals one atom can have (s+p+d+f) */
+#define ATOM_ORBS 16
+
+/******
+  the rotation generators for the p, d and f shells about the x, y and z
+  axes, in the order the orbitals are used in the program (for the f's:
+  z3, xz2, yz2, xyz, z(x2-y2), x(x2-3y2), y(3x2-y2)).  Element [a*dim+b]
+  is the amount of orbital a in the rotated orbital b.
+******/
+static const real p_generators[3][9]={
+  /* x */
+  {
+    0,0,0,
+    0,0,-1,
+    0,1,0
+  },
+  /* y */
+  {
+    0,0,1,
+    0,0,0,
+    -1,0,0
+  },
+  /* z */
+  {
+    0,-1,0,
+    1,0,0,
+    0,0,0
+  }
+};
+static const real d_generators[3][25]={
+  /* x */
+  {
+    0,0,0,0,1,
+    0,0,0,0,SQRT3,
+    0,0,0,-1,0,
+    0,0,1,0,0,
+    -1,-SQRT3,0,0,0
+  },
+  /* y */
+  {
+    0,0,0,1,0,
+    0,0,0,-SQRT3,0,
+    0,0,0,0,1,
+    -1,SQRT3,0,0,0,
+    0,0,-1,0,0
+  },
+  /* z */
+  {
+    0,0,-2,0,0,
+    0,0,0,0,0,
+    2,0,0,0,0,
+    0,0,0,0,-1,
+    0,0,0,1,0
+  }
+};
+static const real f_generators[3][49]={
+  /* x */
+  {
+    0,0,SQRT6,0,0,0,0,
+    0,0,0,SQRT10/2,0,0,0,
+    -SQRT6,0,0,0,-SQRT10/2,0,0,
+    0,-SQRT10/2,0,0,0,-SQRT6/2,0,
+    0,0,SQRT10/2,0,0,0,SQRT6/2,
+    0,0,0,SQRT6/2,0,0,0,
+    0,0,0,0,-SQRT6/2,0,0
+  },
+  /* y */
+  {
+    0,-SQRT6,0,0,0,0,0,
+    SQRT6,0,0,0,-SQRT10/2,0,0,
+    0,0,0,-SQRT10/2,0,0,0,
+    0,0,SQRT10/2,0,0,0,-SQRT6/2,
+    0,SQRT10/2,0,0,0,-SQRT6/2,0,
+    0,0,0,0,SQRT6/2,0,0,
+    0,0,0,SQRT6/2,0,0,0
+  },
+  /* z */
+  {
+    0,0,0,0,0,0,0,
+    0,0,-1,0,0,0,0,
+    0,1,0,0,0,0,0,
+    0,0,0,0,2,0,0,
+    0,0,0,-2,0,0,0,
+    0,0,0,0,0,0,-3,
+    0,0,0,0,0,3,0
+  }
+};
+
+
+/****************************************************************************
+*
+*                   Procedure rotate_block
+*
+* Arguments: dblock: pointer to real
+*             block: pointer to real
+*      atomA, atomB: pointers to atom_type
+*              axis: point_type
+*
+* Returns: none
+*
+* Action: adds the change in the overlaps between 'atomA and 'atomB
+*   ('block, as filled by R_overlap_pair) when the bond between them is
+*   turned about 'axis to 'dblock.  The length of 'axis is the angle.
+*
+*****************************************************************************/
+static void rotate_block(real *dblock,real *block,atom_type *atomA,
+                         atom_type *atomB,point_type axis)
+{
+  static const real *generators[4][3]={
+    {0,0,0},
+    {p_generators[0],p_generators[1],p_generators[2]},
+    {d_generators[0],d_generators[1],d_generators[2]},
+    {f_generators[0],f_generators[1],f_generators[2]}};
+  static const int shell_begin[4]={BEGIN_S,BEGIN_P,BEGIN_D,BEGIN_F};
+  real gen[49];
+  real accum;
+  int has_shellA,has_shellB;
+  int l,dim,begin;
+  int a,b,c;
+
+  for(l=1;l<4;l++){
+    switch(l){
+    case 1:
+      has_shellA = atomA->np;
+      has_shellB = atomB->np;
+      break;
+    case 2:
+      has_shellA = atomA->nd;
+      has_shellB = atomB->nd;
+      break;
+    default:
+      has_shellA = atomA->nf;
+      has_shellB = atomB->nf;
+      break;
+    }
+    if( !has_shellA && !has_shellB ) continue;
+
+    dim = 2*l+1;
+    begin = shell_begin[l];
+    for(a=0;a<dim*dim;a++){
+      gen[a] = axis.x*generators[l][0][a] + axis.y*generators[l][1][a] +
+        axis.z*generators[l][2][a];
+    }
+
+    /* atom A's orbitals turn with the bond... */
+    if( has_shellA ){
+      for(a=0;a<dim;a++){
+        for(b=0;b<ATOM_ORBS;b++){
+          accum = 0.0;
+          for(c=0;c<dim;c++){
+            accum += gen[a*dim+c]*block[(begin+c)*ATOM_ORBS+b];
+          }
+          dblock[(begin+a)*ATOM_ORBS+b] += accum;
+        }
+      }
+    }
+    /* ... and so do B's (the generators are antisymmetric) */
+    if( has_shellB ){
+      for(a=0;a<ATOM_ORBS;a++){
+        for(b=0;b<dim;b++){
+          accum = 0.0;
+          for(c=0;c<dim;c++){
+            accum += block[a*ATOM_ORBS+begin+c]*gen[c*dim+b];
+          }
+          dblock[a*ATOM_ORBS+begin+b] -= accum;
+        }
+      }
+    }
+  }
+}
+
+
+/****************************************************************************
+*
+*                   Procedure eval_gradients
+*
+* Arguments: cell: pointer to cell_type
+*         details: pointer to detail_type
+*        num_orbs: int
+*        eigenset: eigenset_type
+*     occupations: pointer to real
+* orbital_lookup_table: pointer to int
+*       gradients: pointer to point_type
+*
+* Returns: none
+*
+* Action: fills 'gradients (one per atom) with the derivatives of the
+*   energy with respect to the positions of the atoms, for a molecular
+*   calculation which has just been done.  If the electrostatic
+*   correction is being evaluated, its gradient is included.
+*
+*****************************************************************************/
+void eval_gradients(cell_type *cell,detail_type *details,int num_orbs,
+                    eigenset_type eigenset,real *occupations,
+                    int *orbital_lookup_table,point_type *gradients)
+{
+  real *weights,*diagonal_elements;
+  real block[ATOM_ORBS*ATOM_ORBS],rad_block[ATOM_ORBS*ATOM_ORBS];
+  real dblock[ATOM_ORBS*ATOM_ORBS];
+  real dens,e_dens,Hij,temp,temp2;
+  real tot_dist,grad;
+  point_type dist_vect,unit,axis;
+  atom_type *atom_ptr;
+  arena_mark_type mark;
+  int i,j,k,orb_tab;
+  int beginA,endA,beginB,endB;
+  int a,b,dir;
+
+  if( details->Execution_Mode != MOLECULAR )
+    FATAL_BUG("eval_gradients called for an extended system.");
+
+  mark = arena_mark(&cycle_arena);
+  weights = (real *)arena_calloc(&cycle_arena,num_orbs*num_orbs,sizeof(real));
+  diagonal_elements = (real *)arena_calloc(&cycle_arena,num_orbs,sizeof(real));
+
+  /* the Hii's */
+  for(i=0;i<cell->num_atoms;i++){
+    atom_ptr = &(cell->atoms[i]);
+    orb_tab = orbital_lookup_table[i];
+    if( orb_tab >= 0 ){
+      if( atom_ptr->ns != 0 ) diagonal_elements[orb_tab+BEGIN_S] = atom_ptr->coul_s;
+      if( atom_ptr->np != 0 )
+        for(j=BEGIN_P;j<=END_P;j++) diagonal_elements[orb_tab+j] = atom_ptr->coul_p;
+      if( atom_ptr->nd != 0 )
+        for(j=BEGIN_D;j<=END_D;j++) diagonal_elements[orb_tab+j] = atom_ptr->coul_d;
+      if( atom_ptr->nf != 0 )
+        for(j=BEGIN_F;j<=END_F;j++) diagonal_elements[orb_tab+j] = atom_ptr->coul_f;
+    }
+  }
+
+  /*******
+    the weight of dS_ij in the gradient: P_ij h_ij - W_ij
+  *******/
+  for(i=1;i<num_orbs;i++){
+    for(j=0;j<i;j++){
+      dens = e_dens = 0.0;
+      for(k=0;k<num_orbs;k++){
+        if( occupations[k] == 0.0 ) continue;
+        temp = occupations[k]*EIGENVECT_R(eigenset,k,i)*EIGENVECT_R(eigenset,k,j);
+        dens += temp;
+        e_dens += temp*EIGENVAL(eigenset,k);
+      }
+      /* this is the same as in full_R_space_Hamiltonian */
+      if( details->weighted_Hij ){
+        temp = diagonal_elements[i]+diagonal_elements[j];
+        temp2 = (diagonal_elements[i]-diagonal_elements[j])/temp;
+        temp2 = temp2*temp2;
+        temp2 = .5*(details->the_const + temp2 + temp2*temp2*(1-details->the_const));
+        Hij = temp2*temp;
+      }
+      else{
+        Hij = .5*details->the_const*(diagonal_elements[i]+diagonal_elements[j]);
+      }
+      weights[i*num_orbs+j] = weights[j*num_orbs+i] = dens*Hij - e_dens;
+    }
+  }
+
+  /* overlaps which were turned off don't change either */
+  if( details->num_overlaps_off && details->overlaps_off ){
+    zero_overlaps(weights,details,num_orbs,cell->num_atoms,1,
+                  orbital_lookup_table);
+  }
+
+  bzero((char *)gradients,cell->num_atoms*sizeof(point_type));
+  for(i=0;i<cell->num_atoms;i++){
+    find_atoms_orbs(num_orbs,cell->num_atoms,i,orbital_lookup_table,
+                    &beginA,&endA);
+    if( beginA < 0 ) continue;
+    for(j=0;j<i;j++){
+      find_atoms_orbs(num_orbs,cell->num_atoms,j,orbital_lookup_table,
+                      &beginB,&endB);
+      if( beginB < 0 ) continue;
+
+      dist_vect.x = cell->atoms[i].loc.x - cell->atoms[j].loc.x;
+      dist_vect.y = cell->atoms[i].loc.y - cell->atoms[j].loc.y;
+      dist_vect.z = cell->atoms[i].loc.z - cell->atoms[j].loc.z;
+      tot_dist = sqrt(dist_vect.x*dist_vect.x + dist_vect.y*dist_vect.y +
+                      dist_vect.z*dist_vect.z);
+      /* these are the same cutoffs calc_R_overlap uses */
+      if( tot_dist < 1e-6 || tot_dist > details->rho ) continue;
+
+      bzero((char *)block,ATOM_ORBS*ATOM_ORBS*sizeof(real));
+      bzero((char *)rad_block,ATOM_ORBS*ATOM_ORBS*sizeof(real));
+      R_overlap_pair(block,ATOM_ORBS,cell,i,j,dist_vect,0);
+      R_overlap_pair(rad_block,ATOM_ORBS,cell,i,j,dist_vect,1);
+
+      unit.x = dist_vect.x/tot_dist;
+      unit.y = dist_vect.y/tot_dist;
+      unit.z = dist_vect.z/tot_dist;
+      for(dir=0;dir<3;dir++){
+        /*******
+          moving atom i along dir stretches the bond by unit.dir and
+          turns it about unit x dir by 1/tot_dist.
+          (rad_block is per bohr)
+        *******/
+        switch(dir){
+        case 0:
+          temp = unit.x;
+          axis.x = 0.0; axis.y = unit.z; axis.z = -unit.y;
+          break;
+        case 1:
+          temp = unit.y;
+          axis.x = -unit.z; axis.y = 0.0; axis.z = unit.x;
+          break;
+        default:
+          temp = unit.z;
+          axis.x = unit.y; axis.y = -unit.x; axis.z = 0.0;
+          break;
+        }
+        temp *= AUI;
+        axis.x /= tot_dist;
+        axis.y /= tot_dist;
+        axis.z /= tot_dist;
+
+        for(a=0;a<ATOM_ORBS*ATOM_ORBS;a++) dblock[a] = temp*rad_block[a];
+        rotate_block(dblock,block,&(cell->atoms[i]),&(cell->atoms[j]),axis);
+
+        /* the factor of 2 is for the ji block */
+        grad = 0.0;
+        for(a=0;a<endA-beginA;a++){
+          for(b=0;b<endB-beginB;b++){
+            grad += weights[(beginA+a)*num_orbs+beginB+b]*dblock[a*ATOM_ORBS+b];
+          }
+        }
+        grad *= 2.0;
+        switch(dir){
+        case 0:
+          gradients[i].x += grad;
+          gradients[j].x -= grad;
+          break;
+        case 1:
+          gradients[i].y += grad;
+          gradients[j].y -= grad;
+          break;
+        default:
+          gradients[i].z += grad;
+          gradients[j].z -= grad;
+          break;
+        }
+      }
+    }
+  }
+
+  if( details->eval_electrostat ){
+    electrostatic_gradients(cell,num_orbs,orbital_lookup_table,weights,
+                            gradients);
+  }
+
+  arena_release(&cycle_arena,mark);
+}
+
+
+/****************************************************************************
+*
+*                   Procedure report_forces
+*
+* Arguments: cell: pointer to cell_type
+*       gradients: pointer to point_type
+*
+* Returns: none
+*
+* Action: prints the forces on the atoms (minus the gradients) to the
+*   output file and puts them in the binary results.
+*
+*****************************************************************************/
+void report_forces(cell_type *cell,point_type *gradients)
+{
+  real *forces;
+  real max_force,temp;
+  arena_mark_type mark;
+  int i;
+
+  mark = arena_mark(&cycle_arena);
+  forces = (real *)arena_calloc(&cycle_arena,3*cell->num_atoms,sizeof(real));
+
+  fprintf(output_file,"\n;  Forces on the atoms (eV/Angstrom):\n");
+  max_force = 0.0;
+  for(i=0;i<cell->num_atoms;i++){
+    forces[3*i] = -gradients[i].x;
+    forces[3*i+1] = -gradients[i].y;
+    forces[3*i+2] = -gradients[i].z;
+    fprintf(output_file,"%d %s: %12.6lf %12.6lf %12.6lf\n",i+1,
+            cell->atoms[i].symb,forces[3*i],forces[3*i+1],forces[3*i+2]);
+    temp = sqrt(forces[3*i]*forces[3*i] + forces[3*i+1]*forces[3*i+1] +
+                forces[3*i+2]*forces[3*i+2]);
+    if( temp > max_force ) max_force = temp;
+  }
+  fprintf(output_file,";      Largest Force is: %8.6lf\n",max_force);
+  results_write_mat("forces",cell->num_atoms,3,forces);
+
+  arena_release(&cycle_arena,mark);
+}
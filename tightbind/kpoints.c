@@ -48,6 +48,202 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ****/
 
 
+/****************************************************************************
+ *
+ *                   Procedure print_kpoint_label
+ *
+ * Arguments: which_k: int
+ *             kpoint: pointer to k_point_type
+ *
+ * Returns: none
+ *
+ * Action: puts the line which starts the results for k point 'which_k
+ *   in the output file.
+ *
+ ****************************************************************************/
+void print_kpoint_label(int which_k,k_point_type *kpoint)
+{
+  fprintf(output_file,";***& Kpoint: %d (%6.4lf %6.4lf %6.4lf) Weight: %lf\n",which_k+1,
+          kpoint->loc.x,kpoint->loc.y,kpoint->loc.z,kpoint->weight);
+}
+
+/****************************************************************************
+ *
+ *                   Procedure diagonalize_k_matrices
+ *
+ * Arguments:  details: pointer to detail type
+ *                slot: int
+ *            num_orbs: int
+ *            overlapK: hermetian_matrix_type
+ *              hamilK: hermetian_matrix_type
+ *   cmplx_hamil, cmplx_overlap: pointers to complex
+ *            eigenset: eigenset_type
+ *   work1,work2,work3: pointers to reals
+ *          cmplx_work: pointer to complex
+ *          diag_error: pointer to int
+ *
+ * Returns: none
+ *
+ * Action:  solves H(k) * Y = S(k) * E * Y for the whole matrices, leaving
+ *   the eigenvectors in 'eigenset.  'slot is the k point (it's where
+ *   the Cholesky factor of S(k) gets cached, see overlap_factors.c).
+ *   'hamilK is destroyed; 'overlapK is not.
+ *
+ *   The work arrays have the same dimensions as in loop_over_k_points.
+ *
+ ****************************************************************************/
+void diagonalize_k_matrices(detail_type *details,int slot,int num_orbs,
+                            hermetian_matrix_type overlapK,hermetian_matrix_type hamilK,
+                            complex *cmplx_hamil,complex *cmplx_overlap,
+                            eigenset_type eigenset,real *work1,real *work2,real *work3,
+                            complex *cmplx_work,int *diag_error)
+{
+  int j;
+#ifdef USE_LAPACK
+  int k;
+  int jtab,ktab;
+  char jobz, uplo;
+  int num_orbs2;
+#endif
+
+#ifndef USE_LAPACK
+  /******
+    The matrix diagonalization routine destroys the overlap and hamiltonian
+    matrices, so if we need to (i.e. we are printing elements of them)
+    we make a copy of the overlap matrix in work3 and the
+    hamiltonian matrix in eigenset.vectR.  We'll move things around
+    later to get everything straightened out.
+    *******/
+  if(!details->diag_wo_overlap){
+    bcopy((char *)overlapK.mat,(char *)work3,num_orbs*num_orbs*sizeof(real));
+  } else {
+    bzero((char *)work3,num_orbs*num_orbs*sizeof(real));
+    for(j=0;j<num_orbs;j++) work3[j*num_orbs+j] = 1.0;
+  }
+  if( details->hamil_PRT ){
+    bcopy((char *)hamilK.mat,(char *)eigenset.vectR,num_orbs*num_orbs*sizeof(real));
+  }
+
+  /*******
+
+    now diagonalize that beast by calling the FORTRAN subroutine used
+    to diagonalize stuff in new3 and CACAO.
+
+    THIS REALLY SHOULD BE REPLACED with a routine written in C, so if you
+    happen to have some time on your hands....
+
+    The Cholesky factor of the overlap matrix is cached by k point,
+    so it only gets computed once during charge iteration.
+
+    ********/
+  cached_cboris(slot,&(num_orbs),hamilK.mat,work3,eigenset.vectI,eigenset.val,work1,
+                work2,diag_error);
+  timer_add_flops(eigensolver_flops(num_orbs,1));
+
+  /********
+
+    This is some comic relief aimed at members of the Hoffmann group.
+    If you want to do something similar for your site, uncomment this
+    section of code and change the uid's (you can find these in the
+    file /etc/passwd) and messages.
+
+    ********/
+#if 0
+  switch(getuid()){
+  case 1426: fprintf(stderr,"Jahn-Teller is REAL!"); break;
+  case 1501: fprintf(stderr,"Ultimate Man!"); break;
+  case 1649: fprintf(stderr,"Done Fishing?"); break;
+  case 1559: fprintf(stderr,"Damn texan!"); break;
+  case 1622: fprintf(stderr,"Back to the library!"); break;
+  case 1645: fprintf(stderr,"More Helices?"); break;
+  }
+#endif
+
+  /*********
+
+    at this point, hamilK.mat contains the real part of the eigenvectors,
+    eigenset.vectI contains the imaginary part,
+    eigenset.val has the energies,
+    and eigenset.vectR contains the hamiltonian matrix.
+
+    rearrange things so that eigenset.vectR and hamilK.mat store the
+    proper information.
+
+
+    **********/
+  if( details->hamil_PRT ){
+    bcopy((char *)eigenset.vectR,(char *)work3,num_orbs*num_orbs*sizeof(real));
+    bcopy((char *)hamilK.mat,(char *)eigenset.vectR,num_orbs*num_orbs*sizeof(real));
+    bcopy((char *)work3,(char *)hamilK.mat,num_orbs*num_orbs*sizeof(real));
+  } else{
+    bcopy((char *)hamilK.mat,(char *)eigenset.vectR,num_orbs*num_orbs*sizeof(real));
+  }
+
+#else
+  /**********
+
+    we're using LAPACK to diagonalize and we need to copy the matrices into those
+    used by the LAPACK diagonalizer
+
+    **********/
+  for(j=0;j<num_orbs;j++){
+    jtab = j*num_orbs;
+    for(k=j+1;k<num_orbs;k++){
+      ktab = k*num_orbs;
+      cmplx_hamil[jtab+k].r = hamilK.mat[jtab+k];
+      cmplx_hamil[jtab+k].i = hamilK.mat[ktab+j];
+      cmplx_overlap[jtab+k].r = overlapK.mat[jtab+k];
+      cmplx_overlap[jtab+k].i = overlapK.mat[ktab+j];
+      cmplx_hamil[ktab+j].r = 0.0;
+      cmplx_hamil[ktab+j].i = 0.0;
+      cmplx_overlap[ktab+j].r = 0.0;
+      cmplx_overlap[ktab+j].i = 0.0;
+    }
+    cmplx_hamil[jtab+j].r = hamilK.mat[jtab+j];
+    cmplx_hamil[jtab+j].i = 0.0;
+    cmplx_overlap[jtab+j].r = overlapK.mat[jtab+j];
+    cmplx_overlap[jtab+j].i = 0.0;
+
+  }
+
+
+  if( details->just_avgE ){
+    jobz = 'N';
+    if( print_progress )
+      fprintf(stdout,".");
+  } else{
+    jobz = 'V';
+  }
+  uplo = 'L';
+  num_orbs2 = num_orbs*num_orbs;
+  if( print_progress )
+    fprintf(stdout,"{");
+  if(!details->diag_wo_overlap){
+    cached_zhegv(slot,&jobz,&num_orbs,cmplx_hamil,cmplx_overlap,
+                 eigenset.val,cmplx_work,&num_orbs2,work3,diag_error);
+  }else{
+    zheev(&jobz,&uplo,(long *)&num_orbs,cmplx_hamil,(long *)&num_orbs,
+          eigenset.val,cmplx_work,(long *)&num_orbs2,work3,
+          (long *)diag_error);
+  }
+  if( print_progress )
+    fprintf(stdout,"}");
+  timer_add_flops(eigensolver_flops(num_orbs,jobz == 'V'));
+
+  /* now copy stuff back out of the results */
+  if( !details->just_avgE ){
+    for(j=0;j<num_orbs;j++){
+      jtab = j*num_orbs;
+      for(k=0;k<num_orbs;k++){
+        ktab = k*num_orbs;
+        eigenset.vectR[jtab+k] = cmplx_hamil[jtab+k].r;
+        eigenset.vectI[jtab+k] = cmplx_hamil[jtab+k].i;
+      }
+    }
+  }
+#endif
+}
+
 /****************************************************************************
  *
  *                   Procedure loop_over_k_points
@@ -108,39 +304,30 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
                         int num_orbs,int *orbital_lookup_table)
 {
   static char tempfilename[512];
-  static char *label=0;
+  char *label;
+  arena_mark_type mark;
   static FILE *sparse_OVfile,*sparse_HAMfile;
   k_point_type *kpoint;
   real *mat_save;
-  int i,j,k,l,m;
-  int itab,jtab,ktab;
-  int ltab,mtab;
+  int i;
   int diag_error;
-  real temp;
-  real total_energy,tot_chg;
-  int electrons_so_far;
-  real *occupations;
-  real *chg_mat;
+  char blocked;
   int num_KPOINTS;
-  int overlap_file,hamil_file;
+  matrix_dump_type *overlap_dump,*hamil_dump;
 #ifdef USE_LAPACK
-  char jobz, uplo;
-  int info, itype;
-  int num_orbs2;
+  int info;
 #endif
 
   if( details->Execution_Mode == FAT && !details->store_R_overlaps )
     mat_save = overlapK.mat;
 
-  if( !label ){
-    /* get space for the array storing the atomic labels... */
-    label = (char *)calloc(4*cell->num_atoms,sizeof(char));
-    if( !label )fatal("Can't allocate label array in loop_over_k_points");
+  /* get space for the array storing the atomic labels... */
+  mark = arena_mark(&cycle_arena);
+  label = (char *)arena_calloc(&cycle_arena,4*cell->num_atoms,sizeof(char));
 
-    /* put each atom in the label array */
-    for(i=0;i<cell->num_atoms;i++){
-      bcopy(cell->atoms[i].symb,&(label[4*i]),4*sizeof(char));
-    }
+  /* put each atom in the label array */
+  for(i=0;i<cell->num_atoms;i++){
+    bcopy(cell->atoms[i].symb,&(label[4*i]),4*sizeof(char));
   }
 
   /* make sure that we loop once for a molecular calculation */
@@ -157,7 +344,7 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
   ********/
 #ifdef IRIX_MP
 #pragma parallel
-#pragma local (kpoint, overlapK, hamilK, work3, eigenset, work1, work2, diag_error, occupations, i, total_energy, j, tot_chg, k, jtab, chg_mat)
+#pragma local (kpoint, overlapK, hamilK, work3, eigenset, work1, work2, diag_error, blocked, occupations, i, total_energy, j, tot_chg, k, jtab, chg_mat)
 #pragma shared (properties, avg_prop_info, details, cell,  hamilR,num_KPOINTS, num_orbs,orbital_lookup_table,overlapR )
 #pragma pfor iterate (i=0;num_KPOINTS;1)
 #endif
@@ -165,11 +352,18 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
     /* get a pointer to the k point we're working on */
     kpoint = &(details->K_POINTS[i]);
 
+    /* k points finished before a restart come from the checkpoint */
+    if( checkpoint_restore_kpoint(details,i,num_orbs,avg_prop_info) ) continue;
+
+    results_set_kpoint(i);
+
+    /* nothing in the scratch space is needed from the last k point */
+    arena_reset(&kpoint_arena);
+
     /* print some status information */
     if( cell->dim > 0){
       fprintf(status_file,"Kpoint: %d\n",i+1);
-      fprintf(output_file,";***& Kpoint: %d (%6.4lf %6.4lf %6.4lf) Weight: %lf\n",i+1,
-              kpoint->loc.x,kpoint->loc.y,kpoint->loc.z,kpoint->weight);
+      print_kpoint_label(i,kpoint);
     }
 
     /*****
@@ -177,6 +371,7 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
       build the overlap matrix and hamiltonian
 
       *****/
+    timer_start("k_matrices");
     switch(details->Execution_Mode){
     case FAT:
       if( details->store_R_overlaps ){
@@ -214,7 +409,9 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
     default:
       FATAL_BUG("Somehow a bogus execution mode got passed to loop_over_kpoints.");
     }
+    timer_stop("k_matrices");
 
+    timer_start("output");
     /* do we need to print out the overlap matrix? */
     if( details->overlap_mat_PRT ){
       fprintf(output_file,
@@ -229,6 +426,7 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
                          cell->atoms,cell->num_atoms,orbital_lookup_table,
                          num_orbs,details->overlap_mat_PRT & PRT_TRANSPOSE_FLAG,
                          LABEL_BOTH,details->line_width);
+      results_write_hermetian_mat("overlap",num_orbs,overlapK.mat);
     }
 
     /* What about the hamiltonian? */
@@ -245,6 +443,7 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
                          cell->atoms,cell->num_atoms,orbital_lookup_table,
                          num_orbs,details->hamil_PRT & PRT_TRANSPOSE_FLAG,
                          LABEL_BOTH,details->line_width);
+      results_write_hermetian_mat("hamiltonian",num_orbs,hamilK.mat);
     }
 
     /* do we need to do binary dumps of the matrices? */
@@ -252,23 +451,10 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
       /* if this is the first call, the open the file */
       if(i==0){
         sprintf(tempfilename,"%s.OV",details->filename);
-
-#ifndef _MSC_VER
-    		overlap_file = open(tempfilename,
-    			O_RDWR | O_TRUNC | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR);
-#else
-    		overlap_file = open(tempfilename,
-    			O_RDWR | O_TRUNC | O_APPEND | O_CREAT, _S_IREAD | _S_IWRITE);
-#endif
-
-        if( overlap_file == -1 ){
-          fatal("Can't open .OV file for binary I/O");
-        }
-        write(overlap_file,(const char *)&num_KPOINTS,sizeof(int));
-        write(overlap_file,(const char *)&num_orbs,sizeof(int));
-
+        overlap_dump = open_matrix_dump(details,tempfilename,MATRIX_DUMP_OVERLAP,
+                                        num_KPOINTS,num_orbs);
       }
-      dump_hermetian_mat(overlap_file,overlapK.mat,num_orbs);
+      write_matrix_dump(overlap_dump,i,overlapK.mat);
     }
 
     if( details->dump_sparse_mats ){
@@ -290,22 +476,12 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
       /* if this is the first call, the open the file */
       if(i==0){
         sprintf(tempfilename,"%s.HAM",details->filename);
-#ifndef _MSC_VER
-    		hamil_file = open(tempfilename,
-    			O_RDWR | O_APPEND | O_CREAT, S_IRUSR | S_IWUSR);
-#else
-		    hamil_file = open(tempfilename,
-			    O_RDWR | O_APPEND | O_CREAT, _S_IREAD | _S_IWRITE);
-#endif
-        if( hamil_file == -1 ){
-          fatal("Can't open .HAM file for binary I/O");
-        }
-        write(hamil_file,(const char *)&num_KPOINTS,sizeof(int));
-        write(hamil_file,(const char *)&num_orbs,sizeof(int));
-
+        hamil_dump = open_matrix_dump(details,tempfilename,MATRIX_DUMP_HAMILTONIAN,
+                                      num_KPOINTS,num_orbs);
       }
-      dump_hermetian_mat(hamil_file,hamilK.mat,num_orbs);
+      write_matrix_dump(hamil_dump,i,hamilK.mat);
     }
+    timer_stop("output");
 
     if( !details->just_matrices ){
 
@@ -318,155 +494,43 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
 
       ******/
       if(details->num_FCO_frags && details->Execution_Mode != MOLECULAR){
+        timer_start("FCO");
         /* first build the matrices */
         build_FMO_overlap(details,num_orbs,unit_cell->num_atoms,Overlap_K,
                           orbital_lookup_table);
         build_FMO_hamil(details,num_orbs,unit_cell->num_atoms,Hamil_K,
                         orbital_lookup_table);
         /* now diagonalize them */
-        diagonalize_FMO(details,work1,work2,work3,cmplx_hamil,cmplx_overlap,cmplx_work);
+        diagonalize_FMO(details,i,work1,work2,work3,cmplx_hamil,cmplx_overlap,
+                        cmplx_work);
 
         /* generate the transform matrices */
         gen_FMO_tform_matrices(details);
+        timer_stop("FCO");
       }
 
       if ( print_progress )
         fprintf(stdout,"%d >",i+1);
 
-#ifndef USE_LAPACK
-      /******
-        The matrix diagonalization routine destroys the overlap and hamiltonian
-        matrices, so if we need to (i.e. we are printing elements of them)
-        we make a copy of the overlap matrix in work3 and the
-        hamiltonian matrix in eigenset.vectR.  We'll move things around
-        later to get everything straightened out.
-        *******/
-      if(!details->diag_wo_overlap){
-        bcopy((char *)overlapK.mat,(char *)work3,num_orbs*num_orbs*sizeof(real));
-      } else {
-        bzero((char *)work3,num_orbs*num_orbs*sizeof(real));
-        for(j=0;j<num_orbs;j++) work3[j*num_orbs+j] = 1.0;
-      }
-      if( details->hamil_PRT ){
-        bcopy((char *)hamilK.mat,(char *)eigenset.vectR,num_orbs*num_orbs*sizeof(real));
-      }
-
       /*******
 
-        now diagonalize that beast by calling the FORTRAN subroutine used
-        to diagonalize stuff in new3 and CACAO.
-
-        THIS REALLY SHOULD BE REPLACED with a routine written in C, so if you
-        happen to have some time on your hands....
+        if the molecule has symmetry, try to diagonalize H one
+        symmetry block at a time.  If that can't be done, fall back
+        on diagonalizing the whole thing.
 
         ********/
-      cboris(&(num_orbs),&(num_orbs),hamilK.mat,work3,eigenset.vectI,eigenset.val,work1,
-             work2,&diag_error);
-
-      /********
-
-        This is some comic relief aimed at members of the Hoffmann group.
-        If you want to do something similar for your site, uncomment this
-        section of code and change the uid's (you can find these in the
-        file /etc/passwd) and messages.
-
-        ********/
-#if 0
-      switch(getuid()){
-      case 1426: fprintf(stderr,"Jahn-Teller is REAL!"); break;
-      case 1501: fprintf(stderr,"Ultimate Man!"); break;
-      case 1649: fprintf(stderr,"Done Fishing?"); break;
-      case 1559: fprintf(stderr,"Damn texan!"); break;
-      case 1622: fprintf(stderr,"Back to the library!"); break;
-      case 1645: fprintf(stderr,"More Helices?"); break;
-      }
-#endif
-
-      /*********
-
-        at this point, hamilK.mat contains the real part of the eigenvectors,
-        eigenset.vectI contains the imaginary part,
-        eigenset.val has the energies,
-        and eigenset.vectR contains the hamiltonian matrix.
-
-        rearrange things so that eigenset.vectR and hamilK.mat store the
-        proper information.
-
-
-        **********/
-      if( details->hamil_PRT ){
-        bcopy((char *)eigenset.vectR,(char *)work3,num_orbs*num_orbs*sizeof(real));
-        bcopy((char *)hamilK.mat,(char *)eigenset.vectR,num_orbs*num_orbs*sizeof(real));
-        bcopy((char *)work3,(char *)hamilK.mat,num_orbs*num_orbs*sizeof(real));
-      } else{
-        bcopy((char *)hamilK.mat,(char *)eigenset.vectR,num_orbs*num_orbs*sizeof(real));
-      }
-
-#else
-      /**********
-
-        we're using LAPACK to diagonalize and we need to copy the matrices into those
-        used by the LAPACK diagonalizer
-
-        **********/
-      for(j=0;j<num_orbs;j++){
-        jtab = j*num_orbs;
-        for(k=j+1;k<num_orbs;k++){
-          ktab = k*num_orbs;
-          cmplx_hamil[jtab+k].r = hamilK.mat[jtab+k];
-          cmplx_hamil[jtab+k].i = hamilK.mat[ktab+j];
-          cmplx_overlap[jtab+k].r = overlapK.mat[jtab+k];
-          cmplx_overlap[jtab+k].i = overlapK.mat[ktab+j];
-          cmplx_hamil[ktab+j].r = 0.0;
-          cmplx_hamil[ktab+j].i = 0.0;
-          cmplx_overlap[ktab+j].r = 0.0;
-          cmplx_overlap[ktab+j].i = 0.0;
-        }
-        cmplx_hamil[jtab+j].r = hamilK.mat[jtab+j];
-        cmplx_hamil[jtab+j].i = 0.0;
-        cmplx_overlap[jtab+j].r = overlapK.mat[jtab+j];
-        cmplx_overlap[jtab+j].i = 0.0;
-
-      }
-
-
-      itype = 1;
-      if( details->just_avgE ){
-        jobz = 'N';
-        if( print_progress )
-          fprintf(stdout,".");
-      } else{
-        jobz = 'V';
+      timer_start("diagonalize");
+      blocked = 0;
+      if( details->Execution_Mode == MOLECULAR && details->use_symmetry ){
+        blocked = sym_block_diagonalize(details,cell,num_orbs,orbital_lookup_table,
+                                        overlapK,hamilK,eigenset,&diag_error);
       }
-      uplo = 'L';
-      num_orbs2 = num_orbs*num_orbs;
-      if( print_progress )
-        fprintf(stdout,"{");
-      if(!details->diag_wo_overlap){
-        zhegv((long *)&(itype),&jobz,&uplo,(long *)&num_orbs,cmplx_hamil,
-                                (long *)&num_orbs,cmplx_overlap,
-              (long *)&num_orbs,eigenset.val,cmplx_work,
-              (long *)&num_orbs2,work3,(long *)&diag_error);
-      }else{
-        zheev(&jobz,&uplo,(long *)&num_orbs,cmplx_hamil,(long *)&num_orbs,
-              eigenset.val,cmplx_work,(long *)&num_orbs2,work3,
-              (long *)&diag_error);
+      if( !blocked ){
+        diagonalize_k_matrices(details,i,num_orbs,overlapK,hamilK,cmplx_hamil,
+                               cmplx_overlap,eigenset,work1,work2,work3,
+                               cmplx_work,&diag_error);
       }
-      if( print_progress )
-        fprintf(stdout,"}");
-
-      /* now copy stuff back out of the results */
-      if( !details->just_avgE ){
-        for(j=0;j<num_orbs;j++){
-          jtab = j*num_orbs;
-          for(k=0;k<num_orbs;k++){
-            ktab = k*num_orbs;
-            eigenset.vectR[jtab+k] = cmplx_hamil[jtab+k].r;
-            eigenset.vectI[jtab+k] = cmplx_hamil[jtab+k].i;
-          }
-        }
-      }
-#endif
+      timer_stop("diagonalize");
 
       if( print_progress)
         fprintf(stdout,"<\n");
@@ -478,6 +542,7 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
         error("Problems in the diagonalization, try more overlaps.");
       }
 
+      timer_start("postprocess");
       if( !details->just_avgE ){
 
         postprocess_results(cell,details,overlapR,hamilR,overlapK,hamilK,
@@ -520,17 +585,24 @@ void loop_over_k_points(cell_type *cell,detail_type *details,
 
         *********/
       if( details->avg_props ){
-        store_avg_prop_info(details,i,eigenset,overlapK,num_orbs,
+        store_avg_prop_info(details,cell,i,eigenset,overlapK,num_orbs,
                             properties->chg_mat,avg_prop_info);
+        result_cache_keep_energies(i,num_orbs,eigenset);
+        checkpoint_kpoint_done(details,cell,i,num_orbs,avg_prop_info);
       }
+      timer_stop("postprocess");
     } /* end of if(!details->just_matrices) */
   } /* end of k point loop */
+  results_set_kpoint(-1);
+
+  report_overlap_factors();
 
   if( details->Execution_Mode == FAT && !details->store_R_overlaps ){
     overlapK.mat = mat_save;
   }
 
-  if( details->dump_hamil ) close(hamil_file);
-  if( details->dump_overlap) close(overlap_file);
+  if( details->dump_hamil ) close_matrix_dump(hamil_dump);
+  if( details->dump_overlap) close_matrix_dump(overlap_dump);
 
+  arena_release(&cycle_arena,mark);
 }
@@ -71,9 +71,25 @@ int main(int argc, char **argv)
     exit(0);
   }
 
+  /* --restart picks the run up from its checkpoint */
+  if( argc > 2 && strcmp(argv[1], "--restart") == 0){
+    restart_run = true;
+    argv++;
+    argc--;
+  }
+
+  /* --worker runs jobs sent on stdin until it's closed */
+  if( argc > 1 && strcmp(argv[1], "--worker") == 0){
+    signal(SIGINT,handle_sigint);
+    fprintf(stderr,greetings);
+    run_worker(argc > 2 ? argv[2] : NULL);
+    exit(0);
+  }
+
   /* make sure the program was called with the right arguments */
   if( argc < 2){
-    fprintf(stderr,"Usage: bind <inputfile> [paramfile]\n");
+    fprintf(stderr,"Usage: bind [--restart] <inputfile> [paramfile]\n");
+    fprintf(stderr,"       bind --worker [paramfile]\n");
     exit(-1);
   }
 
@@ -0,0 +1,261 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+/****************************************************************************
+*
+*     this file contains the routines for writing the binary matrix
+*      dumps (the .OV and .HAM files).
+*
+*   The format is described in matrix_dump.h.
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+struct matrix_dump_def {
+  int file;
+  matrix_dump_header_type header;
+  matrix_dump_index_type *index;
+  long long end_of_file;
+  /* scratch space used to convert/compress the matrices */
+  char *buffer;
+};
+
+
+/****************************************************************************
+*
+*                   Procedure write_dump_block
+*
+* Arguments: dump: pointer to matrix_dump_type
+*          offset: long long
+*            data: pointer to char
+*            size: long long
+*
+* Returns: none
+*
+* Action: writes 'size bytes from 'data at position 'offset of the dump.
+*
+*****************************************************************************/
+static void write_dump_block(matrix_dump_type *dump,long long offset,char *data,
+                             long long size)
+{
+  if( lseek(dump->file,(off_t)offset,SEEK_SET) == (off_t)-1 ||
+      write(dump->file,data,size) != size ){
+    fatal("Can't write to binary matrix file.");
+  }
+}
+
+
+/****************************************************************************
+*
+*                   Procedure open_matrix_dump
+*
+* Arguments: details: pointer to detail_type
+*        file_name: pointer to char
+*      matrix_type: int
+*      num_kpoints: int
+*         num_orbs: int
+*
+* Returns: pointer to matrix_dump_type
+*
+* Action: creates the dump file 'file_name (wiping out anything that
+*   was there before) and writes its header and k point table.
+*
+*   The element type and compression come from 'details.
+*
+*****************************************************************************/
+matrix_dump_type *open_matrix_dump(detail_type *details,char *file_name,
+                                   int matrix_type,int num_kpoints,int num_orbs)
+{
+  matrix_dump_type *dump;
+  double *kpoint_vals;
+  long long page_size;
+  int i;
+
+  dump = (matrix_dump_type *)my_calloc(1,sizeof(matrix_dump_type));
+  if( !dump ) fatal("Can't allocate a matrix dump.");
+
+#ifndef _MSC_VER
+  dump->file = open(file_name,O_RDWR | O_TRUNC | O_CREAT, S_IRUSR | S_IWUSR);
+#else
+  dump->file = open(file_name,O_RDWR | O_TRUNC | O_CREAT | O_BINARY,
+                    _S_IREAD | _S_IWRITE);
+#endif
+  if( dump->file == -1 ){
+    fatal("Can't open binary matrix file for binary I/O");
+  }
+
+  /* the magic number is a fixed width tag (not a string) that opens the header */
+  memcpy(&(dump->header),MATRIX_DUMP_MAGIC,sizeof(dump->header.magic));
+  dump->header.version = MATRIX_DUMP_VERSION;
+  dump->header.byte_order = MATRIX_DUMP_BYTE_ORDER;
+  dump->header.matrix_type = matrix_type;
+  dump->header.num_kpoints = num_kpoints;
+  dump->header.num_orbs = num_orbs;
+  if( details->dump_float ) dump->header.element_type = MATRIX_DUMP_FLOAT;
+  else dump->header.element_type = MATRIX_DUMP_DOUBLE;
+  if( details->dump_compressed ) dump->header.compression = MATRIX_DUMP_ZERO_RUNS;
+  else dump->header.compression = MATRIX_DUMP_NONE;
+  dump->header.page_size = MATRIX_DUMP_PAGE_SIZE;
+  dump->header.kpoint_offset = sizeof(matrix_dump_header_type);
+  dump->header.index_offset = dump->header.kpoint_offset +
+    4*num_kpoints*sizeof(double);
+
+  /* the matrices start on the first page after the index */
+  page_size = MATRIX_DUMP_PAGE_SIZE;
+  dump->end_of_file = dump->header.index_offset +
+    num_kpoints*sizeof(matrix_dump_index_type);
+  dump->end_of_file = ((dump->end_of_file+page_size-1)/page_size)*page_size;
+
+  dump->index = (matrix_dump_index_type *)
+    my_calloc(num_kpoints,sizeof(matrix_dump_index_type));
+  kpoint_vals = (double *)my_calloc(4*num_kpoints,sizeof(double));
+  /* the worst case for compression is 2 ints per value */
+  dump->buffer = (char *)my_malloc((long)num_orbs*num_orbs*
+                                   (sizeof(double)+2*sizeof(int)));
+  if( !dump->index || !kpoint_vals || !dump->buffer ){
+    fatal("Can't allocate space for a matrix dump.");
+  }
+
+  if( details->Execution_Mode == MOLECULAR ){
+    kpoint_vals[3] = 1.0;
+  } else{
+    for(i=0;i<num_kpoints;i++){
+      kpoint_vals[4*i] = details->K_POINTS[i].loc.x;
+      kpoint_vals[4*i+1] = details->K_POINTS[i].loc.y;
+      kpoint_vals[4*i+2] = details->K_POINTS[i].loc.z;
+      kpoint_vals[4*i+3] = details->K_POINTS[i].weight;
+    }
+  }
+
+  write_dump_block(dump,0,(char *)&(dump->header),sizeof(matrix_dump_header_type));
+  write_dump_block(dump,dump->header.kpoint_offset,(char *)kpoint_vals,
+                   4*num_kpoints*sizeof(double));
+  my_free(kpoint_vals);
+
+  return dump;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure write_matrix_dump
+*
+* Arguments: dump: pointer to matrix_dump_type
+*       which_k: int
+*           mat: pointer to real
+*
+* Returns: none
+*
+* Action: writes the matrix 'mat for k point 'which_k into the dump,
+*   starting on a page boundary.
+*
+*****************************************************************************/
+void write_matrix_dump(matrix_dump_type *dump,int which_k,real *mat)
+{
+  int num_vals,i,j;
+  int run[2];
+  float *float_vals;
+  double *double_vals;
+  long long size,page_size;
+  char *data;
+  int elem_size;
+
+  if( which_k < 0 || which_k >= dump->header.num_kpoints ){
+    FATAL_BUG("Bad k point passed to write_matrix_dump.");
+  }
+  num_vals = dump->header.num_orbs*dump->header.num_orbs;
+  if( dump->header.element_type == MATRIX_DUMP_FLOAT ) elem_size = sizeof(float);
+  else elem_size = sizeof(double);
+
+  if( dump->header.compression == MATRIX_DUMP_ZERO_RUNS ){
+    /* store runs of nonzero values, skipping over the zeros */
+    size = 0;
+    i = 0;
+    while( i < num_vals ){
+      for(run[0]=0;i<num_vals && mat[i]==0.0;i++) run[0]++;
+      for(run[1]=0;i+run[1]<num_vals && mat[i+run[1]]!=0.0;run[1]++);
+      bcopy((char *)run,&(dump->buffer[size]),2*sizeof(int));
+      size += 2*sizeof(int);
+      float_vals = (float *)&(dump->buffer[size]);
+      double_vals = (double *)&(dump->buffer[size]);
+      for(j=0;j<run[1];j++,i++){
+        if( elem_size == sizeof(float) ) float_vals[j] = (float)mat[i];
+        else double_vals[j] = (double)mat[i];
+      }
+      size += run[1]*elem_size;
+    }
+    data = dump->buffer;
+  } else if( elem_size == sizeof(real) ){
+    size = (long long)num_vals*elem_size;
+    data = (char *)mat;
+  } else{
+    float_vals = (float *)dump->buffer;
+    double_vals = (double *)dump->buffer;
+    for(i=0;i<num_vals;i++){
+      if( elem_size == sizeof(float) ) float_vals[i] = (float)mat[i];
+      else double_vals[i] = (double)mat[i];
+    }
+    size = (long long)num_vals*elem_size;
+    data = dump->buffer;
+  }
+
+  write_dump_block(dump,dump->end_of_file,data,size);
+  dump->index[which_k].offset = dump->end_of_file;
+  dump->index[which_k].size = size;
+
+  page_size = dump->header.page_size;
+  dump->end_of_file = ((dump->end_of_file+size+page_size-1)/page_size)*page_size;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure close_matrix_dump
+*
+* Arguments: dump: pointer to matrix_dump_type
+*
+* Returns: none
+*
+* Action: writes the index of the dump, closes the file, and frees
+*   the memory used by 'dump.
+*
+*****************************************************************************/
+void close_matrix_dump(matrix_dump_type *dump)
+{
+  if( !dump ) return;
+  write_dump_block(dump,dump->header.index_offset,(char *)dump->index,
+                   dump->header.num_kpoints*sizeof(matrix_dump_index_type));
+  close(dump->file);
+  my_free(dump->index);
+  my_free(dump->buffer);
+  my_free(dump);
+}
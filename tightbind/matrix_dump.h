@@ -0,0 +1,105 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the definitions for the binary matrix dumps
+*      (the .OV and .HAM files written with the Dump Overlap and
+*      Dump Hamiltonian keywords).
+*
+*     it is kept separate from bind.h so that programs which read these
+*      files (see utils/matrix_dump_reader.c) don't need the rest of bind.
+*
+*   Layout of the file:
+*     - a matrix_dump_header_type
+*     - at 'kpoint_offset: 'num_kpoints sets of 4 doubles (the k point
+*        coordinates and weight; zeros and 1 for a molecule).
+*     - at 'index_offset: 'num_kpoints matrix_dump_index_type's
+*     - the matrices, one per k point.  Each starts on a multiple of
+*        'page_size, so an uncompressed matrix can be mmap'ed directly.
+*
+*   Each matrix is 'num_orbs x 'num_orbs stored the way a
+*    hermetian_matrix_type is: for i>j, the real part of element (i,j)
+*    is at j*num_orbs+i and the imaginary part at i*num_orbs+j.
+*
+*   With MATRIX_DUMP_ZERO_RUNS compression the matrix is a series
+*    of records: two ints (the number of zeros to skip, the number of
+*    values which follow) followed by that many values.
+*
+*   Files written by older versions of bind have no header at all:
+*    just two ints (number of matrices, number of orbitals) and then
+*    the uncompressed matrices as reals.
+*
+*****************************************************************************/
+
+#ifndef MATRIX_DUMP_FORMAT_DEFINED
+#define MATRIX_DUMP_FORMAT_DEFINED
+
+#define MATRIX_DUMP_MAGIC "YAeHmdmp"
+#define MATRIX_DUMP_VERSION 1
+/* used to detect files written on machines with the other byte order */
+#define MATRIX_DUMP_BYTE_ORDER 0x01020304
+#define MATRIX_DUMP_PAGE_SIZE 4096
+
+/* which matrix is in the file */
+#define MATRIX_DUMP_OVERLAP 1
+#define MATRIX_DUMP_HAMILTONIAN 2
+
+/* the element types */
+#define MATRIX_DUMP_FLOAT 3
+#define MATRIX_DUMP_DOUBLE 4
+
+/* the compression schemes */
+#define MATRIX_DUMP_NONE 0
+#define MATRIX_DUMP_ZERO_RUNS 1
+
+typedef struct {
+  char magic[8];
+  int version;
+  int byte_order;
+  int matrix_type;
+  int num_kpoints;
+  int num_orbs;
+  int element_type;
+  int compression;
+  int page_size;
+  long long kpoint_offset;
+  long long index_offset;
+} matrix_dump_header_type;
+
+/* where the matrix for a k point is and how many bytes it takes up */
+typedef struct {
+  long long offset;
+  long long size;
+} matrix_dump_index_type;
+
+#endif
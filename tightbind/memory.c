@@ -37,14 +37,347 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *
 *  created:  greg landrum  August 1993
 *
+*   my_malloc, my_calloc and my_realloc keep track of every block they
+*    hand out (in a hash table keyed on the address) along with the
+*    tag which was current when it was allocated (see set_mem_tag and
+*    the MEM_ defines in bind.h).  This lets us keep the number of
+*    bytes in use and the high water mark for each tag, enforce the
+*    memory budget and report any blocks which are still around when
+*    cleanup_memory is called.
+*
+*   Memory from these routines should be released with my_free.  Blocks
+*    which are passed to plain free() are still counted as live until
+*    their address is handed out again.
+*
 *****************************************************************************/
 #include "bind.h"
 
 
-#define CONDITIONAL_FREE(__a__) if(__a__){ free(__a__); __a__ = 0; }
+#define CONDITIONAL_FREE(__a__) if(__a__){ my_free(__a__); __a__ = 0; }
+
+
+/* one entry in the table of allocated blocks */
+typedef struct{
+  void *ptr;
+  long size;
+  int tag;
+} mem_block_type;
+
+static mem_block_type *mem_blocks=0;
+static long mem_table_size=0,mem_num_blocks=0;
+
+static int current_mem_tag=MEM_MISC;
+static long mem_live[NUM_MEM_TAGS],mem_peak[NUM_MEM_TAGS];
+static long tot_usage=0,peak_usage=0;
+static long mem_budget=0;
+
+static char *mem_tag_names[NUM_MEM_TAGS]={"misc","R_matrices","K_matrices",
+                                          "avg_props","FMO","diag_work",
+                                          "scratch","persistent"};
+
+/****************************************************************************
+*
+*                   Function mem_hash
+*
+* Arguments: ptr: pointer to void
+*
+* Returns: long
+*
+* Action: returns the slot in the block table where the search for 'ptr
+*   starts.
+*
+*****************************************************************************/
+static long mem_hash(void *ptr)
+{
+  unsigned long val;
+
+  val = (unsigned long)ptr >> 4;
+  val ^= val >> 17;
+  val *= 2654435761UL;
+  return (long)(val & (unsigned long)(mem_table_size-1));
+}
+
+/****************************************************************************
+*
+*                   Function find_mem_block
+*
+* Arguments: ptr: pointer to void
+*
+* Returns: long
+*
+* Action: returns the slot holding 'ptr or -1 if it isn't in the table.
+*
+*****************************************************************************/
+static long find_mem_block(void *ptr)
+{
+  long slot;
+
+  if( !mem_table_size ) return -1;
+  slot = mem_hash(ptr);
+  while( mem_blocks[slot].ptr ){
+    if( mem_blocks[slot].ptr == ptr ) return slot;
+    slot = (slot+1) & (mem_table_size-1);
+  }
+  return -1;
+}
+
+/****************************************************************************
+*
+*                   Procedure count_mem_block
+*
+* Arguments: tag: int
+*           size: long
+*
+* Returns: none
+*
+* Action: adds 'size bytes (which may be negative) to the totals for
+*   'tag and updates the high water marks.
+*
+*****************************************************************************/
+static void count_mem_block(int tag,long size)
+{
+  mem_live[tag] += size;
+  tot_usage += size;
+  if( mem_live[tag] > mem_peak[tag] ) mem_peak[tag] = mem_live[tag];
+  if( tot_usage > peak_usage ) peak_usage = tot_usage;
+}
+
+/****************************************************************************
+*
+*                   Procedure forget_mem_block
+*
+* Arguments: ptr: pointer to void
+*
+* Returns: none
+*
+* Action: removes 'ptr from the table (if it's there) and takes its
+*   size off the totals.
+*
+*   The entries after the hole are shifted back so that the searches
+*    in find_mem_block never stop early.
+*
+*****************************************************************************/
+static void forget_mem_block(void *ptr)
+{
+  long slot,next,home;
+
+  slot = find_mem_block(ptr);
+  if( slot < 0 ) return;
+  count_mem_block(mem_blocks[slot].tag,-mem_blocks[slot].size);
+  mem_num_blocks--;
+
+  next = slot;
+  while(1){
+    next = (next+1) & (mem_table_size-1);
+    if( !mem_blocks[next].ptr ) break;
+    home = mem_hash(mem_blocks[next].ptr);
+    /* can the entry in next be moved back into the hole? */
+    if( (slot <= next && (home <= slot || home > next)) ||
+        (slot > next && home <= slot && home > next) ){
+      mem_blocks[slot] = mem_blocks[next];
+      slot = next;
+    }
+  }
+  mem_blocks[slot].ptr = 0;
+}
+
+/****************************************************************************
+*
+*                   Procedure remember_mem_block
+*
+* Arguments: ptr: pointer to void
+*           size: long
+*
+* Returns: none
+*
+* Action: adds 'ptr to the table with the current tag.
+*
+*   If the table can't be grown we just stop keeping track of
+*    things (the allocations themselves are fine).
+*
+*****************************************************************************/
+static void remember_mem_block(void *ptr,long size)
+{
+  mem_block_type *old_blocks;
+  long old_size,i,slot;
+
+  /* the address may still be there from a block freed with free() */
+  forget_mem_block(ptr);
+
+  if( 2*(mem_num_blocks+1) > mem_table_size ){
+    old_blocks = mem_blocks;
+    old_size = mem_table_size;
+    mem_table_size = old_size ? 2*old_size : 1024;
+    mem_blocks = (mem_block_type *)calloc(mem_table_size,sizeof(mem_block_type));
+    if( !mem_blocks ){
+      mem_blocks = old_blocks;
+      mem_table_size = old_size;
+      return;
+    }
+    for(i=0;i<old_size;i++){
+      if( old_blocks[i].ptr ){
+        slot = mem_hash(old_blocks[i].ptr);
+        while( mem_blocks[slot].ptr ) slot = (slot+1) & (mem_table_size-1);
+        mem_blocks[slot] = old_blocks[i];
+      }
+    }
+    if( old_blocks ) free(old_blocks);
+  }
 
+  slot = mem_hash(ptr);
+  while( mem_blocks[slot].ptr ) slot = (slot+1) & (mem_table_size-1);
+  mem_blocks[slot].ptr = ptr;
+  mem_blocks[slot].size = size;
+  mem_blocks[slot].tag = current_mem_tag;
+  mem_num_blocks++;
+  count_mem_block(current_mem_tag,size);
+}
 
-long tot_usage = 0;
+/****************************************************************************
+*
+*                   Function over_memory_budget
+*
+* Arguments: size: long
+*       what: pointer to char
+*
+* Returns: int
+*
+* Action: returns nonzero (after complaining) if getting 'size more
+*   bytes would take us over the memory budget.
+*
+*****************************************************************************/
+static int over_memory_budget(long size,char *what)
+{
+  if( memory_fits(size) ) return 0;
+  fprintf(stderr,"%s of %6.2f K would exceed the memory budget of %6.2f Meg.\
+  In use: %6.2f Meg\n",what,(float)size/1024,(float)mem_budget/(1024*1024),
+          (float)tot_usage/(1024*1024));
+  fprintf(status_file,"%s of %6.2f K would exceed the memory budget of %6.2f Meg.\
+  In use: %6.2f Meg\n",what,(float)size/1024,(float)mem_budget/(1024*1024),
+          (float)tot_usage/(1024*1024));
+  return 1;
+}
+
+/****************************************************************************
+*
+*                   Function set_mem_tag
+*
+* Arguments: tag: int
+*
+* Returns: int
+*
+* Action: makes 'tag the one attached to blocks allocated from now on
+*   and returns the one which was in use before.
+*
+*****************************************************************************/
+int set_mem_tag(int tag)
+{
+  int old_tag;
+
+  old_tag = current_mem_tag;
+  if( tag < 0 || tag >= NUM_MEM_TAGS ){
+    NONFATAL_BUG("bad tag passed to set_mem_tag");
+  } else{
+    current_mem_tag = tag;
+  }
+  return old_tag;
+}
+
+/****************************************************************************
+*
+*                   Procedure retag_memory
+*
+* Arguments: ptr: pointer to void
+*            tag: int
+*
+* Returns: none
+*
+* Action: moves the block 'ptr (which came from one of the my_ allocators)
+*   over to 'tag.
+*
+*****************************************************************************/
+void retag_memory(void *ptr,int tag)
+{
+  long slot;
+
+  if( !ptr || tag < 0 || tag >= NUM_MEM_TAGS ) return;
+  slot = find_mem_block(ptr);
+  if( slot < 0 ) return;
+  count_mem_block(mem_blocks[slot].tag,-mem_blocks[slot].size);
+  mem_blocks[slot].tag = tag;
+  count_mem_block(tag,mem_blocks[slot].size);
+}
+
+/****************************************************************************
+*
+*                   Procedure set_memory_budget
+*
+* Arguments: megs: real
+*
+* Returns: none
+*
+* Action: sets the most memory (in Mbytes) which the my_ allocators will
+*   hand out.  Zero turns the limit off.
+*
+*****************************************************************************/
+void set_memory_budget(real megs)
+{
+  if( megs > 0.0 ) mem_budget = (long)(megs*1024*1024);
+  else mem_budget = 0;
+}
+
+/****************************************************************************
+*
+*                   Function memory_fits
+*
+* Arguments: size: long
+*
+* Returns: int
+*
+* Action: returns nonzero if another 'size bytes can be allocated without
+*   going over the memory budget.
+*
+*****************************************************************************/
+int memory_fits(long size)
+{
+  return !mem_budget || tot_usage + size <= mem_budget;
+}
+
+/****************************************************************************
+*
+*                   Function memory_in_use
+*
+* Arguments: none
+*
+* Returns: long
+*
+* Action: returns the number of bytes the my_ allocators have handed out
+*   which haven't been freed yet.
+*
+*****************************************************************************/
+long memory_in_use()
+{
+  return tot_usage;
+}
+
+/****************************************************************************
+*
+*                   Procedure my_free
+*
+* Arguments: ptr: pointer to void
+*
+* Returns: none
+*
+* Action: frees a block from my_malloc, my_calloc or my_realloc.
+*   It's safe to pass in memory from anywhere else too.
+*
+*****************************************************************************/
+void my_free(void *ptr)
+{
+  if( !ptr ) return;
+  forget_mem_block(ptr);
+  free(ptr);
+}
 
 /****************************************************************************
 *
@@ -62,6 +395,7 @@ int *my_malloc(long size)
 {
   int *tptr;
 
+  if( over_memory_budget(size,"Malloc") ) return 0;
   tptr = (int *)malloc(size);
   if( !tptr ){
     fprintf(stderr,"Malloc failed getting %6.2f K.  Total allocated: %6.2f Meg\n",
@@ -70,7 +404,8 @@ int *my_malloc(long size)
             "Malloc failed getting %6.2f K.  Total allocated: %6.2f Meg\n",
             (float)size/1024,(float)tot_usage/(1024*1024));
   }else{
-    tot_usage += size;
+    remember_mem_block(tptr,size);
+    timer_add_bytes((double)size);
   }
   return tptr;
 }
@@ -92,6 +427,7 @@ int *my_calloc(int num, int size)
 {
   int *tptr;
 
+  if( over_memory_budget((long)num*size,"Calloc") ) return 0;
   tptr = (int *)calloc(num,size);
   if( !tptr ){
     fprintf(stderr,"Calloc failed getting %6.2f K.  Total allocated: %6.2f Meg\n",
@@ -100,7 +436,8 @@ int *my_calloc(int num, int size)
             "Calloc failed getting %6.2f K.  Total allocated: %6.2f Meg\n",
             (float)(num*size)/1024,(float)tot_usage/(1024*1024));
   }else{
-    tot_usage += num*size;
+    remember_mem_block(tptr,(long)num*size);
+    timer_add_bytes((double)num*(double)size);
   }
   return tptr;
 }
@@ -117,30 +454,367 @@ int *my_calloc(int num, int size)
 * Action: reallocates ptr.  dumps information into the status file
 *    file if we fail
 *
+*   The new block keeps the tag of the old one (if we know about it).
+*
 *****************************************************************************/
 int *my_realloc(int *ptr, int size)
 {
   int *tptr;
+  long slot,old_size;
+  int tag,old_tag;
+
+  old_size = 0;
+  tag = current_mem_tag;
+  slot = ptr ? find_mem_block(ptr) : -1;
+  if( slot >= 0 ){
+    old_size = mem_blocks[slot].size;
+    tag = mem_blocks[slot].tag;
+  }
+  if( over_memory_budget(size-old_size,"Realloc") ){
+    my_free(ptr);
+    return 0;
+  }
 
-  tptr = (int *)calloc(1,size);
+  /******
+    we don't know how big the old block was, so let realloc do the
+    copying (copying 'size bytes out of the old block runs off its end
+    whenever we're growing it).
+
+    the old block has to come out of the table before realloc frees
+    it; its address can't be looked at afterwards.
+  ******/
+  if( slot >= 0 ) forget_mem_block(ptr);
+  tptr = (int *)realloc(ptr,size);
+  old_tag = set_mem_tag(tag);
   if( !tptr ){
-    fprintf(stderr,"Calloc failed getting %6.2f K in realloc.  Total allocated: %6.2f Meg\n",
+    fprintf(stderr,"Realloc failed getting %6.2f K.  Total allocated: %6.2f Meg\n",
             (float)(size)/1024,(float)tot_usage/(1024*1024));
     fprintf(status_file,
-            "Calloc failed getting %6.2f K in realloc.  Total allocated: %6.2f Meg\n",
+            "Realloc failed getting %6.2f K.  Total allocated: %6.2f Meg\n",
             (float)(size)/1024,(float)tot_usage/(1024*1024));
+    /* the old block is still ours if realloc failed */
+    if( slot >= 0 ) remember_mem_block(ptr,old_size);
+    set_mem_tag(old_tag);
+    my_free(ptr);
   }else{
-    tot_usage += size;
+    remember_mem_block(tptr,size);
+    set_mem_tag(old_tag);
+    timer_add_bytes((double)size);
   }
 
-  /* we've got the new memory, copy in the old data */
-  bcopy(ptr,tptr,size);
-  /* free up the old pointer */
-  free(ptr);
   return tptr;
 }
 
+/****************************************************************************
+*
+*                   Procedure report_memory_usage
+*
+* Arguments: outfile: pointer to FILE
+*
+* Returns: none
+*
+* Action: writes the memory in use and the high water mark for each tag
+*   to 'outfile in a block between #MEMORY and #END_MEMORY
+*
+*****************************************************************************/
+void report_memory_usage(FILE *outfile)
+{
+  int i;
+
+  if( !outfile ) return;
+  fprintf(outfile,"#MEMORY\n");
+  fprintf(outfile,"; tag live_Kbytes peak_Kbytes\n");
+  for(i=0;i<NUM_MEM_TAGS;i++){
+    if( !mem_peak[i] ) continue;
+    fprintf(outfile,"%s %.2f %.2f\n",mem_tag_names[i],
+            (float)mem_live[i]/1024,(float)mem_peak[i]/1024);
+  }
+  fprintf(outfile,"total %.2f %.2f\n",(float)tot_usage/1024,
+          (float)peak_usage/1024);
+  if( mem_budget ){
+    fprintf(outfile,"budget %.2f\n",(float)mem_budget/1024);
+  }
+  fprintf(outfile,"#END_MEMORY\n");
+}
 
+/****************************************************************************
+*
+*                   Procedure report_memory_leaks
+*
+* Arguments: outfile: pointer to FILE
+*
+* Returns: none
+*
+* Action: writes the number and size of the blocks (other than the
+*   persistent ones) which haven't been freed to 'outfile and then
+*   starts the bookkeeping over.
+*
+*****************************************************************************/
+static void report_memory_leaks(FILE *outfile)
+{
+  long num_leaked[NUM_MEM_TAGS];
+  long i;
+  int tag;
+
+  for(tag=0;tag<NUM_MEM_TAGS;tag++) num_leaked[tag] = 0;
+  for(i=0;i<mem_table_size;i++){
+    if( mem_blocks[i].ptr ) num_leaked[mem_blocks[i].tag]++;
+  }
+  if( outfile ){
+    for(tag=0;tag<NUM_MEM_TAGS;tag++){
+      if( tag == MEM_PERSISTENT || !num_leaked[tag] ) continue;
+      fprintf(outfile,"Memory leak: %ld %s blocks (%.2f K) were never freed.\n",
+              num_leaked[tag],mem_tag_names[tag],(float)mem_live[tag]/1024);
+    }
+  }
+
+  /* the persistent blocks are still in use, so keep track of those */
+  for(i=0;i<mem_table_size;i++){
+    if( mem_blocks[i].ptr && mem_blocks[i].tag != MEM_PERSISTENT ){
+      forget_mem_block(mem_blocks[i].ptr);
+      /* something may have been shifted back into this slot */
+      i--;
+    }
+  }
+  for(tag=0;tag<NUM_MEM_TAGS;tag++) mem_peak[tag] = mem_live[tag];
+  peak_usage = tot_usage;
+  current_mem_tag = MEM_MISC;
+}
+
+
+
+/****************************************************************************
+*
+*                   Function FMO_COOPs_requested
+*
+* Arguments:  details: pointer to detail_type
+*
+* Returns: char
+*
+* Action: returns 1 if any of the COOP's are between FMO's.  Those are the
+*   only things which need the wavefunctions in the FMO basis to be kept
+*   for the average properties.
+*
+*****************************************************************************/
+static char FMO_COOPs_requested(detail_type *details)
+{
+  COOP_type *COOP_ptr,*COOP_ptr2;
+
+  for(COOP_ptr=details->the_COOPS;COOP_ptr;COOP_ptr=COOP_ptr->next_type){
+    for(COOP_ptr2=COOP_ptr;COOP_ptr2;COOP_ptr2=COOP_ptr2->next_to_avg){
+      if( COOP_ptr2->type == P_DOS_FMO ) return 1;
+    }
+  }
+  return 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function FMO_avg_prop_size
+*
+* Arguments:  details: pointer to detail_type
+*            num_orbs: int
+*
+* Returns: real
+*
+* Action: returns the number of elements the FMO arrays in the
+*   avg_prop_info array take up: the charge matrix in the FMO basis for
+*   each k point and, if there are FMO COOP's, the wavefunctions in the
+*   FMO basis.
+*
+*****************************************************************************/
+static real FMO_avg_prop_size(detail_type *details,int num_orbs)
+{
+  real num_sq;
+
+  if( !details->num_FMO_frags && !details->num_FCO_frags ) return 0;
+  num_sq = (real)num_orbs*num_orbs*details->num_KPOINTS;
+  if( FMO_COOPs_requested(details) ) return 3*num_sq;
+  else return num_sq;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure extended_matrix_sizes
+*
+* Arguments:  details: pointer to detail_type
+*            num_orbs: int
+*        tot_overlaps: int
+*                mode: int
+*            store_R: char
+*  mem_per_overlapR,mem_per_hamR: pointers to long
+*  mem_per_overlapK,mem_per_hamK: pointers to long
+*
+* Returns: none
+*
+* Action: fills in the number of reals needed for each of the R and K
+*   space matrices of an extended system run in 'mode (storing the
+*   S(R)'s if 'store_R is set in FAT mode, in single precision beyond
+*   the unit cell if details->mixed_precision is set).
+*
+*****************************************************************************/
+void extended_matrix_sizes(detail_type *details,int num_orbs,
+                           int tot_overlaps,int mode,char store_R,
+                           long *mem_per_overlapR,long *mem_per_hamR,
+                           long *mem_per_overlapK,long *mem_per_hamK)
+{
+  if( mode == FAT ){
+    if( store_R ){
+      *mem_per_overlapR = (long)num_orbs*num_orbs*tot_overlaps;
+      if( details->mixed_precision ){
+        /* the translated cells are packed in after the unit cell */
+        *mem_per_overlapR = (long)num_orbs*num_orbs +
+          ((long)num_orbs*num_orbs*(tot_overlaps-1)*sizeof(float) +
+           sizeof(real) - 1)/sizeof(real);
+      }
+      *mem_per_overlapK = (long)num_orbs*num_orbs;
+    } else{
+      *mem_per_overlapR = (long)num_orbs*num_orbs;
+      *mem_per_overlapK = (long)num_orbs*num_orbs*details->num_KPOINTS;
+    }
+    *mem_per_hamR = (long)num_orbs*num_orbs;
+    *mem_per_hamK = (long)num_orbs*num_orbs;
+  } else{
+    *mem_per_overlapR = (long)num_orbs*num_orbs;
+    *mem_per_overlapK = (long)num_orbs*num_orbs;
+    *mem_per_hamR = num_orbs;
+    *mem_per_hamK = (long)num_orbs*num_orbs;
+  }
+}
+
+/****************************************************************************
+*
+*                   Function estimate_memory_usage
+*
+* Arguments:     cell: pointer to cell_type
+*             details: pointer to detail_type
+*            num_orbs: int
+*                mode: int
+*  mem_per_overlapR,mem_per_hamR: long
+*  mem_per_overlapK,mem_per_hamK: long
+*
+* Returns: real
+*
+* Action: returns an _approximate_ measure of the number of bytes
+*   allocate_matrices is going to get in 'mode given the sizes of the
+*   R and K space matrices.
+*
+*****************************************************************************/
+static real estimate_memory_usage(cell_type *cell,detail_type *details,
+                                  int num_orbs,int mode,
+                                  long mem_per_overlapR,long mem_per_hamR,
+                                  long mem_per_overlapK,long mem_per_hamK)
+{
+  real estimated_usage;
+  real mem_for_avg_props;
+  real num_sq;
+
+  num_sq = (real)num_orbs*num_orbs;
+
+  /* this is the total amount needed for the average properties */
+  mem_for_avg_props = num_sq*details->num_KPOINTS*3 +
+    (real)num_orbs*details->num_KPOINTS;
+
+  estimated_usage = (real)mem_per_hamR + mem_per_hamK + mem_per_overlapR +
+    mem_per_overlapK + 3*num_sq + 3*num_orbs + cell->num_atoms;
+#ifdef USE_LAPACK
+  /* the three complex arrays */
+  estimated_usage += 6*num_sq;
+#endif
+
+  /******
+
+    the FMO analysis needs the fragment matrices, plus the FMO arrays
+    in the avg_prop_info array.
+
+    This is an *extremely* approximate measure.
+
+  ****/
+  if( details->num_FMO_frags || details->num_FCO_frags){
+    mem_for_avg_props += FMO_avg_prop_size(details,num_orbs);
+    estimated_usage += mem_per_hamK + mem_per_overlapK + num_orbs;
+  }
+  if( details->avg_props && mode != THIN ){
+    estimated_usage += mem_for_avg_props;
+  }
+
+  return estimated_usage*sizeof(real);
+}
+
+/****************************************************************************
+*
+*                   Procedure choose_memory_layout
+*
+* Arguments:     cell: pointer to cell_type
+*             details: pointer to detail_type
+*            num_orbs: int
+*        tot_overlaps: int
+*
+* Returns: none
+*
+* Action: switches an extended FAT mode run over to THIN mode if that's
+*   what it takes to fit into the memory budget.  This is only done if
+*   nothing in the run needs the matrices from more than one k point
+*   (or the S(R)'s) at a time.
+*
+*   FAT mode already stores whichever of the S(R)'s and the S(k)'s takes
+*    less space, so there's nothing else to try.
+*
+*   details->Execution_Mode and details->store_R_overlaps are updated.
+*
+*   The factors of the overlap matrices (see overlap_factors.c) are
+*    written to a scratch file when they don't fit, so they aren't
+*    considered here.
+*
+*****************************************************************************/
+static void choose_memory_layout(cell_type *cell,detail_type *details,
+                                 int num_orbs,int tot_overlaps)
+{
+  long mem_per_overlapR,mem_per_hamR;
+  long mem_per_overlapK,mem_per_hamK;
+  real usage[2],smallest;
+  int modes[2];
+  char store_R[2];
+  int num_choices,i;
+  char err_string[240];
+
+  num_choices = 0;
+  modes[num_choices] = FAT;
+  store_R[num_choices++] = details->store_R_overlaps;
+  if( details->num_KPOINTS && !details->the_COOPS && !details->num_FMO_frags &&
+      !details->num_FCO_frags && !details->band_info && !details->avg_props &&
+      !details->vary_zeta ){
+    modes[num_choices] = THIN;
+    store_R[num_choices++] = 0;
+  }
+
+  smallest = -1;
+  for(i=0;i<num_choices;i++){
+    extended_matrix_sizes(details,num_orbs,tot_overlaps,modes[i],store_R[i],
+                          &mem_per_overlapR,&mem_per_hamR,
+                          &mem_per_overlapK,&mem_per_hamK);
+    usage[i] = estimate_memory_usage(cell,details,num_orbs,modes[i],
+                                     mem_per_overlapR,mem_per_hamR,
+                                     mem_per_overlapK,mem_per_hamK);
+    if( smallest < 0 || usage[i] < smallest ) smallest = usage[i];
+    if( memory_fits((long)usage[i]) ) break;
+  }
+  if( i == num_choices ){
+    sprintf(err_string,
+            "The run needs at least %.2f Kbytes, which won't fit into the memory budget",
+            smallest/1024);
+    fatal(err_string);
+  }
+
+  if( modes[i] == THIN ){
+    fprintf(status_file,
+            "Switching to THIN mode to stay within the memory budget.\n");
+  }
+  details->Execution_Mode = modes[i];
+  details->store_R_overlaps = store_R[i];
+}
 
 
 /****************************************************************************
@@ -227,20 +901,25 @@ void allocate_matrices(cell_type *cell,detail_type *details,
 {
 
   FMO_frag_type *FMO_frag;
-  int i,j;
+  int i,j,k;
   int begin,end;
-  int num_so_far;
   long mem_for_avg_props;
   long mem_per_overlapR,mem_per_hamR;
   long mem_per_overlapK,mem_per_hamK;
   real estimated_usage;
-  long tot_usage=0;
   real *temp_mat;
   int num_frags;
+  int num_R_blocks;
 
   /* set the dimensionalities of the various matrices */
   H_R->dim = H_K->dim = S_R->dim = S_K->dim = eigenset->dim = num_orbs;
 
+  /* whatever overlaps we had before are about to be replaced */
+  invalidate_overlap_cache();
+  free_overlap_factors();
+
+  set_memory_budget(details->memory_budget);
+
   /******
 
     figure out how many orbitals there are in each FMO fragment
@@ -270,6 +949,24 @@ void allocate_matrices(cell_type *cell,detail_type *details,
           FMO_frag->orbital_lookup_table[j] = -1;
         }
       }
+      retag_memory(FMO_frag->orbital_lookup_table,MEM_FMO);
+
+      /* now map the fragment's orbitals onto those of the full system */
+      FMO_frag->orb_map = (int *)my_calloc(FMO_frag->num_orbs ? FMO_frag->num_orbs : 1,
+                                           sizeof(int));
+      if( !FMO_frag->orb_map ) fatal("Can't get space for an FMO orbital map.");
+      for( j=0;j<FMO_frag->num_atoms;j++ ){
+        find_atoms_orbs(num_orbs,cell->num_atoms,FMO_frag->atoms_in_frag[j],
+                        orbital_lookup_table,&begin,&end);
+        if( begin >= 0 ){
+          for( k=0; k<end-begin; k++ ){
+            FMO_frag->orb_map[FMO_frag->orbital_lookup_table[j]+k] = begin+k;
+          }
+        }
+      }
+      retag_memory(FMO_frag->orb_map,MEM_FMO);
+      FMO_frag->orb_offset = i ? details->FMO_frags[i-1].orb_offset +
+        details->FMO_frags[i-1].num_orbs : 0;
       fprintf(status_file,"Fragment %d has %d atoms and %d orbitals.\n",
               i+1,FMO_frag->num_atoms,FMO_frag->num_orbs);
 
@@ -292,34 +989,29 @@ void allocate_matrices(cell_type *cell,detail_type *details,
 
     /* figure out about how much memory is gonna be needed */
     if( details->Execution_Mode == FAT ){
-
-      if( !details->num_KPOINTS || *tot_overlaps <= details->num_KPOINTS
+      /* the packed S(R)'s take about half as much room */
+      if( details->mixed_precision ) num_R_blocks = (*tot_overlaps+1)/2;
+      else num_R_blocks = *tot_overlaps;
+      if( !details->num_KPOINTS || num_R_blocks <= details->num_KPOINTS
          || details->the_COOPS
          || details->num_FMO_frags
          || details->num_FCO_frags
          || details->band_info ){
-        mem_per_overlapR = num_orbs*(num_orbs)*(*tot_overlaps);
-        mem_per_overlapK = num_orbs*(num_orbs);
         details->store_R_overlaps = 1;
       } else{
-        mem_per_overlapR = num_orbs*(num_orbs);
-        mem_per_overlapK = num_orbs*(num_orbs)*details->num_KPOINTS;
         details->store_R_overlaps = 0;
       }
 #if 0
-      mem_per_overlapR = num_orbs*(num_orbs)*(*tot_overlaps);
-      mem_per_overlapK = num_orbs*(num_orbs);
       details->store_R_overlaps = 1;
 #endif
-      mem_per_hamR = num_orbs*(num_orbs);
-      mem_per_hamK = num_orbs*(num_orbs);
-    }
-    else if( details->Execution_Mode == THIN){
-      mem_per_overlapR = num_orbs*(num_orbs);
-      mem_per_overlapK = num_orbs*(num_orbs);
-      mem_per_hamR = num_orbs;
-      mem_per_hamK = num_orbs*(num_orbs);
+      if( details->memory_budget > 0.0 ){
+        choose_memory_layout(cell,details,num_orbs,*tot_overlaps);
+      }
     }
+    extended_matrix_sizes(details,num_orbs,*tot_overlaps,
+                          details->Execution_Mode,details->store_R_overlaps,
+                          &mem_per_overlapR,&mem_per_hamR,
+                          &mem_per_overlapK,&mem_per_hamK);
   }
   else{
     mem_per_overlapR = num_orbs*(num_orbs);
@@ -331,24 +1023,13 @@ void allocate_matrices(cell_type *cell,detail_type *details,
   /* this is the total amount needed for the average properties */
   mem_for_avg_props = num_orbs*(num_orbs)*details->num_KPOINTS*3 +
     (num_orbs)*details->num_KPOINTS;
+  mem_for_avg_props += FMO_avg_prop_size(details,num_orbs);
 
   /* this is an _approximate_ measure of the amount of memory required */
-  estimated_usage =
-    mem_per_hamR + mem_per_hamK + mem_per_overlapR + mem_per_overlapK
-      + 3*(num_orbs)*(num_orbs)+3*(num_orbs) + cell->num_atoms;
-
-
-  /******
-
-    it's gonna take about twice as much memory if we're doing FMO
-
-    This is an *extremely* approximate measure.
-
-  ****/
-  if( details->num_FMO_frags || details->num_FCO_frags){
-    mem_for_avg_props *= 2;
-    estimated_usage += mem_per_hamK + mem_per_overlapK + num_orbs;
-  }
+  estimated_usage = estimate_memory_usage(cell,details,num_orbs,
+                                          details->Execution_Mode,
+                                          mem_per_overlapR,mem_per_hamR,
+                                          mem_per_overlapK,mem_per_hamK);
 
   /***********
     Since the total amount of memory for the avg_props array will
@@ -362,7 +1043,7 @@ void allocate_matrices(cell_type *cell,detail_type *details,
   *************/
   if( details->Execution_Mode == THIN && details->avg_props ){
 
-    if( estimated_usage < (mem_for_avg_props + (num_orbs*(num_orbs))) ){
+    if( estimated_usage < (mem_for_avg_props + (num_orbs*(num_orbs)))*sizeof(real) ){
       fprintf(status_file,"Checking to see if the total amount of memory needed\
 is present.\n");
 
@@ -375,17 +1056,11 @@ is present.\n");
       }
 
       /* We're safe, free that temporary array */
-      free(temp_mat);
-    }
-  }
-  else{
-    if( details->avg_props ){
-      estimated_usage += mem_for_avg_props;
+      my_free(temp_mat);
     }
   }
 
-  estimated_usage *= sizeof(real); /* convert to bytes */
-  estimated_usage /= 1024; /* then to Kbytes */
+  estimated_usage /= 1024; /* convert to Kbytes */
 
   fprintf(status_file,"Allocating approximately %8.2lf Kbytes (%8.2lf Meg).\n",
           estimated_usage,estimated_usage/1024);
@@ -400,12 +1075,22 @@ is present.\n");
       (and make sure that we got it)
 
       ***********/
+    set_mem_tag(MEM_R_MATS);
     H_R->mat = (real *)my_malloc(mem_per_hamR*sizeof(real));
     S_R->mat = (real *)my_malloc(mem_per_overlapR*sizeof(real));
     if( !(S_R->mat) ){
       fatal("Can't allocate space for overlap or hamiltonian matrices.");
     }
+    S_R->packed = 0;
+    if( cell->dim != 0 && details->Execution_Mode == FAT &&
+        details->store_R_overlaps && details->mixed_precision &&
+        *tot_overlaps > 1 ){
+      S_R->packed = (float *)(S_R->mat + num_orbs*num_orbs);
+      fprintf(status_file,
+              "The translated S(R)'s will be stored in single precision.\n");
+    }
     if( cell->dim != 0 ){
+      set_mem_tag(MEM_K_MATS);
       H_K->mat = (real *)my_malloc(mem_per_hamK*sizeof(real));
       S_K->mat = (real *)my_malloc(mem_per_overlapK*sizeof(real));
       if( !(S_K->mat) ){
@@ -413,6 +1098,7 @@ is present.\n");
       }
     }
     if( !details->just_matrices ){
+      set_mem_tag(MEM_DIAG_WORK);
 #ifdef USE_LAPACK
       /* allocate storage for the complex arrays used by the LAPACK routines */
       *cmplx_hamil = (complex *)my_malloc(num_orbs*num_orbs*sizeof(complex));
@@ -428,6 +1114,7 @@ is present.\n");
       if( !(eigenset->vectR) || !(eigenset->val) )
         fatal("Can't allocate space for the eigenset storage.");
 
+      set_mem_tag(MEM_MISC);
     /* only get space for mulliken population analysis if we need to */
       if( details->OP_mat_PRT || details->ROP_mat_PRT || details->net_chg_PRT
           || details->vary_zeta || details->avg_props){
@@ -467,6 +1154,7 @@ is present.\n");
       }
 
       /* the temporary storage arrays */
+      set_mem_tag(MEM_DIAG_WORK);
       *work1 = (real *)my_calloc(num_orbs,sizeof(real));
       *work2 = (real *)my_calloc(num_orbs,sizeof(real));
       *work3 = (real *)my_calloc(num_orbs*(num_orbs),sizeof(real));
@@ -487,6 +1175,7 @@ is present.\n");
       *********/
     if( details->Execution_Mode != THIN && details->avg_props &&
         !details->just_matrices){
+      set_mem_tag(MEM_AVG_PROPS);
       *avg_prop_info = (avg_prop_info_type *)my_calloc(details->num_KPOINTS,
                                                     sizeof(avg_prop_info_type));
       if( !(*avg_prop_info) )
@@ -516,10 +1205,15 @@ is present.\n");
         }
         /* get memory for the FMO properties stuff (if we need them) */
         if( details->num_FMO_frags || details->num_FCO_frags){
-          (*avg_prop_info)[i].FMO_orbs =
-            (float *)my_calloc(num_orbs*(num_orbs),sizeof(float));
-          (*avg_prop_info)[i].FMO_orbsI =
-            (float *)my_calloc(num_orbs*(num_orbs),sizeof(float));
+          /* the wavefunctions are only used for FMO COOP's */
+          if( FMO_COOPs_requested(details) ){
+            (*avg_prop_info)[i].FMO_orbs =
+              (float *)my_calloc(num_orbs*(num_orbs),sizeof(float));
+            (*avg_prop_info)[i].FMO_orbsI =
+              (float *)my_calloc(num_orbs*(num_orbs),sizeof(float));
+            if( !(*avg_prop_info)[i].FMO_orbsI )
+              fatal("Can't get memory for an FMO array within the avg_prop_info array.");
+          }
           (*avg_prop_info)[i].FMO_chg_mat =
             (float *)my_calloc(num_orbs*(num_orbs),
                             sizeof(float));
@@ -542,6 +1236,7 @@ is present.\n");
 
     ********/
     if( details->num_FMO_frags || details->num_FCO_frags ){
+      set_mem_tag(MEM_FMO);
 
       details->FMO_props = (FMO_prop_type *)my_calloc(1,sizeof(FMO_prop_type));
       if( !details->FMO_props ) fatal("Can't get memory for FMO_props.");
@@ -564,10 +1259,13 @@ is present.\n");
       if(!details->FMO_props->chg_mat)
         fatal("Can't get memory for charge matrix in FMO basis.");
 
-      details->FMO_props->OP_mat = (real *)my_calloc((num_orbs)*(num_orbs),
-                                                    sizeof(real));
-      if(!details->FMO_props->OP_mat)
-        fatal("Can't get memory for overlap population matrix in FMO basis.");
+      /* the OP matrix and hamiltonian are only needed to print them */
+      if( details->OP_mat_PRT ){
+        details->FMO_props->OP_mat = (real *)my_calloc((num_orbs)*(num_orbs),
+                                                      sizeof(real));
+        if(!details->FMO_props->OP_mat)
+          fatal("Can't get memory for overlap population matrix in FMO basis.");
+      }
 
       details->FMO_props->ROP_mat = (real *)my_calloc((num_frags)*
                                                     (num_frags),
@@ -582,10 +1280,12 @@ is present.\n");
 
       details->FMO_props->overlap.dim = num_orbs;
 
-      details->FMO_props->hamil.mat = (real *)my_calloc((num_orbs)*(num_orbs),
-                                                         sizeof(real));
-      if(!details->FMO_props->hamil.mat)
-        fatal("Can't get memory for hamiltonian matrix in FMO basis.");
+      if( details->hamil_PRT ){
+        details->FMO_props->hamil.mat = (real *)my_calloc((num_orbs)*(num_orbs),
+                                                           sizeof(real));
+        if(!details->FMO_props->hamil.mat)
+          fatal("Can't get memory for hamiltonian matrix in FMO basis.");
+      }
 
       details->FMO_props->hamil.dim = num_orbs;
 
@@ -648,10 +1348,76 @@ is present.\n");
 
       }
     }
+    set_mem_tag(MEM_MISC);
+
+    fprintf(status_file,"Allocated %8.2lf Kbytes (%8.2lf Meg) in all so far.\n",
+            (real)memory_in_use()/1024,(real)memory_in_use()/(1024*1024));
     /* that's that, everything is set.... */
   }
 }
 
+/****************************************************************************
+*
+*                   Procedure free_FMO_memory
+*
+* Arguments: details: pointer to detail_type
+*
+* Returns: none
+*
+* Action: frees the fragments and the FMO properties (allocate_matrices
+*   gets most of this memory).
+*
+*****************************************************************************/
+static void free_FMO_memory(detail_type *details)
+{
+  FMO_frag_type *FMO_frag;
+  int i,num_frags;
+
+  if( details->FMO_frags ){
+    if( !details->num_FMO_frags ) num_frags = details->num_FCO_frags;
+    else num_frags = details->num_FMO_frags;
+    for(i=0;i<num_frags;i++){
+      FMO_frag = &(details->FMO_frags[i]);
+      CONDITIONAL_FREE(FMO_frag->atoms_in_frag);
+      CONDITIONAL_FREE(FMO_frag->orbital_lookup_table);
+      CONDITIONAL_FREE(FMO_frag->orb_map);
+      CONDITIONAL_FREE(FMO_frag->hamil_R.mat);
+      CONDITIONAL_FREE(FMO_frag->overlap_R.mat);
+      CONDITIONAL_FREE(FMO_frag->hamil_K.mat);
+      CONDITIONAL_FREE(FMO_frag->overlap_K.mat);
+      CONDITIONAL_FREE(FMO_frag->tform_matrix.matR);
+      CONDITIONAL_FREE(FMO_frag->tform_matrix.matI);
+      CONDITIONAL_FREE(FMO_frag->eigenset.vectR);
+      CONDITIONAL_FREE(FMO_frag->eigenset.vectI);
+      CONDITIONAL_FREE(FMO_frag->eigenset.val);
+    }
+    CONDITIONAL_FREE(details->FMO_frags);
+  }
+  if( details->FMO_props ){
+    CONDITIONAL_FREE(details->FMO_props->eigenset.vectR);
+    CONDITIONAL_FREE(details->FMO_props->eigenset.vectI);
+    CONDITIONAL_FREE(details->FMO_props->chg_mat);
+    CONDITIONAL_FREE(details->FMO_props->OP_mat);
+    CONDITIONAL_FREE(details->FMO_props->ROP_mat);
+    CONDITIONAL_FREE(details->FMO_props->overlap.mat);
+    CONDITIONAL_FREE(details->FMO_props->hamil.mat);
+    CONDITIONAL_FREE(details->FMO_props->net_chgs);
+    CONDITIONAL_FREE(details->FMO_props);
+  }
+}
+
+/****************************************************************************
+*
+*                   Procedure cleanup_memory
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: frees the global arrays and writes a line to the status file
+*   for each kind of memory which was left allocated after that.
+*
+*****************************************************************************/
 void cleanup_memory()
 {
   if(avg_prop_info != NULL) {
@@ -666,7 +1432,7 @@ void cleanup_memory()
         CONDITIONAL_FREE(avg_prop_info[i].FMO_chg_mat);
       }
     }
-    free(avg_prop_info);
+    my_free(avg_prop_info);
     avg_prop_info = NULL;
   }
   sym_op_type *next=sym_ops_present;
@@ -676,6 +1442,12 @@ void cleanup_memory()
     CONDITIONAL_FREE(tmp->equiv_atoms);
     CONDITIONAL_FREE(tmp);
   }
+  invalidate_overlap_cache();
+  free_overlap_factors();
+  free_sym_blocks();
+  free_R_overlap_block();
+  arena_free(&kpoint_arena);
+  arena_free(&cycle_arena);
   CONDITIONAL_FREE(Hamil_R.mat);
   CONDITIONAL_FREE(Overlap_R.mat);
   if(unit_cell->dim != 0){
@@ -696,14 +1468,21 @@ void cleanup_memory()
   CONDITIONAL_FREE(OP_mat);
   CONDITIONAL_FREE(net_chgs);
   CONDITIONAL_FREE(unique_atoms);
+  if( details->K_POINTS ){
+    for(int i=0;i<details->num_KPOINTS;i++){
+      CONDITIONAL_FREE(details->K_POINTS[i].star);
+    }
+  }
   CONDITIONAL_FREE(details->K_POINTS);
   CONDITIONAL_FREE(details->occup_KPOINTS);
   CONDITIONAL_FREE(details->moments);
   CONDITIONAL_FREE(details->characters);
   CONDITIONAL_FREE(details->atoms_to_vary);
+  free_FMO_memory(details);
   CONDITIONAL_FREE(unit_cell->atoms);
   CONDITIONAL_FREE(unit_cell->geom_frags);
   CONDITIONAL_FREE(unit_cell->distance_mat);
+  free_neighbor_list(unit_cell);
   CONDITIONAL_FREE(unit_cell->equiv_atoms);
   CONDITIONAL_FREE(properties.OP_mat);
   CONDITIONAL_FREE(properties.ROP_mat);
@@ -716,10 +1495,12 @@ void cleanup_memory()
   CONDITIONAL_FREE(unit_cell->atoms);
   CONDITIONAL_FREE(unit_cell->geom_frags);
   CONDITIONAL_FREE(unit_cell->distance_mat);
+  free_neighbor_list(unit_cell);
   CONDITIONAL_FREE(unit_cell->sym_elems);
   CONDITIONAL_FREE(unit_cell->equiv_atoms);
   CONDITIONAL_FREE(unit_cell);
   CONDITIONAL_FREE(details);
+  report_memory_leaks(status_file);
 }
 
 
@@ -49,44 +49,64 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /********************************************************************************
 *
-*                   Procedure mov
+*                   Procedure add_zeta_pair
 *
-* Arguments: sigma,pi,delta,phi: pointers to reals
+* Arguments: sk1s,sk2s,coeffs: pointers to real
+*                   num_pairs: pointer to int
+*             sk1,sk2,coeff: real
+*
+* Returns: none
+*
+* Action:  adds a pair of single zeta functions with exponents 'sk1 and
+*   'sk2, whose overlap is to be weighted by 'coeff, to the list which
+*   is handed to sto_radial_overlaps.
+*
+********************************************************************************/
+static void add_zeta_pair(real *sk1s,real *sk2s,real *coeffs,int *num_pairs,
+                          real sk1,real sk2,real coeff)
+{
+  sk1s[*num_pairs] = sk1;
+  sk2s[*num_pairs] = sk2;
+  coeffs[*num_pairs] = coeff;
+  (*num_pairs)++;
+}
+
+
+/********************************************************************************
+*
+*                   Procedure mov_components
+*
+* Arguments: components: pointer to reals
 *                 which1,which2: int
 *                          dist: real
-*        q_num1,q_num2,l1,l2,nn: int
+*           q_num1,q_num2,l1,l2: int
 *                         atoms: atom_type
+*                    derivative: char
 *
 *
 * Returns: none
 *
-* Action:  does whatever MOV did in the original program
+* Action:  does the work for mov and mov_derivative, i.e. sorts out
+*   the single and double zeta functions on the two atoms.
+*   'components is filled with sigma, pi, delta and phi.
 *
-*   comments will follow the clue when I get one
+*   The (up to four) pairs of single zeta functions are collected and
+*   handed to sto_radial_overlaps in one go.
 *
 ********************************************************************************/
-void mov(real *sigma,real *pi,real *delta,real *phi,int which1,int which2,real dist,int q_num1,int q_num2,
-         int l1,int l2,atom_type *atoms)
+static void mov_components(real *components,int which1,int which2,real dist,
+                           int q_num1,int q_num2,int l1,int l2,atom_type *atoms,
+                           char derivative)
 {
-  int i,j,num_zeta1,num_zeta2;
-  real coeff_1,coeff_2,sk1,sk2,r;
-
-  real A_fn_values[30], B_fn_values[30];
-  real ang_ind_overlap[4];
-
-  int loopvar,max, m=0, nn;  /* definitions for abfns.f and lovlap.f */
-  max = q_num1 + q_num2;
-
-  if(l1>l2){
-    nn=l2;
-  }
-  else{
-    nn=l1;
-  }
+  int num_zeta1,num_zeta2;
+  real coeff_1,coeff_2,sk1,sk2;
+  real sk1s[4],sk2s[4],coeffs[4],dists[4];
+  real overlaps[16];
+  int num_pairs,i,m;
 
   /* initialize the components of the overlap to zero */
-  *sigma=*pi=*delta=*phi=0.0;
-  ang_ind_overlap[0]=ang_ind_overlap[1]=ang_ind_overlap[2]=ang_ind_overlap[3]=0.0;
+  components[0]=components[1]=components[2]=components[3]=0.0;
+  num_pairs = 0;
 
   /* figure out whether or not we are using double zeta f'ns */
 
@@ -145,35 +165,7 @@ void mov(real *sigma,real *pi,real *delta,real *phi,int which1,int which2,real d
     if(l2 == 3) coeff_2 = atoms[which2].coeff_f1;
   }
 
-  /* call the routine to evaluate the A & B functions */
-
-  abfns(A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
-
-  /* test print of A and B functions */
-
-/*    fprintf(stderr,"zeta1[%f]-zeta1[%f] call ...\n",sk1,sk2);
-    loopvar=0;
-    while(loopvar <= max)
-      {
-        fprintf(stderr,"A(%d)= %.16f \t B(%d)= %f\n",loopvar,A_fn_values[loopvar],loopvar,B_fn_values[loopvar]);
-        loopvar++;
-      }
-*/
-
-  /* call the routine to evaluate sigma,pi,... overlaps in the local ref frame */
-
-  for(i=0;i<=nn;i++)
-    {
-      m=i;
-      lovlap(&(ang_ind_overlap[i]),A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
-    }
-
-  /* add in the contributions we have found thus far */
-
-  *sigma += coeff_1*coeff_2*ang_ind_overlap[0];
-  *pi += coeff_1*coeff_2*ang_ind_overlap[1];
-  *delta += coeff_1*coeff_2*ang_ind_overlap[2];
-  *phi += coeff_1*coeff_2*ang_ind_overlap[3];
+  add_zeta_pair(sk1s,sk2s,coeffs,&num_pairs,sk1,sk2,coeff_1*coeff_2);
 
   /* now do zeta1 - zeta2 overlap if applicable */
 
@@ -187,17 +179,7 @@ void mov(real *sigma,real *pi,real *delta,real *phi,int which1,int which2,real d
       coeff_2 = atoms[which2].coeff_f2;
     }
 
-    abfns(A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
-
-    for(i=0;i<=nn;i++){
-      m=i;
-      lovlap(&(ang_ind_overlap[i]),A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
-    }
-
-    *sigma += coeff_1*coeff_2*ang_ind_overlap[0];
-    *pi += coeff_1*coeff_2*ang_ind_overlap[1];
-    *delta += coeff_1*coeff_2*ang_ind_overlap[2];
-    *phi += coeff_1*coeff_2*ang_ind_overlap[3];
+    add_zeta_pair(sk1s,sk2s,coeffs,&num_pairs,sk1,sk2,coeff_1*coeff_2);
   }
 
   /* now do zeta2 - zeta2 */
@@ -212,17 +194,7 @@ void mov(real *sigma,real *pi,real *delta,real *phi,int which1,int which2,real d
       coeff_1 = atoms[which1].coeff_f2;
     }
 
-    abfns(A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
-
-    for(i=0;i<=nn;i++){
-      m=i;
-      lovlap(&(ang_ind_overlap[i]),A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
-    }
-
-    *sigma += coeff_1*coeff_2*ang_ind_overlap[0];
-    *pi += coeff_1*coeff_2*ang_ind_overlap[1];
-    *delta += coeff_1*coeff_2*ang_ind_overlap[2];
-    *phi += coeff_1*coeff_2*ang_ind_overlap[3];
+    add_zeta_pair(sk1s,sk2s,coeffs,&num_pairs,sk1,sk2,coeff_1*coeff_2);
 
     /* finally do zeta2 - zeta1 */
 
@@ -236,16 +208,78 @@ void mov(real *sigma,real *pi,real *delta,real *phi,int which1,int which2,real d
         coeff_2 = atoms[which2].coeff_f1;
       }
 
-      abfns(A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
+      add_zeta_pair(sk1s,sk2s,coeffs,&num_pairs,sk1,sk2,coeff_1*coeff_2);
+    }
+  }
 
-      for(i=0;i<=nn;i++){
-        m=i;
-        lovlap(&(ang_ind_overlap[i]),A_fn_values,B_fn_values,&sk1,&sk2,&dist,&l1,&l2,&m,&q_num1,&q_num2,&max);
-      }
-      *sigma += coeff_1*coeff_2*ang_ind_overlap[0];
-      *pi += coeff_1*coeff_2*ang_ind_overlap[1];
-      *delta += coeff_1*coeff_2*ang_ind_overlap[2];
-      *phi += coeff_1*coeff_2*ang_ind_overlap[3];
+  /* evaluate all the pairs at once and add in the contributions */
+  for(i=0;i<num_pairs;i++) dists[i] = dist;
+  sto_radial_overlaps(overlaps,num_pairs,dists,sk1s,sk2s,q_num1,q_num2,l1,l2,
+                      derivative);
+  for(i=0;i<num_pairs;i++){
+    for(m=0;m<4;m++){
+      components[m] += coeffs[i]*overlaps[m*num_pairs+i];
     }
   }
 }
+
+
+/********************************************************************************
+*
+*                   Procedure mov
+*
+* Arguments: sigma,pi,delta,phi: pointers to reals
+*                 which1,which2: int
+*                          dist: real
+*        q_num1,q_num2,l1,l2,nn: int
+*                         atoms: atom_type
+*
+*
+* Returns: none
+*
+* Action:  does whatever MOV did in the original program
+*
+*   comments will follow the clue when I get one
+*
+********************************************************************************/
+void mov(real *sigma,real *pi,real *delta,real *phi,int which1,int which2,real dist,int q_num1,int q_num2,
+         int l1,int l2,atom_type *atoms)
+{
+  real components[4];
+
+  mov_components(components,which1,which2,dist,q_num1,q_num2,l1,l2,atoms,0);
+  *sigma = components[0];
+  *pi = components[1];
+  *delta = components[2];
+  *phi = components[3];
+}
+
+
+/********************************************************************************
+*
+*                   Procedure mov_derivative
+*
+* Arguments: sigma,pi,delta,phi: pointers to reals
+*                 which1,which2: int
+*                          dist: real
+*           q_num1,q_num2,l1,l2: int
+*                         atoms: atom_type
+*
+*
+* Returns: none
+*
+* Action:  like mov, but returns the derivatives of the sigma, pi, delta
+*   and phi overlaps with respect to the distance (in bohr) between the atoms.
+*
+********************************************************************************/
+void mov_derivative(real *sigma,real *pi,real *delta,real *phi,int which1,int which2,
+                    real dist,int q_num1,int q_num2,int l1,int l2,atom_type *atoms)
+{
+  real components[4];
+
+  mov_components(components,which1,which2,dist,q_num1,q_num2,l1,l2,atoms,1);
+  *sigma = components[0];
+  *pi = components[1];
+  *delta = components[2];
+  *phi = components[3];
+}
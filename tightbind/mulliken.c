@@ -39,6 +39,57 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 #include "bind.h"
 
+/****************************************************************************
+ *
+ *                   Function find_HOMO_degeneracy
+ *
+ * Arguments: num_electrons: real
+ *                 num_orbs: int
+ *                 energies: pointer to real
+ *              begin_degen: pointer to int
+ *
+ * Returns: int
+ *
+ * Action:  finds the levels which are degenerate with the HOMO when
+ *    'num_electrons are put into the levels in 'energies (which are
+ *    sorted).  The first of those levels is put in 'begin_degen and the
+ *    number of them is returned.
+ *
+ *   If the HOMO is degenerate a note is put in the output file.
+ *
+ ****************************************************************************/
+int find_HOMO_degeneracy(real num_electrons,int num_orbs,real *energies,
+                         int *begin_degen)
+{
+  int i,last_occup,end_degen;
+  real electrons_left;
+
+  /* find the HOMO the same way calc_occupations fills the levels */
+  electrons_left = num_electrons;
+  for(i=0;i<num_orbs && electrons_left > 0.0;i++){
+    electrons_left -= 2.0;
+  }
+  last_occup = i-1;
+  *begin_degen = last_occup;
+  if( last_occup < 0 ) return 0;
+
+  end_degen = i;
+  while( end_degen < num_orbs &&
+        fabs(energies[last_occup] - energies[end_degen]) < DEGEN_TOL ){
+    end_degen++;
+  }
+  while( *begin_degen > 0 &&
+        fabs(energies[last_occup] - energies[*begin_degen-1]) < DEGEN_TOL ){
+    (*begin_degen)--;
+  }
+
+  if( end_degen - *begin_degen > 1 ){
+    fprintf(output_file,"; >>>>> The HOMO was found to be %d-fold degenerate.\n",
+            end_degen - *begin_degen);
+  }
+  return end_degen - *begin_degen;
+}
+
 /****************************************************************************
  *
  *                   Procedure calc_occupations
@@ -62,7 +113,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  ****************************************************************************/
 void calc_occupations(detail_type *details,real num_electrons,int num_orbs,real *occupations,eigenset_type eigenset)
 {
-  int i,begin_degen,end_degen,num_degen_levels,last_occup;
+  int i,begin_degen,end_degen,num_degen_levels;
   real num_degen_electrons;
   real electrons_left,electrons_per_level;
 
@@ -81,24 +132,10 @@ void calc_occupations(detail_type *details,real num_electrons,int num_orbs,real
   }
 
   /* now check for degeneracies */
-  last_occup = i-1;
-  end_degen = i;
-  while( fabs(EIGENVAL(eigenset,last_occup) - EIGENVAL(eigenset,end_degen)) < DEGEN_TOL
-        && end_degen < num_orbs ){
-    end_degen++;
-  }
-  begin_degen = last_occup - 1;
-  while( fabs(EIGENVAL(eigenset,last_occup) - EIGENVAL(eigenset,begin_degen)) < DEGEN_TOL
-        && begin_degen > -1){
-    begin_degen--;
-  }
-  /* we went one step too far, so increment begin_degen */
-  begin_degen++;
-
-  num_degen_levels = end_degen-begin_degen;
+  num_degen_levels = find_HOMO_degeneracy(num_electrons,num_orbs,eigenset.val,
+                                          &begin_degen);
+  end_degen = begin_degen+num_degen_levels;
   if( num_degen_levels > 1){
-    fprintf(output_file,"; >>>>> The HOMO was found to be %d-fold degenerate.\n",num_degen_levels);
-
     /********
       now adjust the occupation numbers for the degenerate orbitals
         do this by finding the number of electrons in degenerate levels and
@@ -219,10 +256,8 @@ void FMO_reduced_mulliken(detail_type *details,int num_atoms,int num_orbs,real *
   FMO_frag_type *FMO_frag1,*FMO_frag2;
   int frag1,frag2;
   int orbs_so_far1,orbs_so_far2;
-  int i,j,k,l;
+  int j,k,l;
   int ktab;
-  int i_orb_tab, j_orb_tab;
-  int i_orb_end,j_orb_end;
   int num_elements;
   real temp;
 
@@ -311,6 +346,106 @@ void FMO_reduced_mulliken(detail_type *details,int num_atoms,int num_orbs,real *
 }
 
 
+/****************************************************************************
+ *
+ *                   Function FMO_OP_element
+ *
+ * Arguments: eigenset: eigenset_type
+ *             overlap: hermetian_matrix_type
+ *            num_orbs: int
+ *         occupations: pointer to real
+ *                 i,j: ints
+ *
+ * Returns: real
+ *
+ * Action:  Returns element i,j of the overlap population matrix, computed
+ *   exactly as it is in eval_mulliken.
+ *
+ ****************************************************************************/
+static real FMO_OP_element(eigenset_type eigenset,hermetian_matrix_type overlap,
+                           int num_orbs,real *occupations,int i,int j)
+{
+  int k;
+  real OP_accum;
+
+  OP_accum = 0.0;
+  for(k=0;k<num_orbs;k++){
+    OP_accum += occupations[k]*EIGENVECT_R(eigenset,k,i)*EIGENVECT_R(eigenset,k,j);
+    OP_accum += occupations[k]*EIGENVECT_I(eigenset,k,i)*EIGENVECT_I(eigenset,k,j);
+  }
+  if( i != j ){
+    return 2.0 * OP_accum * HERMETIAN_R(overlap,i,j);
+  }
+  else{
+    return OP_accum * HERMETIAN_R(overlap,i,j);
+  }
+}
+
+
+/****************************************************************************
+ *
+ *                   Procedure FMO_block_mulliken
+ *
+ * Arguments: details: pointer to detail_type
+ *           eigenset: eigenset_type
+ *            overlap: hermetian_matrix_type
+ *           num_orbs: int
+ *        occupations: pointer to real
+ *         ROP_matrix: pointer to real
+ *
+ * Returns: none
+ *
+ * Action:  Generates the same reduced overlap population matrix as
+ *    FMO_reduced_mulliken without building the whole overlap population
+ *    matrix.  Only the elements which are summed into the reduced matrix
+ *    (the blocks below the diagonal and the diagonal elements) are
+ *    evaluated.
+ *
+ *   This is used when the full matrix isn't going to be printed.
+ *
+ ****************************************************************************/
+void FMO_block_mulliken(detail_type *details,eigenset_type eigenset,
+                        hermetian_matrix_type overlap,int num_orbs,
+                        real *occupations,real *ROP_matrix)
+{
+  FMO_frag_type *FMO_frag1,*FMO_frag2;
+  int frag1,frag2;
+  int orbs_so_far1,orbs_so_far2;
+  int j,k,l;
+  int num_elements;
+  real temp;
+
+  num_elements = 0;
+  orbs_so_far1 = 0;
+  for(frag1=0;frag1<details->num_FMO_frags;frag1++){
+    FMO_frag1 = &(details->FMO_frags[frag1]);
+
+    /* do the cross terms involving this fragment */
+    orbs_so_far2 = 0;
+    for(frag2=0;frag2<frag1;frag2++){
+      FMO_frag2 = &(details->FMO_frags[frag2]);
+      temp = 0;
+      for(k=0; k<FMO_frag1->num_orbs; k++){
+        for(l=0; l<FMO_frag2->num_orbs; l++){
+          temp += FMO_OP_element(eigenset,overlap,num_orbs,occupations,
+                                 k+orbs_so_far1,orbs_so_far2+l);
+        }
+      }
+      ROP_matrix[num_elements++] = temp;
+      orbs_so_far2 += FMO_frag2->num_orbs;
+    }
+
+    /* now add up the diagonal elements which arise from this fragment */
+    temp = 0;
+    for(j=0; j<FMO_frag1->num_orbs; j++,orbs_so_far1++){
+      temp += FMO_OP_element(eigenset,overlap,num_orbs,occupations,
+                             orbs_so_far1,orbs_so_far1);
+    }
+    ROP_matrix[num_elements++] = temp;
+  }
+}
+
+
 
 
 /****************************************************************************
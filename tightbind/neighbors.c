@@ -0,0 +1,424 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+
+/****************************************************************************
+*
+*     this file contains the list of neighboring atoms.
+*
+*   For each atom in the unit cell, the list has the atoms (in the unit
+*    cell and in the cells around it) which are within a cut off
+*    distance.  It's built by sorting the atoms into boxes at least as
+*    big as the cut off, so only atoms in adjacent boxes need to be
+*    checked and building the list takes time proportional to the number
+*    of atoms rather than its square.
+*
+*   The cells included are those within cell->overlaps (and at least
+*    one cell) in each direction.  The list is rebuilt whenever the atoms
+*    move or a larger cut off is asked for.
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+/* pairs this much farther apart than the cut off are also included */
+#define NEIGHBOR_SLACK 1e-4
+
+/* used to match translation vectors */
+#define NEIGHBOR_IMAGE_TOL 1e-6
+
+
+/****************************************************************************
+*
+*                   Procedure free_neighbor_list
+*
+* Arguments:  cell: pointer to cell_type
+*
+* Returns: none
+*
+* Action: frees the neighbor list of 'cell (if there is one).
+*
+*****************************************************************************/
+void free_neighbor_list(cell_type *cell)
+{
+  neighbor_list_type *neighbors;
+
+  neighbors = cell->neighbors;
+  if( !neighbors ) return;
+  if( neighbors->images ) free(neighbors->images);
+  if( neighbors->first ) free(neighbors->first);
+  if( neighbors->partner ) my_free(neighbors->partner);
+  if( neighbors->locs ) free(neighbors->locs);
+  free(neighbors);
+  cell->neighbors = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function neighbor_list_is_current
+*
+* Arguments:  cell: pointer to cell_type
+*           cutoff: real
+*       max_image: int[3]
+*
+* Returns: char
+*
+* Action: returns 1 if the neighbor list of 'cell was built for the current
+*   atomic positions with at least 'cutoff and the cells in 'max_image.
+*
+*****************************************************************************/
+static char neighbor_list_is_current(cell_type *cell,real cutoff,int max_image[3])
+{
+  neighbor_list_type *neighbors;
+  int i;
+
+  neighbors = cell->neighbors;
+  if( !neighbors || neighbors->num_atoms != cell->num_atoms ||
+      neighbors->cutoff < cutoff ) return 0;
+  for(i=0;i<3;i++){
+    if( neighbors->max_image[i] != max_image[i] ) return 0;
+  }
+  for(i=0;i<cell->num_atoms;i++){
+    if( neighbors->locs[i].x != cell->atoms[i].loc.x ||
+        neighbors->locs[i].y != cell->atoms[i].loc.y ||
+        neighbors->locs[i].z != cell->atoms[i].loc.z ) return 0;
+  }
+  return 1;
+}
+
+
+/****************************************************************************
+*
+*                   Function compare_ints
+*
+* Arguments: p1, p2: pointers to void
+*
+* Returns: int
+*
+* Action: the comparison function used to qsort the neighbors.
+*
+*****************************************************************************/
+static int compare_ints(const void *p1,const void *p2)
+{
+  return *(const int *)p1 - *(const int *)p2;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure build_neighbor_list
+*
+* Arguments:  cell: pointer to cell_type
+*           cutoff: real
+*       max_image: int[3]
+*
+* Returns: none
+*
+* Action: builds the list of the atoms within 'cutoff of each atom
+*   in the unit cell.
+*
+*   Each copy of an atom in one of the cells is a point, numbered
+*    t*num_atoms + j for atom j in cell t.  The points near the unit cell
+*    are sorted into boxes, then the boxes around each atom are searched.
+*    Sorting the numbers of the points found sorts them by cell, then
+*    by atom, which is the order the list needs.
+*
+*****************************************************************************/
+static void build_neighbor_list(cell_type *cell,real cutoff,int max_image[3])
+{
+  neighbor_list_type *neighbors;
+  neighbor_image_type *image;
+  point_type cell_dim[3],lo,hi,loc;
+  real box_size,limit,dist,temp;
+  int num_atoms,num_images,num_points,num_boxes;
+  int box_dims[3];
+  int *box_start,*box_members;
+  int *candidates,num_candidates,max_candidates,max_pairs;
+  int i,j,t,n0,n1,n2,p,k;
+  int bx,by,bz,x,y,z,box;
+
+  num_atoms = cell->num_atoms;
+  free_neighbor_list(cell);
+  neighbors = (neighbor_list_type *)calloc(1,sizeof(neighbor_list_type));
+  if( !neighbors ) fatal("Can't allocate the neighbor list.");
+  cell->neighbors = neighbors;
+  neighbors->cutoff = cutoff;
+  neighbors->num_atoms = num_atoms;
+
+  /******
+    the translations
+  ******/
+  for(i=0;i<cell->dim;i++){
+    cell_dim[i].x = cell->atoms[cell->tvects[i].end].loc.x -
+      cell->atoms[cell->tvects[i].begin].loc.x;
+    cell_dim[i].y = cell->atoms[cell->tvects[i].end].loc.y -
+      cell->atoms[cell->tvects[i].begin].loc.y;
+    cell_dim[i].z = cell->atoms[cell->tvects[i].end].loc.z -
+      cell->atoms[cell->tvects[i].begin].loc.z;
+  }
+  for(;i<3;i++) cell_dim[i].x = cell_dim[i].y = cell_dim[i].z = 0.0;
+
+  num_images = 1;
+  for(i=0;i<3;i++){
+    neighbors->max_image[i] = max_image[i];
+    num_images *= 2*max_image[i]+1;
+  }
+  neighbors->num_images = num_images;
+  neighbors->images = (neighbor_image_type *)calloc(num_images,
+                                                    sizeof(neighbor_image_type));
+  neighbors->locs = (point_type *)calloc(num_atoms,sizeof(point_type));
+  if( !neighbors->images || !neighbors->locs )
+    fatal("Can't allocate the neighbor list.");
+  t = 0;
+  for(n0=-max_image[0];n0<=max_image[0];n0++){
+    for(n1=-max_image[1];n1<=max_image[1];n1++){
+      for(n2=-max_image[2];n2<=max_image[2];n2++){
+        image = &(neighbors->images[t++]);
+        image->n[0] = n0;
+        image->n[1] = n1;
+        image->n[2] = n2;
+        image->vect.x = n0*cell_dim[0].x + n1*cell_dim[1].x + n2*cell_dim[2].x;
+        image->vect.y = n0*cell_dim[0].y + n1*cell_dim[1].y + n2*cell_dim[2].y;
+        image->vect.z = n0*cell_dim[0].z + n1*cell_dim[1].z + n2*cell_dim[2].z;
+      }
+    }
+  }
+  for(i=0;i<num_atoms;i++){
+    neighbors->locs[i].x = cell->atoms[i].loc.x;
+    neighbors->locs[i].y = cell->atoms[i].loc.y;
+    neighbors->locs[i].z = cell->atoms[i].loc.z;
+  }
+
+  /******
+
+    set up the boxes.  They cover the unit cell plus one box on each side,
+    and are at least as big as the cut off.  If that would give too many
+    boxes, they're made bigger.
+
+  ******/
+  limit = cutoff + NEIGHBOR_SLACK;
+  if( limit < NEIGHBOR_SLACK ) limit = NEIGHBOR_SLACK;
+  lo = hi = neighbors->locs[0];
+  for(i=1;i<num_atoms;i++){
+    loc = neighbors->locs[i];
+    if( loc.x < lo.x ) lo.x = loc.x;
+    if( loc.y < lo.y ) lo.y = loc.y;
+    if( loc.z < lo.z ) lo.z = loc.z;
+    if( loc.x > hi.x ) hi.x = loc.x;
+    if( loc.y > hi.y ) hi.y = loc.y;
+    if( loc.z > hi.z ) hi.z = loc.z;
+  }
+  box_size = limit;
+  while(1){
+    box_dims[0] = (int)((hi.x - lo.x)/box_size) + 3;
+    box_dims[1] = (int)((hi.y - lo.y)/box_size) + 3;
+    box_dims[2] = (int)((hi.z - lo.z)/box_size) + 3;
+    temp = (real)box_dims[0]*(real)box_dims[1]*(real)box_dims[2];
+    if( temp <= 8.0*num_atoms + 64.0 ) break;
+    box_size *= 1.5;
+  }
+  lo.x -= box_size;
+  lo.y -= box_size;
+  lo.z -= box_size;
+  num_boxes = box_dims[0]*box_dims[1]*box_dims[2];
+  num_points = num_atoms*num_images;
+
+  box_start = (int *)calloc(num_boxes+1,sizeof(int));
+  box_members = (int *)calloc(num_points,sizeof(int));
+  if( !box_start || !box_members ) fatal("Can't allocate neighbor boxes.");
+
+  /* count the points in each box, then put them in */
+#define POINT_BOX(_p_,_box_) {                                          \
+    t = (_p_)/num_atoms;                                                \
+    j = (_p_)%num_atoms;                                                \
+    x = (int)floor((neighbors->locs[j].x + neighbors->images[t].vect.x - lo.x)/box_size); \
+    y = (int)floor((neighbors->locs[j].y + neighbors->images[t].vect.y - lo.y)/box_size); \
+    z = (int)floor((neighbors->locs[j].z + neighbors->images[t].vect.z - lo.z)/box_size); \
+    if( x < 0 || y < 0 || z < 0 ||                                      \
+        x >= box_dims[0] || y >= box_dims[1] || z >= box_dims[2] ) _box_ = -1; \
+    else _box_ = (x*box_dims[1] + y)*box_dims[2] + z;                   \
+  }
+  for(p=0;p<num_points;p++){
+    POINT_BOX(p,box);
+    if( box >= 0 ) box_start[box+1]++;
+  }
+  for(box=0;box<num_boxes;box++) box_start[box+1] += box_start[box];
+  for(p=0;p<num_points;p++){
+    POINT_BOX(p,box);
+    if( box >= 0 ) box_members[box_start[box]++] = p;
+  }
+  /* box_start was shifted by the last loop, shift it back */
+  for(box=num_boxes;box>0;box--) box_start[box] = box_start[box-1];
+  box_start[0] = 0;
+
+  /******
+
+    now find the neighbors of each atom
+
+  ******/
+  max_candidates = 64;
+  candidates = (int *)calloc(max_candidates,sizeof(int));
+  max_pairs = 16*num_atoms + 64;
+  neighbors->partner = (int *)calloc(max_pairs,sizeof(int));
+  neighbors->first = (int *)calloc(num_atoms*num_images+1,sizeof(int));
+  if( !candidates || !neighbors->partner || !neighbors->first )
+    fatal("Can't allocate the neighbor list.");
+  neighbors->num_pairs = 0;
+  limit *= limit;
+
+  for(i=0;i<num_atoms;i++){
+    loc = neighbors->locs[i];
+    bx = (int)floor((loc.x - lo.x)/box_size);
+    by = (int)floor((loc.y - lo.y)/box_size);
+    bz = (int)floor((loc.z - lo.z)/box_size);
+    num_candidates = 0;
+    for(x=bx-1;x<=bx+1;x++){
+      if( x < 0 || x >= box_dims[0] ) continue;
+      for(y=by-1;y<=by+1;y++){
+        if( y < 0 || y >= box_dims[1] ) continue;
+        for(z=bz-1;z<=bz+1;z++){
+          if( z < 0 || z >= box_dims[2] ) continue;
+          box = (x*box_dims[1] + y)*box_dims[2] + z;
+          for(k=box_start[box];k<box_start[box+1];k++){
+            p = box_members[k];
+            t = p/num_atoms;
+            j = p%num_atoms;
+            image = &(neighbors->images[t]);
+            if( j == i && !image->n[0] && !image->n[1] && !image->n[2] ) continue;
+            temp = neighbors->locs[j].x + image->vect.x - loc.x;
+            dist = temp*temp;
+            temp = neighbors->locs[j].y + image->vect.y - loc.y;
+            dist += temp*temp;
+            temp = neighbors->locs[j].z + image->vect.z - loc.z;
+            dist += temp*temp;
+            if( dist <= limit ){
+              if( num_candidates == max_candidates ){
+                max_candidates *= 2;
+                candidates = (int *)my_realloc((int *)candidates,
+                                               max_candidates*sizeof(int));
+                if( !candidates ) fatal("Can't reallocate neighbor candidates.");
+              }
+              candidates[num_candidates++] = p;
+            }
+          }
+        }
+      }
+    }
+    qsort((void *)candidates,num_candidates,sizeof(int),compare_ints);
+
+    if( neighbors->num_pairs + num_candidates > max_pairs ){
+      while( neighbors->num_pairs + num_candidates > max_pairs ) max_pairs *= 2;
+      neighbors->partner = (int *)my_realloc((int *)neighbors->partner,
+                                             max_pairs*sizeof(int));
+      if( !neighbors->partner ) fatal("Can't reallocate the neighbor list.");
+    }
+    k = 0;
+    for(t=0;t<num_images;t++){
+      neighbors->first[i*num_images+t] = neighbors->num_pairs;
+      while( k < num_candidates && candidates[k]/num_atoms == t ){
+        neighbors->partner[neighbors->num_pairs++] = candidates[k]%num_atoms;
+        k++;
+      }
+    }
+  }
+  neighbors->first[num_atoms*num_images] = neighbors->num_pairs;
+#undef POINT_BOX
+
+  my_free(candidates);
+  free(box_members);
+  free(box_start);
+
+  fprintf(status_file,"Neighbor list: %d pairs within %6.4lf A in %d cells.\n",
+          neighbors->num_pairs,cutoff,num_images);
+}
+
+
+/****************************************************************************
+*
+*                   Function get_neighbor_list
+*
+* Arguments:  cell: pointer to cell_type
+*           cutoff: real
+*
+* Returns: pointer to neighbor_list_type
+*
+* Action: returns a neighbor list for the current positions of the atoms
+*   in 'cell which includes all pairs closer than 'cutoff.  The list is
+*   only rebuilt if the one stored in 'cell won't do.
+*
+*****************************************************************************/
+neighbor_list_type *get_neighbor_list(cell_type *cell,real cutoff)
+{
+  int max_image[3];
+  int i;
+
+  for(i=0;i<3;i++){
+    if( i < cell->dim ){
+      max_image[i] = cell->overlaps[i] > 1 ? cell->overlaps[i] : 1;
+    } else{
+      max_image[i] = 0;
+    }
+  }
+  if( !neighbor_list_is_current(cell,cutoff,max_image) ){
+    build_neighbor_list(cell,cutoff,max_image);
+  }
+  return cell->neighbors;
+}
+
+
+/****************************************************************************
+*
+*                   Function find_neighbor_image
+*
+* Arguments: neighbors: pointer to neighbor_list_type
+*                 vect: point_type
+*
+* Returns: int
+*
+* Action: returns the index of the cell translated by 'vect in 'neighbors,
+*   or -1 if it isn't there.
+*
+*****************************************************************************/
+int find_neighbor_image(neighbor_list_type *neighbors,point_type vect)
+{
+  neighbor_image_type *image;
+  int t;
+
+  for(t=0;t<neighbors->num_images;t++){
+    image = &(neighbors->images[t]);
+    if( fabs(image->vect.x - vect.x) < NEIGHBOR_IMAGE_TOL &&
+        fabs(image->vect.y - vect.y) < NEIGHBOR_IMAGE_TOL &&
+        fabs(image->vect.z - vect.z) < NEIGHBOR_IMAGE_TOL ) return t;
+  }
+  return -1;
+}
@@ -243,6 +243,9 @@ contributions.");
              &(points[num_k_points].loc.x),&(points[num_k_points].loc.y),
              &(points[num_k_points].loc.z),
              &(points[num_k_points].weight),&(points[num_k_points].num_filled_bands));
+      /* these points don't carry their stars with them */
+      points[num_k_points].num_in_star = 0;
+      points[num_k_points].star = 0;
       num_k_points++;
 
       /* check to see if there's still enough memory */
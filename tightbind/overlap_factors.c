@@ -0,0 +1,406 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+
+/****************************************************************************
+*
+*     this file contains the cache for the Cholesky factors of the
+*      overlap matrices.
+*
+*   Solving the generalized eigenvalue problem H C = S C E starts by
+*    factoring S = L L^H.  During charge iteration only the H_ii's
+*    change from one cycle to the next, so the factors computed
+*    in the first cycle can be used for all of the following ones.
+*
+*   The factors are kept in "slots", one per k point (and one per k point
+*    for each FMO fragment).  They live in memory unless we're in THIN
+*    mode (or memory or the memory budget runs out), in which case
+*    they're written to a scratch file.
+*
+*   The FMO fragments may be diagonalized in parallel (see diagonalize_FMO),
+*    so the cache is only touched inside the overlap_factor_cache
+*    critical section.
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+typedef struct {
+  int dim;
+  real *factor;
+  long file_pos;
+} overlap_factor_type;
+
+static overlap_factor_type *overlap_factors=0;
+static int num_overlap_factors=0;
+static char overlap_factor_caching=0;
+static char overlap_factor_spill=0;
+static FILE *overlap_factor_file=0;
+static long overlap_factor_file_end=0;
+static int overlap_factor_hits=0,overlap_factor_misses=0;
+
+
+/****************************************************************************
+*
+*                   Procedure free_overlap_factors
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: throws away all the cached factors and turns off caching.
+*
+*****************************************************************************/
+void free_overlap_factors()
+{
+  int i;
+
+  for(i=0;i<num_overlap_factors;i++){
+    if( overlap_factors[i].factor ) my_free(overlap_factors[i].factor);
+  }
+  if( overlap_factors ) my_free(overlap_factors);
+  overlap_factors = 0;
+  num_overlap_factors = 0;
+  if( overlap_factor_file ) fclose(overlap_factor_file);
+  overlap_factor_file = 0;
+  overlap_factor_file_end = 0;
+  overlap_factor_caching = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure reset_overlap_factors
+*
+* Arguments: details: pointer to detail_type
+*
+* Returns: none
+*
+* Action: empties the cache.  This needs to be called every time the
+*   overlap matrices change.
+*
+*   Caching is only turned on if we're going to be diagonalizing with the
+*    same overlap matrices more than once (i.e. charge iteration).
+*
+*****************************************************************************/
+void reset_overlap_factors(detail_type *details)
+{
+  free_overlap_factors();
+  overlap_factor_caching = details->do_chg_it && !details->diag_wo_overlap;
+  overlap_factor_spill = details->Execution_Mode == THIN;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure report_overlap_factors
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: writes the number of cache hits and misses since the last
+*   report to the status file.
+*
+*****************************************************************************/
+void report_overlap_factors()
+{
+  if( !overlap_factor_caching ) return;
+  fprintf(status_file,"Overlap factorizations: %d reused, %d computed.\n",
+          overlap_factor_hits,overlap_factor_misses);
+  overlap_factor_hits = 0;
+  overlap_factor_misses = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure fetch_overlap_factor
+*
+* Arguments: slot: int
+*             dim: int
+*            dest: pointer to real
+*
+* Returns: char
+*
+* Action: copies the dim x dim factor stored in 'slot into 'dest.
+*   Returns 1 if there was one to copy, 0 otherwise.
+*
+*****************************************************************************/
+static char fetch_overlap_factor(int slot,int dim,real *dest)
+{
+  overlap_factor_type *entry;
+
+  if( slot < 0 || slot >= num_overlap_factors ) return 0;
+  entry = &(overlap_factors[slot]);
+  if( entry->dim != dim ) return 0;
+
+  if( entry->factor ){
+    bcopy((char *)entry->factor,(char *)dest,dim*dim*sizeof(real));
+  } else{
+    fseek(overlap_factor_file,entry->file_pos,SEEK_SET);
+    if( fread(dest,sizeof(real),dim*dim,overlap_factor_file) != dim*dim ){
+      error("Can't read an overlap factor back from the scratch file.");
+      entry->dim = 0;
+      return 0;
+    }
+  }
+  return 1;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure store_overlap_factor
+*
+* Arguments: slot: int
+*             dim: int
+*             src: pointer to real
+*
+* Returns: none
+*
+* Action: puts a copy of the dim x dim factor in 'src into 'slot.
+*
+*****************************************************************************/
+static void store_overlap_factor(int slot,int dim,real *src)
+{
+  overlap_factor_type *entry;
+  int i,old_tag;
+
+  if( slot < 0 ) return;
+  if( slot >= num_overlap_factors ){
+    overlap_factors = (overlap_factor_type *)
+      my_realloc((int *)overlap_factors,(slot+1)*sizeof(overlap_factor_type));
+    if( !overlap_factors ) fatal("Can't realloc overlap_factors.");
+    for(i=num_overlap_factors;i<=slot;i++){
+      overlap_factors[i].dim = 0;
+      overlap_factors[i].factor = 0;
+      overlap_factors[i].file_pos = -1;
+    }
+    num_overlap_factors = slot+1;
+  }
+  entry = &(overlap_factors[slot]);
+
+  if( entry->dim != dim ){
+    if( entry->factor ) my_free(entry->factor);
+    entry->factor = 0;
+    entry->file_pos = -1;
+    /* go to disk once the factors won't fit into the memory budget */
+    if( !overlap_factor_spill && !memory_fits((long)dim*dim*sizeof(real)) ){
+      fprintf(status_file,
+              "Writing the overlap factors to a scratch file to stay within the memory budget.\n");
+      overlap_factor_spill = 1;
+    }
+    if( !overlap_factor_spill ){
+      old_tag = set_mem_tag(MEM_DIAG_WORK);
+      entry->factor = (real *)my_malloc(dim*dim*sizeof(real));
+      set_mem_tag(old_tag);
+      /* if we've run out of memory, put this one on disk */
+      if( !entry->factor ) overlap_factor_spill = 1;
+    }
+    if( !entry->factor ){
+      if( !overlap_factor_file ){
+        overlap_factor_file = tmpfile();
+        if( !overlap_factor_file ){
+          error("Can't open a scratch file for the overlap factors.");
+          overlap_factor_caching = 0;
+          entry->dim = 0;
+          return;
+        }
+      }
+      entry->file_pos = overlap_factor_file_end;
+      overlap_factor_file_end += dim*dim*sizeof(real);
+    }
+    entry->dim = dim;
+  }
+
+  if( entry->factor ){
+    bcopy((char *)src,(char *)entry->factor,dim*dim*sizeof(real));
+  } else{
+    fseek(overlap_factor_file,entry->file_pos,SEEK_SET);
+    if( fwrite(src,sizeof(real),dim*dim,overlap_factor_file) != dim*dim ){
+      error("Can't write an overlap factor to the scratch file.");
+      entry->dim = 0;
+    }
+  }
+}
+
+
+#ifndef USE_LAPACK
+/****************************************************************************
+*
+*                   Procedure cached_cboris
+*
+* Arguments: slot: int
+*               n: pointer to int
+*      a,b,c,d,e,f: pointers to real
+*            fail: pointer to int
+*
+* Returns: none
+*
+* Action: a drop-in replacement for cboris (arguments as there, with
+*   nd = n) which reuses the Cholesky factor of 'b cached in 'slot.
+*   If caching is off or 'slot is negative, this is just cboris.
+*
+*****************************************************************************/
+void cached_cboris(int slot,int *n,real *a,real *b,real *c,real *d,real *e,
+                   real *f,int *fail)
+{
+  char found=0;
+
+#ifdef _OPENMP
+#pragma omp critical(overlap_factor_cache)
+#endif
+  {
+    if( overlap_factor_caching && slot >= 0 && fetch_overlap_factor(slot,*n,b) ){
+      overlap_factor_hits++;
+      found = 1;
+    }
+  }
+  if( found ){
+    cboris_factored(n,n,a,b,c,d,e,f,fail);
+  } else{
+    cboris(n,n,a,b,c,d,e,f,fail);
+    if( overlap_factor_caching && slot >= 0 && *fail != 1 ){
+      /* b now holds the factor */
+#ifdef _OPENMP
+#pragma omp critical(overlap_factor_cache)
+#endif
+      {
+        overlap_factor_misses++;
+        store_overlap_factor(slot,*n,b);
+      }
+    }
+  }
+}
+
+#else
+/****************************************************************************
+*
+*                   Procedure cached_zhegv
+*
+* Arguments: slot: int
+*            jobz: pointer to char
+*               n: pointer to int
+*             a,b: pointers to complex
+*               w: pointer to real
+*            work: pointer to complex
+*           lwork: pointer to int
+*           rwork: pointer to real
+*            info: pointer to int
+*
+* Returns: none
+*
+* Action: a drop-in replacement for zhegv with itype = 1, uplo = 'L'
+*   and lda = ldb = n, which reuses the Cholesky factor of 'b cached in 'slot.
+*
+*   This does the same steps zhegv does internally (zpotrf, zhegst,
+*    zheev, ztrsm) so that the results are the same whether or not the
+*    factor came from the cache.
+*
+*   Factors are cached in the same packed form cboris uses: real parts
+*    in the lower triangle (with the diagonal), imaginary parts in the
+*    upper triangle.  'rwork is used to pack them, so it needs to be
+*    at least n*n long.
+*
+*****************************************************************************/
+void cached_zhegv(int slot,char *jobz,int *n,complex *a,complex *b,real *w,
+                  complex *work,int *lwork,real *rwork,int *info)
+{
+  int itype=1;
+  int neig;
+  char uplo='L',trans='C',side='L',diag='N';
+  complex one;
+  int dim,j,k,jtab,ktab;
+  char found;
+
+  if( !overlap_factor_caching || slot < 0 ){
+    zhegv((long *)&itype,jobz,&uplo,(long *)n,a,(long *)n,b,(long *)n,w,work,
+          (long *)lwork,rwork,(long *)info);
+    return;
+  }
+
+  dim = *n;
+  found = 0;
+#ifdef _OPENMP
+#pragma omp critical(overlap_factor_cache)
+#endif
+  {
+    if( fetch_overlap_factor(slot,dim,rwork) ){
+      overlap_factor_hits++;
+      found = 1;
+    }
+  }
+  if( found ){
+    for(j=0;j<dim;j++){
+      jtab = j*dim;
+      for(k=j;k<dim;k++){
+        ktab = k*dim;
+        b[jtab+k].r = rwork[jtab+k];
+        b[jtab+k].i = k==j ? 0.0 : rwork[ktab+j];
+      }
+    }
+  } else{
+    zpotrf(&uplo,(long *)n,b,(long *)n,(long *)info);
+    if( *info != 0 ){
+      *info += *n;
+      return;
+    }
+    for(j=0;j<dim;j++){
+      jtab = j*dim;
+      for(k=j;k<dim;k++){
+        ktab = k*dim;
+        rwork[jtab+k] = b[jtab+k].r;
+        if( k != j ) rwork[ktab+j] = b[jtab+k].i;
+      }
+    }
+#ifdef _OPENMP
+#pragma omp critical(overlap_factor_cache)
+#endif
+    {
+      overlap_factor_misses++;
+      store_overlap_factor(slot,dim,rwork);
+    }
+  }
+
+  zhegst((long *)&itype,&uplo,(long *)n,a,(long *)n,b,(long *)n,(long *)info);
+  zheev(jobz,&uplo,(long *)n,a,(long *)n,w,work,(long *)lwork,rwork,(long *)info);
+  if( *jobz == 'V' || *jobz == 'v' ){
+    neig = *n;
+    if( *info > 0 ) neig = *info - 1;
+    one.r = 1.0;
+    one.i = 0.0;
+    ztrsm(&side,&uplo,&trans,&diag,(long *)n,(long *)&neig,&one,b,(long *)n,a,
+          (long *)n);
+  }
+}
+#endif
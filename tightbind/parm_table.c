@@ -0,0 +1,472 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the tables of atomic parameters.
+*
+*   The parameter file (or the default data in eht_parms.h if it can't
+*    be opened) is read once into a hash table keyed by the first two
+*    characters of the atomic symbol, which is how atoms have always
+*    been matched to the parameter file.  Only the first block of lines
+*    for a given symbol is used.
+*
+*   The table for the current parameter file is kept around (see
+*    shared_parm_table) so that runs which set up more than one
+*    structure don't read the file again each time.  That table must
+*    not be modified by the callers.  The special atoms ('*' atoms)
+*    given in the input file go into a table of their own.
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+#ifndef EHT_PARM_FILE
+#define EHT_PARM_FILE "eht_parms.dat"
+#endif
+
+// Include the default data in case we need it
+#include "eht_parms.h"
+
+/* the first size used for a table, this has to be a power of 2 */
+#define PARM_TABLE_START_SIZE 64
+
+/* the table shared between runs and the file it was read from */
+static parm_table_type *the_shared_table=0;
+static char shared_file_name[MAX_STR_LEN];
+
+
+/****************************************************************************
+*
+*                   Function parm_hash
+*
+* Arguments:  symb: pointer to char
+*       table_size: int
+*
+* Returns: int
+*
+* Action: returns where the search for 'symb starts in a table with
+*   'table_size slots.  Only the first two characters are used.
+*
+*****************************************************************************/
+static int parm_hash(char *symb,int table_size)
+{
+  unsigned int val;
+
+  val = (unsigned char)symb[0];
+  if( symb[0] ) val = val*31 + (unsigned char)symb[1];
+  return (int)(val & (table_size-1));
+}
+
+/****************************************************************************
+*
+*                   Function find_parm_entry
+*
+* Arguments: table: pointer to parm_table_type
+*             symb: pointer to char
+*
+* Returns: pointer to parm_entry_type
+*
+* Action: returns the entry for the (upper case) symbol 'symb in 'table,
+*   or NULL if there isn't one.
+*
+*****************************************************************************/
+parm_entry_type *find_parm_entry(parm_table_type *table,char *symb)
+{
+  int slot;
+
+  if( !table || !table->table_size ) return 0;
+  slot = parm_hash(symb,table->table_size);
+  while( table->entries[slot].symb[0] ){
+    if( !strncmp(table->entries[slot].symb,symb,2) )
+      return &(table->entries[slot]);
+    slot = (slot+1) & (table->table_size-1);
+  }
+  return 0;
+}
+
+/****************************************************************************
+*
+*                   Function add_parm_entry
+*
+* Arguments: table: pointer to parm_table_type
+*             symb: pointer to char
+*
+* Returns: pointer to parm_entry_type
+*
+* Action: returns the entry for 'symb in 'table, adding an empty one
+*   if it isn't already there.  The table is doubled in size when it
+*   gets half full.
+*
+*****************************************************************************/
+parm_entry_type *add_parm_entry(parm_table_type *table,char *symb)
+{
+  parm_entry_type *entry,*old_entries;
+  int old_size,slot,i;
+
+  entry = find_parm_entry(table,symb);
+  if( entry ) return entry;
+
+  if( 2*(table->num_entries+1) > table->table_size ){
+    old_entries = table->entries;
+    old_size = table->table_size;
+    if( old_size ) table->table_size = 2*old_size;
+    else table->table_size = PARM_TABLE_START_SIZE;
+    table->entries = (parm_entry_type *)my_calloc(table->table_size,
+                                                  sizeof(parm_entry_type));
+    if( !table->entries ) fatal("Can't allocate memory for a parameter table.");
+    for(i=0;i<old_size;i++){
+      if( !old_entries[i].symb[0] ) continue;
+      slot = parm_hash(old_entries[i].symb,table->table_size);
+      while( table->entries[slot].symb[0] )
+        slot = (slot+1) & (table->table_size-1);
+      bcopy((char *)&(old_entries[i]),(char *)&(table->entries[slot]),
+            sizeof(parm_entry_type));
+    }
+    if( old_entries ) my_free(old_entries);
+  }
+
+  slot = parm_hash(symb,table->table_size);
+  while( table->entries[slot].symb[0] )
+    slot = (slot+1) & (table->table_size-1);
+  entry = &(table->entries[slot]);
+  entry->symb[0] = symb[0];
+  entry->symb[1] = symb[0] ? symb[1] : 0;
+  entry->symb[2] = 0;
+  table->num_entries++;
+  return entry;
+}
+
+/****************************************************************************
+*
+*                   Procedure read_parm_line
+*
+* Arguments: entry: pointer to parm_entry_type
+*         instring: pointer to char
+*
+* Returns: none
+*
+* Action: puts the orbital described by the line 'instring of the
+*   parameter file into 'entry.
+*
+*****************************************************************************/
+static void read_parm_line(parm_entry_type *entry,char *instring)
+{
+  atom_type *atom;
+  char ang[2],tstring[MAX_STR_LEN];
+  int atnum,nzeta,nquant,nval;
+  real Hii,exp1,exp2,c1,c2;
+  real temp;
+
+  atom = &(entry->parms);
+  sscanf(instring,"%s %d %d %d %d %s %lf %lf %lf %lf %lf",
+         tstring,&atnum,&nval,&nzeta,&nquant,ang,&Hii,&exp1,&exp2,&c1,&c2);
+
+  atom->at_number = atnum;
+  atom->num_valence = nval;
+  /* figure out which type of orbital this is */
+  switch(ang[0]){
+  case 's':
+  case 'S':
+    if( Hii != 0.0 )
+      atom->ns = nquant;
+    else atom->ns = 0;
+
+    atom->exp_s = exp1;
+    atom->coul_s = Hii;
+    entry->orbs_found |= PARM_S;
+    break;
+  case 'p':
+  case 'P':
+    if( Hii != 0.0 )
+      atom->np = nquant;
+    else atom->np = 0;
+    atom->exp_p = exp1;
+    atom->coul_p = Hii;
+    entry->orbs_found |= PARM_P;
+    break;
+  case 'd':
+  case 'D':
+    if( Hii != 0.0 )
+      atom->nd = nquant;
+    else atom->nd = 0;
+    atom->exp_d = exp1;
+    atom->coul_d = Hii;
+    atom->coeff_d1 = c1;
+    entry->orbs_found |= PARM_D;
+    if( nzeta == 2 ){
+      atom->exp_d2 = exp2;
+      atom->coeff_d2 = c2;
+
+      /*******
+        this is some kind of wierd coefficient adjustment business that
+        they do in the original source... I'm not sure why...
+        ******/
+      temp = 4.0*(exp1*exp2/pow(exp1+exp2,2.0));
+      temp = pow(temp,(real)nquant+.5);
+
+      temp = sqrt(c1*c1+c2*c2+2*temp*c1*c2);
+      temp = 1.0/temp;
+
+      atom->coeff_d1 *= temp;
+      atom->coeff_d2 *= temp;
+      entry->orbs_found |= PARM_D2;
+    }
+    break;
+  case 'f':
+  case 'F':
+    if( Hii != 0.0 )
+      atom->nf = nquant;
+    else atom->nf = 0;
+    atom->exp_f = exp1;
+    atom->coul_f = Hii;
+    atom->coeff_f1 = c1;
+    entry->orbs_found |= PARM_F;
+    if( nzeta == 2 ){
+      atom->exp_f2 = exp2;
+      atom->coeff_f2 = c2;
+
+      /*******
+        this is some kind of wierd coefficient adjustment business that
+        they do in the original source... I'm not sure why...
+        ******/
+      temp = 4.0*(exp1*exp2/pow(exp1+exp2,2.0));
+      temp = pow(temp,(real)nquant+.5);
+
+      temp = sqrt(c1*c1+c2*c2+2*temp*c1*c2);
+      temp = 1.0/temp;
+
+      atom->coeff_f1 *= temp;
+      atom->coeff_f2 *= temp;
+      entry->orbs_found |= PARM_F2;
+    }
+    break;
+  }
+}
+
+/****************************************************************************
+*
+*                   Function read_parm_table
+*
+* Arguments: parm_file_name: pointer to char
+*
+* Returns: pointer to parm_table_type
+*
+* Action: reads the parameter file 'parm_file_name into a new table.  If
+*   the file can't be opened the default data in eht_parms.h is used.
+*
+*****************************************************************************/
+parm_table_type *read_parm_table(char *parm_file_name)
+{
+  char err_string[MAX_STR_LEN],instring[MAX_STR_LEN];
+  char tstring[MAX_STR_LEN],last_symb[3];
+  FILE *parmfile;
+  parm_table_type *table;
+  parm_entry_type *entry;
+  int default_parms_ind;
+
+  table = (parm_table_type *)my_calloc(1,sizeof(parm_table_type));
+  if( !table ) fatal("Can't allocate memory for a parameter table.");
+
+  parmfile = fopen(parm_file_name,"r");
+  /* make sure that it opened, but don't exit if not... */
+  if(!parmfile){
+    safe_strcpy(err_string,"Can't open parameter file: ");
+    strncat(err_string,parm_file_name,MAX_STR_LEN-80);
+    strcat(err_string," using default data in eht_parms.h...");
+    error(err_string);
+  }
+
+  entry = 0;
+  last_symb[0] = 0;
+  default_parms_ind = 0;
+  while(1){
+    // If the parm file exists, read from that
+    if( parmfile ){
+      if( skipcomments(parmfile,instring,IGNORE) == -1 ) break;
+    }
+    // Else, read from the default data
+    else{
+      // If the string says "END", then we have reached the end!
+      if( !strcmp(defaultParms[default_parms_ind],"END") ) break;
+      safe_strcpy(instring,(char *)defaultParms[default_parms_ind]);
+      default_parms_ind++;
+    }
+
+    tstring[0] = 0;
+    sscanf(instring,"%s",tstring);
+    upcase(tstring);
+    if( !tstring[0] ) continue;
+
+    /******
+      a new symbol starts a new entry, unless it's already been seen
+      (only the first set of lines for each atom gets used).
+    *******/
+    if( !last_symb[0] || strncmp(last_symb,tstring,2) ){
+      last_symb[0] = tstring[0];
+      last_symb[1] = tstring[1];
+      last_symb[2] = 0;
+      if( find_parm_entry(table,last_symb) ) entry = 0;
+      else entry = add_parm_entry(table,last_symb);
+    }
+    if( entry ) read_parm_line(entry,instring);
+  }
+  if( parmfile ) fclose(parmfile);
+
+  return table;
+}
+
+/****************************************************************************
+*
+*                   Procedure free_parm_table
+*
+* Arguments: table: pointer to parm_table_type
+*
+* Returns: none
+*
+* Action: frees the memory used by 'table (and 'table itself)
+*
+*****************************************************************************/
+void free_parm_table(parm_table_type *table)
+{
+  if( !table ) return;
+  if( table->entries ) my_free(table->entries);
+  my_free(table);
+}
+
+/****************************************************************************
+*
+*                   Function shared_parm_table
+*
+* Arguments: parm_file_name: pointer to char
+*
+* Returns: pointer to parm_table_type
+*
+* Action: returns the table for the parameter file.  This is 'parm_file_name
+*   if that isn't NULL, otherwise the file named by the environment
+*   variable BIND_PARM_FILE, otherwise EHT_PARM_FILE.
+*
+*   The file is only read if it isn't the one the last table was read
+*   from.  The table belongs to this file and is reused, so the caller
+*   must not change or free it.
+*
+*****************************************************************************/
+parm_table_type *shared_parm_table(char *parm_file_name)
+{
+  int old_tag;
+
+  if( !parm_file_name )
+    parm_file_name = (char *)getenv("BIND_PARM_FILE");
+  if( !parm_file_name ) parm_file_name = EHT_PARM_FILE;
+
+  if( the_shared_table && !strcmp(shared_file_name,parm_file_name) )
+    return the_shared_table;
+
+  free_shared_parm_table();
+  old_tag = set_mem_tag(MEM_PERSISTENT);
+  the_shared_table = read_parm_table(parm_file_name);
+  set_mem_tag(old_tag);
+  safe_strcpy(shared_file_name,parm_file_name);
+  return the_shared_table;
+}
+
+/****************************************************************************
+*
+*                   Procedure free_shared_parm_table
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: frees the table returned by shared_parm_table, the next call
+*   to that will read the file again.
+*
+*****************************************************************************/
+void free_shared_parm_table()
+{
+  if( the_shared_table ) free_parm_table(the_shared_table);
+  the_shared_table = 0;
+  shared_file_name[0] = 0;
+}
+
+/****************************************************************************
+*
+*                   Procedure apply_parm_entry
+*
+* Arguments:  atom: pointer to atom_type
+*            entry: pointer to parm_entry_type
+*
+* Returns: none
+*
+* Action: copies the parameters in 'entry into 'atom.  Only the orbitals
+*   which were given for the entry are changed; the rest of 'atom
+*   (including its position) is left alone.
+*
+*****************************************************************************/
+void apply_parm_entry(atom_type *atom,parm_entry_type *entry)
+{
+  atom_type *parms;
+
+  parms = &(entry->parms);
+  atom->at_number = parms->at_number;
+  atom->num_valence = parms->num_valence;
+  if( entry->orbs_found & PARM_S ){
+    atom->ns = parms->ns;
+    atom->exp_s = parms->exp_s;
+    atom->coul_s = parms->coul_s;
+  }
+  if( entry->orbs_found & PARM_P ){
+    atom->np = parms->np;
+    atom->exp_p = parms->exp_p;
+    atom->coul_p = parms->coul_p;
+  }
+  if( entry->orbs_found & PARM_D ){
+    atom->nd = parms->nd;
+    atom->exp_d = parms->exp_d;
+    atom->coul_d = parms->coul_d;
+    atom->coeff_d1 = parms->coeff_d1;
+  }
+  if( entry->orbs_found & PARM_D2 ){
+    atom->exp_d2 = parms->exp_d2;
+    atom->coeff_d2 = parms->coeff_d2;
+  }
+  if( entry->orbs_found & PARM_F ){
+    atom->nf = parms->nf;
+    atom->exp_f = parms->exp_f;
+    atom->coul_f = parms->coul_f;
+    atom->coeff_f1 = parms->coeff_f1;
+  }
+  if( entry->orbs_found & PARM_F2 ){
+    atom->exp_f2 = parms->exp_f2;
+    atom->coeff_f2 = parms->coeff_f2;
+  }
+}
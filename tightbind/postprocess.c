@@ -111,7 +111,6 @@ void postprocess_FMO(cell_type *cell,detail_type *details,hermetian_matrix_type
 
     tform_hermetian_matrix_to_FMO_basis(details,num_orbs,cell->num_atoms,
                                         overlapK,
-                                        work3,details->FMO_props->chg_mat,
                                         details->FMO_props->overlap,
                                         orbital_lookup_table);
 
@@ -132,7 +131,6 @@ void postprocess_FMO(cell_type *cell,detail_type *details,hermetian_matrix_type
     if( details->hamil_PRT ){
       tform_hermetian_matrix_to_FMO_basis(details,num_orbs,cell->num_atoms,
                                           hamilK,
-                                          work3,details->FMO_props->chg_mat,
                                           details->FMO_props->hamil,
                                           orbital_lookup_table);
       fprintf(output_file,
@@ -147,20 +145,31 @@ void postprocess_FMO(cell_type *cell,detail_type *details,hermetian_matrix_type
                1e-4, details->overlap_mat_PRT & PRT_TRANSPOSE_FLAG,details->line_width);
     }
 
-    if( details->OP_mat_PRT || details->ROP_mat_PRT || details->net_chg_PRT
-       || details->vary_zeta ){
+    /*******
+
+      the overlap population matrix in the FMO basis is only needed if
+      it's going to be printed.  If just the reduced matrix is wanted,
+      the elements which go into it are summed up directly.
+
+    ********/
+    if( details->OP_mat_PRT ){
       eval_mulliken(cell,details->FMO_props->eigenset,
                     details->FMO_props->overlap,num_orbs,
                     occupations,orbital_lookup_table,
                     details->FMO_props->OP_mat,
                     work3,work1);
-    }
 
-    /* this stores the reduced overlap population matrix */
-    if( details->ROP_mat_PRT ){
-      FMO_reduced_mulliken(details,cell->num_atoms,num_orbs,
-                           details->FMO_props->OP_mat,
-                           details->FMO_props->ROP_mat);
+      /* this stores the reduced overlap population matrix */
+      if( details->ROP_mat_PRT ){
+        FMO_reduced_mulliken(details,cell->num_atoms,num_orbs,
+                             details->FMO_props->OP_mat,
+                             details->FMO_props->ROP_mat);
+      }
+    }
+    else if( details->ROP_mat_PRT ){
+      FMO_block_mulliken(details,details->FMO_props->eigenset,
+                         details->FMO_props->overlap,num_orbs,
+                         occupations,details->FMO_props->ROP_mat);
     }
     if( details->OP_mat_PRT ){
       fprintf(output_file,
@@ -351,7 +360,6 @@ void postprocess_FCO(cell_type *cell,detail_type *details,hermetian_matrix_type
 
     tform_hermetian_matrix_to_FMO_basis(details,num_orbs,cell->num_atoms,
                                         overlapK,
-                                        work3,details->FMO_props->chg_mat,
                                         details->FMO_props->overlap,
                                         orbital_lookup_table);
 
@@ -372,7 +380,6 @@ void postprocess_FCO(cell_type *cell,detail_type *details,hermetian_matrix_type
     if( details->hamil_PRT ){
       tform_hermetian_matrix_to_FMO_basis(details,num_orbs,cell->num_atoms,
                                           hamilK,
-                                          work3,details->FMO_props->chg_mat,
                                           details->FMO_props->hamil,
                                           orbital_lookup_table);
       fprintf(output_file,
@@ -387,20 +394,31 @@ void postprocess_FCO(cell_type *cell,detail_type *details,hermetian_matrix_type
                1e-4, details->overlap_mat_PRT & PRT_TRANSPOSE_FLAG,details->line_width);
     }
 
-    if( details->OP_mat_PRT || details->ROP_mat_PRT || details->net_chg_PRT
-       || details->vary_zeta ){
+    /*******
+
+      the overlap population matrix in the FMO basis is only needed if
+      it's going to be printed.  If just the reduced matrix is wanted,
+      the elements which go into it are summed up directly.
+
+    ********/
+    if( details->OP_mat_PRT ){
       eval_mulliken(cell,details->FMO_props->eigenset,
                     details->FMO_props->overlap,num_orbs,
                     occupations,orbital_lookup_table,
                     details->FMO_props->OP_mat,
                     work3,work1);
-    }
 
-    /* this stores the reduced overlap population matrix */
-    if( details->ROP_mat_PRT ){
-      FMO_reduced_mulliken(details,cell->num_atoms,num_orbs,
-                           details->FMO_props->OP_mat,
-                           details->FMO_props->ROP_mat);
+      /* this stores the reduced overlap population matrix */
+      if( details->ROP_mat_PRT ){
+        FMO_reduced_mulliken(details,cell->num_atoms,num_orbs,
+                             details->FMO_props->OP_mat,
+                             details->FMO_props->ROP_mat);
+      }
+    }
+    else if( details->ROP_mat_PRT ){
+      FMO_block_mulliken(details,details->FMO_props->eigenset,
+                         details->FMO_props->overlap,num_orbs,
+                         occupations,details->FMO_props->ROP_mat);
     }
     if( details->OP_mat_PRT ){
       fprintf(output_file,
@@ -522,6 +540,7 @@ INCREASE to the right)\n");
                        cell->atoms,cell->num_atoms,orbital_lookup_table,
                        num_orbs,details->wave_fn_PRT & PRT_TRANSPOSE_FLAG,
                        LABEL_COLS,details->line_width);
+    results_write_mat("wavefunctions_real",num_orbs,num_orbs,eigenset.vectR);
 
     /********
 
@@ -536,6 +555,7 @@ INCREASE to the right)\n");
                          cell->atoms,cell->num_atoms,orbital_lookup_table,
                          num_orbs,details->wave_fn_PRT & PRT_TRANSPOSE_FLAG,
                          LABEL_COLS,details->line_width);
+      results_write_mat("wavefunctions_imag",num_orbs,num_orbs,eigenset.vectI);
     }
   }
 
@@ -555,6 +575,8 @@ INCREASE to the right)\n");
   bzero((char *)occupations,num_orbs*sizeof(real));
 
   calc_occupations(details,cell->num_electrons,num_orbs,occupations,eigenset);
+  results_write_mat("energies",1,num_orbs,eigenset.val);
+  results_write_mat("occupations",1,num_orbs,occupations);
 
   if( details->levels_PRT || details->Execution_Mode == MOLECULAR){
     fprintf(output_file,"\n#\t******* Energies (in eV)  and Occupation Numbers *******\n");
@@ -565,6 +587,7 @@ INCREASE to the right)\n");
     }
     fprintf(output_file,"Total_Energy: %8.6lg\n",total_energy);
     properties->total_E = total_energy;
+    results_write_mat("total_energy",1,1,&total_energy);
   }
 
   /******************
@@ -575,6 +598,7 @@ INCREASE to the right)\n");
   if( details->use_symmetry && details->Execution_Mode == MOLECULAR){
     find_MO_symmetries(num_orbs,details,cell,eigenset,overlapK,
                        orbital_lookup_table);
+    print_sym_block_labels(num_orbs);
   }
 
   /******************
@@ -629,6 +653,7 @@ INCREASE to the right)\n");
                        cell->atoms,cell->num_atoms,orbital_lookup_table,
                        num_orbs,details->OP_mat_PRT & PRT_TRANSPOSE_FLAG,LABEL_BOTH,
                        details->line_width);
+    results_write_mat("OP_matrix",num_orbs,num_orbs,properties->OP_mat);
   }
   if( details->ROP_mat_PRT ){
     fprintf(output_file,
@@ -636,6 +661,7 @@ INCREASE to the right)\n");
             cell->num_electrons);
     print_sym_mat(properties->ROP_mat,cell->num_atoms,cell->num_atoms,output_file,(char *)0,
                   (char *)0,details->line_width);
+    results_write_sym_mat("ROP_matrix",cell->num_atoms,properties->ROP_mat);
   }
 
   if( details->net_chg_PRT ){
@@ -648,6 +674,7 @@ INCREASE to the right)\n");
               properties->net_chgs[j]);
     }
     fprintf(output_file,";      Total Charge is: %8.6lf\n",tot_chg);
+    results_write_mat("net_charges",1,cell->num_atoms,properties->net_chgs);
   }
 
 
@@ -663,6 +690,7 @@ INCREASE to the right)\n");
                        cell->atoms,cell->num_atoms,orbital_lookup_table,
                        num_orbs,details->mod_OP_mat_PRT & PRT_TRANSPOSE_FLAG,
                        LABEL_BOTH,details->line_width);
+    results_write_mat("mod_OP_matrix",num_orbs,num_orbs,properties->mod_OP_mat);
   }
   if( details->mod_ROP_mat_PRT ){
     fprintf(output_file,
@@ -670,6 +698,7 @@ INCREASE to the right)\n");
             cell->num_electrons);
     print_sym_mat(properties->mod_ROP_mat,cell->num_atoms,cell->num_atoms,
                   output_file,(char *)0,(char *)0,details->line_width);
+    results_write_sym_mat("mod_ROP_matrix",cell->num_atoms,properties->mod_ROP_mat);
   }
 
   if( details->mod_net_chg_PRT ){
@@ -682,6 +711,7 @@ INCREASE to the right)\n");
               properties->mod_net_chgs[j]);
     }
     fprintf(output_file,";      Total Charge is: %8.6lf\n",tot_chg);
+    results_write_mat("mod_net_charges",1,cell->num_atoms,properties->mod_net_chgs);
   }
 
 
@@ -722,6 +752,7 @@ INCREASE to the right)\n");
                          cell->atoms,cell->num_atoms,orbital_lookup_table,
                          num_orbs,details->chg_mat_PRT & PRT_TRANSPOSE_FLAG,
                          LABEL_COLS,details->line_width);
+      results_write_mat("charge_matrix",num_orbs,num_orbs,properties->chg_mat);
 
     }
     if( details->Rchg_mat_PRT ){
@@ -729,6 +760,8 @@ INCREASE to the right)\n");
               "\n;   Reduced Charge Matrix Independant of Occupation\n");
       printmat(properties->Rchg_mat,cell->num_atoms,num_orbs,output_file,1e-5,
                       (char)0,details->line_width);
+      results_write_mat("reduced_charge_matrix",cell->num_atoms,num_orbs,
+                        properties->Rchg_mat);
     }
 
 
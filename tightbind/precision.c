@@ -0,0 +1,155 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the stuff used to keep matrices in single
+*      precision (the MIXED PRECISION keyword).
+*
+*   Only storage is done in single precision: the values are computed
+*    in double precision, rounded when they're packed away, and turned
+*    back into doubles before anything is done with them.  Every value
+*    that's packed is checked against the double precision one it came
+*    from, and the largest errors are written to the end of the status
+*    file in a block between #PRECISION and #END_PRECISION.
+*
+*   A set of packed matrices which gets summed up (like the S(R)'s
+*    are to make S(k)) is started with begin_packed_set, the sum of
+*    the largest errors in each matrix of the set is a bound on the
+*    error in any element of the sum.
+*
+*****************************************************************************/
+
+#include "bind.h"
+#include <float.h>
+
+/* the error statistics */
+static long num_packed=0;
+static real max_abs_error=0.0,max_rel_error=0.0;
+static real set_error=0.0,max_set_error=0.0;
+
+
+/****************************************************************************
+*
+*                   Procedure begin_packed_set
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: starts a new set of packed matrices.
+*
+*****************************************************************************/
+void begin_packed_set(void)
+{
+  set_error = 0.0;
+}
+
+/****************************************************************************
+*
+*                   Procedure pack_matrix
+*
+* Arguments: dest: pointer to float
+*             src: pointer to real
+*             num: long
+*
+* Returns: none
+*
+* Action: rounds the 'num elements of 'src into 'dest, keeping track of
+*   the errors.  The relative error is only checked for values big
+*   enough to be normal floats.
+*
+*****************************************************************************/
+void pack_matrix(float *dest,real *src,long num)
+{
+  long i;
+  real diff,block_error;
+
+  block_error = 0.0;
+  for(i=0;i<num;i++){
+    dest[i] = (float)src[i];
+    diff = fabs(src[i] - (real)dest[i]);
+    if( diff > block_error ) block_error = diff;
+    /* values too small for a float are flushed, so they don't count here */
+    if( fabs(src[i]) >= FLT_MIN && diff > max_rel_error*fabs(src[i]) ){
+      max_rel_error = diff/fabs(src[i]);
+    }
+  }
+  num_packed += num;
+  if( block_error > max_abs_error ) max_abs_error = block_error;
+  set_error += block_error;
+  if( set_error > max_set_error ) max_set_error = set_error;
+}
+
+/****************************************************************************
+*
+*                   Procedure unpack_matrix
+*
+* Arguments: dest: pointer to real
+*             src: pointer to float
+*             num: long
+*
+* Returns: none
+*
+* Action: copies the 'num elements of 'src back into 'dest
+*
+*****************************************************************************/
+void unpack_matrix(real *dest,float *src,long num)
+{
+  long i;
+
+  for(i=0;i<num;i++) dest[i] = (real)src[i];
+}
+
+/****************************************************************************
+*
+*                   Procedure report_precision_errors
+*
+* Arguments: outfile: pointer to FILE
+*
+* Returns: none
+*
+* Action: writes the number of values that were packed and the largest
+*   errors that introduced to 'outfile.  Nothing is written if no
+*   values were packed.
+*
+*****************************************************************************/
+void report_precision_errors(FILE *outfile)
+{
+  if( !outfile || !num_packed ) return;
+  fprintf(outfile,"#PRECISION\n");
+  fprintf(outfile,"values_packed %ld\n",num_packed);
+  fprintf(outfile,"max_abs_error %g\n",max_abs_error);
+  fprintf(outfile,"max_rel_error %g\n",max_rel_error);
+  fprintf(outfile,"max_sum_error %g\n",max_set_error);
+  fprintf(outfile,"#END_PRECISION\n");
+}
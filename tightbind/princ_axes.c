@@ -145,3 +145,71 @@ void find_princ_axes(atom_type *atoms,point_type *locs,real princ_axes[3][3],rea
 
   /* that's it, return now... */
 }
+
+
+/****************************************************************************
+*
+*                   Procedure build_inertia_tensor
+*
+* Arguments:  atoms:  pointer to atom_type
+*              locs:  pointer to point_type
+*         num_atoms:  integer
+*          symm_tol:  real
+*            tensor:  a 3x3 matrix of reals
+*        tensor_tol:  pointer to real
+*
+* Returns: none
+*
+* Action:  builds the inertia tensor of the atoms at positions 'locs
+*    (dummy atoms don't contribute) and stores it in 'tensor.
+*
+*   'tensor_tol is set to the largest amount any element of the tensor
+*    can change when each atom is moved by up to 'symm_tol along each
+*    of the axes.  This is used to decide whether or not a symmetry
+*    operation maps the tensor onto itself.
+*
+*  As with find_princ_axes, 'locs should be in center of mass coordinates.
+*
+*****************************************************************************/
+void build_inertia_tensor(atom_type *atoms,point_type *locs,int num_atoms,
+                          real symm_tol,real tensor[3][3],real *tensor_tol)
+{
+  int i;
+  real mass,dist,max_shift;
+  real mass_accum,dist_accum;
+
+  bzero(tensor,9*sizeof(real));
+  mass_accum = 0.0;
+  dist_accum = 0.0;
+  for(i=0;i<num_atoms;i++){
+    mass = atoms[i].at_number;
+
+    /* we don't want dummy atoms contributing */
+    if( mass >= 0 ){
+      tensor[0][0] += mass*(locs[i].z*locs[i].z + locs[i].y*locs[i].y);
+      tensor[0][1] -= mass*(locs[i].x*locs[i].y);
+      tensor[0][2] -= mass*(locs[i].x*locs[i].z);
+      tensor[1][1] += mass*(locs[i].z*locs[i].z + locs[i].x*locs[i].x);
+      tensor[1][2] -= mass*(locs[i].y*locs[i].z);
+      tensor[2][2] += mass*(locs[i].y*locs[i].y + locs[i].x*locs[i].x);
+
+      dist = sqrt(locs[i].x*locs[i].x + locs[i].y*locs[i].y +
+                  locs[i].z*locs[i].z);
+      mass_accum += mass;
+      dist_accum += mass*dist;
+    }
+  }
+  tensor[1][0] = tensor[0][1];
+  tensor[2][0] = tensor[0][2];
+  tensor[2][1] = tensor[1][2];
+
+  /******
+    each element is a sum of products of two coordinates, so moving an
+    atom by at most max_shift changes its contribution by less than
+    2*(2*dist*max_shift + max_shift^2).  A little slop is added for
+    round-off.
+  ******/
+  max_shift = sqrt(3.0)*symm_tol;
+  *tensor_tol = 4.0*max_shift*dist_accum + 2.0*max_shift*max_shift*mass_accum;
+  *tensor_tol += 1e-8*(tensor[0][0]+tensor[1][1]+tensor[2][2]);
+}
@@ -102,11 +102,21 @@ extern void full_R_space_Hamiltonian PROTO((cell_type *, detail_type *,
                                             hermetian_matrix_type, int, int *,
                                             char));
 extern void zero_overlaps PROTO((real *, detail_type *, int, int, char, int *));
+extern void R_overlap_pair PROTO((real *, int, cell_type *, int, int, point_type,
+                                  char));
 extern void calc_R_overlap PROTO((real *, cell_type *, detail_type *, int,
                                   point_type, char, int *));
 extern void R_space_overlap_matrix PROTO((cell_type *, detail_type *,
                                           hermetian_matrix_type, int, int,
                                           int *, int));
+extern void invalidate_overlap_cache PROTO(());
+extern real *R_overlap_block PROTO((hermetian_matrix_type, int, int));
+extern void free_R_overlap_block PROTO(());
+extern char overlaps_are_current PROTO((cell_type *, detail_type *, real *));
+extern void mark_overlaps_current PROTO((cell_type *, detail_type *, real *));
+extern void free_overlap_factors PROTO(());
+extern void reset_overlap_factors PROTO((detail_type *));
+extern void report_overlap_factors PROTO(());
 extern int find_atom PROTO((atom_type *, int, int));
 extern void eval_Zmat_locs PROTO((atom_type *, int, int, char));
 extern void calc_avg_occups PROTO((detail_type *, cell_type *, int,
@@ -122,9 +132,12 @@ extern void calc_avg_OP PROTO((detail_type *, cell_type *, int,
                                hermetian_matrix_type, prop_type));
 extern void find_crystal_occupations PROTO((detail_type *, real, int,
                                             K_orb_ptr_type *, real *));
-extern void store_avg_prop_info PROTO((detail_type *, int, eigenset_type,
-                                       hermetian_matrix_type, int, real *,
-                                       avg_prop_info_type *));
+extern int avg_prop_orbital PROTO((detail_type *, cell_type *, int,
+                                   avg_prop_info_type *, int, int, real **,
+                                   real **));
+extern void store_avg_prop_info PROTO((detail_type *, cell_type *, int,
+                                       eigenset_type, hermetian_matrix_type,
+                                       int, real *, avg_prop_info_type *));
 extern int sort_energies_helper PROTO((const void *, const void *));
 extern void sort_avg_prop_info PROTO((detail_type *, int, avg_prop_info_type *,
                                       K_orb_ptr_type *));
@@ -137,7 +150,29 @@ extern void eval_charge_matrix PROTO((cell_type *, eigenset_type,
                                       hermetian_matrix_type, int, int *, real *,
                                       real *));
 extern void reduced_charge_mat PROTO((int, int, int *, real *, real *));
-extern void check_a_cell PROTO((atom_type *, point_type, int, real, char *));
+extern real atom_distance PROTO((cell_type *, int, int));
+extern void check_a_cell PROTO((cell_type *, neighbor_list_type *, point_type,
+                                real, char *));
+extern void free_neighbor_list PROTO((cell_type *));
+extern neighbor_list_type *get_neighbor_list PROTO((cell_type *, real));
+extern int find_neighbor_image PROTO((neighbor_list_type *, point_type));
+extern void timers_off PROTO(());
+extern void reset_timers PROTO(());
+extern void timer_start PROTO((char *));
+extern void timer_stop PROTO((char *));
+extern void timer_add_bytes PROTO((double));
+extern void timer_add_flops PROTO((double));
+extern void report_timers PROTO((FILE *));
+extern double eigensolver_flops PROTO((int, char));
+extern void *arena_calloc PROTO((arena_type *, long, long));
+extern void arena_reset PROTO((arena_type *));
+extern arena_mark_type arena_mark PROTO((arena_type *));
+extern void arena_release PROTO((arena_type *, arena_mark_type));
+extern void arena_free PROTO((arena_type *));
+extern void begin_packed_set PROTO(());
+extern void pack_matrix PROTO((float *, real *, long));
+extern void unpack_matrix PROTO((real *, float *, long));
+extern void report_precision_errors PROTO((FILE *));
 extern void check_nn_contacts PROTO((cell_type *, detail_type *details));
 extern void build_distance_matrix PROTO((cell_type *, detail_type *details));
 extern void dump_distance_mats PROTO((cell_type *, detail_type *details));
@@ -150,10 +185,48 @@ extern void AO_occupations PROTO((cell_type *, int, real *, int *, real *));
 extern void eval_electrostatics PROTO((cell_type *, int, eigenset_type, real *,
                                        real *, int *, real *, real *, real *,
                                        real *, real *));
+extern void electrostatic_gradients PROTO((cell_type *, int, int *, real *,
+                                           point_type *));
+extern void eval_gradients PROTO((cell_type *, detail_type *, int, eigenset_type,
+                                  real *, int *, point_type *));
+extern void report_forces PROTO((cell_type *, point_type *));
+extern void optimize_geometry
+    PROTO((cell_type *, detail_type *, hermetian_matrix_type,
+           hermetian_matrix_type, complex *, complex *, eigenset_type, real *,
+           real *, real *, complex *, prop_type *, int, int, int *));
 extern void read_geom_frag PROTO((FILE *, geom_frag_type *));
 extern void write_atom_parms PROTO((detail_type *, atom_type *, int, char));
 extern void write_atom_coords PROTO((atom_type *, int, char, char));
 extern void fill_atomic_parms PROTO((atom_type *, int, FILE *, char *));
+extern parm_entry_type *find_parm_entry PROTO((parm_table_type *, char *));
+extern parm_entry_type *add_parm_entry PROTO((parm_table_type *, char *));
+extern parm_table_type *read_parm_table PROTO((char *));
+extern void free_parm_table PROTO((parm_table_type *));
+extern parm_table_type *shared_parm_table PROTO((char *));
+extern void free_shared_parm_table PROTO(());
+extern char checkpoint_init PROTO((char *));
+extern FILE *checkpoint_fopen PROTO((char *, int));
+extern void checkpoint_setup PROTO((detail_type *, cell_type *, int));
+extern char checkpoint_skip_walsh_step PROTO((cell_type *, int));
+extern void checkpoint_restore_cycle PROTO((cell_type *));
+extern char checkpoint_restore_kpoint PROTO((detail_type *, int, int,
+                                             avg_prop_info_type *));
+extern void checkpoint_write PROTO((detail_type *, cell_type *, int, int, int,
+                                    avg_prop_info_type *));
+extern void checkpoint_kpoint_done PROTO((detail_type *, cell_type *, int, int,
+                                          avg_prop_info_type *));
+extern void checkpoint_finish PROTO(());
+extern char checkpoint_pending PROTO(());
+extern char result_cache_fetch PROTO((cell_type *, detail_type *, int, int,
+                                      hermetian_matrix_type, hermetian_matrix_type,
+                                      hermetian_matrix_type, avg_prop_info_type *));
+extern void result_cache_keep_energies PROTO((int, int, eigenset_type));
+extern void result_cache_store PROTO((cell_type *, detail_type *, int, int,
+                                      hermetian_matrix_type, hermetian_matrix_type,
+                                      hermetian_matrix_type, avg_prop_info_type *));
+extern void report_result_cache PROTO((FILE *));
+extern void run_worker PROTO((char *));
+extern void apply_parm_entry PROTO((atom_type *, parm_entry_type *));
 extern void parse_printing_options PROTO((FILE *, detail_type *, cell_type *));
 extern void read_inputfile PROTO((cell_type *, detail_type *, char *, int *,
                                   int **, FILE *, char *));
@@ -167,6 +240,7 @@ extern void center_text_string PROTO((char *src, char *dest, int dest_len));
 extern void left_just_text_string PROTO((char *src, char *dest, int dest_len));
 extern void map_orb_num_to_name PROTO((char *, int, int *, int, atom_type *,
                                        int));
+extern int sprint_fixed PROTO((char *, double, int, int, char));
 extern void debugmat PROTO((real *, int, int, real));
 extern void printmat PROTO((real *, int, int, FILE *, real, char, int));
 extern void print_labelled_mat PROTO((real *, int, int, FILE *, real,
@@ -190,6 +264,11 @@ extern void loop_over_k_points
            hermetian_matrix_type, hermetian_matrix_type, hermetian_matrix_type,
            complex *, complex *, eigenset_type, real *, real *, real *,
            complex *, prop_type *, avg_prop_info_type *, int, int *));
+extern void diagonalize_k_matrices
+    PROTO((detail_type *, int, int, hermetian_matrix_type, hermetian_matrix_type,
+           complex *, complex *, eigenset_type, real *, real *, real *,
+           complex *, int *));
+extern void print_kpoint_label PROTO((int, k_point_type *));
 
 extern void sparsify_hermetian_matrix PROTO((real, hermetian_matrix_type, int));
 extern void sparsify_matrix PROTO((real, real *, real *, int));
@@ -202,11 +281,20 @@ extern void allocate_matrices
 extern void cleanup_memory PROTO(());
 extern void mov PROTO((real *, real *, real *, real *, int, int, real, int, int,
                        int, int, atom_type *));
+extern void mov_derivative PROTO((real *, real *, real *, real *, int, int, real,
+                                  int, int, int, int, atom_type *));
+extern void sto_ab_functions PROTO((int, real *, real *, int, real *, real *));
+extern void sto_radial_overlaps PROTO((real *, int, real *, real *, real *, int,
+                                       int, int, int, char));
+extern int find_HOMO_degeneracy PROTO((real, int, real *, int *));
 extern void calc_occupations PROTO((detail_type *, real, int, real *,
                                     eigenset_type));
 extern void reduced_mulliken PROTO((int, int, int *, real *, real *));
 extern void FMO_reduced_mulliken PROTO((detail_type *, int, int, real *,
                                         real *));
+extern void FMO_block_mulliken PROTO((detail_type *, eigenset_type,
+                                      hermetian_matrix_type, int, real *,
+                                      real *));
 extern void eval_mulliken PROTO((cell_type *, eigenset_type,
                                  hermetian_matrix_type, int, real *, int *,
                                  real *, real *, real *));
@@ -216,6 +304,8 @@ extern void modified_mulliken PROTO((cell_type *, eigenset_type,
 extern void read_NEW3file PROTO((cell_type *, detail_type *, FILE *, char *));
 extern void find_princ_axes PROTO((atom_type *, point_type *, real[3][3],
                                    real[3], int));
+extern void build_inertia_tensor PROTO((atom_type *, point_type *, int, real,
+                                        real[3][3], real *));
 
 extern void vector_diff PROTO((point_type *, point_type *, point_type *));
 extern void normalize_vector PROTO((point_type *, point_type *));
@@ -228,30 +318,37 @@ extern void walsh_update PROTO((cell_type *, detail_type *, int, char));
 extern void walsh_output PROTO((detail_type *, cell_type *, int, eigenset_type,
                                 hermetian_matrix_type, hermetian_matrix_type,
                                 prop_type, int *, int));
+extern void xtal_coord_tform PROTO((cell_type *, real[3][3],
+                                    real *));
 extern void eval_xtal_coord_locs PROTO((cell_type *, char));
 extern void update_zetas PROTO((cell_type *, real *, real, int *, char));
+extern void get_zeta_state PROTO((int *, real **));
+extern void set_zeta_state PROTO((int, real *, int));
 extern void init_FMO_file PROTO((detail_type *, int, real));
 extern void build_FMO_overlap PROTO((detail_type *, int, int,
                                      hermetian_matrix_type, int *));
 extern void build_FMO_hamil PROTO((detail_type *, int, int,
                                    hermetian_matrix_type, int *));
-extern void diagonalize_FMO PROTO((detail_type *, real *, real *, real *,
+extern void diagonalize_FMO PROTO((detail_type *, int, real *, real *, real *,
                                    complex *, complex *, complex *));
 extern void gen_FMO_tform_matrices PROTO((detail_type *));
 extern void tform_wavefuncs_to_FMO_basis PROTO((detail_type *, int, int,
                                                 eigenset_type, int *));
 extern void tform_matrix_to_FMO_basis PROTO((detail_type *, int, int, real *,
-                                             real *, real *, real *,
-                                             complex_matrix_type, int *));
+                                             real *, complex_matrix_type,
+                                             int *));
 extern void tform_hermetian_matrix_to_FMO_basis
-    PROTO((detail_type *, int, int, hermetian_matrix_type, real *, real *,
+    PROTO((detail_type *, int, int, hermetian_matrix_type,
            hermetian_matrix_type, int *));
 
 extern void charge_to_num_electrons PROTO((cell_type *));
 extern void update_chg_it_parms PROTO((detail_type *, cell_type *, real *,
                                        int *, int, int *));
+extern void get_chg_it_state PROTO((int *, real **, int *));
+extern void set_chg_it_state PROTO((int, real *, int));
 extern void fill_chg_it_parms PROTO((atom_type *, int, int, FILE *));
 extern void parse_charge_iteration PROTO((FILE *, detail_type *, cell_type *));
+extern void parse_geom_opt PROTO((FILE *, detail_type *));
 extern void update_muller_it_parms PROTO((detail_type *, cell_type *, real *,
                                           int *, int, int *));
 extern void calc_muller_init_parms PROTO((atom_type *));
@@ -274,6 +371,10 @@ extern void lovlap PROTO((real *, real *, real *, real *, real *, real *, int *,
                           int *, int *, int *, int *, int *));
 extern void cboris PROTO((int *, int *, real *, real *, real *, real *, real *,
                           real *, int *));
+extern void cboris_factored PROTO((int *, int *, real *, real *, real *, real *,
+                                   real *, real *, int *));
+extern void cached_cboris PROTO((int, int *, real *, real *, real *, real *,
+                                 real *, real *, int *));
 
 #ifndef SYM_OPS_DEFINED
 #include "symmetry.h"
@@ -294,6 +395,12 @@ extern void compare_molecules PROTO((atom_type *, point_type *, point_type *,
 extern void transform_p_orbs PROTO((real *, real[T_MAT_DIM][T_MAT_DIM]));
 extern void transform_d_orbs PROTO((real *, real[D_T_MAT_DIM][D_T_MAT_DIM]));
 extern void transform_orbitals PROTO((atom_type *, real *, sym_op_type *));
+extern char sym_block_diagonalize PROTO((detail_type *, cell_type *, int, int *,
+                                        hermetian_matrix_type,
+                                        hermetian_matrix_type, eigenset_type,
+                                        int *));
+extern void print_sym_block_labels PROTO((int));
+extern void free_sym_blocks PROTO(());
 extern void full_transform PROTO((atom_type *, point_type, real[3][3], int));
 extern void transform_atoms PROTO((atom_type *, real[T_MAT_DIM][T_MAT_DIM],
                                    int));
@@ -331,22 +438,16 @@ extern void compare_crystal_basis PROTO((cell_type *, point_type *,
                                          char *, real));
 extern void compare_crystal_lattice PROTO((cell_type *, point_type *,
                                            point_type *, char *, real, real *));
-extern void reduce_kpoints PROTO((detail_type * details, cell_type *cell,
-                                  point_type *raw_points, int num_raw_points,
-                                  real *multiplicity, int *num_points,
-                                  int orthogonal_axes));
-
 extern int check_for_orthogonal_basis PROTO((point_type vects[3], int dim,
                                              real tol));
 extern int atoms_are_equiv PROTO((cell_type * cell, point_type *loc1,
                                   point_type *loc2, int *which_cell,
                                   real symm_tol, point_type *));
+extern int star_needs_unfolding PROTO((k_point_type *));
+extern void unfold_star_orbital PROTO((cell_type *, int, k_point_type *,
+                                       real *, real *, real *, real *, char));
 
 extern void calc_reciprocal_lattice PROTO((cell_type * cell));
-extern void gen_k_point_mesh PROTO((point_type * *points, int num_per_vect[3],
-                                    int *num_generated,
-                                    char include_high_symm_p, int dim,
-                                    real offset));
 extern void automagic_k_points PROTO((detail_type * details, cell_type *cell));
 
 extern void set_details_defaults PROTO((detail_type *));
@@ -357,6 +458,35 @@ extern void run_eht PROTO((FILE *));
 extern int *my_malloc PROTO((long));
 extern int *my_calloc PROTO((int, int));
 extern int *my_realloc PROTO((int *, int));
+extern void my_free PROTO((void *));
+extern int set_mem_tag PROTO((int));
+extern void retag_memory PROTO((void *, int));
+extern void set_memory_budget PROTO((real));
+extern int memory_fits PROTO((long));
+extern long memory_in_use PROTO(());
+extern void report_memory_usage PROTO((FILE *));
+extern void extended_matrix_sizes PROTO((detail_type *, int, int, int, char,
+                                         long *, long *, long *, long *));
+
+extern void results_write PROTO((char *, int, int, int, int, int, int, void *));
+extern void results_write_mat PROTO((char *, int, int, real *));
+extern void results_write_sym_mat PROTO((char *, int, real *));
+extern void results_write_hermetian_mat PROTO((char *, int, real *));
+extern void results_begin_table PROTO((char *, int, int));
+extern void results_table_value PROTO((real));
+extern void results_end_table PROTO(());
+extern void results_set_kpoint PROTO((int));
+extern void results_begin_step PROTO((cell_type *, int));
+extern void results_open_file PROTO((detail_type *, cell_type *, int, char *));
+extern void results_close_file PROTO(());
+extern void results_start_capture PROTO(());
+extern results_list_type *results_end_capture PROTO(());
+extern results_list_type *results_find PROTO((results_list_type *, char *, int, int));
+extern void results_free_list PROTO((results_list_type *));
+extern matrix_dump_type *open_matrix_dump PROTO((detail_type *, char *, int,
+                                                 int, int));
+extern void write_matrix_dump PROTO((matrix_dump_type *, int, real *));
+extern void close_matrix_dump PROTO((matrix_dump_type *));
 
 #ifdef INCLUDE_NETCDF_SUPPORT
 extern void netCDF_handle_error PROTO((int));
@@ -380,4 +510,19 @@ extern int zhegv_ PROTO((integer * itype, char *jobz, char *uplo, integer *n,
 extern int zheev_ PROTO((char *jobz, char *uplo, integer *n, doublecomplex *a,
                          integer *lda, doublereal *w, doublecomplex *work,
                          integer *lwork, doublereal *rwork, integer *info));
+extern int zpotrf_ PROTO((char *uplo, integer *n, doublecomplex *a, integer *lda,
+                          integer *info));
+extern int zhegst_ PROTO((integer * itype, char *uplo, integer *n,
+                          doublecomplex *a, integer *lda, doublecomplex *b,
+                          integer *ldb, integer *info));
+extern int ztrsm_ PROTO((char *side, char *uplo, char *transa, char *diag,
+                         integer *m, integer *n, doublecomplex *alpha,
+                         doublecomplex *a, integer *lda, doublecomplex *b,
+                         integer *ldb));
+extern int zgemm_ PROTO((char *transa, char *transb, integer *m, integer *n,
+                         integer *k, doublecomplex *alpha, doublecomplex *a,
+                         integer *lda, doublecomplex *b, integer *ldb,
+                         doublecomplex *beta, doublecomplex *c, integer *ldc));
+extern void cached_zhegv PROTO((int, char *, int *, complex *, complex *,
+                                real *, complex *, int *, real *, int *));
 #endif
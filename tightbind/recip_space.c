@@ -83,9 +83,9 @@ void calc_reciprocal_lattice(cell_type *cell)
       cell->atoms[cell->tvects[i].begin].loc.z;
   }
 
-  /* for one dimensional systems, there is nothing to do */
+  /* for one dimensional systems, b0 = a0 / |a0|^2 */
   if(cell->dim == 1 ){
-    V = sqrt(dot_prod(&tvects[0],&tvects[0]));
+    V = dot_prod(&tvects[0],&tvects[0]);
     cell->recip_vects[0].x = tvects[0].x / V;
     cell->recip_vects[0].y = tvects[0].y / V;
     cell->recip_vects[0].z = tvects[0].z / V;
@@ -143,150 +143,172 @@ void calc_reciprocal_lattice(cell_type *cell)
 
 /****************************************************************************
 *
-*                   Procedure gen_k_point_mesh
+*  The automatic k point meshes are handled in integer coordinates.
+*   Along reciprocal lattice vector i there are n[i] points with
+*   coordinates  u = 2r + c[i]  (r = 0..n[i]-1), the fractional
+*   coordinate of the point being u/(2n[i]).  c[i] is 0 for a mesh
+*   which includes the zone center and edges (high symmetry points)
+*   and 1-n[i] for a Monkhorst-Pack style mesh, which is symmetric
+*   about the zone center.
 *
-* Arguments:  points: pointer to pointer to point_type
-*            num_per_vect: int[3]
-*            num_generated: pointer to int
-*            include_high_symm_p: char
-*             dim: int
-*            offset: real
+*  Adding 2n[i] to u is a reciprocal lattice translation, so each
+*   mesh point has a unique r, and the r's give every point a slot in
+*   a table (this is a perfect hash of the mesh).
 *
-* Returns: none
+*****************************************************************************/
+
+/* a symmetry operation in the reciprocal lattice basis */
+typedef struct {
+  int mat[3][3];
+  sym_op_type *op;
+} mesh_op_type;
+
+/****************************************************************************
 *
-* Action:
-*    generates a 'dim dimensional mesh of k points with 'num_per_vect along
-*    each direction.
-*    if 'include_high_symm_p is nonzero, the zone edges and center
-*     will be included, otherwise the points are offset from the
-*     edges and center by 'offset.
-*    the k points are generated in fractional coordinates in reciprocal
-*      space.
+*                   Procedure mesh_slot
+*
+* Arguments:   u: int[3]
+*              n: int[3]
+*              c: int[3]
+*
+* Returns: int
+*
+* Action: returns the table slot of the mesh point with integer
+*   coordinates 'u, or -1 if 'u is not on the mesh.
 *
 *****************************************************************************/
-void gen_k_point_mesh(point_type **points,int num_per_vect[3],
-                      int *num_generated, char include_high_symm_p,int dim,
-                      real offset)
+static int mesh_slot(int u[3],int n[3],int c[3])
 {
-  int i,j,k;
-  int num_p;
-  real step[3];
-  point_type loc,origin;
-  point_type *p_array;
-  int num_so_far;
-
-  if(dim < 1) return;
-
-  /* figure out the number of points to be generated and allocate space */
-  num_p = 2 * num_per_vect[0];
-  if( dim > 1 ){
-    num_p *= 2*num_per_vect[1];
-  }else{
-    num_per_vect[1] = num_per_vect[2] = 0;
+  int i,r,slot;
+
+  slot = 0;
+  for(i=0;i<3;i++){
+    if( (u[i]-c[i]) % 2 ) return -1;
+    r = ((u[i]-c[i])/2) % n[i];
+    if( r < 0 ) r += n[i];
+    slot = slot*n[i] + r;
   }
-  if( dim > 2 ){
-    num_p *= 2*num_per_vect[2];
-  }else{
-    num_per_vect[2] = 0;
-  }
-  p_array = (point_type *)my_calloc(num_p,sizeof(point_type));
-  if(!p_array) fatal("can't allocate p_array");
+  return slot;
+}
+
+/****************************************************************************
+*
+*                   Procedure mesh_coords
+*
+* Arguments: slot: int
+*              u: int[3]
+*              n: int[3]
+*              c: int[3]
+*
+* Returns: none
+*
+* Action: the inverse of mesh_slot.  The coordinates are folded
+*   into (-n,n], i.e. the fractional coordinates are in (-1/2,1/2].
+*
+*****************************************************************************/
+static void mesh_coords(int slot,int u[3],int n[3],int c[3])
+{
+  int i;
 
-  /* figure out the spacing between points */
-  for(i=0;i<dim;i++){
-    if( include_high_symm_p ) step[i] = 0.5 / (real)(num_per_vect[i]-1);
-    else step[i] = (0.5 - 2.0*offset) /  (real)(num_per_vect[i]-1);
+  for(i=2;i>=0;i--){
+    u[i] = 2*(slot % n[i]) + c[i];
+    slot /= n[i];
+    while( u[i] > n[i] ) u[i] -= 2*n[i];
+    while( u[i] <= -n[i] ) u[i] += 2*n[i];
   }
+}
 
-  if( include_high_symm_p ) offset = 0;
+/****************************************************************************
+*
+*                   Function apply_mesh_op
+*
+* Arguments: mesh_op: pointer to mesh_op_type
+*                  u: int[3]
+*                  n: int[3]
+*              new_u: int[3]
+*
+* Returns: int
+*
+* Action: puts the image of the mesh point 'u under 'mesh_op in 'new_u.
+*
+*   'mesh_op acts on fractional coordinates, which are u[i]/(2n[i]),
+*    so in mesh coordinates it's new_u[i] = sum_j mat[i][j]*(n[i]/n[j])*u[j].
+*    When the mesh isn't the same along every axis that needn't be an
+*    integer; 0 is returned if it isn't (the image is off the mesh).
+*
+*****************************************************************************/
+static int apply_mesh_op(mesh_op_type *mesh_op,int u[3],int n[3],int new_u[3])
+{
+  int i,j;
+  long num,den;
 
-  /*********
+  den = (long)n[0]*n[1]*n[2];
+  for(i=0;i<3;i++){
+    num = 0;
+    for(j=0;j<3;j++){
+      num += (long)mesh_op->mat[i][j]*n[i]*u[j]*(den/n[j]);
+    }
+    if( num % den ) return 0;
+    new_u[i] = (int)(num/den);
+  }
+  return 1;
+}
 
-    now generate the points themselves
-
-    because of the simple-minded generation algorithm, there are
-    going to be duplicate points generated if we are using the high
-    symmetry points.  Since duplicates will be removed later, however,
-    this doesn't cause problems.
-
-    in order to get multiplicities right later, it's going to
-    be important to generate *all* the points, even though we
-    are absolutely guaranteed not to need k and -k.
-
-    because we set num_per_vect to 0 for directions beyond the
-    dimensionality of the crystal above, we can just loop like this
-    is a three dimensional crystal here.
-
-  **********/
-  num_so_far = 0;
-  for(i=0;i<num_per_vect[0];i++){
-    for(j=0;j<num_per_vect[1];j++){
-      for(k=0;k<num_per_vect[2];k++){
-        p_array[num_so_far].x = offset + (real)i*step[0];
-        p_array[num_so_far].y = offset + (real)j*step[1];
-        p_array[num_so_far].z = offset + (real)k*step[2];
-        num_so_far++;
-        p_array[num_so_far].x = (offset + (real)i*step[0]);
-        p_array[num_so_far].y = (offset + (real)j*step[1]);
-        p_array[num_so_far].z = -(offset + (real)k*step[2]);
-        num_so_far++;
-        p_array[num_so_far].x = (offset + (real)i*step[0]);
-        p_array[num_so_far].y = -(offset + (real)j*step[1]);
-        p_array[num_so_far].z = -(offset + (real)k*step[2]);
-        num_so_far++;
-        p_array[num_so_far].x = (offset + (real)i*step[0]);
-        p_array[num_so_far].y = -(offset + (real)j*step[1]);
-        p_array[num_so_far].z = offset + (real)k*step[2];
-        num_so_far++;
-
-        p_array[num_so_far].x = -(offset + (real)i*step[0]);
-        p_array[num_so_far].y = -(offset + (real)j*step[1]);
-        p_array[num_so_far].z = -(offset + (real)k*step[2]);
-        num_so_far++;
-        p_array[num_so_far].x = -(offset + (real)i*step[0]);
-        p_array[num_so_far].y = -(offset + (real)j*step[1]);
-        p_array[num_so_far].z = (offset + (real)k*step[2]);
-        num_so_far++;
-        p_array[num_so_far].x = -(offset + (real)i*step[0]);
-        p_array[num_so_far].y = (offset + (real)j*step[1]);
-        p_array[num_so_far].z = (offset + (real)k*step[2]);
-        num_so_far++;
-        p_array[num_so_far].x = -(offset + (real)i*step[0]);
-        p_array[num_so_far].y = (offset + (real)j*step[1]);
-        p_array[num_so_far].z = -(offset + (real)k*step[2]);
-        num_so_far++;
+/****************************************************************************
+*
+*                   Procedure mesh_op_from_sym_op
+*
+* Arguments:   cell: pointer to cell_type
+*            direct: point_type[3]
+*             recip: point_type[3]
+*                op: pointer to sym_op_type
+*               tol: real
+*          mesh_op: pointer to mesh_op_type
+*
+* Returns: int
+*
+* Action: expresses the (cartesian) symmetry operation 'op in the
+*   basis of the reciprocal lattice vectors 'recip.  Element (i,j) is
+*   'direct[i] . (R 'recip[j]).
+*
+*   Returns 0 if the operation doesn't map the reciprocal lattice
+*   onto itself.
+*
+*****************************************************************************/
+static int mesh_op_from_sym_op(cell_type *cell,point_type direct[3],point_type recip[3],
+                               sym_op_type *op,real tol,mesh_op_type *mesh_op)
+{
+  int i,j;
+  real val;
+  point_type rotated,check;
 
-      }
-                        if(dim == 2){
-      p_array[num_so_far].x = (offset + (real)i*step[0]);
-      p_array[num_so_far].y = (offset + (real)j*step[1]);
-      num_so_far++;
-      p_array[num_so_far].x = (offset + (real)i*step[0]);
-      p_array[num_so_far].y = -(offset + (real)j*step[1]);
-      num_so_far++;
-
-      p_array[num_so_far].x = -(offset + (real)i*step[0]);
-      p_array[num_so_far].y = -(offset + (real)j*step[1]);
-      num_so_far++;
-      p_array[num_so_far].x = -(offset + (real)i*step[0]);
-      p_array[num_so_far].y = (offset + (real)j*step[1]);
-      num_so_far++;
-      }
+  for(i=0;i<3;i++){
+    for(j=0;j<3;j++){
+      mesh_op->mat[i][j] = (i==j);
     }
-          if( dim == 1 ){
-    p_array[num_so_far].x = (offset + (real)i*step[0]);
-    num_so_far++;
-
-    p_array[num_so_far].x = -(offset + (real)i*step[0]);
-    num_so_far++;
+  }
+  mesh_op->op = op;
+
+  for(j=0;j<cell->dim;j++){
+    rotated = recip[j];
+    transform_one_point(&rotated,op->t_mat);
+    check.x = check.y = check.z = 0.0;
+    for(i=0;i<cell->dim;i++){
+      val = dot_prod(&(direct[i]),&rotated);
+      mesh_op->mat[i][j] = (int)floor(val+0.5);
+      if( fabs(val-mesh_op->mat[i][j]) > tol ) return 0;
+      check.x += mesh_op->mat[i][j]*recip[i].x;
+      check.y += mesh_op->mat[i][j]*recip[i].y;
+      check.z += mesh_op->mat[i][j]*recip[i].z;
+    }
+    /* make sure nothing was rotated out of the reciprocal lattice */
+    if( !POINTS_ARE_THE_SAME(&check,&rotated,tol*sqrt(dot_prod(&(recip[j]),&(recip[j])))) ){
+      return 0;
     }
   }
-
-        *points = p_array;
-  *num_generated = num_so_far;
+  return 1;
 }
 
-
 /****************************************************************************
 *
 *                   Procedure automagic_k_points
@@ -299,120 +321,204 @@ void gen_k_point_mesh(point_type **points,int num_per_vect[3],
 * Action:
 *   Automagically generates a k-points set for 'cell
 *
+*   The mesh (see the notes above) is split into orbits (stars) under the
+*   symmetry operations in sym_ops_present and time reversal (k -> -k).
+*   The irreducible point of each orbit is the member with the lowest
+*   table slot and its weight is the size of the orbit.
+*
+*   The star of each irreducible point is stored in it, along with
+*   how each member was generated.
+*
 *****************************************************************************/
 void automagic_k_points(detail_type *details,cell_type *cell)
 {
-  int i,j;
-  point_type *raw_points;
-  real *degen_p;
-  int num_raw_points,num_points;
-  real tot_weight;
-  int nonorthogonal_lattice;
-        int num_duplicates;
-
-  /* start by generating a reducible mesh */
-  gen_k_point_mesh(&raw_points,details->points_per_axis,&num_raw_points,
-                   details->use_high_symm_p,cell->dim,details->k_offset);
-
-  /* okay, now we need to generate the reciprocal lattice */
+  int i,j,k;
+  int n[3],c[3],u[3],new_u[3];
+  int num_mesh,slot,new_slot;
+  int num_ops,num_unusable;
+  char use_spatial_ops;
+  int num_points,head,tail;
+  int *orbit,*queue,*from;
+  mesh_op_type *mesh_ops;
+  sym_op_type *op;
+  point_type direct[3],recip[3];
+  k_point_type *points;
+  k_star_type *star;
+
+  if( cell->dim < 1 ) return;
+
+  /* the direct and reciprocal lattice vectors */
   calc_reciprocal_lattice(cell);
+  for(i=0;i<cell->dim;i++){
+    direct[i].x = cell->atoms[cell->tvects[i].end].loc.x -
+      cell->atoms[cell->tvects[i].begin].loc.x;
+    direct[i].y = cell->atoms[cell->tvects[i].end].loc.y -
+      cell->atoms[cell->tvects[i].begin].loc.y;
+    direct[i].z = cell->atoms[cell->tvects[i].end].loc.z -
+      cell->atoms[cell->tvects[i].begin].loc.z;
+    recip[i] = cell->recip_vects[i];
+  }
 
-  /********
-
-    that's in hand, now we can reduce the k_point set
-      start with the easy ones: removing identical points,
-      then move on to using symmetry to reduce the set.
-
-  *********/
-  degen_p = (real *)my_calloc(num_raw_points,sizeof(real));
-  if(!degen_p)fatal("can't allocate degen_p array.");
-          num_duplicates = 0;
-  for(i=0;i<num_raw_points;i++){
-    if( degen_p[i] == 0 ){
-      for(j=i+1;j<num_raw_points;j++){
-        if( POINTS_ARE_THE_SAME(&raw_points[i],&raw_points[j],
-                                details->symm_tol) ){
-          degen_p[j] = -1;
-          num_duplicates++;
-        }
-      }
-    }
+  /* the mesh */
+  num_mesh = 1;
+  for(i=0;i<3;i++){
+    if( i < cell->dim && details->points_per_axis[i] > 0 ){
+      n[i] = details->points_per_axis[i];
+    } else n[i] = 1;
+    if( details->use_high_symm_p ) c[i] = 0;
+    else c[i] = 1-n[i];
+    num_mesh *= n[i];
   }
 
-#ifdef DEBUG_SYMM
-  printf("Here's the reducible k-point mesh (%d duplicates removed) for (%d %d %d) points per axis,\n",
-         num_duplicates,details->points_per_axis[0],details->points_per_axis[1],
-         details->points_per_axis[2]);
-  printf("and an offset of %lf\n",details->k_offset);
-  for(i=0;i<num_raw_points;i++){
-    if( degen_p[i] == 0 ){
-      printf("% 6.4lf % 6.4lf % 6.4lf\n",raw_points[i].x,raw_points[i].y,
-             raw_points[i].z);
-    }
+  /*******
+
+    figure out which symmetry operations can be used:  they have to
+    map the reciprocal lattice, and the mesh, onto themselves.
+    the last operation is time reversal.
+
+  *******/
+  num_ops = 0;
+  for(op=sym_ops_present;op;op=op->next) num_ops++;
+  mesh_ops = (mesh_op_type *)my_calloc(num_ops+1,sizeof(mesh_op_type));
+  orbit = (int *)my_calloc(num_mesh,sizeof(int));
+  queue = (int *)my_calloc(num_mesh,sizeof(int));
+  from = (int *)my_calloc(num_mesh,sizeof(int));
+  if( !mesh_ops || !orbit || !queue || !from ){
+    fatal("Can't allocate memory in automagic_k_points.");
   }
-#endif
 
   /*******
 
-    if the reciprocal lattice is not orthogonal, removing symmetry
-    equivalent k-points requires a lot more smarts that the program
-    currently has, so check for this, warn the user, and
-    go with half the Brillouin zone.
+    the properties of the points in each star are generated from the
+    irreducible point by transforming the orbitals, this can't be done
+    for f orbitals or fragment orbitals, so in those cases only time
+    reversal is used.
 
   *******/
-  nonorthogonal_lattice = check_for_orthogonal_basis(cell->recip_vects,cell->dim,
-                                                details->symm_tol);
-  if( nonorthogonal_lattice ){
-    printf("WARNING: The lattice is non-orthogonal.\n");
-    printf("\tI am not currently smart enough to generate a\n");
-    printf("\tminimal k-point set for non-orthogonal lattices.\n");
-    printf("\tI am going to make an attempt to reduce the zone somewhat,\n");
-    printf("\tbut you should check the resulting k-point set *carefully*.\n");
-    printf("\tFor a more efficent sampling, you will have to use one of the\n");
-    printf("\tdistributed k-point programs.\n");
-    fprintf(status_file,"WARNING: The lattice is non-orthogonal.\n");
-    fprintf(status_file,"\tI am not currently smart enough to generate a\n");
-    fprintf(status_file,"\tminimal k-point set for non-orthogonal lattices.\n");
-    fprintf(status_file,
-            "\tI am going to make an attempt to reduce the zone somewhat,\n");
+  use_spatial_ops = 1;
+  for(i=0;i<cell->num_atoms;i++){
+    if( cell->atoms[i].at_number >= 0 && cell->atoms[i].nf ) use_spatial_ops = 0;
+  }
+  if( details->num_FMO_frags ) use_spatial_ops = 0;
+  if( sym_ops_present && !use_spatial_ops ){
     fprintf(status_file,
-            "\tbut you should check the resulting k-point set *carefully*.\n");
+            "Only time reversal will be used to reduce the k point mesh \
+(f orbitals or FMO fragments are present).\n");
+  }
+
+  num_ops = 0;
+  num_unusable = 0;
+  for(op=sym_ops_present;op && use_spatial_ops;op=op->next){
+    if( op->type == Identity || op->redundant ) continue;
+    if( !mesh_op_from_sym_op(cell,direct,recip,op,details->symm_tol,
+                             &(mesh_ops[num_ops])) ){
+      num_unusable++;
+      continue;
+    }
+    for(slot=0;slot<num_mesh;slot++){
+      mesh_coords(slot,u,n,c);
+      if( !apply_mesh_op(&(mesh_ops[num_ops]),u,n,new_u) ||
+          mesh_slot(new_u,n,c) < 0 ) break;
+    }
+    if( slot < num_mesh ) num_unusable++;
+    else num_ops++;
+  }
+  for(i=0;i<3;i++){
+    for(j=0;j<3;j++){
+      mesh_ops[num_ops].mat[i][j] = -(i==j);
+    }
+  }
+  mesh_ops[num_ops].op = 0;
+  num_ops++;
+
+  if( num_unusable ){
     fprintf(status_file,
-            "\tfor a more efficent sampling, you will have to use one of the\n");
-    fprintf(status_file,"\tdistributed k-point programs.\n");
-
-    fprintf(output_file,";WARNING: The lattice is non-orthogonal.\n");
-    fprintf(output_file,";\tI am not currently smart enough to generate a\n");
-    fprintf(output_file,";\tminimal k-point set for non-orthogonal lattices.\n");
-    fprintf(output_file,
-            ";\tI am going to make an attempt to reduce the zone somewhat,\n");
-    fprintf(output_file,
-            ";\tbut you should check the resulting k-point set *carefully*.\n");
-    fprintf(output_file,
-            ";\tfor a more efficent sampling, you will have to use one of the\n");
-    fprintf(output_file,";\tdistributed k-point programs.\n");
-    reduce_kpoints(details,cell,raw_points,num_raw_points,degen_p,
-                              &num_points,nonorthogonal_lattice);
-  }else{
-#ifdef DEBUG_SYMM
-    printf("Good, the lattice is orthogonal.\n");
-#endif
-    reduce_kpoints(details,cell,raw_points,num_raw_points,degen_p,
-                              &num_points,nonorthogonal_lattice);
+            "%d symmetry operations don't map the k point mesh onto itself and were not used.\n",
+            num_unusable);
   }
-#ifdef DEBUG_SYMM
-  printf("Of the %d unique points originally present, %d survived:\n",
-                                  num_raw_points-num_duplicates,num_points);
-  tot_weight = 0;
-  for(i=0;i<num_raw_points;i++){
-    if( degen_p[i] > 0 ){
-      printf("(%6.4lf %6.4lf %6.4lf) %4.2lf\n",raw_points[i].x,raw_points[i].y,
-             raw_points[i].z,degen_p[i]);
-      tot_weight += degen_p[i];
+
+  /*******
+
+    now split the mesh into orbits.  Each orbit is built up breadth
+    first, starting from the lowest unassigned slot.
+
+  *******/
+  for(slot=0;slot<num_mesh;slot++) orbit[slot] = -1;
+  points = (k_point_type *)my_calloc(num_mesh,sizeof(k_point_type));
+  if( !points ) fatal("Can't allocate memory in automagic_k_points.");
+  num_points = 0;
+  for(slot=0;slot<num_mesh;slot++){
+    if( orbit[slot] >= 0 ) continue;
+
+    orbit[slot] = num_points;
+    from[slot] = -1;
+    queue[0] = slot;
+    head = 0;
+    tail = 1;
+    while( head < tail ){
+      mesh_coords(queue[head],u,n,c);
+      for(k=0;k<num_ops;k++){
+        /* every op was checked above, so the image is on the mesh */
+        apply_mesh_op(&(mesh_ops[k]),u,n,new_u);
+        new_slot = mesh_slot(new_u,n,c);
+        if( orbit[new_slot] < 0 ){
+          orbit[new_slot] = num_points;
+          /* from holds the position in the queue (= star) and the op */
+          from[new_slot] = head*(num_ops+1) + k;
+          queue[tail++] = new_slot;
+        }
+      }
+      head++;
+    }
+
+    /* store the point and its star */
+    star = (k_star_type *)my_calloc(tail,sizeof(k_star_type));
+    if( !star ) fatal("Can't allocate memory for a k point star.");
+    for(i=0;i<tail;i++){
+      mesh_coords(queue[i],u,n,c);
+      star[i].loc.x = (real)u[0]/(real)(2*n[0]);
+      star[i].loc.y = (real)u[1]/(real)(2*n[1]);
+      star[i].loc.z = (real)u[2]/(real)(2*n[2]);
+      if( i == 0 ){
+        star[i].from = -1;
+        star[i].op = 0;
+      } else{
+        star[i].from = from[queue[i]] / (num_ops+1);
+        star[i].op = mesh_ops[from[queue[i]] % (num_ops+1)].op;
+      }
     }
+    points[num_points].loc = star[0].loc;
+    points[num_points].weight = (real)tail;
+    points[num_points].num_in_star = tail;
+    points[num_points].star = star;
+    num_points++;
   }
-  printf("The sum of the k-weights is: %6.3lf\n",tot_weight);
-#endif
 
+  /* replace any k points which were already there */
+  if( details->K_POINTS ){
+    for(i=0;i<details->num_KPOINTS;i++){
+      if( details->K_POINTS[i].star ) my_free(details->K_POINTS[i].star);
+    }
+    my_free(details->K_POINTS);
+  }
+  details->K_POINTS = (k_point_type *)my_realloc((int *)points,
+                                                  num_points*sizeof(k_point_type));
+  if( !details->K_POINTS ) fatal("Can't allocate memory in automagic_k_points.");
+  details->num_KPOINTS = num_points;
+
+  fprintf(status_file,
+          "The %d point k point mesh was reduced to %d points using %d symmetry operations.\n",
+          num_mesh,num_points,num_ops);
+  fprintf(output_file,"\n; Automatically generated k point set: %d points from a %dx%dx%d mesh\n",
+          num_points,n[0],n[1],n[2]);
+  for(i=0;i<num_points;i++){
+    fprintf(output_file,";  %8.6lf %8.6lf %8.6lf  %4.0lf\n",
+            details->K_POINTS[i].loc.x,details->K_POINTS[i].loc.y,
+            details->K_POINTS[i].loc.z,details->K_POINTS[i].weight);
+  }
 
+  my_free(mesh_ops);
+  my_free(orbit);
+  my_free(queue);
+  my_free(from);
 }
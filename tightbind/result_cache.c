@@ -0,0 +1,618 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the on-disk cache of k point results.
+*
+*   For an average properties calculation on an extended system the
+*    expensive part of each cycle is building the matrices and doing the
+*    diagonalizations at the k points.  What comes out of that (S(R) or
+*    the S(k)'s, H(R) and the eigenvalues, wavefunctions and charge
+*    matrices stored in the avg_prop_info array) only depends on the
+*    geometry, the atomic parameters, the k point set and a few of the
+*    details.  When a cache directory is given in the input file those
+*    results are written to a file in that directory whose name is a hash
+*    of a text key describing all of those things.  A later run on the
+*    same problem (even one asking for different DOS projections or
+*    COOP's) finds the file and skips straight to the properties.
+*
+*   The key is made at the top of each cycle, before anything (like an
+*    automatically chosen rho) is changed by building the matrices.
+*
+*   The geometry in the key is given relative to the first atom and
+*    rounded to 1e-6 Angstrom, so structures which only differ by a
+*    translation or by round off share results.  The full key is kept
+*    in the file and checked when it's read, so hash collisions can't
+*    give wrong results.
+*
+*   Results are only taken from the cache when nothing would be printed
+*    at the individual k points.  The only exception is the note about a
+*    degenerate HOMO, which is put back in the output using the
+*    eigenvalues kept (at full precision) in the cache file.
+*
+*****************************************************************************/
+
+#include "bind.h"
+#include <stdarg.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define CACHE_MAGIC "YAeHMOP cache"
+#define CACHE_VERSION 2
+
+/* bits for the arrays stored at each k point */
+#define CACHE_VECTORS 1
+#define CACHE_CHG_MAT 2
+
+/* the key for the current cycle */
+static char *the_key=0;
+static long key_len=0,key_space=0;
+static unsigned long key_hash[2];
+static char key_valid=0;
+
+static int cache_hits=0,cache_misses=0;
+
+/* the eigenvalues at each k point of the current cycle */
+static real *kpoint_energies=0;
+static char *energies_kept=0;
+static long energies_space=0;
+
+
+/****************************************************************************
+*
+*                   Procedure key_printf
+*
+* Arguments: format: pointer to char
+*               ...
+*
+* Returns: none
+*
+* Action: adds to the end of the key (printf style).
+*
+*****************************************************************************/
+static void key_printf(char *format,...)
+{
+  va_list args;
+  int len;
+
+  while(1){
+    va_start(args,format);
+    len = vsnprintf(the_key+key_len,key_space-key_len,format,args);
+    va_end(args);
+    if( len < 0 ) FATAL_BUG("Bad format in key_printf.");
+    if( key_len+len < key_space ) break;
+    key_space = 2*key_space + len + 1024;
+    the_key = (char *)realloc(the_key,key_space);
+    if( !the_key ) fatal("Can't get memory for the result cache key.");
+  }
+  key_len += len;
+}
+
+/****************************************************************************
+*
+*                   Procedure key_real
+*
+* Arguments: value: real
+*
+* Returns: none
+*
+* Action: adds a geometric value to the key, rounded to 6 places
+*   (so that -0.000000 and 0.000000 come out the same).
+*
+*****************************************************************************/
+static void key_real(real value)
+{
+  if( fabs(value) < 5e-7 ) value = 0.0;
+  key_printf(" %.6f",value);
+}
+
+/****************************************************************************
+*
+*                   Procedure build_cache_key
+*
+* Arguments:     cell: pointer to cell_type
+*             details: pointer to detail_type
+*            num_orbs: int
+*        tot_overlaps: int
+*
+* Returns: none
+*
+* Action: builds the key (and its hash) for the current state of the
+*   calculation.
+*
+*****************************************************************************/
+static void build_cache_key(cell_type *cell,detail_type *details,int num_orbs,
+                            int tot_overlaps)
+{
+  atom_type *atom,*origin;
+  k_point_type *kpoint;
+  overlap_cancel_type *off;
+  Tvect_type *tvect;
+  unsigned long hash1,hash2;
+  int i;
+
+  key_len = 0;
+  key_printf("%s %d\n",CACHE_MAGIC,CACHE_VERSION);
+  key_printf("mode %d %d %d dim %d atoms %d orbs %d overlaps %d (%d %d %d)\n",
+             details->Execution_Mode,details->store_R_overlaps,
+             details->mixed_precision,cell->dim,cell->num_atoms,num_orbs,
+             tot_overlaps,cell->overlaps[0],cell->overlaps[1],cell->overlaps[2]);
+  key_printf("const %.10g weighted %d rho %.10g sparsify %.10g symmetry %d nodiag_S %d\n",
+             details->the_const,details->weighted_Hij,details->rho,
+             details->sparsify_value,details->use_symmetry,details->diag_wo_overlap);
+  for(i=0;i<details->num_overlaps_off;i++){
+    off = &(details->overlaps_off[i]);
+    key_printf("off %d %d %d %d\n",off->type,off->inter_cell,off->which1,
+               off->which2);
+  }
+
+  /* the lattice */
+  for(i=0;i<cell->dim;i++){
+    tvect = &(cell->tvects[i]);
+    key_printf("tvect");
+    key_real(cell->atoms[tvect->end].loc.x-cell->atoms[tvect->begin].loc.x);
+    key_real(cell->atoms[tvect->end].loc.y-cell->atoms[tvect->begin].loc.y);
+    key_real(cell->atoms[tvect->end].loc.z-cell->atoms[tvect->begin].loc.z);
+    key_printf("\n");
+  }
+
+  /* the atoms and their parameters */
+  origin = &(cell->atoms[0]);
+  for(i=0;i<cell->num_atoms;i++){
+    atom = &(cell->atoms[i]);
+    key_printf("%s",atom->symb);
+    key_real(atom->loc.x-origin->loc.x);
+    key_real(atom->loc.y-origin->loc.y);
+    key_real(atom->loc.z-origin->loc.z);
+    key_printf(" s %d %.10g %.10g",atom->ns,atom->coul_s,atom->exp_s);
+    key_printf(" p %d %.10g %.10g",atom->np,atom->coul_p,atom->exp_p);
+    key_printf(" d %d %.10g %.10g %.10g %.10g %.10g",atom->nd,atom->coul_d,
+               atom->exp_d,atom->coeff_d1,atom->exp_d2,atom->coeff_d2);
+    key_printf(" f %d %.10g %.10g %.10g %.10g %.10g\n",atom->nf,atom->coul_f,
+               atom->exp_f,atom->coeff_f1,atom->exp_f2,atom->coeff_f2);
+  }
+
+  /* the k points */
+  for(i=0;i<details->num_KPOINTS;i++){
+    kpoint = &(details->K_POINTS[i]);
+    key_printf("k %.8f %.8f %.8f %.8g %d\n",kpoint->loc.x,kpoint->loc.y,
+               kpoint->loc.z,kpoint->weight,kpoint->num_in_star);
+  }
+
+  /* two different (32 bit FNV-1a and djb2) hashes make up the file name */
+  hash1 = 2166136261UL;
+  hash2 = 5381;
+  for(i=0;i<key_len;i++){
+    hash1 = ((hash1 ^ (unsigned char)the_key[i]) * 16777619UL) & 0xffffffffUL;
+    hash2 = ((hash2 << 5) + hash2 + (unsigned char)the_key[i]) & 0xffffffffUL;
+  }
+  key_hash[0] = hash1;
+  key_hash[1] = hash2;
+}
+
+/****************************************************************************
+*
+*                   Function cache_contents
+*
+* Arguments: details: pointer to detail_type
+*
+* Returns: int
+*
+* Action: returns the CACHE_ bits for the arrays which store_avg_prop_info
+*   fills in for this run.
+*
+*****************************************************************************/
+static int cache_contents(detail_type *details)
+{
+  int contents=0;
+
+  if( !details->just_avgE &&
+      (details->num_proj_DOS || details->the_COOPS || !details->no_total_DOS_PRT) ){
+    contents |= CACHE_VECTORS;
+    if( details->chg_mat_PRT || details->Rchg_mat_PRT || !details->no_total_DOS_PRT ){
+      contents |= CACHE_CHG_MAT;
+    }
+  }
+  return contents;
+}
+
+/****************************************************************************
+*
+*                   Function cacheable
+*
+* Arguments: cell: pointer to cell_type
+*         details: pointer to detail_type
+*          lookup: char
+*
+* Returns: char
+*
+* Action: returns 1 if the results of this run can go in the cache (or,
+*   if 'lookup is set, be taken from it).
+*
+*****************************************************************************/
+static char cacheable(cell_type *cell,detail_type *details,char lookup)
+{
+  if( !details->cache_dir[0] ) return 0;
+  if( cell->dim == 0 || details->Execution_Mode != FAT || !details->avg_props ||
+      details->just_matrices || details->num_FMO_frags || details->num_FCO_frags ||
+      details->memory_budget > 0.0 ) return 0;
+  if( !lookup ) return 1;
+
+  /* these all print something at each k point */
+  if( details->levels_PRT || details->OP_mat_PRT || details->ROP_mat_PRT ||
+      details->net_chg_PRT || details->mod_OP_mat_PRT || details->mod_ROP_mat_PRT ||
+      details->mod_net_chg_PRT || details->chg_mat_PRT || details->Rchg_mat_PRT ||
+      details->wave_fn_PRT || details->overlap_mat_PRT || details->hamil_PRT ||
+      details->num_MOs_to_print || details->dump_overlap || details->dump_hamil ||
+      details->dump_sparse_mats || details->binary_results ||
+      details->step_print_options ) return 0;
+
+  /* a checkpoint being picked up needs the k point loop */
+  if( checkpoint_pending() ) return 0;
+  return 1;
+}
+
+/****************************************************************************
+*
+*                   Procedure get_energy_space
+*
+* Arguments: details: pointer to detail_type
+*           num_orbs: int
+*
+* Returns: none
+*
+* Action: makes sure there's room to keep the eigenvalues of all the
+*   k points and marks all of them as not yet kept.
+*
+*****************************************************************************/
+static void get_energy_space(detail_type *details,int num_orbs)
+{
+  long needed;
+
+  needed = (long)details->num_KPOINTS*num_orbs;
+  if( needed > energies_space ){
+    kpoint_energies = (real *)realloc(kpoint_energies,needed*sizeof(real));
+    if( !kpoint_energies ) fatal("Can't get memory for the result cache energies.");
+    energies_space = needed;
+  }
+  energies_kept = (char *)realloc(energies_kept,details->num_KPOINTS*sizeof(char)+1);
+  if( !energies_kept ) fatal("Can't get memory for the result cache energies.");
+  bzero(energies_kept,details->num_KPOINTS*sizeof(char));
+}
+
+/****************************************************************************
+*
+*                   Procedure cache_file_name
+*
+* Arguments: details: pointer to detail_type
+*               name: pointer to char
+*
+* Returns: none
+*
+* Action: puts the name of the cache file for the current key in 'name.
+*
+*****************************************************************************/
+static void cache_file_name(detail_type *details,char *name)
+{
+  sprintf(name,"%s/%08lx%08lx.ehc",details->cache_dir,key_hash[0],key_hash[1]);
+}
+
+/****************************************************************************
+*
+*                   Procedure cache_matrix_sizes
+*
+* Arguments: details: pointer to detail_type
+*           num_orbs: int
+*       tot_overlaps: int
+*        overlap_len: pointer to long
+*          hamil_len: pointer to long
+*
+* Returns: none
+*
+* Action: finds how many reals there are in the stored overlap matrices
+*   (Overlap_R or, if the S(k)'s are stored instead, Overlap_K) and in
+*   the Hamiltonian.
+*
+*****************************************************************************/
+static void cache_matrix_sizes(detail_type *details,int num_orbs,int tot_overlaps,
+                               long *overlap_len,long *hamil_len)
+{
+  long overlapR,hamR,overlapK,hamK;
+
+  extended_matrix_sizes(details,num_orbs,tot_overlaps,details->Execution_Mode,
+                        details->store_R_overlaps,&overlapR,&hamR,&overlapK,&hamK);
+  *overlap_len = details->store_R_overlaps ? overlapR : overlapK;
+  *hamil_len = hamR;
+}
+
+/****************************************************************************
+*
+*                   Function result_cache_fetch
+*
+* Arguments:     cell: pointer to cell_type
+*             details: pointer to detail_type
+*            num_orbs: int
+*        tot_overlaps: int
+*   overlapR,hamilR,overlapK: hermetian_matrix_type
+*       avg_prop_info: pointer to avg_prop_info_type
+*
+* Returns: char
+*
+* Action: looks for the results of the current cycle in the cache.
+*   If they are there, the overlap matrices, the Hamiltonian and the
+*   'avg_prop_info array are filled in from the cache file and 1 is
+*   returned.
+*
+*****************************************************************************/
+char result_cache_fetch(cell_type *cell,detail_type *details,int num_orbs,
+                        int tot_overlaps,hermetian_matrix_type overlapR,
+                        hermetian_matrix_type hamilR,hermetian_matrix_type overlapK,
+                        avg_prop_info_type *avg_prop_info)
+{
+  char file_name[MAX_STR_LEN+40];
+  FILE *infile;
+  char *stored_key;
+  long stored_len,overlap_len,hamil_len,lens[2];
+  int contents,stored_contents;
+  real stored_rho;
+  long num_sq;
+  int i,begin_degen;
+  char ok;
+
+  key_valid = 0;
+  if( !cacheable(cell,details,0) ) return 0;
+  build_cache_key(cell,details,num_orbs,tot_overlaps);
+  key_valid = 1;
+  get_energy_space(details,num_orbs);
+  if( !cacheable(cell,details,1) ) return 0;
+
+  cache_file_name(details,file_name);
+  cache_matrix_sizes(details,num_orbs,tot_overlaps,&overlap_len,&hamil_len);
+  contents = cache_contents(details);
+  num_sq = (long)num_orbs*num_orbs;
+
+  infile = fopen(file_name,"rb");
+  ok = infile != 0;
+
+  /* make sure the file really is for this problem */
+  if( ok ){
+    ok = fread(&stored_len,sizeof(long),1,infile) == 1 && stored_len == key_len;
+  }
+  if( ok ){
+    stored_key = (char *)malloc(key_len);
+    if( !stored_key ) fatal("Can't get memory to check the result cache key.");
+    ok = fread(stored_key,sizeof(char),key_len,infile) == (size_t)key_len &&
+      !memcmp(stored_key,the_key,key_len);
+    free(stored_key);
+  }
+  if( ok ){
+    ok = fread(&stored_rho,sizeof(real),1,infile) == 1 &&
+      fread(&stored_contents,sizeof(int),1,infile) == 1 &&
+      (stored_contents & contents) == contents &&
+      fread(lens,sizeof(long),2,infile) == 2 &&
+      lens[0] == overlap_len && lens[1] == hamil_len;
+  }
+
+  /* read in the results */
+  if( ok ){
+    ok = fread(details->store_R_overlaps ? overlapR.mat : overlapK.mat,
+               sizeof(real),overlap_len,infile) == (size_t)overlap_len &&
+      fread(hamilR.mat,sizeof(real),hamil_len,infile) == (size_t)hamil_len;
+    for(i=0;i<details->num_KPOINTS && ok;i++){
+      ok = fread(avg_prop_info[i].energies,sizeof(float),num_orbs,infile) == (size_t)num_orbs &&
+        fread(&(kpoint_energies[i*num_orbs]),sizeof(real),num_orbs,infile) == (size_t)num_orbs;
+      if( ok && (stored_contents & CACHE_VECTORS) ){
+        if( contents & CACHE_VECTORS ){
+          ok = fread(avg_prop_info[i].orbs,sizeof(float),num_sq,infile) == (size_t)num_sq &&
+            fread(avg_prop_info[i].orbsI,sizeof(float),num_sq,infile) == (size_t)num_sq;
+        } else{
+          ok = !fseek(infile,2*num_sq*sizeof(float),SEEK_CUR);
+        }
+      }
+      if( ok && (stored_contents & CACHE_CHG_MAT) ){
+        if( contents & CACHE_CHG_MAT ){
+          ok = fread(avg_prop_info[i].chg_mat,sizeof(float),num_sq,infile) == (size_t)num_sq;
+        } else{
+          ok = !fseek(infile,num_sq*sizeof(float),SEEK_CUR);
+        }
+      }
+    }
+    if( !ok ){
+      /* the overlaps may be partly overwritten, so they have to be rebuilt */
+      fprintf(status_file,"Result cache file %s is damaged, ignoring it.\n",file_name);
+      mark_overlaps_current(cell,details,0);
+    }
+  }
+  if( infile ) fclose(infile);
+
+  if( !ok ){
+    fprintf(status_file,"Result cache miss (%08lx%08lx).\n",key_hash[0],key_hash[1]);
+    cache_misses++;
+    return 0;
+  }
+
+  fprintf(status_file,"Result cache hit (%08lx%08lx), the k points are skipped.\n",
+          key_hash[0],key_hash[1]);
+  cache_hits++;
+
+  /* the rho that was used to build the overlaps (it's reported just as
+     it would have been when they were built) */
+  details->rho = stored_rho;
+  fprintf(output_file,"\n\n; RHO = %lf\n",details->rho);
+
+  /* the k point labels (and any notes about degenerate HOMOs) still go
+     in the output */
+  for(i=0;i<details->num_KPOINTS;i++){
+    print_kpoint_label(i,&(details->K_POINTS[i]));
+    if( !details->just_avgE ){
+      find_HOMO_degeneracy(cell->num_electrons,num_orbs,
+                           &(kpoint_energies[i*num_orbs]),&begin_degen);
+    }
+  }
+  return 1;
+}
+
+/****************************************************************************
+*
+*                   Procedure result_cache_keep_energies
+*
+* Arguments:  which_k: int
+*            num_orbs: int
+*            eigenset: eigenset_type
+*
+* Returns: none
+*
+* Action: holds on to the eigenvalues of k point 'which_k so that they
+*   can go in the cache file at the end of the cycle.
+*
+*****************************************************************************/
+void result_cache_keep_energies(int which_k,int num_orbs,eigenset_type eigenset)
+{
+  if( !key_valid ) return;
+  bcopy((char *)eigenset.val,(char *)&(kpoint_energies[which_k*num_orbs]),
+        num_orbs*sizeof(real));
+  energies_kept[which_k] = 1;
+}
+
+/****************************************************************************
+*
+*                   Procedure result_cache_store
+*
+* Arguments:     cell: pointer to cell_type
+*             details: pointer to detail_type
+*            num_orbs: int
+*        tot_overlaps: int
+*   overlapR,hamilR,overlapK: hermetian_matrix_type
+*       avg_prop_info: pointer to avg_prop_info_type
+*
+* Returns: none
+*
+* Action: writes the results of the current cycle to the cache
+*   (under the key made by result_cache_fetch at the top of the cycle).
+*   The file is written under a temporary name and then renamed, so
+*   other runs using the cache never see a partial file.
+*
+*****************************************************************************/
+void result_cache_store(cell_type *cell,detail_type *details,int num_orbs,
+                        int tot_overlaps,hermetian_matrix_type overlapR,
+                        hermetian_matrix_type hamilR,hermetian_matrix_type overlapK,
+                        avg_prop_info_type *avg_prop_info)
+{
+  char file_name[MAX_STR_LEN+40],tmp_name[MAX_STR_LEN+80];
+  FILE *outfile;
+  long overlap_len,hamil_len,lens[2];
+  int contents;
+  long num_sq;
+  int i,j;
+  char ok;
+
+  if( !key_valid ) return;
+  key_valid = 0;
+
+  cache_file_name(details,file_name);
+  cache_matrix_sizes(details,num_orbs,tot_overlaps,&overlap_len,&hamil_len);
+  contents = cache_contents(details);
+  num_sq = (long)num_orbs*num_orbs;
+
+  sprintf(tmp_name,"%s.%ld.tmp",file_name,(long)getpid());
+  outfile = fopen(tmp_name,"wb");
+  if( !outfile ){
+    fprintf(status_file,"Can't write the result cache file %s.\n",tmp_name);
+    return;
+  }
+
+  lens[0] = overlap_len;
+  lens[1] = hamil_len;
+  ok = fwrite(&key_len,sizeof(long),1,outfile) == 1 &&
+    fwrite(the_key,sizeof(char),key_len,outfile) == (size_t)key_len &&
+    fwrite(&(details->rho),sizeof(real),1,outfile) == 1 &&
+    fwrite(&contents,sizeof(int),1,outfile) == 1 &&
+    fwrite(lens,sizeof(long),2,outfile) == 2 &&
+    fwrite(details->store_R_overlaps ? overlapR.mat : overlapK.mat,
+           sizeof(real),overlap_len,outfile) == (size_t)overlap_len &&
+    fwrite(hamilR.mat,sizeof(real),hamil_len,outfile) == (size_t)hamil_len;
+  for(i=0;i<details->num_KPOINTS && ok;i++){
+    /* k points which came from a checkpoint only have the single
+       precision eigenvalues */
+    if( !energies_kept[i] ){
+      for(j=0;j<num_orbs;j++){
+        kpoint_energies[i*num_orbs+j] = avg_prop_info[i].energies[j];
+      }
+    }
+    ok = fwrite(avg_prop_info[i].energies,sizeof(float),num_orbs,outfile) == (size_t)num_orbs &&
+      fwrite(&(kpoint_energies[i*num_orbs]),sizeof(real),num_orbs,outfile) == (size_t)num_orbs;
+    if( ok && (contents & CACHE_VECTORS) ){
+      ok = fwrite(avg_prop_info[i].orbs,sizeof(float),num_sq,outfile) == (size_t)num_sq &&
+        fwrite(avg_prop_info[i].orbsI,sizeof(float),num_sq,outfile) == (size_t)num_sq;
+    }
+    if( ok && (contents & CACHE_CHG_MAT) ){
+      ok = fwrite(avg_prop_info[i].chg_mat,sizeof(float),num_sq,outfile) == (size_t)num_sq;
+    }
+  }
+  if( fclose(outfile) ) ok = 0;
+
+#ifdef _WIN32
+  if( ok ) remove(file_name);
+#endif
+  if( !ok || rename(tmp_name,file_name) ){
+    fprintf(status_file,"Can't write the result cache file %s.\n",file_name);
+    remove(tmp_name);
+    return;
+  }
+  fprintf(status_file,"Results stored in the cache as %s.\n",file_name);
+}
+
+/****************************************************************************
+*
+*                   Procedure report_result_cache
+*
+* Arguments: outfile: pointer to FILE
+*
+* Returns: none
+*
+* Action: writes the number of cache hits and misses to 'outfile.
+*   Nothing is written if the cache wasn't used.
+*
+*****************************************************************************/
+void report_result_cache(FILE *outfile)
+{
+  if( !outfile || (!cache_hits && !cache_misses) ) return;
+  fprintf(outfile,"Result cache: %d hits, %d misses.\n",cache_hits,cache_misses);
+  cache_hits = 0;
+  cache_misses = 0;
+}
@@ -0,0 +1,570 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+
+/****************************************************************************
+*
+*     this file contains the routines for writing the binary results
+*      (.bres) file.
+*
+*   The format is described in results.h.  Everything that is written
+*    here is also printed into the output file (unless text matrices
+*    have been turned off), this is just an easier to read copy.
+*
+*   All of these functions are safe to call when no results file is
+*    open, they just don't do anything.
+*
+*   The chunks can also be collected in memory instead of (or as well
+*    as) being written to the file; this is what the library interface
+*    in eht_api.c uses to hand results back without any parsing.
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+#ifdef USE_FLOATS
+#define RESULTS_REAL RESULTS_FLOAT
+#else
+#define RESULTS_REAL RESULTS_DOUBLE
+#endif
+
+static FILE *results_file=0;
+static int results_step=0;
+static int results_kpoint=-1;
+
+/* the chunks collected in memory (see results_start_capture) */
+static char results_capturing=0;
+static results_list_type *captured_head=0,*captured_tail=0;
+
+/* used to accumulate tables (curves) before they're written */
+static char table_name[RESULTS_NAME_LEN];
+static int table_index,table_cols;
+static int table_num_vals=0,table_max_vals=0;
+static real *table_vals=0;
+
+
+/****************************************************************************
+*
+*                   Procedure capture_chunk
+*
+* Arguments: chunk: pointer to results_chunk_type
+*        elem_size: int
+*             data: pointer to void
+*
+* Returns: none
+*
+* Action: adds a copy of 'chunk and its data to the end of the list
+*   of captured chunks.
+*
+*   This memory isn't tracked by my_malloc, since it has to survive
+*    cleanup_memory.
+*
+*****************************************************************************/
+static void capture_chunk(results_chunk_type *chunk,int elem_size,void *data)
+{
+  results_list_type *new_item;
+
+  new_item = (results_list_type *)calloc(1,sizeof(results_list_type));
+  if( !new_item ) fatal("Can't allocate memory to capture a result.");
+  new_item->chunk = *chunk;
+  if( chunk->num_elements ){
+    new_item->data = malloc((size_t)chunk->num_elements*elem_size);
+    if( !new_item->data ) fatal("Can't allocate memory to capture a result.");
+    memcpy(new_item->data,data,(size_t)chunk->num_elements*elem_size);
+  }
+  if( captured_tail ) captured_tail->next = new_item;
+  else captured_head = new_item;
+  captured_tail = new_item;
+}
+
+/****************************************************************************
+*
+*                   Procedure results_write
+*
+* Arguments: name: pointer to char
+*            type: int
+*          layout: int
+*           index: int
+*       rows,cols: ints
+*    num_elements: int
+*            data: pointer to void
+*
+* Returns: none
+*
+* Action: writes a chunk into the results file.  The chunk is tagged
+*   with the current Walsh step and k point.
+*
+*****************************************************************************/
+void results_write(char *name,int type,int layout,int index,int rows,int cols,
+                   int num_elements,void *data)
+{
+  results_chunk_type chunk;
+  int elem_size;
+
+  if( !results_file && !results_capturing ) return;
+
+  switch(type){
+  case RESULTS_CHAR: elem_size = sizeof(char); break;
+  case RESULTS_INT: elem_size = sizeof(int); break;
+  case RESULTS_FLOAT: elem_size = sizeof(float); break;
+  case RESULTS_DOUBLE: elem_size = sizeof(double); break;
+  default: FATAL_BUG("Bad type passed to results_write."); return;
+  }
+
+  bzero((char *)&chunk,sizeof(results_chunk_type));
+  strncpy(chunk.name,name,RESULTS_NAME_LEN-1);
+  chunk.type = type;
+  chunk.layout = layout;
+  chunk.step = results_step;
+  chunk.kpoint = results_kpoint;
+  chunk.index = index;
+  chunk.rows = rows;
+  chunk.cols = cols;
+  chunk.num_elements = num_elements;
+
+  if( results_capturing ) capture_chunk(&chunk,elem_size,data);
+  if( !results_file ) return;
+
+  if( fwrite(&chunk,sizeof(results_chunk_type),1,results_file) != 1 ||
+      (num_elements &&
+       fwrite(data,elem_size,num_elements,results_file) != num_elements) ){
+    error("Can't write to the binary results file, closing it.");
+    fclose(results_file);
+    results_file = 0;
+  }
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_write_mat
+*
+* Arguments: name: pointer to char
+*       rows,cols: ints
+*             mat: pointer to real
+*
+* Returns: none
+*
+* Action: writes the 'rows x 'cols matrix 'mat into the results file.
+*
+*****************************************************************************/
+void results_write_mat(char *name,int rows,int cols,real *mat)
+{
+  results_write(name,RESULTS_REAL,RESULTS_DENSE,-1,rows,cols,rows*cols,
+                (void *)mat);
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_write_sym_mat
+*
+* Arguments: name: pointer to char
+*             dim: int
+*             mat: pointer to real
+*
+* Returns: none
+*
+* Action: writes the symmetric matrix 'mat (in the same storage
+*   print_sym_mat uses) into the results file.
+*
+*****************************************************************************/
+void results_write_sym_mat(char *name,int dim,real *mat)
+{
+  results_write(name,RESULTS_REAL,RESULTS_SYMMETRIC,-1,dim,dim,
+                dim*(dim+1)/2,(void *)mat);
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_write_hermetian_mat
+*
+* Arguments: name: pointer to char
+*             dim: int
+*             mat: pointer to real
+*
+* Returns: none
+*
+* Action: writes the hermetian matrix 'mat into the results file.
+*
+*****************************************************************************/
+void results_write_hermetian_mat(char *name,int dim,real *mat)
+{
+  results_write(name,RESULTS_REAL,RESULTS_HERMETIAN,-1,dim,dim,dim*dim,
+                (void *)mat);
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_begin_table
+*
+* Arguments: name: pointer to char
+*           index: int
+*            cols: int
+*
+* Returns: none
+*
+* Action: starts collecting a table with 'cols columns.  The values
+*   are added (by rows) with results_table_value and the table is
+*   written by results_end_table.
+*
+*   This is used for things like DOS curves which are generated
+*    one point at a time.
+*
+*****************************************************************************/
+void results_begin_table(char *name,int index,int cols)
+{
+  if( !results_file && !results_capturing ) return;
+  strncpy(table_name,name,RESULTS_NAME_LEN-1);
+  table_name[RESULTS_NAME_LEN-1] = 0;
+  table_index = index;
+  table_cols = cols;
+  table_num_vals = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_table_value
+*
+* Arguments: val: real
+*
+* Returns: none
+*
+* Action: adds 'val to the current table.
+*
+*****************************************************************************/
+void results_table_value(real val)
+{
+  if( !results_file && !results_capturing ) return;
+  if( table_num_vals == table_max_vals ){
+    table_max_vals = table_max_vals ? 2*table_max_vals : 256;
+    table_vals = (real *)my_realloc((int *)table_vals,
+                                   table_max_vals*sizeof(real));
+    if( !table_vals ) fatal("Can't realloc table_vals.");
+  }
+  table_vals[table_num_vals++] = val;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_end_table
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: writes the current table into the results file.
+*
+*****************************************************************************/
+void results_end_table()
+{
+  if( !results_file && !results_capturing ) return;
+  results_write(table_name,RESULTS_REAL,RESULTS_DENSE,table_index,
+                table_num_vals/table_cols,table_cols,table_num_vals,
+                (void *)table_vals);
+  table_num_vals = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_set_kpoint
+*
+* Arguments: kpoint: int
+*
+* Returns: none
+*
+* Action: sets the k point that the chunks written from now on will be
+*   tagged with.  Use -1 for things which aren't for a single k point.
+*
+*****************************************************************************/
+void results_set_kpoint(int kpoint)
+{
+  results_kpoint = kpoint;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_begin_step
+*
+* Arguments: cell: pointer to cell_type
+*            step: int
+*
+* Returns: none
+*
+* Action: starts a new Walsh step and writes the geometry for it.
+*
+*****************************************************************************/
+void results_begin_step(cell_type *cell,int step)
+{
+  real *locs;
+  int i;
+
+  if( !results_file && !results_capturing ) return;
+  results_step = step;
+  results_kpoint = -1;
+
+  locs = (real *)my_malloc(3*(cell->num_atoms+cell->dim)*sizeof(real));
+  if( !locs ) fatal("Can't allocate memory for the atomic positions.");
+  for(i=0;i<cell->num_atoms;i++){
+    locs[3*i] = cell->atoms[i].loc.x;
+    locs[3*i+1] = cell->atoms[i].loc.y;
+    locs[3*i+2] = cell->atoms[i].loc.z;
+  }
+  results_write_mat("positions",cell->num_atoms,3,locs);
+
+  for(i=0;i<cell->dim;i++){
+    locs[3*i] = cell->atoms[cell->tvects[i].end].loc.x -
+      cell->atoms[cell->tvects[i].begin].loc.x;
+    locs[3*i+1] = cell->atoms[cell->tvects[i].end].loc.y -
+      cell->atoms[cell->tvects[i].begin].loc.y;
+    locs[3*i+2] = cell->atoms[cell->tvects[i].end].loc.z -
+      cell->atoms[cell->tvects[i].begin].loc.z;
+  }
+  if( cell->dim ) results_write_mat("lattice_vectors",cell->dim,3,locs);
+  my_free(locs);
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_open_file
+*
+* Arguments: details: pointer to detail_type
+*               cell: pointer to cell_type
+*           num_orbs: int
+*          file_name: pointer to char
+*
+* Returns: none
+*
+* Action: opens the results file and writes the header information
+*   (things which don't change over the course of the run).
+*
+*****************************************************************************/
+void results_open_file(detail_type *details,cell_type *cell,int num_orbs,
+                       char *file_name)
+{
+  results_header_type header;
+  char outname[MAX_STR_LEN+8];
+  char *symbs;
+  real *kpoints;
+  int i;
+
+  if( snprintf(outname,sizeof(outname),"%s.bres",file_name) >= (int)sizeof(outname) ){
+    error("The name of the binary results file is too long.");
+    return;
+  }
+  results_file = fopen(outname,"wb");
+  if( !results_file ){
+    error("Can't open the binary results file.");
+    return;
+  }
+  fprintf(status_file,"Writing binary results to %s\n",outname);
+
+  bzero((char *)&header,sizeof(results_header_type));
+  /* the magic number is a fixed width tag, not a string */
+  memcpy(header.magic,RESULTS_MAGIC,8);
+  header.version = RESULTS_VERSION;
+  header.byte_order = RESULTS_BYTE_ORDER;
+  fwrite(&header,sizeof(results_header_type),1,results_file);
+
+  results_step = 0;
+  results_kpoint = -1;
+
+  results_write("title",RESULTS_CHAR,RESULTS_DENSE,-1,1,strlen(details->title)+1,
+                strlen(details->title)+1,(void *)details->title);
+  results_write("num_orbs",RESULTS_INT,RESULTS_DENSE,-1,1,1,1,(void *)&num_orbs);
+  results_write("num_electrons",RESULTS_REAL,RESULTS_DENSE,-1,1,1,1,
+                (void *)&cell->num_electrons);
+
+  symbs = (char *)my_calloc(cell->num_atoms*ATOM_SYMB_LEN,sizeof(char));
+  if( !symbs ) fatal("Can't allocate memory for the atomic symbols.");
+  for(i=0;i<cell->num_atoms;i++){
+    snprintf(&(symbs[i*ATOM_SYMB_LEN]),ATOM_SYMB_LEN,"%s",cell->atoms[i].symb);
+  }
+  results_write("atom_symbols",RESULTS_CHAR,RESULTS_DENSE,-1,cell->num_atoms,
+                ATOM_SYMB_LEN,cell->num_atoms*ATOM_SYMB_LEN,(void *)symbs);
+  my_free(symbs);
+
+  /* the orbital_lookup_table tells which orbitals go with which atoms */
+  results_write("orbital_lookup_table",RESULTS_INT,RESULTS_DENSE,-1,1,
+                cell->num_atoms,cell->num_atoms,(void *)orbital_lookup_table);
+
+  if( details->Execution_Mode != MOLECULAR && details->num_KPOINTS ){
+    kpoints = (real *)my_malloc(4*details->num_KPOINTS*sizeof(real));
+    if( !kpoints ) fatal("Can't allocate memory for the k points.");
+    for(i=0;i<details->num_KPOINTS;i++){
+      kpoints[4*i] = details->K_POINTS[i].loc.x;
+      kpoints[4*i+1] = details->K_POINTS[i].loc.y;
+      kpoints[4*i+2] = details->K_POINTS[i].loc.z;
+      kpoints[4*i+3] = details->K_POINTS[i].weight;
+    }
+    results_write_mat("kpoints",details->num_KPOINTS,4,kpoints);
+    my_free(kpoints);
+  }
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_close_file
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: writes the end marker and closes the results file.
+*
+*****************************************************************************/
+void results_close_file()
+{
+  if( !results_file ) return;
+  results_kpoint = -1;
+  results_write("END",RESULTS_CHAR,RESULTS_DENSE,-1,0,0,0,(void *)0);
+  if( results_file ) fclose(results_file);
+  results_file = 0;
+  if( table_vals ) my_free(table_vals);
+  table_vals = 0;
+  table_max_vals = 0;
+  table_num_vals = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_start_capture
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: starts collecting the chunks in memory.  They are handed
+*   over by results_end_capture.
+*
+*****************************************************************************/
+void results_start_capture()
+{
+  results_free_list(captured_head);
+  captured_head = captured_tail = 0;
+  results_capturing = 1;
+  results_step = 0;
+  results_kpoint = -1;
+}
+
+
+/****************************************************************************
+*
+*                   Function results_end_capture
+*
+* Arguments: none
+*
+* Returns: pointer to results_list_type
+*
+* Action: stops collecting chunks and returns the list of the ones
+*   collected since results_start_capture.  The caller owns the list
+*   (free it with results_free_list).
+*
+*****************************************************************************/
+results_list_type *results_end_capture()
+{
+  results_list_type *list;
+
+  list = captured_head;
+  captured_head = captured_tail = 0;
+  results_capturing = 0;
+  if( !results_file && table_vals ){
+    my_free(table_vals);
+    table_vals = 0;
+    table_max_vals = 0;
+    table_num_vals = 0;
+  }
+  return list;
+}
+
+
+/****************************************************************************
+*
+*                   Function results_find
+*
+* Arguments: list: pointer to results_list_type
+*            name: pointer to char
+*    kpoint,index: ints
+*
+* Returns: pointer to results_list_type
+*
+* Action: finds the chunk called 'name for 'kpoint with 'index in
+*   'list.  If there is more than one (as happens in a charge iteration)
+*   the last one written is returned.  Returns 0 if there isn't one.
+*
+*****************************************************************************/
+results_list_type *results_find(results_list_type *list,char *name,
+                                int kpoint,int index)
+{
+  results_list_type *found=0;
+
+  for(;list;list=list->next){
+    if( list->chunk.kpoint == kpoint && list->chunk.index == index &&
+        !strncmp(list->chunk.name,name,RESULTS_NAME_LEN) ){
+      found = list;
+    }
+  }
+  return found;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure results_free_list
+*
+* Arguments: list: pointer to results_list_type
+*
+* Returns: none
+*
+* Action: frees a list of chunks returned by results_end_capture.
+*
+*****************************************************************************/
+void results_free_list(results_list_type *list)
+{
+  results_list_type *next;
+
+  while(list){
+    next = list->next;
+    if( list->data ) free(list->data);
+    free(list);
+    list = next;
+  }
+}
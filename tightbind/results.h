@@ -0,0 +1,116 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the definitions for the binary results file
+*      (the .bres file).
+*
+*     it is kept separate from bind.h so that programs which read these
+*      files (see utils/results_reader.c) don't need the rest of bind.
+*
+*   The file starts with a results_header_type.  That is followed by
+*    a series of chunks, each of which is a results_chunk_type followed
+*    immediately by 'num_elements values of the type given in the
+*    chunk header.  The last chunk is named "END" and has no data.
+*
+*   Chunks which hold something that was evaluated at a particular
+*    k point have 'kpoint set to the index of that k point (0 for
+*    molecules), the others have 'kpoint set to -1.  'step is the
+*    Walsh step (0 if there's no Walsh diagram).  'index is used to
+*    tell apart multiple curves (projected DOS's, COOP's) and is -1
+*    otherwise.
+*
+*   Readers should skip chunks they don't recognize.
+*
+*****************************************************************************/
+
+#ifndef RESULTS_FORMAT_DEFINED
+#define RESULTS_FORMAT_DEFINED
+
+#define RESULTS_MAGIC "YAeHbres"
+#define RESULTS_VERSION 1
+/* used to detect files written on machines with the other byte order */
+#define RESULTS_BYTE_ORDER 0x01020304
+
+#define RESULTS_NAME_LEN 32
+
+/* the element types */
+#define RESULTS_CHAR 1
+#define RESULTS_INT 2
+#define RESULTS_FLOAT 3
+#define RESULTS_DOUBLE 4
+
+/********
+  the layouts of the matrices:
+   RESULTS_DENSE: 'rows x 'cols, stored by rows.
+   RESULTS_SYMMETRIC: the lower triangle of a 'rows x 'rows matrix,
+     stored by rows (element (i,j) with j<=i is at i*(i+1)/2+j).
+   RESULTS_HERMETIAN: a 'rows x 'rows hermetian matrix stored as
+     a hermetian_matrix_type is: for i>j, the real part of element (i,j)
+     is at j*rows+i and the imaginary part at i*rows+j.
+*********/
+#define RESULTS_DENSE 0
+#define RESULTS_SYMMETRIC 1
+#define RESULTS_HERMETIAN 2
+
+typedef struct {
+  char magic[8];
+  int version;
+  int byte_order;
+} results_header_type;
+
+typedef struct {
+  char name[RESULTS_NAME_LEN];
+  int type;
+  int layout;
+  int step;
+  int kpoint;
+  int index;
+  int rows, cols;
+  int num_elements;
+} results_chunk_type;
+
+/********
+  the chunks can also be kept in memory (see results_start_capture),
+  in which case they end up in a linked list of these, in the order
+  they were written.
+*********/
+typedef struct results_list_def results_list_type;
+
+struct results_list_def {
+  results_chunk_type chunk;
+  void *data;
+  results_list_type *next;
+};
+
+#endif
@@ -41,155 +41,6 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "bind.h"
 #include "symmetry.h"
 
-/****************************************************************************
-*
-*                   Procedure   reduce_kpoints
-*
-* Arguments:  details: pointer to detail_type
-*                cell: pointer to cell_type
-*          raw_points: pointer to point_type
-*      num_raw_points: int
-*        multiplicity: pointer to real
-*          num_points: pointer to int
-*       nonortho_axes: int
-*
-* Returns: none
-*
-* Action: uses the symmetry operations of 'cell
-*   to reduce the number
-*   of k points in 'raw_points.  the multiplicity of each point is returned
-*   in 'multiplicity.  If a point has an initial multiplicity of -1, it
-*   will be ignored here.
-*  The final number of points is returned in 'num_points.
-*
-*  If 'nonortho_axes is non-zero then the points are transformed
-*   into the cartesian basis before the comparisons are done.
-*
-*  NOTE:  This code is actually not correct in the general case where the
-*   three lattice vectors do not point along the cartesian axes.  Luckily,
-*   since the code which finds the symmetry elements is too stupid to find
-*   any elements that don't lie along axes, this will work.
-*   ah... the joys of stupid code.  :-)
-*
-****************************************************************************/
-void reduce_kpoints(detail_type *details,cell_type *cell,
-                    point_type *raw_points,int num_raw_points,
-                    real *multiplicity,int *num_points,
-                    int nonortho_axes)
-{
-  int p1,p2;
-  int i,j;
-  point_type *new_points,*orig_points;
-  sym_op_type *this_op;
-
-  new_points = (point_type *)my_calloc(num_raw_points,sizeof(point_type));
-  if(!new_points) fatal("reduce_kpoints can't allocate new_points");
-
-  /* initialize the multiplicities of nonredundant points to 1 */
-  for(p1=0;p1<num_raw_points;p1++){
-    if(multiplicity[p1] != -1) multiplicity[p1] = 1;
-  }
-
-  /* transform the points to cartesians if necessary */
-  if( nonortho_axes ){
-    orig_points = (point_type *)my_calloc(num_raw_points,sizeof(point_type));
-    if(!new_points) fatal("reduce_orthogonal_kpoints can't allocate orig_points");
-    bcopy((char *)raw_points,(char *)orig_points,
-          num_raw_points*sizeof(point_type));
-    for(p1=0;p1<num_raw_points;p1++){
-      if(multiplicity[p1] != -1){
-        raw_points[p1].x = orig_points[p1].x * cell->recip_vects[0].x +
-           orig_points[p1].y * cell->recip_vects[1].x +
-             orig_points[p1].z * cell->recip_vects[2].x;
-        raw_points[p1].y = orig_points[p1].x * cell->recip_vects[0].y +
-           orig_points[p1].y * cell->recip_vects[1].y +
-             orig_points[p1].z * cell->recip_vects[2].y;
-        raw_points[p1].z = orig_points[p1].x * cell->recip_vects[0].z +
-           orig_points[p1].y * cell->recip_vects[1].z +
-             orig_points[p1].z * cell->recip_vects[2].z;
-      }
-    }
-  }
-
-  /* until I get off my butt and fix it, sym_ops_present is a global... ew */
-  this_op = sym_ops_present;
-  while(this_op){
-    if( this_op->type != Identity && !this_op->redundant ){
-      bcopy((char *)raw_points,(char *)new_points,
-            num_raw_points*sizeof(point_type));
-      for(p1 = 0;p1<num_raw_points;p1++){
-        if( multiplicity[p1] > 0 ){
-          if( this_op->type == Rotation || this_op->type == Improper_Rotation ){
-            /* do all the rotations */
-            for(i=1;i<this_op->order;i++){
-              transform_one_point(&(new_points[p1]),this_op->t_mat);
-              /* loop over the other points and see if we can find a match */
-              for(p2 = p1+1;p2<num_raw_points;p2++){
-                if( multiplicity[p2] > 0 &&
-                   POINTS_ARE_THE_SAME(&(new_points[p1]),&(raw_points[p2]),
-                                       details->symm_tol)){
-                  multiplicity[p1] += multiplicity[p2];
-                  multiplicity[p2] = 0;
-                }
-              }
-            }
-          } else {
-            /* it's not a rotation, so we just need to do one transformation */
-            transform_one_point(&(new_points[p1]),this_op->t_mat);
-            /* loop over the other points and see if we can find a match */
-            for(p2 = p1+1;p2<num_raw_points;p2++){
-              if( multiplicity[p2] > 0 &&
-                 POINTS_ARE_THE_SAME(&(new_points[p1]),&(raw_points[p2]),
-                                     details->symm_tol)){
-                multiplicity[p1] += multiplicity[p2];
-                multiplicity[p2] = 0;
-              }
-            }
-          }
-        }
-      }
-    }
-    this_op = this_op->next;
-  }
-  /* copy back in the original coordinates if needed */
-  if( nonortho_axes ){
-    bcopy((char *)orig_points,(char *)raw_points,
-          num_raw_points*sizeof(point_type));
-  }
-  /* run through, eliminate -k if k is present, and count the points */
-  *num_points = 0;
-  for(p1 = 0; p1<num_raw_points; p1++){
-    if( multiplicity[p1] > 0 ){
-      for(p2 = p1+1; p2<num_raw_points; p2++){
-        if( multiplicity[p2] > 0 ){
-          new_points[0].x = -raw_points[p2].x;
-          new_points[0].y = -raw_points[p2].y;
-          new_points[0].z = -raw_points[p2].z;
-          if( POINTS_ARE_THE_SAME(&(raw_points[p1]),&(new_points[0]),
-                                  details->symm_tol)){
-            multiplicity[p1] += multiplicity[p2];
-            multiplicity[p2] = 0;
-          }
-        }
-      }
-      (*num_points)++;
-    }
-  }
-  free(new_points);
-  if(nonortho_axes) free(orig_points);
-
-  /* the last bit is to reduce the weights of points at zone edges/corners */
-  if(details->use_high_symm_p){
-    for(p1=0;p1<num_raw_points;p1++){
-      if( multiplicity[p1] > 0 ){
-        if( fabs(raw_points[p1].x) == 0.5 ) multiplicity[p1] /= 2.0;
-        if( fabs(raw_points[p1].y) == 0.5 ) multiplicity[p1] /= 2.0;
-        if( fabs(raw_points[p1].z) == 0.5 ) multiplicity[p1] /= 2.0;
-      }
-    }
-  }
-}
-
 /****************************************************************************
 *
 *                   Function check_for_orthogonal_basis
@@ -551,3 +402,131 @@ void compare_crystal_basis(cell_type *cell,point_type *locs1,point_type *locs2,
   *present = 1;
 }
 
+
+
+/****************************************************************************
+*
+*                   Function star_needs_unfolding
+*
+* Arguments:  kpoint: pointer to k_point_type
+*
+* Returns: int
+*
+* Action: returns nonzero if the star of 'kpoint contains any members
+*   which were generated by a spatial symmetry operation.
+*
+*   Members generated only by time reversal don't need to be unfolded:
+*   the orbital projections and overlap populations of psi* at -k are
+*   the same as those of psi at k.
+*
+****************************************************************************/
+int star_needs_unfolding(k_point_type *kpoint)
+{
+  int i;
+
+  if( !kpoint->star ) return(0);
+  for(i=1;i<kpoint->num_in_star;i++){
+    if( kpoint->star[i].op ) return(1);
+  }
+  return(0);
+}
+
+/****************************************************************************
+*
+*                   Procedure unfold_star_orbital
+*
+* Arguments:     cell: pointer to cell_type
+*            num_orbs: int
+*              kpoint: pointer to k_point_type
+*        vectR, vectI: pointers to real
+*        starR, starI: pointers to real
+*          use_phases: char
+*
+* Returns: none
+*
+* Action: generates the crystal orbital (vectR + i vectI) at every
+*   member of the star of 'kpoint.  The coefficients for member m are
+*   stored in starR[m*num_orbs] and starI[m*num_orbs], member 0 is just
+*   a copy of the orbital.
+*
+*   For a member generated from its parent by the operation g, the block
+*   of coefficients on atom b = g(a) is  D(g) c_a exp(-i k.t_a)
+*   where D(g) is applied with transform_orbitals, k is the location of
+*   the member and t_a is the lattice translation in g(r_a) = r_b + t_a
+*   (found using the reciprocal lattice vectors).
+*   Members generated by time reversal are complex conjugates of their
+*   parents.
+*
+*   If 'use_phases is zero the phase factors are left out, that's
+*   fine for anything (like Mulliken populations) that only depends on
+*   products of coefficients on the same atom.
+*
+****************************************************************************/
+void unfold_star_orbital(cell_type *cell,int num_orbs,k_point_type *kpoint,
+                         real *vectR,real *vectI,real *starR,real *starI,
+                         char use_phases)
+{
+  int i,j,m,begin,end,dest;
+  real phase,cos_phase,sin_phase,tempR;
+  real t[3];
+  point_type loc;
+  real *parentR,*parentI,*memberR,*memberI;
+  k_star_type *member;
+
+  bcopy((char *)vectR,(char *)starR,num_orbs*sizeof(real));
+  bcopy((char *)vectI,(char *)starI,num_orbs*sizeof(real));
+  if( !kpoint->star ) return;
+
+  for(m=1;m<kpoint->num_in_star;m++){
+    member = &(kpoint->star[m]);
+    parentR = &(starR[member->from*num_orbs]);
+    parentI = &(starI[member->from*num_orbs]);
+    memberR = &(starR[m*num_orbs]);
+    memberI = &(starI[m*num_orbs]);
+
+    /* time reversal */
+    if( !member->op ){
+      for(j=0;j<num_orbs;j++){
+        memberR[j] = parentR[j];
+        memberI[j] = -parentI[j];
+      }
+      continue;
+    }
+
+    for(i=0;i<cell->num_atoms;i++){
+      find_atoms_orbs(num_orbs,cell->num_atoms,i,orbital_lookup_table,
+                      &begin,&end);
+      if( begin < 0 ) continue;
+      dest = orbital_lookup_table[member->op->equiv_atoms[i]];
+      bcopy((char *)&(parentR[begin]),(char *)&(memberR[dest]),
+            (end-begin)*sizeof(real));
+      bcopy((char *)&(parentI[begin]),(char *)&(memberI[dest]),
+            (end-begin)*sizeof(real));
+      transform_orbitals(&(cell->atoms[i]),&(memberR[dest]),member->op);
+      transform_orbitals(&(cell->atoms[i]),&(memberI[dest]),member->op);
+
+      if( use_phases ){
+        loc = cell->atoms[i].loc;
+        transform_one_point(&loc,member->op->t_mat);
+        loc.x -= cell->atoms[member->op->equiv_atoms[i]].loc.x;
+        loc.y -= cell->atoms[member->op->equiv_atoms[i]].loc.y;
+        loc.z -= cell->atoms[member->op->equiv_atoms[i]].loc.z;
+        t[0] = t[1] = t[2] = 0.0;
+        for(j=0;j<cell->dim;j++){
+          t[j] = floor(dot_prod(&loc,&(cell->recip_vects[j]))+0.5);
+        }
+        phase = -TWOPI*(member->loc.x*t[0] + member->loc.y*t[1] +
+                        member->loc.z*t[2]);
+        if( phase != 0.0 ){
+          cos_phase = cos(phase);
+          sin_phase = sin(phase);
+          for(j=dest;j<dest+end-begin;j++){
+            tempR = memberR[j]*cos_phase - memberI[j]*sin_phase;
+            memberI[j] = memberR[j]*sin_phase + memberI[j]*cos_phase;
+            memberR[j] = tempR;
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,437 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/********************************************************************************
+*
+*     this file contains the radial part of the overlap between two
+*      Slater type orbitals.
+*
+*   This does the same thing as the old abfns and lovlap routines (which
+*    are kept around as a reference for bench_sto), but:
+*
+*    - a whole batch of (distance, exponent pair) inputs is done at once.
+*      The A and B functions are stored with the batch index varying
+*      fastest, so the inner loops run over the batch and vectorize.
+*
+*    - lovlap's six nested loops over binomial coefficients are a product
+*      of binomial expansions, so they are regrouped into a short double
+*      sum (see sto_radial_overlaps).  The distance derivatives come from
+*      the same sum.
+*
+*    - the binomial coefficients and factorials are constant tables, and
+*      exp(-rho1) and exp(rho2) are evaluated once per input and shared
+*      by every m, and by the derivative.
+*
+*    - there are no non-constant statics, so it's safe to call from
+*      several threads at once.
+*
+********************************************************************************/
+#include "bind.h"
+
+/* bincoe[i][j] is j choose i */
+static const real bincoe[8][8] = {
+  {1,1,1,1,1,1,1,1},
+  {0,1,2,3,4,5,6,7},
+  {0,0,1,3,6,10,15,21},
+  {0,0,0,1,4,10,20,35},
+  {0,0,0,0,1,5,15,35},
+  {0,0,0,0,0,1,6,21},
+  {0,0,0,0,0,0,1,7},
+  {0,0,0,0,0,0,0,1}
+};
+
+/* factorials, enough for principal quantum numbers up to 7 */
+static const real fact[15] = {
+  1.0,1.0,2.0,6.0,24.0,120.0,720.0,5040.0,40320.0,362880.0,3628800.0,
+  39916800.0,479001600.0,6227020800.0,87178291200.0
+};
+
+/********************************************************************************
+*
+*                   Procedure b_functions
+*
+* Arguments: rho2: real
+*             max: int
+*               B: pointer to real
+*          stride: int
+*
+* Returns: none
+*
+* Action:  fills B[0], B[stride], ... B[max*stride] with the B functions
+*   of argument 'rho2.  This is the B half of abfns, step for step, so the
+*   results are the same.
+*
+*   Upward recurrence is only stable for a few steps (about 2|rho2|), so
+*   every so often the next function is found by summing its series
+*   instead.
+*
+********************************************************************************/
+static void b_functions(real rho2,int max,real *B,int stride)
+{
+  int num_B;
+  int i,j,k,ir,is,in;
+  real d,h,r,ra,rho22,t,tr;
+
+  num_B = max+1;
+  if( rho2 == 0 ){
+    /* the argument is zero, use the closed form */
+    for(i=1;i<=num_B;i+=2){
+      B[(i-1)*stride] = 2.0/(real)i;
+      if( i < num_B ) B[i*stride] = 0.0;
+    }
+    return;
+  }
+
+  ir = fabs(2.0*rho2);
+  is = ir+1;
+  if( is > 19 ) is = 19;
+  d = exp(rho2);
+  h = 1.0/d;
+  r = d-h;
+
+  /* if rho2 is small the sinh has to come from its series */
+  if( fabs(r) < 0.1 ){
+    ra = rho2;
+    rho22 = rho2*rho2;
+    t = rho2;
+    for(i=2;i<=50;i+=2){
+      t = t*rho22/(real)(i*i+i);
+      ra = ra+t;
+      if( t < 1.e-30 ) break;
+    }
+    r = ra+ra;
+  }
+
+  B[0] = r/rho2;
+  for(i=2;i<=num_B;i+=is){
+    if( ir != 0 ){
+      for(j=1;j<is;j++){
+        k = i+j-1;
+        if( k > num_B ) break;
+        if( k%2 == 0 ) B[(k-1)*stride] = -((d+h-(real)(k-1)*B[(k-2)*stride])/rho2);
+        else B[(k-1)*stride] = (r+(real)(k-1)*B[(k-2)*stride])/rho2;
+      }
+    }
+    in = i+is-1;
+    if( in > num_B ) break;
+
+    /* the next one comes from summing the series */
+    if( in%2 ){
+      tr = 1.0;
+      B[(in-1)*stride] = 2.0*tr/(real)in;
+      for(j=1;j<=500;j++){
+        tr = tr*rho2*rho2/(real)(2*j*(2*j-1));
+        if( fabs(tr/B[(in-1)*stride]) <= 1.0e-7 ) break;
+        B[(in-1)*stride] += 2.0*tr/(real)(in+2*j);
+      }
+    }
+    else{
+      tr = rho2;
+      B[(in-1)*stride] = -(2.0*tr/(real)(in+1));
+      for(j=1;j<=500;j++){
+        tr = tr*rho2*rho2/(real)(2*j*(2*j+1));
+        if( fabs(tr/B[(in-1)*stride]) <= 1.0e-7 ) break;
+        B[(in-1)*stride] -= 2.0*tr/(real)(in+1+2*j);
+      }
+    }
+  }
+}
+
+
+/********************************************************************************
+*
+*                   Procedure sto_ab_functions
+*
+* Arguments: num: int
+*      rho1,rho2: pointers to real
+*            max: int
+*            A,B: pointers to real
+*
+* Returns: none
+*
+* Action:  evaluates the A and B auxiliary functions A_0..A_max and
+*   B_0..B_max for 'num pairs of arguments at once.  A_k of input e goes
+*   in A[k*num+e] (same for B), so each array needs (max+1)*num elements.
+*
+*   Inputs where either argument is larger than 165 in magnitude get
+*   all zeros, as in abfns.
+*
+********************************************************************************/
+void sto_ab_functions(int num,real *rho1,real *rho2,int max,real *A,real *B)
+{
+  real c[STO_BATCH_SIZE];
+  int base,batch_end;
+  int e,k;
+
+  for(base=0;base<num;base+=STO_BATCH_SIZE){
+    batch_end = base+STO_BATCH_SIZE;
+    if( batch_end > num ) batch_end = num;
+
+    /* the A functions: one exponential each, then upward recurrence */
+    for(e=base;e<batch_end;e++){
+      c[e-base] = exp(-rho1[e]);
+      A[e] = c[e-base]/rho1[e];
+    }
+    for(k=1;k<=max;k++){
+      for(e=base;e<batch_end;e++){
+        A[k*num+e] = ((real)k*A[(k-1)*num+e]+c[e-base])/rho1[e];
+      }
+    }
+  }
+
+  for(e=0;e<num;e++){
+    /* zero anything which is out of range */
+    if( fabs(rho1[e]) > 165.0 || fabs(rho2[e]) > 165.0 ){
+      for(k=0;k<=max;k++) A[k*num+e] = B[k*num+e] = 0.0;
+    }
+    else b_functions(rho2[e],max,B+e,num);
+  }
+}
+
+
+/********************************************************************************
+*
+*                   Procedure binomial_product
+*
+* Arguments: poly: pointer to real
+*            N1,N2: int
+*            sign1,sign2: int
+*
+* Returns: none
+*
+* Action:  fills poly[0..N1+N2] with the coefficients of
+*     (1 + sign1 t)^N1 (1 + sign2 t)^N2
+*   by powers of t.  sign1 and sign2 should be 1 or -1.
+*
+********************************************************************************/
+static void binomial_product(real *poly,int N1,int N2,int sign1,int sign2)
+{
+  int i,j,k;
+  real val;
+
+  for(k=0;k<=N1+N2;k++){
+    poly[k] = 0.0;
+    for(i=0;i<=N1 && i<=k;i++){
+      j = k-i;
+      if( j > N2 ) continue;
+      val = bincoe[i][N1]*bincoe[j][N2];
+      if( (sign1 < 0 && i%2) != (sign2 < 0 && j%2) ) val = -val;
+      poly[k] += val;
+    }
+  }
+}
+
+
+/********************************************************************************
+*
+*                   Procedure sto_radial_overlaps
+*
+* Arguments: overlaps: pointer to real
+*                 num: int
+*         dist,sk1,sk2: pointers to real
+*          n1,n2,l1,l2: int
+*           derivative: char
+*
+* Returns: none
+*
+* Action:  evaluates the sigma, pi, delta and phi overlaps between a
+*   Slater orbital (n1,l1) with exponent sk1[e] and one (n2,l2) with
+*   exponent sk2[e] a distance dist[e] (in bohr) apart, for e = 0..num-1.
+*   Component m of input e goes in overlaps[m*num+e]; components with
+*   m larger than l1 or l2 are zero.
+*
+*   If 'derivative is set the derivatives with respect to the distance
+*   are returned instead.  The prefactor goes as dist^(n1+n2+1) and
+*   dA_k/drho = -A_(k+1) (same for B), so these come from the same sums
+*   with the A (or B) functions shifted by one.
+*
+*   For each (j,k) pair in lovlap, the six inner loops over binomial
+*   coefficients are the expansion of
+*
+*     (x+y)^Nab (x-y)^Nbb (1+xy)^Ncb (xy-1)^Ndb (x^2-1)^m (y^2-1)^m
+*
+*   with the power of x giving the A function and the power of y the B
+*   function which multiply each term.  Here the last two factors are
+*   folded into the A and B functions (once for each m), the first two
+*   collapse to a single polynomial in x/y and the middle two to one in
+*   xy, which leaves a short double sum.  This is the same sum as lovlap
+*   with the terms added in a different order.
+*
+********************************************************************************/
+void sto_radial_overlaps(real *overlaps,int num,real *dist,real *sk1,real *sk2,
+                         int n1,int n2,int l1,int l2,char derivative)
+{
+  real rho1[STO_BATCH_SIZE],rho2[STO_BATCH_SIZE];
+  real A[STO_MAX_AB*STO_BATCH_SIZE],B[STO_MAX_AB*STO_BATCH_SIZE];
+  real Am_space[STO_MAX_AB*STO_BATCH_SIZE],Bm_space[STO_MAX_AB*STO_BATCH_SIZE];
+  real *Am,*Bm;
+  real rhopo[STO_BATCH_SIZE],norm,terma,K;
+  real rhoa,rhob,rhoap,rhoab;
+  real value[STO_BATCH_SIZE],A_term[STO_BATCH_SIZE],B_term[STO_BATCH_SIZE];
+  real hom[STO_MAX_AB],zpoly[STO_MAX_AB],mpoly[4];
+  real *Am_vals,*Bm_vals;
+  real con1,con12,coeff;
+  int max,max_AB,nn,num_m;
+  int jend,kend,ju,ku;
+  int Nab,Nbb,Ncb,Ndb,H,Z;
+  int base,batch;
+  int e,m,c,i,k,t;
+
+  max = n1+n2;
+  if( derivative ) max_AB = max+1;
+  else max_AB = max;
+  if( max_AB >= STO_MAX_AB ) FATAL_BUG("Quantum numbers too large in sto_radial_overlaps.");
+
+  if( l1 > l2 ) nn = l2;
+  else nn = l1;
+
+  /* this is 0.5^(l1+l2+1) */
+  norm = 1.0/(real)(1<<(l1+l2+1));
+
+  for(base=0;base<num;base+=STO_BATCH_SIZE){
+    batch = num-base;
+    if( batch > STO_BATCH_SIZE ) batch = STO_BATCH_SIZE;
+
+    for(e=0;e<batch;e++){
+      rho1[e] = 0.5*(sk1[base+e]+sk2[base+e])*dist[base+e];
+      rho2[e] = 0.5*(sk1[base+e]-sk2[base+e])*dist[base+e];
+    }
+    sto_ab_functions(batch,rho1,rho2,max_AB,A,B);
+
+    /* the distance dependent part of the prefactor is the same for each m */
+    for(e=0;e<batch;e++){
+      rhoa = dist[base+e]*sk1[base+e];
+      rhob = dist[base+e]*sk2[base+e];
+      rhoap = pow(rhoa,(real)n1);
+      rhoap = rhoap*rhoap*rhoa;
+      rhoab = pow(rhob,(real)n2);
+      rhoab = rhoab*rhoab*rhob;
+      rhopo[e] = rhoap*rhoab;
+    }
+
+    for(m=0;m<4;m++){
+      if( m > nn ){
+        for(e=0;e<batch;e++) overlaps[m*num+base+e] = 0.0;
+        continue;
+      }
+
+      /*
+        fold (x^2-1)^m and (y^2-1)^m into the A and B functions
+        (there's nothing to do for sigma)
+      */
+      if( m == 0 ){
+        Am = A;
+        Bm = B;
+      }
+      else{
+        Am = Am_space;
+        Bm = Bm_space;
+        for(c=0;c<=m;c++){
+          mpoly[c] = bincoe[c][m];
+          if( (m-c)%2 ) mpoly[c] = -mpoly[c];
+        }
+        num_m = max_AB-m-m;
+        for(t=0;t<=num_m;t++){
+          for(e=0;e<batch;e++){
+            Am[t*batch+e] = mpoly[0]*A[t*batch+e];
+            Bm[t*batch+e] = mpoly[0]*B[t*batch+e];
+          }
+          for(c=1;c<=m;c++){
+            for(e=0;e<batch;e++){
+              Am[t*batch+e] += mpoly[c]*A[(t+c+c)*batch+e];
+              Bm[t*batch+e] += mpoly[c]*B[(t+c+c)*batch+e];
+            }
+          }
+        }
+      }
+
+      for(e=0;e<batch;e++){
+        value[e] = A_term[e] = B_term[e] = 0.0;
+      }
+      jend = 1+(l1-m)/2;
+      kend = 1+(l2-m)/2;
+      for(ju=0;ju<jend;ju++){
+        Nab = n1-l1+ju+ju;
+        Ncb = l1-m-ju-ju;
+        con1 = fact[l1+l1-ju-ju]/(fact[l1-m-ju-ju]*fact[ju]*fact[l1-ju]);
+        for(ku=0;ku<kend;ku++){
+          con12 = con1*fact[l2+l2-ku-ku]/(fact[l2-m-ku-ku]*fact[ku]*fact[l2-ku]);
+          if( (ju+ku+l2)%2 ) con12 = -con12;
+          Nbb = n2-l2+ku+ku;
+          Ndb = l2-m-ku-ku;
+
+          /*
+            (x+y)^Nab (x-y)^Nbb: hom[k] multiplies x^(H-k) y^k
+            (1+xy)^Ncb (xy-1)^Ndb: zpoly[i] multiplies (xy)^(Z-i)
+          */
+          H = Nab+Nbb;
+          binomial_product(hom,Nab,Nbb,1,-1);
+          Z = Ncb+Ndb;
+          binomial_product(zpoly,Ncb,Ndb,1,-1);
+
+          for(k=0;k<=H;k++){
+            if( hom[k] == 0.0 ) continue;
+            for(i=0;i<=Z;i++){
+              coeff = con12*hom[k]*zpoly[i];
+              if( coeff == 0.0 ) continue;
+              Am_vals = Am + (H-k+Z-i)*batch;
+              Bm_vals = Bm + (k+Z-i)*batch;
+              for(e=0;e<batch;e++){
+                value[e] += coeff*Am_vals[e]*Bm_vals[e];
+              }
+              if( derivative ){
+                for(e=0;e<batch;e++){
+                  A_term[e] += coeff*Am_vals[e+batch]*Bm_vals[e];
+                  B_term[e] += coeff*Am_vals[e]*Bm_vals[e+batch];
+                }
+              }
+            }
+          }
+        }
+      }
+
+      K = (real)((l1+l1+1)*(l2+l2+1))*fact[l1-m]*fact[l2-m]/
+        (fact[n1+n1]*fact[n2+n2]*fact[l1+m]*fact[l2+m]);
+      for(e=0;e<batch;e++){
+        terma = norm*sqrt(K*rhopo[e]);
+        if( derivative ){
+          overlaps[m*num+base+e] = terma*((real)(max+1)*value[e]/dist[base+e] -
+                                          0.5*(sk1[base+e]+sk2[base+e])*A_term[e] -
+                                          0.5*(sk1[base+e]-sk2[base+e])*B_term[e]);
+        }
+        else{
+          overlaps[m*num+base+e] = terma*value[e];
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,598 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+
+/****************************************************************************
+*
+*     this file contains the code for diagonalizing molecular Hamiltonians
+*      in a symmetry adapted basis.
+*
+*   The symmetry operations found by find_sym_ops which only change the
+*    signs of the coordinates (C2 axes and mirror planes on the cartesian
+*    axes, and the inversion center) form an abelian group with at most
+*    8 elements: D2h or one of its subgroups.  Each atomic orbital is
+*    carried into plus or minus a single orbital by these, so projecting
+*    the AOs onto the irreducible representations of the group gives
+*    symmetry adapted linear combinations (SALCs) with at most 8 terms.
+*
+*   In the SALC basis H and S are block diagonal, one block per irrep,
+*    and each block is diagonalized on its own.  The MOs are labelled
+*    with the irrep of the block they came from.
+*
+*****************************************************************************/
+
+#include "bind.h"
+#include "symmetry.h"
+
+/* the largest number of operations in the group (D2h) */
+#define MAX_SIGN_OPS 8
+
+/* used to decide if a transformation matrix element is 0 or +/-1 */
+#define SIGN_OP_TOL 1e-6
+
+typedef struct {
+  int block;
+  int num_terms;
+  int AO[MAX_SIGN_OPS];
+  real coeff[MAX_SIGN_OPS];
+} SALC_type;
+
+static char sym_blocks_built=0;
+static int sym_blocks_num_orbs=0;
+static int num_sym_blocks=0;
+static int sym_block_size[MAX_SIGN_OPS];
+static int sym_block_begin[MAX_SIGN_OPS];
+static char *sym_block_label[MAX_SIGN_OPS];
+static SALC_type *SALCs=0;
+static int *MO_blocks=0;
+static char MOs_are_blocked=0;
+
+/* names of the functions with each set of sign changes (x=1, y=2, z=4) */
+static char *sign_function_names[8]={"1","x","y","xy","z","xz","yz","xyz"};
+
+/* element i,j of a hermetian matrix stored in the usual way */
+#define HERM_ELEMENT(mat,dim,i,j) ((j) > (i) ? (mat)[(i)*(dim)+(j)] : (mat)[(j)*(dim)+(i)])
+
+
+/****************************************************************************
+*
+*                   Function parity
+*
+* Arguments: bits: int
+*
+* Returns: int
+*
+* Action: returns -1 if an odd number of bits are set in 'bits, 1 otherwise.
+*
+*****************************************************************************/
+static int parity(int bits)
+{
+  int result=1;
+
+  while(bits){
+    if( bits & 1 ) result = -result;
+    bits >>= 1;
+  }
+  return result;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure build_sym_blocks
+*
+* Arguments:  details: pointer to detail_type
+*                cell: pointer to cell_type
+*            num_orbs: int
+* orbital_lookup_table: pointer to int
+*
+* Returns: none
+*
+* Action: finds the group of sign change operations in sym_ops_present
+*   and builds the SALCs for each of its irreps.
+*
+*   If there's nothing to be gained, or the orbitals can't be handled,
+*    sym_blocks_num_orbs is left at zero.
+*
+*****************************************************************************/
+static void build_sym_blocks(detail_type *details,cell_type *cell,int num_orbs,
+                             int *orbital_lookup_table)
+{
+  sym_op_type *op;
+  sym_op_type *group[MAX_SIGN_OPS];
+  int masks[MAX_SIGN_OPS];
+  int chars[MAX_SIGN_OPS][MAX_SIGN_OPS];
+  int num_ops,mask;
+  int *AO_image,*AO_sign;
+  SALC_type *unsorted,*SALC;
+  real unit[END_D+1];
+  real norm;
+  char is_sign_op,found;
+  int i,j,k,l,b,v,bits;
+  int atom,begin,end,dest_atom;
+  int num_SALCs,AO,image;
+
+  sym_blocks_built = 1;
+  sym_blocks_num_orbs = 0;
+
+  if( cell->dim != 0 || !sym_ops_present ) return;
+
+  /******
+    the transformations needed for f orbitals aren't there
+  ******/
+  for(i=0;i<cell->num_atoms;i++){
+    if( cell->atoms[i].at_number >= 0 && cell->atoms[i].nf > 0 ){
+      fprintf(status_file,
+              "f orbitals are present, symmetry blocks won't be used.\n");
+      return;
+    }
+  }
+
+  /******
+    the atoms don't get moved into the principle axis frame during
+    a Walsh diagram.
+  ******/
+  if( details->walsh_details.num_vars ){
+    for(i=0;i<3;i++){
+      for(j=0;j<3;j++){
+        if( fabs(cell->princ_axes[i][j] - (i==j ? 1.0 : 0.0)) > SIGN_OP_TOL ){
+          fprintf(status_file,
+                  "Walsh diagram in the principle axis frame, symmetry blocks won't be used.\n");
+          return;
+        }
+      }
+    }
+  }
+
+  /******
+
+    collect the operations with diagonal transformation matrices.  masks[k]
+    has bit i set if operation k changes the sign of coordinate i.  the
+    identity is always first.
+
+  ******/
+  num_ops = 1;
+  group[0] = 0;
+  masks[0] = 0;
+  for(op=sym_ops_present;op;op=op->next){
+    if( !op->equiv_atoms ) continue;
+    is_sign_op = 1;
+    mask = 0;
+    for(i=0;i<3 && is_sign_op;i++){
+      for(j=0;j<3;j++){
+        if( i==j ){
+          if( fabs(fabs(op->t_mat[i][j]) - 1.0) > SIGN_OP_TOL ) is_sign_op = 0;
+          else if( op->t_mat[i][j] < 0.0 ) mask |= 1<<i;
+        } else if( fabs(op->t_mat[i][j]) > SIGN_OP_TOL ) is_sign_op = 0;
+      }
+    }
+    if( !is_sign_op || !mask ) continue;
+    found = 0;
+    for(k=0;k<num_ops;k++) if( masks[k] == mask ) found = 1;
+    if( found ) continue;
+    group[num_ops] = op;
+    masks[num_ops] = mask;
+    num_ops++;
+  }
+  if( num_ops == 1 ) return;
+
+  /* make sure it's a group */
+  for(i=0;i<num_ops;i++){
+    for(j=0;j<num_ops;j++){
+      found = 0;
+      for(k=0;k<num_ops;k++) if( masks[k] == (masks[i]^masks[j]) ) found = 1;
+      if( !found ){
+        fprintf(status_file,
+                "The sign change operations don't form a group, symmetry blocks won't be used.\n");
+        return;
+      }
+    }
+  }
+
+  /******
+
+    the irreps.  each one has the characters of some product of x, y
+    and z, use the simplest product to label it.
+
+  ******/
+  num_sym_blocks = 0;
+  for(bits=0;bits<=3;bits++){
+    for(v=0;v<8;v++){
+      if( (v&1) + ((v>>1)&1) + ((v>>2)&1) != bits ) continue;
+      for(k=0;k<num_ops;k++) chars[num_sym_blocks][k] = parity(v & masks[k]);
+      found = 0;
+      for(b=0;b<num_sym_blocks && !found;b++){
+        found = 1;
+        for(k=0;k<num_ops;k++){
+          if( chars[b][k] != chars[num_sym_blocks][k] ) found = 0;
+        }
+      }
+      if( !found ){
+        sym_block_label[num_sym_blocks] = sign_function_names[v];
+        num_sym_blocks++;
+      }
+    }
+  }
+
+  /******
+
+    find where each AO goes under each operation, and its sign there.
+
+  ******/
+  AO_image = (int *)calloc(2*num_orbs*num_ops,sizeof(int));
+  /* the extra SALC is scratch space for projections that vanish */
+  unsorted = (SALC_type *)calloc(num_orbs+1,sizeof(SALC_type));
+  if( !AO_image || !unsorted ) fatal("Can't allocate memory in build_sym_blocks.");
+  AO_sign = AO_image + num_orbs*num_ops;
+
+  for(atom=0;atom<cell->num_atoms;atom++){
+    find_atoms_orbs(num_orbs,cell->num_atoms,atom,orbital_lookup_table,&begin,&end);
+    if( begin < 0 ) continue;
+    for(l=0;l<end-begin;l++){
+      AO = begin+l;
+      for(k=0;k<num_ops;k++){
+        if( !group[k] ){
+          AO_image[AO*num_ops+k] = AO;
+          AO_sign[AO*num_ops+k] = 1;
+          continue;
+        }
+        dest_atom = group[k]->equiv_atoms[atom];
+        bzero((char *)unit,(END_D+1)*sizeof(real));
+        unit[l] = 1.0;
+        transform_orbitals(&(cell->atoms[atom]),unit,group[k]);
+        for(i=0;i<end-begin;i++){
+          if( (i == l && fabs(fabs(unit[i]) - 1.0) > SIGN_OP_TOL) ||
+              (i != l && fabs(unit[i]) > SIGN_OP_TOL) ){
+            FATAL_BUG("A sign change operation mixes orbitals in build_sym_blocks.");
+          }
+        }
+        AO_image[AO*num_ops+k] = orbital_lookup_table[dest_atom]+l;
+        AO_sign[AO*num_ops+k] = unit[l] > 0.0 ? 1 : -1;
+      }
+    }
+  }
+
+  /******
+
+    project each orbit of AOs onto the irreps.  the first AO of the orbit
+    is used, so each SALC is only made once.
+
+  ******/
+  num_SALCs = 0;
+  for(AO=0;AO<num_orbs;AO++){
+    found = 0;
+    for(k=0;k<num_ops;k++) if( AO_image[AO*num_ops+k] < AO ) found = 1;
+    if( found ) continue;
+
+    for(b=0;b<num_sym_blocks;b++){
+      SALC = &(unsorted[num_SALCs]);
+      SALC->num_terms = 0;
+      for(k=0;k<num_ops;k++){
+        image = AO_image[AO*num_ops+k];
+        for(i=0;i<SALC->num_terms && SALC->AO[i] != image;i++);
+        if( i == SALC->num_terms ){
+          SALC->AO[i] = image;
+          SALC->coeff[i] = 0.0;
+          SALC->num_terms++;
+        }
+        SALC->coeff[i] += (real)(chars[b][k]*AO_sign[AO*num_ops+k]);
+      }
+      norm = 0.0;
+      for(i=0;i<SALC->num_terms;i++) norm += SALC->coeff[i]*SALC->coeff[i];
+
+      /* the coefficients are integers, so this is either 0 or at least 1 */
+      if( norm < 0.5 ) continue;
+
+      /* drop the zeros */
+      norm = 1.0/sqrt(norm);
+      j = 0;
+      for(i=0;i<SALC->num_terms;i++){
+        if( fabs(SALC->coeff[i]) > 0.5 ){
+          SALC->AO[j] = SALC->AO[i];
+          SALC->coeff[j] = SALC->coeff[i]*norm;
+          j++;
+        }
+      }
+      SALC->num_terms = j;
+      SALC->block = b;
+      num_SALCs++;
+      if( num_SALCs > num_orbs ) FATAL_BUG("Too many SALCs in build_sym_blocks.");
+    }
+  }
+  if( num_SALCs != num_orbs ) FATAL_BUG("Too few SALCs in build_sym_blocks.");
+
+  /* sort the SALCs by block */
+  if( SALCs ) free(SALCs);
+  if( MO_blocks ) free(MO_blocks);
+  SALCs = (SALC_type *)calloc(num_orbs,sizeof(SALC_type));
+  MO_blocks = (int *)calloc(num_orbs,sizeof(int));
+  if( !SALCs || !MO_blocks ) fatal("Can't allocate memory in build_sym_blocks.");
+  j = 0;
+  for(b=0;b<num_sym_blocks;b++){
+    sym_block_begin[b] = j;
+    for(i=0;i<num_orbs;i++){
+      if( unsorted[i].block == b ){
+        bcopy((char *)&(unsorted[i]),(char *)&(SALCs[j]),sizeof(SALC_type));
+        j++;
+      }
+    }
+    sym_block_size[b] = j - sym_block_begin[b];
+  }
+  free(unsorted);
+  free(AO_image);
+
+  fprintf(output_file,"\n; The Hamiltonian will be diagonalized in %d symmetry blocks:\n",
+          num_sym_blocks);
+  fprintf(output_file,";  block  transforms like  size\n");
+  for(b=0;b<num_sym_blocks;b++){
+    fprintf(output_file,";  %3d    %-14s  %d\n",b+1,sym_block_label[b],
+            sym_block_size[b]);
+  }
+  sym_blocks_num_orbs = num_orbs;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure free_sym_blocks
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: throws away the SALCs so that they'll be rebuilt the next
+*   time sym_block_diagonalize is called.
+*
+*****************************************************************************/
+void free_sym_blocks()
+{
+  if( SALCs ) free(SALCs);
+  if( MO_blocks ) free(MO_blocks);
+  SALCs = 0;
+  MO_blocks = 0;
+  sym_blocks_built = 0;
+  sym_blocks_num_orbs = 0;
+  num_sym_blocks = 0;
+  MOs_are_blocked = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Function sym_block_diagonalize
+*
+* Arguments:  details: pointer to detail_type
+*                cell: pointer to cell_type
+*            num_orbs: int
+* orbital_lookup_table: pointer to int
+*      overlap, hamil: hermetian_matrix_type
+*            eigenset: eigenset_type
+*          diag_error: pointer to int
+*
+* Returns: char
+*
+* Action: solves H C = S C E one symmetry block at a time and puts the
+*   results (sorted by energy) in 'eigenset.  'overlap and 'hamil aren't
+*   modified.
+*
+*   Returns 0 without doing anything if there are no symmetry blocks to
+*    use, in which case the full matrices need to be diagonalized.
+*
+*   'diag_error is set to the error value from the diagonalizer (the
+*    first nonzero one if there are several).
+*
+*****************************************************************************/
+char sym_block_diagonalize(detail_type *details,cell_type *cell,int num_orbs,
+                           int *orbital_lookup_table,
+                           hermetian_matrix_type overlap,hermetian_matrix_type hamil,
+                           eigenset_type eigenset,int *diag_error)
+{
+  static real *block_H=0,*block_S=0,*block_work=0;
+  static real *block_vects=0,*block_vals=0;
+  static int work_size=0;
+#ifdef USE_LAPACK
+  static complex *cmplx_H=0,*cmplx_S=0,*cmplx_work=0;
+  char jobz='V',uplo='L';
+  int nb2;
+#endif
+  int max_size,tot_size,vect_offset[MAX_SIGN_OPS];
+  int pos[MAX_SIGN_OPS];
+  int b,nb,p,q,t,u,m,j,best,slot,num_frags,fail;
+  SALC_type *SALC_p,*SALC_q;
+  real H_elem,S_elem,coeff;
+  real *vect;
+
+  MOs_are_blocked = 0;
+  if( !sym_blocks_built ){
+    build_sym_blocks(details,cell,num_orbs,orbital_lookup_table);
+  }
+  if( sym_blocks_num_orbs != num_orbs ) return 0;
+
+  /* get space */
+  max_size = 0;
+  tot_size = 0;
+  for(b=0;b<num_sym_blocks;b++){
+    if( sym_block_size[b] > max_size ) max_size = sym_block_size[b];
+    vect_offset[b] = tot_size;
+    tot_size += sym_block_size[b]*sym_block_size[b];
+  }
+  if( work_size < max_size ){
+    if( block_H ) free(block_H);
+    if( block_vects ) free(block_vects);
+    block_H = (real *)calloc(4*max_size*max_size+2*max_size+num_orbs,sizeof(real));
+    block_vects = (real *)calloc(tot_size,sizeof(real));
+    if( !block_H || !block_vects )
+      fatal("Can't allocate memory in sym_block_diagonalize.");
+    block_S = block_H + max_size*max_size;
+    block_work = block_S + max_size*max_size;
+    block_vals = block_work + 2*max_size*max_size + 2*max_size;
+#ifdef USE_LAPACK
+    if( cmplx_H ) free(cmplx_H);
+    cmplx_H = (complex *)calloc(3*max_size*max_size,sizeof(complex));
+    if( !cmplx_H ) fatal("Can't allocate memory in sym_block_diagonalize.");
+    cmplx_S = cmplx_H + max_size*max_size;
+    cmplx_work = cmplx_S + max_size*max_size;
+#endif
+    work_size = max_size;
+  }
+
+  fprintf(status_file,"Diagonalizing %d symmetry blocks (largest is %d x %d).\n",
+          num_sym_blocks,max_size,max_size);
+
+  /* the overlap factors for the blocks go after those for the fragments */
+  num_frags = details->num_FMO_frags > details->num_FCO_frags ?
+    details->num_FMO_frags : details->num_FCO_frags;
+
+  *diag_error = 0;
+  for(b=0;b<num_sym_blocks;b++){
+    nb = sym_block_size[b];
+    if( !nb ) continue;
+
+    /******
+      build the blocks of H and S, real parts in the upper triangle
+      (imaginary parts, which are zero, in the lower).
+    ******/
+    for(p=0;p<nb;p++){
+      SALC_p = &(SALCs[sym_block_begin[b]+p]);
+      for(q=p;q<nb;q++){
+        SALC_q = &(SALCs[sym_block_begin[b]+q]);
+        H_elem = 0.0;
+        S_elem = 0.0;
+        for(t=0;t<SALC_p->num_terms;t++){
+          for(u=0;u<SALC_q->num_terms;u++){
+            coeff = SALC_p->coeff[t]*SALC_q->coeff[u];
+            H_elem += coeff*HERM_ELEMENT(hamil.mat,num_orbs,SALC_p->AO[t],SALC_q->AO[u]);
+            S_elem += coeff*HERM_ELEMENT(overlap.mat,num_orbs,SALC_p->AO[t],SALC_q->AO[u]);
+          }
+        }
+        block_H[p*nb+q] = H_elem;
+        block_H[q*nb+p] = p==q ? H_elem : 0.0;
+        if( details->diag_wo_overlap ) S_elem = p==q ? 1.0 : 0.0;
+        block_S[p*nb+q] = S_elem;
+        block_S[q*nb+p] = p==q ? S_elem : 0.0;
+      }
+    }
+
+    slot = (num_frags+1+b)*(details->num_KPOINTS ? details->num_KPOINTS : 1);
+    vect = &(block_vects[vect_offset[b]]);
+#ifndef USE_LAPACK
+    cached_cboris(slot,&nb,block_H,block_S,block_work,
+                  &(block_vals[sym_block_begin[b]]),
+                  block_work+max_size*max_size,
+                  block_work+max_size*max_size+max_size,&fail);
+    bcopy((char *)block_H,(char *)vect,nb*nb*sizeof(real));
+#else
+    for(p=0;p<nb;p++){
+      for(q=0;q<nb;q++){
+        cmplx_H[p*nb+q].r = q >= p ? block_H[p*nb+q] : 0.0;
+        cmplx_H[p*nb+q].i = 0.0;
+        cmplx_S[p*nb+q].r = q >= p ? block_S[p*nb+q] : 0.0;
+        cmplx_S[p*nb+q].i = 0.0;
+      }
+    }
+    nb2 = nb*nb;
+    if( !details->diag_wo_overlap ){
+      cached_zhegv(slot,&jobz,&nb,cmplx_H,cmplx_S,&(block_vals[sym_block_begin[b]]),
+                   cmplx_work,&nb2,block_work,&fail);
+    } else{
+      zheev(&jobz,&uplo,(long *)&nb,cmplx_H,(long *)&nb,
+            &(block_vals[sym_block_begin[b]]),cmplx_work,(long *)&nb2,block_work,
+            (long *)&fail);
+    }
+    /* the blocks are real, so the eigenvectors are too */
+    for(p=0;p<nb*nb;p++) vect[p] = cmplx_H[p].r;
+#endif
+    if( fail && !*diag_error ) *diag_error = fail;
+    timer_add_flops(eigensolver_flops(nb,1));
+  }
+
+  /******
+
+    merge the blocks in order of increasing energy and transform the
+    eigenvectors back to the AO basis.
+
+  ******/
+  for(b=0;b<num_sym_blocks;b++) pos[b] = 0;
+  bzero((char *)eigenset.vectR,num_orbs*num_orbs*sizeof(real));
+  bzero((char *)eigenset.vectI,num_orbs*num_orbs*sizeof(real));
+  for(m=0;m<num_orbs;m++){
+    best = -1;
+    for(b=0;b<num_sym_blocks;b++){
+      if( pos[b] < sym_block_size[b] &&
+          (best < 0 || block_vals[sym_block_begin[b]+pos[b]] <
+           block_vals[sym_block_begin[best]+pos[best]]) ){
+        best = b;
+      }
+    }
+    nb = sym_block_size[best];
+    j = pos[best];
+    pos[best]++;
+
+    eigenset.val[m] = block_vals[sym_block_begin[best]+j];
+    MO_blocks[m] = best;
+    vect = &(block_vects[vect_offset[best]+j*nb]);
+    for(p=0;p<nb;p++){
+      SALC_p = &(SALCs[sym_block_begin[best]+p]);
+      for(t=0;t<SALC_p->num_terms;t++){
+        eigenset.vectR[m*num_orbs+SALC_p->AO[t]] += vect[p]*SALC_p->coeff[t];
+      }
+    }
+  }
+  MOs_are_blocked = 1;
+  return 1;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure print_sym_block_labels
+*
+* Arguments: num_orbs: int
+*
+* Returns: none
+*
+* Action: if the last diagonalization was done in symmetry blocks, writes
+*   the label of the block each MO came from to the output file.
+*
+*****************************************************************************/
+void print_sym_block_labels(int num_orbs)
+{
+  int i;
+
+  if( !MOs_are_blocked || sym_blocks_num_orbs != num_orbs ) return;
+
+  fprintf(output_file,"\n# Symmetry blocks of the MOs\n");
+  fprintf(output_file,"; each MO transforms like the function given\n");
+  for(i=0;i<num_orbs;i++){
+    fprintf(output_file,"%d:---> %s\n",i+1,sym_block_label[MO_blocks[i]]);
+  }
+}
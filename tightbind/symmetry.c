@@ -105,6 +105,29 @@ void name_sym_element(sym_op_type *elem,FILE *the_file,int num_atoms,int show_eq
 
 
 
+/****************************************************************************
+*
+*                   Function sym_hash_bucket
+*
+* Arguments:  ix,iy,iz: ints
+*           table_size: int
+*
+* Returns: int
+*
+* Action:  returns the bucket of the spatial hash used by compare_molecules
+*   that the box with integer coordinates ('ix,'iy,'iz) falls into.
+*   'table_size must be a power of two.
+*
+*****************************************************************************/
+static int sym_hash_bucket(int ix,int iy,int iz,int table_size)
+{
+  unsigned int key;
+
+  key = ((unsigned int)ix*73856093U) ^ ((unsigned int)iy*19349663U) ^
+    ((unsigned int)iz*83492791U);
+  return (int)(key & (unsigned int)(table_size-1));
+}
+
 /****************************************************************************
 *
 *                   Procedure compare_molecules
@@ -125,53 +148,150 @@ void name_sym_element(sym_op_type *elem,FILE *the_file,int num_atoms,int show_eq
 *
 *  This also constructs the list of equivalent atoms: 'equiv_atoms
 *
+*  The atoms in 'locs2 are bucketed into boxes of edge SYM_HASH_CELL
+*   first, so each atom in 'locs1 only has to be compared with the atoms
+*   in the (at most 8) boxes its tolerance region overlaps.  If more than
+*   one atom matches, the one with the lowest index is used.
+*
 *****************************************************************************/
 void compare_molecules(atom_type *atoms,point_type *locs1,point_type *locs2,int num_atoms,int *equiv_atoms,char *present,real symm_tol)
 {
-  int i,j;
-  char found;
+  static int *bucket_head=0,*bucket_next=0;
+  static int table_size=0,max_atoms=0;
+  int i,j,match;
+  int ix,iy,iz;
+  int lo_x,hi_x,lo_y,hi_y,lo_z,hi_z;
+  int bucket;
+  real box_len;
 
   /* initialize present to 0 so that we can bomb out at any time */
   *present = 0;
 
+  /* make sure there's enough space for the hash */
+  if( num_atoms > max_atoms ){
+    if( bucket_head ) free(bucket_head);
+    if( bucket_next ) free(bucket_next);
+    max_atoms = num_atoms;
+    table_size = 16;
+    while( table_size < 2*max_atoms ) table_size *= 2;
+    bucket_head = (int *)calloc(table_size,sizeof(int));
+    bucket_next = (int *)calloc(max_atoms,sizeof(int));
+    if( !bucket_head || !bucket_next )
+      fatal("Can't allocate the spatial hash in compare_molecules.");
+  }
+
+  box_len = SYM_HASH_CELL;
+  if( 2.0*symm_tol > box_len ) box_len = 2.0*symm_tol;
+
+  /*********
+
+    bucket the atoms in locs2.  they're inserted in reverse order so that
+    each bucket holds its atoms in increasing order.
+
+  *********/
+  for(i=0;i<table_size;i++) bucket_head[i] = -1;
+  for(j=num_atoms-1;j>=0;j--){
+    if( atoms[j].at_number >= 0 ){
+      bucket = sym_hash_bucket((int)floor(locs2[j].x/box_len),
+                               (int)floor(locs2[j].y/box_len),
+                               (int)floor(locs2[j].z/box_len),table_size);
+      bucket_next[j] = bucket_head[bucket];
+      bucket_head[bucket] = j;
+    }
+  }
+
   /*********
 
     loop over each of the atoms in locs1, checking to see if it is present in locs2
 
   *********/
   for(i=0;i<num_atoms;i++){
-    found = 0;
     /* don't do dummy atoms */
     if( atoms[i].at_number >= 0 ){
-      for(j=0;j<num_atoms && !found;j++){
-        if( atoms[j].at_number >= 0 ){
-          /* check to see if they are the same atom type */
-          if( atoms[i].at_number == atoms[j].at_number ){
-            /* now check to see if they are in the same location */
-            if( fabs(locs1[i].x - locs2[j].x) < symm_tol &&
-               fabs(locs1[i].y - locs2[j].y) < symm_tol &&
-               fabs(locs1[i].z - locs2[j].z) < symm_tol   ){
-              /* they are */
-              found = 1;
-              equiv_atoms[j] = i;
+      lo_x = (int)floor((locs1[i].x-symm_tol)/box_len);
+      hi_x = (int)floor((locs1[i].x+symm_tol)/box_len);
+      lo_y = (int)floor((locs1[i].y-symm_tol)/box_len);
+      hi_y = (int)floor((locs1[i].y+symm_tol)/box_len);
+      lo_z = (int)floor((locs1[i].z-symm_tol)/box_len);
+      hi_z = (int)floor((locs1[i].z+symm_tol)/box_len);
+
+      match = -1;
+      for(ix=lo_x;ix<=hi_x;ix++){
+        for(iy=lo_y;iy<=hi_y;iy++){
+          for(iz=lo_z;iz<=hi_z;iz++){
+            bucket = sym_hash_bucket(ix,iy,iz,table_size);
+            for(j=bucket_head[bucket];j>=0;j=bucket_next[j]){
+              if( (match < 0 || j < match) &&
+                 atoms[i].at_number == atoms[j].at_number &&
+                 fabs(locs1[i].x - locs2[j].x) < symm_tol &&
+                 fabs(locs1[i].y - locs2[j].y) < symm_tol &&
+                 fabs(locs1[i].z - locs2[j].z) < symm_tol ){
+                match = j;
+              }
             }
           }
         }
       }
+
+      /* if we didn't find this atom, we might as well go ahead and return */
+      if( match < 0 ) return;
+      equiv_atoms[match] = i;
     } else{
       /* it's a dummy atom, pretend we found it and put a -1 in the equiv_atoms array */
-      found = 1;
       equiv_atoms[i] = -1;
     }
-
-    /* if we didn't find this atom, we might as well go ahead and return */
-    if( !found ) return;
   }
   /* we found every atom, so set present to 1 and return */
   *present = 1;
 }
 
 
+/****************************************************************************
+*
+*                   Function op_preserves_inertia
+*
+* Arguments:      op: pointer to sym_op_type
+*             tensor: a 3x3 matrix of reals
+*         tensor_tol: real
+*
+* Returns: char
+*
+* Action:  returns nonzero if applying 'op to the inertia 'tensor (built by
+*   build_inertia_tensor) leaves it unchanged to within 'tensor_tol.
+*
+*   Every symmetry operation of a molecule has to do this: its axis has to
+*    be a principal axis, and rotation axes of order higher than two
+*    require the other two moments to be the same.  This is a cheap way to
+*    throw out candidate operations before comparing atomic positions.
+*
+*****************************************************************************/
+static char op_preserves_inertia(sym_op_type *op,real tensor[3][3],real tensor_tol)
+{
+  int i,j,k;
+  real temp[3][3];
+  real elem;
+
+  for(i=0;i<3;i++){
+    for(j=0;j<3;j++){
+      temp[i][j] = 0.0;
+      for(k=0;k<3;k++){
+        temp[i][j] += op->t_mat[i][k]*tensor[k][j];
+      }
+    }
+  }
+  for(i=0;i<3;i++){
+    for(j=0;j<3;j++){
+      elem = 0.0;
+      for(k=0;k<3;k++){
+        elem += temp[i][k]*op->t_mat[j][k];
+      }
+      if( fabs(elem - tensor[i][j]) > tensor_tol ) return 0;
+    }
+  }
+  return 1;
+}
+
+
 /****************************************************************************
 *
 *                   Procedure make_new_sym_op
@@ -578,6 +698,7 @@ void find_off_axis_sym_ops(detail_type *details,cell_type *cell,
   real base_angle;
   real angle;
   real mapping[9];
+  real inertia[3][3],inertia_tol;
 
   char try_x,try_y,try_z,order_is_odd;
   char present_for_basis,present_for_lattice;
@@ -834,7 +955,14 @@ void find_off_axis_sym_ops(detail_type *details,cell_type *cell,
     okay, we just generated a whole slew of potential operations,
     now check to see if they are present (joy!)
 
+    for molecules, anything which doesn't preserve the inertia tensor
+    can be thrown out without looking at the atoms.
+
   ********/
+  if( cell->dim == 0 ){
+    build_inertia_tensor(cell->atoms,locs,cell->num_atoms,details->symm_tol,
+                         inertia,&inertia_tol);
+  }
   this_op = orig_last->next;
   last_op = orig_last;
   while(this_op){
@@ -849,9 +977,11 @@ void find_off_axis_sym_ops(detail_type *details,cell_type *cell,
     if( !(this_op->equiv_atoms) ) fatal("Can't get memory for equiv_atom array.");
 
     if( cell->dim == 0 ){
-      compare_molecules(cell->atoms,locs,new_locs,
-                        cell->num_atoms,this_op->equiv_atoms,
-                        &(present_for_basis),details->symm_tol);
+      if( op_preserves_inertia(this_op,inertia,inertia_tol) ){
+        compare_molecules(cell->atoms,locs,new_locs,
+                          cell->num_atoms,this_op->equiv_atoms,
+                          &(present_for_basis),details->symm_tol);
+      } else present_for_basis = 0;
       present_for_lattice = 1;
     }else{
       compare_crystal_basis(cell,locs,new_locs,cell_dim,
@@ -970,6 +1100,7 @@ void find_sym_ops(detail_type *details,cell_type *cell)
   char present_for_basis,present_for_lattice;
   real moments[3];
   real mapping[9];
+  real inertia[3][3],inertia_tol;
   long int total_mass;
   int num_ops_present=0;
 
@@ -1087,7 +1218,14 @@ void find_sym_ops(detail_type *details,cell_type *cell)
     list of symmetry operations... remove any element which is not present
     from the list.
 
+    for molecules the inertia tensor is used to screen the operations
+    before the atomic positions are compared.
+
   *********/
+  if( cell->dim == 0 ){
+    build_inertia_tensor(cell->atoms,COM_locs,num_atoms,details->symm_tol,
+                         inertia,&inertia_tol);
+  }
   last_op = 0;
   this_op = sym_ops_present;
   num_ops = 0;
@@ -1112,8 +1250,10 @@ void find_sym_ops(detail_type *details,cell_type *cell)
 
     /* check to see if the transformed molecule is equivalent */
     if( cell->dim == 0 ){
-      compare_molecules(cell->atoms,COM_locs,new_locs,num_atoms,this_op->equiv_atoms,
-                        &(present_for_basis),details->symm_tol);
+      if( op_preserves_inertia(this_op,inertia,inertia_tol) ){
+        compare_molecules(cell->atoms,COM_locs,new_locs,num_atoms,this_op->equiv_atoms,
+                          &(present_for_basis),details->symm_tol);
+      } else present_for_basis = 0;
       present_for_lattice = 1;
     }else{
       compare_crystal_basis(cell,COM_locs,new_locs,cell_dim,
@@ -1262,6 +1402,7 @@ void find_walsh_sym_ops(cell_type *cell,detail_type *details)
   char present;
   long int total_mass;
   real moments[3];
+  real inertia[3][3],inertia_tol;
   int num_ops_present=0;
   int num_steps;
 
@@ -1325,6 +1466,8 @@ void find_walsh_sym_ops(cell_type *cell,detail_type *details)
     cell->princ_axes[1][1] = 1.0;
     cell->princ_axes[2][2] = 1.0;
   }
+  build_inertia_tensor(cell->atoms,COM_locs,num_atoms,details->symm_tol,
+                       inertia,&inertia_tol);
 
   /********
 
@@ -1350,8 +1493,10 @@ void find_walsh_sym_ops(cell_type *cell,detail_type *details)
     if( !(this_op->equiv_atoms) ) fatal("Can't get memory for equiv_atom array.");
 
     /* check to see if the transformed molecule is equivalent */
-    compare_molecules(cell->atoms,COM_locs,new_locs,num_atoms,this_op->equiv_atoms,
-                      &(present),details->symm_tol);
+    if( op_preserves_inertia(this_op,inertia,inertia_tol) ){
+      compare_molecules(cell->atoms,COM_locs,new_locs,num_atoms,this_op->equiv_atoms,
+                        &(present),details->symm_tol);
+    } else present = 0;
 
     /* was this element present? */
     if( !present ){
@@ -1370,8 +1515,8 @@ void find_walsh_sym_ops(cell_type *cell,detail_type *details)
            present
         *****/
         sym_ops_present = this_op->next;
-        free(this_op);
         free(this_op->equiv_atoms);
+        free(this_op);
         this_op = sym_ops_present;
       }
     }
@@ -1395,6 +1540,8 @@ void find_walsh_sym_ops(cell_type *cell,detail_type *details)
     }
     translate_atoms(COM_locs,cell->COM,num_atoms);
     transform_3x3_transpose(COM_locs,cell->princ_axes,num_atoms);
+    build_inertia_tensor(cell->atoms,COM_locs,num_atoms,details->symm_tol,
+                         inertia,&inertia_tol);
 
     last_op = 0;
     this_op = sym_ops_present;
@@ -1413,8 +1560,10 @@ void find_walsh_sym_ops(cell_type *cell,detail_type *details)
       if( !(this_op->equiv_atoms) ) fatal("Can't get memory for equiv_atom array.");
 
       /* check to see if the transformed molecule is equivalent */
-      compare_molecules(cell->atoms,COM_locs,new_locs,num_atoms,this_op->equiv_atoms,
-                        &(present),details->symm_tol);
+      if( op_preserves_inertia(this_op,inertia,inertia_tol) ){
+        compare_molecules(cell->atoms,COM_locs,new_locs,num_atoms,this_op->equiv_atoms,
+                          &(present),details->symm_tol);
+      } else present = 0;
 
       /* was this element present? */
       if( !present ){
@@ -1433,8 +1582,8 @@ void find_walsh_sym_ops(cell_type *cell,detail_type *details)
             present
             *****/
           sym_ops_present = this_op->next;
-          free(this_op);
           free(this_op->equiv_atoms);
+          free(this_op);
           this_op = sym_ops_present;
         }
       }
@@ -1495,9 +1644,9 @@ void find_walsh_sym_ops(cell_type *cell,detail_type *details)
 void find_MO_symmetries(int num_orbs,detail_type *details,cell_type *cell,eigenset_type eigenset,
   hermetian_matrix_type overlap,int *orbital_lookup_table)
 {
-  static real *AO_coeffs=0;
-  static real *norm_fact=0;
-  static int norm_fact_size=0;
+  real *AO_coeffs;
+  real *norm_fact;
+  arena_mark_type mark;
   int i,j,k,ops_so_far;
   int num_atoms;
   int atom1,atom2;
@@ -1506,21 +1655,15 @@ void find_MO_symmetries(int num_orbs,detail_type *details,cell_type *cell,eigens
   real MO_character;
   sym_op_type *sym_op;
 
+  /* the characters from the last time through are replaced */
+  if( details->characters ) free(details->characters);
   details->characters = (real *)calloc(num_orbs*details->num_sym_ops,sizeof(real));
   if( !details->characters ) fatal("can't allocate details->characters");
 
-  /* check to see if we need to get space for the AO_coeffs array */
-  if( !AO_coeffs ){
-    /* this needs to be larger for f orbitals */
-    AO_coeffs = (real *)calloc(END_D + 1,sizeof(real));
-    if( !AO_coeffs ) fatal("Can't get space for AO_coeffs in find_MO_symmetries.");
-  }
-  if(norm_fact_size != num_orbs || !norm_fact){
-    if(norm_fact) free(norm_fact);
-    norm_fact = (real *)calloc(num_orbs,sizeof(real));
-    if( !norm_fact ) fatal("Can't get memory for norm_fact in find_MO_symmetries.");
-    norm_fact_size = num_orbs;
-  }
+  /* scratch space for one atom's AO's and the normalization constants */
+  mark = arena_mark(&kpoint_arena);
+  AO_coeffs = (real *)arena_calloc(&kpoint_arena,END_F + 1,sizeof(real));
+  norm_fact = (real *)arena_calloc(&kpoint_arena,num_orbs,sizeof(real));
 
   num_atoms = cell->num_atoms;
 
@@ -1615,4 +1758,6 @@ operations present.\n");
     }
     fprintf(output_file,"\n");
   }
+
+  arena_release(&kpoint_arena,mark);
 }
@@ -68,6 +68,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /* tolerance for declaring positions the same */
 #define SYMM_TOL 1e-3
 
+/******
+  edge length (in Angstroms) of the boxes used to bucket atomic positions
+  when comparing a transformed molecule with the original.  This is made
+  larger if it's less than twice the symmetry tolerance.
+*******/
+#define SYM_HASH_CELL 1.0
+
 /******
   used to indicate whether or not equivalent atoms should be printed when a
   symmetry element is displayed.
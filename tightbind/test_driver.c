@@ -30,97 +30,48 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 ********************************************************************/
 
-#include "bind.h"
-
-// For booleans
-#include "stdbool.h"
+/* this is an example of using bind as a library (see eht_api.h) */
+#include <stdio.h>
+#include <stdlib.h>
+#include "eht_api.h"
 
 
 int main(int argc, char **argv){
-  char err_string[240];
+  const char *symbols[3] = {"H","C","N"};
+  double coords[9] = {0.0,0.0,0.0,
+                      0.0,0.0,1.0,
+                      0.0,0.0,2.1};
+  double charges[3],rop[9];
+  eht_system *sys;
   int i, j;
-  FILE *nullfile = fopen("nul","w");
-
-  status_file = nullfile;
-  output_file = nullfile;
-
-  unit_cell = (cell_type *)calloc(1,sizeof(cell_type));
-  details = (detail_type *)calloc(1,sizeof(detail_type));
-  if(!unit_cell || !details) fatal("Can't allocate initial memory.");
-  FILE *dest=nullfile;
-
-  /*******
-    initialize some variables
-    ********/
-  set_details_defaults(details);
-  set_cell_defaults(unit_cell);
-
-  safe_strcpy(details->title,"test job");
 
   // molecular calculation
-  details->Execution_Mode = MOLECULAR;
-  details->num_KPOINTS = 1;
-  details->K_POINTS = (k_point_type *)calloc(1,sizeof(k_point_type));
-  if( !details->K_POINTS ) fatal("Can't allocate the single k point.");
-  details->K_POINTS[0].weight = 1.0;
-  details->avg_props = 0;
-  details->use_symmetry = 1;
-  details->net_chg_PRT=1;
-  details->ROP_mat_PRT=1;
-
-
-  unit_cell->using_Zmat = 0;
-  unit_cell->using_xtal_coords = 0;
-
-
-  unit_cell->num_atoms = 3;
-  unit_cell->atoms = (atom_type *)calloc(unit_cell->num_atoms,sizeof(atom_type));
-  if(!unit_cell->atoms){
-    sprintf(err_string,"Can't allocate memory for: %d atoms.",unit_cell->num_atoms);
-    fatal("Can't allocate memory for the atoms.");
+  sys = eht_create(3,symbols,coords,0,NULL);
+  if( !sys ){
+    fprintf(stderr,"Can't create the system.\n");
+    exit(1);
   }
-  safe_strcpy(unit_cell->atoms[0].symb,"H");
-  unit_cell->atoms[0].loc.x = 0.0;
-  unit_cell->atoms[0].loc.y = 0.0;
-  unit_cell->atoms[0].loc.z = 0.0;
+  eht_set_symmetry(sys,1);
+  eht_request(sys,EHT_ROP);
 
-  safe_strcpy(unit_cell->atoms[1].symb,"C");
-  unit_cell->atoms[1].loc.x = 0.0;
-  unit_cell->atoms[1].loc.y = 0.0;
-  unit_cell->atoms[1].loc.z = 1.0;
-
-  safe_strcpy(unit_cell->atoms[2].symb,"N");
-  unit_cell->atoms[2].loc.x = 0.0;
-  unit_cell->atoms[2].loc.y = 0.0;
-  unit_cell->atoms[2].loc.z = 2.1;
-
-  unit_cell->charge = 0.0;
-
-
-  // shouldn't need to change below here
-  fill_atomic_parms(unit_cell->atoms,unit_cell->num_atoms,NULL,NULL);
-  unit_cell->num_raw_atoms = unit_cell->num_atoms;
-  charge_to_num_electrons(unit_cell);
-  build_orbital_lookup_table(unit_cell,&num_orbs,&orbital_lookup_table);
-
-
-  /* install the sig_int handler */
-  signal(SIGINT,handle_sigint);
-
-  run_eht(dest);
+  if( eht_run(sys) ){
+    fprintf(stderr,"Run failed: %s\n",eht_last_error(sys));
+    exit(1);
+  }
 
   //pull properties
-  for(i=0;i<unit_cell->num_atoms;i++){
-   printf(">>>> Atom %d: %.2f\n",i+1,properties.net_chgs[i]);
+  eht_get_charges(sys,charges);
+  for(i=0;i<3;i++){
+   printf(">>>> Atom %d: %.2f\n",i+1,charges[i]);
   }
 
-  for(i=0;i<unit_cell->num_atoms;i++){
+  eht_get_ROP(sys,rop);
+  for(i=0;i<3;i++){
   for(j=0;j<i;j++){
-   printf(">>>> ROP %d-%d: %.2f\n",i+1,j+1,properties.ROP_mat[i*(i+1)/2 + j]);
+   printf(">>>> ROP %d-%d: %.2f\n",i+1,j+1,rop[i*3+j]);
   }
 }
 
-  free(unit_cell);
-  free(details);
+  eht_destroy(sys);
   exit(0);
 }
@@ -0,0 +1,372 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+
+/****************************************************************************
+*
+*     this file contains the timers used to see where a run spends
+*      its time.
+*
+*   Timers are identified by name and nest: starting a timer while
+*    another is running makes it a child of the running one, so the
+*    same name can show up in more than one place in the tree.  Each
+*    one keeps track of the wall and CPU time spent in it, the number
+*    of times it was started, the number of bytes allocated (through
+*    my_malloc and friends) and an estimate of the number of floating
+*    point operations done while it was the innermost running timer.
+*
+*   The results are written to the end of the status file in a block
+*    between #TIMERS and #END_TIMERS, one line per timer:
+*       path calls wall_seconds cpu_seconds bytes mflops
+*    where path is the list of names from the outermost timer joined
+*    with /'s.
+*
+*   If timing is turned off all of the calls return immediately.  The
+*    timers are not thread safe.
+*
+*****************************************************************************/
+
+#include "bind.h"
+#ifndef _MSC_VER
+#include <sys/time.h>
+#include <sys/resource.h>
+#else
+#include <time.h>
+#endif
+
+#define MAX_TIMERS 128
+#define MAX_TIMER_DEPTH 16
+
+typedef struct {
+  char *name;
+  int parent;
+  long calls;
+  double wall,cpu;
+  double start_wall,start_cpu;
+  double bytes,flops;
+} timer_type;
+
+static timer_type timers[MAX_TIMERS];
+static int num_timers=0;
+static int timer_stack[MAX_TIMER_DEPTH];
+static int timer_depth=0;
+static char timers_on=1;
+
+
+/****************************************************************************
+*
+*                   Function wall_clock, cpu_clock
+*
+* Arguments: none
+*
+* Returns: double
+*
+* Action: return the wall clock and CPU times in seconds.
+*
+*****************************************************************************/
+static double wall_clock()
+{
+#ifndef _MSC_VER
+  struct timeval tv;
+
+  gettimeofday(&tv,0);
+  return (double)tv.tv_sec + 1e-6*(double)tv.tv_usec;
+#else
+  return (double)time(0);
+#endif
+}
+
+static double cpu_clock()
+{
+#ifndef _MSC_VER
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF,&usage);
+  return (double)usage.ru_utime.tv_sec + 1e-6*(double)usage.ru_utime.tv_usec +
+    (double)usage.ru_stime.tv_sec + 1e-6*(double)usage.ru_stime.tv_usec;
+#else
+  return (double)clock()/CLOCKS_PER_SEC;
+#endif
+}
+
+
+/****************************************************************************
+*
+*                   Procedure timers_off
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: turns off timing and throws away anything that's been
+*   collected so far.
+*
+*****************************************************************************/
+void timers_off()
+{
+  timers_on = 0;
+  num_timers = 0;
+  timer_depth = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure reset_timers
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: throws away all the timers and turns timing back on.
+*
+*****************************************************************************/
+void reset_timers()
+{
+  timers_on = 1;
+  num_timers = 0;
+  timer_depth = 0;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure timer_start
+*
+* Arguments: name: pointer to char
+*
+* Returns: none
+*
+* Action: starts the timer 'name as a child of the innermost running
+*   timer.  The name isn't copied, so it needs to be a constant.
+*
+*****************************************************************************/
+void timer_start(char *name)
+{
+  timer_type *timer;
+  int parent,which;
+
+  if( !timers_on ) return;
+  if( timer_depth == MAX_TIMER_DEPTH ){
+    NONFATAL_BUG("Timers nested too deeply.");
+    timers_off();
+    return;
+  }
+
+  parent = timer_depth ? timer_stack[timer_depth-1] : -1;
+  for(which=0;which<num_timers;which++){
+    if( timers[which].parent == parent &&
+        (timers[which].name == name || !strcmp(timers[which].name,name)) ) break;
+  }
+  if( which == num_timers ){
+    if( num_timers == MAX_TIMERS ){
+      NONFATAL_BUG("Too many timers.");
+      timers_off();
+      return;
+    }
+    timer = &(timers[num_timers++]);
+    bzero((char *)timer,sizeof(timer_type));
+    timer->name = name;
+    timer->parent = parent;
+  }
+  timer = &(timers[which]);
+  timer->calls++;
+  timer->start_wall = wall_clock();
+  timer->start_cpu = cpu_clock();
+  timer_stack[timer_depth++] = which;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure timer_stop
+*
+* Arguments: name: pointer to char
+*
+* Returns: none
+*
+* Action: stops the timer 'name, which has to be the innermost running one.
+*
+*****************************************************************************/
+void timer_stop(char *name)
+{
+  timer_type *timer;
+
+  if( !timers_on ) return;
+  if( !timer_depth || strcmp(timers[timer_stack[timer_depth-1]].name,name) ){
+    NONFATAL_BUG("Timers stopped out of order.");
+    timers_off();
+    return;
+  }
+  timer = &(timers[timer_stack[--timer_depth]]);
+  timer->wall += wall_clock() - timer->start_wall;
+  timer->cpu += cpu_clock() - timer->start_cpu;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure timer_add_bytes, timer_add_flops
+*
+* Arguments: amount: double
+*
+* Returns: none
+*
+* Action: charge 'amount bytes allocated (or floating point operations)
+*   to the innermost running timer.
+*
+*****************************************************************************/
+void timer_add_bytes(double amount)
+{
+  if( !timers_on || !timer_depth ) return;
+  timers[timer_stack[timer_depth-1]].bytes += amount;
+}
+
+void timer_add_flops(double amount)
+{
+  if( !timers_on || !timer_depth ) return;
+  timers[timer_stack[timer_depth-1]].flops += amount;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure print_timer_path
+*
+* Arguments: outfile: pointer to FILE
+*             which: int
+*
+* Returns: none
+*
+* Action: writes the names of timer 'which and its parents, outermost
+*   first and separated by /'s.
+*
+*****************************************************************************/
+static void print_timer_path(FILE *outfile,int which)
+{
+  if( timers[which].parent >= 0 ){
+    print_timer_path(outfile,timers[which].parent);
+    fputc('/',outfile);
+  }
+  fputs(timers[which].name,outfile);
+}
+
+
+/****************************************************************************
+*
+*                   Procedure print_timer_tree
+*
+* Arguments: outfile: pointer to FILE
+*             parent: int
+*
+* Returns: none
+*
+* Action: writes out the children of 'parent (and their children...) in
+*   the order they were first started.
+*
+*****************************************************************************/
+static void print_timer_tree(FILE *outfile,int parent)
+{
+  timer_type *timer;
+  int which;
+
+  for(which=0;which<num_timers;which++){
+    timer = &(timers[which]);
+    if( timer->parent != parent ) continue;
+    print_timer_path(outfile,which);
+    fprintf(outfile," %ld %.6lf %.6lf %.0lf %.3lf\n",timer->calls,timer->wall,
+            timer->cpu,timer->bytes,timer->flops*1e-6);
+    print_timer_tree(outfile,which);
+  }
+}
+
+
+/****************************************************************************
+*
+*                   Procedure report_timers
+*
+* Arguments: outfile: pointer to FILE
+*
+* Returns: none
+*
+* Action: writes out the timer block.  Any timers which are still running
+*   are reported up to the present.
+*
+*****************************************************************************/
+void report_timers(FILE *outfile)
+{
+  double now_wall,now_cpu;
+  int i;
+
+  if( !timers_on || !num_timers ) return;
+
+  now_wall = wall_clock();
+  now_cpu = cpu_clock();
+  for(i=0;i<timer_depth;i++){
+    timers[timer_stack[i]].wall += now_wall - timers[timer_stack[i]].start_wall;
+    timers[timer_stack[i]].cpu += now_cpu - timers[timer_stack[i]].start_cpu;
+    timers[timer_stack[i]].start_wall = now_wall;
+    timers[timer_stack[i]].start_cpu = now_cpu;
+  }
+
+  fprintf(outfile,"#TIMERS\n");
+  fprintf(outfile,"; timer calls wall_seconds cpu_seconds bytes mflops\n");
+  print_timer_tree(outfile,-1);
+  fprintf(outfile,"#END_TIMERS\n");
+}
+
+
+/****************************************************************************
+*
+*                   Function eigensolver_flops
+*
+* Arguments: num_orbs: int
+*         want_vects: char
+*
+* Returns: double
+*
+* Action: returns a rough count of the floating point operations needed
+*   to solve the 'num_orbs x 'num_orbs generalized hermitian eigenproblem
+*   with a dense solver: the Cholesky factorization of S (n^3/3), the
+*   reduction to a standard problem (n^3), tridiagonalization (4n^3/3) and,
+*   if 'want_vects is set, the QL iterations and back transformations
+*   (about 3n^3).  Each complex operation is counted as 4 real ones.
+*
+*****************************************************************************/
+double eigensolver_flops(int num_orbs,char want_vects)
+{
+  double n3;
+
+  n3 = (double)num_orbs*(double)num_orbs*(double)num_orbs;
+  if( want_vects ) return 4.0*(n3/3.0 + n3 + 4.0*n3/3.0 + 3.0*n3);
+  else return 4.0*(n3/3.0 + n3 + 4.0*n3/3.0);
+}
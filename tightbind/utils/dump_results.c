@@ -0,0 +1,102 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+/************************************************************************
+
+  This program lists the contents of a binary results (.bres) file
+   written by bind.  If a dataset name is given as well, the values
+   in the matching chunks are printed.
+
+   usage: dump_results file.bres [name]
+
+************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "results_reader.h"
+
+static char *type_names[] = {"?","char","int","float","double"};
+static char *layout_names[] = {"dense","symmetric","hermetian"};
+
+int main(int argc,char **argv)
+{
+  results_reader_type *reader;
+  results_chunk_type chunk;
+  double *vals;
+  char *text;
+  int i,j;
+
+  if( argc < 2 ){
+    fprintf(stderr,"Usage: dump_results infile [name]\n");
+    exit(1);
+  }
+
+  reader = results_open(argv[1]);
+  if( !reader ) exit(1);
+
+  while( results_next_chunk(reader,&chunk) ){
+    if( argc > 2 && strcmp(chunk.name,argv[2]) ) continue;
+
+    printf("%-24s %-6s %-9s step: %d kpoint: %d index: %d (%d x %d)\n",
+           chunk.name,
+           chunk.type >= RESULTS_CHAR && chunk.type <= RESULTS_DOUBLE ?
+           type_names[chunk.type] : type_names[0],
+           chunk.layout >= RESULTS_DENSE && chunk.layout <= RESULTS_HERMETIAN ?
+           layout_names[chunk.layout] : "?",
+           chunk.step,chunk.kpoint,chunk.index,chunk.rows,chunk.cols);
+    if( argc < 3 ) continue;
+
+    if( chunk.type == RESULTS_CHAR ){
+      text = (char *)calloc(chunk.num_elements+1,sizeof(char));
+      if( text && results_read_data(reader,&chunk,text) ){
+        for(i=0;i<chunk.rows;i++){
+          printf("  %.*s\n",chunk.cols,&text[i*chunk.cols]);
+        }
+      }
+      if( text ) free(text);
+      continue;
+    }
+
+    vals = results_read_doubles(reader,&chunk);
+    if( !vals ) continue;
+    for(i=0;i<chunk.rows;i++){
+      for(j=0;j<chunk.cols;j++){
+        if( chunk.layout == RESULTS_SYMMETRIC && j > i ) break;
+        printf(" % 12.6lg",results_matrix_element(&chunk,vals,i,j,0));
+      }
+      printf("\n");
+    }
+    free(vals);
+  }
+  results_close(reader);
+  return 0;
+}
@@ -17,8 +17,14 @@
 
     NOTE:  it is assumed that the lattice vectors are defined by the first
         and last ndim atoms.
+
+  usage: grow_xtal <infilename> <outfilename> [num_a [num_b [num_c]]]
+    if the number of cells along each direction isn't given on the
+    command line, you'll be prompted for it.
 */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define real double
 
@@ -106,8 +112,8 @@ int skipcomments(FILE *file,char *string,char toggle)
   ********/
   i = 0;
   while(string[i] == ' ') i++;
-  while( string[i] == '\n' || string[i] == ';'
-        && string[i] != 0 ){
+  while( string[i] == '\n' || (string[i] == ';'
+        && string[i] != 0) ){
     string[0] = 0;
     fgets(string,MAX_STR_LEN,file);
     i = 0;
@@ -234,7 +240,21 @@ void grow_it(molec_type *solid,int num_a,int num_b, int num_c)
 }
 
 
-void main(int argc,char **argv)
+/* returns the number of cells given in argv[which], or 0 if there isn't one */
+int cells_from_args(int argc,char **argv,int which)
+{
+  int num;
+
+  if( which >= argc ) return 0;
+  num = atoi(argv[which]);
+  if( num < 1 ){
+    error("Don't enter dumb values!");
+    num = 1;
+  }
+  return num;
+}
+
+int main(int argc,char **argv)
 {
   FILE *infile,*outfile;
   int i;
@@ -242,8 +262,8 @@ void main(int argc,char **argv)
   molec_type molec;
   int num_a,num_b,num_c;
 
-  if( argc != 3 )
-    fatal("usage: grow_xtal <infilename> <outfilename>\n");
+  if( argc < 3 || argc > 6 )
+    fatal("usage: grow_xtal <infilename> <outfilename> [num_a [num_b [num_c]]]\n");
 
   /* open the infile */
   infile = fopen(argv[1],"r");
@@ -254,34 +274,43 @@ void main(int argc,char **argv)
   /* read the data */
   read_from_file(infile,&molec);
 
-  /* prompt for the size */
+  /* prompt for the size (unless it was on the command line) */
   printf("The file system has: %d atoms and is %d dimensional\n",
          molec.num_raw_atoms,molec.num_dim);
 
-  printf("Please enter the number of cells along each lattice direction on separate lines.\n");
-  printf("(a)  ");
-  scanf("%d",&num_a);
-  if( num_a < 1 ){
-    error("Don't enter dumb values!");
-    num_a = 1;
+  num_a = cells_from_args(argc,argv,3);
+  num_b = cells_from_args(argc,argv,4);
+  num_c = cells_from_args(argc,argv,5);
+  if( !num_a ){
+    printf("Please enter the number of cells along each lattice direction on separate lines.\n");
+    printf("(a)  ");
+    scanf("%d",&num_a);
+    if( num_a < 1 ){
+      error("Don't enter dumb values!");
+      num_a = 1;
+    }
   }
   if( molec.num_dim > 1 ){
-    printf("(b)  ");
-    scanf("%d",&num_b);
-    if( num_b < 1 ){
-      error("Don't enter dumb values!");
-      num_b = 1;
+    if( !num_b ){
+      printf("(b)  ");
+      scanf("%d",&num_b);
+      if( num_b < 1 ){
+        error("Don't enter dumb values!");
+        num_b = 1;
+      }
     }
   }
   else{
     num_b = num_c = 1;
   }
   if( molec.num_dim > 2 ){
-    printf("(c)  ");
-    scanf("%d",&num_c);
-    if( num_c < 1 ){
-      error("Don't enter dumb values!");
-      num_c = 1;
+    if( !num_c ){
+      printf("(c)  ");
+      scanf("%d",&num_c);
+      if( num_c < 1 ){
+        error("Don't enter dumb values!");
+        num_c = 1;
+      }
     }
   }
   else{
@@ -341,6 +370,7 @@ void main(int argc,char **argv)
   printf("Done. Don't forget to put *'s back in for atoms that need parms\n");
 
   fclose(outfile);
+  return 0;
 }
 
 
@@ -0,0 +1,390 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+/************************************************************************
+
+  These are the routines for reading the binary matrix dumps (.OV and
+   .HAM files) written by bind.  See matrix_dump_reader.h for how to
+   use them.
+
+  None of these call exit(); errors are reported on stderr and
+   through the return values.
+
+************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/mman.h>
+#else
+#include <io.h>
+#endif
+
+#include "matrix_dump_reader.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+
+/************************************************************************
+ *
+ *                   Procedure read_block
+ *
+ * Arguments: file: int
+ *          offset: long long
+ *            dest: pointer to void
+ *            size: long long
+ *
+ * Returns: int
+ *
+ * Action: reads 'size bytes at 'offset of 'file into 'dest.
+ *   Returns 1 on success.
+ *
+ ************************************************************************/
+static int read_block(int file,long long offset,void *dest,long long size)
+{
+  if( lseek(file,(off_t)offset,SEEK_SET) == (off_t)-1 ) return 0;
+  return read(file,dest,size) == size;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure matrix_dump_open
+ *
+ * Arguments: name: pointer to char
+ *
+ * Returns: pointer to matrix_dump_reader_type
+ *
+ * Action: opens the dump file 'name and reads its header, k points
+ *   and index.  Returns 0 if the file can't be opened or read.
+ *
+ *   Old style files (without a header) get a header filled in here;
+ *    they are assumed to contain doubles.
+ *
+ ************************************************************************/
+matrix_dump_reader_type *matrix_dump_open(char *name)
+{
+  matrix_dump_reader_type *reader;
+  matrix_dump_header_type *header;
+  long long mat_size;
+  int file,sizes[2];
+  int i;
+
+  file = open(name,O_RDONLY | O_BINARY);
+  if( file == -1 ){
+    fprintf(stderr,"Can't open matrix file %s\n",name);
+    return 0;
+  }
+  reader = (matrix_dump_reader_type *)calloc(1,sizeof(matrix_dump_reader_type));
+  if( !reader ){
+    close(file);
+    return 0;
+  }
+  reader->file = file;
+  header = &(reader->header);
+
+  if( !read_block(file,0,header,sizeof(matrix_dump_header_type)) ||
+      strncmp(header->magic,MATRIX_DUMP_MAGIC,8) ){
+    /* this could be an old style file */
+    if( !read_block(file,0,sizes,2*sizeof(int)) || sizes[0] <= 0 || sizes[1] <= 0 ){
+      fprintf(stderr,"%s is not a matrix file.\n",name);
+      matrix_dump_close(reader);
+      return 0;
+    }
+    memset(header,0,sizeof(matrix_dump_header_type));
+    header->num_kpoints = sizes[0];
+    header->num_orbs = sizes[1];
+    header->element_type = MATRIX_DUMP_DOUBLE;
+    header->compression = MATRIX_DUMP_NONE;
+    reader->index = (matrix_dump_index_type *)
+      calloc(header->num_kpoints,sizeof(matrix_dump_index_type));
+    reader->kpoints = (double *)calloc(4*header->num_kpoints,sizeof(double));
+    if( !reader->index || !reader->kpoints ){
+      fprintf(stderr,"Can't allocate memory to read %s\n",name);
+      matrix_dump_close(reader);
+      return 0;
+    }
+    mat_size = (long long)header->num_orbs*header->num_orbs*sizeof(double);
+    for(i=0;i<header->num_kpoints;i++){
+      reader->index[i].offset = 2*sizeof(int) + i*mat_size;
+      reader->index[i].size = mat_size;
+    }
+    return reader;
+  }
+
+  if( header->byte_order != MATRIX_DUMP_BYTE_ORDER ){
+    fprintf(stderr,"%s was written on a machine with a different byte order.\n",
+            name);
+    matrix_dump_close(reader);
+    return 0;
+  }
+  if( header->version > MATRIX_DUMP_VERSION ){
+    fprintf(stderr,"%s was written by a newer version of bind (%d).\n",
+            name,header->version);
+    matrix_dump_close(reader);
+    return 0;
+  }
+
+  reader->index = (matrix_dump_index_type *)
+    calloc(header->num_kpoints,sizeof(matrix_dump_index_type));
+  reader->kpoints = (double *)calloc(4*header->num_kpoints,sizeof(double));
+  if( !reader->index || !reader->kpoints ){
+    fprintf(stderr,"Can't allocate memory to read %s\n",name);
+    matrix_dump_close(reader);
+    return 0;
+  }
+  if( !read_block(file,header->kpoint_offset,reader->kpoints,
+                  4*header->num_kpoints*sizeof(double)) ||
+      !read_block(file,header->index_offset,reader->index,
+                  header->num_kpoints*sizeof(matrix_dump_index_type)) ){
+    fprintf(stderr,"%s is truncated.\n",name);
+    matrix_dump_close(reader);
+    return 0;
+  }
+  return reader;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure matrix_dump_close
+ *
+ * Arguments: reader: pointer to matrix_dump_reader_type
+ *
+ * Returns: none
+ *
+ * Action: closes the file and frees 'reader
+ *
+ ************************************************************************/
+void matrix_dump_close(matrix_dump_reader_type *reader)
+{
+  if( !reader ) return;
+  close(reader->file);
+  if( reader->index ) free(reader->index);
+  if( reader->kpoints ) free(reader->kpoints);
+  free(reader);
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure matrix_dump_read
+ *
+ * Arguments: reader: pointer to matrix_dump_reader_type
+ *          which_k: int
+ *              mat: pointer to double
+ *
+ * Returns: int
+ *
+ * Action: reads the matrix for k point 'which_k into 'mat (which
+ *   should have space for num_orbs*num_orbs doubles), converting and
+ *   uncompressing it as needed.
+ *
+ *   Returns 1 on success, 0 if the matrix isn't in the file or can't
+ *    be read.
+ *
+ ************************************************************************/
+int matrix_dump_read(matrix_dump_reader_type *reader,int which_k,double *mat)
+{
+  matrix_dump_index_type *entry;
+  char *data;
+  float *float_vals;
+  double *double_vals;
+  int run[2];
+  long long pos,elem_size;
+  int num_vals,i,j;
+
+  if( which_k < 0 || which_k >= reader->header.num_kpoints ) return 0;
+  entry = &(reader->index[which_k]);
+  if( !entry->size ) return 0;
+
+  num_vals = reader->header.num_orbs*reader->header.num_orbs;
+  if( reader->header.element_type == MATRIX_DUMP_FLOAT ) elem_size = sizeof(float);
+  else elem_size = sizeof(double);
+
+  if( reader->header.compression == MATRIX_DUMP_NONE &&
+      elem_size == sizeof(double) ){
+    if( entry->size != num_vals*elem_size ) return 0;
+    return read_block(reader->file,entry->offset,mat,entry->size);
+  }
+
+  data = (char *)malloc(entry->size);
+  if( !data ){
+    fprintf(stderr,"Can't allocate memory to read a matrix.\n");
+    return 0;
+  }
+  if( !read_block(reader->file,entry->offset,data,entry->size) ){
+    free(data);
+    return 0;
+  }
+
+  if( reader->header.compression == MATRIX_DUMP_NONE ){
+    float_vals = (float *)data;
+    for(i=0;i<num_vals;i++) mat[i] = float_vals[i];
+  } else{
+    /* zero runs */
+    i = 0;
+    pos = 0;
+    while( pos + (long long)(2*sizeof(int)) <= entry->size && i <= num_vals ){
+      memcpy(run,&(data[pos]),2*sizeof(int));
+      pos += 2*sizeof(int);
+      if( run[0] < 0 || run[1] < 0 || i+run[0]+run[1] > num_vals ||
+          pos + run[1]*elem_size > entry->size ){
+        fprintf(stderr,"Bad compressed matrix for k point %d.\n",which_k);
+        free(data);
+        return 0;
+      }
+      for(j=0;j<run[0];j++) mat[i++] = 0.0;
+      float_vals = (float *)&(data[pos]);
+      double_vals = (double *)&(data[pos]);
+      for(j=0;j<run[1];j++){
+        if( elem_size == sizeof(float) ) mat[i++] = float_vals[j];
+        else mat[i++] = double_vals[j];
+      }
+      pos += run[1]*elem_size;
+    }
+    /* anything left over is zero */
+    for(;i<num_vals;i++) mat[i] = 0.0;
+  }
+  free(data);
+  return 1;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure matrix_dump_map
+ *
+ * Arguments: reader: pointer to matrix_dump_reader_type
+ *          which_k: int
+ *
+ * Returns: pointer to void
+ *
+ * Action: maps the matrix for k point 'which_k into memory without
+ *   copying it.  The result points to num_orbs*num_orbs floats or
+ *   doubles (depending on header.element_type) and should be released
+ *   with matrix_dump_unmap.
+ *
+ *   Returns 0 for compressed matrices (use matrix_dump_read for those),
+ *    if the matrix isn't there, or if mapping isn't supported.
+ *
+ ************************************************************************/
+void *matrix_dump_map(matrix_dump_reader_type *reader,int which_k)
+{
+#ifndef _WIN32
+  matrix_dump_index_type *entry;
+  long long page_size,start;
+  char *data;
+
+  if( which_k < 0 || which_k >= reader->header.num_kpoints ) return 0;
+  if( reader->header.compression != MATRIX_DUMP_NONE ) return 0;
+  entry = &(reader->index[which_k]);
+  if( !entry->size ) return 0;
+
+  /* the system page size may be bigger than the one used in the file */
+  page_size = sysconf(_SC_PAGESIZE);
+  start = (entry->offset/page_size)*page_size;
+  data = (char *)mmap(0,entry->size+(entry->offset-start),PROT_READ,MAP_SHARED,
+                      reader->file,(off_t)start);
+  if( data == (char *)MAP_FAILED ) return 0;
+  return data + (entry->offset-start);
+#else
+  return 0;
+#endif
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure matrix_dump_unmap
+ *
+ * Arguments: reader: pointer to matrix_dump_reader_type
+ *          which_k: int
+ *             data: pointer to void
+ *
+ * Returns: none
+ *
+ * Action: releases a matrix mapped by matrix_dump_map
+ *
+ ************************************************************************/
+void matrix_dump_unmap(matrix_dump_reader_type *reader,int which_k,void *data)
+{
+#ifndef _WIN32
+  matrix_dump_index_type *entry;
+  long long page_size,start;
+
+  if( !data ) return;
+  entry = &(reader->index[which_k]);
+  page_size = sysconf(_SC_PAGESIZE);
+  start = (entry->offset/page_size)*page_size;
+  munmap((char *)data - (entry->offset-start),entry->size+(entry->offset-start));
+#endif
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure matrix_dump_element
+ *
+ * Arguments: reader: pointer to matrix_dump_reader_type
+ *             mat: pointer to double
+ *         row,col: ints
+ *            imag: pointer to double
+ *
+ * Returns: double
+ *
+ * Action: returns the real part of element ('row,'col) of a matrix
+ *   read with matrix_dump_read.  If 'imag is nonzero, the imaginary
+ *   part is put there.
+ *
+ ************************************************************************/
+double matrix_dump_element(matrix_dump_reader_type *reader,double *mat,
+                           int row,int col,double *imag)
+{
+  int num_orbs;
+
+  num_orbs = reader->header.num_orbs;
+  if( row == col ){
+    if( imag ) *imag = 0.0;
+    return mat[row*num_orbs+row];
+  }
+  if( row > col ){
+    if( imag ) *imag = mat[row*num_orbs+col];
+    return mat[col*num_orbs+row];
+  }
+  if( imag ) *imag = -mat[col*num_orbs+row];
+  return mat[row*num_orbs+col];
+}
@@ -0,0 +1,80 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+/************************************************************************
+  This is the include file for the library used to read the binary
+   matrix dumps (.OV and .HAM files) written by bind.
+
+  Typical use:
+
+    matrix_dump_reader_type *reader;
+    double *mat;
+
+    reader = matrix_dump_open("example.HAM");
+    mat = (double *)calloc(reader->header.num_orbs*reader->header.num_orbs,
+                           sizeof(double));
+    for(k=0;k<reader->header.num_kpoints;k++){
+      if( matrix_dump_read(reader,k,mat) ){
+        ...
+      }
+    }
+    matrix_dump_close(reader);
+
+  Uncompressed matrices can also be mapped straight out of the file
+   with matrix_dump_map (not available on Windows).
+
+  Files in the old format (no header, just two ints and the matrices)
+   can be read as well.  The format is described in ../matrix_dump.h
+************************************************************************/
+#ifndef MATRIX_DUMP_READER_DEFINED
+#define MATRIX_DUMP_READER_DEFINED
+
+#include "../matrix_dump.h"
+
+typedef struct {
+  int file;
+  matrix_dump_header_type header;
+  matrix_dump_index_type *index;
+  /* x, y, z and weight for each k point */
+  double *kpoints;
+} matrix_dump_reader_type;
+
+extern matrix_dump_reader_type *matrix_dump_open(char *name);
+extern void matrix_dump_close(matrix_dump_reader_type *reader);
+extern int matrix_dump_read(matrix_dump_reader_type *reader,int which_k,
+                            double *mat);
+extern void *matrix_dump_map(matrix_dump_reader_type *reader,int which_k);
+extern void matrix_dump_unmap(matrix_dump_reader_type *reader,int which_k,
+                              void *data);
+extern double matrix_dump_element(matrix_dump_reader_type *reader,double *mat,
+                                  int row,int col,double *imag);
+
+#endif
@@ -12,6 +12,7 @@
 #include <fcntl.h>
 
 #include "fit_props.h"
+#include "matrix_dump_reader.h"
 
 /* the width and height in points */
 #define BOX_WIDTH 432
@@ -33,14 +34,14 @@ void main(argc, argv)
   int argc;
   char **argv;
 {
-  int infile;
+  matrix_dump_reader_type *reader;
   FILE *psfile,*the_file;
   int num_orbs,num_mats;
   char draw_grid;
   real xp,yp;
   real xgap,ygap;
   int i,j,curr_mat;
-  real *matrix;
+  double *matrix;
   real realpart,imagpart;
   real mag,max_mag;
   real gray;
@@ -54,21 +55,19 @@ void main(argc, argv)
   else draw_grid = 0;
 
   /* open the file */
-  infile = open(argv[1],O_RDONLY,"r");
+  reader = matrix_dump_open(argv[1]);
 
-  if( infile == -1 ){
+  if( !reader ){
     error("Can't open file for binary I/O.");
     return;
   }
 
-  /* read out the number of matrices */
-  read(infile,(const char *)&num_mats,sizeof(int));
-  /* now the number of orbitals */
-  read(infile,(const char *)&num_orbs,sizeof(int));
-
+  /* the number of matrices (one per k point) and orbitals */
+  num_mats = reader->header.num_kpoints;
+  num_orbs = reader->header.num_orbs;
 
   /* get space to store the matrices */
-  matrix = (real *)calloc(num_orbs*num_orbs,sizeof(real));
+  matrix = (double *)calloc(num_orbs*num_orbs,sizeof(double));
   if(!matrix) fatal("Can't get space for the matrix\n");
 
   /* open the ps file */
@@ -94,7 +93,10 @@ void main(argc, argv)
   ygap = (real)BOX_HEIGHT / (real)num_orbs;
   /* now read in the matrices one at a time */
   for(curr_mat=0;curr_mat<num_mats;curr_mat++){
-    read(infile,(const char *)matrix,num_orbs*num_orbs*sizeof(real));
+    if( !matrix_dump_read(reader,curr_mat,matrix) ){
+      error("Can't read a matrix from the file.");
+      break;
+    }
 
     /* find the maximum value */
     max_mag = 0.0;
@@ -168,7 +170,7 @@ void main(argc, argv)
   }
 
   fclose(psfile);
-  close(infile);
+  matrix_dump_close(reader);
 
 }
 
@@ -0,0 +1,339 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+/************************************************************************
+
+  These are the routines for reading the binary results (.bres) files
+   written by bind.  See results_reader.h for how to use them.
+
+  None of these call exit(); errors are reported on stderr and
+   through the return values.
+
+************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "results_reader.h"
+
+
+/************************************************************************
+ *
+ *                   Procedure results_element_size
+ *
+ * Arguments: type: int
+ *
+ * Returns: int
+ *
+ * Action: returns the size (in bytes) of the elements of 'type, or 0
+ *   if 'type isn't a valid type.
+ *
+ ************************************************************************/
+int results_element_size(int type)
+{
+  switch(type){
+  case RESULTS_CHAR: return sizeof(char);
+  case RESULTS_INT: return sizeof(int);
+  case RESULTS_FLOAT: return sizeof(float);
+  case RESULTS_DOUBLE: return sizeof(double);
+  }
+  return 0;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure results_open
+ *
+ * Arguments: name: pointer to char
+ *
+ * Returns: pointer to results_reader_type
+ *
+ * Action: opens the results file 'name and checks its header.
+ *   Returns 0 if the file can't be opened or isn't a results file.
+ *
+ ************************************************************************/
+results_reader_type *results_open(char *name)
+{
+  results_reader_type *reader;
+  results_header_type header;
+  FILE *file;
+
+  file = fopen(name,"rb");
+  if( !file ){
+    fprintf(stderr,"Can't open results file %s\n",name);
+    return 0;
+  }
+  if( fread(&header,sizeof(results_header_type),1,file) != 1 ||
+      strncmp(header.magic,RESULTS_MAGIC,8) ){
+    fprintf(stderr,"%s is not a binary results file.\n",name);
+    fclose(file);
+    return 0;
+  }
+  if( header.byte_order != RESULTS_BYTE_ORDER ){
+    fprintf(stderr,"%s was written on a machine with a different byte order.\n",
+            name);
+    fclose(file);
+    return 0;
+  }
+  if( header.version > RESULTS_VERSION ){
+    fprintf(stderr,"%s was written by a newer version of bind (%d).\n",
+            name,header.version);
+    fclose(file);
+    return 0;
+  }
+
+  reader = (results_reader_type *)calloc(1,sizeof(results_reader_type));
+  if( !reader ){
+    fclose(file);
+    return 0;
+  }
+  reader->file = file;
+  reader->version = header.version;
+  reader->data_pos = ftell(file);
+  reader->data_size = 0;
+  return reader;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure results_close
+ *
+ * Arguments: reader: pointer to results_reader_type
+ *
+ * Returns: none
+ *
+ * Action: closes the file and frees 'reader.
+ *
+ ************************************************************************/
+void results_close(results_reader_type *reader)
+{
+  if( !reader ) return;
+  fclose(reader->file);
+  free(reader);
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure results_next_chunk
+ *
+ * Arguments: reader: pointer to results_reader_type
+ *             chunk: pointer to results_chunk_type
+ *
+ * Returns: int
+ *
+ * Action: reads the header of the next chunk in the file into 'chunk
+ *   (skipping over the data of the current one).
+ *
+ *   Returns 1 if a chunk was read, 0 at the end of the file.
+ *
+ ************************************************************************/
+int results_next_chunk(results_reader_type *reader,results_chunk_type *chunk)
+{
+  int elem_size;
+
+  if( fseek(reader->file,reader->data_pos+reader->data_size,SEEK_SET) ) return 0;
+  if( fread(chunk,sizeof(results_chunk_type),1,reader->file) != 1 ) return 0;
+  chunk->name[RESULTS_NAME_LEN-1] = 0;
+  if( !strcmp(chunk->name,"END") ) return 0;
+
+  elem_size = results_element_size(chunk->type);
+  if( !elem_size || chunk->num_elements < 0 ){
+    fprintf(stderr,"Corrupt chunk (%s) in results file.\n",chunk->name);
+    return 0;
+  }
+  reader->data_pos = ftell(reader->file);
+  reader->data_size = (long)elem_size*chunk->num_elements;
+  return 1;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure results_find_chunk
+ *
+ * Arguments: reader: pointer to results_reader_type
+ *              name: pointer to char
+ *   step,kpoint,index: ints
+ *             chunk: pointer to results_chunk_type
+ *
+ * Returns: int
+ *
+ * Action: searches forward from the current position for the next chunk
+ *   named 'name.  'step, 'kpoint and 'index have to match too, unless
+ *   they are set to -2 (which matches anything).
+ *
+ *   Returns 1 if the chunk was found.
+ *
+ ************************************************************************/
+int results_find_chunk(results_reader_type *reader,char *name,int step,
+                       int kpoint,int index,results_chunk_type *chunk)
+{
+  while( results_next_chunk(reader,chunk) ){
+    if( !strcmp(chunk->name,name) &&
+        (step == -2 || chunk->step == step) &&
+        (kpoint == -2 || chunk->kpoint == kpoint) &&
+        (index == -2 || chunk->index == index) ){
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure results_read_data
+ *
+ * Arguments: reader: pointer to results_reader_type
+ *             chunk: pointer to results_chunk_type
+ *              dest: pointer to void
+ *
+ * Returns: int
+ *
+ * Action: reads the data for 'chunk (which must be the last chunk
+ *   returned by results_next_chunk) into 'dest, without any conversion.
+ *
+ *   Returns 1 on success.
+ *
+ ************************************************************************/
+int results_read_data(results_reader_type *reader,results_chunk_type *chunk,
+                      void *dest)
+{
+  if( !chunk->num_elements ) return 1;
+  if( fseek(reader->file,reader->data_pos,SEEK_SET) ) return 0;
+  if( fread(dest,results_element_size(chunk->type),chunk->num_elements,
+            reader->file) != chunk->num_elements ){
+    fprintf(stderr,"Short read of chunk (%s) in results file.\n",chunk->name);
+    return 0;
+  }
+  return 1;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure results_read_doubles
+ *
+ * Arguments: reader: pointer to results_reader_type
+ *             chunk: pointer to results_chunk_type
+ *
+ * Returns: pointer to double
+ *
+ * Action: reads the data for 'chunk and converts it to doubles.  The
+ *   caller is responsible for freeing the returned array.
+ *
+ *   Returns 0 on failure.
+ *
+ ************************************************************************/
+double *results_read_doubles(results_reader_type *reader,
+                             results_chunk_type *chunk)
+{
+  double *vals;
+  char *raw;
+  int i;
+
+  vals = (double *)calloc(chunk->num_elements ? chunk->num_elements : 1,
+                          sizeof(double));
+  if( !vals ) return 0;
+  if( chunk->type == RESULTS_DOUBLE ){
+    if( !results_read_data(reader,chunk,vals) ){
+      free(vals);
+      return 0;
+    }
+    return vals;
+  }
+
+  raw = (char *)calloc(chunk->num_elements ? chunk->num_elements : 1,
+                       results_element_size(chunk->type));
+  if( !raw || !results_read_data(reader,chunk,raw) ){
+    if( raw ) free(raw);
+    free(vals);
+    return 0;
+  }
+  for(i=0;i<chunk->num_elements;i++){
+    switch(chunk->type){
+    case RESULTS_CHAR: vals[i] = (double)raw[i]; break;
+    case RESULTS_INT: vals[i] = (double)((int *)raw)[i]; break;
+    case RESULTS_FLOAT: vals[i] = (double)((float *)raw)[i]; break;
+    }
+  }
+  free(raw);
+  return vals;
+}
+
+
+/************************************************************************
+ *
+ *                   Procedure results_matrix_element
+ *
+ * Arguments: chunk: pointer to results_chunk_type
+ *             vals: pointer to double
+ *          row,col: ints
+ *             imag: pointer to double
+ *
+ * Returns: double
+ *
+ * Action: returns element ('row,'col) of the matrix in 'vals (as
+ *   returned by results_read_doubles), taking care of the layout of
+ *   the matrix.
+ *
+ *   If 'imag is nonzero, the imaginary part of the element is stored
+ *    there (this is only nonzero for RESULTS_HERMETIAN matrices).
+ *
+ ************************************************************************/
+double results_matrix_element(results_chunk_type *chunk,double *vals,
+                              int row,int col,double *imag)
+{
+  int tmp;
+
+  if( imag ) *imag = 0.0;
+  switch(chunk->layout){
+  case RESULTS_SYMMETRIC:
+    if( col > row ){
+      tmp = row;
+      row = col;
+      col = tmp;
+    }
+    return vals[row*(row+1)/2+col];
+  case RESULTS_HERMETIAN:
+    if( imag && row != col ){
+      if( row > col ) *imag = vals[row*chunk->cols+col];
+      else *imag = -vals[col*chunk->cols+row];
+    }
+    if( row > col ) return vals[col*chunk->cols+row];
+    return vals[row*chunk->cols+col];
+  default:
+    return vals[row*chunk->cols+col];
+  }
+}
@@ -0,0 +1,83 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+/************************************************************************
+  This is the include file for the library used to read the binary
+   results (.bres) files written by bind.
+
+  Typical use:
+
+    results_reader_type *reader;
+    results_chunk_type chunk;
+    double *vals;
+
+    reader = results_open("example.bres");
+    while( results_next_chunk(reader,&chunk) ){
+      if( !strcmp(chunk.name,"energies") ){
+        vals = results_read_doubles(reader,&chunk);
+        ...
+        free(vals);
+      }
+    }
+    results_close(reader);
+
+  Chunks which aren't read are skipped automatically by
+   results_next_chunk.  The format itself is described in ../results.h
+************************************************************************/
+#ifndef RESULTS_READER_DEFINED
+#define RESULTS_READER_DEFINED
+
+#include <stdio.h>
+#include "../results.h"
+
+typedef struct {
+  FILE *file;
+  int version;
+  /* where the data for the current chunk starts and how big it is */
+  long data_pos, data_size;
+} results_reader_type;
+
+extern results_reader_type *results_open(char *name);
+extern void results_close(results_reader_type *reader);
+extern int results_next_chunk(results_reader_type *reader,
+                              results_chunk_type *chunk);
+extern int results_find_chunk(results_reader_type *reader,char *name,
+                              int step,int kpoint,int index,
+                              results_chunk_type *chunk);
+extern int results_element_size(int type);
+extern int results_read_data(results_reader_type *reader,
+                             results_chunk_type *chunk,void *dest);
+extern double *results_read_doubles(results_reader_type *reader,
+                                    results_chunk_type *chunk);
+extern double results_matrix_element(results_chunk_type *chunk,double *vals,
+                                     int row,int col,double *imag);
+
+#endif
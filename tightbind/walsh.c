@@ -359,6 +359,25 @@ void walsh_update(cell_type *cell,detail_type *details,int step,char printing)
 
 
 
+/****************************************************************************
+*
+*                   Procedure put_walsh_value
+*
+* Arguments:  val: real
+*
+* Returns: none
+*
+* Action:   writes one of the values for the current Walsh step into the
+*  walsh output file (and the results file, if there is one).
+*
+*****************************************************************************/
+static void put_walsh_value(real val)
+{
+  fprintf(walsh_file,"%8.6lf ",val);
+  results_table_value(val);
+}
+
+
 /****************************************************************************
 *
 *                   Procedure walsh_output
@@ -393,8 +412,10 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
   /**********
     if this is the first time that this function was called in this particular run
     of the program then print out header information that tells what each of the
-    columns in the file are.
+    columns in the file are.  (A run restarted from a checkpoint after the
+    first step already has the header.)
   ***********/
+  if( first_call && step > 0 ) first_call = 0;
   if( first_call ){
     fprintf(walsh_file,"# Walsh output for job: %s\n",details->title);
     fprintf(walsh_file,"# This is the key to the columns printed out below.\n");
@@ -548,9 +569,12 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
     now actually print out the results that are desired
   ********************/
 
+  /* the values also go into the results file as a single column */
+  results_begin_table("walsh_values",-1,1);
+
   /* print out the values of the Walsh variables */
   for(i=0;i<details->walsh_details.num_vars;i++){
-    fprintf(walsh_file,"%8.6lf ",
+    put_walsh_value(
             details->walsh_details.values[i*details->walsh_details.num_steps+step]);
   }
 
@@ -562,7 +586,7 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
     case PRT_OP:
       switch(p_info->type){
       case P_DOS_ORB:
-        fprintf(walsh_file,"%8.6lf ",properties.OP_mat[p_info->contrib1*num_orbs+
+        put_walsh_value(properties.OP_mat[p_info->contrib1*num_orbs+
                                                         p_info->contrib2]);
         break;
       }
@@ -571,11 +595,11 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
       switch(p_info->type){
       case P_DOS_ATOM:
         if( p_info->contrib1 > p_info->contrib2 ){
-          fprintf(walsh_file,"%8.6lf ",
+          put_walsh_value(
                   properties.ROP_mat[p_info->contrib1*(p_info->contrib1+1)/2
                                      + p_info->contrib2]);
         } else{
-          fprintf(walsh_file,"%8.6lf ",
+          put_walsh_value(
                   properties.ROP_mat[p_info->contrib2*(p_info->contrib2+1)/2
                                      + p_info->contrib1]);
         }
@@ -585,7 +609,7 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
     case PRT_OVERLAP:
       switch(p_info->type){
       case P_DOS_ORB:
-        fprintf(walsh_file,"%8.6lf ",
+        put_walsh_value(
                 HERMETIAN_R(overlap,(p_info->contrib1),(p_info->contrib2)));
                 break;
       }
@@ -593,7 +617,7 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
     case PRT_HAMIL:
       switch(p_info->type){
       case P_DOS_ORB:
-        fprintf(walsh_file,"%8.6lf ",
+        put_walsh_value(
                 HERMETIAN_R(hamil,(p_info->contrib1),(p_info->contrib2)));
                 break;
       }
@@ -601,7 +625,7 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
     case PRT_CHG_MAT:
       switch(p_info->type){
       case P_DOS_ORB:
-        fprintf(walsh_file,"%8.6lf ",properties.chg_mat[p_info->contrib1*num_orbs+
+        put_walsh_value(properties.chg_mat[p_info->contrib1*num_orbs+
                                                          p_info->contrib2]);
         break;
       }
@@ -609,7 +633,7 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
     case PRT_RCHG_MAT:
       switch(p_info->type){
       case P_DOS_ATOM:
-        fprintf(walsh_file,"%8.6lf ",properties.Rchg_mat[p_info->contrib1*cell->num_atoms
+        put_walsh_value(properties.Rchg_mat[p_info->contrib1*cell->num_atoms
                                                           +p_info->contrib2]);
           break;
       }
@@ -617,14 +641,14 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
     case PRT_NET_CHG:
       switch(p_info->type){
       case P_DOS_ATOM:
-        fprintf(walsh_file,"%8.6lf ",properties.net_chgs[p_info->contrib1]);
+        put_walsh_value(properties.net_chgs[p_info->contrib1]);
         break;
       }
       break;
     case PRT_WAVE_FUNC:
       switch(p_info->type){
       case P_DOS_ORB:
-        fprintf(walsh_file,"%8.6lf ",EIGENVECT_R(eigenset,p_info->contrib2,
+        put_walsh_value(EIGENVECT_R(eigenset,p_info->contrib2,
                                                  p_info->contrib1));
         break;
       }
@@ -633,8 +657,8 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
       switch(p_info->type){
       case P_DOS_ATOM:
         /********
-          since the distance mat is stored as a symmetric matrix, we have to do
-          a little extra work to get the element out
+          the larger atom number goes first so that this gives exactly
+          what the distance matrix would
           ********/
         if( p_info->contrib1 < p_info->contrib2 ){
           atom1 = p_info->contrib1;
@@ -643,28 +667,28 @@ void walsh_output(detail_type *details,cell_type *cell,int num_orbs,eigenset_typ
           atom1 = p_info->contrib2;
           atom2 = p_info->contrib1;
         }
-        fprintf(walsh_file,"%8.6lf ",
-                cell->distance_mat[(atom2*(atom2+1))/2 + atom1]);
+        put_walsh_value(atom_distance(cell,atom2,atom1));
         break;
       }
       break;
     case PRT_ENERGIES:
-      fprintf(walsh_file,"%8.6lf ",properties.total_E);
+      put_walsh_value(properties.total_E);
       break;
     case PRT_ORB_ENERGY:
-      fprintf(walsh_file,"%8.6lf ",EIGENVAL(eigenset,p_info->contrib1));
+      put_walsh_value(EIGENVAL(eigenset,p_info->contrib1));
       break;
     case PRT_ORB_COEFF:
-      fprintf(walsh_file,"%8.6lf ",
+      put_walsh_value(
               EIGENVECT_R(eigenset,p_info->contrib2,p_info->contrib1));
       break;
     case PRT_ELECTROSTAT:
-      fprintf(walsh_file,"%8.6lf ",properties.electrostat_E);
+      put_walsh_value(properties.electrostat_E);
       break;
     }
     p_info = p_info->next;
   }
   /* put in a carriage return to finish the line */
   fprintf(walsh_file,"\n");
+  results_end_table();
 }
 
@@ -0,0 +1,332 @@
+/*******************************************************
+
+Copyright (C) 1995 Greg Landrum
+All rights reserved
+
+This file is part of yaehmop.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+1. Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+********************************************************************/
+
+/****************************************************************************
+*
+*     this file contains the worker mode of bind (bind --worker).
+*
+*   A worker reads jobs from stdin and writes the results to stdout
+*    until stdin is closed (or it gets a "quit" line), so a program
+*    that runs lots of calculations can keep a few workers going instead
+*    of starting bind for each one.
+*
+*   Everything is framed by a one line text header which gives the
+*    length of the (binary) data following it:
+*
+*     request:   job <id> <length>\n<the input file>
+*                quit\n
+*
+*     response:  begin <id>\n
+*                frame <id> <channel> <length>\n<data>    (zero or more)
+*                end <id> <exit status>\n
+*
+*   <id> is any word without spaces, it's just handed back.  Each frame
+*    holds one of the files bind made for the job, the channel is the
+*    extension of the file: "status", "out", "band", "walsh", "MO",
+*    "bres" (the binary results, which are always written in worker
+*    mode, see results.h), plus "stdout" and "stderr".  The exit status
+*    is 0 if bind finished normally.
+*
+*   Each job is run in a child process forked from the worker, so a
+*    job that dies (with fatal()) can't take the worker down with it and
+*    every job starts from a clean set of globals.  The parameter file
+*    is read once, before the first job, and shared with the children.
+*    The files for a job are made in a scratch directory which is
+*    emptied after each job and removed when the worker exits.
+*
+*   This needs fork(), so there is no worker mode on Windows.
+*
+*****************************************************************************/
+
+#include "bind.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <dirent.h>
+#include <sys/wait.h>
+
+#define WORKER_JOB_NAME "job"
+
+static char scratch_dir[MAX_STR_LEN];
+
+
+/****************************************************************************
+*
+*                   Procedure clear_scratch_dir
+*
+* Arguments: none
+*
+* Returns: none
+*
+* Action: removes all the files in the scratch directory.
+*
+*****************************************************************************/
+static void clear_scratch_dir()
+{
+  DIR *dir;
+  struct dirent *entry;
+  char path[2*MAX_STR_LEN];
+
+  dir = opendir(scratch_dir);
+  if( !dir ) return;
+  while( (entry = readdir(dir)) ){
+    if( entry->d_name[0] == '.' ) continue;
+    sprintf(path,"%s/%s",scratch_dir,entry->d_name);
+    remove(path);
+  }
+  closedir(dir);
+}
+
+
+/****************************************************************************
+*
+*                   Function send_frame
+*
+* Arguments: id: pointer to char
+*       channel: pointer to char
+*          path: pointer to char
+*
+* Returns: int
+*
+* Action: writes the contents of the file 'path to stdout as a frame
+*   for 'channel.  Returns 0 if stdout couldn't be written.
+*
+*****************************************************************************/
+static int send_frame(char *id,char *channel,char *path)
+{
+  FILE *infile;
+  char buffer[8192];
+  long length;
+  size_t num_read;
+
+  infile = fopen(path,"rb");
+  if( !infile ) return 1;
+  fseek(infile,0,SEEK_END);
+  length = ftell(infile);
+  rewind(infile);
+
+  fprintf(stdout,"frame %s %s %ld\n",id,channel,length);
+  while( length > 0 &&
+         (num_read = fread(buffer,1,sizeof(buffer),infile)) > 0 ){
+    if( fwrite(buffer,1,num_read,stdout) != num_read ){
+      fclose(infile);
+      return 0;
+    }
+    length -= num_read;
+  }
+  fclose(infile);
+
+  /* in case the file was cut short while it was being read */
+  while( length-- > 0 ) putc(0,stdout);
+  return !ferror(stdout);
+}
+
+
+/****************************************************************************
+*
+*                   Function send_results
+*
+* Arguments: id: pointer to char
+*
+* Returns: int
+*
+* Action: sends a frame for each of the files the job made in the
+*   scratch directory.  The output files are sent first, in a fixed
+*   order, then whatever else is there.
+*
+*****************************************************************************/
+static int send_results(char *id)
+{
+  static char *first_channels[]={"status","out","stdout","stderr",0};
+  DIR *dir;
+  struct dirent *entry;
+  char path[2*MAX_STR_LEN];
+  char *channel;
+  int prefix_len;
+  int i;
+
+  prefix_len = strlen(WORKER_JOB_NAME)+1;
+  for(i=0;first_channels[i];i++){
+    sprintf(path,"%s/%s.%s",scratch_dir,WORKER_JOB_NAME,first_channels[i]);
+    if( !send_frame(id,first_channels[i],path) ) return 0;
+  }
+
+  dir = opendir(scratch_dir);
+  if( !dir ) return 1;
+  while( (entry = readdir(dir)) ){
+    if( strncmp(entry->d_name,WORKER_JOB_NAME ".",prefix_len) ) continue;
+    channel = entry->d_name+prefix_len;
+    for(i=0;first_channels[i] && strcmp(channel,first_channels[i]);i++);
+    if( first_channels[i] ) continue;
+    sprintf(path,"%s/%s",scratch_dir,entry->d_name);
+    if( !send_frame(id,channel,path) ){
+      closedir(dir);
+      return 0;
+    }
+  }
+  closedir(dir);
+  return 1;
+}
+
+
+/****************************************************************************
+*
+*                   Function run_job
+*
+* Arguments: parm_file_name: pointer to char
+*
+* Returns: int
+*
+* Action: runs the input file in the scratch directory in a child
+*   process and returns its exit status (or minus the signal which
+*   killed it).
+*
+*****************************************************************************/
+static int run_job(char *parm_file_name)
+{
+  char file_name[2*MAX_STR_LEN],path[2*MAX_STR_LEN];
+  pid_t pid;
+  int status,fd;
+
+  sprintf(file_name,"%s/%s",scratch_dir,WORKER_JOB_NAME);
+
+  fflush(stdout);
+  fflush(stderr);
+  pid = fork();
+  if( pid < 0 ){
+    fprintf(stderr,"bind worker: can't fork.\n");
+    return -1;
+  }
+  if( pid == 0 ){
+    /******
+      the child: keep its stdout and stderr out of the protocol
+      stream, and make sure it can't touch the worker's stdin.
+    ******/
+    fd = open("/dev/null",O_RDONLY);
+    if( fd >= 0 ){
+      dup2(fd,0);
+      close(fd);
+    }
+    if( snprintf(path,sizeof(path),"%s.stdout",file_name) >= (int)sizeof(path) ||
+        !freopen(path,"w",stdout) ) _exit(-1);
+    if( snprintf(path,sizeof(path),"%s.stderr",file_name) >= (int)sizeof(path) ||
+        !freopen(path,"w",stderr) ) _exit(-1);
+
+    force_binary_results = true;
+    run_bind(file_name,false,parm_file_name);
+    exit(0);
+  }
+
+  while( waitpid(pid,&status,0) < 0 ){
+    if( errno != EINTR ) return -1;
+  }
+  if( WIFEXITED(status) ) return WEXITSTATUS(status);
+  if( WIFSIGNALED(status) ) return -WTERMSIG(status);
+  return -1;
+}
+
+
+/****************************************************************************
+*
+*                   Procedure run_worker
+*
+* Arguments: parm_file_name: pointer to char
+*
+* Returns: none
+*
+* Action: reads and runs jobs from stdin until it's closed.
+*
+*****************************************************************************/
+void run_worker(char *parm_file_name)
+{
+  char header[MAX_STR_LEN],id[MAX_STR_LEN],command[MAX_STR_LEN];
+  char file_name[2*MAX_STR_LEN];
+  char *tmpdir;
+  char buffer[8192];
+  FILE *job_file;
+  long length,chunk;
+  int exit_status;
+
+  tmpdir = getenv("TMPDIR");
+  if( !tmpdir || !tmpdir[0] ) tmpdir = "/tmp";
+  sprintf(scratch_dir,"%.*s/bind_worker.XXXXXX",MAX_STR_LEN-40,tmpdir);
+  if( !mkdtemp(scratch_dir) ) fatal("Can't make the worker's scratch directory");
+  sprintf(file_name,"%s/%s",scratch_dir,WORKER_JOB_NAME);
+
+  /* the children all use this */
+  shared_parm_table(parm_file_name);
+
+  while( fgets(header,MAX_STR_LEN,stdin) ){
+    if( sscanf(header,"%s",command) != 1 ) continue;
+    if( !strcmp(command,"quit") ) break;
+    if( strcmp(command,"job") || sscanf(header,"%*s %s %ld",id,&length) != 2 ||
+        length < 0 ){
+      fprintf(stderr,"bind worker: bad request: %s",header);
+      break;
+    }
+
+    /* copy the input file into the scratch directory */
+    job_file = fopen(file_name,"wb");
+    if( !job_file ) fatal("Can't write the worker's input file");
+    while( length > 0 ){
+      chunk = length < (long)sizeof(buffer) ? length : (long)sizeof(buffer);
+      if( fread(buffer,1,chunk,stdin) != (size_t)chunk ) break;
+      fwrite(buffer,1,chunk,job_file);
+      length -= chunk;
+    }
+    fclose(job_file);
+    if( length > 0 ){
+      fprintf(stderr,"bind worker: input ended in the middle of job %s.\n",id);
+      break;
+    }
+
+    exit_status = run_job(parm_file_name);
+
+    fprintf(stdout,"begin %s\n",id);
+    if( !send_results(id) ) break;
+    fprintf(stdout,"end %s %d\n",id,exit_status);
+    fflush(stdout);
+    clear_scratch_dir();
+  }
+
+  clear_scratch_dir();
+  rmdir(scratch_dir);
+}
+
+#else
+
+void run_worker(char *parm_file_name)
+{
+  fatal("Worker mode isn't available on this platform");
+}
+
+#endif
@@ -44,6 +44,52 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "bind.h"
 
 
+/****************************************************************************
+*
+*                   Procedure xtal_coord_tform
+*
+* Arguments: cell: pointer to cell_type
+*       tform_mat: 3x3 array of reals
+*     cell_volume: pointer to real
+*
+* Returns: none
+*
+* Action: fills 'tform_mat with the matrix which takes crystallographic
+*   coordinates (in the cell described by 'cell->xtal_defn) into
+*   cartesian coordinates.  The matrix is upper triangular.
+*
+*****************************************************************************/
+void xtal_coord_tform(cell_type *cell,real tform_mat[3][3],
+                      real *cell_volume)
+{
+  real cos_alpha,cos_beta,cos_gamma,sin_gamma;
+  real weird_term;
+
+  cos_alpha = cos(cell->xtal_defn.angles[0]*PI/180.0);
+  cos_beta = cos(cell->xtal_defn.angles[1]*PI/180.0);
+  cos_gamma = cos(cell->xtal_defn.angles[2]*PI/180.0);
+  sin_gamma = sin(cell->xtal_defn.angles[2]*PI/180.0);
+  weird_term = sqrt(1-cos_alpha*cos_alpha-cos_beta*cos_beta-
+                    cos_gamma*cos_gamma + 2.0*cos_alpha*cos_beta*cos_gamma);
+  *cell_volume = weird_term*cell->xtal_defn.axis_lengths[0]*
+    cell->xtal_defn.axis_lengths[1]*cell->xtal_defn.axis_lengths[2];
+
+  /* first do the diagonal terms */
+  tform_mat[0][0] = cell->xtal_defn.axis_lengths[0];
+  tform_mat[1][1] = cell->xtal_defn.axis_lengths[1]*sin_gamma;
+  tform_mat[2][2] = cell->xtal_defn.axis_lengths[2]*weird_term/sin_gamma;
+
+  /* now the off diagonals */
+  tform_mat[0][1] = cell->xtal_defn.axis_lengths[1]*cos_gamma;
+  tform_mat[0][2] = cell->xtal_defn.axis_lengths[2]*cos_beta;
+  tform_mat[1][2] = cell->xtal_defn.axis_lengths[2]*(cos_alpha-cos_beta*cos_gamma) /
+    sin_gamma;
+  tform_mat[1][0] = 0.0;
+  tform_mat[2][0] = 0.0;
+  tform_mat[2][1] = 0.0;
+}
+
+
 /****************************************************************************
 *
 *                   Procedure eval_xtal_coord_locs
@@ -71,8 +117,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 void eval_xtal_coord_locs(cell_type *cell,char printing)
 {
   int i;
-  real cos_alpha,cos_beta,cos_gamma,sin_gamma;
-  real weird_term,cell_volume;
+  real cell_volume;
   real tform_mat[3][3];
 
   /* write the crystallographic information if we need to */
@@ -90,34 +135,13 @@ void eval_xtal_coord_locs(cell_type *cell,char printing)
 
 
   /* set up the transformation matrix */
-  cos_alpha = cos(cell->xtal_defn.angles[0]*PI/180.0);
-  cos_beta = cos(cell->xtal_defn.angles[1]*PI/180.0);
-  cos_gamma = cos(cell->xtal_defn.angles[2]*PI/180.0);
-  sin_gamma = sin(cell->xtal_defn.angles[2]*PI/180.0);
-  weird_term = sqrt(1-cos_alpha*cos_alpha-cos_beta*cos_beta-
-                    cos_gamma*cos_gamma + 2.0*cos_alpha*cos_beta*cos_gamma);
-  cell_volume = weird_term*cell->xtal_defn.axis_lengths[0]*
-    cell->xtal_defn.axis_lengths[1]*cell->xtal_defn.axis_lengths[2];
+  xtal_coord_tform(cell,tform_mat,&cell_volume);
 
   if( printing ){
     fprintf(output_file,"#Cell Volume: %6.4lf cubic Angstroms\n",cell_volume);
   }
 
 
-  /* first do the diagonal terms */
-  tform_mat[0][0] = cell->xtal_defn.axis_lengths[0];
-  tform_mat[1][1] = cell->xtal_defn.axis_lengths[1]*sin_gamma;
-  tform_mat[2][2] = cell->xtal_defn.axis_lengths[2]*weird_term/sin_gamma;
-
-  /* now the off diagonals */
-  tform_mat[0][1] = cell->xtal_defn.axis_lengths[1]*cos_gamma;
-  tform_mat[0][2] = cell->xtal_defn.axis_lengths[2]*cos_beta;
-  tform_mat[1][2] = cell->xtal_defn.axis_lengths[2]*(cos_alpha-cos_beta*cos_gamma) /
-    sin_gamma;
-  tform_mat[1][0] = 0.0;
-  tform_mat[2][0] = 0.0;
-  tform_mat[2][1] = 0.0;
-
   /* now transform all the atomic locations */
   transform_atoms(cell->atoms,tform_mat,cell->num_raw_atoms);
 
@@ -39,7 +39,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *****************************************************************************/
 #include "bind.h"
 
-
+/******
+  the charges from the last call and the number of calls so far.
+  These live out here so that they can be saved in checkpoints.
+******/
+static real *last_chgs=0;
+static int num_calls=0;
 
 
 /****************************************************************************
@@ -67,8 +72,6 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  ****************************************************************************/
 void update_zetas(cell_type *cell,real *net_chgs,real zeta_tol,int *converged,char reset)
 {
-  static real *last_chgs=0;
-  static int num_calls=0;
   static int max_calls=100;
   atom_type *atom;
   int i,num_atoms;
@@ -137,3 +140,48 @@ fprintf(stderr,"Total zeta change this cycle: %lg  tolerance: %lg\n",total_delta
   }
 
 }
+
+
+/****************************************************************************
+ *
+ *                   Procedure get_zeta_state
+ *
+ * Arguments:     calls: pointer to int
+ *         last_charges: pointer to pointer to real
+ *
+ * Returns: none
+ *
+ * Action:  Returns the number of zeta updates done so far and the net
+ *   charges used in the last of them (last_charges is zero if
+ *   update_zetas hasn't been called yet).
+ *
+ ****************************************************************************/
+void get_zeta_state(int *calls,real **last_charges)
+{
+  *calls = num_calls;
+  *last_charges = last_chgs;
+}
+
+/****************************************************************************
+ *
+ *                   Procedure set_zeta_state
+ *
+ * Arguments:     calls: int
+ *         last_charges: pointer to real
+ *            num_atoms: int
+ *
+ * Returns: none
+ *
+ * Action:  The inverse of get_zeta_state, this is used to pick up
+ *   a zeta optimization from a checkpoint.
+ *
+ ****************************************************************************/
+void set_zeta_state(int calls,real *last_charges,int num_atoms)
+{
+  if( !last_chgs ){
+    last_chgs = (real *)calloc(num_atoms,sizeof(real));
+    if(!last_chgs)fatal("Can't allocate last_charge array in set_zeta_state.");
+  }
+  bcopy((char *)last_charges,(char *)last_chgs,num_atoms*sizeof(real));
+  num_calls = calls;
+}